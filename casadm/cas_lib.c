@@ -271,6 +271,7 @@ static struct name_to_val_mapping cleaning_policy_names[] = {
 static struct name_to_val_mapping promotion_policy_names[] = {
 	{ .short_name = "always", .value = ocf_promotion_always },
 	{ .short_name = "nhit", .value = ocf_promotion_nhit },
+	{ .short_name = "tinylfu", .value = KCAS_PROMOTION_TINYLFU },
 	{ NULL}
 };
 
@@ -287,6 +288,12 @@ static struct name_to_val_mapping stats_filters_names[] = {
 	{ .short_name = "req", .value = STATS_FILTER_REQ },
 	{ .short_name = "blk", .value = STATS_FILTER_BLK },
 	{ .short_name = "err", .value = STATS_FILTER_ERR },
+	{ .short_name = "lat", .value = STATS_FILTER_LAT },
+	{ .short_name = "queue", .value = STATS_FILTER_QUEUE },
+	{ .short_name = "mem", .value = STATS_FILTER_MEM },
+	{ .short_name = "heatmap", .value = STATS_FILTER_HEATMAP },
+	{ .short_name = "mrc", .value = STATS_FILTER_MRC },
+	{ .short_name = "internal", .value = STATS_FILTER_INTERNAL },
 	{ .short_name = "all", .value = STATS_FILTER_ALL },
 	{ NULL }
 };
@@ -541,19 +548,38 @@ dev_err:
 	return path_len;
 }
 
+size_t volume_path_prefix_len(const char *path)
+{
+	static const char *const prefixes[] = { "null:", "ram:" };
+	size_t i, len;
+
+	for (i = 0; i < ARRAY_SIZE(prefixes); i++) {
+		len = strlen(prefixes[i]);
+		if (!strncmp(path, prefixes[i], len))
+			return len;
+	}
+
+	return 0;
+}
+
 /**
   * @brief get special device file path (/dev/sdX) for disk.
   */
 int get_dev_path(const char* disk, char* buf, size_t num)
 {
+	size_t prefix_len = volume_path_prefix_len(disk);
+	char prefix[MAX_STR_LEN];
 	char *path;
 	int err;
 
-	path = realpath(disk, NULL);
+	path = realpath(disk + prefix_len, NULL);
 	if (!path)
 		return FAILURE;
 
-	err = strncpy_s(buf, num, path, MAX_STR_LEN);
+	/* Resolved path keeps prefix, disk and buf may be the same buffer */
+	snprintf(prefix, sizeof(prefix), "%.*s", (int)prefix_len, disk);
+	err = snprintf(buf, num, "%s%s", prefix, path) >= num ?
+			FAILURE : SUCCESS;
 
 	free(path);
 	return err;
@@ -600,7 +626,8 @@ static int _is_by_id_path(const char* dev_path)
 			 strnlen_s(dev_by_id_dir, sizeof(dev_by_id_dir))));
 }
 
-int set_device_path(char *dest_path, size_t dest_len, const char *src_path, size_t src_len)
+static int _set_device_path(char *dest_path, size_t dest_len,
+		const char *src_path, size_t src_len)
 {
 	char abs_dev_path[MAX_STR_LEN];
 	int result;
@@ -632,6 +659,20 @@ int set_device_path(char *dest_path, size_t dest_len, const char *src_path, size
 	return FAILURE;
 }
 
+/* Prefix selecting type of volume is kept in front of resolved path */
+int set_device_path(char *dest_path, size_t dest_len, const char *src_path, size_t src_len)
+{
+	size_t prefix_len = volume_path_prefix_len(src_path);
+
+	if (prefix_len >= dest_len || prefix_len >= src_len)
+		return FAILURE;
+
+	memcpy(dest_path, src_path, prefix_len);
+
+	return _set_device_path(dest_path + prefix_len, dest_len - prefix_len,
+			src_path + prefix_len, src_len - prefix_len);
+}
+
 int get_core_info(int fd, uint32_t cache_id, int core_id,
 		  struct kcas_core_info *info, bool by_id_path)
 {
@@ -686,70 +727,77 @@ static int get_core_device(uint32_t cache_id, int core_id, struct core_device *c
 	return SUCCESS;
 }
 
-int get_cache_count(int fd)
+/*
+ * List ids of caches in chunks, until one comes short. Number of caches is
+ * not asked for up front - caches started or stopped meanwhile would make
+ * the count and the list disagree, and each of these calls serializes with
+ * management of all caches in kernel. Count is -1 upon error.
+ */
+static uint32_t *_list_cache_ids(int fd, int *caches_count)
 {
-	struct kcas_cache_count cmd;
+	struct kcas_cache_list cache_list;
+	uint32_t *cache_ids = NULL, *tmp;
+	int i;
 
-	if (ioctl(fd, KCAS_IOCTL_GET_CACHE_COUNT, &cmd) < 0)
-		return 0;
+	*caches_count = 0;
 
-	return cmd.cache_count;
-}
+	memset(&cache_list, 0, sizeof(cache_list));
+	cache_list.id_position = 0;
+	do {
+		cache_list.in_out_num = CACHE_LIST_ID_LIMIT;
+		if (ioctl(fd, KCAS_IOCTL_LIST_CACHE, &cache_list) < 0) {
+			if (errno != EINVAL) {
+				cas_printf(LOG_ERR, "Error while retrieving "
+						"cache properties %d\n", errno);
+				goto err;
+			}
+		}
 
-uint32_t *get_cache_ids(int *caches_count)
-{
-	int i, fd, status;
-	struct kcas_cache_list cache_list;
-	uint32_t *cache_ids = NULL;
-	int count, chunk_size;
+		if (!cache_list.in_out_num)
+			break;
 
-	fd = open_ctrl_device();
-	if (fd == -1)
-		return NULL;
+		tmp = realloc(cache_ids, (*caches_count +
+				cache_list.in_out_num) * sizeof(*cache_ids));
+		if (!tmp)
+			goto err;
+		cache_ids = tmp;
 
-	count = get_cache_count(fd);
+		for (i = 0; i < cache_list.in_out_num; i++)
+			cache_ids[(*caches_count)++] = cache_list.cache_id_tab[i];
 
-	if (count <= 0) {
-		goto error_out;
-	}
+		cache_list.id_position += CACHE_LIST_ID_LIMIT;
+	} while (cache_list.in_out_num >= CACHE_LIST_ID_LIMIT);
 
-	cache_ids = malloc(count * sizeof(*cache_ids));
-	if (cache_ids == NULL) {
-		goto error_out;
-	}
+	return cache_ids;
 
-	memset(&cache_list, 0, sizeof(cache_list));
+err:
+	free(cache_ids);
+	*caches_count = -1;
+	return NULL;
+}
 
-	*caches_count = 0;
+uint32_t *get_cache_ids_fd(int fd, int *caches_count)
+{
+	uint32_t *cache_ids;
 
-	chunk_size = CACHE_LIST_ID_LIMIT;
-	cache_list.id_position = 0;
-	cache_list.in_out_num = chunk_size;
-	do {
-		if ((status = ioctl(fd, KCAS_IOCTL_LIST_CACHE, &cache_list)) < 0) {
-			if (errno != EINVAL) {
-				cas_printf(LOG_ERR, "Error while retrieving cache properties %d %d\n",
-					errno, status);
-				free(cache_ids);
-				cache_ids = NULL;
-				*caches_count = 0;
-				break;
-			}
-		}
+	cache_ids = _list_cache_ids(fd, caches_count);
+	if (*caches_count < 0)
+		*caches_count = 0;
 
-		/* iterate through id table and get status */
-		for (i = 0; i < cache_list.in_out_num; i++) {
-			cache_ids[(*caches_count)] = cache_list.cache_id_tab[i];
-			(*caches_count)++;
-			if (*caches_count >= count) {
-				break;
-			}
-		}
+	return cache_ids;
+}
 
-		cache_list.id_position += chunk_size;
-	} while (cache_list.in_out_num >= chunk_size); /* repeat until there is no more devices on the list */
+uint32_t *get_cache_ids(int *caches_count)
+{
+	uint32_t *cache_ids;
+	int fd;
+
+	fd = open_ctrl_device();
+	if (fd == -1)
+		return NULL;
+
+	cache_ids = get_cache_ids_fd(fd, caches_count);
 
-error_out:
 	close(fd);
 	return cache_ids;
 }
@@ -791,6 +839,9 @@ struct cache_device *get_cache_device(const struct kcas_cache_info *info, bool b
 	}
 
 	cache->mode = info->info.cache_mode;
+	cache->mode_drain_from = info->mode_drain_from;
+	cache->purge_total = info->purge_total;
+	cache->purge_done = info->purge_done;
 	cache->dirty = info->info.dirty;
 	cache->flushed = info->info.flushed;
 	cache->cleaning_policy = info->info.cleaning_policy;
@@ -849,8 +900,8 @@ void free_cache_devices_list(struct cache_device **caches, int caches_count)
 
 struct cache_device **get_cache_devices(int *caches_count, bool by_id_path)
 {
-	int i, fd, status, chunk_size, count;
-	struct kcas_cache_list cache_list;
+	int i, fd, count;
+	uint32_t *cache_ids;
 	struct cache_device **caches = NULL;
 	struct cache_device *tmp_cache;
 
@@ -860,14 +911,12 @@ struct cache_device **get_cache_devices(int *caches_count, bool by_id_path)
 	if (fd == -1)
 		return NULL;
 
-	*caches_count = count = get_cache_count(fd);
-	if (count <= 0) {
+	cache_ids = _list_cache_ids(fd, &count);
+	*caches_count = count;
+	if (count <= 0)
 		goto error_out;
-	}
 
-	memset(&cache_list, 0, sizeof(cache_list));
 	caches = malloc(count * sizeof(*caches));
-
 	if (NULL == caches) {
 		*caches_count = -1;
 		goto error_out;
@@ -875,39 +924,17 @@ struct cache_device **get_cache_devices(int *caches_count, bool by_id_path)
 
 	(*caches_count) = 0;
 
-	chunk_size = CACHE_LIST_ID_LIMIT;
-
-	cache_list.id_position = 0;
-	cache_list.in_out_num = chunk_size;
-	do {
-		if ((status = ioctl(fd, KCAS_IOCTL_LIST_CACHE, &cache_list)) < 0) {
-			if (errno != EINVAL) {
-				cas_printf(LOG_ERR, "Error while retrieving cache properties %d %d\n",
-					errno, status);
-				free_cache_devices_list(caches, *caches_count);
-				*caches_count = -1;
-				caches = NULL;
-				goto error_out;
-			}
-		}
-
-		/* iterate through id table and get status */
-		for (i = 0; i < cache_list.in_out_num; i++) {
-			if ((tmp_cache = get_cache_device_by_id_fd(cache_list.cache_id_tab[i],
-								   fd, by_id_path)) == NULL) {
-				cas_printf(LOG_ERR, "Failed to retrieve cache information!\n");
-				continue;
-			}
-			caches[(*caches_count)] = tmp_cache;
-			(*caches_count)++;
-			if (*caches_count >= count) {
-				break;
-			}
+	for (i = 0; i < count; i++) {
+		if ((tmp_cache = get_cache_device_by_id_fd(cache_ids[i],
+							   fd, by_id_path)) == NULL) {
+			cas_printf(LOG_ERR, "Failed to retrieve cache information!\n");
+			continue;
 		}
-		cache_list.id_position += chunk_size;
-	} while (cache_list.in_out_num >= chunk_size); /* repeat until there is no more devices on the list */
+		caches[(*caches_count)++] = tmp_cache;
+	}
 
 error_out:
+	free(cache_ids);
 	close(fd);
 	return caches;
 }
@@ -946,21 +973,69 @@ static int _verify_and_parse_volume_path(char *tgt_buf,
 		size_t tgt_buf_size, const char *cache_device,
 		size_t paths_size)
 {
+	char member_path[MAX_STR_LEN];
+	char *paths, *member, *savep;
+	const char *separator = ",";
+	size_t len = 0;
 	int fd = 0;
+	int result = SUCCESS;
 
-	/* check if cache device exists */
-	fd = open(cache_device, 0);
-	if (fd < 0) {
-		cas_printf(LOG_ERR, "Device %s not found.\n", cache_device);
-		return FAILURE;
+	/*
+	 * Striped cache device is given as comma separated list of members,
+	 * mirrored one as list separated with plus
+	 */
+	if (strchr(cache_device, '+')) {
+		if (strchr(cache_device, ',')) {
+			cas_printf(LOG_ERR, "Cache device cannot be both "
+					"striped and mirrored.\n");
+			return FAILURE;
+		}
+		separator = "+";
 	}
-	close(fd);
 
-	if (set_device_path(tgt_buf, tgt_buf_size, cache_device, paths_size) != SUCCESS) {
+	paths = strdup(cache_device);
+	if (!paths)
 		return FAILURE;
+
+	tgt_buf[0] = '\0';
+	for (member = strtok_r(paths, separator, &savep); member;
+			member = strtok_r(NULL, separator, &savep)) {
+		if (volume_path_prefix_len(member) &&
+				strpbrk(cache_device, ",+")) {
+			cas_printf(LOG_ERR, "Null or RAM-backed cache device "
+					"cannot have multiple members.\n");
+			result = FAILURE;
+			break;
+		}
+
+		/* check if cache device exists */
+		fd = open(member + volume_path_prefix_len(member), 0);
+		if (fd < 0) {
+			cas_printf(LOG_ERR, "Device %s not found.\n", member);
+			result = FAILURE;
+			break;
+		}
+		close(fd);
+
+		if (set_device_path(member_path, sizeof(member_path), member,
+				paths_size) != SUCCESS) {
+			result = FAILURE;
+			break;
+		}
+
+		if (snprintf(tgt_buf + len, tgt_buf_size - len, "%s%s",
+				len ? separator : "", member_path) >=
+				tgt_buf_size - len) {
+			cas_printf(LOG_ERR, "Cache device path is too long.\n");
+			result = FAILURE;
+			break;
+		}
+		len = strnlen_s(tgt_buf, tgt_buf_size);
 	}
 
-	return SUCCESS;
+	free(paths);
+
+	return result;
 }
 
 int string_split_kv_for_each(const char *str, char *delim, char *split,
@@ -1006,38 +1081,73 @@ int string_split_kv_for_each(const char *str, char *delim, char *split,
 	return result ? : idx;
 }
 
+/*
+ * Map fs meta map file into memory instead of reading it, so large maps
+ * are passed down to kernel without extra copy. Returns NULL for empty
+ * or unmappable file, in which case @len is 0 or -1 respectively.
+ */
+static void *_map_fs_meta_file(const char *fs_meta_map_file, int *len)
+{
+	struct stat st = {};
+	void *data;
+	int fd;
+
+	*len = -1;
+
+	fd = open(fs_meta_map_file, O_RDONLY);
+	if (fd == -1)
+		return NULL;
+
+	if (fstat(fd, &st) < 0 || st.st_size > INT_MAX) {
+		close(fd);
+		return NULL;
+	}
+
+	if (!st.st_size) {
+		close(fd);
+		*len = 0;
+		return NULL;
+	}
+
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return NULL;
+
+	*len = st.st_size;
+	return data;
+}
+
+static void _unmap_fs_meta_file(void *data, int len)
+{
+	if (data)
+		munmap(data, len);
+}
+
 static bool _load_fs_meta_dict(char *key, char *val, int idx, void *usr)
 {
 	struct fs_meta_map *fs_meta_dict = (struct fs_meta_map *)usr;
 	uint16_t core_id = atoi(key);
 	char *fs_meta_map_file = val;
 	char *data = NULL;
-	int fd, len;
-	struct stat st = {};
+	int len;
 
 	if (idx >= OCF_CORE_MAX || core_id >= OCF_CORE_MAX) {
 		return false;
 	}
 
-	if (fs_meta_map_file && stat(fs_meta_map_file, &st) < 0) {
-		cas_printf(LOG_ERR, "file %s not found.\n", fs_meta_map_file);
+	if (!fs_meta_map_file)
 		return false;
-	}
 
-	fd = open(fs_meta_map_file, O_RDONLY);
-	if (fd == -1)
+	data = _map_fs_meta_file(fs_meta_map_file, &len);
+	if (len < 0) {
+		cas_printf(LOG_ERR, "Cannot read file %s.\n", fs_meta_map_file);
 		return false;
-
-	data = malloc(st.st_size);
-	assert(data);
-	len = read(fd, data, st.st_size);
-	close(fd);
-	assert(len == st.st_size);
+	}
 
 	fs_meta_dict[core_id].core_id = core_id;
 	fs_meta_dict[core_id].data = data;
 	fs_meta_dict[core_id].length = len;
-	//printf("idx %d %p\n", core_id, fs_meta_dict[core_id].data);
 	return true;
 }
 
@@ -1088,13 +1198,23 @@ static int _start_cache(uint32_t cache_id, unsigned int cache_init,
 	cmd.init_cache = cache_init;
 	memcpy(cmd.fs_meta_dict, fs_meta_dict, sizeof(fs_meta_dict));
 
-	status = run_ioctl_interruptible_retry(
-			fd,
-			ioctl,
-			&cmd,
-			start ? "Starting cache" : "Attaching device to cache",
-			cache_id,
-			OCF_CORE_ID_INVALID);
+	if (cache_init == CACHE_INIT_LOAD) {
+		status = run_ioctl_interruptible_load(
+				fd,
+				ioctl,
+				&cmd,
+				"Loading cache",
+				cache_id,
+				cmd.cache_path_name);
+	} else {
+		status = run_ioctl_interruptible_retry(
+				fd,
+				ioctl,
+				&cmd,
+				start ? "Starting cache" : "Attaching device to cache",
+				cache_id,
+				OCF_CORE_ID_INVALID);
+	}
 	cache_id = cmd.cache_id;
 	if (status < 0) {
 		close(fd);
@@ -1135,10 +1255,8 @@ static int _start_cache(uint32_t cache_id, unsigned int cache_init,
 out:
 	if (fs_meta_map_files) {
 		for (i = 0; i < OCF_CORE_MAX; i++) {
-			if (fs_meta_dict[i].length) {
-				//printf("idx %d %p\n", i, fs_meta_dict[i].data);
-				free(fs_meta_dict[i].data);
-			}
+			_unmap_fs_meta_file(fs_meta_dict[i].data,
+					fs_meta_dict[i].length);
 		}
 	}
 	return result;
@@ -1348,6 +1466,14 @@ int set_cache_mode(unsigned int cache_mode, uint32_t cache_id, int flush)
 	if (flush_param_required) {
 		if (1 == flush) {
 			cas_printf(LOG_INFO, "CAS is currently flushing dirty data to primary storage devices.\n");
+		} else if (CACHE_MODE_FLUSH_BACKGROUND == flush) {
+			cas_printf(LOG_INFO, "CAS is currently migrating from %s to %s mode.\n"
+				"Dirty data are being drained to primary storage device in background,\n"
+				"cache mode is listed as %s->%s until it is done (‘casadm -L’).\n",
+				cache_mode_to_name_long(orig_mode),
+				cache_mode_to_name_long(cache_mode),
+				cache_mode_to_name(orig_mode),
+				cache_mode_to_name(cache_mode));
 		} else {
 			cas_printf(LOG_INFO, "CAS is currently migrating from %s to %s mode.\n"
 				"Dirty data are being flushed to primary storage device in background.\n"
@@ -1400,7 +1526,7 @@ static void print_param(FILE *intermediate_file, struct cas_param *param)
 }
 
 int core_params_set(uint32_t cache_id, unsigned int core_id,
-		struct cas_param *params)
+		uint32_t io_class_id, struct cas_param *params)
 {
 	int cache_mode = ocf_cache_mode_none;
 	struct kcas_set_core_param cmd = {0};
@@ -1430,6 +1556,7 @@ int core_params_set(uint32_t cache_id, unsigned int core_id,
 		cmd.core_id = core_id;
 		cmd.param_id = i;
 		cmd.param_value = params[i].value;
+		cmd.io_class_id = io_class_id;
 
 		if (run_ioctl(fd, KCAS_IOCTL_SET_CORE_PARAM, &cmd) < 0) {
 			close(fd);
@@ -1445,7 +1572,8 @@ int core_params_set(uint32_t cache_id, unsigned int core_id,
 }
 
 int core_params_get(uint32_t cache_id, unsigned int core_id,
-		struct cas_param *params, unsigned int output_format)
+		uint32_t io_class_id, struct cas_param *params,
+		unsigned int output_format)
 {
 	struct kcas_get_core_param cmd = {0};
 	FILE *intermediate_file[2];
@@ -1472,6 +1600,7 @@ int core_params_get(uint32_t cache_id, unsigned int core_id,
 		cmd.cache_id = cache_id;
 		cmd.core_id = core_id;
 		cmd.param_id = i;
+		cmd.io_class_id = io_class_id;
 
 		if (run_ioctl(fd, KCAS_IOCTL_GET_CORE_PARAM, &cmd) < 0) {
 			if (cmd.ext_err_code == OCF_ERR_CACHE_NOT_EXIST)
@@ -1504,7 +1633,8 @@ int core_params_get(uint32_t cache_id, unsigned int core_id,
 	return SUCCESS;
 }
 
-int cache_params_set(uint32_t cache_id, struct cas_param *params)
+int cache_params_set(uint32_t cache_id, uint32_t io_class_id,
+		struct cas_param *params)
 {
 	int cache_mode = ocf_cache_mode_none;
 	struct kcas_set_cache_param cmd = {0};
@@ -1531,6 +1661,7 @@ int cache_params_set(uint32_t cache_id, struct cas_param *params)
 			continue;
 
 		cmd.cache_id = cache_id;
+		cmd.io_class_id = io_class_id;
 		cmd.param_id = i;
 		cmd.param_value = params[i].value;
 
@@ -1546,8 +1677,8 @@ int cache_params_set(uint32_t cache_id, struct cas_param *params)
 	return SUCCESS;
 }
 
-int cache_params_get(uint32_t cache_id, struct cas_param *params,
-		unsigned int output_format)
+int cache_params_get(uint32_t cache_id, uint32_t io_class_id,
+		struct cas_param *params, unsigned int output_format)
 {
 	struct kcas_get_cache_param cmd = {0};
 	FILE *intermediate_file[2];
@@ -1572,6 +1703,7 @@ int cache_params_get(uint32_t cache_id, struct cas_param *params,
 			continue;
 
 		cmd.cache_id = cache_id;
+		cmd.io_class_id = io_class_id;
 		cmd.param_id = i;
 
 		if (run_ioctl(fd, KCAS_IOCTL_GET_CACHE_PARAM, &cmd) < 0) {
@@ -1765,6 +1897,9 @@ int illegal_recursive_core(uint32_t cache_id, const char *core_device, int core_
 	static const char cas_pattern[] = "/dev/cas";
 	struct cache_device *cache; /*structure containing data on cache device*/
 
+	/* Null or RAM-backed volume is checked by its underlying device */
+	core_device += volume_path_prefix_len(core_device);
+
 	while (true) {
 		/*
 		 * if core_device is an cas device (or a symlink to
@@ -1840,29 +1975,14 @@ int illegal_recursive_core(uint32_t cache_id, const char *core_device, int core_
 	}
 }
 
-int add_core(uint32_t cache_id, unsigned int core_id, const char *core_device,
-		int try_add, int update_path, const char *fs_meta_map_file)
+/* Check if core device provided is valid */
+static int _validate_core_device(const char *core_device)
 {
-	int fd = 0, len = 0, user_core_path_size;
-	struct kcas_insert_core cmd;
 	struct stat query_core;
-	const char *core_path;      /* core path sent down to kernel  */
-	const char *user_core_path; /* core path provided by user */
-	struct stat st = {};
-	char *data = NULL;
-	int result = SUCCESS;
-
-	if (fs_meta_map_file && stat(fs_meta_map_file, &st) < 0) {
-		cas_printf(LOG_ERR, "file %s not found.\n", fs_meta_map_file);
-		return FAILURE;
-	}
+	int fd;
 
-	if (try_add && core_id == OCF_CORE_ID_INVALID) {
-		cas_printf(LOG_ERR, "Option '--core-id' is missing\n");
-		return FAILURE;
-	}
+	core_device += volume_path_prefix_len(core_device);
 
-	/* Check if core device provided is valid */
 	fd = open(core_device, 0);
 	if (fd < 0) {
 		cas_printf(LOG_ERR, "Device %s not found.\n", core_device);
@@ -1881,6 +2001,53 @@ int add_core(uint32_t cache_id, unsigned int core_id, const char *core_device,
 		return FAILURE;
 	}
 
+	return SUCCESS;
+}
+
+static void _print_add_core_error(int ext_err_code, const char *core_path,
+		const char *user_core_path)
+{
+	if (OCF_ERR_NOT_OPEN_EXC == ext_err_code) {
+		if (FAILURE == check_core_already_cached(core_path)) {
+			cas_printf(LOG_ERR, "Core device '%s' is already cached.\n",
+				user_core_path);
+		} else {
+			cas_printf(LOG_ERR, "Failed to open '%s' device"
+			  " exclusively. Please close all applications "
+			  "accessing it or unmount the device.\n",
+			  user_core_path);
+		}
+	} else {
+		print_err(ext_err_code);
+	}
+}
+
+int add_core(uint32_t cache_id, unsigned int core_id, const char *core_device,
+		int try_add, int update_path, const char *fs_meta_map_file,
+		uint32_t queue_depth, uint32_t hw_queues,
+		uint32_t read_ahead_kb, uint32_t io_opt_kb)
+{
+	int fd = 0, len = 0, user_core_path_size;
+	struct kcas_insert_core cmd;
+	const char *core_path;      /* core path sent down to kernel  */
+	const char *user_core_path; /* core path provided by user */
+	struct stat st = {};
+	char *data = NULL;
+	int result = SUCCESS;
+
+	if (fs_meta_map_file && stat(fs_meta_map_file, &st) < 0) {
+		cas_printf(LOG_ERR, "file %s not found.\n", fs_meta_map_file);
+		return FAILURE;
+	}
+
+	if (try_add && core_id == OCF_CORE_ID_INVALID) {
+		cas_printf(LOG_ERR, "Option '--core-id' is missing\n");
+		return FAILURE;
+	}
+
+	if (_validate_core_device(core_device) != SUCCESS)
+		return FAILURE;
+
 	memset(&cmd, 0, sizeof(cmd));
 	if (set_device_path(cmd.core_path_name, sizeof(cmd.core_path_name),
 			    core_device, MAX_STR_LEN) != SUCCESS)
@@ -1892,14 +2059,12 @@ int add_core(uint32_t cache_id, unsigned int core_id, const char *core_device,
 	core_path = cmd.core_path_name;
 
 	if (fs_meta_map_file) {
-		fd = open(fs_meta_map_file, O_RDONLY);
-		if (fd == -1)
+		data = _map_fs_meta_file(fs_meta_map_file, &len);
+		if (len < 0) {
+			cas_printf(LOG_ERR, "Cannot read file %s.\n",
+					fs_meta_map_file);
 			return FAILURE;
-		data = malloc(st.st_size);
-		assert(data);
-		len = read(fd, data, st.st_size);
-		close(fd);
-		assert(len == st.st_size);
+		}
 	}
 
 	fd = open_ctrl_device();
@@ -1920,6 +2085,10 @@ int add_core(uint32_t cache_id, unsigned int core_id, const char *core_device,
 	cmd.core_id = core_id;
 	cmd.try_add = try_add;
 	cmd.update_path = update_path;
+	cmd.queue_depth = queue_depth;
+	cmd.hw_queues = hw_queues;
+	cmd.read_ahead_kb = read_ahead_kb;
+	cmd.io_opt_kb = io_opt_kb;
 	cmd.fs_meta_dict.core_id = core_id;
 	cmd.fs_meta_dict.data = data;
 	cmd.fs_meta_dict.length = len;
@@ -1928,19 +2097,8 @@ int add_core(uint32_t cache_id, unsigned int core_id, const char *core_device,
 		close(fd);
 		cas_printf(LOG_ERR, "Error while adding core device to cache instance %"PRIu32"\n",
 			cache_id);
-		if (OCF_ERR_NOT_OPEN_EXC == cmd.ext_err_code) {
-			if (FAILURE == check_core_already_cached(core_path)) {
-				cas_printf(LOG_ERR, "Core device '%s' is already cached.\n",
-					user_core_path);
-			} else {
-				cas_printf(LOG_ERR, "Failed to open '%s' device"
-				  " exclusively. Please close all applications "
-				  "accessing it or unmount the device.\n",
-				  user_core_path);
-			}
-		} else {
-			print_err(cmd.ext_err_code);
-		}
+		_print_add_core_error(cmd.ext_err_code, core_path,
+				user_core_path);
 		result = FAILURE;
 		goto out;
 	}
@@ -1955,47 +2113,144 @@ int add_core(uint32_t cache_id, unsigned int core_id, const char *core_device,
 	}
 
 out:
-	if (data) {
-		free(data);
-	}
+	_unmap_fs_meta_file(data, len);
 	return result;
 }
 
-int _check_if_mounted(uint32_t cache_id, int core_id)
+int add_cores(uint32_t cache_id, const char *core_devices,
+		uint32_t queue_depth, uint32_t hw_queues,
+		uint32_t read_ahead_kb, uint32_t io_opt_kb)
 {
-	FILE *mtab;
-	struct mntent *mstruct;
-	char dev_buf[80];
-	int difference = 0, error = 0;
-	if (core_id >= 0) {
-		/* verify if specific core is mounted */
-		snprintf(dev_buf, sizeof(dev_buf), "/dev/cas%"PRIu32"-%d", cache_id, core_id);
-	} else {
-		/* verify if any core from given cache is mounted */
-		snprintf(dev_buf, sizeof(dev_buf), "/dev/cas%"PRIu32"-", cache_id);
+	struct kcas_insert_cores cmd = {};
+	struct kcas_insert_core *cores = NULL;
+	const char **user_core_paths = NULL;
+	char *paths, *member, *savep;
+	uint32_t count = 1, i;
+	int fd, result = SUCCESS;
+
+	for (i = 0; core_devices[i]; i++)
+		count += core_devices[i] == ',';
+
+	if (count > OCF_CORE_MAX) {
+		cas_printf(LOG_ERR, "Up to %u core devices can be added at "
+				"once.\n", OCF_CORE_MAX);
+		return FAILURE;
 	}
 
-	mtab = setmntent("/etc/mtab", "r");
-	if (!mtab)
-	{
-		cas_printf(LOG_ERR, "Error while accessing /etc/mtab\n");
-		return FAILURE;
+	paths = strdup(core_devices);
+	cores = calloc(count, sizeof(*cores));
+	user_core_paths = calloc(count, sizeof(*user_core_paths));
+	if (!paths || !cores || !user_core_paths) {
+		cas_printf(LOG_ERR, "Failed to allocate memory.\n");
+		result = FAILURE;
+		goto out;
 	}
 
-	while ((mstruct = getmntent(mtab)) != NULL) {
-		error = strcmp_s(mstruct->mnt_fsname, PATH_MAX, dev_buf, &difference);
-		/* mstruct->mnt_fsname is /dev/... block device path, not a mountpoint */
-		if (error != EOK)
-			return FAILURE;
-		if (!difference) {
-			if (core_id<0) {
-				cas_printf(LOG_ERR,
-					   "Can't stop cache instance %"PRIu32". Device %s is mounted!\n",
-					   cache_id, mstruct->mnt_fsname);
-			} else {
-				cas_printf(LOG_ERR,
-					   "Can't remove core %d from cache %"PRIu32"."
-					   " Device %s is mounted!\n",
+	fd = open_ctrl_device();
+	if (fd == -1) {
+		result = FAILURE;
+		goto out;
+	}
+
+	count = 0;
+	for (member = strtok_r(paths, ",", &savep); member;
+			member = strtok_r(NULL, ",", &savep)) {
+		if (_validate_core_device(member) != SUCCESS ||
+				set_device_path(cores[count].core_path_name,
+					sizeof(cores[count].core_path_name),
+					member, MAX_STR_LEN) != SUCCESS ||
+				illegal_recursive_core(cache_id, member,
+					strnlen_s(member, MAX_STR_LEN), fd)) {
+			close(fd);
+			result = FAILURE;
+			goto out;
+		}
+
+		user_core_paths[count] = member;
+		cores[count].cache_id = cache_id;
+		cores[count].core_id = OCF_CORE_ID_INVALID;
+		cores[count].queue_depth = queue_depth;
+		cores[count].hw_queues = hw_queues;
+		cores[count].read_ahead_kb = read_ahead_kb;
+		cores[count].io_opt_kb = io_opt_kb;
+		/* Entries not reached by kernel keep it */
+		cores[count].ext_err_code = -1;
+		count++;
+	}
+
+	cmd.cache_id = cache_id;
+	cmd.cores_count = count;
+	cmd.cores = cores;
+
+	if (ioctl(fd, KCAS_IOCTL_INSERT_CORES, &cmd) < 0)
+		result = FAILURE;
+	close(fd);
+
+	for (i = 0; i < count; i++) {
+		if (cores[i].ext_err_code < 0) {
+			cas_printf(LOG_ERR, "Error while adding core devices "
+					"to cache instance %"PRIu32"\n",
+					cache_id);
+			print_err(cmd.ext_err_code);
+			break;
+		}
+
+		if (!cores[i].ext_err_code) {
+			cas_printf(LOG_INFO, "Successfully added core %u to "
+					"cache instance %"PRIu32"\n",
+					cores[i].core_id, cache_id);
+			continue;
+		}
+
+		cas_printf(LOG_ERR, "Error while adding core device %s to "
+				"cache instance %"PRIu32"\n",
+				user_core_paths[i], cache_id);
+		_print_add_core_error(cores[i].ext_err_code,
+				cores[i].core_path_name, user_core_paths[i]);
+	}
+
+out:
+	free(user_core_paths);
+	free(cores);
+	free(paths);
+	return result;
+}
+
+int _check_if_mounted(uint32_t cache_id, int core_id)
+{
+	FILE *mtab;
+	struct mntent *mstruct;
+	char dev_buf[80];
+	int difference = 0, error = 0;
+	if (core_id >= 0) {
+		/* verify if specific core is mounted */
+		snprintf(dev_buf, sizeof(dev_buf), "/dev/cas%"PRIu32"-%d", cache_id, core_id);
+	} else {
+		/* verify if any core from given cache is mounted */
+		snprintf(dev_buf, sizeof(dev_buf), "/dev/cas%"PRIu32"-", cache_id);
+	}
+
+	mtab = setmntent("/etc/mtab", "r");
+	if (!mtab)
+	{
+		cas_printf(LOG_ERR, "Error while accessing /etc/mtab\n");
+		return FAILURE;
+	}
+
+	while ((mstruct = getmntent(mtab)) != NULL) {
+		error = strcmp_s(mstruct->mnt_fsname, PATH_MAX, dev_buf, &difference);
+		/* mstruct->mnt_fsname is /dev/... block device path, not a mountpoint */
+		if (error != EOK)
+			return FAILURE;
+		if (!difference) {
+			if (core_id<0) {
+				cas_printf(LOG_ERR,
+					   "Can't stop cache instance %"PRIu32". Device %s is mounted!\n",
+					   cache_id, mstruct->mnt_fsname);
+			} else {
+				cas_printf(LOG_ERR,
+					   "Can't remove core %d from cache %"PRIu32"."
+					   " Device %s is mounted!\n",
 					   core_id, cache_id, mstruct->mnt_fsname);
 			}
 			return FAILURE;
@@ -2120,6 +2375,60 @@ int remove_inactive_core(uint32_t cache_id, unsigned int core_id,
 	return SUCCESS;
 }
 
+int update_fs_meta(uint32_t cache_id, unsigned int core_id,
+		const char *fs_meta_map_file, bool remove)
+{
+	struct kcas_update_fs_meta cmd;
+	struct stat st = {};
+	char *data = NULL;
+	int fd, len;
+
+	if (stat(fs_meta_map_file, &st) < 0) {
+		cas_printf(LOG_ERR, "file %s not found.\n", fs_meta_map_file);
+		return FAILURE;
+	}
+
+	data = _map_fs_meta_file(fs_meta_map_file, &len);
+	if (len < 0) {
+		cas_printf(LOG_ERR, "Cannot read file %s.\n", fs_meta_map_file);
+		return FAILURE;
+	}
+
+	if (len > KCAS_UPDATE_FS_META_MAX_LENGTH) {
+		cas_printf(LOG_ERR, "File %s exceeds %d bytes.\n",
+				fs_meta_map_file, KCAS_UPDATE_FS_META_MAX_LENGTH);
+		_unmap_fs_meta_file(data, len);
+		return FAILURE;
+	}
+
+	fd = open_ctrl_device();
+	if (fd == -1) {
+		_unmap_fs_meta_file(data, len);
+		return FAILURE;
+	}
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.cache_id = cache_id;
+	cmd.core_id = core_id;
+	cmd.remove = remove;
+	cmd.fs_meta_dict.core_id = core_id;
+	cmd.fs_meta_dict.data = data;
+	cmd.fs_meta_dict.length = len;
+
+	if (run_ioctl(fd, KCAS_IOCTL_UPDATE_FS_META, &cmd) < 0) {
+		close(fd);
+		_unmap_fs_meta_file(data, len);
+		cas_printf(LOG_ERR, "Error while updating fs meta map of core %u "
+				"of cache instance %"PRIu32"\n", core_id, cache_id);
+		print_err(cmd.ext_err_code);
+		return FAILURE;
+	}
+	close(fd);
+	_unmap_fs_meta_file(data, len);
+
+	return SUCCESS;
+}
+
 int core_pool_remove(const char *core_device)
 {
 	struct kcas_core_pool_remove cmd;
@@ -2147,7 +2456,8 @@ int core_pool_remove(const char *core_device)
 	return SUCCESS;
 }
 
-int purge_cache(uint32_t cache_id)
+#define PURGE_BACKGROUND_INFO "Purge is running in background. Please find its progress via list command (‘casadm -L’).\n"
+int purge_cache(uint32_t cache_id, bool background)
 {
 	int fd = 0;
 	struct kcas_flush_cache cmd;
@@ -2158,6 +2468,17 @@ int purge_cache(uint32_t cache_id)
 
 	memset(&cmd, 0, sizeof(cmd));
 	cmd.cache_id = cache_id;
+	cmd.background = background;
+	if (background) {
+		if (run_ioctl(fd, KCAS_IOCTL_PURGE_CACHE, &cmd) < 0) {
+			close(fd);
+			print_err(cmd.ext_err_code);
+			return FAILURE;
+		}
+		cas_printf(LOG_INFO, PURGE_BACKGROUND_INFO);
+		close(fd);
+		return SUCCESS;
+	}
 	/* synchronous flag */
 	if (run_ioctl_interruptible(fd, KCAS_IOCTL_PURGE_CACHE, &cmd, "Purging cache",
 			cache_id, OCF_CORE_ID_INVALID) < 0) {
@@ -2171,7 +2492,7 @@ int purge_cache(uint32_t cache_id)
 }
 
 #define DIRTY_FLUSHING_WARNING "You have interrupted flushing of cache dirty data. CAS continues to operate\nnormally and dirty data that remains on cache device will be flushed by cleaning thread.\n"
-int flush_cache(uint32_t cache_id)
+int flush_cache(uint32_t cache_id, uint32_t rate_limit)
 {
 	int fd = 0;
 	struct kcas_flush_cache cmd;
@@ -2182,6 +2503,7 @@ int flush_cache(uint32_t cache_id)
 
 	memset(&cmd, 0, sizeof(cmd));
 	cmd.cache_id = cache_id;
+	cmd.rate_limit = rate_limit;
 	/* synchronous flag */
 	if (run_ioctl_interruptible_retry(fd, KCAS_IOCTL_FLUSH_CACHE, &cmd, "Flushing cache",
 			cache_id, OCF_CORE_ID_INVALID) < 0) {
@@ -2199,7 +2521,7 @@ int flush_cache(uint32_t cache_id)
 	return SUCCESS;
 }
 
-int purge_core(uint32_t cache_id, unsigned int core_id)
+int purge_core(uint32_t cache_id, unsigned int core_id, bool background)
 {
 	int fd = 0;
 	struct kcas_flush_core cmd;
@@ -2207,11 +2529,23 @@ int purge_core(uint32_t cache_id, unsigned int core_id)
 	memset(&cmd, 0, sizeof(cmd));
 	cmd.cache_id = cache_id;
 	cmd.core_id = core_id;
+	cmd.background = background;
 
 	fd = open_ctrl_device();
 	if (fd == -1)
 		return FAILURE;
 
+	if (background) {
+		if (run_ioctl(fd, KCAS_IOCTL_PURGE_CORE, &cmd) < 0) {
+			close(fd);
+			print_err(cmd.ext_err_code);
+			return FAILURE;
+		}
+		cas_printf(LOG_INFO, PURGE_BACKGROUND_INFO);
+		close(fd);
+		return SUCCESS;
+	}
+
 	/* synchronous flag */
 	if (run_ioctl_interruptible(fd, KCAS_IOCTL_PURGE_CORE, &cmd, "Purging core", cache_id, core_id) < 0) {
 		close(fd);
@@ -2225,7 +2559,8 @@ int purge_core(uint32_t cache_id, unsigned int core_id)
 	return SUCCESS;
 }
 
-int flush_core(uint32_t cache_id, unsigned int core_id)
+int flush_core(uint32_t cache_id, unsigned int core_id,
+		uint32_t rate_limit)
 {
 	int fd = 0;
 	struct kcas_flush_core cmd;
@@ -2233,6 +2568,7 @@ int flush_core(uint32_t cache_id, unsigned int core_id)
 	memset(&cmd, 0, sizeof(cmd));
 	cmd.cache_id = cache_id;
 	cmd.core_id = core_id;
+	cmd.rate_limit = rate_limit;
 
 	fd = open_ctrl_device();
 	if (fd == -1)
@@ -2253,9 +2589,116 @@ int flush_core(uint32_t cache_id, unsigned int core_id)
 	return SUCCESS;
 }
 
+static const char *async_op_names[] = {
+	[KCAS_ASYNC_OP_FLUSH_CACHE] = "Flushing cache",
+	[KCAS_ASYNC_OP_FLUSH_CORE] = "Flushing core",
+	[KCAS_ASYNC_OP_PURGE_CACHE] = "Purging cache",
+	[KCAS_ASYNC_OP_PURGE_CORE] = "Purging core",
+	[KCAS_ASYNC_OP_STOP_CACHE] = "Stopping cache",
+};
+
+int async_op_start(uint32_t type, uint32_t cache_id, unsigned int core_id,
+		int flush_data, uint32_t rate_limit)
+{
+	int fd = 0;
+	struct kcas_async_op cmd;
+
+	/* Don't stop instance with mounted filesystem */
+	if (type == KCAS_ASYNC_OP_STOP_CACHE &&
+			is_cache_mounted(cache_id) == FAILURE)
+		return FAILURE;
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.type = type;
+	cmd.cache_id = cache_id;
+	cmd.core_id = core_id;
+	cmd.flush_data = flush_data;
+	cmd.rate_limit = rate_limit;
+	cmd.eventfd = -1;
+
+	fd = open_ctrl_device();
+	if (fd == -1)
+		return FAILURE;
+
+	if (run_ioctl(fd, KCAS_IOCTL_ASYNC_OP, &cmd) < 0) {
+		close(fd);
+		print_err(cmd.ext_err_code);
+		return FAILURE;
+	}
+	close(fd);
+
+	cas_printf(LOG_INFO, "%s in background as operation %"PRIu64". "
+			"Please find its progress via 'casadm --op-status "
+			"--op-id %"PRIu64"'.\n", async_op_names[type],
+			cmd.op_id, cmd.op_id);
+
+	return SUCCESS;
+}
+
+int async_op_status(uint64_t op_id, bool wait)
+{
+	int fd = 0;
+	struct kcas_async_status cmd;
+	uint64_t cleaned;
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.op_id = op_id;
+	cmd.wait = wait;
+	cmd.release = true;
+
+	fd = open_ctrl_device();
+	if (fd == -1)
+		return FAILURE;
+
+	if (run_ioctl(fd, KCAS_IOCTL_ASYNC_STATUS, &cmd) < 0) {
+		close(fd);
+		print_err(cmd.ext_err_code);
+		return FAILURE;
+	}
+	close(fd);
+
+	if (cmd.type >= KCAS_ASYNC_OP_TYPE_MAX) {
+		cas_printf(LOG_ERR, "Unknown operation type\n");
+		return FAILURE;
+	}
+
+	if (cmd.type == KCAS_ASYNC_OP_FLUSH_CORE ||
+			cmd.type == KCAS_ASYNC_OP_PURGE_CORE) {
+		cas_printf(LOG_INFO, "Operation: %s %"PRIu16" of cache %"PRIu32"\n",
+				async_op_names[cmd.type], cmd.core_id,
+				cmd.cache_id);
+	} else {
+		cas_printf(LOG_INFO, "Operation: %s %"PRIu32"\n",
+				async_op_names[cmd.type], cmd.cache_id);
+	}
+
+	cas_printf(LOG_INFO, "Status: %s\n", !cmd.done ? "Running" :
+			cmd.result ? "Failed" : "Completed");
+	cas_printf(LOG_INFO, "Elapsed: %"PRIu64".%03"PRIu64" s\n",
+			cmd.elapsed_ms / 1000, cmd.elapsed_ms % 1000);
+
+	if (cmd.dirty_start) {
+		cleaned = cmd.dirty < cmd.dirty_start ?
+				cmd.dirty_start - cmd.dirty : 0;
+		cas_printf(LOG_INFO, "Dirty: %"PRIu64" of %"PRIu64" cache lines"
+				" (%.1f %% flushed)\n", cmd.dirty,
+				cmd.dirty_start,
+				100.0 * cleaned / cmd.dirty_start);
+	}
+
+	if (cmd.done && cmd.result) {
+		print_err(cmd.result);
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
 struct partition_config_col {
 	const char *name;
 	int pos;
+	/* Column may be left out of configuration file */
+	bool optional;
 };
 
 static struct partition_config_col partition_config_columns[] = {
@@ -2263,14 +2706,18 @@ static struct partition_config_col partition_config_columns[] = {
 	{ .name = "IO class name", .pos = -1 },
 	{ .name = "Eviction priority", .pos = -1 },
 	{ .name = "Allocation", .pos = -1 },
+	{ .name = "Sequential cutoff threshold [KiB]", .pos = -1,
+		.optional = true },
 	{ .name = NULL }
 };
 
-void partition_list_line(FILE *out, struct kcas_io_class *cls, bool csv)
+void partition_list_line(FILE *out, struct kcas_io_class *cls, bool csv,
+		bool seq_cutoff)
 {
 	char buffer[128];
 	const char *prio;
 	char allocation_str[MAX_STR_LEN];
+	char seq_cutoff_str[MAX_STR_LEN] = "";
 
 	snprintf(allocation_str, sizeof(allocation_str), "%d.%02d",
 					cls->info.max_size/100, cls->info.max_size%100);
@@ -2282,18 +2729,29 @@ void partition_list_line(FILE *out, struct kcas_io_class *cls, bool csv)
 		prio = buffer;
 	}
 
-	fprintf(out, TAG(TABLE_ROW)"%u,%s,%s,%s\n",
+	fprintf(out, TAG(TABLE_ROW)"%u,%s,%s,%s",
 		cls->class_id, cls->info.name, prio, allocation_str);
 
+	/* IO class without override follows sequential cutoff of core */
+	if (seq_cutoff) {
+		if (cls->seq_cutoff_threshold) {
+			snprintf(seq_cutoff_str, sizeof(seq_cutoff_str), "%u",
+					cls->seq_cutoff_threshold);
+		}
+		fprintf(out, ",%s", seq_cutoff_str);
+	}
+	fputc('\n', out);
+
 }
 
 int partition_list(uint32_t cache_id, unsigned int output_format)
 {
 	struct kcas_io_class io_class = { .ext_err_code = 0 };
-	int fd, i = 0, result = 0;
+	struct kcas_io_class classes[OCF_USER_IO_CLASS_MAX];
+	int fd, i = 0, count = 0, result = 0;
 	/* 1 is writing end, 0 is reading end of a pipe */
 	FILE *intermediate_file[2];
-	bool use_csv, first_col;
+	bool use_csv, first_col, seq_cutoff = false;
 
 	fd = open_ctrl_device();
 	if (fd == -1 )
@@ -2308,9 +2766,31 @@ int partition_list(uint32_t cache_id, unsigned int output_format)
 
 	use_csv = (output_format == OUTPUT_FORMAT_CSV);
 
+	for (i = 0; i < OCF_USER_IO_CLASS_MAX; i++, io_class.ext_err_code = 0) {
+		io_class.cache_id = cache_id;
+		io_class.class_id = i;
+
+		result = run_ioctl(fd, KCAS_IOCTL_PARTITION_INFO, &io_class);
+		if (result) {
+			if (OCF_ERR_IO_CLASS_NOT_EXIST == io_class.ext_err_code) {
+				result = SUCCESS;
+				continue;
+			} else {
+				result = FAILURE;
+				break;
+			}
+		}
+
+		classes[count++] = io_class;
+		seq_cutoff |= !!io_class.seq_cutoff_threshold;
+	}
+
+	/* Optional columns are listed only if any IO class uses them */
 	first_col = true;
 	fprintf(intermediate_file[1], TAG(TABLE_HEADER));
 	for (i = 0; partition_config_columns[i].name; i++) {
+		if (partition_config_columns[i].optional && !seq_cutoff)
+			continue;
 		if (!first_col) {
 			fputc(',', intermediate_file[1]);
 		}
@@ -2320,6 +2800,66 @@ int partition_list(uint32_t cache_id, unsigned int output_format)
 	}
 	fputc('\n', intermediate_file[1]);
 
+	for (i = 0; i < count; i++) {
+		partition_list_line(intermediate_file[1], &classes[i],
+			use_csv, seq_cutoff);
+	}
+
+	if (io_class.ext_err_code) {
+		print_err(io_class.ext_err_code);
+	}
+
+	fclose(intermediate_file[1]);
+	if (!result && stat_format_output(intermediate_file[0], stdout,
+					  use_csv?RAW_CSV:TEXT)) {
+		cas_printf(LOG_ERR, "An error occured during statistics formatting.\n");
+		result = FAILURE;
+	}
+	fclose(intermediate_file[0]);
+	close(fd);
+
+	return result;
+}
+
+static void partition_stats_line(FILE *out, struct kcas_io_class *cls,
+		struct kcas_io_class_stats *stats)
+{
+	uint32_t i;
+
+	fprintf(out, TAG(TABLE_ROW)"%u,%s,%llu,%llu,\"", cls->class_id,
+		cls->info.name, (unsigned long long)stats->evaluations,
+		(unsigned long long)stats->matches);
+	for (i = 0; i < stats->conditions_no; i++) {
+		fprintf(out, "%s%llu", i ? " " : "",
+			(unsigned long long)stats->condition_evaluations[i]);
+	}
+	fprintf(out, "\"\n");
+}
+
+int partition_stats(uint32_t cache_id, unsigned int output_format)
+{
+	struct kcas_io_class io_class = { .ext_err_code = 0 };
+	struct kcas_io_class_stats stats = { .ext_err_code = 0 };
+	int fd, i = 0, result = 0;
+	/* 1 is writing end, 0 is reading end of a pipe */
+	FILE *intermediate_file[2];
+	bool use_csv, samples = false;
+
+	fd = open_ctrl_device();
+	if (fd == -1 )
+		return FAILURE;
+
+	if (create_pipe_pair(intermediate_file)) {
+		cas_printf(LOG_ERR,"Failed to create unidirectional pipe.\n");
+		close(fd);
+		return FAILURE;
+	}
+
+	use_csv = (output_format == OUTPUT_FORMAT_CSV);
+
+	fprintf(intermediate_file[1], TAG(TABLE_HEADER) "IO class id,"
+		"IO class name,Evaluations,Matches,Condition evaluations\n");
+
 	for (i = 0; i < OCF_USER_IO_CLASS_MAX; i++, io_class.ext_err_code = 0) {
 		io_class.cache_id = cache_id;
 		io_class.class_id = i;
@@ -2335,15 +2875,40 @@ int partition_list(uint32_t cache_id, unsigned int output_format)
 			}
 		}
 
-		partition_list_line(intermediate_file[1],
-			&io_class, use_csv);
+		stats.cache_id = cache_id;
+		stats.class_id = i;
+		result = run_ioctl(fd, KCAS_IOCTL_IO_CLASS_STATS, &stats);
+		if (result) {
+			io_class.ext_err_code = stats.ext_err_code;
+			result = FAILURE;
+			break;
+		}
 
+		if (stats.has_rule)
+			partition_stats_line(intermediate_file[1], &io_class, &stats);
 	}
 
 	if (io_class.ext_err_code) {
 		print_err(io_class.ext_err_code);
 	}
 
+	/* Histogram is common to all IO classes of the cache */
+	for (i = 0; !result && i < KCAS_IO_CLASS_LATENCY_BUCKETS; i++)
+		samples |= !!stats.latency_hist[i];
+
+	if (samples) {
+		fprintf(intermediate_file[1], TAG(TABLE_HEADER)
+			"Classification time [ns],Samples\n");
+		for (i = 0; i < KCAS_IO_CLASS_LATENCY_BUCKETS; i++) {
+			if (!stats.latency_hist[i])
+				continue;
+			fprintf(intermediate_file[1], TAG(TABLE_ROW)
+				"%llu-%llu,%llu\n", 1ULL << i,
+				(1ULL << (i + 1)) - 1,
+				(unsigned long long)stats.latency_hist[i]);
+		}
+	}
+
 	fclose(intermediate_file[1]);
 	if (!result && stat_format_output(intermediate_file[0], stdout,
 					  use_csv?RAW_CSV:TEXT)) {
@@ -2356,11 +2921,132 @@ int partition_list(uint32_t cache_id, unsigned int output_format)
 	return result;
 }
 
+/* Synthetic requests of classifier benchmark */
+#define IO_CLASS_BENCH_REQUESTS 16384
+#define IO_CLASS_BENCH_ROUNDS 64
+#define IO_CLASS_BENCH_MAX_PAGES 32
+#define IO_CLASS_BENCH_READ_PERCENT 70
+
+/* Part of file read, so that its pages are in page cache */
+#define IO_CLASS_BENCH_FILE_READ (16 * MiB)
+
+static int partition_bench_read_file(const char *path)
+{
+	char buf[64 * KiB];
+	ssize_t bytes;
+	size_t total = 0;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		cas_printf(LOG_ERR, "Failed to open %s\n", path);
+		return FAILURE;
+	}
+
+	while (total < IO_CLASS_BENCH_FILE_READ) {
+		bytes = read(fd, buf, sizeof(buf));
+		if (bytes <= 0)
+			break;
+		total += bytes;
+	}
+
+	close(fd);
+	return SUCCESS;
+}
+
+int partition_bench(uint32_t cache_id, uint16_t core_id, const char *path,
+		unsigned int output_format)
+{
+	struct kcas_io_class io_class = { .ext_err_code = 0 };
+	struct kcas_io_class_bench *cmd;
+	/* 1 is writing end, 0 is reading end of a pipe */
+	FILE *intermediate_file[2];
+	int fd, i, result = SUCCESS;
+	bool use_csv;
+
+	if (path[0] && partition_bench_read_file(path))
+		return FAILURE;
+
+	cmd = calloc(1, sizeof(*cmd));
+	if (!cmd) {
+		cas_printf(LOG_ERR, "Failed to allocate memory\n");
+		return FAILURE;
+	}
+
+	cmd->cache_id = cache_id;
+	cmd->core_id = core_id;
+	strncpy_s(cmd->path, sizeof(cmd->path), path,
+			strnlen_s(path, sizeof(cmd->path)));
+	cmd->requests = IO_CLASS_BENCH_REQUESTS;
+	cmd->rounds = IO_CLASS_BENCH_ROUNDS;
+	cmd->max_pages = IO_CLASS_BENCH_MAX_PAGES;
+	cmd->read_percent = IO_CLASS_BENCH_READ_PERCENT;
+
+	fd = open_ctrl_device();
+	if (fd == -1) {
+		free(cmd);
+		return FAILURE;
+	}
+
+	if (run_ioctl(fd, KCAS_IOCTL_IO_CLASS_BENCH, cmd)) {
+		cas_printf(LOG_ERR, "Error running classifier benchmark\n");
+		print_err(cmd->ext_err_code);
+		result = FAILURE;
+		goto close;
+	}
+
+	if (create_pipe_pair(intermediate_file)) {
+		cas_printf(LOG_ERR,"Failed to create unidirectional pipe.\n");
+		result = FAILURE;
+		goto close;
+	}
+
+	use_csv = (output_format == OUTPUT_FORMAT_CSV);
+
+	fprintf(intermediate_file[1], TAG(TABLE_HEADER) "Requests,"
+		"File requests,Classifications,Time per classification [ns]\n");
+	fprintf(intermediate_file[1], TAG(TABLE_ROW) "%u,%u,%llu,%.1f\n",
+		cmd->requests, cmd->file_requests,
+		(unsigned long long)cmd->classifications,
+		cmd->classifications ?
+			(double)cmd->elapsed_ns / cmd->classifications : 0);
+
+	fprintf(intermediate_file[1], TAG(TABLE_HEADER) "IO class id,"
+		"IO class name,Classifications\n");
+	for (i = 0; i < OCF_USER_IO_CLASS_MAX; i++, io_class.ext_err_code = 0) {
+		if (!cmd->io_class_hits[i])
+			continue;
+
+		io_class.cache_id = cache_id;
+		io_class.class_id = i;
+		if (run_ioctl(fd, KCAS_IOCTL_PARTITION_INFO, &io_class))
+			io_class.info.name[0] = '\0';
+
+		fprintf(intermediate_file[1], TAG(TABLE_ROW) "%u,%s,%llu\n",
+			i, io_class.info.name,
+			(unsigned long long)cmd->io_class_hits[i]);
+	}
+
+	fclose(intermediate_file[1]);
+	if (stat_format_output(intermediate_file[0], stdout,
+			       use_csv?RAW_CSV:TEXT)) {
+		cas_printf(LOG_ERR, "An error occured during statistics formatting.\n");
+		result = FAILURE;
+	}
+	fclose(intermediate_file[0]);
+
+close:
+	close(fd);
+	free(cmd);
+	return result;
+}
+
 enum {
 	part_csv_coll_id = 0,
 	part_csv_coll_name,
 	part_csv_coll_prio,
 	part_csv_coll_alloc,
+	part_csv_coll_seq_cutoff,
 	part_csv_coll_max
 };
 
@@ -2427,7 +3113,7 @@ static inline int partition_get_line(CSVFILE *csv,
 {
 	uint32_t part_id;
 	uint32_t value;
-	const char *id, *name, *prio, *alloc;
+	const char *id, *name, *prio, *alloc, *seq_cutoff = "";
 
 	id = partition_get_csv_col(csv, part_csv_coll_id, error_col);
 	if (!id) {
@@ -2445,6 +3131,13 @@ static inline int partition_get_line(CSVFILE *csv,
 	if (!alloc) {
 		return FAILURE;
 	}
+	if (partition_config_columns[part_csv_coll_seq_cutoff].pos >= 0) {
+		seq_cutoff = partition_get_csv_col(csv,
+				part_csv_coll_seq_cutoff, error_col);
+		if (!seq_cutoff) {
+			return FAILURE;
+		}
+	}
 
 	/* Validate ID */
 	*error_col = part_csv_coll_id;
@@ -2475,7 +3168,7 @@ static inline int partition_get_line(CSVFILE *csv,
 
 	/* Validate Priority*/
 	*error_col = part_csv_coll_prio;
-	if (strempty(prio)) {
+	if (strempty(prio) || !strncmp(prio, "pinned", MAX_STR_LEN)) {
 		value = OCF_IO_CLASS_PRIO_PINNED;
 	} else {
 		if (validate_str_num(prio, "prio", OCF_IO_CLASS_PRIO_HIGHEST,
@@ -2495,10 +3188,34 @@ static inline int partition_get_line(CSVFILE *csv,
 	if (calculate_max_allocation(cnfg->cache_id, alloc, &value) == FAILURE)
 		return FAILURE;
 
+	/* Allocation is the only thing capping occupancy of pinned class */
+	if (OCF_IO_CLASS_PRIO_PINNED == cnfg->info[part_id].priority &&
+			value == 100) {
+		cas_printf(LOG_WARNING, "WARNING: IO class %u is pinned with "
+				"allocation 1, its data may fill whole cache "
+				"and is never evicted.\n", part_id);
+	}
+
 	cnfg->info[part_id].cache_mode = ocf_cache_mode_max;
 	cnfg->info[part_id].min_size = 0;
 	cnfg->info[part_id].max_size = value;
 
+	/* Validate sequential cutoff threshold, empty if not overridden */
+	*error_col = part_csv_coll_seq_cutoff;
+	if (!strempty(seq_cutoff)) {
+		if (part_id == KCAS_IO_CLASS_BYPASS) {
+			cas_printf(LOG_ERR, "IO class %u is reserved for "
+					"requests bypassing cache\n", part_id);
+			return FAILURE;
+		}
+		if (validate_str_num(seq_cutoff, "sequential cutoff threshold",
+				1, OCF_SEQ_CUTOFF_MAX_THRESHOLD / KiB)) {
+			return FAILURE;
+		}
+		cnfg->seq_cutoff_threshold[part_id] = strtoul(seq_cutoff,
+				NULL, 10);
+	}
+
 	return 0;
 }
 
@@ -2531,7 +3248,8 @@ static int partition_parse_header(CSVFILE *csv)
 	}
 
 	for (i = 0; partition_config_columns[i].name; i++) {
-		if (partition_config_columns[i].pos < 0) {
+		if (partition_config_columns[i].pos < 0 &&
+				!partition_config_columns[i].optional) {
 			cas_printf(LOG_ERR,
 				   "Cannot parse configuration file - missing column \"%s\".\n",
 				   partition_config_columns[i].name);
@@ -2547,6 +3265,7 @@ int partition_get_config(CSVFILE *csv, struct kcas_io_classes *cnfg,
 	int result = 0, count = 0;
 	int line = 1;
 	int error_col = -1;
+	int cols;
 
 	cnfg->cache_id = cache_id;
 
@@ -2575,6 +3294,7 @@ int partition_get_config(CSVFILE *csv, struct kcas_io_classes *cnfg,
 			   " be named.\n");
 		return FAILURE;
 	}
+	cols = csv_count_cols(csv);
 
 	/* check all lines of input */
 	while (!csv_feof(csv)) {
@@ -2588,7 +3308,7 @@ int partition_get_config(CSVFILE *csv, struct kcas_io_classes *cnfg,
 			}
 		}
 
-		if (part_csv_coll_max != csv_count_cols(csv)) {
+		if (cols != csv_count_cols(csv)) {
 			if (csv_empty_line(csv)) {
 				continue;
 			} else {
@@ -2649,20 +3369,11 @@ int partition_set_config(struct kcas_io_classes *cnfg)
 	return result;
 }
 
-int partition_setup(uint32_t cache_id, const char *file)
+static int partition_read_csv(const char *file, struct kcas_io_classes *cnfg,
+		uint32_t cache_id)
 {
-	int result = 0;
+	int result;
 	CSVFILE *in;
-	struct kcas_io_classes *cnfg = calloc(1, KCAS_IO_CLASSES_SIZE);
-
-	if (!cnfg)
-		return FAILURE;
-
-	if (strempty(file)) {
-		cas_printf(LOG_ERR, "Invalid path of configuration file\n");
-		result = FAILURE;
-		goto exit;
-	}
 
 	if ('-'==file[0] && (!file[1])) {
 		/* configuration is supposed to be read from stdin. Setup
@@ -2676,15 +3387,10 @@ int partition_setup(uint32_t cache_id, const char *file)
 	if (NULL == in) {
 		cas_printf(LOG_ERR, "Cannot open configuration file %s\n",
 				file);
-		result = FAILURE;
-		goto exit;
+		return FAILURE;
 	}
 
-	if (0 == partition_get_config(in, cnfg, cache_id)) {
-		result = partition_set_config(cnfg);
-	} else {
-		result = FAILURE;
-	}
+	result = partition_get_config(in, cnfg, cache_id) ? FAILURE : SUCCESS;
 
 	if ('-' == file[0] && (!file[1])) {
 		/* free assets allocated by CSV parser without actually
@@ -2694,6 +3400,198 @@ int partition_setup(uint32_t cache_id, const char *file)
 		csv_close(in);
 	}
 
+	return result;
+}
+
+/*
+ * Compiled IO class configuration. Configuration file is parsed and
+ * validated once by --compile and the image is loaded as it is
+ * afterwards. Layout is fixed by version, independently of ioctl
+ * structures.
+ */
+#define IO_CLASS_IMAGE_MAGIC "CASIOCL"
+#define IO_CLASS_IMAGE_VERSION 1
+
+struct io_class_image_header {
+	char magic[8];
+	uint32_t version;
+	/** number of entries following header */
+	uint32_t count;
+	/** size of single entry */
+	uint32_t entry_size;
+	uint32_t reserved;
+};
+
+struct io_class_image_entry {
+	uint32_t id;
+	uint32_t priority;
+	/** allocation in percent */
+	uint32_t max_size;
+	/** sequential cutoff threshold override [KiB], 0 - none */
+	uint32_t seq_cutoff_threshold;
+	char name[OCF_IO_CLASS_NAME_MAX];
+};
+
+static bool partition_is_image(const char *file)
+{
+	struct io_class_image_header hdr;
+	bool result = false;
+	FILE *in;
+
+	if ('-' == file[0] && (!file[1]))
+		return false;
+
+	in = fopen(file, "rb");
+	if (!in)
+		return false;
+
+	if (fread(&hdr, sizeof(hdr), 1, in) == 1) {
+		result = !memcmp(hdr.magic, IO_CLASS_IMAGE_MAGIC,
+				sizeof(hdr.magic));
+	}
+
+	fclose(in);
+	return result;
+}
+
+static int partition_read_image(const char *file,
+		struct kcas_io_classes *cnfg, uint32_t cache_id)
+{
+	struct io_class_image_header hdr;
+	struct io_class_image_entry entry;
+	int result = FAILURE;
+	uint32_t i;
+	FILE *in;
+
+	cnfg->cache_id = cache_id;
+
+	in = fopen(file, "rb");
+	if (!in) {
+		cas_printf(LOG_ERR, "Cannot open configuration file %s\n",
+				file);
+		return FAILURE;
+	}
+
+	if (fread(&hdr, sizeof(hdr), 1, in) != 1 ||
+			hdr.version != IO_CLASS_IMAGE_VERSION ||
+			hdr.entry_size != sizeof(entry) ||
+			!hdr.count || hdr.count > OCF_USER_IO_CLASS_MAX) {
+		cas_printf(LOG_ERR, "Unsupported or corrupted IO class "
+				"configuration image %s\n", file);
+		goto out;
+	}
+
+	for (i = 0; i < hdr.count; i++) {
+		if (fread(&entry, sizeof(entry), 1, in) != 1 ||
+				entry.id > OCF_IO_CLASS_ID_MAX ||
+				!memchr(entry.name, '\0', sizeof(entry.name)) ||
+				!strempty(cnfg->info[entry.id].name)) {
+			cas_printf(LOG_ERR, "Corrupted entry %u of IO class "
+					"configuration image %s\n", i, file);
+			goto out;
+		}
+
+		strncpy_s(cnfg->info[entry.id].name,
+				sizeof(cnfg->info[entry.id].name), entry.name,
+				strnlen_s(entry.name, sizeof(entry.name)));
+		cnfg->info[entry.id].priority = entry.priority;
+		cnfg->info[entry.id].cache_mode = ocf_cache_mode_max;
+		cnfg->info[entry.id].min_size = 0;
+		cnfg->info[entry.id].max_size = entry.max_size;
+		cnfg->seq_cutoff_threshold[entry.id] =
+				entry.seq_cutoff_threshold;
+	}
+
+	result = SUCCESS;
+
+out:
+	fclose(in);
+	return result;
+}
+
+int partition_compile(const char *file, const char *image)
+{
+	struct io_class_image_header hdr = {};
+	struct io_class_image_entry entry;
+	struct kcas_io_classes *cnfg;
+	int result = FAILURE;
+	uint32_t i;
+	FILE *out;
+
+	cnfg = calloc(1, KCAS_IO_CLASSES_SIZE);
+	if (!cnfg)
+		return FAILURE;
+
+	if (partition_read_csv(file, cnfg, OCF_CACHE_ID_INVALID))
+		goto out_free;
+
+	memcpy(hdr.magic, IO_CLASS_IMAGE_MAGIC, sizeof(hdr.magic));
+	hdr.version = IO_CLASS_IMAGE_VERSION;
+	hdr.entry_size = sizeof(entry);
+	for (i = 0; i < OCF_USER_IO_CLASS_MAX; i++)
+		hdr.count += !strempty(cnfg->info[i].name);
+
+	out = fopen(image, "wb");
+	if (!out) {
+		cas_printf(LOG_ERR, "Cannot open image file %s\n", image);
+		goto out_free;
+	}
+
+	if (fwrite(&hdr, sizeof(hdr), 1, out) != 1)
+		goto out_close;
+
+	for (i = 0; i < OCF_USER_IO_CLASS_MAX; i++) {
+		if (strempty(cnfg->info[i].name))
+			continue;
+
+		memset(&entry, 0, sizeof(entry));
+		entry.id = i;
+		entry.priority = cnfg->info[i].priority;
+		entry.max_size = cnfg->info[i].max_size;
+		entry.seq_cutoff_threshold = cnfg->seq_cutoff_threshold[i];
+		strncpy_s(entry.name, sizeof(entry.name), cnfg->info[i].name,
+				strnlen_s(cnfg->info[i].name,
+					sizeof(cnfg->info[i].name)));
+
+		if (fwrite(&entry, sizeof(entry), 1, out) != 1)
+			goto out_close;
+	}
+
+	result = SUCCESS;
+
+out_close:
+	if (fclose(out) || result) {
+		cas_printf(LOG_ERR, "Cannot write image file %s\n", image);
+		result = FAILURE;
+	}
+out_free:
+	free(cnfg);
+	return result;
+}
+
+int partition_setup(uint32_t cache_id, const char *file)
+{
+	int result = 0;
+	struct kcas_io_classes *cnfg = calloc(1, KCAS_IO_CLASSES_SIZE);
+
+	if (!cnfg)
+		return FAILURE;
+
+	if (strempty(file)) {
+		cas_printf(LOG_ERR, "Invalid path of configuration file\n");
+		result = FAILURE;
+		goto exit;
+	}
+
+	/* Image compiled by --compile is validated already */
+	if (partition_is_image(file))
+		result = partition_read_image(file, cnfg, cache_id);
+	else
+		result = partition_read_csv(file, cnfg, cache_id);
+
+	if (!result)
+		result = partition_set_config(cnfg);
+
 exit:
 	free(cnfg);
 	return result;
@@ -2969,6 +3867,18 @@ int list_caches(unsigned int list_format, bool by_id_path)
 			tmp_status = status_buf;
 			snprintf(mode_string, sizeof(mode_string), "wb->%s",
 					cache_mode_to_name(curr_cache->mode));
+		} else if (curr_cache->purge_total) {
+			snprintf(status_buf, sizeof(status_buf),
+				"%s (%3.1f %%)", "Purging", 100.0 *
+				curr_cache->purge_done / curr_cache->purge_total);
+			tmp_status = status_buf;
+			snprintf(mode_string, sizeof(mode_string), "%s",
+					cache_mode_to_name(curr_cache->mode));
+		} else if (curr_cache->mode_drain_from != ocf_cache_mode_none) {
+			tmp_status = "Draining";
+			snprintf(mode_string, sizeof(mode_string), "%s->%s",
+					cache_mode_to_name(curr_cache->mode_drain_from),
+					cache_mode_to_name(curr_cache->mode));
 		} else {
 			tmp_status = get_cache_state_name(curr_cache->state, curr_cache->standby_detached);
 
@@ -43,6 +43,9 @@ struct cache_device {
 	int expected_core_count;
 	char device[MAX_STR_LEN];
 	int mode;
+	int mode_drain_from; /* lazy write mode being drained after switch */
+	uint32_t purge_total; /* purge chunks, 0 if no purge in progress */
+	uint32_t purge_done;
 	int eviction_policy;
 	int cleaning_policy;
 	int promotion_policy;
@@ -77,6 +80,12 @@ enum output_format_t {
 #define STATS_FILTER_BLK (1 << 3)
 #define STATS_FILTER_ERR (1 << 4)
 #define STATS_FILTER_IOCLASS (1 << 5)
+#define STATS_FILTER_LAT (1 << 6)
+#define STATS_FILTER_QUEUE (1 << 7)
+#define STATS_FILTER_MEM (1 << 8)
+#define STATS_FILTER_HEATMAP (1 << 9)
+#define STATS_FILTER_MRC (1 << 10)
+#define STATS_FILTER_INTERNAL (1 << 11)
 #define STATS_FILTER_ALL (STATS_FILTER_CONF |	\
 			  STATS_FILTER_USAGE |	\
 			  STATS_FILTER_REQ |	\
@@ -137,11 +146,13 @@ int dump_inflight_of_cache(uint32_t cache_id);
 /**
  * @brief handle set cache param command
  * @param cache_id id of cache device
+ * @param io_class_id io class of per io class params
  * @param params parameter array
  * @return exit code of successful completion is 0;
  * nonzero exit code means failure
  */
-int cache_params_set(uint32_t cache_id, struct cas_param *params);
+int cache_params_set(uint32_t cache_id, uint32_t io_class_id,
+		struct cas_param *params);
 
 /**
  * @brief get cache param value
@@ -156,34 +167,38 @@ int cache_get_param(uint32_t cache_id, unsigned int param_id,
 /**
  * @brief handle get cache param command
  * @param cache_id id of cache device
+ * @param io_class_id io class of per io class params
  * @param params parameter array
  * @return exit code of successful completion is 0;
  * nonzero exit code means failure
  */
-int cache_params_get(uint32_t cache_id, struct cas_param *params,
-		unsigned int output_format);
+int cache_params_get(uint32_t cache_id, uint32_t io_class_id,
+		struct cas_param *params, unsigned int output_format);
 
 /**
  * @brief handle set core param command
  * @param cache_id id of cache device
  * @param core_id id of core device
+ * @param io_class_id io class of per io class params
  * @param params parameter array
  * @return exit code of successful completion is 0;
  * nonzero exit code means failure
  */
 int core_params_set(uint32_t cache_id, unsigned int core_id,
-		struct cas_param *params);
+		uint32_t io_class_id, struct cas_param *params);
 
 /**
  * @brief handle get core param command
  * @param cache_id id of cache device
  * @param core_id id of core device
+ * @param io_class_id io class of per io class params
  * @param params parameter array
  * @return exit code of successful completion is 0;
  * nonzero exit code means failure
  */
 int core_params_get(uint32_t cache_id, unsigned int core_id,
-		struct cas_param *params, unsigned int output_format);
+		uint32_t io_class_id, struct cas_param *params,
+		unsigned int output_format);
 
 /**
  * @brief handle set cache mode (-Q) command
@@ -202,9 +217,30 @@ int set_cache_mode(unsigned int cache_state, uint32_t cache_id, int flush);
  * @param iogroup_id id of iogroup (this parameter is not exposed in user CLI)
  * @param try_add try add core to earlier loaded cache or add to core pool
  * @param update_path try update path to core device
+ * @param queue_depth exported object queue depth, 0 - inherit from devices
+ * @param hw_queues number of exported object hw queues, 0 - inherit from devices
+ * @param read_ahead_kb exported object read-ahead in KiB, 0 - derive
+ * @param io_opt_kb exported object optimal I/O size in KiB, 0 - derive
  * @return 0 upon successful core addition, 1 upon failure
  */
-int add_core(uint32_t cache_id, unsigned int core_id, const char *core_device, int try_add, int update_path, const char *fs_meta_map_file);
+int add_core(uint32_t cache_id, unsigned int core_id, const char *core_device, int try_add, int update_path, const char *fs_meta_map_file,
+		uint32_t queue_depth, uint32_t hw_queues,
+		uint32_t read_ahead_kb, uint32_t io_opt_kb);
+
+/**
+ * @brief add cores given as comma separated list of devices in single call
+ *
+ * @param cache_id cache to which cores are added
+ * @param core_devices comma separated list of core devices
+ * @param queue_depth exported objects queue depth, 0 - inherit
+ * @param hw_queues exported objects hw queues, 0 - inherit
+ * @param read_ahead_kb exported objects read-ahead in KiB, 0 - derive
+ * @param io_opt_kb exported objects optimal I/O size in KiB, 0 - derive
+ * @return 0 upon successful addition of all cores, 1 otherwise
+ */
+int add_cores(uint32_t cache_id, const char *core_devices,
+		uint32_t queue_depth, uint32_t hw_queues,
+		uint32_t read_ahead_kb, uint32_t io_opt_kb);
 
 int get_core_info(int fd, uint32_t cache_id, int core_id, struct kcas_core_info *info, bool by_id_path);
 
@@ -267,25 +303,72 @@ void check_cache_state_incomplete(uint32_t cache_id, int fd);
  */
 int remove_inactive_core(uint32_t cache_id, unsigned int core_id, bool force);
 
+/**
+ * @brief add extents listed in file to fs meta map of core, or remove them
+ */
+int update_fs_meta(uint32_t cache_id, unsigned int core_id,
+		const char *fs_meta_map_file, bool remove);
+
 int core_pool_remove(const char *core_device);
 int get_core_pool_count(int fd);
 
 int reset_counters(uint32_t cache_id, unsigned int core_id);
 
-int purge_cache(uint32_t cache_id);
-int purge_core(uint32_t cache_id, unsigned int core_id);
+int purge_cache(uint32_t cache_id, bool background);
+int purge_core(uint32_t cache_id, unsigned int core_id, bool background);
+
+int flush_cache(uint32_t cache_id, uint32_t rate_limit);
+int flush_core(uint32_t cache_id, unsigned int core_id,
+		uint32_t rate_limit);
 
-int flush_cache(uint32_t cache_id);
-int flush_core(uint32_t cache_id, unsigned int core_id);
+/**
+ * @brief run management operation in background
+ * @param type operation to run, enum kcas_async_op_type
+ * @return SUCCESS if operation was queued
+ */
+int async_op_start(uint32_t type, uint32_t cache_id, unsigned int core_id,
+		int flush_data, uint32_t rate_limit);
+
+/**
+ * @brief print status of operation run in background, releasing it
+ * when it is completed
+ * @param wait block until operation completes
+ * @return FAILURE if status can't be retrieved or operation failed
+ */
+int async_op_status(uint64_t op_id, bool wait);
 
 int check_cache_device(const char *device_path);
 
 int partition_list(uint32_t cache_id, unsigned int output_format);
+int partition_stats(uint32_t cache_id, unsigned int output_format);
+int partition_bench(uint32_t cache_id, uint16_t core_id, const char *path,
+		unsigned int output_format);
 int partition_setup(uint32_t cache_id, const char *file);
+
+/**
+ * @brief validate IO class configuration file and compile it into image,
+ *	which can be loaded by partition_setup() without parsing
+ *
+ * @param file IO class configuration file, "-" for standard input
+ * @param image path of image to be written
+ * @return 0 upon success, 1 upon failure
+ */
+int partition_compile(const char *file, const char *image);
+
 int partition_is_name_valid(const char *name);
 
 int cas_module_version(char *buff, int size);
 int list_caches(unsigned int list_format, bool by_id_path);
+int cache_status_watch(uint32_t cache_id, unsigned int core_id,
+		       uint32_t interval, unsigned int output_format);
+int cache_inflight_dump(uint32_t cache_id, unsigned int output_format);
+int cache_bench(struct kcas_bench *cmd, unsigned int output_format);
+
+/* Pool of allocator benchmark by name, -1 if unknown */
+int alloc_bench_pool_from_name(const char *name);
+
+int alloc_bench(struct kcas_alloc_bench *cmd, unsigned int output_format);
+
 int cache_status(uint32_t cache_id, unsigned int core_id, int io_class_id,
 		 unsigned int stats_filters, unsigned int stats_format, bool by_id_path);
 int get_inactive_core_count(const struct kcas_cache_info *cache_info);
@@ -293,6 +376,7 @@ int get_inactive_core_count(const struct kcas_cache_info *cache_info);
 int open_ctrl_device_quiet();
 int open_ctrl_device();
 uint32_t *get_cache_ids(int *cache_count);
+uint32_t *get_cache_ids_fd(int fd, int *cache_count);
 struct cache_device *get_cache_device_by_id_fd(uint32_t cache_id, int fd, bool by_id_path);
 struct cache_device **get_cache_devices(int *caches_count, bool by_id_path);
 void free_cache_devices_list(struct cache_device **caches, int caches_count);
@@ -343,6 +427,13 @@ int get_flush_progress(uint32_t cache_id, float *progress);
  */
 void print_err(int error_code);
 
+/**
+ * @brief get length of prefix of device path selecting null ("null:") or
+ * RAM-backed ("ram:") volume on top of the device.
+ * @return length of prefix, 0 if path has no prefix
+ */
+size_t volume_path_prefix_len(const char *path);
+
 /**
   * @brief get special device file path (/dev/sdX) for disk.
   */
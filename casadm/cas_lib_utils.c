@@ -12,6 +12,9 @@
 #include <sys/types.h>
 #include <time.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <libgen.h>
 #include "cas_lib.h"
 #include "extended_err_msg.h"
 #include "cas_lib_utils.h"
@@ -312,6 +315,65 @@ void get_cache_flush_progress(int fd, uint32_t cache_id, float *prog)
 	}
 }
 
+/* Number of 512B sectors read from block device so far, from sysfs */
+static int get_device_read_sectors(const char *device, uint64_t *sectors)
+{
+	char path[PATH_MAX];
+	unsigned long long ios, merges, sects;
+	char *real_path;
+	FILE *stat_file;
+	int ret;
+
+	real_path = realpath(device, NULL);
+	if (!real_path)
+		return FAILURE;
+
+	snprintf(path, sizeof(path), "/sys/class/block/%s/stat",
+			basename(real_path));
+	free(real_path);
+
+	stat_file = fopen(path, "r");
+	if (!stat_file)
+		return FAILURE;
+
+	ret = fscanf(stat_file, "%llu %llu %llu", &ios, &merges, &sects);
+	fclose(stat_file);
+	if (ret != 3)
+		return FAILURE;
+
+	*sectors = sects;
+	return SUCCESS;
+}
+
+/*
+ * Load progress is estimated as amount of data read from cache device
+ * against size of metadata reported by kernel.
+ */
+static void get_cache_load_progress(int fd, struct progress_status *ps, float *prog)
+{
+	struct kcas_load_progress cmd_info;
+	uint64_t sectors;
+	float read;
+
+	memset(&cmd_info, 0, sizeof(cmd_info));
+	cmd_info.cache_id = ps->cache_id;
+
+	if (ioctl(fd, KCAS_IOCTL_LOAD_PROGRESS, &cmd_info) ||
+			!cmd_info.metadata_size) {
+		return;
+	}
+
+	if (get_device_read_sectors(ps->load_device, &sectors) ||
+			sectors < ps->load_read_sectors) {
+		return;
+	}
+
+	read = (sectors - ps->load_read_sectors) * 512.;
+	*prog = read * 100. / cmd_info.metadata_size;
+	if (*prog > 99.)
+		*prog = 99.;
+}
+
 /**
  * pthread thread handling function - runs during proper ioctl execution. Prints command progress
  */
@@ -391,7 +453,9 @@ void *print_command_progress(void *th_arg)
 			break;
 		}
 
-		if (ps->core_id == OCF_CORE_ID_INVALID) {
+		if (ps->load_device) {
+			get_cache_load_progress(fd, ps, &prog);
+		} else if (ps->core_id == OCF_CORE_ID_INVALID) {
 			get_cache_flush_progress(fd, ps->cache_id, &prog);
 		} else {
 			get_core_flush_progress(fd, ps->cache_id, ps->core_id, &prog);
@@ -435,7 +499,8 @@ void *print_command_progress(void *th_arg)
  * @param retry decide if ioctl attepmts should retry
  */
 static int run_ioctl_interruptible_retry_option(int fd, int command, void *cmd,
-		char *friendly_name, uint32_t cache_id, int core_id, bool retry)
+		char *friendly_name, uint32_t cache_id, int core_id, bool retry,
+		const char *load_device)
 {
 	pthread_t thread;
 	int ioctl_res;
@@ -446,6 +511,10 @@ static int run_ioctl_interruptible_retry_option(int fd, int command, void *cmd,
 	ps.friendly_name = friendly_name;
 	ps.cache_id = cache_id;
 	ps.core_id = core_id;
+	if (load_device && !get_device_read_sectors(load_device,
+				&ps.load_read_sectors)) {
+		ps.load_device = load_device;
+	}
 	if (pipe(fdspipe)) {
 		cas_printf(LOG_ERR,"Failed to allocate pipes.\n");
 		return -1;
@@ -484,7 +553,7 @@ int run_ioctl_interruptible(int fd, int command, void *cmd,
 		char *friendly_name, uint32_t cache_id, int core_id)
 {
 	return run_ioctl_interruptible_retry_option(fd, command, cmd, friendly_name, 
-				cache_id, core_id, false);
+				cache_id, core_id, false, NULL);
 }
 
 /*
@@ -498,7 +567,20 @@ int run_ioctl_interruptible_retry(int fd, int command, void *cmd,
 		char *friendly_name, uint32_t cache_id, int core_id)
 {
 	return run_ioctl_interruptible_retry_option(fd, command, cmd, friendly_name, 
-				cache_id, core_id, true);
+				cache_id, core_id, true, NULL);
+}
+
+/*
+ * Run ioctl loading cache metadata from @load_device with retries,
+ * displaying progressbar of load if it takes longer.
+ * Catch SIGINT signal.
+ */
+int run_ioctl_interruptible_load(int fd, int command, void *cmd,
+		char *friendly_name, uint32_t cache_id, const char *load_device)
+{
+	return run_ioctl_interruptible_retry_option(fd, command, cmd,
+			friendly_name, cache_id, OCF_CORE_ID_INVALID, true,
+			load_device);
 }
 
 /*
@@ -22,6 +22,10 @@ struct progress_status {
 					 *!< be displayed in command prompt */
 	uint32_t cache_id;		/*!< cache id */
 	int core_id;			/*!< core id */
+	const char *load_device;	/*!< cache device metadata of which is
+					 *!< loaded, NULL if not loading */
+	uint64_t load_read_sectors;	/*!< sectors read from load_device
+					 *!< before load was started */
 };
 
 
@@ -33,6 +37,8 @@ int run_ioctl_interruptible(int fd, int command, void *cmd,
 		char *friendly_name, uint32_t cache_id, int core_id);
 int run_ioctl_interruptible_retry(int fd, int command, void *cmd,
 		char *friendly_name, uint32_t cache_id, int core_id);
+int run_ioctl_interruptible_load(int fd, int command, void *cmd,
+		char *friendly_name, uint32_t cache_id, const char *load_device);
 int open_ctrl_device();
 int was_ioctl_interrupted();
 void set_default_sig_handler();
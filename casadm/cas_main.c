@@ -23,6 +23,10 @@
 #include "safeclib/safe_str_lib.h"
 #include <cas_ioctl_codes.h>
 #include "statistics_view.h"
+#include "statistics_export.h"
+#include "hot_set.h"
+#include "io_trace.h"
+#include "prefetch.h"
 
 #define DIV_ROUND_UP(n, d) (((n) + (d) - 1) / (d))
 
@@ -36,6 +40,13 @@ extern cas_printf_t cas_printf;
 #define PARAM_TYPE_CORE		1
 #define PARAM_TYPE_CACHE	2
 
+/* Same as BLK_MQ_MAX_DEPTH of the kernel */
+#define EXP_OBJ_QUEUE_DEPTH_MAX	10240
+#define EXP_OBJ_HW_QUEUES_MAX	1024
+#define INFLIGHT_LIMIT_MAX	65536
+#define FLUSH_RATE_LIMIT_MAX	1048576
+#define WATCH_INTERVAL_MAX	3600
+
 /* struct with all the commands parameters/flags with default values */
 struct command_args{
 	int force;
@@ -54,8 +65,16 @@ struct command_args{
 	int script_subcmd;
 	int try_add;
 	int update_path;
+	uint32_t queue_depth;
+	uint32_t hw_queues;
+	uint32_t read_ahead_kb;
+	uint32_t io_opt_kb;
+	uint32_t flush_rate_limit;
+	uint32_t watch_interval;
 	int detach;
 	int no_flush;
+	int fs_meta_remove;
+	bool purge_background;
 	const char* cache_device;
 	const char* core_device;
 	const char* fs_meta_map_file;
@@ -64,6 +83,8 @@ struct command_args{
 	uint32_t params_count;
 	bool verbose;
 	bool by_id_path;
+	bool kernel_log;
+	bool async;
 };
 
 static struct command_args command_args_values = {
@@ -83,6 +104,12 @@ static struct command_args command_args_values = {
 		.script_subcmd = -1,
 		.try_add = false,
 		.update_path = false,
+		.queue_depth = 0,
+		.hw_queues = 0,
+		.read_ahead_kb = 0,
+		.io_opt_kb = 0,
+		.flush_rate_limit = 0,
+		.watch_interval = 0,
 		.detach = false,
 		.no_flush = false,
 		.cache_device = NULL,
@@ -90,6 +117,8 @@ static struct command_args command_args_values = {
 		.fs_meta_map_file = NULL,
 		.fs_meta_map_files = NULL,
 		.by_id_path = false,
+		.kernel_log = false,
+		.async = false,
 
 		.params_type = 0,
 		.params_count = 0,
@@ -108,6 +137,31 @@ int validate_device_name(const char *dev_name) {
 	return SUCCESS;
 }
 
+/* Multiple core devices are given as comma separated list */
+static int validate_core_devices(const char *devices)
+{
+	char *paths, *member, *savep;
+	int result = SUCCESS;
+
+	if (!strchr(devices, ','))
+		return validate_device_name(devices);
+
+	paths = strdup(devices);
+	if (!paths)
+		return FAILURE;
+
+	for (member = strtok_r(paths, ",", &savep); member;
+			member = strtok_r(NULL, ",", &savep)) {
+		result = validate_device_name(member);
+		if (result != SUCCESS)
+			break;
+	}
+
+	free(paths);
+
+	return result;
+}
+
 int command_handle_option(char *opt, const char **arg)
 {
 	if (!strcmp(opt, "cache-id")) {
@@ -122,7 +176,7 @@ int command_handle_option(char *opt, const char **arg)
 
 		command_args_values.core_id = atoi(arg[0]);
 	} else if (!strcmp(opt, "core-device")) {
-		if (validate_device_name(arg[0]) == FAILURE)
+		if (validate_core_devices(arg[0]) == FAILURE)
 			return FAILURE;
 
 		command_args_values.core_device = arg[0];
@@ -136,6 +190,8 @@ int command_handle_option(char *opt, const char **arg)
 			return FAILURE;
 
 		command_args_values.fs_meta_map_file = arg[0];
+	} else if (!strcmp(opt, "remove")) {
+		command_args_values.fs_meta_remove = 1;
 	} else if (!strcmp(opt, "no-data-flush")) {
 		command_args_values.flush_data = 0;
 	} else if (!strcmp(opt, "output-format")) {
@@ -153,12 +209,46 @@ int command_handle_option(char *opt, const char **arg)
 		command_args_values.try_add = true;
 	} else if (!strcmp(opt, "update-path")) {
 		command_args_values.update_path = true;
+	} else if (!strcmp(opt, "queue-depth")) {
+		if (validate_str_num(arg[0], "queue depth", 1,
+				EXP_OBJ_QUEUE_DEPTH_MAX) == FAILURE)
+			return FAILURE;
+
+		command_args_values.queue_depth = strtoul(arg[0], NULL, 10);
+	} else if (!strcmp(opt, "hw-queues")) {
+		if (validate_str_num(arg[0], "hw queues", 1,
+				EXP_OBJ_HW_QUEUES_MAX) == FAILURE)
+			return FAILURE;
+
+		command_args_values.hw_queues = strtoul(arg[0], NULL, 10);
+	} else if (!strcmp(opt, "bdi-read-ahead")) {
+		if (validate_str_num(arg[0], "read-ahead", 1,
+				KCAS_EXP_OBJ_IO_HINT_KB_MAX) == FAILURE)
+			return FAILURE;
+
+		command_args_values.read_ahead_kb = strtoul(arg[0], NULL, 10);
+	} else if (!strcmp(opt, "io-opt")) {
+		if (validate_str_num(arg[0], "optimal I/O size", 1,
+				KCAS_EXP_OBJ_IO_HINT_KB_MAX) == FAILURE)
+			return FAILURE;
+
+		command_args_values.io_opt_kb = strtoul(arg[0], NULL, 10);
+	} else if (!strcmp(opt, "rate-limit")) {
+		if (validate_str_num(arg[0], "rate limit", 1,
+				FLUSH_RATE_LIMIT_MAX) == FAILURE)
+			return FAILURE;
+
+		command_args_values.flush_rate_limit = strtoul(arg[0], NULL, 10);
 	} else if (!strcmp(opt, "detach")) {
 		command_args_values.detach = true;
 	} else if (!strcmp(opt, "no-flush")) {
 		command_args_values.no_flush = true;
+	} else if (!strcmp(opt, "background")) {
+		command_args_values.purge_background = true;
 	} else if (!strcmp(opt, "by-id-path")) {
 		command_args_values.by_id_path = true;
+	} else if (!strcmp(opt, "async")) {
+		command_args_values.async = true;
 	} else {
 		return FAILURE;
 	}
@@ -320,6 +410,12 @@ int dump_inflight_command_handle_option(char *opt, const char **arg)
 			return FAILURE;
 
 		command_args_values.cache_id = strtoul(arg[0], NULL, 10);
+	} else if (!strcmp(opt, "output-format")) {
+		command_args_values.output_format = validate_str_output_format(arg[0]);
+		if (OUTPUT_FORMAT_INVALID == command_args_values.output_format)
+			return FAILURE;
+	} else if (!strcmp(opt, "kernel-log")) {
+		command_args_values.kernel_log = true;
 	}
 
 	return 0;
@@ -342,13 +438,20 @@ int dump_inflight_command_handle_option(char *opt, const char **arg)
 
 #define CACHE_DEVICE_DESC "Caching device to be used"
 #define CORE_DEVICE_DESC "Path to core device"
+#define CORE_DEVICES_DESC "Path to core device, or comma separated list of " \
+	"core devices to be added at once"
+#define QUEUE_DEPTH_DESC "Queue depth of exported object <1-"xstr(EXP_OBJ_QUEUE_DEPTH_MAX)"> (default: inherited from core device)"
+#define FLUSH_RATE_LIMIT_DESC "Limit writeback to each core device to <1-"xstr(FLUSH_RATE_LIMIT_MAX)"> MiB/s, yielding to user I/O (default: unlimited)"
+#define HW_QUEUES_DESC "Number of exported object hardware queues <1-"xstr(EXP_OBJ_HW_QUEUES_MAX)"> (default: inherited from core and cache devices)"
+#define BDI_READ_AHEAD_DESC "Page cache read-ahead of exported object in KiB <1-"xstr(KCAS_EXP_OBJ_IO_HINT_KB_MAX)"> (default: twice optimal I/O size, within sequential cutoff threshold)"
+#define IO_OPT_DESC "Optimal I/O size of exported object in KiB, rounded up to cache line size <1-"xstr(KCAS_EXP_OBJ_IO_HINT_KB_MAX)"> (default: inherited from core device)"
 #define CACHE_LINE_SIZE_DESC "Set cache line size in kibibytes: {4,8,16,32,64}[KiB] (default: %d)"
 
 
 static cli_option start_options[] = {
 	{'d', "cache-device", CACHE_DEVICE_DESC, 1, "DEVICE", CLI_OPTION_REQUIRED},
 	{'i', "cache-id", CACHE_ID_DESC_LONG, 1, "ID", 0},
-	{'l', "load", "Load cache metadata from caching device (DANGEROUS - see manual or Admin Guide for details)"},
+	{'l', "load", "Load cache metadata from caching device (DANGEROUS - see manual or Admin Guide for details). Not valid for compressed cache device"},
 	{'f', "force", "Force the creation of cache instance"},
 	{'c', "cache-mode", "Set cache mode from available: {"CAS_CLI_HELP_START_CACHE_MODES"} "CAS_CLI_HELP_START_CACHE_MODES_FULL"; without this parameter Write-Through will be set by default", 1, "NAME"},
 	{'x', "cache-line-size", CACHE_LINE_SIZE_DESC, 1, "NUMBER",  CLI_OPTION_DEFAULT_INT, 0, 0, ocf_cache_line_size_default / KiB},
@@ -389,11 +492,13 @@ static int check_fs(const char* device, bool force)
 	return SUCCESS;
 }
 
-int validate_cache_path(const char* path, bool force)
+static int _validate_cache_member_path(const char* path, bool force)
 {
 	int cache_device;
 	struct stat device_info;
 
+	/* Null or RAM-backed volume is validated by its underlying device */
+	path += volume_path_prefix_len(path);
 
 	cache_device = open(path, O_RDONLY);
 
@@ -429,6 +534,28 @@ int validate_cache_path(const char* path, bool force)
 	return SUCCESS;
 }
 
+/* Each member of striped or mirrored cache device is validated separately */
+int validate_cache_path(const char* path, bool force)
+{
+	char *paths, *member, *savep;
+	int result = SUCCESS;
+
+	paths = strdup(path);
+	if (!paths)
+		return FAILURE;
+
+	for (member = strtok_r(paths, ",+", &savep); member;
+			member = strtok_r(NULL, ",+", &savep)) {
+		result = _validate_cache_member_path(member, force);
+		if (result != SUCCESS)
+			break;
+	}
+
+	free(paths);
+
+	return result;
+}
+
 static cli_option attach_cache_options[] = {
 	{'d', "cache-device", CACHE_DEVICE_DESC, 1, "DEVICE", CLI_OPTION_REQUIRED},
 	{'i', "cache-id", CACHE_ID_DESC_LONG, 1, "ID", CLI_OPTION_REQUIRED},
@@ -504,9 +631,10 @@ static cli_option stats_options[] = {
 	{'i', "cache-id", CACHE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
 	{'j', "core-id", "Limit display of core-specific statistics to only ones pertaining to a specific core. If this option is not given, casadm will display statistics pertaining to all cores assigned to given cache instance.", 1, "ID", 0},
 	{'d', "io-class-id", "Display per IO class statistics", 1, "ID", CLI_OPTION_OPTIONAL_ARG},
-	{'f', "filter", "Apply filters from the following set: {all, conf, usage, req, blk, err}", 1, "FILTER-SPEC"},
+	{'f', "filter", "Apply filters from the following set: {all, conf, usage, req, blk, err, lat, queue, mem, heatmap, mrc, internal}", 1, "FILTER-SPEC"},
 	{'o', "output-format", "Output format: {table|csv}", 1, "FORMAT"},
 	{'b', "by-id-path", "Display by-id path to disks instead of short form /dev/sdx"},
+	{'w', "watch", "Print per interval rates of cache and core statistics every INTERVAL seconds until interrupted", 1, "INTERVAL"},
 	{0}
 };
 
@@ -549,6 +677,12 @@ int stats_command_handle_option(char *opt, const char **arg)
 		command_args_values.by_id_path = true;
 		if (command_args_values.by_id_path == false)
 			return FAILURE;
+	} else if (!strcmp(opt, "watch")) {
+		if (validate_str_num(arg[0], "watch interval", 1,
+				     WATCH_INTERVAL_MAX) == FAILURE)
+			return FAILURE;
+
+		command_args_values.watch_interval = strtoul(arg[0], NULL, 10);
 	} else {
 		return FAILURE;
 	}
@@ -558,6 +692,19 @@ int stats_command_handle_option(char *opt, const char **arg)
 
 int handle_stats()
 {
+	if (command_args_values.watch_interval) {
+		if (command_args_values.stats_filters & STATS_FILTER_IOCLASS) {
+			cas_printf(LOG_ERR, "Option '--watch' cannot be used "
+					"with '--io-class-id'\n");
+			return FAILURE;
+		}
+
+		return cache_status_watch(command_args_values.cache_id,
+					  command_args_values.core_id,
+					  command_args_values.watch_interval,
+					  command_args_values.output_format);
+	}
+
 	return cache_status(command_args_values.cache_id,
 			    command_args_values.core_id,
 			    command_args_values.io_class_id,
@@ -566,9 +713,441 @@ int handle_stats()
 			    command_args_values.by_id_path);
 }
 
+struct {
+	const char *path;
+	uint32_t interval;
+} static export_params = {
+	.path = NULL,
+	.interval = 0,
+};
+
+static cli_option export_metrics_options[] = {
+	{'f', "file", "Atomically replace FILE with metrics instead of printing them (e.g. for node_exporter textfile collector)", 1, "FILE", 0},
+	{'t', "interval", "Refresh metrics every INTERVAL seconds until interrupted", 1, "INTERVAL", 0},
+	{0}
+};
+
+int export_metrics_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "file")) {
+		if (strnlen(arg[0], MAX_STR_LEN) >= MAX_STR_LEN - 4) {
+			cas_printf(LOG_ERR, "Path too long\n");
+			return FAILURE;
+		}
+		export_params.path = arg[0];
+	} else if (!strcmp(opt, "interval")) {
+		if (validate_str_num(arg[0], "interval", 1,
+				     WATCH_INTERVAL_MAX) == FAILURE)
+			return FAILURE;
+
+		export_params.interval = strtoul(arg[0], NULL, 10);
+	} else {
+		return FAILURE;
+	}
+
+	return 0;
+}
+
+int handle_export_metrics()
+{
+	return cache_stats_export(export_params.path, export_params.interval);
+}
+
+#define PREFETCH_RATE_LIMIT_DEFAULT 100
+#define PREFETCH_RATE_LIMIT_DESC "Limit prefetch of cache to <0-"xstr(FLUSH_RATE_LIMIT_MAX)"> MiB/s, 0 for unlimited (default: "xstr(PREFETCH_RATE_LIMIT_DEFAULT)")"
+
+struct {
+	const char *path;
+	uint32_t rate_limit;
+} static hot_set_params = {
+	.path = NULL,
+	.rate_limit = PREFETCH_RATE_LIMIT_DEFAULT,
+};
+
+static cli_option save_hot_set_options[] = {
+	{'i', "cache-id", CACHE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
+	{'j', "core-id", CORE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
+	{'f', "file", "Atomically replace FILE with hot set of core", 1, "FILE", CLI_OPTION_REQUIRED},
+	{0}
+};
+
+static cli_option load_hot_set_options[] = {
+	{'i', "cache-id", CACHE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
+	{'j', "core-id", CORE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
+	{'f', "file", "File with hot set of core saved by --save-hot-set", 1, "FILE", CLI_OPTION_REQUIRED},
+	{'r', "rate-limit", PREFETCH_RATE_LIMIT_DESC, 1, "MiB/s", 0},
+	{0}
+};
+
+int hot_set_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "file")) {
+		if (strnlen(arg[0], MAX_STR_LEN) >= MAX_STR_LEN - 4) {
+			cas_printf(LOG_ERR, "Path too long\n");
+			return FAILURE;
+		}
+		hot_set_params.path = arg[0];
+	} else if (!strcmp(opt, "rate-limit")) {
+		if (validate_str_num(arg[0], "rate limit", 0,
+				     FLUSH_RATE_LIMIT_MAX) == FAILURE)
+			return FAILURE;
+
+		hot_set_params.rate_limit = strtoul(arg[0], NULL, 10);
+	} else {
+		return command_handle_option(opt, arg);
+	}
+
+	return SUCCESS;
+}
+
+struct {
+	struct kcas_prefetch_range *ranges;
+	uint32_t count;
+	const char *path;
+	uint32_t io_class;
+	uint32_t rate_limit;
+	bool wait;
+} static prefetch_params = {
+	.ranges = NULL,
+	.count = 0,
+	.path = NULL,
+	.io_class = 0,
+	.rate_limit = PREFETCH_RATE_LIMIT_DEFAULT,
+	.wait = false,
+};
+
+static cli_option prefetch_options[] = {
+	{'i', "cache-id", CACHE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
+	{'j', "core-id", CORE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
+	{'b', "ranges", "Comma separated ranges of core in 512 B sectors", 1, "START:LENGTH[,...]", 0},
+	{'p', "path", "File on exported object of core (or on its partition) to prefetch extents of", 1, "FILE", 0},
+	{'c', "io-class", "IO class which prefetched data is inserted into (default: 0)", 1, "ID", 0},
+	{'r', "rate-limit", PREFETCH_RATE_LIMIT_DESC, 1, "MiB/s", 0},
+	{'w', "wait", "Wait for all prefetch of cache to finish, printing progress"},
+	{0}
+};
+
+int prefetch_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "ranges")) {
+		if (prefetch_parse_ranges(arg[0], &prefetch_params.ranges,
+				&prefetch_params.count))
+			return FAILURE;
+	} else if (!strcmp(opt, "path")) {
+		if (validate_path(arg[0], 1))
+			return FAILURE;
+		prefetch_params.path = arg[0];
+	} else if (!strcmp(opt, "io-class")) {
+		if (validate_str_num(arg[0], "IO class id", 0,
+				     OCF_IO_CLASS_ID_MAX) == FAILURE)
+			return FAILURE;
+
+		prefetch_params.io_class = strtoul(arg[0], NULL, 10);
+	} else if (!strcmp(opt, "rate-limit")) {
+		if (validate_str_num(arg[0], "rate limit", 0,
+				     FLUSH_RATE_LIMIT_MAX) == FAILURE)
+			return FAILURE;
+
+		prefetch_params.rate_limit = strtoul(arg[0], NULL, 10);
+	} else if (!strcmp(opt, "wait")) {
+		prefetch_params.wait = true;
+	} else {
+		return command_handle_option(opt, arg);
+	}
+
+	return SUCCESS;
+}
+
+int handle_prefetch()
+{
+	int ret;
+
+	if (!prefetch_params.ranges == !prefetch_params.path) {
+		cas_printf(LOG_ERR, "Exactly one of --ranges and --path "
+				"options is required\n");
+		return FAILURE;
+	}
+
+	ret = prefetch(command_args_values.cache_id,
+			command_args_values.core_id, prefetch_params.ranges,
+			prefetch_params.count, prefetch_params.path,
+			prefetch_params.io_class, prefetch_params.rate_limit,
+			prefetch_params.wait);
+
+	free(prefetch_params.ranges);
+	return ret;
+}
+
+int handle_save_hot_set()
+{
+	return hot_set_save(command_args_values.cache_id,
+			command_args_values.core_id, hot_set_params.path);
+}
+
+int handle_load_hot_set()
+{
+	return hot_set_load(command_args_values.cache_id,
+			command_args_values.core_id, hot_set_params.path,
+			hot_set_params.rate_limit);
+}
+
+#define TRACE_DURATION_DEFAULT 60
+#define TRACE_DURATION_MAX (24 * 60 * 60)
+
+struct {
+	const char *path;
+	uint32_t duration;
+} static trace_params = {
+	.path = NULL,
+	.duration = TRACE_DURATION_DEFAULT,
+};
+
+static cli_option capture_trace_options[] = {
+	{'i', "cache-id", CACHE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
+	{'j', "core-id", CORE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
+	{'f', "file", "Replace FILE with binary trace of requests of core", 1, "FILE", CLI_OPTION_REQUIRED},
+	{'d', "duration", "Capture time in seconds, stopped earlier with SIGINT (default: "xstr(TRACE_DURATION_DEFAULT)")", 1, "SECONDS", 0},
+	{0}
+};
+
+int trace_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "file")) {
+		if (validate_path(arg[0], 0))
+			return FAILURE;
+
+		trace_params.path = arg[0];
+	} else if (!strcmp(opt, "duration")) {
+		if (validate_str_num(arg[0], "duration", 1,
+				     TRACE_DURATION_MAX) == FAILURE)
+			return FAILURE;
+
+		trace_params.duration = strtoul(arg[0], NULL, 10);
+	} else {
+		return command_handle_option(opt, arg);
+	}
+
+	return SUCCESS;
+}
+
+int handle_capture_trace()
+{
+	return io_trace_capture(command_args_values.cache_id,
+			command_args_values.core_id, trace_params.path,
+			trace_params.duration);
+}
+
+#define BENCH_THREADS_DEFAULT 1
+#define BENCH_QUEUE_DEPTH_DEFAULT 32
+#define BENCH_IO_SIZE_DEFAULT 4096
+#define BENCH_READ_PERCENT_DEFAULT 100
+#define BENCH_DURATION_DEFAULT 10
+
+static struct kcas_bench bench_params = {
+	.threads = BENCH_THREADS_DEFAULT,
+	.queue_depth = BENCH_QUEUE_DEPTH_DEFAULT,
+	.io_size = BENCH_IO_SIZE_DEFAULT,
+	.read_percent = BENCH_READ_PERCENT_DEFAULT,
+	.duration = BENCH_DURATION_DEFAULT,
+};
+
+static cli_option bench_options[] = {
+	{'i', "cache-id", CACHE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
+	{'j', "core-id", CORE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
+	{'t', "threads", "Number of kernel threads submitting I/O, each on its own CPU (default: "xstr(BENCH_THREADS_DEFAULT)")", 1, "NUMBER", 0},
+	{'q', "queue-depth", "Requests in flight per thread (default: "xstr(BENCH_QUEUE_DEPTH_DEFAULT)")", 1, "NUMBER", 0},
+	{'s', "io-size", "Size of each request in bytes, multiple of 512 (default: "xstr(BENCH_IO_SIZE_DEFAULT)")", 1, "BYTES", 0},
+	{'r', "read-percent", "Percent of requests being reads, writes overwrite data of core (default: "xstr(BENCH_READ_PERCENT_DEFAULT)")", 1, "PERCENT", 0},
+	{'b', "range", "Size of range of core accessed from its start (default: whole core)", 1, "MiB", 0},
+	{'p', "hot-percent", "Percent of range being hot (default: 0, uniform access)", 1, "PERCENT", 0},
+	{'H', "hot-io-percent", "Percent of requests going to hot part of range", 1, "PERCENT", 0},
+	{'d', "duration", "Duration of benchmark in seconds (default: "xstr(BENCH_DURATION_DEFAULT)")", 1, "SECONDS", 0},
+	{'o', "output-format", "Output format: {table|csv}", 1, "FORMAT", 0},
+	{0}
+};
+
+int bench_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "threads")) {
+		if (validate_str_num(arg[0], "number of threads", 1,
+				     KCAS_BENCH_THREADS_MAX) == FAILURE)
+			return FAILURE;
+
+		bench_params.threads = strtoul(arg[0], NULL, 10);
+	} else if (!strcmp(opt, "queue-depth")) {
+		if (validate_str_num(arg[0], "queue depth", 1,
+				     KCAS_BENCH_QUEUE_DEPTH_MAX) == FAILURE)
+			return FAILURE;
+
+		bench_params.queue_depth = strtoul(arg[0], NULL, 10);
+	} else if (!strcmp(opt, "io-size")) {
+		if (validate_str_num(arg[0], "I/O size", 512,
+				     KCAS_BENCH_IO_SIZE_MAX) == FAILURE)
+			return FAILURE;
+
+		bench_params.io_size = strtoul(arg[0], NULL, 10);
+		if (bench_params.io_size % 512) {
+			cas_printf(LOG_ERR, "I/O size has to be multiple of "
+					"512 bytes\n");
+			return FAILURE;
+		}
+	} else if (!strcmp(opt, "read-percent")) {
+		if (validate_str_num(arg[0], "read percent", 0,
+				     100) == FAILURE)
+			return FAILURE;
+
+		bench_params.read_percent = strtoul(arg[0], NULL, 10);
+	} else if (!strcmp(opt, "range")) {
+		if (validate_str_num(arg[0], "range", 1,
+				     UINT32_MAX) == FAILURE)
+			return FAILURE;
+
+		bench_params.range = strtoull(arg[0], NULL, 10) *
+				(MiB / 512);
+	} else if (!strcmp(opt, "hot-percent")) {
+		if (validate_str_num(arg[0], "hot percent", 0,
+				     100) == FAILURE)
+			return FAILURE;
+
+		bench_params.hot_percent = strtoul(arg[0], NULL, 10);
+	} else if (!strcmp(opt, "hot-io-percent")) {
+		if (validate_str_num(arg[0], "hot I/O percent", 0,
+				     100) == FAILURE)
+			return FAILURE;
+
+		bench_params.hot_io_percent = strtoul(arg[0], NULL, 10);
+	} else if (!strcmp(opt, "duration")) {
+		if (validate_str_num(arg[0], "duration", 1,
+				     KCAS_BENCH_DURATION_MAX) == FAILURE)
+			return FAILURE;
+
+		bench_params.duration = strtoul(arg[0], NULL, 10);
+	} else {
+		return command_handle_option(opt, arg);
+	}
+
+	return SUCCESS;
+}
+
+int handle_bench()
+{
+	if (bench_params.hot_percent && !bench_params.hot_io_percent) {
+		cas_printf(LOG_ERR, "Option --hot-io-percent is required "
+				"with --hot-percent\n");
+		return FAILURE;
+	}
+
+	bench_params.cache_id = command_args_values.cache_id;
+	bench_params.core_id = command_args_values.core_id;
+
+	return cache_bench(&bench_params, command_args_values.output_format);
+}
+
+#define ALLOC_BENCH_DEPTH_DEFAULT 256
+#define ALLOC_BENCH_REMOTE_PERCENT_DEFAULT 25
+#define ALLOC_BENCH_MAX_SEGMENTS_DEFAULT 128
+#define ALLOC_BENCH_DURATION_DEFAULT 10
+
+static struct kcas_alloc_bench alloc_bench_params = {
+	.pool = KCAS_ALLOC_BENCH_MPOOL,
+	.depth = ALLOC_BENCH_DEPTH_DEFAULT,
+	.remote_percent = ALLOC_BENCH_REMOTE_PERCENT_DEFAULT,
+	.max_order = KCAS_ALLOC_BENCH_MAX_ORDER,
+	.duration = ALLOC_BENCH_DURATION_DEFAULT,
+};
+
+static cli_option alloc_bench_options[] = {
+	{'p', "pool", "Pool to be exercised: {mpool|mpool-mag|allocator} (default: mpool)", 1, "NAME", 0},
+	{'t', "threads", "Number of kernel threads, each on its own CPU (default: one per online CPU)", 1, "NUMBER", 0},
+	{'n', "objects", "Objects held by each thread (default: "xstr(ALLOC_BENCH_DEPTH_DEFAULT)")", 1, "NUMBER", 0},
+	{'r', "remote-percent", "Percent of objects freed by thread of another CPU (default: "xstr(ALLOC_BENCH_REMOTE_PERCENT_DEFAULT)")", 1, "PERCENT", 0},
+	{'s', "max-segments", "Segments of largest memory pool allocation, power of two (default: "xstr(ALLOC_BENCH_MAX_SEGMENTS_DEFAULT)")", 1, "NUMBER", 0},
+	{'d', "duration", "Duration of benchmark in seconds (default: "xstr(ALLOC_BENCH_DURATION_DEFAULT)")", 1, "SECONDS", 0},
+	{'o', "output-format", "Output format: {table|csv}", 1, "FORMAT", 0},
+	{0}
+};
+
+int alloc_bench_handle_option(char *opt, const char **arg)
+{
+	uint32_t segments;
+	int pool;
+
+	if (!strcmp(opt, "pool")) {
+		pool = alloc_bench_pool_from_name(arg[0]);
+		if (pool < 0) {
+			cas_printf(LOG_ERR, "Invalid pool name\n");
+			return FAILURE;
+		}
+
+		alloc_bench_params.pool = pool;
+	} else if (!strcmp(opt, "threads")) {
+		if (validate_str_num(arg[0], "number of threads", 1,
+				     KCAS_BENCH_THREADS_MAX) == FAILURE)
+			return FAILURE;
+
+		alloc_bench_params.threads = strtoul(arg[0], NULL, 10);
+	} else if (!strcmp(opt, "objects")) {
+		if (validate_str_num(arg[0], "number of objects", 1,
+				     KCAS_ALLOC_BENCH_DEPTH_MAX) == FAILURE)
+			return FAILURE;
+
+		alloc_bench_params.depth = strtoul(arg[0], NULL, 10);
+	} else if (!strcmp(opt, "remote-percent")) {
+		if (validate_str_num(arg[0], "remote percent", 0,
+				     100) == FAILURE)
+			return FAILURE;
+
+		alloc_bench_params.remote_percent = strtoul(arg[0], NULL, 10);
+	} else if (!strcmp(opt, "max-segments")) {
+		if (validate_str_num(arg[0], "max segments", 1,
+				     1 << KCAS_ALLOC_BENCH_MAX_ORDER) == FAILURE)
+			return FAILURE;
+
+		segments = strtoul(arg[0], NULL, 10);
+		if (segments & (segments - 1)) {
+			cas_printf(LOG_ERR, "Max segments has to be power "
+					"of two\n");
+			return FAILURE;
+		}
+
+		alloc_bench_params.max_order = __builtin_ctz(segments);
+	} else if (!strcmp(opt, "duration")) {
+		if (validate_str_num(arg[0], "duration", 1,
+				     KCAS_BENCH_DURATION_MAX) == FAILURE)
+			return FAILURE;
+
+		alloc_bench_params.duration = strtoul(arg[0], NULL, 10);
+	} else {
+		return command_handle_option(opt, arg);
+	}
+
+	return SUCCESS;
+}
+
+int handle_alloc_bench()
+{
+	long cpus;
+
+	if (!alloc_bench_params.threads) {
+		cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		if (cpus < 1)
+			cpus = 1;
+		else if (cpus > KCAS_BENCH_THREADS_MAX)
+			cpus = KCAS_BENCH_THREADS_MAX;
+
+		alloc_bench_params.threads = cpus;
+	}
+
+	return alloc_bench(&alloc_bench_params,
+			command_args_values.output_format);
+}
+
+#define ASYNC_DESC "Run in background and print id of operation instead of waiting for it to complete"
+
 static cli_option stop_options[] = {
 	{'i', "cache-id", CACHE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
 	{'n', "no-data-flush", "Do not flush dirty data (may be dangerous)"},
+	{'a', "async", ASYNC_DESC},
 	{0}
 };
 
@@ -579,18 +1158,67 @@ static cli_option detach_options[] = {
 
 int handle_stop()
 {
+	if (command_args_values.async)
+		return async_op_start(KCAS_ASYNC_OP_STOP_CACHE,
+				command_args_values.cache_id,
+				OCF_CORE_ID_INVALID,
+				command_args_values.flush_data, 0);
+
 	return stop_cache(command_args_values.cache_id,
 			command_args_values.flush_data);
 }
 
+struct {
+	uint64_t op_id;
+	bool wait;
+} static op_status_params = {
+	.op_id = 0,
+	.wait = false,
+};
+
+static cli_option op_status_options[] = {
+	{'o', "op-id", "Identifier of operation printed when it was started", 1, "ID", CLI_OPTION_REQUIRED},
+	{'w', "wait", "Wait for operation to complete"},
+	{0}
+};
+
+int op_status_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "op-id")) {
+		if (validate_str_num(arg[0], "operation id", 1,
+				LLONG_MAX) == FAILURE)
+			return FAILURE;
+
+		op_status_params.op_id = strtoull(arg[0], NULL, 10);
+	} else if (!strcmp(opt, "wait")) {
+		op_status_params.wait = true;
+	} else {
+		return FAILURE;
+	}
+
+	return 0;
+}
+
+int handle_op_status()
+{
+	return async_op_status(op_status_params.op_id,
+			op_status_params.wait);
+}
+
 static cli_option dump_options[] = {
 	{'i', "cache-id", CACHE_ID_DESC_LONG, 1, "ID", 0},
+	{'o', "output-format", "Output format: {table|csv}", 1, "FORMAT"},
+	{'l', "kernel-log", "Dump inflight requests of OCF engine to kernel log instead"},
 	{0}
 };
 
 int handle_dump_inflight()
 {
-	return dump_inflight_of_cache(command_args_values.cache_id);
+	if (command_args_values.kernel_log)
+		return dump_inflight_of_cache(command_args_values.cache_id);
+
+	return cache_inflight_dump(command_args_values.cache_id,
+			command_args_values.output_format);
 }
 
 /*****************************************************************************
@@ -728,7 +1356,53 @@ static struct cas_param cas_core_params[] = {
 	[core_param_seq_cutoff_promotion_count] = {
 		.name = "Sequential cutoff promotion request count threshold",
 	},
-	{0},
+
+	/* Core device inflight limits */
+	[core_param_inflight_limit_foreground] = {
+		.name = "Foreground inflight limit",
+	},
+	[core_param_inflight_limit_background] = {
+		.name = "Background inflight limit",
+	},
+
+	/* Read-ahead params */
+	[core_param_read_ahead_lines] = {
+		.name = "Read-ahead window [cache lines]",
+	},
+
+	/* Dirty data write throttling params */
+	[core_param_dirty_throttle_limit] = {
+		.name = "Dirty data limit [%]",
+	},
+	[core_param_dirty_throttle_max_pause] = {
+		.name = "Max write pause [ms]",
+	},
+
+	/* Writeback sweep params */
+	[core_param_writeback_sweep_window] = {
+		.name = "Cleaning writes gathering window [us]",
+	},
+
+	/* QoS params */
+	[core_param_qos_read_iops] = {
+		.name = "Read IOPS limit",
+	},
+	[core_param_qos_write_iops] = {
+		.name = "Write IOPS limit",
+	},
+	[core_param_qos_read_bandwidth] = {
+		.name = "Read bandwidth limit [MiB/s]",
+	},
+	[core_param_qos_write_bandwidth] = {
+		.name = "Write bandwidth limit [MiB/s]",
+	},
+	[core_param_get_qos_read_throttled] = {
+		.name = "Reads throttled time [ms]",
+	},
+	[core_param_get_qos_write_throttled] = {
+		.name = "Writes throttled time [ms]",
+	},
+	{0},
 };
 
 static char *cleaner_policy_control_values[] = {
@@ -747,6 +1421,50 @@ static char *cleaning_policy_type_values[] = {
 static char *promotion_policy_type_values[] = {
 	[ocf_promotion_always] = "always",
 	[ocf_promotion_nhit] = "nhit",
+	[KCAS_PROMOTION_TINYLFU] = "tinylfu",
+	NULL,
+};
+
+static char *promotion_nhit_adaptive_values[] = {
+	[0] = "off",
+	[1] = "on",
+	NULL,
+};
+
+static char *compress_enabled_values[] = {
+	[0] = "off",
+	[1] = "on",
+	NULL,
+};
+
+static char *dedup_enabled_values[] = {
+	[0] = "off",
+	[1] = "on",
+	NULL,
+};
+
+static char *checksum_enabled_values[] = {
+	[0] = "off",
+	[1] = "on",
+	NULL,
+};
+
+static char *slow_bypass_active_values[] = {
+	[0] = "No",
+	[1] = "Yes",
+	NULL,
+};
+
+static char *seq_absorb_active_values[] = {
+	[0] = "No",
+	[1] = "Yes",
+	NULL,
+};
+
+static char *mirror_member_state_values[] = {
+	[KCAS_MIRROR_MEMBER_ACTIVE] = "Active",
+	[KCAS_MIRROR_MEMBER_FAILED] = "Failed",
+	[KCAS_MIRROR_MEMBER_REBUILDING] = "Rebuilding",
 	NULL,
 };
 
@@ -820,6 +1538,106 @@ static struct cas_param cas_cache_params[] = {
 	[cache_param_promotion_nhit_trigger_threshold] = {
 		.name = "Policy trigger [%]",
 	},
+	[cache_param_promotion_nhit_adaptive] = {
+		.name = "Adaptive insertion threshold",
+		.value_names = promotion_nhit_adaptive_values,
+	},
+
+	/* Queue thread polling */
+	[cache_param_queue_poll_time] = {
+		.name = "Poll time [us]",
+	},
+
+	/* Cleaner workers */
+	[cache_param_cleaner_workers] = {
+		.name = "Cleaner workers",
+	},
+
+	/* Deferral of cleaning of rewritten lines */
+	[cache_param_cleaner_rewrite_defer] = {
+		.name = "Rewrite deferral dirty threshold [%]",
+	},
+
+	/* Adaptive io class priorities */
+	[cache_param_io_class_adaptive_prio] = {
+		.name = "Max priority shift",
+	},
+
+	/* Background trim of cache device */
+	[cache_param_cache_trim_rate] = {
+		.name = "Trim rate [MiB/s]",
+	},
+
+	/* In-memory tier in front of cache */
+	[cache_param_dram_tier_size] = {
+		.name = "Size [MiB]",
+	},
+
+	/* Mirrored cache device */
+	[cache_param_mirror_rebuild] = {
+		.name = "Rebuilt member",
+	},
+	[cache_param_get_mirror_member0_state] = {
+		.name = "Member 0 state",
+		.value_names = mirror_member_state_values,
+	},
+	[cache_param_get_mirror_member1_state] = {
+		.name = "Member 1 state",
+		.value_names = mirror_member_state_values,
+	},
+	[cache_param_get_mirror_rebuild_progress] = {
+		.name = "Rebuild progress [%]",
+	},
+
+	/* Compression of cache device data */
+	[cache_param_compress_enabled] = {
+		.name = "Compression",
+		.value_names = compress_enabled_values,
+	},
+	[cache_param_get_compress_ratio] = {
+		.name = "Compression ratio [%]",
+	},
+	[cache_param_get_compress_device_used] = {
+		.name = "Device space used [%]",
+	},
+
+	/* Deduplication of cache device data */
+	[cache_param_dedup_enabled] = {
+		.name = "Deduplication",
+		.value_names = dedup_enabled_values,
+	},
+
+	/* Checksums of cache device data */
+	[cache_param_checksum_enabled] = {
+		.name = "Checksums",
+		.value_names = checksum_enabled_values,
+	},
+
+	/* Bypass of slow cache device */
+	[cache_param_slow_bypass_threshold] = {
+		.name = "Latency threshold [%]",
+	},
+	[cache_param_get_slow_bypass_active] = {
+		.name = "Bypass active",
+		.value_names = slow_bypass_active_values,
+	},
+
+	/* Coalescing of metadata writes */
+	[cache_param_meta_coalesce_window] = {
+		.name = "Coalescing window [us]",
+	},
+
+	/* Absorbing sequential writes */
+	[cache_param_seq_absorb_free] = {
+		.name = "Free space threshold [%]",
+	},
+	[cache_param_seq_absorb_headroom] = {
+		.name = "Dirty headroom threshold [%]",
+	},
+	[cache_param_get_seq_absorb_active] = {
+		.name = "Absorbing active",
+		.value_names = seq_absorb_active_values,
+	},
 	{0},
 };
 
@@ -832,8 +1650,76 @@ static struct cas_param cas_cache_params[] = {
 	"Available policies: {always|full|never}"
 #define SEQ_CUT_OFF_PROMO_COUNT_DESC "Sequential cutoff stream promotion request count threshold"
 
+#define INFLIGHT_LIMIT_FOREGROUND_DESC "Max number of requests in flight to core device " \
+	"serving user I/O, 0 - unlimited <%d-%d> (default: %d)"
+#define INFLIGHT_LIMIT_BACKGROUND_DESC "Max number of requests in flight to core device " \
+	"issued by cleaning, 0 - unlimited <%d-%d> (default: %d)"
+
+#define READ_AHEAD_IO_CLASS_DESC "IO class which read-ahead parameters apply to"
+#define READ_AHEAD_LINES_DESC "Number of cache lines read ahead of sequential " \
+	"streams, 0 - read-ahead disabled <%d-%d> (default: %d)"
+
+#define DIRTY_THROTTLE_LIMIT_DESC "Dirty data of core in percent of cache " \
+	"writes are throttled towards, 0 - throttling disabled <%d-%d>[%%] (default: %d %%)"
+#define DIRTY_THROTTLE_MAX_PAUSE_DESC "Max pause of single write at dirty " \
+	"data limit <%d-%d>[ms] (default: %d ms)"
+
+#define WRITEBACK_SWEEP_WINDOW_DESC "Time cleaning writes to core are gathered " \
+	"for to be sent in ascending order, 0 - sent as they come <%d-%d>[us] (default: %d us)"
+
+#define QOS_IO_CLASS_DESC "IO class which QoS limits apply to (default: whole core)"
+#define QOS_READ_IOPS_DESC "Max reads per second, 0 - unlimited <%d-%d> (default: %d)"
+#define QOS_WRITE_IOPS_DESC "Max writes per second, 0 - unlimited <%d-%d> (default: %d)"
+#define QOS_READ_BANDWIDTH_DESC "Max bandwidth of reads, 0 - unlimited " \
+	"<%d-%d>[MiB/s] (default: %d)"
+#define QOS_WRITE_BANDWIDTH_DESC "Max bandwidth of writes, 0 - unlimited " \
+	"<%d-%d>[MiB/s] (default: %d)"
+
 #define CLEANER_CONTROL_DESC "Cleaner control. " \
 	"Available policies: {on|off}"
+#define CLEANER_WORKERS_DESC "Number of queues cleaning passes are spread over " \
+	"<%d-%d> (default: %d)"
+#define CLEANER_REWRITE_DEFER_DESC "Dirty ratio below which cleaning is deferred " \
+	"while writes mostly rewrite recently written lines, 0 - never deferred " \
+	"<%d-%d>[%%] (default: %d %%)"
+
+#define IO_CLASS_ADAPT_BOUND_DESC "Max shift of io class eviction priorities " \
+	"adapted to reuse of classes, 0 - configured priorities are kept " \
+	"<%d-%d> (default: %d)"
+
+#define CACHE_TRIM_RATE_DESC "Rate of background discard of unused cache " \
+	"data area, 0 - not discarded <%d-%d>[MiB/s] (default: %d)"
+
+#define DRAM_TIER_SIZE_DESC "Size of in-memory tier holding hot read data " \
+	"in front of cache, 0 - not used <%d-%d>[MiB] (default: %d)"
+
+#define MIRROR_REBUILD_DESC "Member of mirrored cache device to be rebuilt " \
+	"from the other one <%d-%d>"
+
+#define COMPRESS_IO_CLASS_DESC "IO class which compression setting " \
+	"applies to (default: all data)"
+#define COMPRESS_ENABLED_DESC "Compress data written to cache device " \
+	"{on|off} (default: on)"
+
+#define DEDUP_ENABLED_DESC "Share cache device space among identical " \
+	"blocks cache lines are filled clean with {on|off} (default: off)"
+
+#define CHECKSUM_ENABLED_DESC "Checksum blocks written to cache device " \
+	"and verify blocks read from it {on|off} (default: off)"
+
+#define SLOW_BYPASS_THRESHOLD_DESC "Read latency of cache device relative " \
+	"to core above which clean reads bypass cache, 0 - never bypassed " \
+	"<%d-%d>[%%] (default: %d)"
+
+#define SEQ_ABSORB_FREE_DESC "Free space of cache above which sequential " \
+	"writes are absorbed, 0 - never absorbed <%d-%d>[%%] (default: %d)"
+
+#define SEQ_ABSORB_HEADROOM_DESC "Space of cache not taken by dirty data " \
+	"above which sequential writes are absorbed <%d-%d>[%%] (default: %d)"
+
+#define META_COALESCE_WINDOW_DESC "Time metadata writes are buffered for " \
+	"before being written back together, 0 - written as they come " \
+	"<%d-%d>[us] (default: %d)"
 
 #define CLEANING_POLICY_TYPE_DESC "Cleaning policy type. " \
 	"Available policy types: {nop|alru|acp}"
@@ -859,7 +1745,7 @@ static struct cas_param cas_cache_params[] = {
 	" <%d-%d> (default: %d)"
 
 #define PROMOTION_POLICY_TYPE_DESC "Promotion policy type. "\
-	"Available policy types: {always|nhit}"
+	"Available policy types: {always|nhit|tinylfu}"
 
 #define PROMOTION_NHIT_TRIGGER_DESC "Cache occupancy value over which NHIT promotion is active " \
 	"<%d-%d>[%] (default: %d%)"
@@ -867,6 +1753,12 @@ static struct cas_param cas_cache_params[] = {
 #define PROMOTION_NHIT_THRESHOLD_DESC "Number of requests for given core line " \
 	"after which NHIT policy allows insertion into cache <%d-%d> (default: %d)"
 
+#define PROMOTION_NHIT_ADAPTIVE_DESC "Adjust insertion threshold to observed " \
+	"hit ratio and cache churn {on|off} (default: off)"
+
+#define QUEUE_POLL_TIME_DESC "Max time queue threads poll for new requests " \
+	"before going to sleep, 0 - never poll <%d-%d>[us] (default: %d us)"
+
 static cli_namespace set_param_namespace = {
 	.short_name = 'n',
 	.long_name = "name",
@@ -877,8 +1769,62 @@ static cli_namespace set_param_namespace = {
 			{0, "promotion-count", SEQ_CUT_OFF_PROMO_COUNT_DESC, 1, "NUMBER", 0},
 		CORE_PARAMS_NS_END()
 
+		CORE_PARAMS_NS_BEGIN("inflight-limit", "Core device inflight limits")
+			{'f', "foreground", INFLIGHT_LIMIT_FOREGROUND_DESC, 1, "NUMBER",
+				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
+				0, INFLIGHT_LIMIT_MAX, 0},
+			{'b', "background", INFLIGHT_LIMIT_BACKGROUND_DESC, 1, "NUMBER",
+				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
+				0, INFLIGHT_LIMIT_MAX, 0},
+		CORE_PARAMS_NS_END()
+
+		CORE_PARAMS_NS_BEGIN("read-ahead", "Read-ahead of sequential streams")
+			{'d', "io-class-id", READ_AHEAD_IO_CLASS_DESC, 1, "ID",
+				CLI_OPTION_REQUIRED},
+			{'l', "lines", READ_AHEAD_LINES_DESC, 1, "NUMBER",
+				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
+				0, KCAS_READ_AHEAD_LINES_MAX, 0},
+		CORE_PARAMS_NS_END()
+
+		CORE_PARAMS_NS_BEGIN("dirty-throttle", "Write throttling by dirty data of core")
+			{'l', "limit", DIRTY_THROTTLE_LIMIT_DESC, 1, "PERCENTAGE",
+				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
+				0, 100, 0},
+			{'p', "max-pause", DIRTY_THROTTLE_MAX_PAUSE_DESC, 1, "NUMBER",
+				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
+				1, KCAS_DIRTY_THROTTLE_MAX_PAUSE_MAX, 100},
+		CORE_PARAMS_NS_END()
+
+		CORE_PARAMS_NS_BEGIN("writeback-sweep", "Sorting of cleaning writes to core")
+			{'w', "window", WRITEBACK_SWEEP_WINDOW_DESC, 1, "NUMBER",
+				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
+				0, KCAS_WRITEBACK_SWEEP_WINDOW_MAX, 0},
+		CORE_PARAMS_NS_END()
+
+		CORE_PARAMS_NS_BEGIN("qos", "IOPS and bandwidth limits")
+			{'d', "io-class-id", QOS_IO_CLASS_DESC, 1, "ID", 0},
+			{'r', "read-iops", QOS_READ_IOPS_DESC, 1, "NUMBER",
+				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
+				0, KCAS_QOS_IOPS_MAX, 0},
+			{'w', "write-iops", QOS_WRITE_IOPS_DESC, 1, "NUMBER",
+				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
+				0, KCAS_QOS_IOPS_MAX, 0},
+			{'R', "read-bandwidth", QOS_READ_BANDWIDTH_DESC, 1, "NUMBER",
+				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
+				0, KCAS_QOS_BANDWIDTH_MAX, 0},
+			{'W', "write-bandwidth", QOS_WRITE_BANDWIDTH_DESC, 1, "NUMBER",
+				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
+				0, KCAS_QOS_BANDWIDTH_MAX, 0},
+		CORE_PARAMS_NS_END()
+
 		CACHE_PARAMS_NS_BEGIN("cleaner", "Cleaner policy parameters")
 			{'p', "policy", CLEANER_CONTROL_DESC, 1, "POLICY", 0},
+			{'w', "workers", CLEANER_WORKERS_DESC, 1, "NUMBER",
+				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
+				1, CAS_CLEANER_WORKERS_MAX, CAS_CLEANER_WORKERS_DEFAULT},
+			{'r', "rewrite-defer", CLEANER_REWRITE_DEFER_DESC, 1, "PERCENTAGE",
+				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
+				0, 100, 0},
 		CACHE_PARAMS_NS_END()
 
 		CACHE_PARAMS_NS_BEGIN("cleaning", "Cleaning policy parameters")
@@ -898,6 +1844,71 @@ static cli_namespace set_param_namespace = {
 				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
 				OCF_NHIT_MIN_TRIGGER, OCF_NHIT_MAX_TRIGGER,
 				OCF_NHIT_TRIGGER_DEFAULT},
+			{'a', "adaptive", PROMOTION_NHIT_ADAPTIVE_DESC, 1, "POLICY", 0},
+		CACHE_PARAMS_NS_END()
+
+		CACHE_PARAMS_NS_BEGIN("queue-poll", "Queue thread polling parameters")
+			{'t', "poll-time", QUEUE_POLL_TIME_DESC, 1, "NUMBER",
+				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
+				0, CAS_QUEUE_POLL_TIME_MAX, 0},
+		CACHE_PARAMS_NS_END()
+
+		CACHE_PARAMS_NS_BEGIN("io-class-adapt", "Adaptive io class priorities")
+			{'b', "bound", IO_CLASS_ADAPT_BOUND_DESC, 1, "NUMBER",
+				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
+				0, OCF_IO_CLASS_PRIO_LOWEST, 0},
+		CACHE_PARAMS_NS_END()
+
+		CACHE_PARAMS_NS_BEGIN("cache-trim", "Background trim of cache device")
+			{'r', "rate", CACHE_TRIM_RATE_DESC, 1, "NUMBER",
+				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
+				0, KCAS_CACHE_TRIM_RATE_MAX, 0},
+		CACHE_PARAMS_NS_END()
+
+		CACHE_PARAMS_NS_BEGIN("dram-tier", "In-memory tier in front of cache")
+			{'s', "size", DRAM_TIER_SIZE_DESC, 1, "NUMBER",
+				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
+				0, KCAS_DRAM_TIER_SIZE_MAX, 0},
+		CACHE_PARAMS_NS_END()
+
+		CACHE_PARAMS_NS_BEGIN("mirror", "Mirrored cache device")
+			{'r', "rebuild-member", MIRROR_REBUILD_DESC, 1, "NUMBER",
+				CLI_OPTION_RANGE_INT, 0, 1},
+		CACHE_PARAMS_NS_END()
+
+		CACHE_PARAMS_NS_BEGIN("compression", "Compression of cache device data")
+			{'d', "io-class-id", COMPRESS_IO_CLASS_DESC, 1, "ID", 0},
+			{'e', "enabled", COMPRESS_ENABLED_DESC, 1, "POLICY", 0},
+		CACHE_PARAMS_NS_END()
+
+		CACHE_PARAMS_NS_BEGIN("dedup", "Deduplication of cache device data")
+			{'e', "enabled", DEDUP_ENABLED_DESC, 1, "POLICY", 0},
+		CACHE_PARAMS_NS_END()
+
+		CACHE_PARAMS_NS_BEGIN("checksum", "Checksums of cache device data")
+			{'e', "enabled", CHECKSUM_ENABLED_DESC, 1, "POLICY", 0},
+		CACHE_PARAMS_NS_END()
+
+		CACHE_PARAMS_NS_BEGIN("slow-bypass", "Bypass of slow cache device")
+			{'t', "threshold", SLOW_BYPASS_THRESHOLD_DESC, 1, "NUMBER",
+				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
+				0, KCAS_SLOW_BYPASS_THRESHOLD_MAX, 0},
+		CACHE_PARAMS_NS_END()
+
+		CACHE_PARAMS_NS_BEGIN("metadata-coalesce", "Coalescing of metadata writes")
+			{'w', "window", META_COALESCE_WINDOW_DESC, 1, "NUMBER",
+				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
+				0, KCAS_META_COALESCE_WINDOW_MAX, 0},
+		CACHE_PARAMS_NS_END()
+
+		CACHE_PARAMS_NS_BEGIN("seq-absorb", "Absorbing sequential writes")
+			{'f', "free", SEQ_ABSORB_FREE_DESC, 1, "NUMBER",
+				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
+				0, 100, 0},
+			{'d', "dirty-headroom", SEQ_ABSORB_HEADROOM_DESC, 1,
+				"NUMBER",
+				CLI_OPTION_RANGE_INT | CLI_OPTION_DEFAULT_INT,
+				0, 100, KCAS_SEQ_ABSORB_HEADROOM_DEFAULT},
 		CACHE_PARAMS_NS_END()
 
 		CACHE_PARAMS_NS_BEGIN("cleaning-alru", "Cleaning policy ALRU parameters")
@@ -987,6 +1998,143 @@ int set_param_seq_cutoff_handle_option(char *opt, const char **arg)
 	return SUCCESS;
 }
 
+int set_param_inflight_limit_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "foreground")) {
+		if (validate_str_num(arg[0], "foreground inflight limit",
+				0, INFLIGHT_LIMIT_MAX) == FAILURE)
+			return FAILURE;
+
+		SET_CORE_PARAM(core_param_inflight_limit_foreground,
+				strtoul(arg[0], NULL, 10));
+	} else if (!strcmp(opt, "background")) {
+		if (validate_str_num(arg[0], "background inflight limit",
+				0, INFLIGHT_LIMIT_MAX) == FAILURE)
+			return FAILURE;
+
+		SET_CORE_PARAM(core_param_inflight_limit_background,
+				strtoul(arg[0], NULL, 10));
+	} else {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+int set_param_dirty_throttle_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "limit")) {
+		if (validate_str_num(arg[0], "dirty data limit", 0, 100) == FAILURE)
+			return FAILURE;
+
+		SET_CORE_PARAM(core_param_dirty_throttle_limit,
+				strtoul(arg[0], NULL, 10));
+	} else if (!strcmp(opt, "max-pause")) {
+		if (validate_str_num(arg[0], "max write pause", 1,
+				KCAS_DIRTY_THROTTLE_MAX_PAUSE_MAX) == FAILURE)
+			return FAILURE;
+
+		SET_CORE_PARAM(core_param_dirty_throttle_max_pause,
+				strtoul(arg[0], NULL, 10));
+	} else {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+int set_param_writeback_sweep_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "window")) {
+		if (validate_str_num(arg[0], "gathering window", 0,
+				KCAS_WRITEBACK_SWEEP_WINDOW_MAX) == FAILURE)
+			return FAILURE;
+
+		SET_CORE_PARAM(core_param_writeback_sweep_window,
+				strtoul(arg[0], NULL, 10));
+	} else {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+static int core_param_handle_io_class(const char **arg)
+{
+	if (validate_str_num(arg[0], "IO class id", 0,
+			OCF_IO_CLASS_ID_MAX) == FAILURE)
+		return FAILURE;
+
+	command_args_values.io_class_id = atoi(arg[0]);
+
+	return SUCCESS;
+}
+
+int set_param_read_ahead_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "io-class-id")) {
+		return core_param_handle_io_class(arg);
+	} else if (!strcmp(opt, "lines")) {
+		if (validate_str_num(arg[0], "read-ahead lines",
+				0, KCAS_READ_AHEAD_LINES_MAX) == FAILURE)
+			return FAILURE;
+
+		SET_CORE_PARAM(core_param_read_ahead_lines,
+				strtoul(arg[0], NULL, 10));
+	} else {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+int set_param_qos_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "io-class-id")) {
+		return core_param_handle_io_class(arg);
+	} else if (!strcmp(opt, "read-iops")) {
+		if (validate_str_num(arg[0], "read IOPS limit", 0,
+				KCAS_QOS_IOPS_MAX) == FAILURE)
+			return FAILURE;
+
+		SET_CORE_PARAM(core_param_qos_read_iops,
+				strtoul(arg[0], NULL, 10));
+	} else if (!strcmp(opt, "write-iops")) {
+		if (validate_str_num(arg[0], "write IOPS limit", 0,
+				KCAS_QOS_IOPS_MAX) == FAILURE)
+			return FAILURE;
+
+		SET_CORE_PARAM(core_param_qos_write_iops,
+				strtoul(arg[0], NULL, 10));
+	} else if (!strcmp(opt, "read-bandwidth")) {
+		if (validate_str_num(arg[0], "read bandwidth limit", 0,
+				KCAS_QOS_BANDWIDTH_MAX) == FAILURE)
+			return FAILURE;
+
+		SET_CORE_PARAM(core_param_qos_read_bandwidth,
+				strtoul(arg[0], NULL, 10));
+	} else if (!strcmp(opt, "write-bandwidth")) {
+		if (validate_str_num(arg[0], "write bandwidth limit", 0,
+				KCAS_QOS_BANDWIDTH_MAX) == FAILURE)
+			return FAILURE;
+
+		SET_CORE_PARAM(core_param_qos_write_bandwidth,
+				strtoul(arg[0], NULL, 10));
+	} else {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+int get_param_io_class_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "io-class-id"))
+		return core_param_handle_io_class(arg);
+
+	return get_param_handle_option(opt, arg);
+}
+
 int set_param_cleaner_handle_option(char *opt, const char **arg)
 {
 	if (!strcmp(opt, "policy")) {
@@ -1000,6 +2148,22 @@ int set_param_cleaner_handle_option(char *opt, const char **arg)
 			cas_printf(LOG_ERR, "Error: Invalid policy name.\n");
 			return FAILURE;
 		}
+	} else if (!strcmp(opt, "workers")) {
+		if (validate_str_num(arg[0], "cleaner workers",
+				1, CAS_CLEANER_WORKERS_MAX)) {
+			return FAILURE;
+		}
+
+		SET_CACHE_PARAM(cache_param_cleaner_workers,
+				strtoul(arg[0], NULL, 10));
+	} else if (!strcmp(opt, "rewrite-defer")) {
+		if (validate_str_num(arg[0], "rewrite deferral threshold",
+				0, 100)) {
+			return FAILURE;
+		}
+
+		SET_CACHE_PARAM(cache_param_cleaner_rewrite_defer,
+				strtoul(arg[0], NULL, 10));
 	} else {
 		return FAILURE;
 	}
@@ -1079,48 +2243,226 @@ int set_param_cleaning_alru_handle_option(char *opt, const char **arg)
 	return SUCCESS;
 }
 
-int set_param_cleaning_acp_handle_option(char *opt, const char **arg)
+int set_param_cleaning_acp_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "wake-up")) {
+		if (validate_str_num(arg[0], "wake-up time",
+				OCF_ACP_MIN_WAKE_UP, OCF_ACP_MAX_WAKE_UP)) {
+			return FAILURE;
+		}
+
+		SET_CACHE_PARAM(cache_param_cleaning_acp_wake_up_time,
+				strtoul(arg[0], NULL, 10));
+	} else if (!strcmp(opt, "flush-split-unit")) {
+		if (validate_str_num(arg[0], "flush split unit",
+				OCF_ACP_MIN_FLUSH_SPLIT_UNIT, OCF_ACP_MAX_FLUSH_SPLIT_UNIT)) {
+			return FAILURE;
+		}
+
+		SET_CACHE_PARAM(cache_param_cleaning_acp_flush_split_unit,
+				strtoul(arg[0], NULL, 10));
+	} else if (!strcmp(opt, "flush-max-buffers")) {
+		if (validate_str_num(arg[0], "flush max buffers",
+				OCF_ACP_MIN_FLUSH_MAX_BUFFERS, OCF_ACP_MAX_FLUSH_MAX_BUFFERS)) {
+			return FAILURE;
+		}
+
+		SET_CACHE_PARAM(cache_param_cleaning_acp_flush_max_buffers,
+				strtoul(arg[0], NULL, 10));
+	} else if (!strcmp(opt, "activity-threshold")) {
+		if (validate_str_num(arg[0], "activity threshold",
+				OCF_ACP_MIN_ACTIVITY_THRESHOLD, OCF_ACP_MAX_ACTIVITY_THRESHOLD)) {
+			return FAILURE;
+		}
+
+		SET_CACHE_PARAM(cache_param_cleaning_acp_activity_threshold,
+				strtoul(arg[0], NULL, 10));
+	} else if (!strcmp(opt, "dirty-overflow-threshold")) {
+		if (validate_str_num(arg[0], "dirty overflow threshold",
+				OCF_ACP_MIN_DIRTY_OVERFLOW_THRESHOLD, OCF_ACP_MAX_DIRTY_OVERFLOW_THRESHOLD)) {
+			return FAILURE;
+		}
+
+		SET_CACHE_PARAM(cache_param_cleaning_acp_dirty_overflow_threshold,
+				strtoul(arg[0], NULL, 10));
+	} else {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+int set_param_promotion_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "policy")) {
+		if (!strcmp("always", arg[0])) {
+			SET_CACHE_PARAM(cache_param_promotion_policy_type,
+					ocf_promotion_always);
+		} else if (!strcmp("nhit", arg[0])) {
+			SET_CACHE_PARAM(cache_param_promotion_policy_type,
+					ocf_promotion_nhit);
+		} else if (!strcmp("tinylfu", arg[0])) {
+			SET_CACHE_PARAM(cache_param_promotion_policy_type,
+					KCAS_PROMOTION_TINYLFU);
+		} else {
+			cas_printf(LOG_ERR, "Error: Invalid policy name.\n");
+			return FAILURE;
+		}
+	} else {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+int set_param_promotion_nhit_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "threshold")) {
+		if (validate_str_num(arg[0], "threshold",
+				OCF_NHIT_MIN_THRESHOLD, OCF_NHIT_MAX_THRESHOLD)) {
+			return FAILURE;
+		}
+
+		SET_CACHE_PARAM(cache_param_promotion_nhit_insertion_threshold,
+				strtoul(arg[0], NULL, 10));
+	} else if (!strcmp(opt, "trigger")) {
+		if (validate_str_num(arg[0], "trigger",
+				OCF_NHIT_MIN_TRIGGER, OCF_NHIT_MAX_TRIGGER)) {
+			return FAILURE;
+		}
+
+		SET_CACHE_PARAM(cache_param_promotion_nhit_trigger_threshold,
+				strtoul(arg[0], NULL, 10));
+	} else if (!strcmp(opt, "adaptive")) {
+		if (!strcmp("on", arg[0])) {
+			SET_CACHE_PARAM(cache_param_promotion_nhit_adaptive, 1);
+		} else if (!strcmp("off", arg[0])) {
+			SET_CACHE_PARAM(cache_param_promotion_nhit_adaptive, 0);
+		} else {
+			cas_printf(LOG_ERR, "Error: Invalid adaptive value.\n");
+			return FAILURE;
+		}
+	} else {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+int set_param_queue_poll_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "poll-time")) {
+		if (validate_str_num(arg[0], "poll time",
+				0, CAS_QUEUE_POLL_TIME_MAX)) {
+			return FAILURE;
+		}
+
+		SET_CACHE_PARAM(cache_param_queue_poll_time,
+				strtoul(arg[0], NULL, 10));
+	} else {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+int set_param_io_class_adapt_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "bound")) {
+		if (validate_str_num(arg[0], "priority shift bound",
+				0, OCF_IO_CLASS_PRIO_LOWEST)) {
+			return FAILURE;
+		}
+
+		SET_CACHE_PARAM(cache_param_io_class_adaptive_prio,
+				strtoul(arg[0], NULL, 10));
+	} else {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+int set_param_cache_trim_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "rate")) {
+		if (validate_str_num(arg[0], "trim rate",
+				0, KCAS_CACHE_TRIM_RATE_MAX)) {
+			return FAILURE;
+		}
+
+		SET_CACHE_PARAM(cache_param_cache_trim_rate,
+				strtoul(arg[0], NULL, 10));
+	} else {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+int set_param_dram_tier_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "size")) {
+		if (validate_str_num(arg[0], "tier size",
+				0, KCAS_DRAM_TIER_SIZE_MAX)) {
+			return FAILURE;
+		}
+
+		SET_CACHE_PARAM(cache_param_dram_tier_size,
+				strtoul(arg[0], NULL, 10));
+	} else {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+int set_param_mirror_handle_option(char *opt, const char **arg)
 {
-	if (!strcmp(opt, "wake-up")) {
-		if (validate_str_num(arg[0], "wake-up time",
-				OCF_ACP_MIN_WAKE_UP, OCF_ACP_MAX_WAKE_UP)) {
+	if (!strcmp(opt, "rebuild-member")) {
+		if (validate_str_num(arg[0], "member", 0, 1))
 			return FAILURE;
-		}
 
-		SET_CACHE_PARAM(cache_param_cleaning_acp_wake_up_time,
+		SET_CACHE_PARAM(cache_param_mirror_rebuild,
 				strtoul(arg[0], NULL, 10));
-	} else if (!strcmp(opt, "flush-split-unit")) {
-		if (validate_str_num(arg[0], "flush split unit",
-				OCF_ACP_MIN_FLUSH_SPLIT_UNIT, OCF_ACP_MAX_FLUSH_SPLIT_UNIT)) {
-			return FAILURE;
-		}
+	} else {
+		return FAILURE;
+	}
 
-		SET_CACHE_PARAM(cache_param_cleaning_acp_flush_split_unit,
-				strtoul(arg[0], NULL, 10));
-	} else if (!strcmp(opt, "flush-max-buffers")) {
-		if (validate_str_num(arg[0], "flush max buffers",
-				OCF_ACP_MIN_FLUSH_MAX_BUFFERS, OCF_ACP_MAX_FLUSH_MAX_BUFFERS)) {
-			return FAILURE;
-		}
+	return SUCCESS;
+}
 
-		SET_CACHE_PARAM(cache_param_cleaning_acp_flush_max_buffers,
-				strtoul(arg[0], NULL, 10));
-	} else if (!strcmp(opt, "activity-threshold")) {
-		if (validate_str_num(arg[0], "activity threshold",
-				OCF_ACP_MIN_ACTIVITY_THRESHOLD, OCF_ACP_MAX_ACTIVITY_THRESHOLD)) {
+int set_param_compression_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "io-class-id")) {
+		return core_param_handle_io_class(arg);
+	} else if (!strcmp(opt, "enabled")) {
+		if (!strcmp("on", arg[0])) {
+			SET_CACHE_PARAM(cache_param_compress_enabled, 1);
+		} else if (!strcmp("off", arg[0])) {
+			SET_CACHE_PARAM(cache_param_compress_enabled, 0);
+		} else {
+			cas_printf(LOG_ERR, "Error: Invalid compression value.\n");
 			return FAILURE;
 		}
+	} else {
+		return FAILURE;
+	}
 
-		SET_CACHE_PARAM(cache_param_cleaning_acp_activity_threshold,
-				strtoul(arg[0], NULL, 10));
-	} else if (!strcmp(opt, "dirty-overflow-threshold")) {
-		if (validate_str_num(arg[0], "dirty overflow threshold",
-				OCF_ACP_MIN_DIRTY_OVERFLOW_THRESHOLD, OCF_ACP_MAX_DIRTY_OVERFLOW_THRESHOLD)) {
+	return SUCCESS;
+}
+
+int set_param_dedup_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "enabled")) {
+		if (!strcmp("on", arg[0])) {
+			SET_CACHE_PARAM(cache_param_dedup_enabled, 1);
+		} else if (!strcmp("off", arg[0])) {
+			SET_CACHE_PARAM(cache_param_dedup_enabled, 0);
+		} else {
+			cas_printf(LOG_ERR, "Error: Invalid deduplication value.\n");
 			return FAILURE;
 		}
-
-		SET_CACHE_PARAM(cache_param_cleaning_acp_dirty_overflow_threshold,
-				strtoul(arg[0], NULL, 10));
 	} else {
 		return FAILURE;
 	}
@@ -1128,17 +2470,15 @@ int set_param_cleaning_acp_handle_option(char *opt, const char **arg)
 	return SUCCESS;
 }
 
-int set_param_promotion_handle_option(char *opt, const char **arg)
+int set_param_checksum_handle_option(char *opt, const char **arg)
 {
-	if (!strcmp(opt, "policy")) {
-		if (!strcmp("always", arg[0])) {
-			SET_CACHE_PARAM(cache_param_promotion_policy_type,
-					ocf_promotion_always);
-		} else if (!strcmp("nhit", arg[0])) {
-			SET_CACHE_PARAM(cache_param_promotion_policy_type,
-					ocf_promotion_nhit);
+	if (!strcmp(opt, "enabled")) {
+		if (!strcmp("on", arg[0])) {
+			SET_CACHE_PARAM(cache_param_checksum_enabled, 1);
+		} else if (!strcmp("off", arg[0])) {
+			SET_CACHE_PARAM(cache_param_checksum_enabled, 0);
 		} else {
-			cas_printf(LOG_ERR, "Error: Invalid policy name.\n");
+			cas_printf(LOG_ERR, "Error: Invalid checksum value.\n");
 			return FAILURE;
 		}
 	} else {
@@ -1148,23 +2488,55 @@ int set_param_promotion_handle_option(char *opt, const char **arg)
 	return SUCCESS;
 }
 
-int set_param_promotion_nhit_handle_option(char *opt, const char **arg)
+int set_param_slow_bypass_handle_option(char *opt, const char **arg)
 {
 	if (!strcmp(opt, "threshold")) {
-		if (validate_str_num(arg[0], "threshold",
-				OCF_NHIT_MIN_THRESHOLD, OCF_NHIT_MAX_THRESHOLD)) {
+		if (validate_str_num(arg[0], "latency threshold",
+				0, KCAS_SLOW_BYPASS_THRESHOLD_MAX)) {
 			return FAILURE;
 		}
 
-		SET_CACHE_PARAM(cache_param_promotion_nhit_insertion_threshold,
+		SET_CACHE_PARAM(cache_param_slow_bypass_threshold,
 				strtoul(arg[0], NULL, 10));
-	} else if (!strcmp(opt, "trigger")) {
-		if (validate_str_num(arg[0], "trigger",
-				OCF_NHIT_MIN_TRIGGER, OCF_NHIT_MAX_TRIGGER)) {
+	} else {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+int set_param_seq_absorb_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "free")) {
+		if (validate_str_num(arg[0], "free space threshold", 0, 100))
+			return FAILURE;
+
+		SET_CACHE_PARAM(cache_param_seq_absorb_free,
+				strtoul(arg[0], NULL, 10));
+	} else if (!strcmp(opt, "dirty-headroom")) {
+		if (validate_str_num(arg[0], "dirty headroom threshold",
+				0, 100)) {
 			return FAILURE;
 		}
 
-		SET_CACHE_PARAM(cache_param_promotion_nhit_trigger_threshold,
+		SET_CACHE_PARAM(cache_param_seq_absorb_headroom,
+				strtoul(arg[0], NULL, 10));
+	} else {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+int set_param_meta_coalesce_handle_option(char *opt, const char **arg)
+{
+	if (!strcmp(opt, "window")) {
+		if (validate_str_num(arg[0], "coalescing window",
+				0, KCAS_META_COALESCE_WINDOW_MAX)) {
+			return FAILURE;
+		}
+
+		SET_CACHE_PARAM(cache_param_meta_coalesce_window,
 				strtoul(arg[0], NULL, 10));
 	} else {
 		return FAILURE;
@@ -1178,6 +2550,21 @@ int set_param_namespace_handle_option(char *namespace, char *opt, const char **a
 	if (!strcmp(namespace, "seq-cutoff")) {
 		return core_param_handle_option_generic(opt, arg,
 				set_param_seq_cutoff_handle_option);
+	} else if (!strcmp(namespace, "inflight-limit")) {
+		return core_param_handle_option_generic(opt, arg,
+				set_param_inflight_limit_handle_option);
+	} else if (!strcmp(namespace, "read-ahead")) {
+		return core_param_handle_option_generic(opt, arg,
+				set_param_read_ahead_handle_option);
+	} else if (!strcmp(namespace, "dirty-throttle")) {
+		return core_param_handle_option_generic(opt, arg,
+				set_param_dirty_throttle_handle_option);
+	} else if (!strcmp(namespace, "writeback-sweep")) {
+		return core_param_handle_option_generic(opt, arg,
+				set_param_writeback_sweep_handle_option);
+	} else if (!strcmp(namespace, "qos")) {
+		return core_param_handle_option_generic(opt, arg,
+				set_param_qos_handle_option);
 	} else if (!strcmp(namespace, "cleaner")) {
 		return cache_param_handle_option_generic(opt, arg,
 				set_param_cleaner_handle_option);
@@ -1196,6 +2583,39 @@ int set_param_namespace_handle_option(char *namespace, char *opt, const char **a
 	} else if (!strcmp(namespace, "promotion-nhit")) {
 		return cache_param_handle_option_generic(opt, arg,
 				set_param_promotion_nhit_handle_option);
+	} else if (!strcmp(namespace, "queue-poll")) {
+		return cache_param_handle_option_generic(opt, arg,
+				set_param_queue_poll_handle_option);
+	} else if (!strcmp(namespace, "io-class-adapt")) {
+		return cache_param_handle_option_generic(opt, arg,
+				set_param_io_class_adapt_handle_option);
+	} else if (!strcmp(namespace, "cache-trim")) {
+		return cache_param_handle_option_generic(opt, arg,
+				set_param_cache_trim_handle_option);
+	} else if (!strcmp(namespace, "dram-tier")) {
+		return cache_param_handle_option_generic(opt, arg,
+				set_param_dram_tier_handle_option);
+	} else if (!strcmp(namespace, "mirror")) {
+		return cache_param_handle_option_generic(opt, arg,
+				set_param_mirror_handle_option);
+	} else if (!strcmp(namespace, "compression")) {
+		return cache_param_handle_option_generic(opt, arg,
+				set_param_compression_handle_option);
+	} else if (!strcmp(namespace, "dedup")) {
+		return cache_param_handle_option_generic(opt, arg,
+				set_param_dedup_handle_option);
+	} else if (!strcmp(namespace, "checksum")) {
+		return cache_param_handle_option_generic(opt, arg,
+				set_param_checksum_handle_option);
+	} else if (!strcmp(namespace, "slow-bypass")) {
+		return cache_param_handle_option_generic(opt, arg,
+				set_param_slow_bypass_handle_option);
+	} else if (!strcmp(namespace, "metadata-coalesce")) {
+		return cache_param_handle_option_generic(opt, arg,
+				set_param_meta_coalesce_handle_option);
+	} else if (!strcmp(namespace, "seq-absorb")) {
+		return cache_param_handle_option_generic(opt, arg,
+				set_param_seq_absorb_handle_option);
 	} else {
 		return FAILURE;
 	}
@@ -1215,10 +2635,12 @@ int handle_set_param()
 	case PARAM_TYPE_CORE:
 		err = core_params_set(command_args_values.cache_id,
 				command_args_values.core_id,
+				command_args_values.io_class_id,
 				cas_core_params);
 		break;
 	case PARAM_TYPE_CACHE:
 		err = cache_params_set(command_args_values.cache_id,
+				command_args_values.io_class_id,
 				cas_cache_params);
 		break;
 	default:
@@ -1241,6 +2663,32 @@ static cli_namespace get_param_namespace = {
 	.long_name = "name",
 	.entries = {
 		GET_CORE_PARAMS_NS("seq-cutoff", "Sequential cutoff parameters")
+		GET_CORE_PARAMS_NS("inflight-limit", "Core device inflight limits")
+		{
+			.name = "read-ahead",
+			.desc = "Read-ahead of sequential streams",
+			.options = {
+				{'i', "cache-id", CACHE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
+				{'j', "core-id", CORE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
+				{'d', "io-class-id", READ_AHEAD_IO_CLASS_DESC, 1, "ID",
+					CLI_OPTION_REQUIRED},
+				{'o', "output-format", "Output format: {table|csv}", 1, "FORMAT"},
+				{0},
+			},
+		},
+		GET_CORE_PARAMS_NS("dirty-throttle", "Write throttling by dirty data of core")
+		GET_CORE_PARAMS_NS("writeback-sweep", "Sorting of cleaning writes to core")
+		{
+			.name = "qos",
+			.desc = "IOPS and bandwidth limits",
+			.options = {
+				{'i', "cache-id", CACHE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
+				{'j', "core-id", CORE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
+				{'d', "io-class-id", QOS_IO_CLASS_DESC, 1, "ID", 0},
+				{'o', "output-format", "Output format: {table|csv}", 1, "FORMAT"},
+				{0},
+			},
+		},
 		GET_CACHE_PARAMS_NS("dirty-meta-chunk", "Dirty meta chunk policy parameters")
 		GET_CACHE_PARAMS_NS("dirty-data-chunk", "Dirty data chunk policy parameters")
 		GET_CACHE_PARAMS_NS("cleaner", "Cleaner policy parameters")
@@ -1249,6 +2697,26 @@ static cli_namespace get_param_namespace = {
 		GET_CACHE_PARAMS_NS("cleaning-acp", "Cleaning policy ACP parameters")
 		GET_CACHE_PARAMS_NS("promotion", "Promotion policy parameters")
 		GET_CACHE_PARAMS_NS("promotion-nhit", "Promotion policy NHIT parameters")
+		GET_CACHE_PARAMS_NS("queue-poll", "Queue thread polling parameters")
+		GET_CACHE_PARAMS_NS("io-class-adapt", "Adaptive io class priorities")
+		GET_CACHE_PARAMS_NS("cache-trim", "Background trim of cache device")
+		GET_CACHE_PARAMS_NS("dram-tier", "In-memory tier in front of cache")
+		GET_CACHE_PARAMS_NS("mirror", "Mirrored cache device")
+		{
+			.name = "compression",
+			.desc = "Compression of cache device data",
+			.options = {
+				{'i', "cache-id", CACHE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
+				{'d', "io-class-id", COMPRESS_IO_CLASS_DESC, 1, "ID", 0},
+				{'o', "output-format", "Output format: {table|csv}", 1, "FORMAT"},
+				{0},
+			},
+		},
+		GET_CACHE_PARAMS_NS("dedup", "Deduplication of cache device data")
+		GET_CACHE_PARAMS_NS("checksum", "Checksums of cache device data")
+		GET_CACHE_PARAMS_NS("slow-bypass", "Bypass of slow cache device")
+		GET_CACHE_PARAMS_NS("metadata-coalesce", "Coalescing of metadata writes")
+		GET_CACHE_PARAMS_NS("seq-absorb", "Absorbing sequential writes")
 
 		{0},
 	},
@@ -1275,6 +2743,33 @@ int get_param_namespace_handle_option(char *namespace, char *opt, const char **a
 		SELECT_CORE_PARAM(core_param_seq_cutoff_promotion_count);
 		return core_param_handle_option_generic(opt, arg,
 				get_param_handle_option);
+	} else if (!strcmp(namespace, "inflight-limit")) {
+		SELECT_CORE_PARAM(core_param_inflight_limit_foreground);
+		SELECT_CORE_PARAM(core_param_inflight_limit_background);
+		return core_param_handle_option_generic(opt, arg,
+				get_param_handle_option);
+	} else if (!strcmp(namespace, "read-ahead")) {
+		SELECT_CORE_PARAM(core_param_read_ahead_lines);
+		return core_param_handle_option_generic(opt, arg,
+				get_param_io_class_handle_option);
+	} else if (!strcmp(namespace, "dirty-throttle")) {
+		SELECT_CORE_PARAM(core_param_dirty_throttle_limit);
+		SELECT_CORE_PARAM(core_param_dirty_throttle_max_pause);
+		return core_param_handle_option_generic(opt, arg,
+				get_param_handle_option);
+	} else if (!strcmp(namespace, "writeback-sweep")) {
+		SELECT_CORE_PARAM(core_param_writeback_sweep_window);
+		return core_param_handle_option_generic(opt, arg,
+				get_param_handle_option);
+	} else if (!strcmp(namespace, "qos")) {
+		SELECT_CORE_PARAM(core_param_qos_read_iops);
+		SELECT_CORE_PARAM(core_param_qos_write_iops);
+		SELECT_CORE_PARAM(core_param_qos_read_bandwidth);
+		SELECT_CORE_PARAM(core_param_qos_write_bandwidth);
+		SELECT_CORE_PARAM(core_param_get_qos_read_throttled);
+		SELECT_CORE_PARAM(core_param_get_qos_write_throttled);
+		return core_param_handle_option_generic(opt, arg,
+				get_param_io_class_handle_option);
 	} else if (!strcmp(namespace, "dirty-meta-chunk")) {
 		SELECT_CACHE_PARAM(cache_param_get_dirty_meta_chunk);
 		return cache_param_handle_option_generic(opt, arg,
@@ -1285,6 +2780,8 @@ int get_param_namespace_handle_option(char *namespace, char *opt, const char **a
 				get_param_handle_option);
 	} else if (!strcmp(namespace, "cleaner")) {
 		SELECT_CACHE_PARAM(cache_param_cleaner_policy_control);
+		SELECT_CACHE_PARAM(cache_param_cleaner_workers);
+		SELECT_CACHE_PARAM(cache_param_cleaner_rewrite_defer);
 		return cache_param_handle_option_generic(opt, arg,
 				get_param_handle_option);
 	} else if (!strcmp(namespace, "cleaning")) {
@@ -1314,6 +2811,58 @@ int get_param_namespace_handle_option(char *namespace, char *opt, const char **a
 	} else if (!strcmp(namespace, "promotion-nhit")) {
 		SELECT_CACHE_PARAM(cache_param_promotion_nhit_insertion_threshold);
 		SELECT_CACHE_PARAM(cache_param_promotion_nhit_trigger_threshold);
+		SELECT_CACHE_PARAM(cache_param_promotion_nhit_adaptive);
+		return cache_param_handle_option_generic(opt, arg,
+				get_param_handle_option);
+	} else if (!strcmp(namespace, "queue-poll")) {
+		SELECT_CACHE_PARAM(cache_param_queue_poll_time);
+		return cache_param_handle_option_generic(opt, arg,
+				get_param_handle_option);
+	} else if (!strcmp(namespace, "io-class-adapt")) {
+		SELECT_CACHE_PARAM(cache_param_io_class_adaptive_prio);
+		return cache_param_handle_option_generic(opt, arg,
+				get_param_handle_option);
+	} else if (!strcmp(namespace, "cache-trim")) {
+		SELECT_CACHE_PARAM(cache_param_cache_trim_rate);
+		return cache_param_handle_option_generic(opt, arg,
+				get_param_handle_option);
+	} else if (!strcmp(namespace, "dram-tier")) {
+		SELECT_CACHE_PARAM(cache_param_dram_tier_size);
+		return cache_param_handle_option_generic(opt, arg,
+				get_param_handle_option);
+	} else if (!strcmp(namespace, "mirror")) {
+		SELECT_CACHE_PARAM(cache_param_get_mirror_member0_state);
+		SELECT_CACHE_PARAM(cache_param_get_mirror_member1_state);
+		SELECT_CACHE_PARAM(cache_param_get_mirror_rebuild_progress);
+		return cache_param_handle_option_generic(opt, arg,
+				get_param_handle_option);
+	} else if (!strcmp(namespace, "compression")) {
+		SELECT_CACHE_PARAM(cache_param_compress_enabled);
+		SELECT_CACHE_PARAM(cache_param_get_compress_ratio);
+		SELECT_CACHE_PARAM(cache_param_get_compress_device_used);
+		return cache_param_handle_option_generic(opt, arg,
+				get_param_io_class_handle_option);
+	} else if (!strcmp(namespace, "dedup")) {
+		SELECT_CACHE_PARAM(cache_param_dedup_enabled);
+		return cache_param_handle_option_generic(opt, arg,
+				get_param_handle_option);
+	} else if (!strcmp(namespace, "checksum")) {
+		SELECT_CACHE_PARAM(cache_param_checksum_enabled);
+		return cache_param_handle_option_generic(opt, arg,
+				get_param_handle_option);
+	} else if (!strcmp(namespace, "slow-bypass")) {
+		SELECT_CACHE_PARAM(cache_param_slow_bypass_threshold);
+		SELECT_CACHE_PARAM(cache_param_get_slow_bypass_active);
+		return cache_param_handle_option_generic(opt, arg,
+				get_param_handle_option);
+	} else if (!strcmp(namespace, "metadata-coalesce")) {
+		SELECT_CACHE_PARAM(cache_param_meta_coalesce_window);
+		return cache_param_handle_option_generic(opt, arg,
+				get_param_handle_option);
+	} else if (!strcmp(namespace, "seq-absorb")) {
+		SELECT_CACHE_PARAM(cache_param_seq_absorb_free);
+		SELECT_CACHE_PARAM(cache_param_seq_absorb_headroom);
+		SELECT_CACHE_PARAM(cache_param_get_seq_absorb_active);
 		return cache_param_handle_option_generic(opt, arg,
 				get_param_handle_option);
 	} else {
@@ -1334,10 +2883,12 @@ int handle_get_param()
 	case PARAM_TYPE_CORE:
 		err = core_params_get(command_args_values.cache_id,
 				command_args_values.core_id,
+				command_args_values.io_class_id,
 				cas_core_params, format);
 		break;
 	case PARAM_TYPE_CACHE:
 		err = cache_params_get(command_args_values.cache_id,
+				command_args_values.io_class_id,
 				cas_cache_params, format);
 		break;
 	default:
@@ -1354,7 +2905,7 @@ int handle_get_param()
 static cli_option set_state_cache_mode_options[] = {
 	{'c', "cache-mode", "Cache mode. Available cache modes: {"CAS_CLI_HELP_SET_CACHE_MODES"}", 1, "NAME", CLI_OPTION_REQUIRED},
 	{'i', "cache-id", CACHE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
-	{'f', "flush-cache", "Flush all dirty data from cache before switching to new mode. Option is required when switching from Write-Back or Write-Only mode", 1, "yes|no",0},
+	{'f', "flush-cache", "Flush all dirty data from cache before switching to new mode, or with 'background' switch at once and drain dirty data in background. Option is required when switching from Write-Back or Write-Only mode", 1, "yes|no|background",0},
 	{0},
 };
 
@@ -1377,8 +2928,10 @@ int set_cache_mode_command_handle_option(char *opt, const char **arg)
 			command_args_values.cache_state_flush = YES;
 		else if (!strcmp("no", arg[0]))
 			command_args_values.cache_state_flush = NO;
+		else if (!strcmp("background", arg[0]))
+			command_args_values.cache_state_flush = CACHE_MODE_FLUSH_BACKGROUND;
 		else {
-			cas_printf(LOG_ERR, "Error: 'yes' or 'no' required as an argument for -f option.\n");
+			cas_printf(LOG_ERR, "Error: 'yes', 'no' or 'background' required as an argument for -f option.\n");
 			return FAILURE;
 		}
 	} else {
@@ -1398,17 +2951,42 @@ int handle_set_cache_mode()
 static cli_option add_options[] = {
 	{'i', "cache-id", CACHE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
 	{'j', "core-id", CORE_ID_DESC, 1, "ID", 0},
-	{'d', "core-device", CORE_DEVICE_DESC, 1, "DEVICE", CLI_OPTION_REQUIRED},
+	{'d', "core-device", CORE_DEVICES_DESC, 1, "DEVICE", CLI_OPTION_REQUIRED},
 	{'m', "fs-meta-map-file", "fs meta map file", 1, "FILE", CLI_OPTION_OPTIONAL_ARG},
+	{0, "queue-depth", QUEUE_DEPTH_DESC, 1, "NUMBER", 0},
+	{0, "hw-queues", HW_QUEUES_DESC, 1, "NUMBER", 0},
+	{0, "bdi-read-ahead", BDI_READ_AHEAD_DESC, 1, "KiB", 0},
+	{0, "io-opt", IO_OPT_DESC, 1, "KiB", 0},
 	{0}
 };
 
 int handle_add()
 {
+	if (strchr(command_args_values.core_device, ',')) {
+		if (command_args_values.core_id != OCF_CORE_ID_INVALID ||
+				command_args_values.fs_meta_map_file) {
+			cas_printf(LOG_ERR, "Options '--core-id' and "
+					"'--fs-meta-map-file' cannot be used "
+					"with multiple core devices\n");
+			return FAILURE;
+		}
+
+		return add_cores(command_args_values.cache_id,
+				command_args_values.core_device,
+				command_args_values.queue_depth,
+				command_args_values.hw_queues,
+				command_args_values.read_ahead_kb,
+				command_args_values.io_opt_kb);
+	}
+
 	return add_core(command_args_values.cache_id,
 			command_args_values.core_id,
 			command_args_values.core_device,
-			false, false, command_args_values.fs_meta_map_file);
+			false, false, command_args_values.fs_meta_map_file,
+			command_args_values.queue_depth,
+			command_args_values.hw_queues,
+			command_args_values.read_ahead_kb,
+			command_args_values.io_opt_kb);
 }
 
 static cli_option remove_options[] = {
@@ -1439,6 +3017,22 @@ int handle_remove_inactive()
 			command_args_values.core_id, command_args_values.force);
 }
 
+static cli_option update_fs_meta_options[] = {
+	{'i', "cache-id", CACHE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
+	{'j', "core-id", CORE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
+	{'m', "fs-meta-map-file", "fs meta map file with extents to add or remove", 1, "FILE", CLI_OPTION_REQUIRED},
+	{'r', "remove", "Remove extents listed in file instead of adding them"},
+	{0}
+};
+
+int handle_update_fs_meta()
+{
+	return update_fs_meta(command_args_values.cache_id,
+			command_args_values.core_id,
+			command_args_values.fs_meta_map_file,
+			command_args_values.fs_meta_remove);
+}
+
 static cli_option core_pool_remove_options[] = {
 	{'d', "device", CORE_DEVICE_DESC, 1, "DEVICE", CLI_OPTION_REQUIRED},
 	{0}
@@ -1468,14 +3062,29 @@ int handle_reset_counters()
 static cli_option flush_cache_options[] = { 
 	{'i', "cache-id", CACHE_ID_DESC, 1, "ID", CLI_OPTION_REQUIRED},
 	{'j', "core-id", CORE_ID_DESC, 1, "ID", CLI_OPTION_OPTIONAL_ARG},
+	{'r', "rate-limit", FLUSH_RATE_LIMIT_DESC, 1, "MiB/s", 0},
+	{'a', "async", ASYNC_DESC},
 	{0}
 };
 
 int handle_flush_cache()
 {
+	if (command_args_values.async) {
+		bool core = command_args_values.core_id != OCF_CORE_ID_INVALID;
+
+		return async_op_start(core ? KCAS_ASYNC_OP_FLUSH_CORE :
+					KCAS_ASYNC_OP_FLUSH_CACHE,
+				command_args_values.cache_id,
+				command_args_values.core_id, 0,
+				command_args_values.flush_rate_limit);
+	}
+
 	if(command_args_values.core_id != OCF_CORE_ID_INVALID)
-		return flush_core(command_args_values.cache_id, command_args_values.core_id);
-	return flush_cache(command_args_values.cache_id);
+		return flush_core(command_args_values.cache_id,
+				command_args_values.core_id,
+				command_args_values.flush_rate_limit);
+	return flush_cache(command_args_values.cache_id,
+			command_args_values.flush_rate_limit);
 }
 
 /*******************************************************************************
@@ -1485,10 +3094,16 @@ int handle_flush_cache()
 enum {
 	io_class_opt_subcmd_configure = 0,
 	io_class_opt_subcmd_list,
+	io_class_opt_subcmd_stats,
+	io_class_opt_subcmd_bench,
+	io_class_opt_subcmd_compile,
 
 	io_class_opt_cache_id,
 	io_class_opt_cache_file_load,
+	io_class_opt_image,
 	io_class_opt_output_format,
+	io_class_opt_core_id,
+	io_class_opt_path,
 
 	io_class_opt_io_class_id,
 	io_class_opt_prio,
@@ -1523,6 +3138,33 @@ static cli_option io_class_params_options[] = {
 		.priv = 0,
 		.flags = CLI_OPTION_SUBCMD,
 	},
+	[io_class_opt_subcmd_stats] = {
+		.short_name = 'S',
+		.long_name = "stats",
+		.desc = "Prints classification statistics of IO classes",
+		.args_count = 0,
+		.arg = NULL,
+		.priv = 0,
+		.flags = CLI_OPTION_SUBCMD,
+	},
+	[io_class_opt_subcmd_bench] = {
+		.short_name = 'B',
+		.long_name = "bench",
+		.desc = "Measures classification time of synthetic requests",
+		.args_count = 0,
+		.arg = NULL,
+		.priv = 0,
+		.flags = CLI_OPTION_SUBCMD,
+	},
+	[io_class_opt_subcmd_compile] = {
+		.short_name = 'K',
+		.long_name = "compile",
+		.desc = "Validates configuration file and compiles it into image loadable with --load-config",
+		.args_count = 0,
+		.arg = NULL,
+		.priv = 0,
+		.flags = CLI_OPTION_SUBCMD,
+	},
 	[io_class_opt_cache_id] = {
 		.short_name = 'i',
 		.long_name = "cache-id",
@@ -1531,6 +3173,8 @@ static cli_option io_class_params_options[] = {
 		.arg = "ID",
 		.priv = (1 << io_class_opt_subcmd_configure)
 			| (1 << io_class_opt_subcmd_list)
+			| (1 << io_class_opt_subcmd_stats)
+			| (1 << io_class_opt_subcmd_bench)
 			| (1 << io_class_opt_flag_required),
 		.flags = CLI_OPTION_RANGE_INT,
 		.max_value = 0,
@@ -1539,10 +3183,20 @@ static cli_option io_class_params_options[] = {
 	[io_class_opt_cache_file_load] = {
 		.short_name = 'f',
 		.long_name = "file",
-		.desc = "Configuration file containing IO class definition",
+		.desc = "Configuration file containing IO class definition, or image compiled from it",
 		.args_count = 1,
 		.arg = "FILE",
 		.priv = (1 << io_class_opt_subcmd_configure)
+			| (1 << io_class_opt_subcmd_compile)
+			| (1 << io_class_opt_flag_required)
+	},
+	[io_class_opt_image] = {
+		.short_name = 'I',
+		.long_name = "image",
+		.desc = "Image file compiled configuration is written to",
+		.args_count = 1,
+		.arg = "FILE",
+		.priv = (1 << io_class_opt_subcmd_compile)
 			| (1 << io_class_opt_flag_required)
 	},
 	[io_class_opt_output_format] = {
@@ -1552,6 +3206,25 @@ static cli_option io_class_params_options[] = {
 		.args_count = 1,
 		.arg = "FORMAT",
 		.priv = (1 << io_class_opt_subcmd_list)
+			| (1 << io_class_opt_subcmd_stats)
+			| (1 << io_class_opt_subcmd_bench)
+	},
+	[io_class_opt_core_id] = {
+		.short_name = 'j',
+		.long_name = "core-id",
+		.desc = CORE_ID_DESC,
+		.args_count = 1,
+		.arg = "ID",
+		.priv = (1 << io_class_opt_subcmd_bench)
+			| (1 << io_class_opt_flag_required)
+	},
+	[io_class_opt_path] = {
+		.short_name = 'P',
+		.long_name = "path",
+		.desc = "File whose cached pages are carried by requests",
+		.args_count = 1,
+		.arg = "FILE",
+		.priv = (1 << io_class_opt_subcmd_bench)
 	},
 
 	[io_class_opt_io_class_id] = {
@@ -1607,6 +3280,7 @@ static cli_option io_class_params_options[] = {
 struct {
 	int subcmd;
 	uint32_t cache_id;
+	uint16_t core_id;
 	int io_class_id;
 	int cache_mode;
 	int io_class_prio;
@@ -1614,11 +3288,15 @@ struct {
 	uint32_t min;
 	uint32_t max;
 	char file[MAX_STR_LEN];
+	char path[MAX_STR_LEN];
+	char image[MAX_STR_LEN];
 	char name[OCF_IO_CLASS_NAME_MAX];
 } static io_class_params = {
 	.subcmd = io_class_opt_subcmd_unknown,
 	.cache_id = 0,
 	.file = "",
+	.path = "",
+	.image = "",
 	.output_format = OUTPUT_FORMAT_DEFAULT
 };
 
@@ -1633,6 +3311,15 @@ int io_class_handle_option(char *opt, const char **arg)
 		} else if (!strcmp(opt, "list")) {
 			io_class_params.subcmd = io_class_opt_subcmd_list;
 			return 0;
+		} else if (!strcmp(opt, "stats")) {
+			io_class_params.subcmd = io_class_opt_subcmd_stats;
+			return 0;
+		} else if (!strcmp(opt, "bench")) {
+			io_class_params.subcmd = io_class_opt_subcmd_bench;
+			return 0;
+		} else if (!strcmp(opt, "compile")) {
+			io_class_params.subcmd = io_class_opt_subcmd_compile;
+			return 0;
 		}
 	}
 
@@ -1642,6 +3329,19 @@ int io_class_handle_option(char *opt, const char **arg)
 
 		io_class_params_options[io_class_opt_cache_id].priv |= (1 << io_class_opt_flag_set);
 		io_class_params.cache_id = command_args_values.cache_id;
+	} else if (!strcmp(opt, "core-id")) {
+		if (command_handle_option(opt, arg))
+			return FAILURE;
+
+		io_class_params_options[io_class_opt_core_id].priv |= (1 << io_class_opt_flag_set);
+		io_class_params.core_id = command_args_values.core_id;
+	} else if (!strcmp(opt, "path")) {
+		if (validate_path(arg[0], 1))
+			return FAILURE;
+
+		io_class_params_options[io_class_opt_path].priv |=  (1 << io_class_opt_flag_set);
+
+		strncpy_s(io_class_params.path, sizeof(io_class_params.path), arg[0], strnlen_s(arg[0], sizeof(io_class_params.path)));
 	} else if (!strcmp(opt, "file")) {
 		if (validate_path(arg[0], 0))
 			return FAILURE;
@@ -1649,6 +3349,15 @@ int io_class_handle_option(char *opt, const char **arg)
 		io_class_params_options[io_class_opt_cache_file_load].priv |=  (1 << io_class_opt_flag_set);
 
 		strncpy_s(io_class_params.file, sizeof(io_class_params.file), arg[0], strnlen_s(arg[0], sizeof(io_class_params.file)));
+	} else if (!strcmp(opt, "image")) {
+		if (strempty(arg[0])) {
+			cas_printf(LOG_ERR, "Invalid path of image file\n");
+			return FAILURE;
+		}
+
+		io_class_params_options[io_class_opt_image].priv |=  (1 << io_class_opt_flag_set);
+
+		strncpy_s(io_class_params.image, sizeof(io_class_params.image), arg[0], strnlen_s(arg[0], sizeof(io_class_params.image)));
 	} else if (!strcmp(opt, "output-format")) {
 		io_class_params.output_format = validate_str_output_format(arg[0]);
 		if (OUTPUT_FORMAT_INVALID == io_class_params.output_format)
@@ -1715,6 +3424,16 @@ int io_class_handle() {
 	case io_class_opt_subcmd_list:
 		return partition_list(io_class_params.cache_id,
 				io_class_params.output_format);
+	case io_class_opt_subcmd_stats:
+		return partition_stats(io_class_params.cache_id,
+				io_class_params.output_format);
+	case io_class_opt_subcmd_bench:
+		return partition_bench(io_class_params.cache_id,
+				io_class_params.core_id, io_class_params.path,
+				io_class_params.output_format);
+	case io_class_opt_subcmd_compile:
+		return partition_compile(io_class_params.file,
+				io_class_params.image);
 	}
 
 	return FAILURE;
@@ -1752,6 +3471,7 @@ enum {
 	script_opt_update_path,
 	script_opt_detach,
 	script_opt_no_flush,
+	script_opt_background,
 
 	script_opt_max_id,
 
@@ -1879,6 +3599,15 @@ static cli_option script_params_options[] = {
 		.priv = (1 << script_cmd_remove_core),
 		.flags = CLI_OPTION_HIDDEN,
 	},
+	[script_opt_background] = {
+		.short_name = 0,
+		.long_name = "background",
+		.args_count = 0,
+		.arg = NULL,
+		.priv = (1 << script_cmd_purge_cache)
+			| (1 << script_cmd_purge_core),
+		.flags = CLI_OPTION_HIDDEN,
+	},
 
 	{0}
 };
@@ -1980,7 +3709,11 @@ int script_handle() {
 			command_args_values.core_device,
 			command_args_values.try_add,
 			command_args_values.update_path,
-			command_args_values.fs_meta_map_file
+			command_args_values.fs_meta_map_file,
+			command_args_values.queue_depth,
+			command_args_values.hw_queues,
+			command_args_values.read_ahead_kb,
+			command_args_values.io_opt_kb
 			);
 	case script_cmd_remove_core:
 		return remove_core(
@@ -1990,11 +3723,13 @@ int script_handle() {
 			command_args_values.no_flush
 			);
 	case script_cmd_purge_cache:
-		return purge_cache(command_args_values.cache_id);
+		return purge_cache(command_args_values.cache_id,
+				command_args_values.purge_background);
 	case script_cmd_purge_core:
 		return purge_core(
 				command_args_values.cache_id,
-				command_args_values.core_id
+				command_args_values.core_id,
+				command_args_values.purge_background
 				);
 	}
 
@@ -2438,6 +4173,16 @@ static cli_command cas_commands[] = {
 			.flags = CLI_SU_REQUIRED,
 			.help = NULL,
 		},
+		{
+			.name = "op-status",
+			.desc = "Print status of operation running in background",
+			.long_desc = NULL,
+			.options = op_status_options,
+			.command_handle_opts = op_status_handle_option,
+			.handle = handle_op_status,
+			.flags = CLI_SU_REQUIRED,
+			.help = NULL,
+		},
 		{
 			.name = "dump-inflight",
 			.short_name = 'D',
@@ -2514,6 +4259,16 @@ static cli_command cas_commands[] = {
 			.flags = CLI_SU_REQUIRED,
 			.help = NULL,
 		},
+		{
+			.name = "update-fs-meta",
+			.desc = "Add or remove extents of fs meta map of core device",
+			.long_desc = NULL,
+			.options = update_fs_meta_options,
+			.command_handle_opts = command_handle_option,
+			.handle = handle_update_fs_meta,
+			.flags = CLI_SU_REQUIRED,
+			.help = NULL,
+		},
 		{
 			.name = "remove-detached",
 			.desc = "Remove core device from core pool",
@@ -2546,6 +4301,76 @@ static cli_command cas_commands[] = {
 			.flags = CLI_SU_REQUIRED,
 			.help = NULL,
 		},
+		{
+			.name = "export-metrics",
+			.desc = "Export statistics of all caches in Prometheus format",
+			.long_desc = NULL,
+			.options = export_metrics_options,
+			.command_handle_opts = export_metrics_handle_option,
+			.handle = handle_export_metrics,
+			.flags = CLI_SU_REQUIRED,
+			.help = NULL,
+		},
+		{
+			.name = "prefetch",
+			.desc = "Prefetch ranges of core or extents of file into cache",
+			.long_desc = NULL,
+			.options = prefetch_options,
+			.command_handle_opts = prefetch_handle_option,
+			.handle = handle_prefetch,
+			.flags = CLI_SU_REQUIRED,
+			.help = NULL,
+		},
+		{
+			.name = "bench",
+			.desc = "Benchmark exported object of core from kernel",
+			.long_desc = "Generate random I/O to exported object of core from kernel threads, bypassing syscalls and block layer, and print its throughput and latency. Writes destroy data of core.",
+			.options = bench_options,
+			.command_handle_opts = bench_handle_option,
+			.handle = handle_bench,
+			.flags = CLI_SU_REQUIRED,
+			.help = NULL,
+		},
+		{
+			.name = "alloc-bench",
+			.desc = "Benchmark memory allocators of I/O path",
+			.long_desc = "Allocate and free objects of private memory pool from kernel threads on all CPUs at once and print allocation throughput, reserve pool fallbacks and hardware cache misses.",
+			.options = alloc_bench_options,
+			.command_handle_opts = alloc_bench_handle_option,
+			.handle = handle_alloc_bench,
+			.flags = CLI_SU_REQUIRED,
+			.help = NULL,
+		},
+		{
+			.name = "save-hot-set",
+			.desc = "Save most accessed regions of core to file",
+			.long_desc = NULL,
+			.options = save_hot_set_options,
+			.command_handle_opts = hot_set_handle_option,
+			.handle = handle_save_hot_set,
+			.flags = CLI_SU_REQUIRED,
+			.help = NULL,
+		},
+		{
+			.name = "load-hot-set",
+			.desc = "Prefetch regions of core saved with --save-hot-set into cache",
+			.long_desc = NULL,
+			.options = load_hot_set_options,
+			.command_handle_opts = hot_set_handle_option,
+			.handle = handle_load_hot_set,
+			.flags = CLI_SU_REQUIRED,
+			.help = NULL,
+		},
+		{
+			.name = "capture-trace",
+			.desc = "Capture trace of requests of core to be replayed offline",
+			.long_desc = "Capture sector, size, direction, io class and time of requests of core into binary file, to be replayed with cas-trace-sim under alternative cache configurations. Requires cas_cache module to be loaded with io_trace_records parameter.",
+			.options = capture_trace_options,
+			.command_handle_opts = trace_handle_option,
+			.handle = handle_capture_trace,
+			.flags = CLI_SU_REQUIRED,
+			.help = NULL,
+		},
 		{
 			.name = "reset-counters",
 			.short_name = 'Z',
@@ -292,6 +292,29 @@ struct {
 		"The cache contains dirty data assigned to the core. If you want to "
 		"continue, please use --force option.\nWarning: the data will be lost"
 	},
+	{
+		KCAS_ERR_PURGE_IN_PROGRESS,
+		"Purge of the cache is already in progress"
+	},
+	{
+		KCAS_ERR_ASYNC_OP_NOT_EXIST,
+		"Operation with given id does not exist or was already released"
+	},
+	{
+		KCAS_ERR_ASYNC_OPS_LIMIT,
+		"Too many operations running in background"
+	},
+	{
+		KCAS_ERR_IO_CLASS_RESERVED,
+		"Last IO class id is reserved for requests bypassing cache due "
+		"to sequential cutoff overrides or tinylfu promotion policy"
+	},
+	{
+		KCAS_ERR_COMPRESSED_LOAD,
+		"Cache cannot be loaded from compressed cache device, as mapping "
+		"of compressed data is kept in memory only. Start new cache "
+		"on the device instead."
+	},
 	{
 		KCAS_ERR_STANDBY_DETACHED,
 		"Cache device is already in standby detached state."
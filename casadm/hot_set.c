@@ -0,0 +1,197 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <sys/ioctl.h>
+#include "cas_lib.h"
+#include "cas_lib_utils.h"
+#include <cas_ioctl_codes.h>
+#include "hot_set.h"
+#include "prefetch.h"
+
+#define HOT_SET_HEADER "# Open CAS hot set"
+
+/* Upper bound of regions tracked by kernel (hot_set_regions param) */
+#define HOT_SET_REGIONS_MAX (1 << 20)
+
+static int hot_set_write(const char *path, struct kcas_hot_region *regions,
+		uint32_t count)
+{
+	char tmp_path[MAX_STR_LEN];
+	uint32_t i;
+	FILE *out;
+
+	if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >=
+			sizeof(tmp_path)) {
+		cas_printf(LOG_ERR, "Path too long: %s\n", path);
+		return FAILURE;
+	}
+
+	out = fopen(tmp_path, "w");
+	if (!out) {
+		cas_printf(LOG_ERR, "Failed to open %s\n", tmp_path);
+		return FAILURE;
+	}
+
+	fprintf(out, HOT_SET_HEADER ", region %u sectors\n",
+			KCAS_HOT_SET_REGION_SECTORS);
+	fprintf(out, "# sector,count\n");
+	for (i = 0; i < count; i++) {
+		fprintf(out, "%"PRIu64",%"PRIu32"\n", regions[i].sector,
+				regions[i].count);
+	}
+
+	/* Previously saved hot set is kept if anything goes wrong */
+	if (fclose(out) || rename(tmp_path, path)) {
+		cas_printf(LOG_ERR, "Failed to write %s\n", path);
+		unlink(tmp_path);
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+int hot_set_save(uint32_t cache_id, uint16_t core_id, const char *path)
+{
+	struct kcas_get_hot_set cmd;
+	struct kcas_hot_region *regions;
+	int fd, ret;
+
+	regions = calloc(HOT_SET_REGIONS_MAX, sizeof(*regions));
+	if (!regions) {
+		cas_printf(LOG_ERR, "Failed to allocate memory\n");
+		return FAILURE;
+	}
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.cache_id = cache_id;
+	cmd.core_id = core_id;
+	cmd.decay = true;
+	cmd.regions = regions;
+	cmd.regions_count = HOT_SET_REGIONS_MAX;
+
+	fd = open_ctrl_device();
+	if (fd == -1) {
+		free(regions);
+		return FAILURE;
+	}
+
+	if (run_ioctl(fd, KCAS_IOCTL_GET_HOT_SET, &cmd) < 0) {
+		close(fd);
+		free(regions);
+		print_err(cmd.ext_err_code);
+		return FAILURE;
+	}
+	close(fd);
+
+	if (!cmd.enabled) {
+		cas_printf(LOG_ERR, "Hot set is not tracked, load cas_cache "
+				"module with hot_set_regions parameter\n");
+		free(regions);
+		return FAILURE;
+	}
+
+	ret = hot_set_write(path, regions, cmd.regions_count);
+	if (!ret) {
+		cas_printf(LOG_INFO, "Saved %"PRIu32" regions of core %"PRIu16
+				" of cache %"PRIu32"\n", cmd.regions_count,
+				core_id, cache_id);
+	}
+
+	free(regions);
+	return ret;
+}
+
+static int hot_set_read(const char *path, struct kcas_prefetch_range **pranges,
+		uint32_t *pcount)
+{
+	struct kcas_prefetch_range *ranges = NULL, *tmp;
+	uint32_t count = 0, capacity = 0;
+	unsigned long long sector;
+	char line[MAX_STR_LEN];
+	unsigned int lineno = 0;
+	FILE *in;
+
+	in = fopen(path, "r");
+	if (!in) {
+		cas_printf(LOG_ERR, "Failed to open %s\n", path);
+		return FAILURE;
+	}
+
+	while (fgets(line, sizeof(line), in)) {
+		lineno++;
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+
+		if (sscanf(line, "%llu", &sector) != 1) {
+			cas_printf(LOG_ERR, "Invalid line %u of %s\n", lineno,
+					path);
+			goto err;
+		}
+
+		if (count == KCAS_PREFETCH_RANGES_MAX)
+			break;
+
+		if (count == capacity) {
+			capacity = capacity ? capacity * 2 : 1024;
+			tmp = realloc(ranges, capacity * sizeof(*ranges));
+			if (!tmp) {
+				cas_printf(LOG_ERR, "Failed to allocate memory\n");
+				goto err;
+			}
+			ranges = tmp;
+		}
+
+		ranges[count].sector = sector;
+		ranges[count].sectors = KCAS_HOT_SET_REGION_SECTORS;
+		count++;
+	}
+
+	fclose(in);
+	*pranges = ranges;
+	*pcount = count;
+	return SUCCESS;
+
+err:
+	fclose(in);
+	free(ranges);
+	return FAILURE;
+}
+
+int hot_set_load(uint32_t cache_id, uint16_t core_id, const char *path,
+		uint32_t rate_limit)
+{
+	struct kcas_prefetch_range *ranges;
+	uint32_t count;
+	int ret;
+
+	if (hot_set_read(path, &ranges, &count))
+		return FAILURE;
+
+	if (!count) {
+		cas_printf(LOG_INFO, "No regions in %s\n", path);
+		free(ranges);
+		return SUCCESS;
+	}
+
+	/* Hot set of all io classes is prefetched into unclassified one */
+	ret = prefetch_queue(cache_id, core_id, ranges, count, 0, rate_limit);
+	free(ranges);
+	if (ret)
+		return FAILURE;
+
+	cas_printf(LOG_INFO, "Queued prefetch of %"PRIu32" regions of core %"
+			PRIu16" of cache %"PRIu32"\n", count, core_id,
+			cache_id);
+
+	return SUCCESS;
+}
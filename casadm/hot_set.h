@@ -0,0 +1,34 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __HOT_SET_H
+#define __HOT_SET_H
+
+/**
+ * @brief save most accessed regions of core, hottest first
+ *
+ * Access counts are halved by kernel once read, so regardless of how long
+ * the core was running, recent accesses outweigh old ones.
+ *
+ * @param cache_id id of cache
+ * @param core_id id of core
+ * @param path file to be (atomically) replaced with hot set
+ */
+int hot_set_save(uint32_t cache_id, uint16_t core_id, const char *path);
+
+/**
+ * @brief queue background prefetch of regions of core saved earlier by
+ * hot_set_save()
+ *
+ * @param cache_id id of cache
+ * @param core_id id of core
+ * @param path file with saved hot set
+ * @param rate_limit prefetch bandwidth limit of cache in MiB/s, 0 for
+ *        unlimited
+ */
+int hot_set_load(uint32_t cache_id, uint16_t core_id, const char *path,
+		uint32_t rate_limit);
+
+#endif
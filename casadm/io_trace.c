@@ -0,0 +1,183 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include "cas_lib.h"
+#include "cas_lib_utils.h"
+#include <cas_ioctl_codes.h>
+#include "io_trace.h"
+
+#define IO_TRACE_MAGIC "CASTRACE"
+#define IO_TRACE_VERSION 1
+
+/* Interval of taking records from kernel */
+#define IO_TRACE_POLL_MS 100
+
+struct io_trace_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t record_size;
+};
+
+static volatile sig_atomic_t io_trace_stop;
+
+static void io_trace_sig_handler(int x)
+{
+	io_trace_stop = 1;
+}
+
+static int io_trace_record_cmp(const void *a, const void *b)
+{
+	const struct kcas_trace_record *ra = a, *rb = b;
+
+	return (ra->time_ns > rb->time_ns) - (ra->time_ns < rb->time_ns);
+}
+
+static uint64_t io_trace_now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+/* Take all records captured so far and append them to @out, if given */
+static int io_trace_take(int fd, struct kcas_get_trace *cmd,
+		struct kcas_trace_record *records, FILE *out,
+		uint64_t *total, uint64_t *lost)
+{
+	do {
+		cmd->records = records;
+		cmd->records_count = KCAS_TRACE_RECORDS_MAX;
+		cmd->ext_err_code = 0;
+
+		if (run_ioctl(fd, KCAS_IOCTL_GET_TRACE, cmd) < 0) {
+			print_err(cmd->ext_err_code);
+			return FAILURE;
+		}
+
+		if (!cmd->enabled) {
+			cas_printf(LOG_ERR, "Trace is not captured, load "
+					"cas_cache module with io_trace_records "
+					"parameter\n");
+			return FAILURE;
+		}
+
+		if (!out)
+			continue;
+
+		/* Records of separate CPUs come one after another */
+		qsort(records, cmd->records_count, sizeof(*records),
+				io_trace_record_cmp);
+
+		if (fwrite(records, sizeof(*records), cmd->records_count,
+				out) != cmd->records_count) {
+			cas_printf(LOG_ERR, "Failed to write trace\n");
+			return FAILURE;
+		}
+
+		*total += cmd->records_count;
+		*lost += cmd->lost;
+	} while (cmd->records_count == KCAS_TRACE_RECORDS_MAX);
+
+	return SUCCESS;
+}
+
+int io_trace_capture(uint32_t cache_id, uint16_t core_id, const char *path,
+		uint32_t duration)
+{
+	struct io_trace_header header = {
+		.magic = IO_TRACE_MAGIC,
+		.version = IO_TRACE_VERSION,
+		.record_size = sizeof(struct kcas_trace_record),
+	};
+	struct kcas_trace_record *records;
+	struct sigaction action, old_action;
+	struct kcas_get_trace cmd;
+	uint64_t total = 0, lost = 0, end;
+	FILE *out;
+	int fd, ret;
+
+	records = calloc(KCAS_TRACE_RECORDS_MAX, sizeof(*records));
+	if (!records) {
+		cas_printf(LOG_ERR, "Failed to allocate memory\n");
+		return FAILURE;
+	}
+
+	fd = open_ctrl_device();
+	if (fd == -1) {
+		free(records);
+		return FAILURE;
+	}
+
+	out = fopen(path, "w");
+	if (!out) {
+		cas_printf(LOG_ERR, "Failed to open %s\n", path);
+		close(fd);
+		free(records);
+		return FAILURE;
+	}
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.cache_id = cache_id;
+	cmd.core_id = core_id;
+
+	/* Drop records captured before, so that trace starts now */
+	ret = io_trace_take(fd, &cmd, records, NULL, &total, &lost);
+	if (ret)
+		goto close;
+	total = lost = 0;
+
+	if (fwrite(&header, sizeof(header), 1, out) != 1) {
+		cas_printf(LOG_ERR, "Failed to write %s\n", path);
+		ret = FAILURE;
+		goto close;
+	}
+
+	io_trace_stop = 0;
+	action.sa_handler = io_trace_sig_handler;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = 0;
+	sigaction(SIGINT, &action, &old_action);
+
+	end = io_trace_now_ms() + duration * 1000ULL;
+	while (!io_trace_stop && io_trace_now_ms() < end) {
+		usleep(IO_TRACE_POLL_MS * 1000);
+
+		ret = io_trace_take(fd, &cmd, records, out, &total, &lost);
+		if (ret)
+			break;
+	}
+
+	sigaction(SIGINT, &old_action, NULL);
+
+	if (!ret) {
+		cas_printf(LOG_INFO, "Captured %"PRIu64" requests of core %"
+				PRIu16" of cache %"PRIu32", %"PRIu64" lost\n",
+				total, core_id, cache_id, lost);
+		if (lost) {
+			cas_printf(LOG_WARNING, "Increase io_trace_records "
+					"parameter to avoid losing requests\n");
+		}
+	}
+
+close:
+	if (fclose(out) && !ret) {
+		cas_printf(LOG_ERR, "Failed to write %s\n", path);
+		ret = FAILURE;
+	}
+	close(fd);
+	free(records);
+	return ret;
+}
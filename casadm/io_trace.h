@@ -0,0 +1,26 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __IO_TRACE_H
+#define __IO_TRACE_H
+
+/**
+ * @brief capture requests of core into binary trace file to be replayed
+ * offline with cas-trace-sim
+ *
+ * Records are taken from kernel every IO_TRACE_POLL_MS until @duration
+ * expires or capture is interrupted with SIGINT. File starts with
+ * 16 bytes header: magic "CASTRACE", version and size of record, each
+ * 32 bits little endian, followed by struct kcas_trace_record entries.
+ *
+ * @param cache_id id of cache
+ * @param core_id id of core
+ * @param path file to be replaced with trace
+ * @param duration capture time in seconds
+ */
+int io_trace_capture(uint32_t cache_id, uint16_t core_id, const char *path,
+		uint32_t duration);
+
+#endif
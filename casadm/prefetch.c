@@ -0,0 +1,345 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <libgen.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <linux/fs.h>
+#include <linux/fiemap.h>
+#include "cas_lib.h"
+#include "cas_lib_utils.h"
+#include "prefetch.h"
+
+/* Extents retrieved by single FIEMAP call */
+#define PREFETCH_FIEMAP_EXTENTS 256
+
+/* Extents without data of their own on device */
+#define PREFETCH_FIEMAP_SKIP (FIEMAP_EXTENT_UNKNOWN | \
+		FIEMAP_EXTENT_DELALLOC | FIEMAP_EXTENT_ENCODED | \
+		FIEMAP_EXTENT_DATA_ENCRYPTED | FIEMAP_EXTENT_NOT_ALIGNED | \
+		FIEMAP_EXTENT_DATA_INLINE | FIEMAP_EXTENT_DATA_TAIL | \
+		FIEMAP_EXTENT_UNWRITTEN)
+
+#define SECTOR_SHIFT 9
+
+static int prefetch_ranges_add(struct kcas_prefetch_range **pranges,
+		uint32_t *pcount, uint32_t *pcapacity, uint64_t sector,
+		uint64_t sectors)
+{
+	struct kcas_prefetch_range *tmp;
+
+	if (*pcount == KCAS_PREFETCH_RANGES_MAX) {
+		cas_printf(LOG_ERR, "Too many ranges, at most %u are allowed\n",
+				KCAS_PREFETCH_RANGES_MAX);
+		return FAILURE;
+	}
+
+	if (*pcount == *pcapacity) {
+		*pcapacity = *pcapacity ? *pcapacity * 2 : 64;
+		tmp = realloc(*pranges, *pcapacity * sizeof(**pranges));
+		if (!tmp) {
+			cas_printf(LOG_ERR, "Failed to allocate memory\n");
+			return FAILURE;
+		}
+		*pranges = tmp;
+	}
+
+	(*pranges)[*pcount].sector = sector;
+	(*pranges)[*pcount].sectors = sectors;
+	(*pcount)++;
+
+	return SUCCESS;
+}
+
+int prefetch_parse_ranges(const char *str, struct kcas_prefetch_range **pranges,
+		uint32_t *pcount)
+{
+	struct kcas_prefetch_range *ranges = NULL;
+	uint32_t count = 0, capacity = 0;
+	unsigned long long sector, sectors;
+	const char *pos = str;
+	char *end;
+
+	while (*pos) {
+		sector = strtoull(pos, &end, 10);
+		if (end == pos || *end != ':')
+			goto invalid;
+		pos = end + 1;
+
+		sectors = strtoull(pos, &end, 10);
+		if (end == pos || !sectors || (*end && *end != ','))
+			goto invalid;
+		pos = *end ? end + 1 : end;
+
+		if (prefetch_ranges_add(&ranges, &count, &capacity, sector,
+				sectors)) {
+			free(ranges);
+			return FAILURE;
+		}
+	}
+
+	if (!count)
+		goto invalid;
+
+	*pranges = ranges;
+	*pcount = count;
+	return SUCCESS;
+
+invalid:
+	cas_printf(LOG_ERR, "Invalid ranges, expected START:LENGTH[,START:LENGTH...]"
+			" in sectors\n");
+	free(ranges);
+	return FAILURE;
+}
+
+/*
+ * Offset in sectors of device of filesystem holding @path within exported
+ * object of core, which is either that device or its partition
+ */
+static int prefetch_file_offset(const char *path, uint32_t cache_id,
+		uint16_t core_id, uint64_t *offset)
+{
+	char exp_obj[MAX_STR_LEN], sys_path[PATH_MAX], real[PATH_MAX];
+	struct stat file_st, exp_obj_st;
+	unsigned long long start;
+	FILE *f;
+	int ret;
+
+	snprintf(exp_obj, sizeof(exp_obj), "/dev/cas%"PRIu32"-%"PRIu16,
+			cache_id, core_id);
+
+	if (stat(path, &file_st)) {
+		cas_printf(LOG_ERR, "Failed to stat %s\n", path);
+		return FAILURE;
+	}
+
+	if (!S_ISREG(file_st.st_mode)) {
+		cas_printf(LOG_ERR, "%s is not a regular file\n", path);
+		return FAILURE;
+	}
+
+	if (stat(exp_obj, &exp_obj_st) || !S_ISBLK(exp_obj_st.st_mode)) {
+		cas_printf(LOG_ERR, "Failed to stat %s\n", exp_obj);
+		return FAILURE;
+	}
+
+	if (file_st.st_dev == exp_obj_st.st_rdev) {
+		*offset = 0;
+		return SUCCESS;
+	}
+
+	/* Partition is a child of its disk in sysfs */
+	snprintf(sys_path, sizeof(sys_path), "/sys/dev/block/%u:%u",
+			major(file_st.st_dev), minor(file_st.st_dev));
+	if (!realpath(sys_path, real) ||
+			strcmp(basename(dirname(real)), basename(exp_obj))) {
+		cas_printf(LOG_ERR, "%s is not on %s\n", path, exp_obj);
+		return FAILURE;
+	}
+
+	strncat(sys_path, "/start", sizeof(sys_path) - strlen(sys_path) - 1);
+	f = fopen(sys_path, "r");
+	if (!f) {
+		cas_printf(LOG_ERR, "Failed to open %s\n", sys_path);
+		return FAILURE;
+	}
+	ret = fscanf(f, "%llu", &start);
+	fclose(f);
+
+	if (ret != 1) {
+		cas_printf(LOG_ERR, "Failed to read %s\n", sys_path);
+		return FAILURE;
+	}
+
+	*offset = start;
+	return SUCCESS;
+}
+
+/* Resolve file to ranges of core with FIEMAP */
+static int prefetch_file_ranges(const char *path, uint32_t cache_id,
+		uint16_t core_id, struct kcas_prefetch_range **pranges,
+		uint32_t *pcount)
+{
+	struct kcas_prefetch_range *ranges = NULL;
+	uint32_t count = 0, capacity = 0, i;
+	struct fiemap_extent *extent;
+	struct fiemap *fiemap;
+	uint64_t offset;
+	bool last = false;
+	int fd;
+
+	if (prefetch_file_offset(path, cache_id, core_id, &offset))
+		return FAILURE;
+
+	fiemap = calloc(1, sizeof(*fiemap) +
+			PREFETCH_FIEMAP_EXTENTS * sizeof(*fiemap->fm_extents));
+	if (!fiemap) {
+		cas_printf(LOG_ERR, "Failed to allocate memory\n");
+		return FAILURE;
+	}
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		cas_printf(LOG_ERR, "Failed to open %s\n", path);
+		free(fiemap);
+		return FAILURE;
+	}
+
+	fiemap->fm_start = 0;
+	while (!last) {
+		fiemap->fm_length = FIEMAP_MAX_OFFSET - fiemap->fm_start;
+		/* Delayed allocations are flushed to get their extents */
+		fiemap->fm_flags = FIEMAP_FLAG_SYNC;
+		fiemap->fm_extent_count = PREFETCH_FIEMAP_EXTENTS;
+		fiemap->fm_mapped_extents = 0;
+
+		if (ioctl(fd, FS_IOC_FIEMAP, fiemap) < 0) {
+			cas_printf(LOG_ERR, "Failed to get extents of %s\n",
+					path);
+			goto err;
+		}
+
+		if (!fiemap->fm_mapped_extents)
+			break;
+
+		for (i = 0; i < fiemap->fm_mapped_extents; i++) {
+			extent = &fiemap->fm_extents[i];
+			last = extent->fe_flags & FIEMAP_EXTENT_LAST;
+
+			if (extent->fe_flags & PREFETCH_FIEMAP_SKIP)
+				continue;
+
+			if (prefetch_ranges_add(&ranges, &count, &capacity,
+					offset + (extent->fe_physical >>
+						SECTOR_SHIFT),
+					extent->fe_length >> SECTOR_SHIFT))
+				goto err;
+		}
+
+		extent = &fiemap->fm_extents[fiemap->fm_mapped_extents - 1];
+		fiemap->fm_start = extent->fe_logical + extent->fe_length;
+	}
+
+	close(fd);
+	free(fiemap);
+
+	if (!count) {
+		cas_printf(LOG_ERR, "%s has no data on device\n", path);
+		free(ranges);
+		return FAILURE;
+	}
+
+	*pranges = ranges;
+	*pcount = count;
+	return SUCCESS;
+
+err:
+	close(fd);
+	free(fiemap);
+	free(ranges);
+	return FAILURE;
+}
+
+static int prefetch_ioctl(struct kcas_prefetch *cmd)
+{
+	int fd;
+
+	fd = open_ctrl_device();
+	if (fd == -1)
+		return FAILURE;
+
+	if (run_ioctl(fd, KCAS_IOCTL_PREFETCH, cmd) < 0) {
+		close(fd);
+		print_err(cmd->ext_err_code);
+		return FAILURE;
+	}
+	close(fd);
+
+	return SUCCESS;
+}
+
+int prefetch_queue(uint32_t cache_id, uint16_t core_id,
+		struct kcas_prefetch_range *ranges, uint32_t count,
+		uint32_t io_class, uint32_t rate_limit)
+{
+	struct kcas_prefetch cmd;
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.cache_id = cache_id;
+	cmd.core_id = core_id;
+	cmd.ranges = ranges;
+	cmd.ranges_count = count;
+	cmd.io_class = io_class;
+	cmd.rate_limit = rate_limit;
+
+	return prefetch_ioctl(&cmd);
+}
+
+/* Poll progress of all prefetch of cache until nothing is pending */
+static int prefetch_wait(uint32_t cache_id)
+{
+	struct kcas_prefetch cmd;
+
+	do {
+		sleep(1);
+
+		memset(&cmd, 0, sizeof(cmd));
+		cmd.cache_id = cache_id;
+		if (prefetch_ioctl(&cmd))
+			return FAILURE;
+
+		cas_printf(LOG_INFO, "Pending: %"PRIu64" MiB, done: %"PRIu64
+				" MiB, failed: %"PRIu64" MiB\n",
+				cmd.pending_sectors >> 11,
+				cmd.done_sectors >> 11,
+				cmd.failed_sectors >> 11);
+	} while (cmd.pending_sectors);
+
+	return cmd.failed_sectors ? FAILURE : SUCCESS;
+}
+
+int prefetch(uint32_t cache_id, uint16_t core_id,
+		struct kcas_prefetch_range *ranges, uint32_t count,
+		const char *path, uint32_t io_class, uint32_t rate_limit,
+		bool wait)
+{
+	struct kcas_prefetch_range *file_ranges = NULL;
+	uint64_t sectors = 0;
+	uint32_t i;
+	int ret;
+
+	if (path) {
+		if (prefetch_file_ranges(path, cache_id, core_id,
+				&file_ranges, &count))
+			return FAILURE;
+		ranges = file_ranges;
+	}
+
+	for (i = 0; i < count; i++)
+		sectors += ranges[i].sectors;
+
+	ret = prefetch_queue(cache_id, core_id, ranges, count, io_class,
+			rate_limit);
+	free(file_ranges);
+	if (ret)
+		return FAILURE;
+
+	cas_printf(LOG_INFO, "Queued prefetch of %"PRIu32" ranges (%"PRIu64
+			" MiB) of core %"PRIu16" of cache %"PRIu32"\n", count,
+			sectors >> 11, core_id, cache_id);
+
+	return wait ? prefetch_wait(cache_id) : SUCCESS;
+}
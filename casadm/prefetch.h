@@ -0,0 +1,55 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __PREFETCH_H
+#define __PREFETCH_H
+
+#include <cas_ioctl_codes.h>
+
+/**
+ * @brief queue background prefetch of ranges of core into cache
+ *
+ * @param cache_id id of cache
+ * @param core_id id of core
+ * @param ranges ranges of core in sectors
+ * @param count number of ranges
+ * @param io_class io class which ranges are inserted into
+ * @param rate_limit prefetch bandwidth limit of cache in MiB/s, 0 for
+ *        unlimited
+ */
+int prefetch_queue(uint32_t cache_id, uint16_t core_id,
+		struct kcas_prefetch_range *ranges, uint32_t count,
+		uint32_t io_class, uint32_t rate_limit);
+
+/**
+ * @brief parse list of ranges of core
+ *
+ * @param str comma separated list of START:LENGTH pairs in sectors
+ * @param pranges allocated ranges, to be freed by caller
+ * @param pcount number of ranges
+ */
+int prefetch_parse_ranges(const char *str, struct kcas_prefetch_range **pranges,
+		uint32_t *pcount);
+
+/**
+ * @brief prefetch ranges of core or extents of file on exported object
+ *
+ * @param cache_id id of cache
+ * @param core_id id of core
+ * @param ranges ranges of core in sectors, NULL if @path is given
+ * @param count number of ranges
+ * @param path file on filesystem on exported object of core (or on its
+ *        partition), NULL if @ranges are given
+ * @param io_class io class which ranges are inserted into
+ * @param rate_limit prefetch bandwidth limit of cache in MiB/s, 0 for
+ *        unlimited
+ * @param wait wait for all prefetch of cache to finish, printing progress
+ */
+int prefetch(uint32_t cache_id, uint16_t core_id,
+		struct kcas_prefetch_range *ranges, uint32_t count,
+		const char *path, uint32_t io_class, uint32_t rate_limit,
+		bool wait);
+
+#endif
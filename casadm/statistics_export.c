@@ -0,0 +1,499 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <sys/ioctl.h>
+#include "cas_lib.h"
+#include "cas_lib_utils.h"
+#include <cas_ioctl_codes.h>
+#include "statistics_export.h"
+
+#define EXPORT_PREFIX "opencas_"
+#define EXPORT_BLOCK_BYTES 4096ULL
+
+/* Statistics of one cache retrieved in single bulk call */
+struct export_cache {
+	struct kcas_cache_info info;
+	struct kcas_get_stats *entries;
+	uint32_t count;
+	/* Statistics of cgroups, NULL if not collected */
+	struct kcas_cgroup_stats *cgroups;
+	uint32_t cgroups_count;
+};
+
+enum export_object {
+	EXPORT_CACHE,
+	EXPORT_CORE,
+	EXPORT_IO_CLASS,
+	EXPORT_SKIP,
+};
+
+/* Sample of metric family taken from ocf_stat value field of stats entry */
+struct export_field {
+	const char *labels;
+	size_t offset;
+	uint64_t scale;
+};
+
+struct export_family {
+	const char *name;
+	const char *type;
+	const char *help;
+	/* Objects of which the family is exported, bitmask */
+	uint32_t objects;
+	const struct export_field *fields;
+};
+
+#define EXPORT_STAT(__labels, __field, __scale) { \
+	.labels = __labels, \
+	.offset = offsetof(struct kcas_get_stats, __field.value), \
+	.scale = __scale, \
+}
+
+#define EXPORT_ALL ((1 << EXPORT_CACHE) | (1 << EXPORT_CORE) | \
+		(1 << EXPORT_IO_CLASS))
+#define EXPORT_NO_IO_CLASS ((1 << EXPORT_CACHE) | (1 << EXPORT_CORE))
+
+static const struct export_field export_requests[] = {
+	EXPORT_STAT("type=\"rd_hits\"", req.rd_hits, 1),
+	EXPORT_STAT("type=\"rd_partial_misses\"", req.rd_partial_misses, 1),
+	EXPORT_STAT("type=\"rd_full_misses\"", req.rd_full_misses, 1),
+	EXPORT_STAT("type=\"rd_pt\"", req.rd_pt, 1),
+	EXPORT_STAT("type=\"wr_hits\"", req.wr_hits, 1),
+	EXPORT_STAT("type=\"wr_partial_misses\"", req.wr_partial_misses, 1),
+	EXPORT_STAT("type=\"wr_full_misses\"", req.wr_full_misses, 1),
+	EXPORT_STAT("type=\"wr_pt\"", req.wr_pt, 1),
+	{ NULL }
+};
+
+static const struct export_field export_bytes[] = {
+	EXPORT_STAT("device=\"exported\",dir=\"read\"", blocks.volume_rd,
+			EXPORT_BLOCK_BYTES),
+	EXPORT_STAT("device=\"exported\",dir=\"write\"", blocks.volume_wr,
+			EXPORT_BLOCK_BYTES),
+	EXPORT_STAT("device=\"cache\",dir=\"read\"", blocks.cache_volume_rd,
+			EXPORT_BLOCK_BYTES),
+	EXPORT_STAT("device=\"cache\",dir=\"write\"", blocks.cache_volume_wr,
+			EXPORT_BLOCK_BYTES),
+	EXPORT_STAT("device=\"core\",dir=\"read\"", blocks.core_volume_rd,
+			EXPORT_BLOCK_BYTES),
+	EXPORT_STAT("device=\"core\",dir=\"write\"", blocks.core_volume_wr,
+			EXPORT_BLOCK_BYTES),
+	{ NULL }
+};
+
+static const struct export_field export_errors[] = {
+	EXPORT_STAT("device=\"cache\",dir=\"read\"", errors.cache_volume_rd, 1),
+	EXPORT_STAT("device=\"cache\",dir=\"write\"", errors.cache_volume_wr, 1),
+	EXPORT_STAT("device=\"core\",dir=\"read\"", errors.core_volume_rd, 1),
+	EXPORT_STAT("device=\"core\",dir=\"write\"", errors.core_volume_wr, 1),
+	{ NULL }
+};
+
+static const struct export_field export_usage[] = {
+	EXPORT_STAT("state=\"occupancy\"", usage.occupancy, EXPORT_BLOCK_BYTES),
+	EXPORT_STAT("state=\"clean\"", usage.clean, EXPORT_BLOCK_BYTES),
+	EXPORT_STAT("state=\"dirty\"", usage.dirty, EXPORT_BLOCK_BYTES),
+	{ NULL }
+};
+
+static const struct export_family export_families[] = {
+	{
+		.name = "requests_total",
+		.type = "counter",
+		.help = "Requests by result",
+		.objects = EXPORT_ALL,
+		.fields = export_requests,
+	},
+	{
+		.name = "bytes_total",
+		.type = "counter",
+		.help = "Bytes transferred by device and direction",
+		.objects = EXPORT_ALL,
+		.fields = export_bytes,
+	},
+	{
+		.name = "errors_total",
+		.type = "counter",
+		.help = "I/O errors by device and direction",
+		.objects = EXPORT_NO_IO_CLASS,
+		.fields = export_errors,
+	},
+	{
+		.name = "usage_bytes",
+		.type = "gauge",
+		.help = "Cache space by state",
+		.objects = EXPORT_ALL,
+		.fields = export_usage,
+	},
+	{ NULL }
+};
+
+static const char *export_object_names[] = {
+	[EXPORT_CACHE] = "cache",
+	[EXPORT_CORE] = "core",
+	[EXPORT_IO_CLASS] = "io_class",
+	[EXPORT_SKIP] = NULL,
+};
+
+/*
+ * Cache level io class entries are sums of per core ones, so only the
+ * latter are exported not to count them twice.
+ */
+static enum export_object export_entry_object(const struct kcas_get_stats *e)
+{
+	if (e->core_id == OCF_CORE_ID_INVALID)
+		return e->part_id == OCF_IO_CLASS_INVALID ? EXPORT_CACHE :
+				EXPORT_SKIP;
+
+	return e->part_id == OCF_IO_CLASS_INVALID ? EXPORT_CORE :
+			EXPORT_IO_CLASS;
+}
+
+static void export_labels(FILE *out, const struct kcas_get_stats *e,
+		enum export_object object)
+{
+	fprintf(out, "cache=\"%u\"", e->cache_id);
+	if (object != EXPORT_CACHE)
+		fprintf(out, ",core=\"%u\"", e->core_id);
+	if (object == EXPORT_IO_CLASS)
+		fprintf(out, ",io_class=\"%u\"", e->part_id);
+}
+
+static void export_family(FILE *out, const struct export_family *family,
+		enum export_object object, const struct export_cache *caches,
+		int caches_count)
+{
+	const struct export_field *field;
+	const struct kcas_get_stats *e;
+	uint64_t value;
+	uint32_t i;
+	int c;
+
+	fprintf(out, "# HELP " EXPORT_PREFIX "%s_%s %s\n",
+			export_object_names[object], family->name, family->help);
+	fprintf(out, "# TYPE " EXPORT_PREFIX "%s_%s %s\n",
+			export_object_names[object], family->name, family->type);
+
+	for (c = 0; c < caches_count; c++) {
+		for (i = 0; i < caches[c].count; i++) {
+			e = &caches[c].entries[i];
+			if (export_entry_object(e) != object)
+				continue;
+
+			for (field = family->fields; field->labels; field++) {
+				value = *(const uint64_t *)((const char *)e +
+						field->offset);
+				fprintf(out, EXPORT_PREFIX "%s_%s{",
+						export_object_names[object],
+						family->name);
+				export_labels(out, e, object);
+				fprintf(out, ",%s} %llu\n", field->labels,
+						(unsigned long long)value * field->scale);
+			}
+		}
+	}
+}
+
+static void export_cache_metric(FILE *out, const char *name,
+		const char *type, const char *help,
+		const struct export_cache *caches, int caches_count,
+		uint64_t (*get)(const struct kcas_cache_info *info))
+{
+	int c;
+
+	fprintf(out, "# HELP " EXPORT_PREFIX "cache_%s %s\n", name, help);
+	fprintf(out, "# TYPE " EXPORT_PREFIX "cache_%s %s\n", name, type);
+	for (c = 0; c < caches_count; c++) {
+		fprintf(out, EXPORT_PREFIX "cache_%s{cache=\"%u\"} %llu\n",
+				name, caches[c].info.cache_id,
+				(unsigned long long)get(&caches[c].info));
+	}
+}
+
+#define EXPORT_CACHE_GETTER(__name, __expr) \
+	static uint64_t export_get_##__name(const struct kcas_cache_info *info) \
+	{ \
+		return __expr; \
+	}
+
+EXPORT_CACHE_GETTER(size, info->info.size * info->info.cache_line_size)
+EXPORT_CACHE_GETTER(dirty_for, info->info.dirty_for)
+EXPORT_CACHE_GETTER(core_count, info->info.core_count)
+EXPORT_CACHE_GETTER(cleaner_passes, info->cleaner.passes)
+EXPORT_CACHE_GETTER(cleaner_bytes, info->cleaner.bytes_cleaned)
+EXPORT_CACHE_GETTER(cleaner_kicks, info->cleaner.kicks)
+EXPORT_CACHE_GETTER(cleaner_rate,
+		info->cleaner.rate * info->info.cache_line_size)
+
+static void export_cgroup_labels(FILE *out, uint32_t cache_id,
+		const struct kcas_cgroup_stats *e)
+{
+	if (e->cgroup_id == KCAS_CGROUP_ID_OTHER) {
+		fprintf(out, "cache=\"%u\",cgroup=\"other\"", cache_id);
+		return;
+	}
+
+	fprintf(out, "cache=\"%u\",cgroup=\"%llu\"", cache_id,
+			(unsigned long long)e->cgroup_id);
+}
+
+static void export_cgroups(FILE *out, const struct export_cache *caches,
+		int caches_count)
+{
+	const struct kcas_cgroup_stats *e;
+	uint32_t i;
+	int c;
+
+	fprintf(out, "# HELP " EXPORT_PREFIX "cgroup_requests_total "
+			"Requests of cgroup by result\n");
+	fprintf(out, "# TYPE " EXPORT_PREFIX "cgroup_requests_total "
+			"counter\n");
+	for (c = 0; c < caches_count; c++) {
+		for (i = 0; i < caches[c].cgroups_count; i++) {
+			e = &caches[c].cgroups[i];
+			fprintf(out, EXPORT_PREFIX "cgroup_requests_total{");
+			export_cgroup_labels(out, caches[c].info.cache_id, e);
+			fprintf(out, ",type=\"rd_hits\"} %llu\n",
+					(unsigned long long)e->read_hits);
+			fprintf(out, EXPORT_PREFIX "cgroup_requests_total{");
+			export_cgroup_labels(out, caches[c].info.cache_id, e);
+			fprintf(out, ",type=\"rd_misses\"} %llu\n",
+					(unsigned long long)e->read_misses);
+			fprintf(out, EXPORT_PREFIX "cgroup_requests_total{");
+			export_cgroup_labels(out, caches[c].info.cache_id, e);
+			fprintf(out, ",type=\"wr\"} %llu\n",
+					(unsigned long long)e->writes);
+		}
+	}
+
+	fprintf(out, "# HELP " EXPORT_PREFIX "cgroup_bytes_total "
+			"Bytes transferred by cgroup and direction\n");
+	fprintf(out, "# TYPE " EXPORT_PREFIX "cgroup_bytes_total "
+			"counter\n");
+	for (c = 0; c < caches_count; c++) {
+		for (i = 0; i < caches[c].cgroups_count; i++) {
+			e = &caches[c].cgroups[i];
+			fprintf(out, EXPORT_PREFIX "cgroup_bytes_total{");
+			export_cgroup_labels(out, caches[c].info.cache_id, e);
+			fprintf(out, ",dir=\"read\"} %llu\n",
+					(unsigned long long)e->read_bytes);
+			fprintf(out, EXPORT_PREFIX "cgroup_bytes_total{");
+			export_cgroup_labels(out, caches[c].info.cache_id, e);
+			fprintf(out, ",dir=\"write\"} %llu\n",
+					(unsigned long long)e->write_bytes);
+		}
+	}
+}
+
+static void export_write(FILE *out, const struct export_cache *caches,
+		int caches_count)
+{
+	const struct export_family *family;
+	enum export_object object;
+
+	for (family = export_families; family->name; family++) {
+		for (object = EXPORT_CACHE; object <= EXPORT_IO_CLASS; object++) {
+			if (family->objects & (1 << object)) {
+				export_family(out, family, object, caches,
+						caches_count);
+			}
+		}
+	}
+
+	export_cache_metric(out, "size_bytes", "gauge", "Cache size",
+			caches, caches_count, export_get_size);
+	export_cache_metric(out, "dirty_for_seconds", "gauge",
+			"Time cache has been dirty for", caches, caches_count,
+			export_get_dirty_for);
+	export_cache_metric(out, "cores", "gauge", "Number of core devices",
+			caches, caches_count, export_get_core_count);
+	export_cache_metric(out, "cleaner_passes_total", "counter",
+			"Cleaning passes", caches, caches_count,
+			export_get_cleaner_passes);
+	export_cache_metric(out, "cleaner_bytes_total", "counter",
+			"Bytes written back by cleaner (approximate)", caches,
+			caches_count, export_get_cleaner_bytes);
+	export_cache_metric(out, "cleaner_kicks_total", "counter",
+			"Cleaner kicks", caches, caches_count,
+			export_get_cleaner_kicks);
+	export_cache_metric(out, "cleaner_rate_bytes", "gauge",
+			"Recent cleaning rate in bytes per second", caches,
+			caches_count, export_get_cleaner_rate);
+	export_cgroups(out, caches, caches_count);
+}
+
+static void export_free(struct export_cache *caches, int caches_count)
+{
+	int c;
+
+	for (c = 0; c < caches_count; c++) {
+		free(caches[c].entries);
+		free(caches[c].cgroups);
+	}
+	free(caches);
+}
+
+/* Retrieve stats of all caches, cores and io classes, one call per cache */
+static int export_collect(int ctrl_fd, struct export_cache **pcaches,
+		int *pcount)
+{
+	struct kcas_get_stats_bulk bulk;
+	struct export_cache *caches, *cache;
+	uint32_t *cache_ids;
+	int count, c, n = 0;
+
+	cache_ids = get_cache_ids_fd(ctrl_fd, &count);
+	if (!cache_ids) {
+		*pcaches = NULL;
+		*pcount = 0;
+		return SUCCESS;
+	}
+
+	caches = calloc(count, sizeof(*caches));
+	if (!caches) {
+		free(cache_ids);
+		return FAILURE;
+	}
+
+	for (c = 0; c < count; c++) {
+		cache = &caches[n];
+		cache->info.cache_id = cache_ids[c];
+
+		/* Cache may be stopped meanwhile */
+		if (ioctl(ctrl_fd, KCAS_IOCTL_CACHE_INFO, &cache->info) < 0)
+			continue;
+
+		/* Standby cache has no statistics */
+		if (cache->info.info.state & (1 << ocf_cache_state_standby))
+			continue;
+
+		cache->count = (cache->info.info.core_count + 1) *
+				(OCF_USER_IO_CLASS_MAX + 1);
+		cache->entries = calloc(cache->count, sizeof(*cache->entries));
+		if (!cache->entries)
+			goto err;
+
+		/* Tracked cgroups and the one summing the rest */
+		cache->cgroups_count = KCAS_CGROUP_STATS_MAX + 1;
+		cache->cgroups = calloc(cache->cgroups_count,
+				sizeof(*cache->cgroups));
+		if (!cache->cgroups) {
+			free(cache->entries);
+			cache->entries = NULL;
+			goto err;
+		}
+
+		memset(&bulk, 0, sizeof(bulk));
+		bulk.cache_id = cache_ids[c];
+		bulk.core_id = OCF_CORE_ID_INVALID;
+		bulk.io_classes = true;
+		bulk.entries_count = cache->count;
+		bulk.entries = cache->entries;
+		bulk.cgroup_entries_count = cache->cgroups_count;
+		bulk.cgroup_entries = cache->cgroups;
+
+		if (ioctl(ctrl_fd, KCAS_IOCTL_GET_STATS_BULK, &bulk) < 0) {
+			free(cache->entries);
+			cache->entries = NULL;
+			free(cache->cgroups);
+			cache->cgroups = NULL;
+			continue;
+		}
+
+		if (bulk.entries_count < cache->count)
+			cache->count = bulk.entries_count;
+		if (!bulk.cgroup_stats)
+			cache->cgroups_count = 0;
+		else if (bulk.cgroup_entries_count < cache->cgroups_count)
+			cache->cgroups_count = bulk.cgroup_entries_count;
+		n++;
+	}
+
+	free(cache_ids);
+	*pcaches = caches;
+	*pcount = n;
+	return SUCCESS;
+
+err:
+	free(cache_ids);
+	export_free(caches, n);
+	return FAILURE;
+}
+
+/* Replace file with new metrics at once, so scraper never sees partial */
+static int export_to_file(const char *path, struct export_cache *caches,
+		int caches_count)
+{
+	char tmp_path[MAX_STR_LEN];
+	FILE *out;
+
+	if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >=
+			sizeof(tmp_path)) {
+		cas_printf(LOG_ERR, "Path too long: %s\n", path);
+		return FAILURE;
+	}
+
+	out = fopen(tmp_path, "w");
+	if (!out) {
+		cas_printf(LOG_ERR, "Failed to open %s\n", tmp_path);
+		return FAILURE;
+	}
+
+	export_write(out, caches, caches_count);
+
+	if (fclose(out) || rename(tmp_path, path)) {
+		cas_printf(LOG_ERR, "Failed to write %s\n", path);
+		unlink(tmp_path);
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+int cache_stats_export(const char *path, uint32_t interval)
+{
+	struct export_cache *caches;
+	int ctrl_fd, caches_count;
+	int ret = SUCCESS;
+
+	ctrl_fd = open_ctrl_device();
+	if (ctrl_fd < 0) {
+		print_err(KCAS_ERR_SYSTEM);
+		return FAILURE;
+	}
+
+	do {
+		if (export_collect(ctrl_fd, &caches, &caches_count)) {
+			cas_printf(LOG_ERR, "Failed to allocate memory\n");
+			ret = FAILURE;
+			break;
+		}
+
+		if (path) {
+			ret = export_to_file(path, caches, caches_count);
+		} else {
+			export_write(stdout, caches, caches_count);
+			fflush(stdout);
+		}
+
+		export_free(caches, caches_count);
+
+		if (ret)
+			break;
+
+		if (interval)
+			sleep(interval);
+	} while (interval);
+
+	close(ctrl_fd);
+	return ret;
+}
@@ -0,0 +1,20 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __STATISTICS_EXPORT_H
+#define __STATISTICS_EXPORT_H
+
+/**
+ * @brief export statistics of all caches, cores and io classes in
+ * Prometheus text exposition format
+ *
+ * @param path file to be (atomically) replaced with metrics, NULL to print
+ *        them to standard output
+ * @param interval period in seconds of refreshing the metrics until
+ *        interrupted, 0 to export them once
+ */
+int cache_stats_export(const char *path, uint32_t interval);
+
+#endif
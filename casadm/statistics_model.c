@@ -31,6 +31,7 @@
 
 #include "csvparse.h"
 #include "statistics_view.h"
+#include "vt100codes.h"
 #include "safeclib/safe_str_lib.h"
 #include "ocf/ocf_cache.h"
 
@@ -471,7 +472,9 @@ int cache_stats_ioclasses(int ctrl_fd, const struct kcas_cache_info *cache_info,
 {
 	struct kcas_io_class info = {};
 	struct kcas_get_stats stats = {};
-	int part_iter_id;
+	struct kcas_get_stats_bulk bulk = {};
+	struct kcas_get_stats *entries;
+	uint32_t i;
 	bool cache_stats = (core_id == OCF_CORE_ID_INVALID);
 	int ret;
 
@@ -503,35 +506,92 @@ int cache_stats_ioclasses(int ctrl_fd, const struct kcas_cache_info *cache_info,
 		return SUCCESS;
 	}
 
-	for (part_iter_id = 0; part_iter_id < OCF_USER_IO_CLASS_MAX; part_iter_id++) {
-		info.cache_id = cache_id;
-		info.class_id = part_iter_id;
-		stats.cache_id = cache_id;
-		stats.core_id = core_id;
-		stats.part_id = part_iter_id;
+	/* Retrieve statistics of all configured io classes at once */
+	entries = calloc(OCF_USER_IO_CLASS_MAX + 1, sizeof(*entries));
+	if (!entries) {
+		cas_printf(LOG_ERR, "Failed to allocate memory\n");
+		return FAILURE;
+	}
 
-		ret = ioctl(ctrl_fd, KCAS_IOCTL_PARTITION_INFO, &info);
-		if (info.ext_err_code  == OCF_ERR_IO_CLASS_NOT_EXIST)
+	bulk.cache_id = cache_id;
+	bulk.core_id = core_id;
+	bulk.io_classes = true;
+	bulk.entries_count = OCF_USER_IO_CLASS_MAX + 1;
+	bulk.entries = entries;
+
+	if (ioctl(ctrl_fd, KCAS_IOCTL_GET_STATS_BULK, &bulk) < 0) {
+		print_err(bulk.ext_err_code);
+		ret = FAILURE;
+		goto out;
+	}
+
+	for (i = 0; i < bulk.entries_count; i++) {
+		/* Skip statistics of the cache/core itself */
+		if (entries[i].part_id == OCF_IO_CLASS_INVALID)
 			continue;
-		else if (ret) {
-			print_err(info.ext_err_code);
-			return FAILURE;
-		}
 
-		ret = ioctl(ctrl_fd, KCAS_IOCTL_GET_STATS, &stats);
-		if (ret)
-			return FAILURE;
+		memset(&info, 0, sizeof(info));
+		info.cache_id = cache_id;
+		info.class_id = entries[i].part_id;
+
+		if (stats_filters & STATS_FILTER_CONF) {
+			ret = ioctl(ctrl_fd, KCAS_IOCTL_PARTITION_INFO, &info);
+			if (info.ext_err_code == OCF_ERR_IO_CLASS_NOT_EXIST) {
+				/* IO class removed in the meantime */
+				ret = SUCCESS;
+				continue;
+			} else if (ret) {
+				print_err(info.ext_err_code);
+				ret = FAILURE;
+				goto out;
+			}
+		}
 
 		begin_record(outfile);
 
-		print_stats_ioclass(&info, &stats, cache_stats,
+		print_stats_ioclass(&info, &entries[i], cache_stats,
 				outfile, stats_filters);
-
-		memset(&stats, 0, sizeof(stats));
-		memset(&info, 0, sizeof(info));
 	}
 
-	return SUCCESS;
+	ret = SUCCESS;
+out:
+	free(entries);
+	return ret;
+}
+
+/**
+ * @brief print cleaner activity and estimated time to clean all dirty data
+ * at current cleaning rate
+ */
+static void print_cleaner_stats(const struct kcas_cache_info *cache_info,
+		FILE *outfile)
+{
+	const struct kcas_cleaner_stats *cleaner = &cache_info->cleaner;
+	uint64_t line_size = cache_info->info.cache_line_size;
+
+	print_kv_pair(outfile, "Cleaner passes", "%lu", cleaner->passes);
+	print_kv_pair(outfile, "Cleaner kicks", "%lu", cleaner->kicks);
+	print_kv_pair(outfile, "Cleaner lines per pass", "%.1f",
+		      cleaner->passes ? (float)cleaner->lines_cleaned /
+		      cleaner->passes : 0.f);
+	print_kv_pair(outfile, "Cleaner written back", "%.2f, [GiB]",
+		      (float)cleaner->bytes_cleaned / GiB);
+	print_kv_pair(outfile, "Cleaner avg pass duration", "%.1f, [ms]",
+		      cleaner->passes ? cleaner->pass_ns / 1e6f /
+		      cleaner->passes : 0.f);
+	print_kv_pair(outfile, "Cleaner time sleeping", "%.1f, [s]",
+		      cleaner->sleep_ns / 1e9f);
+	print_kv_pair(outfile, "Cleaner rate", "%.2f, [MiB/s]",
+		      (float)cleaner->rate * line_size / MiB);
+
+	if (!cache_info->info.dirty) {
+		print_kv_pair(outfile, "Time to clean", "0");
+	} else if (!cleaner->rate) {
+		print_kv_pair(outfile, "Time to clean", "-");
+	} else {
+		print_kv_pair_time(outfile, "Time to clean",
+				   cache_info->info.dirty / cleaner->rate);
+	}
 }
 
 int cache_stats_conf(int ctrl_fd, const struct kcas_cache_info *cache_info,
@@ -584,14 +644,23 @@ int cache_stats_conf(int ctrl_fd, const struct kcas_cache_info *cache_info,
 		return FAILURE;
 	print_kv_pair(outfile, "Inactive Core Devices", "%d", inactive_cores);
 
-	print_kv_pair(outfile, "Write Policy", "%s", standby ? "-" :
-		      cache_mode_to_name(cache_info->info.cache_mode));
+	if (!standby && cache_info->mode_drain_from != ocf_cache_mode_none) {
+		print_kv_pair(outfile, "Write Policy", "%s->%s",
+			      cache_mode_to_name(cache_info->mode_drain_from),
+			      cache_mode_to_name(cache_info->info.cache_mode));
+	} else {
+		print_kv_pair(outfile, "Write Policy", "%s", standby ? "-" :
+			      cache_mode_to_name(cache_info->info.cache_mode));
+	}
 	print_kv_pair(outfile, "Cleaning Policy", "%s", standby ? "-" :
 		      cleaning_policy_to_name(cache_info->info.cleaning_policy));
 	print_kv_pair(outfile, "Promotion Policy", "%s", standby ? "-" :
 		      promotion_policy_to_name(cache_info->info.promotion_policy));
 	print_kv_pair(outfile, "Cache line size", "%llu, [KiB]",
 		      cache_info->info.cache_line_size / KiB);
+	/* 0 - cache device does not support untorn writes */
+	print_kv_pair(outfile, "Atomic write unit", "%"PRIu32", [KiB]",
+		      cache_info->atomic_write_unit / KiB);
 
 	metadata_memory_footprint(cache_info->info.metadata_footprint,
 				  &value, &units);
@@ -600,6 +669,9 @@ int cache_stats_conf(int ctrl_fd, const struct kcas_cache_info *cache_info,
 
 	print_kv_pair_time(outfile, "Dirty for", cache_info->info.dirty_for);
 
+	if (!standby)
+		print_cleaner_stats(cache_info, outfile);
+
 	if (flush_progress) {
 		print_kv_pair(outfile, "Status", "%s (%3.1f %%)",
 			      "Flushing", flush_progress);
@@ -698,6 +770,504 @@ int cache_stats_cores(int ctrl_fd, const struct kcas_cache_info *cache_info,
 	return SUCCESS;
 }
 
+/* Upper bound in ns of latency histogram bucket */
+static uint64_t lat_hist_bucket_end(uint32_t bucket)
+{
+	uint32_t group = bucket >> KCAS_LAT_HIST_SUB_BITS;
+	uint64_t sub = bucket & ((1 << KCAS_LAT_HIST_SUB_BITS) - 1);
+
+	if (group == 0) {
+		return (sub + 1) << (KCAS_LAT_HIST_MIN_SHIFT -
+				KCAS_LAT_HIST_SUB_BITS);
+	}
+
+	return ((1 << KCAS_LAT_HIST_SUB_BITS) + sub + 1) <<
+		(group - 1 + KCAS_LAT_HIST_MIN_SHIFT - KCAS_LAT_HIST_SUB_BITS);
+}
+
+/* Latency in us below which given per mille of requests completed */
+static float lat_hist_percentile(const struct kcas_lat_hist *hist,
+		uint64_t count, uint32_t per_mille)
+{
+	uint64_t target = (count * per_mille + 999) / 1000;
+	uint64_t sum = 0;
+	uint32_t i;
+
+	for (i = 0; i < KCAS_LAT_HIST_BUCKETS - 1; i++) {
+		sum += hist->buckets[i];
+		if (sum >= target)
+			break;
+	}
+
+	return lat_hist_bucket_end(i) / 1000.f;
+}
+
+static void print_lat_hist_row(FILE *outfile, const char *title,
+		const struct kcas_lat_hist *hist)
+{
+	uint64_t count = 0;
+	uint32_t i;
+
+	for (i = 0; i < KCAS_LAT_HIST_BUCKETS; i++)
+		count += hist->buckets[i];
+
+	fprintf(outfile, TAG(TABLE_ROW) "\"%s\",%lu,", title, count);
+	if (count) {
+		fprintf(outfile, "%.1f,%.1f,%.1f",
+				lat_hist_percentile(hist, count, 500),
+				lat_hist_percentile(hist, count, 990),
+				lat_hist_percentile(hist, count, 999));
+	} else {
+		fprintf(outfile, "-,-,-");
+	}
+	fprintf(outfile, ",\"[us]\"\n");
+}
+
+static void cache_stats_stages(const struct kcas_get_lat_hist *lat,
+		FILE *outfile)
+{
+	static const char *stage_names[KCAS_IO_STAGE_MAX] = {
+		[KCAS_IO_STAGE_CLASSIFY] = "classification",
+		[KCAS_IO_STAGE_SUBMIT] = "submission to OCF",
+		[KCAS_IO_STAGE_OCF] = "OCF queue and locks",
+		[KCAS_IO_STAGE_DEVICE] = "cache/core device",
+		[KCAS_IO_STAGE_COMPLETE] = "completion",
+	};
+	static const char *dir_names[2] = { "Reads", "Writes" };
+	char title[64];
+	int dir, stage;
+
+	print_table_header(outfile, 6, "Stage latency statistics", "Count",
+			   "p50", "p99", "p99.9", "[Units]");
+
+	for (dir = 0; dir < 2; dir++) {
+		for (stage = 0; stage < KCAS_IO_STAGE_MAX; stage++) {
+			snprintf(title, sizeof(title), "%s: %s",
+					dir_names[dir], stage_names[stage]);
+			print_lat_hist_row(outfile, title,
+					&lat->stage[dir][stage]);
+		}
+	}
+}
+
+/**
+ * @brief print latency percentiles of cache/core requests
+ *
+ * Cache device latencies are cache wide even if statistics of particular
+ * core are printed, and they are not split by io class.
+ */
+static int cache_stats_latency(int ctrl_fd, uint32_t cache_id,
+		unsigned int core_id, int io_class_id, FILE *outfile)
+{
+	struct kcas_get_lat_hist *lat;
+	int ret = SUCCESS;
+
+	lat = calloc(1, sizeof(*lat));
+	if (!lat) {
+		cas_printf(LOG_ERR, "Failed to allocate memory\n");
+		return FAILURE;
+	}
+
+	lat->cache_id = cache_id;
+	lat->core_id = core_id;
+	lat->part_id = io_class_id;
+
+	if (ioctl(ctrl_fd, KCAS_IOCTL_GET_LAT_HIST, lat) < 0) {
+		print_err(lat->ext_err_code);
+		ret = FAILURE;
+		goto out;
+	}
+
+	if (!lat->enabled && !lat->stage_sample) {
+		cas_printf(LOG_WARNING, "Latency histograms are not collected, "
+				"load cas_cache with latency_histograms=1 "
+				"or stage_latency_sample=N to enable them.\n");
+		goto out;
+	}
+
+	begin_record(outfile);
+
+	if (lat->stage_sample)
+		cache_stats_stages(lat, outfile);
+
+	if (!lat->enabled)
+		goto out;
+
+	print_table_header(outfile, 6, "Latency statistics", "Count", "p50",
+			   "p99", "p99.9", "[Units]");
+
+	print_lat_hist_row(outfile, "Exported object reads",
+			&lat->hist[KCAS_LAT_HIST_EXP_OBJ_RD]);
+	print_lat_hist_row(outfile, "Exported object writes",
+			&lat->hist[KCAS_LAT_HIST_EXP_OBJ_WR]);
+	print_lat_hist_row(outfile, "Cache device reads (hits)",
+			&lat->hist[KCAS_LAT_HIST_CACHE_DEV_RD]);
+	print_lat_hist_row(outfile, "Cache device writes (inserts, writeback)",
+			&lat->hist[KCAS_LAT_HIST_CACHE_DEV_WR]);
+	print_lat_hist_row(outfile, "Core device reads (misses, pass-through)",
+			&lat->hist[KCAS_LAT_HIST_CORE_DEV_RD]);
+	print_lat_hist_row(outfile, "Core device writes (write-through, cleaning)",
+			&lat->hist[KCAS_LAT_HIST_CORE_DEV_WR]);
+
+out:
+	free(lat);
+	return ret;
+}
+
+static const char *queue_type_name(uint32_t type)
+{
+	switch (type) {
+	case KCAS_QUEUE_WORKER:
+		return "Worker";
+	case KCAS_QUEUE_PORTER:
+		return "Porter";
+	case KCAS_QUEUE_IDLE:
+		return "Idle";
+	default:
+		return "Unknown";
+	}
+}
+
+/**
+ * @brief print depth, dwell time, batch size and busy time of each cache
+ * I/O queue
+ */
+static int cache_stats_queues(int ctrl_fd, uint32_t cache_id, FILE *outfile)
+{
+	struct kcas_get_queue_stats queues = {};
+	struct kcas_queue_stats_entry *entries = NULL;
+	struct kcas_queue_stats_entry *q;
+	long cpus = sysconf(_SC_NPROCESSORS_CONF);
+	char title[32];
+	uint32_t capacity = 3 * (cpus > 0 ? cpus : 1);
+	uint64_t total;
+	uint32_t i;
+	int ret = SUCCESS;
+
+	queues.cache_id = cache_id;
+	queues.entries_count = capacity;
+
+	entries = calloc(capacity, sizeof(*entries));
+	if (!entries) {
+		cas_printf(LOG_ERR, "Failed to allocate memory\n");
+		return FAILURE;
+	}
+	queues.entries = entries;
+
+	if (ioctl(ctrl_fd, KCAS_IOCTL_GET_QUEUE_STATS, &queues) < 0) {
+		print_err(queues.ext_err_code);
+		ret = FAILURE;
+		goto out;
+	}
+
+	begin_record(outfile);
+
+	print_table_header(outfile, 9, "Queue statistics", "Pending",
+			   "Max pending", "Runs", "Avg batch", "Max batch",
+			   "Avg dwell [us]", "Max dwell [us]", "Busy [%]");
+
+	for (i = 0; i < queues.entries_count && i < capacity; i++) {
+		q = &entries[i];
+		total = q->busy_ns + q->idle_ns;
+
+		snprintf(title, sizeof(title), "%s %u",
+				queue_type_name(q->type), q->cpu);
+		fprintf(outfile, TAG(TABLE_ROW)
+				"\"%s\",%u,%u,%lu,%.1f,%u,%.1f,%.1f,%.1f\n",
+				title, q->pending, q->max_pending, q->runs,
+				q->runs ? (float)q->processed / q->runs : 0.f,
+				q->max_batch,
+				q->dwells ? q->dwell_ns / 1000.f / q->dwells : 0.f,
+				q->dwell_max_ns / 1000.f,
+				total ? 100.f * q->busy_ns / total : 0.f);
+	}
+
+out:
+	free(entries);
+	return ret;
+}
+
+static void print_internal_row(FILE *outfile, const char *title,
+		uint64_t value, const char *unit)
+{
+	fprintf(outfile, TAG(TABLE_ROW) "\"%s\",%lu,\"[%s]\"\n", title,
+			value, unit);
+}
+
+/**
+ * @brief print internal counters of cache
+ */
+static int cache_stats_internal(int ctrl_fd, uint32_t cache_id, FILE *outfile)
+{
+	struct kcas_get_stats_bulk bulk = {};
+	struct kcas_get_stats entry = {};
+	const struct kcas_cache_counters *c = &bulk.counters;
+
+	bulk.cache_id = cache_id;
+	bulk.core_id = OCF_CORE_ID_INVALID;
+	bulk.io_classes = false;
+	bulk.entries_count = 1;
+	bulk.entries = &entry;
+
+	if (ioctl(ctrl_fd, KCAS_IOCTL_GET_STATS_BULK, &bulk) < 0) {
+		print_err(bulk.ext_err_code);
+		return FAILURE;
+	}
+
+	begin_record(outfile);
+
+	print_table_header(outfile, 3, "Internal statistics", "Count",
+			   "[Units]");
+	print_internal_row(outfile, "Bios deferred without preallocated context",
+			c->defer_pool_exhausted, UNIT_REQUESTS);
+	print_internal_row(outfile, "Classified requests",
+			c->classifier_invocations, UNIT_REQUESTS);
+	print_internal_row(outfile, "Flushes completed without device flush",
+			c->flushes_elided, UNIT_REQUESTS);
+	print_internal_row(outfile, "Work found while polling",
+			c->queue_polls, "Events");
+	print_internal_row(outfile, "Sleeps waiting for work",
+			c->queue_sleeps, "Events");
+	print_internal_row(outfile, "Writes replicated in standby",
+			c->standby_writes, UNIT_REQUESTS);
+	print_internal_row(outfile, "Last activation time",
+			c->activate_time_ms, "ms");
+	print_internal_row(outfile, "Trimmed by background trim",
+			c->cache_trimmed, "MiB");
+	print_internal_row(outfile, "In-memory tier used",
+			c->dram_tier_used >> 20, "MiB");
+	print_internal_row(outfile, "In-memory tier read hits",
+			c->dram_tier_hits, UNIT_REQUESTS);
+	print_internal_row(outfile, "In-memory tier read misses",
+			c->dram_tier_misses, UNIT_REQUESTS);
+	print_internal_row(outfile, "Compressed data stored",
+			c->compress_stored >> 20, "MiB");
+	print_internal_row(outfile, "Compressed data on device",
+			c->compress_packed >> 20, "MiB");
+	print_internal_row(outfile, "Deduplication indexed data",
+			c->dedup_indexed >> 20, "MiB");
+	print_internal_row(outfile, "Deduplication saved space",
+			c->dedup_saved >> 20, "MiB");
+	print_internal_row(outfile, "Checksum mismatches",
+			c->checksum_errors, "Blocks");
+	print_internal_row(outfile, "Time bypassing slow cache device",
+			c->slow_bypass_time_ms, "ms");
+	print_internal_row(outfile, "Reads bypassing slow cache device",
+			c->slow_bypass_reads, UNIT_REQUESTS);
+	print_internal_row(outfile, "Coalesced metadata writes",
+			c->meta_coalesce_absorbed, UNIT_REQUESTS);
+	print_internal_row(outfile, "Coalesced metadata writeback writes",
+			c->meta_coalesce_writes, UNIT_REQUESTS);
+	print_internal_row(outfile, "Unchanged metadata pages not written",
+			c->meta_elided, "Pages");
+	print_internal_row(outfile, "Time absorbing sequential writes",
+			c->seq_absorb_time_ms, "ms");
+
+	return SUCCESS;
+}
+
+static void print_kv_pair_bytes(FILE *outfile, const char *title,
+		uint64_t bytes)
+{
+	const char *units;
+	float value;
+
+	metadata_memory_footprint(bytes, &value, &units);
+	print_kv_pair(outfile, title, "%.1f, [%s]", value, units);
+}
+
+static int cache_stats_memory(int ctrl_fd, uint32_t cache_id, FILE *outfile)
+{
+	struct kcas_get_mem_footprint mem = {};
+	uint64_t bvec_bytes = 0, total;
+	char title[64];
+	int i;
+
+	mem.cache_id = cache_id;
+
+	if (ioctl(ctrl_fd, KCAS_IOCTL_GET_MEM_FOOTPRINT, &mem) < 0) {
+		print_err(mem.ext_err_code);
+		return FAILURE;
+	}
+
+	for (i = 0; i < KCAS_BVEC_POOL_ORDERS; i++)
+		bvec_bytes += (uint64_t)mem.bvec_items[i] * mem.bvec_item_size[i];
+
+	total = mem.metadata_bytes + mem.fs_meta_bytes + mem.cls_bytes;
+
+	begin_record(outfile);
+
+	print_kv_pair_bytes(outfile, "Metadata", mem.metadata_bytes);
+	print_kv_pair(outfile, "FS metadata extents", "%lu",
+		      mem.fs_meta_extents);
+	print_kv_pair_bytes(outfile, "FS metadata maps", mem.fs_meta_bytes);
+	print_kv_pair(outfile, "Classifier rules", "%u", mem.cls_rules);
+	print_kv_pair_bytes(outfile, "Classifier", mem.cls_bytes);
+	print_kv_pair_bytes(outfile, "Total (cache)", total);
+	print_kv_pair_bytes(outfile, "Reserve pools (shared)",
+			    mem.rpool_bytes);
+	print_kv_pair_bytes(outfile, "BIO vector pool (shared)", bvec_bytes);
+
+	begin_record(outfile);
+
+	print_table_header(outfile, 3, "BIO vector pool", "Objects", "Size");
+
+	for (i = 0; i < KCAS_BVEC_POOL_ORDERS; i++) {
+		if (!mem.bvec_item_size[i])
+			continue;
+		snprintf(title, sizeof(title), "%u pages", 1 << i);
+		fprintf(outfile, TAG(TABLE_ROW) "\"%s\",%u,%lu\n", title,
+				mem.bvec_items[i],
+				(uint64_t)mem.bvec_items[i] *
+				mem.bvec_item_size[i]);
+	}
+
+	return SUCCESS;
+}
+
+static int cache_stats_heatmap(int ctrl_fd, uint32_t cache_id,
+		uint32_t core_id, FILE *outfile)
+{
+	struct kcas_get_heatmap *heatmap;
+	struct kcas_heatmap_bucket *b;
+	int ret = SUCCESS;
+	int i;
+
+	heatmap = calloc(1, sizeof(*heatmap));
+	if (!heatmap) {
+		cas_printf(LOG_ERR, "Failed to allocate memory\n");
+		return FAILURE;
+	}
+
+	heatmap->cache_id = cache_id;
+	heatmap->core_id = core_id;
+
+	if (ioctl(ctrl_fd, KCAS_IOCTL_GET_HEATMAP, heatmap) < 0) {
+		print_err(heatmap->ext_err_code);
+		ret = FAILURE;
+		goto out;
+	}
+
+	if (!heatmap->enabled) {
+		cas_printf(LOG_WARNING, "LBA heatmap is not collected, load "
+				"cas_cache with lba_heatmap=1\n");
+		goto out;
+	}
+
+	begin_record(outfile);
+
+	print_table_header(outfile, 5, "LBA heatmap [sector]", "Reads",
+			   "Writes", "Read hits", "Read hit ratio [%]");
+
+	for (i = 0; i < KCAS_HEATMAP_BUCKETS; i++) {
+		b = &heatmap->buckets[i];
+		fprintf(outfile, TAG(TABLE_ROW) "%lu,%lu,%lu,%lu,%.1f\n",
+				i * heatmap->bucket_sectors, b->reads,
+				b->writes, b->read_hits,
+				b->reads ? 100.f * b->read_hits / b->reads : 0.f);
+	}
+
+out:
+	free(heatmap);
+	return ret;
+}
+
+/* Sampled accesses with reuse distance below @lines, i.e. LRU hits */
+static double mrc_hits(const struct kcas_get_mrc *mrc, double lines)
+{
+	double low, width, hits = 0;
+	uint32_t group;
+	int i;
+
+	for (i = 0; i < KCAS_MRC_BUCKETS; i++) {
+		if (i < (1 << KCAS_MRC_SUB_BITS)) {
+			low = i;
+			width = 1;
+		} else {
+			group = i >> KCAS_MRC_SUB_BITS;
+			width = (double)(1ULL << (group - 1));
+			low = ((1 << KCAS_MRC_SUB_BITS) +
+				(i & ((1 << KCAS_MRC_SUB_BITS) - 1))) * width;
+		}
+
+		if (low >= lines)
+			break;
+		/* Assume distances spread evenly within bucket */
+		hits += mrc->hist[i] * (low + width <= lines ? 1 :
+				(lines - low) / width);
+	}
+
+	return hits;
+}
+
+static int cache_stats_mrc(int ctrl_fd, struct kcas_cache_info *cache_info,
+		unsigned int core_id, FILE *outfile)
+{
+	static const double factors[] = { 0.5, 1, 2, 4 };
+	struct kcas_get_mrc *mrc;
+	uint64_t samples;
+	char title[32];
+	int ret = SUCCESS;
+	int i, j;
+	int n = 0;
+
+	mrc = calloc(1, sizeof(*mrc));
+	if (!mrc) {
+		cas_printf(LOG_ERR, "Failed to allocate memory\n");
+		return FAILURE;
+	}
+
+	begin_record(outfile);
+
+	print_table_header(outfile, 7, "Miss ratio curve", "Sampling rate",
+			   "Samples", "Hit ratio 0.5x [%]", "Hit ratio 1x [%]",
+			   "Hit ratio 2x [%]", "Hit ratio 4x [%]");
+
+	for (i = 0; i < cache_info->info.core_count; i++) {
+		if (core_id != OCF_CORE_ID_INVALID &&
+				core_id != cache_info->core_id[i])
+			continue;
+
+		memset(mrc, 0, sizeof(*mrc));
+		mrc->cache_id = cache_info->cache_id;
+		mrc->core_id = cache_info->core_id[i];
+
+		if (ioctl(ctrl_fd, KCAS_IOCTL_GET_MRC, mrc) < 0) {
+			print_err(mrc->ext_err_code);
+			ret = FAILURE;
+			goto out;
+		}
+
+		if (!mrc->enabled)
+			continue;
+		n++;
+
+		samples = mrc->cold;
+		for (j = 0; j < KCAS_MRC_BUCKETS; j++)
+			samples += mrc->hist[j];
+
+		snprintf(title, sizeof(title), "Core %u", mrc->core_id);
+		fprintf(outfile, TAG(TABLE_ROW) "\"%s\",1/%llu,%lu", title,
+				1ULL << mrc->sample_shift, samples);
+		for (j = 0; j < sizeof(factors) / sizeof(factors[0]); j++) {
+			fprintf(outfile, ",%.1f", samples ? 100 *
+					mrc_hits(mrc, factors[j] *
+						cache_info->info.size) /
+					samples : 0.);
+		}
+		fprintf(outfile, "\n");
+	}
+
+	if (!n) {
+		cas_printf(LOG_WARNING, "Miss ratio curve is not estimated, "
+				"load cas_cache with mrc_estimation=1\n");
+	}
+
+out:
+	free(mrc);
+	return ret;
+}
+
 struct stats_printout_ctx
 {
 	FILE *intermediate;
@@ -803,6 +1373,10 @@ int cache_status(uint32_t cache_id, unsigned int core_id, int io_class_id,
 		}
 	}
 
+	/* Latency and queue statistics only */
+	if (!(stats_filters & STATS_FILTER_ALL))
+		goto latency;
+
 	if (stats_filters & STATS_FILTER_IOCLASS) {
 		if (cache_stats_ioclasses(ctrl_fd, &cache_info, cache_id,
 					core_id, io_class_id,
@@ -826,6 +1400,60 @@ int cache_status(uint32_t cache_id, unsigned int core_id, int io_class_id,
 		}
 	}
 
+latency:
+	if (stats_filters & STATS_FILTER_LAT) {
+		if (cache_stats_latency(ctrl_fd, cache_id, core_id,
+					io_class_id, intermediate_file[1])) {
+			ret = FAILURE;
+			goto cleanup;
+		}
+	}
+
+	/* Queues are shared by all cores, so only cache wide */
+	if ((stats_filters & STATS_FILTER_QUEUE) &&
+			core_id == OCF_CORE_ID_INVALID) {
+		if (cache_stats_queues(ctrl_fd, cache_id,
+					intermediate_file[1])) {
+			ret = FAILURE;
+			goto cleanup;
+		}
+	}
+
+	if ((stats_filters & STATS_FILTER_MEM) &&
+			core_id == OCF_CORE_ID_INVALID) {
+		if (cache_stats_memory(ctrl_fd, cache_id,
+					intermediate_file[1])) {
+			ret = FAILURE;
+			goto cleanup;
+		}
+	}
+
+	if ((stats_filters & STATS_FILTER_INTERNAL) &&
+			core_id == OCF_CORE_ID_INVALID) {
+		if (cache_stats_internal(ctrl_fd, cache_id,
+					intermediate_file[1])) {
+			ret = FAILURE;
+			goto cleanup;
+		}
+	}
+
+	if ((stats_filters & STATS_FILTER_HEATMAP) &&
+			core_id != OCF_CORE_ID_INVALID) {
+		if (cache_stats_heatmap(ctrl_fd, cache_id, core_id,
+					intermediate_file[1])) {
+			ret = FAILURE;
+			goto cleanup;
+		}
+	}
+
+	if (stats_filters & STATS_FILTER_MRC) {
+		if (cache_stats_mrc(ctrl_fd, &cache_info, core_id,
+					intermediate_file[1])) {
+			ret = FAILURE;
+			goto cleanup;
+		}
+	}
+
 cleanup:
 	close(ctrl_fd);
 	fclose(intermediate_file[1]);
@@ -838,3 +1466,584 @@ cleanup:
 
 	return ret;
 }
+
+/* Single sample of statistics taken by watch mode */
+struct watch_sample {
+	struct timespec time;
+	struct kcas_get_stats *entries;
+	uint32_t count;
+	uint64_t lines_cleaned;
+	uint64_t line_size;
+};
+
+#define WATCH_BLOCK_BYTES (4 * KiB)
+
+static int watch_take_sample(int ctrl_fd, uint32_t cache_id,
+		unsigned int core_id, struct watch_sample *sample)
+{
+	struct kcas_cache_info cache_info = {};
+	struct kcas_get_stats_bulk bulk = {};
+
+	cache_info.cache_id = cache_id;
+	if (ioctl(ctrl_fd, KCAS_IOCTL_CACHE_INFO, &cache_info) < 0) {
+		print_err(cache_info.ext_err_code);
+		return FAILURE;
+	}
+
+	free(sample->entries);
+	sample->count = cache_info.info.core_count + 1;
+	sample->entries = calloc(sample->count, sizeof(*sample->entries));
+	if (!sample->entries) {
+		cas_printf(LOG_ERR, "Failed to allocate memory\n");
+		return FAILURE;
+	}
+
+	/* Counters of cache and all cores are retrieved atomically at once */
+	bulk.cache_id = cache_id;
+	bulk.core_id = core_id;
+	bulk.io_classes = false;
+	bulk.entries_count = sample->count;
+	bulk.entries = sample->entries;
+
+	if (ioctl(ctrl_fd, KCAS_IOCTL_GET_STATS_BULK, &bulk) < 0) {
+		print_err(bulk.ext_err_code);
+		return FAILURE;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &sample->time);
+	sample->count = bulk.entries_count < sample->count ?
+			bulk.entries_count : sample->count;
+	sample->lines_cleaned = cache_info.cleaner.lines_cleaned;
+	sample->line_size = cache_info.info.cache_line_size;
+
+	return SUCCESS;
+}
+
+static const struct kcas_get_stats *watch_find_entry(
+		const struct watch_sample *sample, uint16_t core_id)
+{
+	uint32_t i;
+
+	for (i = 0; i < sample->count; i++) {
+		if (sample->entries[i].core_id == core_id)
+			return &sample->entries[i];
+	}
+
+	return NULL;
+}
+
+#define WATCH_DELTA(field) ((double)(cur->field.value - prev->field.value))
+
+struct watch_rates {
+	double rd_iops;
+	double wr_iops;
+	double rd_mibps;
+	double wr_mibps;
+	double hit_ratio;
+	double dirty_mibps;
+};
+
+static void watch_compute_rates(const struct kcas_get_stats *cur,
+		const struct kcas_get_stats *prev, double secs,
+		struct watch_rates *rates)
+{
+	double reqs = WATCH_DELTA(req.rd_total) + WATCH_DELTA(req.wr_total);
+	double hits = WATCH_DELTA(req.rd_hits) + WATCH_DELTA(req.wr_hits);
+
+	rates->rd_iops = WATCH_DELTA(req.rd_total) / secs;
+	rates->wr_iops = WATCH_DELTA(req.wr_total) / secs;
+	rates->rd_mibps = WATCH_DELTA(blocks.volume_rd) * WATCH_BLOCK_BYTES /
+			MiB / secs;
+	rates->wr_mibps = WATCH_DELTA(blocks.volume_wr) * WATCH_BLOCK_BYTES /
+			MiB / secs;
+	rates->hit_ratio = reqs > 0 ? 100. * hits / reqs : 0.;
+	rates->dirty_mibps = WATCH_DELTA(usage.dirty) * WATCH_BLOCK_BYTES /
+			MiB / secs;
+}
+
+static void watch_object_name(const struct kcas_get_stats *entry,
+		char *name, size_t len)
+{
+	if (entry->core_id == OCF_CORE_ID_INVALID)
+		snprintf(name, len, "Cache %u", entry->cache_id);
+	else
+		snprintf(name, len, "Core %u", entry->core_id);
+}
+
+static void watch_print_csv_header(FILE *outfile)
+{
+	fprintf(outfile, "Time [s],Object,Read IOPS,Write IOPS,"
+			"Read [MiB/s],Write [MiB/s],Hit ratio [%%],"
+			"Dirty growth [MiB/s],Cleaned [MiB/s]\n");
+	fflush(outfile);
+}
+
+/*
+ * Print rates between two samples, either as raw CSV lines for logging or
+ * as intermediate records for statistics formatter.
+ */
+static void watch_print_rates(const struct watch_sample *cur,
+		const struct watch_sample *prev, FILE *outfile, bool raw)
+{
+	const struct kcas_get_stats *prev_entry;
+	struct watch_rates rates;
+	double secs, cleaned;
+	char name[32];
+	uint32_t i;
+
+	secs = (cur->time.tv_sec - prev->time.tv_sec) +
+		(cur->time.tv_nsec - prev->time.tv_nsec) / 1e9;
+	if (secs <= 0)
+		return;
+
+	cleaned = (double)(cur->lines_cleaned - prev->lines_cleaned) *
+			cur->line_size / MiB / secs;
+
+	if (!raw) {
+		begin_record(outfile);
+		print_table_header(outfile, 8, "Rates", "Read IOPS",
+				   "Write IOPS", "Read [MiB/s]",
+				   "Write [MiB/s]", "Hit ratio [%]",
+				   "Dirty growth [MiB/s]", "Cleaned [MiB/s]");
+	}
+
+	for (i = 0; i < cur->count; i++) {
+		prev_entry = watch_find_entry(prev, cur->entries[i].core_id);
+		if (!prev_entry)
+			continue;
+
+		watch_compute_rates(&cur->entries[i], prev_entry, secs, &rates);
+		watch_object_name(&cur->entries[i], name, sizeof(name));
+
+		if (raw) {
+			fprintf(outfile, "%ld.%03ld,", (long)cur->time.tv_sec,
+					cur->time.tv_nsec / 1000000);
+			fprintf(outfile, "\"%s\",", name);
+		} else {
+			fprintf(outfile, TAG(TABLE_ROW) "\"%s\",", name);
+		}
+		fprintf(outfile, "%.0f,%.0f,%.2f,%.2f,%.1f,%.2f,",
+				rates.rd_iops, rates.wr_iops, rates.rd_mibps,
+				rates.wr_mibps, rates.hit_ratio,
+				rates.dirty_mibps);
+
+		/* Cleaner is cache wide */
+		if (cur->entries[i].core_id == OCF_CORE_ID_INVALID)
+			fprintf(outfile, "%.2f\n", cleaned);
+		else
+			fprintf(outfile, "-\n");
+	}
+
+	fflush(outfile);
+}
+
+static int watch_print_table(const struct watch_sample *cur,
+		const struct watch_sample *prev, uint32_t cache_id,
+		uint32_t interval)
+{
+	struct stats_printout_ctx printout_ctx;
+	FILE *intermediate_file[2];
+	pthread_t thread;
+
+	if (create_pipe_pair(intermediate_file)) {
+		cas_printf(LOG_ERR,"Failed to create unidirectional pipe.\n");
+		return FAILURE;
+	}
+
+	printout_ctx.intermediate = intermediate_file[0];
+	printout_ctx.out = stdout;
+	printout_ctx.type = TEXT;
+	pthread_create(&thread, 0, stats_printout, &printout_ctx);
+
+	printf(ERASE CURSOR_HOME);
+	printf("Cache %u, refreshed every %u s, press Ctrl-C to exit\n\n",
+			cache_id, interval);
+	fflush(stdout);
+
+	watch_print_rates(cur, prev, intermediate_file[1], false);
+
+	fclose(intermediate_file[1]);
+	pthread_join(thread, 0);
+	fclose(intermediate_file[0]);
+
+	return printout_ctx.result;
+}
+
+/**
+ * @brief print per interval rates of cache statistics until interrupted
+ *
+ * this routine implements -P (--stats) subcommand of casadm with
+ * --watch option. Rates are printed in top-like table or, with csv output
+ * format, as raw CSV lines suitable for logging.
+ */
+int cache_status_watch(uint32_t cache_id, unsigned int core_id,
+		       uint32_t interval, unsigned int output_format)
+{
+	struct watch_sample samples[2] = {};
+	struct watch_sample *cur = &samples[0], *prev = &samples[1], *tmp;
+	bool raw = (output_format == OUTPUT_FORMAT_CSV);
+	int ctrl_fd, ret = SUCCESS;
+
+	ctrl_fd = open_ctrl_device();
+	if (ctrl_fd < 0) {
+		print_err(KCAS_ERR_SYSTEM);
+		return FAILURE;
+	}
+
+	if (watch_take_sample(ctrl_fd, cache_id, core_id, prev)) {
+		ret = FAILURE;
+		goto out;
+	}
+
+	if (raw)
+		watch_print_csv_header(stdout);
+
+	while (true) {
+		sleep(interval);
+
+		if (watch_take_sample(ctrl_fd, cache_id, core_id, cur)) {
+			ret = FAILURE;
+			break;
+		}
+
+		if (raw) {
+			watch_print_rates(cur, prev, stdout, true);
+		} else if (watch_print_table(cur, prev, cache_id, interval)) {
+			ret = FAILURE;
+			break;
+		}
+
+		tmp = prev;
+		prev = cur;
+		cur = tmp;
+	}
+
+out:
+	free(samples[0].entries);
+	free(samples[1].entries);
+	close(ctrl_fd);
+	return ret;
+}
+
+/* Max number of inflight requests listed, histogram covers all of them */
+#define INFLIGHT_ENTRIES_MAX 65536
+
+static int inflight_cmp_age(const void *a, const void *b)
+{
+	const struct kcas_inflight_entry *ea = a, *eb = b;
+
+	if (ea->age_us == eb->age_us)
+		return 0;
+	return ea->age_us < eb->age_us ? 1 : -1;
+}
+
+static const char *inflight_stage_name(uint8_t stage)
+{
+	switch (stage) {
+	case KCAS_INFLIGHT_STAGE_OCF:
+		return "Engine";
+	case KCAS_INFLIGHT_STAGE_DEVICE:
+		return "Device";
+	default:
+		return "Unknown";
+	}
+}
+
+static void inflight_print(const struct kcas_dump_inflight *cmd,
+		FILE *outfile)
+{
+	const struct kcas_inflight_entry *e;
+	char title[32];
+	uint32_t i, count;
+
+	begin_record(outfile);
+
+	print_table_header(outfile, 2, "Inflight age [us]", "Requests");
+	for (i = 0; i < KCAS_INFLIGHT_AGE_BUCKETS; i++) {
+		if (i == 0) {
+			snprintf(title, sizeof(title), "< 1");
+		} else if (i == KCAS_INFLIGHT_AGE_BUCKETS - 1) {
+			snprintf(title, sizeof(title), ">= %llu",
+					1ULL << (i - 1));
+		} else {
+			snprintf(title, sizeof(title), "%llu - %llu",
+					1ULL << (i - 1), (1ULL << i) - 1);
+		}
+		fprintf(outfile, TAG(TABLE_ROW) "\"%s\",%lu\n", title,
+				cmd->age_hist[i]);
+	}
+
+	count = cmd->entries_count < INFLIGHT_ENTRIES_MAX ?
+		cmd->entries_count : INFLIGHT_ENTRIES_MAX;
+
+	begin_record(outfile);
+
+	print_table_header(outfile, 7, "Core", "Dir", "Offset [B]",
+			   "Size [B]", "Queue", "Stage", "Age [us]");
+	for (i = 0; i < count; i++) {
+		e = &cmd->entries[i];
+		fprintf(outfile, TAG(TABLE_ROW) "%u,%s,%lu,%u,%u,%s,%lu\n",
+				e->core_id, e->dir ? "Write" : "Read", e->addr,
+				e->bytes, e->queue,
+				inflight_stage_name(e->stage), e->age_us);
+	}
+}
+
+/**
+ * @brief print requests inflight in exported objects of cache
+ *
+ * this routine implements -D (--dump-inflight) subcommand of casadm.
+ * Requests are listed from the oldest one, followed by histogram of ages
+ * of all inflight requests.
+ */
+int cache_inflight_dump(uint32_t cache_id, unsigned int output_format)
+{
+	struct stats_printout_ctx printout_ctx;
+	struct kcas_dump_inflight cmd = {};
+	FILE *intermediate_file[2];
+	pthread_t thread;
+	int ctrl_fd, ret = SUCCESS;
+
+	cmd.cache_id = cache_id;
+	cmd.entries_count = INFLIGHT_ENTRIES_MAX;
+	cmd.entries = calloc(INFLIGHT_ENTRIES_MAX, sizeof(*cmd.entries));
+	if (!cmd.entries) {
+		cas_printf(LOG_ERR, "Failed to allocate memory\n");
+		return FAILURE;
+	}
+
+	ctrl_fd = open_ctrl_device();
+	if (ctrl_fd < 0) {
+		print_err(KCAS_ERR_SYSTEM);
+		ret = FAILURE;
+		goto free;
+	}
+
+	if (ioctl(ctrl_fd, KCAS_IOCTL_DUMP_INFLIGHT, &cmd) < 0) {
+		cas_printf(LOG_ERR, "Error dump inflight cache %"PRIu32"\n",
+				cache_id);
+		print_err(cmd.ext_err_code);
+		ret = FAILURE;
+		goto close;
+	}
+
+	if (!cmd.enabled) {
+		cas_printf(LOG_WARNING, "Inflight requests are not tracked, "
+				"load cas_cache with inflight_tracking=1 or use "
+				"--kernel-log\n");
+		goto close;
+	}
+
+	qsort(cmd.entries, cmd.entries_count < INFLIGHT_ENTRIES_MAX ?
+			cmd.entries_count : INFLIGHT_ENTRIES_MAX,
+			sizeof(*cmd.entries), inflight_cmp_age);
+
+	if (create_pipe_pair(intermediate_file)) {
+		cas_printf(LOG_ERR,"Failed to create unidirectional pipe.\n");
+		ret = FAILURE;
+		goto close;
+	}
+
+	printout_ctx.intermediate = intermediate_file[0];
+	printout_ctx.out = stdout;
+	printout_ctx.type = (OUTPUT_FORMAT_CSV == output_format ? CSV : TEXT);
+	pthread_create(&thread, 0, stats_printout, &printout_ctx);
+
+	inflight_print(&cmd, intermediate_file[1]);
+
+	fclose(intermediate_file[1]);
+	pthread_join(thread, 0);
+	fclose(intermediate_file[0]);
+	ret = printout_ctx.result;
+
+	if (cmd.entries_count > INFLIGHT_ENTRIES_MAX) {
+		cas_printf(LOG_WARNING, "%u more inflight requests not listed\n",
+				cmd.entries_count - INFLIGHT_ENTRIES_MAX);
+	}
+
+close:
+	close(ctrl_fd);
+free:
+	free(cmd.entries);
+	return ret;
+}
+
+static void bench_print(const struct kcas_bench *cmd, FILE *outfile)
+{
+	double seconds = cmd->elapsed_ns / 1e9;
+	uint64_t ios = cmd->reads + cmd->writes;
+
+	begin_record(outfile);
+
+	print_kv_pair(outfile, "Threads", "%u", cmd->threads);
+	print_kv_pair(outfile, "Queue depth", "%u", cmd->queue_depth);
+	print_kv_pair(outfile, "I/O size", "%u, [B]", cmd->io_size);
+	print_kv_pair(outfile, "Reads", "%u, [%%]", cmd->read_percent);
+	print_kv_pair(outfile, "Elapsed time", "%.3f, [s]", seconds);
+	print_kv_pair(outfile, "Completed reads", "%lu", cmd->reads);
+	print_kv_pair(outfile, "Completed writes", "%lu", cmd->writes);
+	print_kv_pair(outfile, "Errors", "%lu", cmd->errors);
+	print_kv_pair(outfile, "IOPS", "%.0f", seconds ? ios / seconds : 0);
+	print_kv_pair(outfile, "Throughput", "%.1f, [MiB/s]",
+			seconds ? cmd->bytes / seconds / MiB : 0);
+
+	begin_record(outfile);
+
+	print_table_header(outfile, 6, "Latency statistics", "Count", "p50",
+			   "p99", "p99.9", "[Units]");
+
+	print_lat_hist_row(outfile, "Submission",
+			&cmd->hist[KCAS_BENCH_HIST_SUBMIT]);
+	print_lat_hist_row(outfile, "Reads", &cmd->hist[KCAS_BENCH_HIST_RD]);
+	print_lat_hist_row(outfile, "Writes", &cmd->hist[KCAS_BENCH_HIST_WR]);
+}
+
+int cache_bench(struct kcas_bench *cmd, unsigned int output_format)
+{
+	struct stats_printout_ctx printout_ctx;
+	FILE *intermediate_file[2];
+	pthread_t thread;
+	int ctrl_fd, ret;
+
+	ctrl_fd = open_ctrl_device();
+	if (ctrl_fd < 0) {
+		print_err(KCAS_ERR_SYSTEM);
+		return FAILURE;
+	}
+
+	if (ioctl(ctrl_fd, KCAS_IOCTL_BENCH, cmd) < 0) {
+		cas_printf(LOG_ERR, "Error running benchmark of core %u "
+				"of cache %"PRIu32"\n", cmd->core_id,
+				cmd->cache_id);
+		print_err(cmd->ext_err_code);
+		ret = FAILURE;
+		goto close;
+	}
+
+	if (create_pipe_pair(intermediate_file)) {
+		cas_printf(LOG_ERR,"Failed to create unidirectional pipe.\n");
+		ret = FAILURE;
+		goto close;
+	}
+
+	printout_ctx.intermediate = intermediate_file[0];
+	printout_ctx.out = stdout;
+	printout_ctx.type = (OUTPUT_FORMAT_CSV == output_format ? CSV : TEXT);
+	pthread_create(&thread, 0, stats_printout, &printout_ctx);
+
+	bench_print(cmd, intermediate_file[1]);
+
+	fclose(intermediate_file[1]);
+	pthread_join(thread, 0);
+	fclose(intermediate_file[0]);
+	ret = printout_ctx.result;
+
+close:
+	close(ctrl_fd);
+	return ret;
+}
+
+static const char *alloc_bench_pool_names[KCAS_ALLOC_BENCH_POOL_MAX] = {
+	[KCAS_ALLOC_BENCH_MPOOL] = "mpool",
+	[KCAS_ALLOC_BENCH_MPOOL_MAG] = "mpool-mag",
+	[KCAS_ALLOC_BENCH_ALLOCATOR] = "allocator",
+};
+
+int alloc_bench_pool_from_name(const char *name)
+{
+	int i;
+
+	for (i = 0; i < KCAS_ALLOC_BENCH_POOL_MAX; i++) {
+		if (!strcmp(name, alloc_bench_pool_names[i]))
+			return i;
+	}
+
+	return -1;
+}
+
+static void alloc_bench_print(const struct kcas_alloc_bench *cmd,
+		FILE *outfile)
+{
+	double seconds = cmd->elapsed_ns / 1e9;
+	uint64_t allocs = cmd->allocs;
+
+	begin_record(outfile);
+
+	print_kv_pair(outfile, "Pool", "%s",
+			alloc_bench_pool_names[cmd->pool]);
+	print_kv_pair(outfile, "Threads", "%u", cmd->threads);
+	print_kv_pair(outfile, "Objects per thread", "%u", cmd->depth);
+	print_kv_pair(outfile, "Remote frees", "%u, [%%]",
+			cmd->remote_percent);
+	if (cmd->pool != KCAS_ALLOC_BENCH_ALLOCATOR) {
+		print_kv_pair(outfile, "Max segments", "%u",
+				1U << cmd->max_order);
+	}
+	print_kv_pair(outfile, "Elapsed time", "%.3f, [s]", seconds);
+	print_kv_pair(outfile, "Allocations", "%lu", cmd->allocs);
+	print_kv_pair(outfile, "Failed allocations", "%lu", cmd->failures);
+	print_kv_pair(outfile, "Objects freed remotely", "%lu",
+			cmd->remote_frees);
+	print_kv_pair(outfile, "Allocations per second", "%.0f",
+			seconds ? allocs / seconds : 0);
+	print_kv_pair(outfile, "Reserve pool steals", "%lu, %.2f, [%%]",
+			cmd->steals, allocs ? 100.0 * cmd->steals / allocs : 0);
+	print_kv_pair(outfile, "Reserve pool fallbacks", "%lu, %.2f, [%%]",
+			cmd->fallbacks,
+			allocs ? 100.0 * cmd->fallbacks / allocs : 0);
+	if (cmd->pool == KCAS_ALLOC_BENCH_MPOOL_MAG) {
+		print_kv_pair(outfile, "Magazine hits", "%lu", cmd->mag_hits);
+		print_kv_pair(outfile, "Magazine misses", "%lu",
+				cmd->mag_misses);
+	}
+	if (cmd->cache_misses == ~0ULL) {
+		print_kv_pair(outfile, "Cache misses", "%s", "-");
+	} else {
+		print_kv_pair(outfile, "Cache misses",
+				"%lu, %.2f, [per allocation]", cmd->cache_misses,
+				allocs ? (double)cmd->cache_misses / allocs : 0);
+	}
+}
+
+int alloc_bench(struct kcas_alloc_bench *cmd, unsigned int output_format)
+{
+	struct stats_printout_ctx printout_ctx;
+	FILE *intermediate_file[2];
+	pthread_t thread;
+	int ctrl_fd, ret;
+
+	ctrl_fd = open_ctrl_device();
+	if (ctrl_fd < 0) {
+		print_err(KCAS_ERR_SYSTEM);
+		return FAILURE;
+	}
+
+	if (ioctl(ctrl_fd, KCAS_IOCTL_ALLOC_BENCH, cmd) < 0) {
+		cas_printf(LOG_ERR, "Error running allocator benchmark\n");
+		print_err(cmd->ext_err_code);
+		ret = FAILURE;
+		goto close;
+	}
+
+	if (create_pipe_pair(intermediate_file)) {
+		cas_printf(LOG_ERR,"Failed to create unidirectional pipe.\n");
+		ret = FAILURE;
+		goto close;
+	}
+
+	printout_ctx.intermediate = intermediate_file[0];
+	printout_ctx.out = stdout;
+	printout_ctx.type = (OUTPUT_FORMAT_CSV == output_format ? CSV : TEXT);
+	pthread_create(&thread, 0, stats_printout, &printout_ctx);
+
+	alloc_bench_print(cmd, intermediate_file[1]);
+
+	fclose(intermediate_file[1]);
+	pthread_join(thread, 0);
+	fclose(intermediate_file[0]);
+	ret = printout_ctx.result;
+
+close:
+	close(ctrl_fd);
+	return ret;
+}
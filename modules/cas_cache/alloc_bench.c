@@ -0,0 +1,414 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "cas_cache.h"
+#include <linux/random.h>
+#include <linux/perf_event.h>
+
+/* Size of objects of single size allocator */
+#define CAS_ALLOC_BENCH_ITEM_SIZE 256
+
+/* Objects replaced between checks for objects freed by other threads */
+#define CAS_ALLOC_BENCH_BATCH 64
+
+struct cas_alloc_bench_obj {
+	struct llist_node node;
+		/*< Entry of list of objects handed over to other thread */
+
+	uint32_t count;
+		/*< Elements of memory pool allocation */
+};
+
+struct cas_alloc_bench;
+
+struct cas_alloc_bench_worker {
+	struct cas_alloc_bench *bench;
+	struct task_struct *thread;
+	struct rnd_state rnd;
+
+	struct cas_alloc_bench_obj **held;
+		/*< Objects held by worker, NULL where allocation failed */
+
+	struct llist_head remote;
+		/*< Objects allocated by other worker to be freed by this one */
+
+	struct perf_event *counter;
+		/*< Cache misses of worker thread, NULL if not counted */
+
+	uint64_t allocs;
+	uint64_t failures;
+	uint64_t remote_frees;
+	uint64_t cache_misses;
+		/*< ~0 until counter is read */
+} ____cacheline_aligned;
+
+struct cas_alloc_bench {
+	const struct kcas_alloc_bench *cmd;
+
+	struct env_mpool *mpool;
+	env_allocator *allocator;
+		/*< Pool exercised, the other one is NULL */
+
+	bool stop;
+
+	uint32_t nr_workers;
+	struct cas_alloc_bench_worker workers[];
+};
+
+static DEFINE_MUTEX(cas_alloc_bench_lock);
+
+#ifdef CONFIG_PERF_EVENTS
+static void _cas_alloc_bench_counter_create(struct cas_alloc_bench_worker *w)
+{
+	struct perf_event_attr attr = {
+		.type = PERF_TYPE_HARDWARE,
+		.config = PERF_COUNT_HW_CACHE_MISSES,
+		.size = sizeof(attr),
+	};
+	struct perf_event *event;
+
+	event = perf_event_create_kernel_counter(&attr, -1, w->thread,
+			NULL, NULL);
+	w->counter = IS_ERR(event) ? NULL : event;
+}
+
+static void _cas_alloc_bench_counter_read(struct cas_alloc_bench_worker *w)
+{
+	u64 enabled, running;
+
+	if (w->counter) {
+		w->cache_misses = perf_event_read_value(w->counter, &enabled,
+				&running);
+	}
+}
+
+static void _cas_alloc_bench_counter_destroy(
+		struct cas_alloc_bench_worker *w)
+{
+	if (w->counter)
+		perf_event_release_kernel(w->counter);
+	w->counter = NULL;
+}
+#else
+static void _cas_alloc_bench_counter_create(struct cas_alloc_bench_worker *w)
+{
+}
+
+static void _cas_alloc_bench_counter_read(struct cas_alloc_bench_worker *w)
+{
+}
+
+static void _cas_alloc_bench_counter_destroy(
+		struct cas_alloc_bench_worker *w)
+{
+}
+#endif
+
+static struct cas_alloc_bench_obj *_cas_alloc_bench_new(
+		struct cas_alloc_bench_worker *w)
+{
+	struct cas_alloc_bench *bench = w->bench;
+	struct cas_alloc_bench_obj *obj;
+	uint32_t count = 1, order;
+
+	if (bench->allocator) {
+		obj = env_allocator_new(bench->allocator);
+	} else {
+		/* Order k drawn with probability 2^-(k+1), rest goes to max */
+		order = __ffs(prandom_u32_state(&w->rnd) |
+				(1U << bench->cmd->max_order));
+		if (order) {
+			count = 1U << (order - 1);
+			count += 1 + prandom_u32_state(&w->rnd) % count;
+		}
+		obj = env_mpool_new(bench->mpool, count);
+	}
+
+	if (!obj) {
+		w->failures++;
+		return NULL;
+	}
+
+	obj->count = count;
+	w->allocs++;
+
+	return obj;
+}
+
+static void _cas_alloc_bench_free(struct cas_alloc_bench *bench,
+		struct cas_alloc_bench_obj *obj)
+{
+	if (bench->allocator)
+		env_allocator_del(bench->allocator, obj);
+	else
+		env_mpool_del(bench->mpool, obj, obj->count);
+}
+
+static void _cas_alloc_bench_replace(struct cas_alloc_bench_worker *w)
+{
+	struct cas_alloc_bench *bench = w->bench;
+	struct cas_alloc_bench_worker *peer;
+	struct cas_alloc_bench_obj **slot;
+
+	slot = &w->held[prandom_u32_state(&w->rnd) % bench->cmd->depth];
+	if (*slot) {
+		if (bench->nr_workers > 1 && prandom_u32_state(&w->rnd) % 100 <
+				bench->cmd->remote_percent) {
+			peer = &bench->workers[(w - bench->workers + 1) %
+					bench->nr_workers];
+			llist_add(&(*slot)->node, &peer->remote);
+		} else {
+			_cas_alloc_bench_free(bench, *slot);
+		}
+	}
+
+	*slot = _cas_alloc_bench_new(w);
+}
+
+static void _cas_alloc_bench_drain(struct cas_alloc_bench_worker *w)
+{
+	struct cas_alloc_bench_obj *obj, *next;
+	struct llist_node *node = llist_del_all(&w->remote);
+
+	llist_for_each_entry_safe(obj, next, node, node) {
+		_cas_alloc_bench_free(w->bench, obj);
+		w->remote_frees++;
+	}
+}
+
+static int _cas_alloc_bench_thread(void *data)
+{
+	struct cas_alloc_bench_worker *w = data;
+	struct cas_alloc_bench *bench = w->bench;
+	uint32_t i;
+
+	while (!kthread_should_stop() && !READ_ONCE(bench->stop)) {
+		for (i = 0; i < CAS_ALLOC_BENCH_BATCH; i++)
+			_cas_alloc_bench_replace(w);
+
+		_cas_alloc_bench_drain(w);
+		cond_resched();
+	}
+
+	/* Counter of thread is read before thread exits */
+	_cas_alloc_bench_counter_read(w);
+
+	for (i = 0; i < bench->cmd->depth; i++) {
+		if (w->held[i])
+			_cas_alloc_bench_free(bench, w->held[i]);
+		w->held[i] = NULL;
+	}
+
+	return 0;
+}
+
+static int _cas_alloc_bench_create_pool(struct cas_alloc_bench *bench)
+{
+	const struct kcas_alloc_bench *cmd = bench->cmd;
+
+	if (cmd->pool == KCAS_ALLOC_BENCH_ALLOCATOR) {
+		bench->allocator = env_allocator_create(
+				CAS_ALLOC_BENCH_ITEM_SIZE, "cas_alloc_bench",
+				false);
+		return bench->allocator ? 0 : -ENOMEM;
+	}
+
+	/* Laid out as BIO vector pool, which is the busiest one */
+	bench->mpool = env_mpool_create(max_t(uint32_t,
+				sizeof(struct blk_data),
+				sizeof(struct cas_alloc_bench_obj)),
+			sizeof(struct bio_vec), GFP_NOIO, cmd->max_order,
+			false, NULL, "cas_alloc_bench", true);
+	if (!bench->mpool)
+		return -ENOMEM;
+
+	if (cmd->pool == KCAS_ALLOC_BENCH_MPOOL_MAG &&
+			env_mpool_enable_magazines(bench->mpool)) {
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void _cas_alloc_bench_destroy_pool(struct cas_alloc_bench *bench)
+{
+	if (bench->mpool)
+		env_mpool_destroy(bench->mpool);
+	if (bench->allocator)
+		env_allocator_destroy(bench->allocator);
+}
+
+static int _cas_alloc_bench_start(struct cas_alloc_bench *bench)
+{
+	struct cas_alloc_bench_worker *w;
+	struct task_struct *thread;
+	int cpu = -1;
+	uint32_t i;
+
+	for (i = 0; i < bench->nr_workers; i++) {
+		w = &bench->workers[i];
+
+		cpu = cpumask_next(cpu, cpu_online_mask);
+		if (cpu >= nr_cpu_ids)
+			cpu = cpumask_first(cpu_online_mask);
+
+		thread = kthread_create(_cas_alloc_bench_thread, w,
+				"cas_alloc_bench_%u", i);
+		if (IS_ERR(thread))
+			return PTR_ERR(thread);
+
+		/* Thread may exit on its own before it is stopped */
+		get_task_struct(thread);
+		kthread_bind(thread, cpu);
+		w->thread = thread;
+
+		_cas_alloc_bench_counter_create(w);
+	}
+
+	return 0;
+}
+
+static void _cas_alloc_bench_stop(struct cas_alloc_bench *bench)
+{
+	struct cas_alloc_bench_worker *w;
+	uint32_t i;
+
+	WRITE_ONCE(bench->stop, true);
+
+	for (i = 0; i < bench->nr_workers; i++) {
+		w = &bench->workers[i];
+		if (!w->thread)
+			continue;
+
+		kthread_stop(w->thread);
+		put_task_struct(w->thread);
+		_cas_alloc_bench_counter_destroy(w);
+	}
+
+	/* Objects handed over to workers which stopped meanwhile */
+	for (i = 0; i < bench->nr_workers; i++)
+		_cas_alloc_bench_drain(&bench->workers[i]);
+}
+
+static void _cas_alloc_bench_results(struct cas_alloc_bench *bench,
+		struct kcas_alloc_bench *cmd)
+{
+	struct cas_alloc_bench_worker *w;
+	uint64_t a, b;
+	int i;
+
+	cmd->allocs = cmd->failures = cmd->remote_frees = 0;
+	cmd->cache_misses = 0;
+	for (i = 0; i < bench->nr_workers; i++) {
+		w = &bench->workers[i];
+		cmd->allocs += w->allocs;
+		cmd->failures += w->failures;
+		cmd->remote_frees += w->remote_frees;
+
+		if (w->cache_misses == ~0ULL || cmd->cache_misses == ~0ULL)
+			cmd->cache_misses = ~0ULL;
+		else
+			cmd->cache_misses += w->cache_misses;
+	}
+
+	cmd->steals = cmd->fallbacks = 0;
+	cmd->mag_hits = cmd->mag_misses = 0;
+
+	if (bench->allocator) {
+		env_allocator_get_rpool_stats(bench->allocator, &cmd->steals,
+				&cmd->fallbacks);
+		return;
+	}
+
+	for (i = 0; i <= cmd->max_order; i++) {
+		env_mpool_get_rpool_stats(bench->mpool, i, &a, &b);
+		cmd->steals += a;
+		cmd->fallbacks += b;
+	}
+
+	for (i = 0; i < env_mpool_mag_max; i++) {
+		env_mpool_get_magazine_stats(bench->mpool, i, &a, &b);
+		cmd->mag_hits += a;
+		cmd->mag_misses += b;
+	}
+}
+
+int cas_alloc_bench_run(struct kcas_alloc_bench *cmd)
+{
+	struct cas_alloc_bench *bench;
+	struct cas_alloc_bench_worker *w;
+	uint64_t start;
+	uint32_t i;
+	int result;
+
+	if (cmd->pool >= KCAS_ALLOC_BENCH_POOL_MAX || !cmd->threads ||
+			cmd->threads > KCAS_BENCH_THREADS_MAX || !cmd->depth ||
+			cmd->depth > KCAS_ALLOC_BENCH_DEPTH_MAX ||
+			cmd->remote_percent > 100 ||
+			cmd->max_order > KCAS_ALLOC_BENCH_MAX_ORDER ||
+			!cmd->duration ||
+			cmd->duration > KCAS_BENCH_DURATION_MAX) {
+		return -EINVAL;
+	}
+
+	/* Pool names are fixed and runs would skew each other anyway */
+	if (!mutex_trylock(&cas_alloc_bench_lock))
+		return -EBUSY;
+
+	bench = kzalloc(struct_size(bench, workers, cmd->threads), GFP_KERNEL);
+	if (!bench) {
+		result = -ENOMEM;
+		goto unlock;
+	}
+
+	bench->cmd = cmd;
+
+	result = _cas_alloc_bench_create_pool(bench);
+	if (result)
+		goto destroy;
+
+	for (i = 0; i < cmd->threads; i++) {
+		w = &bench->workers[i];
+		w->bench = bench;
+		prandom_seed_state(&w->rnd, get_random_u64() ^ i);
+		init_llist_head(&w->remote);
+		w->cache_misses = ~0ULL;
+
+		w->held = kcalloc(cmd->depth, sizeof(*w->held), GFP_KERNEL);
+		if (!w->held) {
+			result = -ENOMEM;
+			goto free;
+		}
+		bench->nr_workers++;
+	}
+
+	result = _cas_alloc_bench_start(bench);
+	if (result) {
+		_cas_alloc_bench_stop(bench);
+		goto free;
+	}
+
+	start = ktime_get_ns();
+	for (i = 0; i < bench->nr_workers; i++)
+		wake_up_process(bench->workers[i].thread);
+
+	if (msleep_interruptible(cmd->duration * MSEC_PER_SEC))
+		result = -EINTR;
+
+	_cas_alloc_bench_stop(bench);
+
+	cmd->elapsed_ns = ktime_get_ns() - start;
+	_cas_alloc_bench_results(bench, cmd);
+
+free:
+	for (i = 0; i < bench->nr_workers; i++)
+		kfree(bench->workers[i].held);
+destroy:
+	_cas_alloc_bench_destroy_pool(bench);
+	kfree(bench);
+unlock:
+	mutex_unlock(&cas_alloc_bench_lock);
+	return result;
+}
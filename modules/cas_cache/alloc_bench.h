@@ -0,0 +1,22 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __ALLOC_BENCH_H__
+#define __ALLOC_BENCH_H__
+
+/*
+ * Stress of allocators of I/O path. Pool of the same kind as ones used by
+ * I/O path is created for the run only, so that its statistics cover the
+ * run alone. Each thread, bound to its own CPU, holds configured number of
+ * objects and keeps replacing random one of them, handing some of frees
+ * over to thread of next CPU. Hardware cache misses of threads are counted
+ * with perf events where kernel and CPU support it.
+ *
+ * Returns once duration expires or caller is interrupted, with all objects
+ * freed and pool destroyed. Only one run at a time is allowed.
+ */
+int cas_alloc_bench_run(struct kcas_alloc_bench *cmd);
+
+#endif /* __ALLOC_BENCH_H__ */
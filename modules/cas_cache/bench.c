@@ -0,0 +1,396 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "cas_cache.h"
+#include <linux/random.h>
+
+struct cas_bench_hists {
+	struct kcas_lat_hist hist[KCAS_BENCH_HIST_MAX];
+};
+
+struct cas_bench_worker;
+
+/* Slot of queue depth of worker */
+struct cas_bench_io {
+	struct llist_node node;
+	struct cas_bench_worker *worker;
+	uint64_t start;
+	bool write;
+};
+
+struct cas_bench_worker {
+	struct cas_bench *bench;
+	struct task_struct *thread;
+	struct rnd_state rnd;
+
+	struct page *buf;
+		/*< Data of all bios of worker, its content doesn't matter */
+
+	struct cas_bench_io *ios;
+	struct llist_head free;
+		/*< Slots not in flight, taken by worker thread only */
+	wait_queue_head_t wait;
+
+	atomic64_t reads;
+	atomic64_t writes;
+	atomic64_t errors;
+};
+
+struct cas_bench {
+	ocf_core_t core;
+	struct block_device *bd;
+	const struct kcas_bench *cmd;
+
+	uint32_t io_sectors;
+	uint64_t blocks;
+	uint64_t hot_blocks;
+		/*< Range in units of bio size and its hot part */
+
+	struct cas_bench_hists __percpu *hists;
+
+	bool stop;
+
+	atomic_t refs;
+		/*< Bios in flight and one of caller waiting for them */
+	struct completion done;
+
+	uint32_t nr_workers;
+	struct cas_bench_worker workers[];
+};
+
+static uint64_t _cas_bench_rand(struct cas_bench_worker *w, uint64_t max)
+{
+	uint64_t rand = ((uint64_t)prandom_u32_state(&w->rnd) << 32) |
+			prandom_u32_state(&w->rnd);
+	uint64_t rem;
+
+	div64_u64_rem(rand, max, &rem);
+
+	return rem;
+}
+
+static uint64_t _cas_bench_block(struct cas_bench_worker *w)
+{
+	struct cas_bench *bench = w->bench;
+	uint64_t cold_blocks = bench->blocks - bench->hot_blocks;
+
+	if (!bench->hot_blocks)
+		return _cas_bench_rand(w, bench->blocks);
+
+	if (!cold_blocks || prandom_u32_state(&w->rnd) % 100 <
+			bench->cmd->hot_io_percent) {
+		return _cas_bench_rand(w, bench->hot_blocks);
+	}
+
+	return bench->hot_blocks + _cas_bench_rand(w, cold_blocks);
+}
+
+static void _cas_bench_put(struct cas_bench *bench)
+{
+	if (atomic_dec_and_test(&bench->refs))
+		complete(&bench->done);
+}
+
+CAS_DECLARE_BLOCK_CALLBACK(cas_bench_end, struct bio *bio,
+		unsigned int bytes_done, int error)
+{
+	struct cas_bench_io *io;
+	struct cas_bench_worker *w;
+	struct cas_bench *bench;
+	int err;
+
+	CAS_BLOCK_CALLBACK_INIT(bio);
+	io = bio->bi_private;
+	w = io->worker;
+	bench = w->bench;
+	err = CAS_BLOCK_CALLBACK_ERROR(bio, error);
+
+	if (err)
+		atomic64_inc(&w->errors);
+	else if (io->write)
+		atomic64_inc(&w->writes);
+	else
+		atomic64_inc(&w->reads);
+
+	cas_lat_hist_record(&bench->hists->hist[io->write ?
+			KCAS_BENCH_HIST_WR : KCAS_BENCH_HIST_RD], io->start);
+
+	bio_put(bio);
+
+	llist_add(&io->node, &w->free);
+	wake_up(&w->wait);
+
+	/* Worker may be gone once reference is dropped */
+	_cas_bench_put(bench);
+	CAS_BLOCK_CALLBACK_RETURN();
+}
+
+static void _cas_bench_submit(struct cas_bench_io *io)
+{
+	struct cas_bench_worker *w = io->worker;
+	struct cas_bench *bench = w->bench;
+	uint32_t bytes = bench->cmd->io_size, len;
+	struct bio *bio;
+	int i;
+
+	bio = cas_bio_alloc(bench->bd, GFP_NOIO,
+			DIV_ROUND_UP(bytes, PAGE_SIZE));
+	if (!bio) {
+		atomic64_inc(&w->errors);
+		llist_add(&io->node, &w->free);
+		return;
+	}
+
+	io->write = prandom_u32_state(&w->rnd) % 100 >=
+			bench->cmd->read_percent;
+
+	CAS_BIO_SET_DEV(bio, bench->bd);
+	CAS_BIO_BISECTOR(bio) = _cas_bench_block(w) * bench->io_sectors;
+	if (io->write)
+		CAS_BIO_OP_FLAGS(bio) |= WRITE;
+	bio->bi_private = io;
+	bio->bi_end_io = CAS_REFER_BLOCK_CALLBACK(cas_bench_end);
+
+	for (i = 0; bytes; i++, bytes -= len) {
+		len = min_t(uint32_t, bytes, PAGE_SIZE);
+		bio_add_page(bio, w->buf + i, len, 0);
+	}
+
+	atomic_inc(&bench->refs);
+
+	io->start = ktime_get_ns();
+	kcas_core_submit_bio(bench->core, bio);
+	cas_lat_hist_record(&bench->hists->hist[KCAS_BENCH_HIST_SUBMIT],
+			io->start);
+}
+
+static bool _cas_bench_should_stop(struct cas_bench_worker *w)
+{
+	return kthread_should_stop() || READ_ONCE(w->bench->stop);
+}
+
+static int _cas_bench_thread(void *data)
+{
+	struct cas_bench_worker *w = data;
+	struct llist_node *node;
+
+	while (!_cas_bench_should_stop(w)) {
+		node = llist_del_first(&w->free);
+		if (!node) {
+			wait_event(w->wait, !llist_empty(&w->free) ||
+					_cas_bench_should_stop(w));
+			continue;
+		}
+
+		_cas_bench_submit(llist_entry(node, struct cas_bench_io, node));
+		cond_resched();
+	}
+
+	return 0;
+}
+
+static int _cas_bench_worker_init(struct cas_bench *bench,
+		struct cas_bench_worker *w, uint32_t id)
+{
+	uint32_t i;
+
+	w->bench = bench;
+	prandom_seed_state(&w->rnd, get_random_u64() ^ id);
+	init_llist_head(&w->free);
+	init_waitqueue_head(&w->wait);
+	atomic64_set(&w->reads, 0);
+	atomic64_set(&w->writes, 0);
+	atomic64_set(&w->errors, 0);
+
+	w->buf = alloc_pages(GFP_KERNEL, get_order(bench->cmd->io_size));
+	if (!w->buf)
+		return -ENOMEM;
+
+	w->ios = kcalloc(bench->cmd->queue_depth, sizeof(*w->ios), GFP_KERNEL);
+	if (!w->ios) {
+		__free_pages(w->buf, get_order(bench->cmd->io_size));
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < bench->cmd->queue_depth; i++) {
+		w->ios[i].worker = w;
+		llist_add(&w->ios[i].node, &w->free);
+	}
+
+	return 0;
+}
+
+static void _cas_bench_worker_deinit(struct cas_bench_worker *w)
+{
+	kfree(w->ios);
+	__free_pages(w->buf, get_order(w->bench->cmd->io_size));
+}
+
+static int _cas_bench_start(struct cas_bench *bench)
+{
+	struct cas_bench_worker *w;
+	struct task_struct *thread;
+	int cpu = -1;
+	uint32_t i;
+
+	for (i = 0; i < bench->nr_workers; i++) {
+		w = &bench->workers[i];
+
+		cpu = cpumask_next(cpu, cpu_online_mask);
+		if (cpu >= nr_cpu_ids)
+			cpu = cpumask_first(cpu_online_mask);
+
+		thread = kthread_create(_cas_bench_thread, w, "cas_bench_%u",
+				i);
+		if (IS_ERR(thread))
+			return PTR_ERR(thread);
+
+		/* Thread may exit on its own before it is stopped */
+		get_task_struct(thread);
+		kthread_bind(thread, cpu);
+		w->thread = thread;
+	}
+
+	return 0;
+}
+
+static void _cas_bench_stop(struct cas_bench *bench)
+{
+	struct cas_bench_worker *w;
+	uint32_t i;
+
+	WRITE_ONCE(bench->stop, true);
+
+	for (i = 0; i < bench->nr_workers; i++) {
+		w = &bench->workers[i];
+		if (!w->thread)
+			continue;
+
+		kthread_stop(w->thread);
+		put_task_struct(w->thread);
+	}
+
+	/* Wait for bios still in flight */
+	_cas_bench_put(bench);
+	wait_for_completion(&bench->done);
+}
+
+static void _cas_bench_results(struct cas_bench *bench,
+		struct kcas_bench *cmd)
+{
+	struct cas_bench_hists *hists;
+	struct cas_bench_worker *w;
+	int cpu, i, j;
+
+	cmd->reads = cmd->writes = cmd->errors = 0;
+	for (i = 0; i < bench->nr_workers; i++) {
+		w = &bench->workers[i];
+		cmd->reads += atomic64_read(&w->reads);
+		cmd->writes += atomic64_read(&w->writes);
+		cmd->errors += atomic64_read(&w->errors);
+	}
+	cmd->bytes = (cmd->reads + cmd->writes) * cmd->io_size;
+
+	memset(cmd->hist, 0, sizeof(cmd->hist));
+	for_each_possible_cpu(cpu) {
+		hists = per_cpu_ptr(bench->hists, cpu);
+		for (i = 0; i < KCAS_BENCH_HIST_MAX; i++) {
+			for (j = 0; j < KCAS_LAT_HIST_BUCKETS; j++) {
+				cmd->hist[i].buckets[j] +=
+					hists->hist[i].buckets[j];
+			}
+		}
+	}
+}
+
+int cas_bench_run(ocf_core_t core, struct kcas_bench *cmd)
+{
+	struct cas_bench *bench;
+	struct block_device *bd;
+	uint64_t sectors, start;
+	uint32_t i;
+	int result;
+
+	if (!cmd->threads || cmd->threads > KCAS_BENCH_THREADS_MAX ||
+			!cmd->queue_depth ||
+			cmd->queue_depth > KCAS_BENCH_QUEUE_DEPTH_MAX ||
+			!cmd->io_size || cmd->io_size > KCAS_BENCH_IO_SIZE_MAX ||
+			cmd->io_size % SECTOR_SIZE ||
+			cmd->read_percent > 100 || cmd->hot_percent > 100 ||
+			cmd->hot_io_percent > 100 || !cmd->duration ||
+			cmd->duration > KCAS_BENCH_DURATION_MAX) {
+		return -EINVAL;
+	}
+
+#ifndef CAS_DISK_PART0
+	return -EOPNOTSUPP;
+#endif
+
+	bd = kcas_core_get_exported_bdev(core);
+	if (!bd)
+		return -ENODEV;
+
+	sectors = ocf_volume_get_length(ocf_core_get_volume(core)) >>
+			SECTOR_SHIFT;
+	if (cmd->range && cmd->range < sectors)
+		sectors = cmd->range;
+
+	bench = kzalloc(struct_size(bench, workers, cmd->threads), GFP_KERNEL);
+	if (!bench)
+		return -ENOMEM;
+
+	bench->core = core;
+	bench->bd = bd;
+	bench->cmd = cmd;
+	bench->io_sectors = cmd->io_size >> SECTOR_SHIFT;
+	bench->blocks = div_u64(sectors, bench->io_sectors);
+	bench->hot_blocks = div_u64(bench->blocks * cmd->hot_percent, 100);
+	atomic_set(&bench->refs, 1);
+	init_completion(&bench->done);
+
+	if (!bench->blocks) {
+		result = -EINVAL;
+		goto free;
+	}
+
+	bench->hists = alloc_percpu(struct cas_bench_hists);
+	if (!bench->hists) {
+		result = -ENOMEM;
+		goto free;
+	}
+
+	for (i = 0; i < cmd->threads; i++) {
+		result = _cas_bench_worker_init(bench, &bench->workers[i], i);
+		if (result)
+			goto deinit;
+		bench->nr_workers++;
+	}
+
+	result = _cas_bench_start(bench);
+	if (result) {
+		_cas_bench_stop(bench);
+		goto deinit;
+	}
+
+	start = ktime_get_ns();
+	for (i = 0; i < bench->nr_workers; i++)
+		wake_up_process(bench->workers[i].thread);
+
+	if (msleep_interruptible(cmd->duration * MSEC_PER_SEC))
+		result = -EINTR;
+
+	_cas_bench_stop(bench);
+
+	cmd->elapsed_ns = ktime_get_ns() - start;
+	_cas_bench_results(bench, cmd);
+
+deinit:
+	for (i = 0; i < bench->nr_workers; i++)
+		_cas_bench_worker_deinit(&bench->workers[i]);
+	free_percpu(bench->hists);
+free:
+	kfree(bench);
+	return result;
+}
@@ -0,0 +1,21 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+/*
+ * Closed loop benchmark of exported object of core. Each thread, bound to
+ * its own CPU, keeps queue depth of bios in flight and submits them straight
+ * to exported object, so that neither syscalls nor block layer are measured.
+ * Bios are addressed randomly, aligned to their size, with configured share
+ * of them going to hot part of range. Data of bios is not initialized.
+ *
+ * Called with cache read lock held. Returns once duration expires or caller
+ * is interrupted, with all bios completed.
+ */
+int cas_bench_run(ocf_core_t core, struct kcas_bench *cmd);
+
+#endif /* __BENCH_H__ */
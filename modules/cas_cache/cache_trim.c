@@ -0,0 +1,230 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "cas_cache.h"
+
+/* Period of rate budget refills and of checks whether cache got empty */
+#define CAS_CACHE_TRIM_INTERVAL (HZ / 10)
+
+#define CAS_CACHE_TRIM_CHUNK (1ULL << CAS_BD_TRIM_CHUNK_SHIFT)
+
+enum cas_cache_trim_state {
+	CAS_CACHE_TRIM_WAIT_EMPTY,
+		/*< Waiting for no cache line to be valid */
+
+	CAS_CACHE_TRIM_CONFIRM,
+		/*< Tracking reset, waiting for writes issued before to
+		 *  complete, i.e. for cache to stay empty for an interval */
+
+	CAS_CACHE_TRIM_RUNNING,
+		/*< Discarding chunks not written since reset */
+
+	CAS_CACHE_TRIM_DONE,
+		/*< Whole area passed, waiting for cache to be used again */
+};
+
+struct cas_cache_trim {
+	ocf_cache_t cache;
+
+	uint32_t rate;
+		/*< MiB per second */
+
+	enum cas_cache_trim_state state;
+
+	uint64_t cursor;
+		/*< First chunk not passed yet */
+
+	atomic64_t trimmed;
+		/*< Chunks discarded */
+
+	struct completion done;
+	int error;
+
+	struct delayed_work work;
+};
+
+static void _cas_cache_trim_end(ocf_io_t io, void *priv1, void *priv2,
+		int error)
+{
+	struct cas_cache_trim *trim = priv1;
+
+	trim->error = error;
+	complete(&trim->done);
+	ocf_io_put(io);
+}
+
+static int _cas_cache_trim_discard(struct cas_cache_trim *trim,
+		uint64_t addr, uint64_t bytes)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(trim->cache);
+	ocf_io_t io;
+
+	io = ocf_volume_new_io(ocf_cache_get_volume(trim->cache),
+			cache_priv->mngt_queue, addr, bytes, OCF_WRITE, 0, 0);
+	if (!io)
+		return -OCF_ERR_NO_MEM;
+
+	reinit_completion(&trim->done);
+	ocf_io_set_cmpl(io, trim, NULL, _cas_cache_trim_end);
+	ocf_volume_submit_discard(io);
+	wait_for_completion(&trim->done);
+
+	return trim->error;
+}
+
+/* Discard budget of single interval worth of chunks */
+static void _cas_cache_trim_run(struct cas_cache_trim *trim)
+{
+	ocf_volume_t volume = ocf_cache_get_volume(trim->cache);
+	struct bd_object *bdobj = bd_object(volume);
+	uint64_t budget, chunks, first;
+	int error;
+
+	budget = div_u64((uint64_t)READ_ONCE(trim->rate) *
+			CAS_CACHE_TRIM_INTERVAL, HZ);
+	budget = max_t(uint64_t, budget, 1);
+
+	while (budget) {
+		first = trim->cursor;
+		chunks = block_dev_trim_fence(volume, &first, budget);
+		if (!chunks) {
+			trim->state = CAS_CACHE_TRIM_DONE;
+			return;
+		}
+
+		error = _cas_cache_trim_discard(trim, bdobj->trim_base +
+				(first << CAS_BD_TRIM_CHUNK_SHIFT),
+				chunks << CAS_BD_TRIM_CHUNK_SHIFT);
+		block_dev_trim_release(volume);
+		if (error) {
+			/* Device won't take it, so give up until next reset */
+			trim->state = CAS_CACHE_TRIM_DONE;
+			return;
+		}
+
+		atomic64_add(chunks, &trim->trimmed);
+		trim->cursor = first + chunks;
+		budget -= chunks;
+	}
+}
+
+static void _cas_cache_trim_update(struct cas_cache_trim *trim)
+{
+	ocf_volume_t volume = ocf_cache_get_volume(trim->cache);
+	struct ocf_cache_info info;
+	bool empty;
+
+	if (trim->state == CAS_CACHE_TRIM_RUNNING) {
+		_cas_cache_trim_run(trim);
+		return;
+	}
+
+	if (ocf_cache_get_info(trim->cache, &info))
+		return;
+
+	empty = !info.occupancy;
+
+	switch (trim->state) {
+	case CAS_CACHE_TRIM_WAIT_EMPTY:
+		if (!empty)
+			break;
+		/* Lines mapped from now on mark their chunks written */
+		block_dev_trim_reset(volume);
+		trim->state = CAS_CACHE_TRIM_CONFIRM;
+		break;
+	case CAS_CACHE_TRIM_CONFIRM:
+		trim->state = empty ? CAS_CACHE_TRIM_RUNNING :
+				CAS_CACHE_TRIM_WAIT_EMPTY;
+		trim->cursor = 0;
+		break;
+	case CAS_CACHE_TRIM_DONE:
+		if (!empty)
+			trim->state = CAS_CACHE_TRIM_WAIT_EMPTY;
+		break;
+	default:
+		break;
+	}
+}
+
+static void _cas_cache_trim_work(struct work_struct *work)
+{
+	struct cas_cache_trim *trim = container_of(to_delayed_work(work),
+			struct cas_cache_trim, work);
+
+	/* Cache being stopped or detached waits for the work */
+	if (!ocf_mngt_cache_read_trylock(trim->cache)) {
+		if (READ_ONCE(trim->rate) &&
+				ocf_cache_is_device_attached(trim->cache)) {
+			_cas_cache_trim_update(trim);
+		}
+		ocf_mngt_cache_read_unlock(trim->cache);
+	}
+
+	if (READ_ONCE(trim->rate)) {
+		queue_delayed_work(system_unbound_wq, &trim->work,
+				CAS_CACHE_TRIM_INTERVAL);
+	}
+}
+
+struct cas_cache_trim *cas_cache_trim_create(ocf_cache_t cache)
+{
+	struct cas_cache_trim *trim;
+	struct ocf_cache_info info;
+	uint64_t chunks;
+
+	if (ocf_cache_get_info(cache, &info))
+		return NULL;
+
+	chunks = ((uint64_t)info.size * ocf_cache_get_line_size(cache)) >>
+			CAS_BD_TRIM_CHUNK_SHIFT;
+
+	trim = kzalloc(sizeof(*trim), GFP_KERNEL);
+	if (!trim)
+		return NULL;
+
+	trim->cache = cache;
+	trim->state = CAS_CACHE_TRIM_WAIT_EMPTY;
+	atomic64_set(&trim->trimmed, 0);
+	init_completion(&trim->done);
+	INIT_DELAYED_WORK(&trim->work, _cas_cache_trim_work);
+
+	/* Metadata end offset is given in 4 KiB blocks */
+	if (block_dev_trim_start(ocf_cache_get_volume(cache),
+			(uint64_t)info.metadata_end_offset * 4096,
+			chunks)) {
+		kfree(trim);
+		return NULL;
+	}
+
+	return trim;
+}
+
+void cas_cache_trim_destroy(struct cas_cache_trim *trim)
+{
+	WRITE_ONCE(trim->rate, 0);
+	cancel_delayed_work_sync(&trim->work);
+
+	block_dev_trim_stop(ocf_cache_get_volume(trim->cache));
+	kfree(trim);
+}
+
+void cas_cache_trim_set_rate(struct cas_cache_trim *trim, uint32_t rate)
+{
+	uint32_t old = xchg(&trim->rate, rate);
+
+	if (rate && !old)
+		queue_delayed_work(system_unbound_wq, &trim->work, 0);
+}
+
+uint32_t cas_cache_trim_get_rate(struct cas_cache_trim *trim)
+{
+	return READ_ONCE(trim->rate);
+}
+
+uint64_t cas_cache_trim_get_trimmed(struct cas_cache_trim *trim)
+{
+	return atomic64_read(&trim->trimmed) *
+			(CAS_CACHE_TRIM_CHUNK / (1024 * 1024));
+}
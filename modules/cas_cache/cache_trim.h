@@ -0,0 +1,32 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __CACHE_TRIM_H__
+#define __CACHE_TRIM_H__
+
+struct cas_cache_trim;
+
+/*
+ * Background discard of unused data area of cache device. Data area is
+ * split into chunks and writes to chunks are tracked by cache volume. Once
+ * no cache line is valid, e.g. after purge or removal of all cores, tracking
+ * is reset and chunks not written since then are discarded at given rate,
+ * coalesced into ranges of consecutive chunks. Writes to range being
+ * discarded wait for the discard to complete.
+ */
+struct cas_cache_trim *cas_cache_trim_create(ocf_cache_t cache);
+
+/* Called with cache locked, so that no discard is in flight */
+void cas_cache_trim_destroy(struct cas_cache_trim *trim);
+
+/* Rate of discards in MiB per second */
+void cas_cache_trim_set_rate(struct cas_cache_trim *trim, uint32_t rate);
+
+uint32_t cas_cache_trim_get_rate(struct cas_cache_trim *trim);
+
+/* MiB discarded so far */
+uint64_t cas_cache_trim_get_trimmed(struct cas_cache_trim *trim);
+
+#endif /* __CACHE_TRIM_H__ */
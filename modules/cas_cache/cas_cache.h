@@ -18,6 +18,23 @@
 #include "service_ui_ioctl.h"
 #include "volume/vol_blk_utils.h"
 #include "classifier.h"
+#include "prefetch.h"
+#include "bench.h"
+#include "alloc_bench.h"
+#include "read_ahead.h"
+#include "seq_cutoff.h"
+#include "dirty_throttle.h"
+#include "qos.h"
+#include "cache_trim.h"
+#include "dram_tier.h"
+#include "compress.h"
+#include "utils/utils_lat_hist.h"
+#include "utils/utils_mrc.h"
+#include "utils/utils_hot_set.h"
+#include "utils/utils_io_trace.h"
+#include "utils/utils_tinylfu.h"
+#include "utils/utils_rewrite.h"
+#include "utils/utils_cgroup_stats.h"
 #include "context.h"
 #include <linux/kallsyms.h>
 #include "disk.h"
@@ -40,12 +57,16 @@
 #define SECTOR_SIZE (1<<SECTOR_SHIFT)
 #endif
 
-#define MAX_LINES_PER_IO	16
-
 /**
  * cache/core object types */
 enum {
 	BLOCK_DEVICE_VOLUME = 1,	/**< block device volume */
+	STRIPED_DEVICE_VOLUME = 2,	/**< volume striped over block devices */
+	MIRRORED_DEVICE_VOLUME = 3,	/**< volume mirrored on block devices */
+	DAX_DEVICE_VOLUME = 4,		/**< persistent memory accessed by DAX */
+	NULL_DEVICE_VOLUME = 5,		/**< volume completing I/O instantly */
+	RAM_DEVICE_VOLUME = 6,		/**< volume keeping data in memory */
+	COMPRESSED_DEVICE_VOLUME = 7,	/**< volume compressing its data */
 /** \cond SKIP_IN_DOC */
 	OBJECT_TYPE_MAX,
 /** \endcond */
@@ -57,21 +78,255 @@ struct cas_module {
 
 	struct kmem_cache *disk_cache;
 	struct kmem_cache *exp_obj_cache;
+
+	struct workqueue_struct *exp_obj_wq;
+		/*< Workqueue handling bios deferred by all exported objects */
 };
 
 extern struct cas_module cas_module;
 
 struct cas_classifier;
 
+/* Topologies of cache I/O queues, see queue_topology module parameter */
+enum {
+	CAS_QUEUE_TOPOLOGY_CPU,
+	CAS_QUEUE_TOPOLOGY_LLC,
+	CAS_QUEUE_TOPOLOGY_NODE,
+	CAS_QUEUE_TOPOLOGY_FIXED,
+
+	CAS_QUEUE_TOPOLOGY_MAX
+};
+
+/* Exported object I/O steering, see numa_io_steering module parameter */
+enum {
+	CAS_IO_STEERING_NONE,
+	CAS_IO_STEERING_HOME_NODE,
+	CAS_IO_STEERING_LBA_SHARDS,
+
+	CAS_IO_STEERING_MAX
+};
+
+/* Max NUMA nodes LBA space of cores is sharded across */
+#define CAS_NUMA_SHARDS_MAX 8
+
+/* Porter queue balancing policies, see porter_select module parameter */
+enum {
+	CAS_PORTER_SELECT_SCAN,
+	CAS_PORTER_SELECT_TWO_CHOICES,
+	CAS_PORTER_SELECT_NODE,
+
+	CAS_PORTER_SELECT_MAX
+};
+
+/* Extents per block of encoded metadata map, see struct cas_fs_meta */
+#define CAS_FS_META_BLOCK_EXTENTS 32
+
+struct cas_fs_meta_block {
+	uint64_t lba_beg;
+	uint32_t offset;
+};
+
+/*
+ * Sorted, disjoint filesystem metadata extents of core, delta encoded in
+ * blocks of CAS_FS_META_BLOCK_EXTENTS extents. Skip index holds start of
+ * first extent of each block and offset of block in encoded data.
+ */
+struct cas_fs_meta {
+	uint32_t count;
+	uint32_t blocks_no;
+	/* Size of whole allocation in bytes */
+	uint32_t size;
+	struct cas_fs_meta_block *blocks;
+	uint8_t *data;
+	uint8_t buf[];
+};
+
+/* Number of learned metadata extents buffered until merged into maps */
+#define CAS_FS_META_LEARN_MAX 1024
+
+struct cas_fs_meta_learned {
+	ocf_core_id_t core_id;
+	struct fs_meta_lba extent;
+};
+
+/* Statistics last collected for core or cache, see cache_mngt_get_stats() */
+struct cas_stats_snapshot_entry {
+	seqlock_t lock;
+	bool valid;
+	struct ocf_stats_usage usage;
+	struct ocf_stats_requests req;
+	struct ocf_stats_blocks blocks;
+	struct ocf_stats_errors errors;
+};
+
+struct cas_stats_snapshot {
+	struct rcu_head rcu;
+	/* Indexed by io class id, last entry for all io classes */
+	struct cas_stats_snapshot_entry part[OCF_IO_CLASS_MAX + 1];
+};
+
 struct cache_priv {
 	uint64_t core_id_bitmap[DIV_ROUND_UP(OCF_CORE_MAX, 8*sizeof(uint64_t))];
 	struct cas_classifier *classifier;
 	struct _cache_mngt_stop_context *stop_context;
 	env_atomic flush_interrupt_enabled;
-	struct fs_meta_map fs_meta_dict[OCF_CORE_MAX];
+	/* Filesystem metadata extents of each core, updated under cache
+	 * management lock */
+	struct cas_fs_meta __rcu *fs_meta[OCF_CORE_MAX];
+	/* Statistics snapshots of each core, last entry for whole cache */
+	struct cas_stats_snapshot __rcu *stats_snapshot[OCF_CORE_MAX + 1];
+	/* Metadata extents learned from I/O, see fs_meta_learn parameter */
+	struct {
+		/* Protects stopped, count and pending */
+		spinlock_t lock;
+		bool stopped;
+		uint32_t count;
+		struct cas_fs_meta_learned pending[CAS_FS_META_LEARN_MAX];
+		/* Used only by work merging pending extents into maps */
+		struct cas_fs_meta_learned merging[CAS_FS_META_LEARN_MAX];
+		struct fs_meta_lba extents[CAS_FS_META_LEARN_MAX];
+		struct delayed_work work;
+	} fs_meta_learn;
+	/* Purge running core by core, see _cache_mngt_purge_work() */
+	struct {
+		/* Protects all fields but work */
+		spinlock_t lock;
+		bool active;
+		/* Purged core, OCF_CORE_ID_INVALID for whole cache */
+		ocf_core_id_t core_id;
+		ocf_core_id_t next;
+		/* Inactive core skipped, whole cache purge is needed */
+		bool skipped;
+		uint32_t done;
+		uint32_t total;
+		/* Completed when purge ends, NULL for background purge */
+		struct _cache_mngt_async_context *context;
+		struct delayed_work work;
+	} purge;
+	/* Reads of core ranges into cache, see prefetch.c */
+	struct cas_prefetch prefetch;
+	/* Sequential cutoff threshold overrides of io classes [sectors] */
+	uint64_t seq_cutoff_threshold[OCF_USER_IO_CLASS_MAX];
+	/* Admission of tinylfu promotion policy, NULL if not used */
+	struct cas_tinylfu __rcu *tinylfu;
+	/* Adaptive nhit insertion threshold, updated under management lock */
+	struct {
+		bool enabled;
+		/* Statistics below are set, i.e. first update is done */
+		bool primed;
+		/* Statistics of cache at last update */
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t cache_writes;
+		/* Hit ratio of last interval [0.01%] */
+		uint32_t hit_ratio;
+		struct delayed_work work;
+	} nhit_adapt;
+	/* Adaptive io class priorities, updated under management lock */
+	struct {
+		/* Max shift from configured priorities, 0 - not adapted */
+		uint32_t bound;
+		/* Statistics below are set, i.e. first update is done */
+		bool primed;
+		/* Priorities set in io class configuration */
+		int16_t prio[OCF_USER_IO_CLASS_MAX];
+		/* Hits of io classes at last update */
+		uint64_t hits[OCF_USER_IO_CLASS_MAX];
+		struct delayed_work work;
+	} prio_adapt;
+	/* Background discard of unused cache data area, NULL if disabled,
+	 * changed under management lock */
+	struct cas_cache_trim *trim;
+	/* In-memory tier in front of cache, NULL if not configured */
+	struct cas_dram_tier __rcu *dram_tier;
+	/* Statistics of requests by cgroup, NULL if not collected */
+	struct cas_cgroup_stats *cgroup_stats;
+	/* Bypass of clean reads while cache device is slower than core,
+	 * see blkdev_slow_cache() */
+	struct {
+		/* Read latency of cache device relative to core starting
+		 * bypass [%], 0 - never bypassed */
+		uint32_t threshold;
+		atomic_t active;
+		/* Start of bypass in progress [ns] */
+		uint64_t since;
+		/* Time of bypasses already ended [ns] */
+		atomic64_t total_ns;
+		atomic64_t reads;
+		/* Sequence of bypassed reads picking probes of cache device */
+		atomic_t probe;
+	} slow_bypass;
+	/* Sequential cutoff of cores turned off while cache has room to absorb
+	 * sequential writes, updated under management lock */
+	struct {
+		/* Free space of cache needed to absorb [%], 0 - disabled */
+		uint32_t free;
+		/* Space of cache not taken by dirty data needed to absorb [%] */
+		uint32_t headroom;
+		bool active;
+		/* Start of absorbing in progress [jiffies] */
+		unsigned long since;
+		/* Time of absorbing already ended [ms] */
+		uint64_t total_ms;
+		/* Policies of cores to be restored once absorbing ends */
+		ocf_seq_cutoff_policy policy[OCF_CORE_MAX];
+		DECLARE_BITMAP(saved, OCF_CORE_MAX);
+		struct delayed_work work;
+	} seq_absorb;
+	/* Cache mode switch waiting for dirty data to drain */
+	struct {
+		/* Lazy write mode left, ocf_cache_mode_none if none */
+		ocf_cache_mode_t from;
+		struct delayed_work work;
+	} mode_drain;
+	struct {
+		uint32_t queue_depth;
+		uint32_t hw_queues;
+		uint32_t read_ahead_kb;
+		uint32_t io_opt_kb;
+	} exp_obj_queue_cfg[OCF_CORE_MAX];
 	ocf_queue_t mngt_queue;
 	void *attach_context;
 	bool cache_exported_object_initialized;
+	env_atomic64 defer_pool_exhausted;
+	/* Writes to cache device of standby cache, i.e. replication stream
+	 * its metadata is updated from by OCF incrementally */
+	env_atomic64 standby_writes;
+	/* Duration of last activation of standby cache [ms] */
+	uint32_t activate_ms;
+	/* Pool of exported objects request data, NULL if shared pool is used */
+	struct env_mpool *bvec_pool;
+	int home_node;
+	/* NUMA nodes data I/O is sharded across by LBA, 0 - not sharded */
+	uint32_t numa_shards;
+	/* Log2 of LBA range of single shard [sectors] */
+	uint32_t numa_shard_shift;
+	uint32_t queue_poll_us;
+	/* Sequence of porter queue selections, seeds balancing policies */
+	atomic_t porter_cursor;
+	ocf_cache_t cache;
+	struct hlist_node cpuhp_node;
+	bool cpuhp_registered;
+	struct {
+		/* Serializes cleaning pass start with changing the queues */
+		struct mutex lock;
+		uint32_t workers;
+		uint32_t next;
+		/* Used only with more than one worker, porter queues otherwise */
+		ocf_queue_t queues[CAS_CLEANER_WORKERS_MAX];
+		/* Updated by cleaner thread only and read unsynchronized */
+		uint64_t passes;
+		uint64_t lines_cleaned;
+		uint64_t pass_ns;
+		uint64_t sleep_ns;
+		uint64_t rate;
+		atomic64_t kicks;
+		/* Dirty ratio [%] below which cleaning is deferred while
+		 * writes are mostly rewrites, 0 - never deferred */
+		uint32_t rewrite_defer;
+		/* Recency of writes, NULL if cleaning is never deferred */
+		struct cas_rewrite __rcu *rewrite;
+	} cleaner;
 	struct {
 		struct queue_limits queue_limits;
 		bool fua;
@@ -80,9 +335,79 @@ struct cache_priv {
 	struct {
 		ocf_queue_t worker_queue;
 		ocf_queue_t porter_queue;
-	} queues[];
+		/* Serves idle I/O priority class, see idle_io_queues parameter */
+		ocf_queue_t idle_queue;
+		/* Index of queue of CPU group this CPU belongs to, queues are
+		 * created only by group owners (queue_idx equal to own index)
+		 */
+		uint32_t queue_idx;
+		/* Index of queue serving I/O submitted on this CPU */
+		uint32_t steer_idx;
+		/* Index of queue on node of each shard serving data I/O
+		 * submitted on this CPU, valid up to numa_shards */
+		uint32_t shard_idx[CAS_NUMA_SHARDS_MAX];
+	} queues[]; /* Indexed by CPU id, nr_cpu_ids entries */
 };
 
+static inline bool cache_priv_owns_queue(struct cache_priv *cache_priv,
+		unsigned int cpu)
+{
+	return cache_priv->queues[cpu].queue_idx == cpu &&
+			cache_priv->queues[cpu].porter_queue;
+}
+
+static inline ocf_queue_t cache_priv_get_io_queue(struct cache_priv *cache_priv,
+		unsigned int idx)
+{
+	/* Request based exported object may have more hw queues than CPUs */
+	if (unlikely(idx >= nr_cpu_ids))
+		idx %= nr_cpu_ids;
+
+	/* Steering changes on CPU hotplug, every entry is valid at any time */
+	idx = READ_ONCE(cache_priv->queues[idx].steer_idx);
+
+	return READ_ONCE(cache_priv->queues[idx].worker_queue);
+}
+
+/* Like cache_priv_get_io_queue(), but with LBA sharding data I/O is served
+ * by queue on node owning LBA range of @sector */
+static inline ocf_queue_t cache_priv_get_data_queue(
+		struct cache_priv *cache_priv, unsigned int idx, sector_t sector)
+{
+	uint32_t shards = READ_ONCE(cache_priv->numa_shards);
+	uint32_t shard;
+
+	if (likely(!shards))
+		return cache_priv_get_io_queue(cache_priv, idx);
+
+	if (unlikely(idx >= nr_cpu_ids))
+		idx %= nr_cpu_ids;
+
+	shard = hash_64(sector >> cache_priv->numa_shard_shift, 32) % shards;
+	idx = READ_ONCE(cache_priv->queues[idx].shard_idx[shard]);
+
+	return READ_ONCE(cache_priv->queues[idx].worker_queue);
+}
+
+/* Like cache_priv_get_data_queue(), but keeps idle class I/O off the queues
+ * serving other I/O when idle queues were created */
+static inline ocf_queue_t cache_priv_get_bio_queue(struct cache_priv *cache_priv,
+		unsigned int idx, struct bio *bio, sector_t sector)
+{
+	ocf_queue_t queue;
+
+	if (likely(CAS_BIO_IOPRIO_CLASS(bio) != IOPRIO_CLASS_IDLE))
+		return cache_priv_get_data_queue(cache_priv, idx, sector);
+
+	if (unlikely(idx >= nr_cpu_ids))
+		idx %= nr_cpu_ids;
+
+	idx = READ_ONCE(cache_priv->queues[idx].steer_idx);
+	queue = READ_ONCE(cache_priv->queues[idx].idle_queue);
+
+	return queue ?: READ_ONCE(cache_priv->queues[idx].worker_queue);
+}
+
 extern ocf_ctx_t cas_ctx;
 
 static inline void cache_name_from_id(char *name, uint32_t id)
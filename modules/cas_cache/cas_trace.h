@@ -0,0 +1,169 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM cas_cache
+
+#if !defined(__CAS_TRACE_H__) || defined(TRACE_HEADER_MULTI_READ)
+#define __CAS_TRACE_H__
+
+#include <linux/tracepoint.h>
+
+/*
+ * Static tracepoints of I/O path. Devices are identified by dev_t of
+ * cache/core device, so events of exported object and of the device
+ * below it can be matched. OCF I/O and bios are identified by address.
+ */
+
+DECLARE_EVENT_CLASS(cas_bio,
+	TP_PROTO(dev_t dev, struct bio *bio),
+	TP_ARGS(dev, bio),
+	TP_STRUCT__entry(
+		__field(dev_t, dev)
+		__field(void *, bio)
+		__field(sector_t, sector)
+		__field(unsigned int, size)
+		__field(unsigned int, dir)
+	),
+	TP_fast_assign(
+		__entry->dev = dev;
+		__entry->bio = bio;
+		__entry->sector = CAS_BIO_BISECTOR(bio);
+		__entry->size = CAS_BIO_BISIZE(bio);
+		__entry->dir = bio_data_dir(bio);
+	),
+	TP_printk("%d,%d bio=%p sector=%llu size=%u %s",
+		MAJOR(__entry->dev), MINOR(__entry->dev), __entry->bio,
+		(unsigned long long)__entry->sector, __entry->size,
+		__entry->dir == WRITE ? "W" : "R")
+);
+
+/* Bio arrived at exported object */
+DEFINE_EVENT(cas_bio, cas_bio_queue,
+	TP_PROTO(dev_t dev, struct bio *bio),
+	TP_ARGS(dev, bio)
+);
+
+/* Bio deferred to exported object workqueue */
+DEFINE_EVENT(cas_bio, cas_bio_defer,
+	TP_PROTO(dev_t dev, struct bio *bio),
+	TP_ARGS(dev, bio)
+);
+
+/* Bio submitted to cache/core device */
+DEFINE_EVENT(cas_bio, cas_bd_submit,
+	TP_PROTO(dev_t dev, struct bio *bio),
+	TP_ARGS(dev, bio)
+);
+
+TRACE_EVENT(cas_bd_complete,
+	TP_PROTO(dev_t dev, struct bio *bio, int error),
+	TP_ARGS(dev, bio, error),
+	TP_STRUCT__entry(
+		__field(dev_t, dev)
+		__field(void *, bio)
+		__field(int, error)
+	),
+	TP_fast_assign(
+		__entry->dev = dev;
+		__entry->bio = bio;
+		__entry->error = error;
+	),
+	TP_printk("%d,%d bio=%p error=%d",
+		MAJOR(__entry->dev), MINOR(__entry->dev), __entry->bio,
+		__entry->error)
+);
+
+TRACE_EVENT(cas_classify,
+	TP_PROTO(dev_t dev, struct bio *bio, uint32_t part_id),
+	TP_ARGS(dev, bio, part_id),
+	TP_STRUCT__entry(
+		__field(dev_t, dev)
+		__field(void *, bio)
+		__field(uint32_t, part_id)
+	),
+	TP_fast_assign(
+		__entry->dev = dev;
+		__entry->bio = bio;
+		__entry->part_id = part_id;
+	),
+	TP_printk("%d,%d bio=%p io_class=%u",
+		MAJOR(__entry->dev), MINOR(__entry->dev), __entry->bio,
+		__entry->part_id)
+);
+
+TRACE_EVENT(cas_ocf_submit,
+	TP_PROTO(dev_t dev, void *io, struct bio *bio, uint64_t addr,
+			uint32_t bytes),
+	TP_ARGS(dev, io, bio, addr, bytes),
+	TP_STRUCT__entry(
+		__field(dev_t, dev)
+		__field(void *, io)
+		__field(void *, bio)
+		__field(uint64_t, addr)
+		__field(uint32_t, bytes)
+	),
+	TP_fast_assign(
+		__entry->dev = dev;
+		__entry->io = io;
+		__entry->bio = bio;
+		__entry->addr = addr;
+		__entry->bytes = bytes;
+	),
+	TP_printk("%d,%d io=%p bio=%p addr=%llu bytes=%u",
+		MAJOR(__entry->dev), MINOR(__entry->dev), __entry->io,
+		__entry->bio, (unsigned long long)__entry->addr,
+		__entry->bytes)
+);
+
+TRACE_EVENT(cas_ocf_complete,
+	TP_PROTO(void *io, int error),
+	TP_ARGS(io, error),
+	TP_STRUCT__entry(
+		__field(void *, io)
+		__field(int, error)
+	),
+	TP_fast_assign(
+		__entry->io = io;
+		__entry->error = error;
+	),
+	TP_printk("io=%p error=%d", __entry->io, __entry->error)
+);
+
+TRACE_EVENT(cas_cleaner_pass_start,
+	TP_PROTO(uint16_t cache_id),
+	TP_ARGS(cache_id),
+	TP_STRUCT__entry(
+		__field(uint16_t, cache_id)
+	),
+	TP_fast_assign(
+		__entry->cache_id = cache_id;
+	),
+	TP_printk("cache=%u", __entry->cache_id)
+);
+
+TRACE_EVENT(cas_cleaner_pass_end,
+	TP_PROTO(uint16_t cache_id, uint32_t interval_ms),
+	TP_ARGS(cache_id, interval_ms),
+	TP_STRUCT__entry(
+		__field(uint16_t, cache_id)
+		__field(uint32_t, interval_ms)
+	),
+	TP_fast_assign(
+		__entry->cache_id = cache_id;
+		__entry->interval_ms = interval_ms;
+	),
+	TP_printk("cache=%u next_run_ms=%u", __entry->cache_id,
+		__entry->interval_ms)
+);
+
+#endif /* __CAS_TRACE_H__ */
+
+/* This part must be outside protection */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE cas_trace
+#include <trace/define_trace.h>
@@ -9,6 +9,22 @@
 #include "classifier.h"
 #include "classifier_defs.h"
 #include <linux/namei.h>
+#include <linux/rculist.h>
+#include <linux/pagemap.h>
+#include <linux/random.h>
+
+extern u32 classifier_inode_cache;
+extern u32 classifier_latency_sample;
+extern u32 classifier_bpf_hook;
+
+/* Max age of cached inode classification result */
+#define CAS_CLS_INODE_CACHE_TTL HZ
+
+/* Max age of cached directory match mask */
+#define CAS_CLS_DIR_CACHE_TTL HZ
+
+/* Max size of file listing ranges of LBA set condition */
+#define CAS_CLS_LBA_SET_FILE_MAX (16 << 20)
 
 /* Kernel log prefix */
 #define CAS_CLS_LOG_PREFIX OCF_PREFIX_SHORT"[Classifier]"
@@ -215,6 +231,8 @@ static int _cas_cls_string_ctr(struct cas_classifier *cls,
 
 	strncpy(ctx->string, data, MAX_STRING_SPECIFIER_LEN);
 	ctx->len = len;
+	ctx->idx = -1;
+	ctx->extension = false;
 
 	c->context = ctx;
 
@@ -282,6 +300,71 @@ static cas_cls_eval_t _cas_cls_file_size_test(
 	return _cas_cls_numeric_test_u(c, i_size_read(io->inode));
 }
 
+/* Rebuild set of resolved directory inodes, called under dirs_lock */
+static void _cas_cls_dir_set_rebuild(struct cas_classifier *cls)
+{
+	struct cas_cls_dir_set *set, *old;
+	struct cas_cls_directory *ctx;
+	uint32_t dirs_no = 0, slots_no, slot;
+	int i;
+
+	for (i = 0; i < CAS_CLS_DIRS_MAX; i++) {
+		if (cls->dirs[i] && cls->dirs[i]->resolved)
+			dirs_no++;
+	}
+
+	/* Keep load factor at most 1/2, so probe sequences stay short */
+	slots_no = roundup_pow_of_two(max(2 * dirs_no, 4U));
+	set = kzalloc(sizeof(*set) + slots_no * sizeof(set->slots[0]),
+			GFP_KERNEL);
+	if (set) {
+		set->slots_mask = slots_no - 1;
+		for (i = 0; i < CAS_CLS_DIRS_MAX; i++) {
+			ctx = cls->dirs[i];
+			if (!ctx || !ctx->resolved)
+				continue;
+
+			slot = hash_long(ctx->i_ino, 32) & set->slots_mask;
+			while (set->slots[slot].ino &&
+					set->slots[slot].ino != ctx->i_ino) {
+				slot = (slot + 1) & set->slots_mask;
+			}
+			set->slots[slot].ino = ctx->i_ino;
+			set->slots[slot].mask |= 1ULL << i;
+		}
+	} else {
+		/* Directory conditions will walk the tree on their own */
+		for (i = 0; i < CAS_CLS_DIRS_MAX; i++) {
+			if (cls->dirs[i])
+				cls->dirs[i]->idx = -1;
+			cls->dirs[i] = NULL;
+		}
+	}
+
+	old = rcu_dereference_protected(cls->dir_set,
+			lockdep_is_held(&cls->dirs_lock));
+	rcu_assign_pointer(cls->dir_set, set);
+	atomic_inc(&cls->generation);
+
+	if (old)
+		kfree_rcu(old, rcu);
+}
+
+/* Get mask of directory conditions resolved to given inode */
+static uint64_t _cas_cls_dir_set_lookup(struct cas_cls_dir_set *set,
+		unsigned long ino)
+{
+	uint32_t slot = hash_long(ino, 32) & set->slots_mask;
+
+	while (set->slots[slot].ino) {
+		if (set->slots[slot].ino == ino)
+			return set->slots[slot].mask;
+		slot = (slot + 1) & set->slots_mask;
+	}
+
+	return 0;
+}
+
 /* Resolve path to inode */
 static void _cas_cls_directory_resolve(struct cas_classifier *cls,
 		struct cas_cls_directory *ctx)
@@ -299,6 +382,9 @@ static void _cas_cls_directory_resolve(struct cas_classifier *cls,
 	if (error) {
 		ctx->resolved = 0;
 		if (o_res) {
+			mutex_lock(&cls->dirs_lock);
+			_cas_cls_dir_set_rebuild(cls);
+			mutex_unlock(&cls->dirs_lock);
 			CAS_CLS_DEBUG_MSG("Removed inode resolution for %s\n",
 					ctx->pathname);
 		}
@@ -310,6 +396,12 @@ static void _cas_cls_directory_resolve(struct cas_classifier *cls,
 	ctx->resolved = 1;
 	path_put(&path);
 
+	if (!o_res || o_ino != ctx->i_ino) {
+		mutex_lock(&cls->dirs_lock);
+		_cas_cls_dir_set_rebuild(cls);
+		mutex_unlock(&cls->dirs_lock);
+	}
+
 	if (!o_res) {
 		CAS_CLS_DEBUG_MSG("Resolved %s to inode: %lu\n", ctx->pathname,
 				ctx->i_ino);
@@ -361,29 +453,14 @@ unlock:
 	return d;
 }
 
-/* Directory condition test function */
-static cas_cls_eval_t _cas_cls_directory_test(
-		struct cas_classifier *cls, struct cas_cls_condition *c,
-		struct cas_cls_io *io, ocf_part_id_t part_id)
+/* Walk up directory tree starting from I/O destination dir until current
+ * dir inode matches condition inode or top directory is reached. */
+static cas_cls_eval_t _cas_cls_directory_walk(struct cas_cls_directory *ctx,
+		struct inode *inode, struct dentry *dentry)
 {
-	struct cas_cls_directory *ctx;
-	struct inode *inode, *p_inode;
-	struct dentry *dentry, *p_dentry;
+	struct inode *p_inode;
+	struct dentry *p_dentry;
 
-	ctx = c->context;
-	inode = io->inode;
-
-	if (!inode || !ctx->resolved)
-		return cas_cls_eval_no;
-
-	/* I/O target inode dentry */
-	dentry = _cas_cls_dir_get_inode_dentry(inode);
-	if (!dentry)
-		return cas_cls_eval_no;
-
-	/* Walk up directory tree starting from I/O destination
-	 * dir until current dir inode matches condition inode or top
-	 * directory is reached. */
 	while (inode) {
 		if (inode->i_ino == ctx->i_ino)
 			return cas_cls_eval_yes;
@@ -406,11 +483,115 @@ static cas_cls_eval_t _cas_cls_directory_test(
 	return cas_cls_eval_no;
 }
 
+/* Collect directory conditions matched by ancestors of given dentry */
+static uint64_t _cas_cls_directory_match_parents(struct cas_cls_dir_set *set,
+		struct inode *inode, struct dentry *dentry)
+{
+	struct inode *p_inode;
+	struct dentry *p_dentry;
+	uint64_t mask = 0;
+
+	for (;;) {
+		spin_lock(&dentry->d_lock);
+		p_dentry = dentry->d_parent;
+		p_inode = p_dentry ? p_dentry->d_inode : NULL;
+		spin_unlock(&dentry->d_lock);
+
+		if (!p_inode || p_inode == inode)
+			return mask;
+
+		mask |= _cas_cls_dir_set_lookup(set, p_inode->i_ino);
+		inode = p_inode;
+		dentry = p_dentry;
+	}
+}
+
+/*
+ * Match all directory conditions with single tree walk. Masks of parent
+ * dentries are cached, so I/O to files of the same directory costs just
+ * a hash probe. Directory moves are not tracked, cached masks expire
+ * after a while.
+ */
+static uint64_t _cas_cls_directory_match(struct cas_classifier *cls,
+		struct inode *inode, struct dentry *dentry)
+{
+	struct cas_cls_dir_set *set = rcu_dereference(cls->dir_set);
+	struct cas_cls_dir_entry *e;
+	uint32_t generation = atomic_read(&cls->generation);
+	struct dentry *parent;
+	uint64_t mask, p_mask;
+	unsigned long idx;
+
+	if (!set)
+		return 0;
+
+	mask = _cas_cls_dir_set_lookup(set, inode->i_ino);
+
+	spin_lock(&dentry->d_lock);
+	parent = dentry->d_parent;
+	spin_unlock(&dentry->d_lock);
+
+	idx = hash_ptr(parent, CAS_CLS_DIR_CACHE_BITS);
+	e = &get_cpu_ptr(cls->dir_cache)->entries[idx];
+	if (e->parent == parent && e->generation == generation &&
+			time_before(jiffies, e->stamp + CAS_CLS_DIR_CACHE_TTL)) {
+		p_mask = e->mask;
+		put_cpu_ptr(cls->dir_cache);
+		return mask | p_mask;
+	}
+	put_cpu_ptr(cls->dir_cache);
+
+	p_mask = _cas_cls_directory_match_parents(set, inode, dentry);
+
+	e = &get_cpu_ptr(cls->dir_cache)->entries[idx];
+	e->parent = parent;
+	e->stamp = jiffies;
+	e->generation = generation;
+	e->mask = p_mask;
+	put_cpu_ptr(cls->dir_cache);
+
+	return mask | p_mask;
+}
+
+/* Directory condition test function */
+static cas_cls_eval_t _cas_cls_directory_test(
+		struct cas_classifier *cls, struct cas_cls_condition *c,
+		struct cas_cls_io *io, ocf_part_id_t part_id)
+{
+	struct cas_cls_directory *ctx;
+	struct inode *inode;
+	struct dentry *dentry;
+
+	ctx = c->context;
+	inode = io->inode;
+
+	if (!inode || !ctx->resolved)
+		return cas_cls_eval_no;
+
+	/* I/O target inode dentry */
+	dentry = _cas_cls_dir_get_inode_dentry(inode);
+	if (!dentry)
+		return cas_cls_eval_no;
+
+	if (ctx->idx < 0)
+		return _cas_cls_directory_walk(ctx, inode, dentry);
+
+	/* Shared by all directory conditions evaluated for this I/O */
+	if (!io->dirs_matched) {
+		io->dirs_mask = _cas_cls_directory_match(cls, inode, dentry);
+		io->dirs_matched = true;
+	}
+
+	return (io->dirs_mask & (1ULL << ctx->idx)) ?
+			cas_cls_eval_yes : cas_cls_eval_no;
+}
+
 /* Directory condition constructor */
 static int _cas_cls_directory_ctr(struct cas_classifier *cls,
 		struct cas_cls_condition *c, char *data)
 {
 	struct cas_cls_directory *ctx;
+	int i;
 
 	if (!data || strlen(data) == 0) {
 		CAS_CLS_MSG(KERN_ERR, "Missing directory specifier\n");
@@ -429,6 +610,18 @@ static int _cas_cls_directory_ctr(struct cas_classifier *cls,
 		return -ENOMEM;
 	}
 
+	/* Nothing resolved yet, so directory set doesn't change */
+	ctx->idx = -1;
+	mutex_lock(&cls->dirs_lock);
+	for (i = 0; cls->dir_cache && i < CAS_CLS_DIRS_MAX; i++) {
+		if (!cls->dirs[i]) {
+			cls->dirs[i] = ctx;
+			ctx->idx = i;
+			break;
+		}
+	}
+	mutex_unlock(&cls->dirs_lock);
+
 	INIT_DELAYED_WORK(&ctx->d_work, _cas_cls_directory_resolve_work);
 	queue_delayed_work(cls->wq, &ctx->d_work,
 			msecs_to_jiffies(10));
@@ -449,6 +642,15 @@ static void _cas_cls_directory_dtr(struct cas_classifier *cls,
 		return;
 
 	cancel_delayed_work_sync(&ctx->d_work);
+
+	mutex_lock(&cls->dirs_lock);
+	if (ctx->idx >= 0 && cls->dirs[ctx->idx] == ctx) {
+		cls->dirs[ctx->idx] = NULL;
+		if (ctx->resolved)
+			_cas_cls_dir_set_rebuild(cls);
+	}
+	mutex_unlock(&cls->dirs_lock);
+
 	kfree(ctx->pathname);
 	kfree(ctx);
 }
@@ -511,6 +713,136 @@ static void _cas_cls_core_id_dtr(struct cas_classifier *cls,
 	c->context = NULL;
 }
 
+/* Find child of trie node labelled with given character */
+static uint32_t _cas_cls_trie_child(struct cas_cls_name_set *set,
+		uint32_t node, char c)
+{
+	uint32_t child = set->nodes[node].child;
+
+	while (child && set->nodes[child].c != c)
+		child = set->nodes[child].sibling;
+
+	return child;
+}
+
+/* Insert string into trie, return node where it ends */
+static uint32_t _cas_cls_trie_insert(struct cas_cls_name_set *set,
+		uint32_t node, const char *string, uint32_t len)
+{
+	uint32_t i, child;
+
+	for (i = 0; i < len; i++) {
+		child = _cas_cls_trie_child(set, node, string[i]);
+		if (!child) {
+			child = set->nodes_no++;
+			set->nodes[child].c = string[i];
+			set->nodes[child].sibling = set->nodes[node].child;
+			set->nodes[node].child = child;
+		}
+		node = child;
+	}
+
+	return node;
+}
+
+/* Rebuild tries of file name conditions, called under names_lock */
+static void _cas_cls_name_set_rebuild(struct cas_classifier *cls)
+{
+	struct cas_cls_name_set *set, *old;
+	struct cas_cls_string *ctx;
+	uint32_t nodes_no = 2, node;
+	int i;
+
+	for (i = 0; i < CAS_CLS_NAMES_MAX; i++) {
+		if (cls->names[i])
+			nodes_no += cls->names[i]->len;
+	}
+
+	set = vzalloc(sizeof(*set) + nodes_no * sizeof(set->nodes[0]));
+	if (set) {
+		set->prefix_root = set->nodes_no++;
+		set->ext_root = set->nodes_no++;
+		for (i = 0; i < CAS_CLS_NAMES_MAX; i++) {
+			ctx = cls->names[i];
+			if (!ctx)
+				continue;
+
+			node = _cas_cls_trie_insert(set, ctx->extension ?
+					set->ext_root : set->prefix_root,
+					ctx->string, ctx->len);
+			set->nodes[node].mask |= 1ULL << i;
+		}
+	} else {
+		/* File name conditions will compare strings on their own */
+		for (i = 0; i < CAS_CLS_NAMES_MAX; i++) {
+			if (cls->names[i])
+				cls->names[i]->idx = -1;
+			cls->names[i] = NULL;
+		}
+	}
+
+	old = rcu_dereference_protected(cls->name_set,
+			lockdep_is_held(&cls->names_lock));
+	rcu_assign_pointer(cls->name_set, set);
+
+	if (old) {
+		synchronize_rcu();
+		vfree(old);
+	}
+}
+
+/* Match all file name conditions with single walk of each trie */
+static uint64_t _cas_cls_name_match(struct cas_classifier *cls,
+		struct dentry *dentry)
+{
+	struct cas_cls_name_set *set = rcu_dereference(cls->name_set);
+	const char *name = dentry->d_name.name;
+	const char *extension;
+	uint32_t len = dentry->d_name.len;
+	uint32_t i, node;
+	uint64_t mask = 0;
+
+	if (!set)
+		return 0;
+
+	/* Every node on the path is a matched prefix */
+	node = set->prefix_root;
+	for (i = 0; i < len; i++) {
+		node = _cas_cls_trie_child(set, node, name[i]);
+		if (!node)
+			break;
+		mask |= set->nodes[node].mask;
+	}
+
+	/* Extension has to match entirely */
+	extension = strrchr(name, '.');
+	if (!extension)
+		return mask;
+
+	node = set->ext_root;
+	for (extension++; *extension && node; extension++)
+		node = _cas_cls_trie_child(set, node, *extension);
+	if (node)
+		mask |= set->nodes[node].mask;
+
+	return mask;
+}
+
+/* Test file name condition against mask shared by all such conditions
+ * evaluated for this I/O */
+static cas_cls_eval_t _cas_cls_name_test(struct cas_classifier *cls,
+		struct cas_cls_string *ctx, struct cas_cls_io *io,
+		struct dentry *dentry)
+{
+	if (!io->names_matched) {
+		io->names_mask = _cas_cls_name_match(cls, dentry);
+		io->names_matched = true;
+	}
+
+	return (io->names_mask & (1ULL << ctx->idx)) ?
+			cas_cls_eval_yes : cas_cls_eval_no;
+}
+
 /* File extension test function */
 static cas_cls_eval_t _cas_cls_extension_test(
 		struct cas_classifier *cls, struct cas_cls_condition *c,
@@ -533,6 +865,9 @@ static cas_cls_eval_t _cas_cls_extension_test(
 	if (!dentry)
 		return cas_cls_eval_no;
 
+	if (ctx->idx >= 0)
+		return _cas_cls_name_test(cls, ctx, io, dentry);
+
 	extension = strrchr(dentry->d_name.name, '.');
 	if (!extension)
 		return cas_cls_eval_no;
@@ -571,6 +906,9 @@ static cas_cls_eval_t _cas_cls_file_name_prefix_test(
 	if (!dentry || !dentry->d_name.name)
 		return cas_cls_eval_no;
 
+	if (ctx->idx >= 0)
+		return _cas_cls_name_test(cls, ctx, io, dentry);
+
 	/* Check if name is not too short, we expect full prefix in name */
 	if (dentry->d_name.len < ctx->len)
 		return cas_cls_eval_no;
@@ -583,6 +921,67 @@ static cas_cls_eval_t _cas_cls_file_name_prefix_test(
 	return cas_cls_eval_no;
 }
 
+/* File name condition constructor, adds string to tries of classifier */
+static int _cas_cls_name_ctr(struct cas_classifier *cls,
+		struct cas_cls_condition *c, char *data, bool extension)
+{
+	struct cas_cls_string *ctx;
+	int result, i;
+
+	result = _cas_cls_string_ctr(cls, c, data);
+	if (result)
+		return result;
+
+	ctx = c->context;
+	ctx->extension = extension;
+
+	mutex_lock(&cls->names_lock);
+	for (i = 0; i < CAS_CLS_NAMES_MAX; i++) {
+		if (!cls->names[i]) {
+			cls->names[i] = ctx;
+			ctx->idx = i;
+			_cas_cls_name_set_rebuild(cls);
+			break;
+		}
+	}
+	mutex_unlock(&cls->names_lock);
+
+	return 0;
+}
+
+/* File extension condition constructor */
+static int _cas_cls_extension_ctr(struct cas_classifier *cls,
+		struct cas_cls_condition *c, char *data)
+{
+	return _cas_cls_name_ctr(cls, c, data, true);
+}
+
+/* File name prefix condition constructor */
+static int _cas_cls_file_name_prefix_ctr(struct cas_classifier *cls,
+		struct cas_cls_condition *c, char *data)
+{
+	return _cas_cls_name_ctr(cls, c, data, false);
+}
+
+/* File name condition destructor */
+static void _cas_cls_name_dtr(struct cas_classifier *cls,
+		struct cas_cls_condition *c)
+{
+	struct cas_cls_string *ctx = c->context;
+
+	if (!ctx)
+		return;
+
+	mutex_lock(&cls->names_lock);
+	if (ctx->idx >= 0 && cls->names[ctx->idx] == ctx) {
+		cls->names[ctx->idx] = NULL;
+		_cas_cls_name_set_rebuild(cls);
+	}
+	mutex_unlock(&cls->names_lock);
+
+	_cas_cls_generic_dtr(cls, c);
+}
+
 /* LBA test function */
 static cas_cls_eval_t _cas_cls_lba_test(
 		struct cas_classifier *cls, struct cas_cls_condition *c,
@@ -593,95 +992,301 @@ static cas_cls_eval_t _cas_cls_lba_test(
 	return _cas_cls_numeric_test_u(c, lba);
 }
 
-/* PID test function */
-static cas_cls_eval_t _cas_cls_pid_test(
+/* LBA set test function */
+static cas_cls_eval_t _cas_cls_lba_set_test(
 		struct cas_classifier *cls, struct cas_cls_condition *c,
 		struct cas_cls_io *io, ocf_part_id_t part_id)
 {
-	/* 'current' is kernel macro that allows to access control block of
-	   currently executing task */
-	struct task_struct *ti = current;
+	struct cas_cls_lba_set *ctx = c->context;
+	uint64_t lba = CAS_BIO_BISECTOR(io->bio);
+	uint32_t l = 0, r = ctx->ranges_no, m;
+
+	/* Find first range starting past @lba */
+	while (l < r) {
+		m = l + (r - l) / 2;
+		if (ctx->ranges[m].first <= lba)
+			l = m + 1;
+		else
+			r = m;
+	}
 
-	return _cas_cls_numeric_test_u(c, ti->pid);
+	if (l && lba <= ctx->ranges[l - 1].last)
+		return cas_cls_eval_yes;
+
+	return cas_cls_eval_no;
 }
 
-/* Process name test function */
-static cas_cls_eval_t _cas_cls_process_name_test(
-		struct cas_classifier *cls, struct cas_cls_condition *c,
-		struct cas_cls_io *io, ocf_part_id_t part_id)
+static int _cas_cls_lba_range_cmp(const void *a, const void *b)
 {
-	struct cas_cls_string *ctx;
-	/* 'current' is kernel macro that allows to access control block of
-	   currently executing task */
-	struct task_struct *ti = current;
-	char comm[TASK_COMM_LEN];
-	uint32_t len;
+	const struct cas_cls_lba_range *ra = a, *rb = b;
 
-	ctx = c->context;
+	if (ra->first < rb->first)
+		return -1;
 
-	get_task_comm(comm, ti);
+	return ra->first > rb->first;
+}
 
-	len = strnlen(comm, TASK_COMM_LEN);
-	if (len != ctx->len)
-		return cas_cls_eval_no;
+/* Parse "first-last" or "first" range, @line is modified */
+static int _cas_cls_lba_range_parse(char *line,
+		struct cas_cls_lba_range *range)
+{
+	char *last = strchr(line, '-');
+	int result;
 
-	if (strncmp(ctx->string, comm, len) == 0)
-		return cas_cls_eval_yes;
+	if (last)
+		*last++ = '\0';
 
-	return cas_cls_eval_no;
+	result = kstrtoull(strim(line), 10, &range->first);
+	if (result)
+		return result;
+
+	if (!last) {
+		range->last = range->first;
+		return 0;
+	}
+
+	result = kstrtoull(strim(last), 10, &range->last);
+	if (result)
+		return result;
+
+	return range->last < range->first ? -EINVAL : 0;
 }
 
-/* File offset test function */
-static cas_cls_eval_t _cas_cls_file_offset_test(
-		struct cas_classifier *cls, struct cas_cls_condition *c,
-		struct cas_cls_io *io, ocf_part_id_t part_id)
+/* Read whole LBA set file into NULL terminated buffer */
+static char *_cas_cls_lba_set_read(const char *path)
 {
-	struct inode *inode;
-	struct dentry *dentry;
-	uint64_t offset;
-
-	inode = io->inode;
+	struct file *file;
+	loff_t size, pos = 0;
+	ssize_t count;
+	char *buf;
+
+	file = filp_open(path, O_RDONLY, 0);
+	if (IS_ERR(file))
+		return ERR_CAST(file);
+
+	size = i_size_read(file_inode(file));
+	if (size > CAS_CLS_LBA_SET_FILE_MAX) {
+		filp_close(file, NULL);
+		return ERR_PTR(-EFBIG);
+	}
 
-	if (!inode)
-		return cas_cls_eval_no;
+	buf = vmalloc(size + 1);
+	if (!buf) {
+		filp_close(file, NULL);
+		return ERR_PTR(-ENOMEM);
+	}
 
-	/* I/O target inode dentry */
-	dentry = _cas_cls_dir_get_inode_dentry(inode);
-	if (!dentry)
-		return cas_cls_eval_no;
+	while (pos < size) {
+		count = cas_kernel_read(file, buf + pos, size - pos, &pos);
+		if (count <= 0)
+			break;
+	}
+	buf[pos] = '\0';
 
-	offset = PAGE_SIZE * io->page->index +
-		io->bio->bi_io_vec->bv_offset;
+	filp_close(file, NULL);
 
-	return _cas_cls_numeric_test_u(c, offset);
+	return buf;
 }
 
-/* Request size test function */
-static cas_cls_eval_t _cas_cls_request_size_test(
-		struct cas_classifier *cls, struct cas_cls_condition *c,
-		struct cas_cls_io *io, ocf_part_id_t part_id)
+/* LBA set condition constructor. @data is expected to contain path to file
+ * listing sector ranges, one "first-last" or "first" per line. Lines
+ * starting with '#' are ignored. */
+static int _cas_cls_lba_set_ctr(struct cas_classifier *cls,
+		struct cas_cls_condition *c, char *data)
 {
-	return _cas_cls_numeric_test_u(c, CAS_BIO_BISIZE(io->bio));
-}
+	struct cas_cls_lba_set *ctx;
+	char *buf, *line, *next;
+	uint32_t ranges_no = 0, i, j;
+	int result = 0;
 
-/* Array of condition handlers */
-static struct cas_cls_condition_handler _handlers[] = {
-	{ "done", _cas_cls_done_test, _cas_cls_generic_ctr },
-	{ "metadata", _cas_cls_metadata_test, _cas_cls_generic_ctr },
-	{ "direct", _cas_cls_direct_test, _cas_cls_generic_ctr },
-	{ "io_class", _cas_cls_io_class_test, _cas_cls_numeric_ctr,
-			_cas_cls_generic_dtr },
-	{ "file_size", _cas_cls_file_size_test, _cas_cls_numeric_ctr,
-			_cas_cls_generic_dtr },
-	{ "directory", _cas_cls_directory_test, _cas_cls_directory_ctr,
-			_cas_cls_directory_dtr },
-	{ "core_id", _cas_cls_core_id_test, _cas_cls_core_id_ctr,
-			_cas_cls_core_id_dtr },
-	{ "extension", _cas_cls_extension_test, _cas_cls_string_ctr,
-			_cas_cls_generic_dtr },
-	{ "file_name_prefix", _cas_cls_file_name_prefix_test, _cas_cls_string_ctr,
-			_cas_cls_generic_dtr },
+	if (!data || strlen(data) == 0) {
+		CAS_CLS_MSG(KERN_ERR, "Missing LBA set file\n");
+		return -EINVAL;
+	}
+
+	buf = _cas_cls_lba_set_read(data);
+	if (IS_ERR(buf)) {
+		CAS_CLS_MSG(KERN_ERR, "Cannot read LBA set file %s\n", data);
+		return PTR_ERR(buf);
+	}
+
+	for (line = buf; *line; line++)
+		ranges_no += (*line == '\n');
+	ranges_no++;
+
+	ctx = vmalloc(sizeof(*ctx) + ranges_no * sizeof(ctx->ranges[0]));
+	if (!ctx) {
+		vfree(buf);
+		return -ENOMEM;
+	}
+
+	i = 0;
+	for (next = buf; next; ) {
+		line = strsep(&next, "\n");
+		line = strim(line);
+		if (!*line || *line == '#')
+			continue;
+
+		result = _cas_cls_lba_range_parse(line, &ctx->ranges[i]);
+		if (result) {
+			CAS_CLS_MSG(KERN_ERR, "Invalid LBA range %s\n", line);
+			break;
+		}
+		i++;
+	}
+	vfree(buf);
+
+	if (result) {
+		vfree(ctx);
+		return -EINVAL;
+	}
+
+	/* Sort and merge overlapping or adjacent ranges */
+	sort(ctx->ranges, i, sizeof(ctx->ranges[0]), _cas_cls_lba_range_cmp,
+			NULL);
+	for (ranges_no = 0, j = 0; j < i; j++) {
+		if (ranges_no && ctx->ranges[j].first <=
+				ctx->ranges[ranges_no - 1].last + 1) {
+			ctx->ranges[ranges_no - 1].last = max(
+					ctx->ranges[ranges_no - 1].last,
+					ctx->ranges[j].last);
+		} else {
+			ctx->ranges[ranges_no++] = ctx->ranges[j];
+		}
+	}
+	ctx->ranges_no = ranges_no;
+
+	c->context = ctx;
+
+	return 0;
+}
+
+/* LBA set condition destructor */
+static void _cas_cls_lba_set_dtr(struct cas_classifier *cls,
+		struct cas_cls_condition *c)
+{
+	vfree(c->context);
+	c->context = NULL;
+}
+
+/* I/O priority class test function */
+static cas_cls_eval_t _cas_cls_ioprio_test(
+		struct cas_classifier *cls, struct cas_cls_condition *c,
+		struct cas_cls_io *io, ocf_part_id_t part_id)
+{
+	return _cas_cls_numeric_test_u(c, CAS_BIO_IOPRIO_CLASS(io->bio));
+}
+
+/* cgroup test function */
+static cas_cls_eval_t _cas_cls_cgroup_test(
+		struct cas_classifier *cls, struct cas_cls_condition *c,
+		struct cas_cls_io *io, ocf_part_id_t part_id)
+{
+	uint64_t id = cas_bio_cgroup_id(io->bio);
+
+	/* Bio not associated with any cgroup */
+	if (!id)
+		return cas_cls_eval_no;
+
+	return _cas_cls_numeric_test_u(c, id);
+}
+
+/* PID test function */
+static cas_cls_eval_t _cas_cls_pid_test(
+		struct cas_classifier *cls, struct cas_cls_condition *c,
+		struct cas_cls_io *io, ocf_part_id_t part_id)
+{
+	/* 'current' is kernel macro that allows to access control block of
+	   currently executing task */
+	struct task_struct *ti = current;
+
+	return _cas_cls_numeric_test_u(c, ti->pid);
+}
+
+/* Process name test function */
+static cas_cls_eval_t _cas_cls_process_name_test(
+		struct cas_classifier *cls, struct cas_cls_condition *c,
+		struct cas_cls_io *io, ocf_part_id_t part_id)
+{
+	struct cas_cls_string *ctx;
+	/* 'current' is kernel macro that allows to access control block of
+	   currently executing task */
+	struct task_struct *ti = current;
+	char comm[TASK_COMM_LEN];
+	uint32_t len;
+
+	ctx = c->context;
+
+	get_task_comm(comm, ti);
+
+	len = strnlen(comm, TASK_COMM_LEN);
+	if (len != ctx->len)
+		return cas_cls_eval_no;
+
+	if (strncmp(ctx->string, comm, len) == 0)
+		return cas_cls_eval_yes;
+
+	return cas_cls_eval_no;
+}
+
+/* File offset test function */
+static cas_cls_eval_t _cas_cls_file_offset_test(
+		struct cas_classifier *cls, struct cas_cls_condition *c,
+		struct cas_cls_io *io, ocf_part_id_t part_id)
+{
+	struct inode *inode;
+	struct dentry *dentry;
+	uint64_t offset;
+
+	inode = io->inode;
+
+	if (!inode)
+		return cas_cls_eval_no;
+
+	/* I/O target inode dentry */
+	dentry = _cas_cls_dir_get_inode_dentry(inode);
+	if (!dentry)
+		return cas_cls_eval_no;
+
+	offset = PAGE_SIZE * io->page->index +
+		io->bio->bi_io_vec->bv_offset;
+
+	return _cas_cls_numeric_test_u(c, offset);
+}
+
+/* Request size test function */
+static cas_cls_eval_t _cas_cls_request_size_test(
+		struct cas_classifier *cls, struct cas_cls_condition *c,
+		struct cas_cls_io *io, ocf_part_id_t part_id)
+{
+	return _cas_cls_numeric_test_u(c, CAS_BIO_BISIZE(io->bio));
+}
+
+/* Array of condition handlers */
+static struct cas_cls_condition_handler _handlers[] = {
+	{ "done", _cas_cls_done_test, _cas_cls_generic_ctr, NULL, true },
+	{ "metadata", _cas_cls_metadata_test, _cas_cls_generic_ctr, NULL,
+			true },
+	{ "direct", _cas_cls_direct_test, _cas_cls_generic_ctr, NULL, true },
+	{ "io_class", _cas_cls_io_class_test, _cas_cls_numeric_ctr,
+			_cas_cls_generic_dtr },
+	{ "file_size", _cas_cls_file_size_test, _cas_cls_numeric_ctr,
+			_cas_cls_generic_dtr, true },
+	{ "directory", _cas_cls_directory_test, _cas_cls_directory_ctr,
+			_cas_cls_directory_dtr, true },
+	{ "core_id", _cas_cls_core_id_test, _cas_cls_core_id_ctr,
+			_cas_cls_core_id_dtr },
+	{ "extension", _cas_cls_extension_test, _cas_cls_extension_ctr,
+			_cas_cls_name_dtr, true },
+	{ "file_name_prefix", _cas_cls_file_name_prefix_test,
+			_cas_cls_file_name_prefix_ctr, _cas_cls_name_dtr, true },
 	{ "lba", _cas_cls_lba_test, _cas_cls_numeric_ctr, _cas_cls_generic_dtr },
+	{ "lba_set", _cas_cls_lba_set_test, _cas_cls_lba_set_ctr,
+			_cas_cls_lba_set_dtr },
+	{ "ioprio", _cas_cls_ioprio_test, _cas_cls_numeric_ctr,
+			_cas_cls_generic_dtr },
+	{ "cgroup", _cas_cls_cgroup_test, _cas_cls_numeric_ctr,
+			_cas_cls_generic_dtr },
 	{ "pid", _cas_cls_pid_test, _cas_cls_numeric_ctr, _cas_cls_generic_dtr },
 	{ "process_name", _cas_cls_process_name_test, _cas_cls_string_ctr,
 					_cas_cls_generic_dtr },
@@ -717,6 +1322,7 @@ static void _cas_cls_free_condition(struct cas_classifier *cls,
 {
 	if (c->handler->dtr)
 		c->handler->dtr(cls, c);
+	free_percpu(c->evaluations);
 	kfree(c);
 }
 
@@ -740,6 +1346,12 @@ static struct cas_cls_condition * _cas_cls_create_condition(
 	if (!c)
 		return ERR_PTR(-ENOMEM);
 
+	c->evaluations = alloc_percpu(u64);
+	if (!c->evaluations) {
+		kfree(c);
+		return ERR_PTR(-ENOMEM);
+	}
+
 	c->handler = h;
 	c->context = NULL;
 	c->l_op = l_op;
@@ -747,6 +1359,7 @@ static struct cas_cls_condition * _cas_cls_create_condition(
 	if (c->handler->ctr) {
 		result = c->handler->ctr(cls, c, data);
 		if (result) {
+			free_percpu(c->evaluations);
 			kfree(c);
 			return ERR_PTR(result);
 		}
@@ -881,6 +1494,8 @@ static void _cas_cls_rule_destroy(struct cas_classifier *cls,
 		_cas_cls_free_condition(cls, c);
 	}
 
+	free_percpu(r->stats);
+	kfree(r->text);
 	kfree(r);
 }
 
@@ -908,6 +1523,15 @@ static struct cas_cls_rule *_cas_cls_rule_create(struct cas_classifier *cls,
 
 	r->part_id = part_id;
 	INIT_LIST_HEAD(&r->conditions);
+	r->stats = alloc_percpu(struct cas_cls_rule_stats);
+	r->text = kstrdup(rule, GFP_KERNEL);
+	if (!r->stats || !r->text) {
+		free_percpu(r->stats);
+		kfree(r->text);
+		kfree(r);
+		return ERR_PTR(-ENOMEM);
+	}
+
 	result = _cas_cls_parse_conditions(cls, r, rule);
 	if (result) {
 		_cas_cls_rule_destroy(cls, r);
@@ -917,19 +1541,114 @@ static struct cas_cls_rule *_cas_cls_rule_create(struct cas_classifier *cls,
 	return r;
 }
 
-/* Update rule associated with given io class */
-void cas_cls_rule_apply(ocf_cache_t cache,
+/* Get threshold rule property and its upper bound */
+static bool _cas_cls_rule_threshold(struct cas_cls_rule *r,
+		enum cas_cls_property *property, uint64_t *max)
+{
+	struct cas_cls_condition *c, *done;
+	struct cas_cls_numeric *ctx;
+
+	if (list_empty(&r->conditions) || list_is_singular(&r->conditions))
+		return false;
+
+	c = list_first_entry(&r->conditions, struct cas_cls_condition, list);
+	done = list_next_entry(c, list);
+	if (!list_is_last(&done->list, &r->conditions))
+		return false;
+
+	if (done->handler->test != _cas_cls_done_test ||
+			done->l_op != cas_cls_logical_and) {
+		return false;
+	}
+
+	if (c->handler->test == _cas_cls_file_size_test)
+		*property = cas_cls_property_file_size;
+	else if (c->handler->test == _cas_cls_request_size_test)
+		*property = cas_cls_property_request_size;
+	else
+		return false;
+
+	ctx = c->context;
+	switch (ctx->operator) {
+	case cas_cls_numeric_le:
+		*max = ctx->v_u64;
+		return true;
+	case cas_cls_numeric_lt:
+		if (!ctx->v_u64)
+			return false;
+		*max = ctx->v_u64 - 1;
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Compile rules list into classification program */
+static struct cas_cls_program *_cas_cls_compile(struct cas_classifier *cls)
+{
+	struct cas_cls_program *prog;
+	struct cas_cls_threshold *thresholds;
+	struct cas_cls_step *step;
+	enum cas_cls_property property;
+	struct cas_cls_condition *c;
+	struct cas_cls_rule *r;
+	uint32_t rules_no = 0;
+	uint64_t max;
+
+	list_for_each_entry(r, &cls->rules, list)
+		rules_no++;
+
+	prog = kzalloc(sizeof(*prog) + rules_no * (sizeof(prog->steps[0]) +
+			sizeof(*thresholds)), GFP_KERNEL);
+	if (!prog)
+		return NULL;
+
+	thresholds = (void *)&prog->steps[rules_no];
+	prog->inode_cacheable = true;
+
+	list_for_each_entry(r, &cls->rules, list) {
+		list_for_each_entry(c, &r->conditions, list) {
+			if (!c->handler->inode_only)
+				prog->inode_cacheable = false;
+		}
+
+		if (!_cas_cls_rule_threshold(r, &property, &max)) {
+			prog->steps[prog->steps_no++].rule = r;
+			continue;
+		}
+
+		step = prog->steps_no ? &prog->steps[prog->steps_no - 1] : NULL;
+		if (!step || step->rule || step->property != property) {
+			step = &prog->steps[prog->steps_no++];
+			step->property = property;
+			step->thresholds = thresholds;
+		}
+
+		/* Rule shadowed by earlier one with higher bound never wins */
+		if (step->thresholds_no &&
+				step->thresholds[step->thresholds_no - 1].max >= max) {
+			continue;
+		}
+
+		thresholds->max = max;
+		thresholds->part_id = r->part_id;
+		thresholds->rule = r;
+		thresholds++;
+		step->thresholds_no++;
+	}
+
+	return prog;
+}
+
+/* Replace rule of given io class in rules list, called under cls->lock.
+ * Returns replaced rule, it's up to the caller to free it past grace
+ * period. */
+static struct cas_cls_rule *_cas_cls_rule_swap(struct cas_classifier *cls,
 		ocf_part_id_t part_id, struct cas_cls_rule *new)
 {
-	struct cas_classifier *cls;
 	struct cas_cls_rule *old = NULL, *elem;
 	struct list_head *item, *_n;
 
-	cls = cas_get_classifier(cache);
-	BUG_ON(!cls);
-
-	write_lock(&cls->lock);
-
 	/* Walk through list of rules in reverse order (tail to head), visiting
 	 * rules from high to low part_id */
 	list_for_each_prev_safe(item, _n, &cls->rules) {
@@ -937,27 +1656,125 @@ void cas_cls_rule_apply(ocf_cache_t cache,
 
 		if (elem->part_id == part_id) {
 			old = elem;
-			list_del(item);
+			break;
 		}
 
 		if (elem->part_id < part_id)
 			break;
 	}
 
-	/* Insert new element past loop cursor */
-	if (new)
-		list_add(&new->list, item);
-
-	write_unlock(&cls->lock);
-
-	_cas_cls_rule_destroy(cls, old);
+	/* Readers see either old or new rule, never both or none */
+	if (old && new)
+		list_replace_rcu(&old->list, &new->list);
+	else if (old)
+		list_del_rcu(&old->list);
+	else if (new)
+		list_add_rcu(&new->list, item); /* Insert past loop cursor */
 
 	if (old)
 		CAS_CLS_DEBUG_MSG("Removed rule for class %d\n", part_id);
 	if (new)
 		CAS_CLS_DEBUG_MSG("New rule for class  %d\n", part_id);
 
-	return;
+	return old;
+}
+
+/* Compile rules list and publish program, called under cls->lock */
+static void _cas_cls_publish(struct cas_classifier *cls)
+{
+	struct cas_cls_program *old_prog;
+
+	/* Without program classification falls back to walking the list */
+	old_prog = rcu_dereference_protected(cls->program,
+			lockdep_is_held(&cls->lock));
+	rcu_assign_pointer(cls->program, _cas_cls_compile(cls));
+	atomic_inc(&cls->generation);
+
+	if (old_prog)
+		kfree_rcu(old_prog, rcu);
+}
+
+/* Update rule associated with given io class */
+void cas_cls_rule_apply(ocf_cache_t cache,
+		ocf_part_id_t part_id, struct cas_cls_rule *new)
+{
+	struct cas_classifier *cls;
+	struct cas_cls_rule *old;
+
+	cls = cas_get_classifier(cache);
+	BUG_ON(!cls);
+
+	mutex_lock(&cls->lock);
+	old = _cas_cls_rule_swap(cls, part_id, new);
+	_cas_cls_publish(cls);
+	mutex_unlock(&cls->lock);
+
+	if (old) {
+		/* Wait for classifications which might still walk old rule */
+		synchronize_rcu();
+		_cas_cls_rule_destroy(cls, old);
+	}
+}
+
+/* Check whether rule of given io class was created from given text */
+bool cas_cls_rule_unchanged(ocf_cache_t cache, ocf_part_id_t part_id,
+		const char *rule)
+{
+	struct cas_classifier *cls;
+	struct cas_cls_rule *r;
+	bool found = false, unchanged;
+
+	cls = cas_get_classifier(cache);
+	if (!cls)
+		return false;
+
+	mutex_lock(&cls->lock);
+	list_for_each_entry(r, &cls->rules, list) {
+		if (r->part_id == part_id) {
+			found = true;
+			break;
+		}
+	}
+	/* Class 0 and empty descriptions never have rule */
+	if (found)
+		unchanged = !strncmp(r->text, rule, OCF_IO_CLASS_NAME_MAX);
+	else
+		unchanged = (part_id == 0 || rule[0] == '\0');
+	mutex_unlock(&cls->lock);
+
+	return unchanged;
+}
+
+/* Update rules of all io classes at once, except those set in @keep */
+void cas_cls_rules_apply(ocf_cache_t cache,
+		struct cas_cls_rule *rules[OCF_USER_IO_CLASS_MAX], uint64_t keep)
+{
+	struct cas_cls_rule *old[OCF_USER_IO_CLASS_MAX] = {};
+	struct cas_classifier *cls;
+	ocf_part_id_t part_id;
+	bool replaced = false;
+
+	cls = cas_get_classifier(cache);
+	BUG_ON(!cls);
+
+	mutex_lock(&cls->lock);
+	for (part_id = 0; part_id < OCF_USER_IO_CLASS_MAX; part_id++) {
+		if (keep & (1ULL << part_id))
+			continue;
+		old[part_id] = _cas_cls_rule_swap(cls, part_id, rules[part_id]);
+		replaced |= !!old[part_id];
+	}
+	/* Classification switches to the whole new set at once */
+	_cas_cls_publish(cls);
+	mutex_unlock(&cls->lock);
+
+	if (!replaced)
+		return;
+
+	/* Single grace period covers all replaced rules */
+	synchronize_rcu();
+	for (part_id = 0; part_id < OCF_USER_IO_CLASS_MAX; part_id++)
+		_cas_cls_rule_destroy(cls, old[part_id]);
 }
 
 /*
@@ -1080,6 +1897,13 @@ void cas_cls_deinit(ocf_cache_t cache)
 
 	destroy_workqueue(cls->wq);
 
+	kfree(rcu_access_pointer(cls->program));
+	kfree(rcu_access_pointer(cls->dir_set));
+	vfree(rcu_access_pointer(cls->name_set));
+	free_percpu(cls->dir_cache);
+	free_percpu(cls->inode_cache);
+	free_percpu(cls->latency);
+	free_percpu(cls->invocations);
 	kfree(cls);
 	cas_set_classifier(cache, NULL);
 
@@ -1099,13 +1923,45 @@ static struct cas_classifier *_cas_cls_init(void)
 
 	INIT_LIST_HEAD(&cls->rules);
 
+	cls->invocations = alloc_percpu(u64);
+	if (!cls->invocations) {
+		kfree(cls);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	cls->latency = alloc_percpu(struct cas_cls_latency);
+	if (!cls->latency) {
+		free_percpu(cls->invocations);
+		kfree(cls);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	if (classifier_inode_cache) {
+		cls->inode_cache = alloc_percpu(struct cas_cls_inode_cache);
+		if (!cls->inode_cache) {
+			free_percpu(cls->latency);
+			free_percpu(cls->invocations);
+			kfree(cls);
+			return ERR_PTR(-ENOMEM);
+		}
+	}
+
+	/* Without cache directory conditions walk the tree on their own */
+	cls->dir_cache = alloc_percpu(struct cas_cls_dir_cache);
+	mutex_init(&cls->dirs_lock);
+	mutex_init(&cls->names_lock);
+
 	cls->wq = alloc_workqueue("kcas_clsd", WQ_UNBOUND | WQ_FREEZABLE, 1);
 	if (!cls->wq) {
+		free_percpu(cls->dir_cache);
+		free_percpu(cls->inode_cache);
+		free_percpu(cls->latency);
+		free_percpu(cls->invocations);
 		kfree(cls);
 		return ERR_PTR(-ENOMEM);
 	}
 
-	rwlock_init(&cls->lock);
+	mutex_init(&cls->lock);
 
 	CAS_CLS_MSG(KERN_INFO, "Initialized IO classifier\n");
 
@@ -1148,6 +2004,7 @@ static cas_cls_eval_t cas_cls_process_rule(struct cas_classifier *cls,
 	cas_cls_eval_t ret = cas_cls_eval_no, rr;
 
 	CAS_CLS_DEBUG_TRACE(" Processing rule for class %d\n", r->part_id);
+	this_cpu_inc(r->stats->evaluations);
 	list_for_each(item, &r->conditions) {
 
 		c = list_entry(item, struct cas_cls_condition, list);
@@ -1155,6 +2012,7 @@ static cas_cls_eval_t cas_cls_process_rule(struct cas_classifier *cls,
 		if (!ret.yes && c->l_op == cas_cls_logical_and)
 			break;
 
+		this_cpu_inc(*c->evaluations);
 		rr = c->handler->test(cls, c, io, *part_id);
 		CAS_CLS_DEBUG_TRACE("  Processing condition %s => %d, stop:%d "
 				"(l_op: %d)\n", c->handler->token, rr.yes,
@@ -1172,6 +2030,9 @@ static cas_cls_eval_t cas_cls_process_rule(struct cas_classifier *cls,
 	CAS_CLS_DEBUG_TRACE("  Rule %d output => %d stop: %d\n", r->part_id,
 		ret.yes, ret.stop);
 
+	if (ret.yes)
+		this_cpu_inc(r->stats->matches);
+
 	return ret;
 }
 
@@ -1209,34 +2070,519 @@ static void _cas_cls_get_bio_context(struct bio *bio,
 	return;
 }
 
-/* Determine I/O class for bio */
-ocf_part_id_t cas_cls_classify(ocf_cache_t cache, struct bio *bio)
+/* Get I/O property value, false if not applicable to this I/O */
+static bool _cas_cls_get_property(struct cas_cls_io *io,
+		enum cas_cls_property property, uint64_t *value)
+{
+	switch (property) {
+	case cas_cls_property_file_size:
+		if (!io->inode || !S_ISREG(io->inode->i_mode))
+			return false;
+		*value = i_size_read(io->inode);
+		return true;
+	case cas_cls_property_request_size:
+		*value = CAS_BIO_BISIZE(io->bio);
+		return true;
+	}
+
+	return false;
+}
+
+/* Run classification program, returns true if evaluation stopped */
+static bool _cas_cls_run_program(struct cas_classifier *cls,
+		struct cas_cls_program *prog, struct cas_cls_io *io,
+		ocf_part_id_t *part_id)
+{
+	struct cas_cls_step *step;
+	cas_cls_eval_t ret;
+	uint32_t i, l, r, m;
+	uint64_t value;
+
+	for (i = 0; i < prog->steps_no; i++) {
+		step = &prog->steps[i];
+
+		if (step->rule) {
+			ret = cas_cls_process_rule(cls, step->rule, io, part_id);
+			if (ret.yes)
+				*part_id = step->rule->part_id;
+			if (ret.stop)
+				return true;
+			continue;
+		}
+
+		if (!_cas_cls_get_property(io, step->property, &value))
+			continue;
+
+		/* First threshold not below value */
+		l = 0;
+		r = step->thresholds_no;
+		while (l < r) {
+			m = l + (r - l) / 2;
+			if (step->thresholds[m].max < value)
+				l = m + 1;
+			else
+				r = m;
+		}
+
+		/* Only the matching rule of table counts as evaluated */
+		if (l < step->thresholds_no) {
+			this_cpu_inc(step->thresholds[l].rule->stats->evaluations);
+			this_cpu_inc(step->thresholds[l].rule->stats->matches);
+			*part_id = step->thresholds[l].part_id;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Classify file I/O using per inode result cache. Entry is valid as long as
+ * neither rules, directory resolution nor file size changed. Renames are
+ * not tracked, so entries also expire after a while.
+ */
+static ocf_part_id_t _cas_cls_classify_inode(struct cas_classifier *cls,
+		struct cas_cls_program *prog, struct cas_cls_io *io)
+{
+	struct inode *inode = io->inode;
+	struct cas_cls_inode_entry *e;
+	uint32_t generation = atomic_read(&cls->generation);
+	loff_t size = i_size_read(inode);
+	ocf_part_id_t part_id = 0;
+	unsigned long idx;
+
+	idx = hash_long(inode->i_ino ^ (unsigned long)inode->i_sb,
+			CAS_CLS_INODE_CACHE_BITS);
+
+	e = &get_cpu_ptr(cls->inode_cache)->entries[idx];
+	if (e->sb == inode->i_sb && e->ino == inode->i_ino &&
+			e->size == size && e->generation == generation &&
+			time_before(jiffies, e->stamp + CAS_CLS_INODE_CACHE_TTL)) {
+		part_id = e->part_id;
+		put_cpu_ptr(cls->inode_cache);
+		return part_id;
+	}
+	put_cpu_ptr(cls->inode_cache);
+
+	_cas_cls_run_program(cls, prog, io, &part_id);
+
+	e = &get_cpu_ptr(cls->inode_cache)->entries[idx];
+	e->sb = inode->i_sb;
+	e->ino = inode->i_ino;
+	e->size = size;
+	e->stamp = jiffies;
+	e->generation = generation;
+	e->part_id = part_id;
+	put_cpu_ptr(cls->inode_cache);
+
+	return part_id;
+}
+
+/*
+ * Attach point for eBPF classification, see classifier_bpf_hook. BPF
+ * program of BPF_MODIFY_RETURN (fmod_ret) type attached here gets read-only
+ * access to the bio, inode of its first page (NULL if not file data) and
+ * cgroup id. It returns IO class id of request, or 0 to leave request to IO
+ * class rules.
+ *
+ * Kernels with BTF fmod_ret id sets get it registered as one of them. Older
+ * ones only let fmod_ret attach to functions allowed for error injection,
+ * where ERRNO type restricts values injected by fail_function, but not ones
+ * returned by BPF programs.
+ */
+noinline int cas_cls_bpf_classify(uint16_t cache_id, const struct bio *bio,
+		const struct inode *inode, uint64_t cgroup_id)
+{
+	/* Keep the call from being optimized away */
+	barrier();
+	return 0;
+}
+CAS_BPF_FMODRET_HOOK(cas_cls_bpf_classify);
+
+void cas_cls_bpf_init(void)
+{
+	int result;
+
+	if (!classifier_bpf_hook)
+		return;
+
+	result = cas_register_bpf_fmodret_hook(cas_cls_bpf_classify);
+	if (result) {
+		printk(KERN_WARNING OCF_PREFIX_SHORT
+				"eBPF classification attach point not available "
+				"(%d), classifier_bpf_hook ignored\n", result);
+		classifier_bpf_hook = 0;
+	}
+}
+
+static ocf_part_id_t _cas_cls_classify(ocf_cache_t cache,
+		struct cas_classifier *cls, struct bio *bio)
 {
-	struct cas_classifier *cls;
 	struct cas_cls_io io = {};
-	struct list_head *item;
+	struct cas_cls_program *prog;
 	struct cas_cls_rule *r;
 	ocf_part_id_t part_id = 0;
 	cas_cls_eval_t ret;
-
-	cls = cas_get_classifier(cache);
-	if (!cls)
-		return 0;
+	int bpf_part_id;
 
 	_cas_cls_get_bio_context(bio, &io);
 
-	read_lock(&cls->lock);
+	if (classifier_bpf_hook) {
+		bpf_part_id = cas_cls_bpf_classify(ocf_cache_get_id(cache),
+				bio, io.inode, cas_bio_cgroup_id(bio));
+		if (bpf_part_id > 0 && bpf_part_id < OCF_USER_IO_CLASS_MAX)
+			return bpf_part_id;
+	}
+
+	rcu_read_lock();
 	CAS_CLS_DEBUG_TRACE("%s\n", "Starting processing");
-	list_for_each(item, &cls->rules) {
-		r = list_entry(item, struct cas_cls_rule, list);
+
+	prog = rcu_dereference(cls->program);
+	if (prog) {
+		if (prog->inode_cacheable && io.inode && cls->inode_cache)
+			part_id = _cas_cls_classify_inode(cls, prog, &io);
+		else
+			_cas_cls_run_program(cls, prog, &io, &part_id);
+		rcu_read_unlock();
+		return part_id;
+	}
+
+	list_for_each_entry_rcu(r, &cls->rules, list) {
 		ret = cas_cls_process_rule(cls, r, &io, &part_id);
 		if (ret.yes)
 			part_id = r->part_id;
 		if (ret.stop)
 			break;
 	}
-	read_unlock(&cls->lock);
+	rcu_read_unlock();
+
+	return part_id;
+}
+
+/* Determine I/O class for bio */
+ocf_part_id_t cas_cls_classify(ocf_cache_t cache, struct bio *bio)
+{
+	struct cas_classifier *cls;
+	ocf_part_id_t part_id;
+	u64 seq, start, ns;
+
+	cls = cas_get_classifier(cache);
+	if (!cls)
+		return 0;
+
+	seq = this_cpu_inc_return(*cls->invocations);
+	if (likely(!classifier_latency_sample ||
+			seq % classifier_latency_sample)) {
+		return _cas_cls_classify(cache, cls, bio);
+	}
+
+	start = ktime_get_ns();
+	part_id = _cas_cls_classify(cache, cls, bio);
+	ns = ktime_get_ns() - start;
+
+	this_cpu_inc(cls->latency->buckets[min_t(u32, ns ? ilog2(ns) : 0,
+			KCAS_IO_CLASS_LATENCY_BUCKETS - 1)]);
 
 	return part_id;
 }
 
+/* Get number of requests classified so far */
+uint64_t cas_cls_get_invocations(ocf_cache_t cache)
+{
+	struct cas_classifier *cls;
+	uint64_t count = 0;
+	int cpu;
+
+	cls = cas_get_classifier(cache);
+	if (!cls)
+		return 0;
+
+	for_each_possible_cpu(cpu)
+		count += *per_cpu_ptr(cls->invocations, cpu);
+
+	return count;
+}
+
+/* Pages of file taken by benchmark requests */
+#define CAS_CLS_BENCH_FILE_PAGES_MAX 4096
+
+/* Pages of file already in page cache, from its start */
+static uint32_t _cas_cls_bench_file_pages(struct file *file,
+		struct page **pages, uint32_t max)
+{
+	pgoff_t index, end;
+	struct page *page;
+	uint32_t count = 0;
+
+	end = DIV_ROUND_UP(i_size_read(file_inode(file)), PAGE_SIZE);
+	for (index = 0; index < end && count < max; index++) {
+		page = find_get_page(file->f_mapping, index);
+		if (page)
+			pages[count++] = page;
+	}
+
+	return count;
+}
+
+static struct bio *_cas_cls_bench_bio(struct kcas_io_class_bench *cmd,
+		struct block_device *bd, uint64_t sectors, struct rnd_state *rnd,
+		struct page **pages, uint32_t pages_no)
+{
+	uint32_t i, first, count = 1 + prandom_u32_state(rnd) % cmd->max_pages;
+	uint64_t rand, sector;
+	struct bio *bio;
+
+	bio = cas_bio_alloc(bd, GFP_KERNEL, count);
+	if (!bio)
+		return NULL;
+
+	rand = ((uint64_t)prandom_u32_state(rnd) << 32) |
+			prandom_u32_state(rnd);
+	div64_u64_rem(rand, max_t(uint64_t, sectors >> (PAGE_SHIFT -
+			SECTOR_SHIFT), 1), &sector);
+
+	CAS_BIO_SET_DEV(bio, bd);
+	CAS_BIO_BISECTOR(bio) = sector << (PAGE_SHIFT - SECTOR_SHIFT);
+	if (prandom_u32_state(rnd) % 100 >= cmd->read_percent)
+		CAS_BIO_OP_FLAGS(bio) |= WRITE;
+
+	/* Single page of no file repeated or consecutive pages of file */
+	first = pages_no > 1 ? prandom_u32_state(rnd) % pages_no : 0;
+	for (i = 0; i < count; i++) {
+		bio_add_page(bio, pages[(first + i) % pages_no], PAGE_SIZE,
+				0);
+	}
+
+	return bio;
+}
+
+int cas_cls_bench(ocf_cache_t cache, ocf_core_t core,
+		struct kcas_io_class_bench *cmd)
+{
+	struct cas_classifier *cls = cas_get_classifier(cache);
+	struct page **file_pages = NULL, *page = NULL;
+	uint32_t file_pages_no = 0, i, round;
+	struct file *file = NULL;
+	struct block_device *bd;
+	struct rnd_state rnd;
+	struct bio **bios;
+	ocf_part_id_t part_id;
+	uint64_t sectors, start;
+	int result = 0;
+
+	if (!cmd->requests ||
+			cmd->requests > KCAS_IO_CLASS_BENCH_REQUESTS_MAX ||
+			!cmd->rounds || !cmd->max_pages ||
+			cmd->max_pages > KCAS_IO_CLASS_BENCH_PAGES_MAX ||
+			cmd->read_percent > 100) {
+		return -EINVAL;
+	}
+
+	if (!cls)
+		return -EINVAL;
+
+	bd = kcas_core_get_exported_bdev(core);
+	if (!bd)
+		return -ENODEV;
+
+	bios = vzalloc(cmd->requests * sizeof(*bios));
+	if (!bios)
+		return -ENOMEM;
+
+	/* Page of no file, classified as filesystem metadata */
+	page = alloc_page(GFP_KERNEL);
+	if (!page) {
+		result = -ENOMEM;
+		goto free;
+	}
+
+	cmd->path[MAX_STR_LEN - 1] = '\0';
+	if (cmd->path[0]) {
+		file = filp_open(cmd->path, O_RDONLY | O_LARGEFILE, 0);
+		if (IS_ERR(file)) {
+			result = PTR_ERR(file);
+			file = NULL;
+			goto free;
+		}
+
+		file_pages = vmalloc(CAS_CLS_BENCH_FILE_PAGES_MAX *
+				sizeof(*file_pages));
+		if (!file_pages) {
+			result = -ENOMEM;
+			goto free;
+		}
+
+		file_pages_no = _cas_cls_bench_file_pages(file, file_pages,
+				CAS_CLS_BENCH_FILE_PAGES_MAX);
+	}
+
+	sectors = ocf_volume_get_length(ocf_core_get_volume(core)) >>
+			SECTOR_SHIFT;
+	prandom_seed_state(&rnd, get_random_u64());
+
+	/* With file given, every other request carries its pages */
+	cmd->file_requests = 0;
+	for (i = 0; i < cmd->requests; i++) {
+		if (file_pages_no && i % 2 == 0) {
+			bios[i] = _cas_cls_bench_bio(cmd, bd, sectors, &rnd,
+					file_pages, file_pages_no);
+			cmd->file_requests++;
+		} else {
+			bios[i] = _cas_cls_bench_bio(cmd, bd, sectors, &rnd,
+					&page, 1);
+		}
+
+		if (!bios[i]) {
+			result = -ENOMEM;
+			goto put;
+		}
+	}
+
+	cmd->classifications = 0;
+	memset(cmd->io_class_hits, 0, sizeof(cmd->io_class_hits));
+
+	start = ktime_get_ns();
+	for (round = 0; round < cmd->rounds; round++) {
+		for (i = 0; i < cmd->requests; i++) {
+			part_id = _cas_cls_classify(cache, cls, bios[i]);
+			if (part_id < OCF_USER_IO_CLASS_MAX)
+				cmd->io_class_hits[part_id]++;
+		}
+		cmd->classifications += cmd->requests;
+
+		if (fatal_signal_pending(current)) {
+			result = -EINTR;
+			break;
+		}
+		cond_resched();
+	}
+	cmd->elapsed_ns = ktime_get_ns() - start;
+
+put:
+	for (i = 0; i < cmd->requests && bios[i]; i++)
+		bio_put(bios[i]);
+	for (i = 0; i < file_pages_no; i++)
+		put_page(file_pages[i]);
+free:
+	vfree(file_pages);
+	if (file)
+		filp_close(file, NULL);
+	if (page)
+		__free_page(page);
+	vfree(bios);
+	return result;
+}
+
+/* Get classification statistics of given I/O class */
+int cas_cls_get_stats(ocf_cache_t cache, struct kcas_io_class_stats *stats)
+{
+	struct cas_cls_rule_stats *rule_stats;
+	struct cas_cls_condition *c;
+	struct cas_classifier *cls;
+	struct cas_cls_rule *r;
+	uint32_t i;
+	int cpu;
+
+	cls = cas_get_classifier(cache);
+	if (!cls)
+		return -EINVAL;
+
+	stats->has_rule = false;
+	stats->evaluations = 0;
+	stats->matches = 0;
+	stats->conditions_no = 0;
+	memset(stats->condition_evaluations, 0,
+			sizeof(stats->condition_evaluations));
+	memset(stats->latency_hist, 0, sizeof(stats->latency_hist));
+
+	stats->classifications = cas_cls_get_invocations(cache);
+	for_each_possible_cpu(cpu) {
+		for (i = 0; i < KCAS_IO_CLASS_LATENCY_BUCKETS; i++) {
+			stats->latency_hist[i] +=
+				per_cpu_ptr(cls->latency, cpu)->buckets[i];
+		}
+	}
+
+	/* Rules and their conditions are freed only after grace period */
+	rcu_read_lock();
+	list_for_each_entry_rcu(r, &cls->rules, list) {
+		if (r->part_id != stats->class_id)
+			continue;
+
+		stats->has_rule = true;
+		for_each_possible_cpu(cpu) {
+			rule_stats = per_cpu_ptr(r->stats, cpu);
+			stats->evaluations += rule_stats->evaluations;
+			stats->matches += rule_stats->matches;
+		}
+
+		list_for_each_entry(c, &r->conditions, list) {
+			if (stats->conditions_no == KCAS_IO_CLASS_CONDITIONS_MAX)
+				break;
+			for_each_possible_cpu(cpu) {
+				stats->condition_evaluations[stats->conditions_no] +=
+					*per_cpu_ptr(c->evaluations, cpu);
+			}
+			stats->conditions_no++;
+		}
+		break;
+	}
+	rcu_read_unlock();
+
+	return 0;
+}
+
+void cas_cls_get_footprint(ocf_cache_t cache, uint32_t *rules_no,
+		uint64_t *bytes)
+{
+	struct cas_cls_condition *c;
+	struct cas_cls_program *prog;
+	struct cas_cls_dir_set *dir_set;
+	struct cas_cls_name_set *name_set;
+	struct cas_classifier *cls;
+	struct cas_cls_rule *r;
+	size_t percpu;
+
+	*rules_no = 0;
+	*bytes = 0;
+
+	cls = cas_get_classifier(cache);
+	if (!cls)
+		return;
+
+	percpu = sizeof(u64) + sizeof(struct cas_cls_latency);
+	if (cls->inode_cache)
+		percpu += sizeof(struct cas_cls_inode_cache);
+	if (cls->dir_cache)
+		percpu += sizeof(struct cas_cls_dir_cache);
+	*bytes = sizeof(*cls) + percpu * num_possible_cpus();
+
+	/* Condition contexts differ per handler and are not accounted */
+	rcu_read_lock();
+	list_for_each_entry_rcu(r, &cls->rules, list) {
+		(*rules_no)++;
+		*bytes += sizeof(*r) + (r->text ? strlen(r->text) + 1 : 0) +
+			sizeof(struct cas_cls_rule_stats) * num_possible_cpus();
+		list_for_each_entry(c, &r->conditions, list)
+			*bytes += sizeof(*c) + sizeof(u64) * num_possible_cpus();
+	}
+
+	prog = rcu_dereference(cls->program);
+	if (prog) {
+		*bytes += sizeof(*prog) + *rules_no * (sizeof(prog->steps[0]) +
+				sizeof(struct cas_cls_threshold));
+	}
+
+	dir_set = rcu_dereference(cls->dir_set);
+	if (dir_set) {
+		*bytes += sizeof(*dir_set) + (dir_set->slots_mask + 1) *
+			sizeof(dir_set->slots[0]);
+	}
+
+	name_set = rcu_dereference(cls->name_set);
+	if (name_set) {
+		*bytes += sizeof(*name_set) + name_set->nodes_no *
+			sizeof(name_set->nodes[0]);
+	}
+	rcu_read_unlock();
+}
@@ -26,8 +26,44 @@ void cas_cls_rule_destroy(ocf_cache_t cache, struct cas_cls_rule *r);
 void cas_cls_rule_apply(ocf_cache_t cache, ocf_part_id_t part_id,
 		struct cas_cls_rule *r);
 
+/* Check whether rule of io class was created from given description */
+bool cas_cls_rule_unchanged(ocf_cache_t cache, ocf_part_id_t part_id,
+		const char *rule);
+
+/* Bind classification rules to all io classes not set in @keep at once */
+void cas_cls_rules_apply(ocf_cache_t cache,
+		struct cas_cls_rule *rules[OCF_USER_IO_CLASS_MAX], uint64_t keep);
+
 /* Determine I/O class for bio */
 ocf_part_id_t cas_cls_classify(ocf_cache_t cache, struct bio *bio);
 
+/* eBPF attach point called by classification, returns 0 unless overridden */
+int cas_cls_bpf_classify(uint16_t cache_id, const struct bio *bio,
+		const struct inode *inode, uint64_t cgroup_id);
+
+/*
+ * Register eBPF attach point if classifier_bpf_hook is set, clearing it if
+ * kernel doesn't allow programs to be attached there
+ */
+void cas_cls_bpf_init(void);
+
+/* Get number of requests classified so far */
+uint64_t cas_cls_get_invocations(ocf_cache_t cache);
+
+/*
+ * Classify synthetic bios to exported object of @core with rules currently
+ * loaded, without submitting them. Rules matching process run in context of
+ * caller.
+ */
+int cas_cls_bench(ocf_cache_t cache, ocf_core_t core,
+		struct kcas_io_class_bench *cmd);
+
+/* Get classification statistics of I/O class given in @stats */
+int cas_cls_get_stats(ocf_cache_t cache, struct kcas_io_class_stats *stats);
+
+/* Get number of rules and approximate memory used by classifier */
+void cas_cls_get_footprint(ocf_cache_t cache, uint32_t *rules_no,
+		uint64_t *bytes);
+
 
 #endif
@@ -19,18 +19,86 @@ struct cas_cls_rule {
 
 	/* Conditions for this rule */
 	struct list_head conditions;
+
+	/* Evaluation counters */
+	struct cas_cls_rule_stats __percpu *stats;
+
+	/* Text description rule was created from */
+	char *text;
+};
+
+struct cas_cls_rule_stats {
+	u64 evaluations;
+	u64 matches;
+};
+
+/* Histogram of sampled classification time */
+struct cas_cls_latency {
+	u64 buckets[KCAS_IO_CLASS_LATENCY_BUCKETS];
 };
 
+struct cas_cls_program;
+struct cas_cls_inode_cache;
+struct cas_cls_directory;
+struct cas_cls_dir_set;
+struct cas_cls_dir_cache;
+
+/* Max number of directory conditions matched with single tree walk */
+#define CAS_CLS_DIRS_MAX 64
+
+struct cas_cls_string;
+struct cas_cls_name_set;
+
+/* Max number of file name conditions matched with single trie walk */
+#define CAS_CLS_NAMES_MAX 64
+
 /* Classifier context - one per cache instance. */
 struct cas_classifier {
 	/* Rules list head */
 	struct list_head rules;
 
+	/* Rules compiled for classification, NULL - walk rules list */
+	struct cas_cls_program __rcu *program;
+
+	/* Per CPU cache of classification results of file inodes, NULL if
+	 * disabled */
+	struct cas_cls_inode_cache __percpu *inode_cache;
+
+	/* Bumped whenever cached classification results become stale */
+	atomic_t generation;
+
+	/* Directory conditions by their bit in directory match mask */
+	struct cas_cls_directory *dirs[CAS_CLS_DIRS_MAX];
+
+	/* Resolved directory inodes of conditions in @dirs */
+	struct cas_cls_dir_set __rcu *dir_set;
+
+	/* Per CPU cache of directory match masks of parent dentries */
+	struct cas_cls_dir_cache __percpu *dir_cache;
+
+	/* Serializes updates of @dirs and @dir_set */
+	struct mutex dirs_lock;
+
+	/* Extension and file name prefix conditions by their bit */
+	struct cas_cls_string *names[CAS_CLS_NAMES_MAX];
+
+	/* Tries of strings of conditions in @names */
+	struct cas_cls_name_set __rcu *name_set;
+
+	/* Serializes updates of @names and @name_set */
+	struct mutex names_lock;
+
 	/* Directory inode resolving workqueue */
 	struct workqueue_struct *wq;
 
-	/* Lock for rules list */
-	rwlock_t lock __attribute__((aligned(64)));
+	/* Number of classified requests */
+	u64 __percpu *invocations;
+
+	/* Sampled classification time, see classifier_latency_sample */
+	struct cas_cls_latency __percpu *latency;
+
+	/* Serializes rules list updates, readers are protected by RCU */
+	struct mutex lock;
 };
 
 struct cas_cls_condition_handler;
@@ -50,6 +118,53 @@ struct cas_cls_condition {
 
 	/* Logical operator to apply to previous conditions evaluation */
 	int l_op;
+
+	/* Number of evaluations of this condition */
+	u64 __percpu *evaluations;
+};
+
+/* I/O properties compared against threshold tables */
+enum cas_cls_property {
+	cas_cls_property_file_size,
+	cas_cls_property_request_size,
+};
+
+/* Threshold table entry, compiled from "<property>:le:<max>&done" rule */
+struct cas_cls_threshold {
+	/* Inclusive upper bound of property value */
+	uint64_t max;
+
+	/* Associated partition id */
+	ocf_part_id_t part_id;
+
+	/* Rule the threshold was compiled from */
+	struct cas_cls_rule *rule;
+};
+
+/* Single classification program step */
+struct cas_cls_step {
+	/* Rule evaluated condition by condition, NULL for threshold table */
+	struct cas_cls_rule *rule;
+
+	/* Property compared against threshold table */
+	enum cas_cls_property property;
+
+	/* Thresholds sorted by ascending max, first one not below property
+	 * value is the first matching rule */
+	struct cas_cls_threshold *thresholds;
+	uint32_t thresholds_no;
+};
+
+/* Rules list compiled on each rule update. Consecutive threshold rules on
+ * the same property collapse into single step resolved with binary search */
+struct cas_cls_program {
+	struct rcu_head rcu;
+
+	/* Result depends only on inode, so it can be cached per inode */
+	bool inode_cacheable;
+
+	uint32_t steps_no;
+	struct cas_cls_step steps[];
 };
 
 /* Helper structure aggregating I/O data often accessed by condition handlers */
@@ -62,6 +177,14 @@ struct cas_cls_io {
 
 	/* Inode associated with page */
 	struct inode *inode;
+
+	/* Directory conditions matched by inode, valid if @dirs_matched */
+	uint64_t dirs_mask;
+	bool dirs_matched;
+
+	/* File name conditions matched by inode, valid if @names_matched */
+	uint64_t names_mask;
+	bool names_matched;
 };
 
 /* Condition evaluation return flags */
@@ -99,6 +222,9 @@ struct cas_cls_condition_handler {
 
 	/* Condition destructor */
 	void (*dtr)(struct cas_classifier *cls, struct cas_cls_condition *c);
+
+	/* Test result is determined by I/O target inode alone */
+	bool inode_only;
 };
 
 /* Numeric condition numeric operators */
@@ -127,6 +253,48 @@ struct cas_cls_string {
 
 	/* String length */
 	uint32_t len;
+
+	/* Bit in file name match mask, -1 if compared per condition */
+	int idx;
+
+	/* Matched against file extension rather than name prefix */
+	bool extension;
+};
+
+/* Inclusive range of sectors */
+struct cas_cls_lba_range {
+	uint64_t first;
+	uint64_t last;
+};
+
+/* LBA set condition context, sorted disjoint ranges */
+struct cas_cls_lba_set {
+	uint32_t ranges_no;
+	struct cas_cls_lba_range ranges[];
+};
+
+/* Trie node, children form a list linked through @sibling */
+struct cas_cls_trie_node {
+	/* Conditions whose string ends at this node */
+	uint64_t mask;
+
+	/* Index of first child and of next sibling, 0 - none */
+	uint32_t child;
+	uint32_t sibling;
+
+	char c;
+};
+
+/* Tries of file name prefixes and extensions matched by conditions */
+struct cas_cls_name_set {
+	struct rcu_head rcu;
+
+	/* Roots of prefix and extension tries */
+	uint32_t prefix_root;
+	uint32_t ext_root;
+
+	uint32_t nodes_no;
+	struct cas_cls_trie_node nodes[];
 };
 
 /* Directory condition context */
@@ -145,6 +313,66 @@ struct cas_cls_directory {
 
 	/* Work item associated with resolving dir for this condition */
 	struct delayed_work d_work;
+
+	/* Bit in directory match mask, -1 if tree is walked per condition */
+	int idx;
+};
+
+/* Open addressing hash set of resolved directory inodes */
+struct cas_cls_dir_set {
+	struct rcu_head rcu;
+
+	/* Number of slots minus one, power of two */
+	uint32_t slots_mask;
+
+	struct {
+		/* Directory inode number, 0 - empty slot */
+		unsigned long ino;
+
+		/* Directory conditions resolved to this inode */
+		uint64_t mask;
+	} slots[];
+};
+
+/* Cached directory match mask of parent dentry */
+struct cas_cls_dir_entry {
+	struct dentry *parent;
+	unsigned long stamp;
+	uint32_t generation;
+	uint64_t mask;
+};
+
+#define CAS_CLS_DIR_CACHE_BITS 6
+
+/* Direct mapped cache of directory match masks */
+struct cas_cls_dir_cache {
+	struct cas_cls_dir_entry entries[1 << CAS_CLS_DIR_CACHE_BITS];
+};
+
+/* Cached classification result of inode */
+struct cas_cls_inode_entry {
+	/* Inode identity */
+	struct super_block *sb;
+	unsigned long ino;
+
+	/* File size at classification time */
+	loff_t size;
+
+	/* Time of classification in jiffies */
+	unsigned long stamp;
+
+	/* Classifier generation entry was created in */
+	uint32_t generation;
+
+	/* Classification result */
+	ocf_part_id_t part_id;
+};
+
+#define CAS_CLS_INODE_CACHE_BITS 8
+
+/* Direct mapped inode classification cache */
+struct cas_cls_inode_cache {
+	struct cas_cls_inode_entry entries[1 << CAS_CLS_INODE_CACHE_BITS];
 };
 
 #endif
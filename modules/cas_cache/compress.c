@@ -0,0 +1,611 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "cas_cache.h"
+
+/* Slots of the same size are packed together in chunks of this size */
+#define CAS_COMPRESS_CHUNK_SECTORS 128
+
+/* Chunks at start of device holding label, never allocated to slots */
+#define CAS_COMPRESS_LABEL_CHUNKS \
+	DIV_ROUND_UP(CAS_COMPRESS_LABEL_SECTORS, CAS_COMPRESS_CHUNK_SECTORS)
+
+/* Map entry holds sector, length less one and io class of slot */
+#define CAS_COMPRESS_MAPPED (1ULL << 63)
+#define CAS_COMPRESS_SHARED (1ULL << 62)
+#define CAS_COMPRESS_CLASS_SHIFT 52
+#define CAS_COMPRESS_CLASS_MASK 0x3fULL
+#define CAS_COMPRESS_LENGTH_SHIFT 40
+#define CAS_COMPRESS_LENGTH_MASK 0xfffULL
+#define CAS_COMPRESS_SECTOR_MASK ((1ULL << CAS_COMPRESS_LENGTH_SHIFT) - 1)
+
+#define CAS_COMPRESS_IO_CLASSES (CAS_COMPRESS_IO_CLASS_OTHER + 1)
+
+/* Indexed slot */
+struct cas_compress_dedup {
+	struct rhash_head node;
+	uint64_t hash;
+	sector_t sector;
+	uint32_t length;
+
+	uint32_t refs;
+		/*< Blocks in map stored in slot and references taken by get */
+
+	uint32_t io_class;
+		/*< IO class sectors of slot are accounted to */
+
+	struct rcu_head rcu;
+};
+
+static const struct rhashtable_params cas_compress_dedup_params = {
+	.key_len = sizeof(uint64_t),
+	.key_offset = offsetof(struct cas_compress_dedup, hash),
+	.head_offset = offsetof(struct cas_compress_dedup, node),
+	.automatic_shrinking = true,
+};
+
+struct cas_compress_chunk {
+	struct list_head node;
+		/*< Entry on list of partially used or free chunks */
+
+	unsigned long slots[BITS_TO_LONGS(CAS_COMPRESS_CHUNK_SECTORS)];
+
+	struct cas_compress_dedup **shared;
+		/*< Index entries of slots, allocated once first slot of chunk
+		 *  is indexed */
+
+	uint8_t sectors;
+		/*< Size of slots of chunk, 0 if chunk is not used */
+
+	uint8_t used;
+};
+
+struct cas_compress {
+	uint64_t blocks;
+	uint64_t *map;
+
+	struct cas_compress_chunk *chunks;
+	uint64_t nr_chunks;
+
+	/* Protects map updates, chunks and statistics */
+	spinlock_t lock;
+
+	uint64_t fresh;
+		/*< Chunks from this one on were never used */
+
+	struct list_head free;
+	struct list_head partial[CAS_COMPRESS_BLOCK_SECTORS];
+		/*< Chunks with free slots, indexed by size of slot less one */
+
+	uint64_t dev_used;
+	uint64_t stored[CAS_COMPRESS_IO_CLASSES];
+	uint64_t packed[CAS_COMPRESS_IO_CLASSES];
+		/*< Blocks of io class in map and sectors of their slots */
+
+	bool enabled[CAS_COMPRESS_IO_CLASSES];
+
+	struct rhashtable dedup_index;
+		/*< Indexed slots by fingerprint */
+
+	bool dedup_index_init;
+	bool dedup;
+
+	uint64_t dedup_slots;
+	uint64_t dedup_refs;
+		/*< Slots indexed and blocks in map stored in them */
+
+	void * __percpu *tfm;
+};
+
+static inline uint32_t _cas_compress_sectors(uint32_t length)
+{
+	return DIV_ROUND_UP(length, SECTOR_SIZE);
+}
+
+struct cas_compress *cas_compress_create(uint64_t dev_sectors, uint32_t ratio)
+{
+	struct cas_compress *comp;
+	uint32_t i;
+	int cpu;
+
+	comp = kzalloc(sizeof(*comp), GFP_KERNEL);
+	if (!comp)
+		return NULL;
+
+	comp->nr_chunks = min_t(uint64_t, dev_sectors,
+			CAS_COMPRESS_SECTOR_MASK) /
+			CAS_COMPRESS_CHUNK_SECTORS;
+	if (comp->nr_chunks <= CAS_COMPRESS_LABEL_CHUNKS)
+		goto error;
+
+	comp->blocks = div_u64((comp->nr_chunks - CAS_COMPRESS_LABEL_CHUNKS) *
+			(CAS_COMPRESS_CHUNK_SECTORS /
+			CAS_COMPRESS_BLOCK_SECTORS) * ratio, 100);
+	if (!comp->blocks)
+		goto error;
+
+	comp->map = vzalloc(array_size(comp->blocks, sizeof(*comp->map)));
+	if (!comp->map)
+		goto error;
+
+	comp->chunks = vzalloc(array_size(comp->nr_chunks,
+			sizeof(*comp->chunks)));
+	if (!comp->chunks)
+		goto error;
+
+	spin_lock_init(&comp->lock);
+	comp->fresh = CAS_COMPRESS_LABEL_CHUNKS;
+	INIT_LIST_HEAD(&comp->free);
+	for (i = 0; i < CAS_COMPRESS_BLOCK_SECTORS; i++)
+		INIT_LIST_HEAD(&comp->partial[i]);
+	for (i = 0; i < CAS_COMPRESS_IO_CLASSES; i++)
+		comp->enabled[i] = true;
+
+	if (rhashtable_init(&comp->dedup_index, &cas_compress_dedup_params))
+		goto error;
+	comp->dedup_index_init = true;
+
+	/* Compressor keeps its workspace in tfm, so each CPU has its own */
+	comp->tfm = alloc_percpu(void *);
+	if (!comp->tfm)
+		goto error;
+
+	for_each_possible_cpu(cpu) {
+		*per_cpu_ptr(comp->tfm, cpu) = cas_comp_alloc();
+		if (!*per_cpu_ptr(comp->tfm, cpu))
+			goto error;
+	}
+
+	return comp;
+
+error:
+	cas_compress_destroy(comp);
+	return NULL;
+}
+
+static void _cas_compress_dedup_destroy(void *ptr, void *arg)
+{
+	kfree(ptr);
+}
+
+void cas_compress_destroy(struct cas_compress *comp)
+{
+	uint64_t i;
+	int cpu;
+
+	if (comp->tfm) {
+		for_each_possible_cpu(cpu) {
+			if (*per_cpu_ptr(comp->tfm, cpu))
+				cas_comp_free(*per_cpu_ptr(comp->tfm, cpu));
+		}
+		free_percpu(comp->tfm);
+	}
+
+	if (comp->dedup_index_init) {
+		rhashtable_free_and_destroy(&comp->dedup_index,
+				_cas_compress_dedup_destroy, NULL);
+	}
+
+	for (i = 0; comp->chunks && i < comp->fresh; i++)
+		kfree(comp->chunks[i].shared);
+
+	vfree(comp->chunks);
+	vfree(comp->map);
+	kfree(comp);
+}
+
+uint64_t cas_compress_get_blocks(struct cas_compress *comp)
+{
+	return comp->blocks;
+}
+
+bool cas_compress_lookup(struct cas_compress *comp, uint64_t block,
+		sector_t *sector, uint32_t *length)
+{
+	uint64_t entry = READ_ONCE(comp->map[block]);
+
+	if (!(entry & CAS_COMPRESS_MAPPED))
+		return false;
+
+	*sector = entry & CAS_COMPRESS_SECTOR_MASK;
+	*length = ((entry >> CAS_COMPRESS_LENGTH_SHIFT) &
+			CAS_COMPRESS_LENGTH_MASK) + 1;
+
+	return true;
+}
+
+uint32_t cas_compress_pack(struct cas_compress *comp, const void *src,
+		void *dst, uint32_t io_class)
+{
+	/* No point in storing compressed block which doesn't save a sector */
+	unsigned int length = CAS_COMPRESS_BLOCK_SIZE - SECTOR_SIZE;
+	int result;
+
+	if (!READ_ONCE(comp->enabled[io_class]))
+		return CAS_COMPRESS_BLOCK_SIZE;
+
+	result = cas_comp_compress(*get_cpu_ptr(comp->tfm), src,
+			CAS_COMPRESS_BLOCK_SIZE, dst, &length);
+	put_cpu_ptr(comp->tfm);
+
+	return result ? CAS_COMPRESS_BLOCK_SIZE : length;
+}
+
+/* Block stored as is is not unpacked, but read straight in place */
+int cas_compress_unpack(struct cas_compress *comp, const void *src,
+		uint32_t length, void *dst)
+{
+	unsigned int unpacked = CAS_COMPRESS_BLOCK_SIZE;
+	int result;
+
+	result = cas_comp_decompress(*get_cpu_ptr(comp->tfm), src, length,
+			dst, &unpacked);
+	put_cpu_ptr(comp->tfm);
+
+	if (!result && unpacked != CAS_COMPRESS_BLOCK_SIZE)
+		result = -EILSEQ;
+
+	return result;
+}
+
+/* Called with lock held */
+static int _cas_compress_alloc_slot(struct cas_compress *comp,
+		uint32_t sectors, sector_t *sector)
+{
+	struct list_head *partial = &comp->partial[sectors - 1];
+	uint32_t slots = CAS_COMPRESS_CHUNK_SECTORS / sectors;
+	struct cas_compress_chunk *chunk;
+	uint32_t slot;
+
+	if (!list_empty(partial)) {
+		chunk = list_first_entry(partial, struct cas_compress_chunk,
+				node);
+	} else if (!list_empty(&comp->free)) {
+		chunk = list_first_entry(&comp->free,
+				struct cas_compress_chunk, node);
+		list_move(&chunk->node, partial);
+		chunk->sectors = sectors;
+	} else if (comp->fresh < comp->nr_chunks) {
+		chunk = &comp->chunks[comp->fresh++];
+		list_add(&chunk->node, partial);
+		chunk->sectors = sectors;
+	} else {
+		return -ENOSPC;
+	}
+
+	slot = find_first_zero_bit(chunk->slots, slots);
+	__set_bit(slot, chunk->slots);
+	if (++chunk->used == slots)
+		list_del_init(&chunk->node);
+
+	*sector = (chunk - comp->chunks) * CAS_COMPRESS_CHUNK_SECTORS +
+			slot * sectors;
+	comp->dev_used += sectors;
+
+	return 0;
+}
+
+/* Called with lock held */
+static void _cas_compress_free_slot(struct cas_compress *comp,
+		uint32_t sectors, sector_t sector)
+{
+	struct cas_compress_chunk *chunk;
+	uint32_t slots = CAS_COMPRESS_CHUNK_SECTORS / sectors;
+
+	chunk = &comp->chunks[sector / CAS_COMPRESS_CHUNK_SECTORS];
+	__clear_bit((sector % CAS_COMPRESS_CHUNK_SECTORS) / sectors,
+			chunk->slots);
+
+	if (chunk->used-- == slots)
+		list_add(&chunk->node, &comp->partial[sectors - 1]);
+	if (!chunk->used) {
+		list_move(&chunk->node, &comp->free);
+		chunk->sectors = 0;
+		kfree(chunk->shared);
+		chunk->shared = NULL;
+	}
+
+	comp->dev_used -= sectors;
+}
+
+/* Called with lock held */
+static struct cas_compress_dedup **_cas_compress_dedup_entry(
+		struct cas_compress *comp, sector_t sector)
+{
+	struct cas_compress_chunk *chunk;
+
+	chunk = &comp->chunks[sector / CAS_COMPRESS_CHUNK_SECTORS];
+
+	return &chunk->shared[(sector % CAS_COMPRESS_CHUNK_SECTORS) /
+			chunk->sectors];
+}
+
+/* Called with lock held */
+static void _cas_compress_dedup_release(struct cas_compress *comp,
+		sector_t sector)
+{
+	struct cas_compress_dedup **entry, *dedup;
+	uint32_t sectors;
+
+	entry = _cas_compress_dedup_entry(comp, sector);
+	dedup = *entry;
+	if (--dedup->refs)
+		return;
+
+	rhashtable_remove_fast(&comp->dedup_index, &dedup->node,
+			cas_compress_dedup_params);
+	*entry = NULL;
+	comp->dedup_slots--;
+
+	sectors = _cas_compress_sectors(dedup->length);
+	comp->packed[dedup->io_class] -= sectors;
+	_cas_compress_free_slot(comp, sectors, sector);
+
+	kfree_rcu(dedup, rcu);
+}
+
+/*
+ * Index slot just written, called with lock held. Failing that, block is
+ * stored in slot of its own and not shared.
+ */
+static bool _cas_compress_dedup_index(struct cas_compress *comp,
+		const struct cas_compress_slot *slot, uint32_t io_class)
+{
+	struct cas_compress_chunk *chunk;
+	struct cas_compress_dedup *dedup;
+
+	chunk = &comp->chunks[slot->sector / CAS_COMPRESS_CHUNK_SECTORS];
+	if (!chunk->shared) {
+		chunk->shared = kcalloc(CAS_COMPRESS_CHUNK_SECTORS /
+				chunk->sectors, sizeof(*chunk->shared),
+				GFP_ATOMIC);
+		if (!chunk->shared)
+			return false;
+	}
+
+	dedup = kmalloc(sizeof(*dedup), GFP_ATOMIC);
+	if (!dedup)
+		return false;
+
+	dedup->hash = slot->hash;
+	dedup->sector = slot->sector;
+	dedup->length = slot->length;
+	dedup->refs = 1;
+	dedup->io_class = io_class;
+
+	/* Identical block might have been indexed in the meantime */
+	if (rhashtable_lookup_insert_fast(&comp->dedup_index, &dedup->node,
+			cas_compress_dedup_params)) {
+		kfree(dedup);
+		return false;
+	}
+
+	*_cas_compress_dedup_entry(comp, slot->sector) = dedup;
+	comp->dedup_slots++;
+
+	return true;
+}
+
+int cas_compress_alloc(struct cas_compress *comp,
+		struct cas_compress_slot *slot, uint32_t count)
+{
+	uint32_t i;
+	int result = 0;
+
+	spin_lock(&comp->lock);
+	for (i = 0; i < count; i++) {
+		if (slot[i].shared)
+			continue;
+
+		result = _cas_compress_alloc_slot(comp,
+				_cas_compress_sectors(slot[i].length),
+				&slot[i].sector);
+		if (result)
+			break;
+	}
+
+	while (result && i--) {
+		if (slot[i].shared)
+			continue;
+
+		_cas_compress_free_slot(comp,
+				_cas_compress_sectors(slot[i].length),
+				slot[i].sector);
+	}
+	spin_unlock(&comp->lock);
+
+	return result;
+}
+
+void cas_compress_free(struct cas_compress *comp,
+		const struct cas_compress_slot *slot, uint32_t count)
+{
+	uint32_t i;
+
+	spin_lock(&comp->lock);
+	for (i = 0; i < count; i++) {
+		if (slot[i].shared) {
+			_cas_compress_dedup_release(comp, slot[i].sector);
+		} else {
+			_cas_compress_free_slot(comp,
+					_cas_compress_sectors(slot[i].length),
+					slot[i].sector);
+		}
+	}
+	spin_unlock(&comp->lock);
+}
+
+/* Called with lock held */
+static void _cas_compress_unmap(struct cas_compress *comp, uint64_t block)
+{
+	uint64_t entry = comp->map[block];
+	uint32_t io_class, sectors;
+
+	if (!(entry & CAS_COMPRESS_MAPPED))
+		return;
+
+	io_class = (entry >> CAS_COMPRESS_CLASS_SHIFT) &
+			CAS_COMPRESS_CLASS_MASK;
+	sectors = _cas_compress_sectors(((entry >> CAS_COMPRESS_LENGTH_SHIFT) &
+			CAS_COMPRESS_LENGTH_MASK) + 1);
+
+	comp->stored[io_class]--;
+	if (entry & CAS_COMPRESS_SHARED) {
+		comp->dedup_refs--;
+		_cas_compress_dedup_release(comp,
+				entry & CAS_COMPRESS_SECTOR_MASK);
+	} else {
+		_cas_compress_free_slot(comp, sectors,
+				entry & CAS_COMPRESS_SECTOR_MASK);
+		comp->packed[io_class] -= sectors;
+	}
+
+	WRITE_ONCE(comp->map[block], 0);
+}
+
+void cas_compress_commit(struct cas_compress *comp, uint64_t block,
+		const struct cas_compress_slot *slot, uint32_t count,
+		uint32_t io_class)
+{
+	uint64_t entry;
+	uint32_t i;
+
+	spin_lock(&comp->lock);
+	for (i = 0; i < count; i++) {
+		/* Reference to shared slot was taken by get, so rewrite of
+		 * block with the same content doesn't free its slot here */
+		_cas_compress_unmap(comp, block + i);
+
+		entry = CAS_COMPRESS_MAPPED |
+				((uint64_t)io_class << CAS_COMPRESS_CLASS_SHIFT) |
+				((uint64_t)(slot[i].length - 1) <<
+					CAS_COMPRESS_LENGTH_SHIFT) |
+				slot[i].sector;
+		comp->stored[io_class]++;
+
+		if (!slot[i].shared) {
+			comp->packed[io_class] +=
+				_cas_compress_sectors(slot[i].length);
+		}
+
+		if (slot[i].shared || (slot[i].hash &&
+				_cas_compress_dedup_index(comp, &slot[i],
+					io_class))) {
+			entry |= CAS_COMPRESS_SHARED;
+			comp->dedup_refs++;
+		}
+
+		WRITE_ONCE(comp->map[block + i], entry);
+	}
+	spin_unlock(&comp->lock);
+}
+
+/* Discard of whole volume takes a while, lock is dropped now and then */
+#define CAS_COMPRESS_DISCARD_BATCH 1024
+
+void cas_compress_discard(struct cas_compress *comp, uint64_t block,
+		uint64_t count)
+{
+	uint64_t end = block + count;
+
+	while (block < end) {
+		count = min_t(uint64_t, end - block,
+				CAS_COMPRESS_DISCARD_BATCH);
+
+		spin_lock(&comp->lock);
+		for (; count; count--, block++)
+			_cas_compress_unmap(comp, block);
+		spin_unlock(&comp->lock);
+
+		cond_resched();
+	}
+}
+
+uint64_t cas_compress_fingerprint(const void *src)
+{
+	return xxh64(src, CAS_COMPRESS_BLOCK_SIZE, 0) ?: 1;
+}
+
+bool cas_compress_dedup_get(struct cas_compress *comp,
+		struct cas_compress_slot *slot)
+{
+	struct cas_compress_dedup *dedup;
+
+	if (!READ_ONCE(comp->dedup))
+		return false;
+
+	spin_lock(&comp->lock);
+	dedup = rhashtable_lookup_fast(&comp->dedup_index, &slot->hash,
+			cas_compress_dedup_params);
+	if (dedup) {
+		dedup->refs++;
+		slot->sector = dedup->sector;
+		slot->length = dedup->length;
+		slot->shared = true;
+	}
+	spin_unlock(&comp->lock);
+
+	return dedup;
+}
+
+void cas_compress_dedup_put(struct cas_compress *comp,
+		struct cas_compress_slot *slot)
+{
+	spin_lock(&comp->lock);
+	_cas_compress_dedup_release(comp, slot->sector);
+	spin_unlock(&comp->lock);
+
+	slot->shared = false;
+}
+
+void cas_compress_set_dedup(struct cas_compress *comp, bool enabled)
+{
+	WRITE_ONCE(comp->dedup, enabled);
+}
+
+bool cas_compress_get_dedup(struct cas_compress *comp)
+{
+	return READ_ONCE(comp->dedup);
+}
+
+void cas_compress_get_dedup_stats(struct cas_compress *comp,
+		uint64_t *indexed, uint64_t *shared)
+{
+	spin_lock(&comp->lock);
+	*indexed = comp->dedup_slots;
+	*shared = comp->dedup_refs;
+	spin_unlock(&comp->lock);
+}
+
+void cas_compress_set_enabled(struct cas_compress *comp, uint32_t io_class,
+		bool enabled)
+{
+	WRITE_ONCE(comp->enabled[io_class], enabled);
+}
+
+bool cas_compress_get_enabled(struct cas_compress *comp, uint32_t io_class)
+{
+	return READ_ONCE(comp->enabled[io_class]);
+}
+
+void cas_compress_get_stats(struct cas_compress *comp, uint32_t io_class,
+		uint64_t *stored, uint64_t *packed)
+{
+	spin_lock(&comp->lock);
+	*stored = comp->stored[io_class] * CAS_COMPRESS_BLOCK_SIZE;
+	*packed = comp->packed[io_class] << SECTOR_SHIFT;
+	spin_unlock(&comp->lock);
+}
+
+void cas_compress_get_dev_usage(struct cas_compress *comp, uint64_t *used,
+		uint64_t *total)
+{
+	spin_lock(&comp->lock);
+	*used = comp->dev_used;
+	spin_unlock(&comp->lock);
+
+	*total = (comp->nr_chunks - CAS_COMPRESS_LABEL_CHUNKS) *
+			CAS_COMPRESS_CHUNK_SECTORS;
+}
@@ -0,0 +1,132 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __COMPRESS_H__
+#define __COMPRESS_H__
+
+/* Unit data of compressed volume is compressed and addressed in */
+#define CAS_COMPRESS_BLOCK_SIZE 4096
+#define CAS_COMPRESS_BLOCK_SECTORS (CAS_COMPRESS_BLOCK_SIZE >> SECTOR_SHIFT)
+
+/* Capacity of compressed volume in percent of device */
+#define CAS_COMPRESS_RATIO_MIN 100
+#define CAS_COMPRESS_RATIO_MAX 1000
+
+/*
+ * Sectors at start of device reserved for label marking it as compressed.
+ * As map is not persisted, label keeps device from being loaded as cache
+ * of plain block device, which would find no cache metadata at its start.
+ */
+#define CAS_COMPRESS_LABEL_SECTORS CAS_COMPRESS_BLOCK_SECTORS
+#define CAS_COMPRESS_LABEL_MAGIC "CASCOMP"
+#define CAS_COMPRESS_LABEL_VERSION 1
+
+/* Statistics of data without io class, e.g. cache metadata */
+#define CAS_COMPRESS_IO_CLASS_OTHER OCF_USER_IO_CLASS_MAX
+
+struct cas_compress;
+
+/* Slot of device block is stored in */
+struct cas_compress_slot {
+	sector_t sector;
+	uint32_t length;
+
+	uint64_t hash;
+		/*< Fingerprint of block to be indexed for deduplication, 0 if
+		 *  block is not to be deduplicated */
+
+	bool shared;
+		/*< Block is stored in slot of identical block already indexed */
+};
+
+/*
+ * Map of compressed volume. Address space of volume, @ratio percent of
+ * @dev_sectors, is divided into blocks, each compressed with LZ4 into slot
+ * of whole sectors of device. Slots of the same size are packed together
+ * in chunks of device, so that slots are allocated and freed without
+ * fragmenting device. Map is kept in memory only, so data of volume does not
+ * survive it and the volume may hold clean cache lines only.
+ *
+ * With deduplication enabled, slots of blocks given fingerprint are indexed,
+ * so that blocks of the same content share one slot, which is freed once
+ * last of them is dropped from map.
+ */
+struct cas_compress *cas_compress_create(uint64_t dev_sectors, uint32_t ratio);
+
+void cas_compress_destroy(struct cas_compress *comp);
+
+/* Number of blocks in address space of volume */
+uint64_t cas_compress_get_blocks(struct cas_compress *comp);
+
+/* Slot block is stored in, false if block was never written or discarded */
+bool cas_compress_lookup(struct cas_compress *comp, uint64_t block,
+		sector_t *sector, uint32_t *length);
+
+/*
+ * Compress block into @dst, which has to hold CAS_COMPRESS_BLOCK_SIZE bytes.
+ * Returns CAS_COMPRESS_BLOCK_SIZE if block is to be stored as is, because
+ * it doesn't compress or compression is disabled for its io class.
+ */
+uint32_t cas_compress_pack(struct cas_compress *comp, const void *src,
+		void *dst, uint32_t io_class);
+
+int cas_compress_unpack(struct cas_compress *comp, const void *src,
+		uint32_t length, void *dst);
+
+/* Allocate slots of @count packed blocks not shared, all or none of them */
+int cas_compress_alloc(struct cas_compress *comp,
+		struct cas_compress_slot *slot, uint32_t count);
+
+/* Release slots of blocks which failed to be written */
+void cas_compress_free(struct cas_compress *comp,
+		const struct cas_compress_slot *slot, uint32_t count);
+
+/* Map @count blocks from @block to slots written, freeing previous ones */
+void cas_compress_commit(struct cas_compress *comp, uint64_t block,
+		const struct cas_compress_slot *slot, uint32_t count,
+		uint32_t io_class);
+
+/* Drop blocks from map, so that they read as zeros */
+void cas_compress_discard(struct cas_compress *comp, uint64_t block,
+		uint64_t count);
+
+/* Fingerprint of block, never 0 */
+uint64_t cas_compress_fingerprint(const void *src);
+
+/*
+ * Find indexed slot of block of given fingerprint and take reference to it.
+ * Caller compares its content with block and either stores block there with
+ * commit or drops the reference with put.
+ */
+bool cas_compress_dedup_get(struct cas_compress *comp,
+		struct cas_compress_slot *slot);
+
+void cas_compress_dedup_put(struct cas_compress *comp,
+		struct cas_compress_slot *slot);
+
+/* Blocks already sharing slots keep sharing them once disabled */
+void cas_compress_set_dedup(struct cas_compress *comp, bool enabled);
+
+bool cas_compress_get_dedup(struct cas_compress *comp);
+
+/* Slots indexed and blocks stored in them */
+void cas_compress_get_dedup_stats(struct cas_compress *comp,
+		uint64_t *indexed, uint64_t *shared);
+
+/* Compression of blocks of io class, CAS_COMPRESS_IO_CLASS_OTHER included */
+void cas_compress_set_enabled(struct cas_compress *comp, uint32_t io_class,
+		bool enabled);
+
+bool cas_compress_get_enabled(struct cas_compress *comp, uint32_t io_class);
+
+/* Bytes of blocks of io class stored and bytes of their slots on device */
+void cas_compress_get_stats(struct cas_compress *comp, uint32_t io_class,
+		uint64_t *stored, uint64_t *packed);
+
+/* Sectors of device taken by slots and sectors usable for slots */
+void cas_compress_get_dev_usage(struct cas_compress *comp, uint64_t *used,
+		uint64_t *total);
+
+#endif /* __COMPRESS_H__ */
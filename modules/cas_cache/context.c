@@ -79,16 +79,77 @@ static int _cas_page_get_cpu(struct page *page)
 
 /* *** CONTEXT DATA OPERATIONS *** */
 
+extern u32 data_page_order;
+
+/*
+ * Allocate chunk of 2^order physically contiguous pages. It is only an
+ * optimization, so do not try hard and let caller fall back to single pages.
+ */
+static struct page *_cas_ctx_data_alloc_chunk(unsigned int order)
+{
+	struct page *page;
+
+	page = alloc_pages(GFP_NOIO | __GFP_COMP | __GFP_NORETRY |
+			__GFP_NOWARN, order);
+	if (page)
+		kmemleak_alloc(page_address(page), PAGE_SIZE << order, 1, GFP_NOIO);
+
+	return page;
+}
+
+static struct page *_cas_ctx_data_alloc_page(void)
+{
+	struct page *page;
+	void *page_addr;
+	int cpu;
+
+	page_addr = cas_rpool_try_get(cas_bvec_pages_rpool, &cpu);
+	if (page_addr) {
+		page = virt_to_page(page_addr);
+		_cas_page_set_cpu(page, cpu);
+		return page;
+	}
+
+	page = alloc_page(GFP_NOIO);
+	if (page) {
+		/* Failed to get memory from rpool but backup allocation worked.
+		   Need to keep track of this page as well */
+		kmemleak_alloc(page_address(page), PAGE_SIZE, 1, GFP_NOIO);
+	}
+
+	return page;
+}
+
+static void _cas_ctx_data_free_vec(struct bio_vec *vec)
+{
+	struct page *page = vec->bv_page;
+
+	if (vec->bv_len > PAGE_SIZE) {
+		/* Compound page, never comes from rpool */
+		kmemleak_free(page_address(page));
+		__free_pages(page, get_order(vec->bv_len));
+		return;
+	}
+
+	if (!(_cas_page_test_priv(page) && !cas_rpool_try_put(
+			cas_bvec_pages_rpool,
+			page_address(page),
+			_cas_page_get_cpu(page)))) {
+		__free_page(page);
+		/* It wasn't a page from rpool thus need to stop tracking it explicitly */
+		kmemleak_free(page_address(page));
+	}
+}
+
 /*
  *
  */
 static ctx_data_t *__cas_ctx_data_alloc(uint32_t pages)
 {
 	struct blk_data *data;
-	uint32_t i;
-	void *page_addr = NULL;
-	struct page *page = NULL;
-	int cpu;
+	uint32_t i, left, chunk;
+	unsigned int order = 0;
+	struct page *page;
 
 	data = env_mpool_new(cas_bvec_pool, pages);
 
@@ -97,41 +158,53 @@ static ctx_data_t *__cas_ctx_data_alloc(uint32_t pages)
 		return NULL;
 	}
 
-	data->size = pages;
-
-	for (i = 0; i < pages; ++i) {
-		page_addr = cas_rpool_try_get(cas_bvec_pages_rpool, &cpu);
-		if (page_addr) {
-			data->vec[i].bv_page = virt_to_page(page_addr);
-			_cas_page_set_cpu(data->vec[i].bv_page, cpu);
-		} else {
-			data->vec[i].bv_page = alloc_page(GFP_NOIO);
-			if (data->vec[i].bv_page) {
-				/* Failed to get memory from rpool but backup allocation worked.
-				   Need to keep track of this page as well */
-				kmemleak_alloc(page_address(data->vec[i].bv_page), PAGE_SIZE, 1, GFP_NOIO);
-			}
+	data->vec = data->vec_inline;
+	data->inflight = NULL;
+	data->cgroup_entry = NULL;
+	data->io_class = OCF_IO_CLASS_INVALID;
+	data->dedup = false;
+	data->scrub = false;
+	data->stage_hist = NULL;
+	data->cursor.vec = NULL;
+
+#ifdef CAS_BIO_MULTIPAGE_BVEC
+	/* Vectors spanning multiple pages can be added to bio as a whole */
+	order = data_page_order;
+#endif
+
+	for (i = 0, left = pages; left; ++i) {
+		page = NULL;
+		chunk = 1;
+
+		if (order && left > 1) {
+			unsigned int chunk_order = min_t(unsigned int, order,
+					ilog2(left));
+
+			page = _cas_ctx_data_alloc_chunk(chunk_order);
+			if (page)
+				chunk = 1 << chunk_order;
+			else
+				order = 0;
 		}
 
-		if (!data->vec[i].bv_page)
+		if (!page)
+			page = _cas_ctx_data_alloc_page();
+
+		if (!page)
 			break;
 
-		data->vec[i].bv_len = PAGE_SIZE;
+		data->vec[i].bv_page = page;
+		data->vec[i].bv_len = chunk << PAGE_SHIFT;
 		data->vec[i].bv_offset = 0;
+		left -= chunk;
 	}
 
+	data->size = i;
+
 	/* One of allocations failed */
-	if (i != pages) {
-		for (pages = 0; pages < i; pages++) {
-			page = data->vec[i].bv_page;
-
-			if (page && !(_cas_page_test_priv(page) &&
-					!cas_rpool_try_put(cas_bvec_pages_rpool,
-					page_address(page),
-					_cas_page_get_cpu(page)))) {
-				__free_page(page);
-			}
-		}
+	if (left) {
+		for (i = 0; i < data->size; i++)
+			_cas_ctx_data_free_vec(&data->vec[i]);
 
 		env_mpool_del(cas_bvec_pool, data, pages);
 		data = NULL;
@@ -148,32 +221,81 @@ ctx_data_t *cas_ctx_data_alloc(uint32_t pages)
 	return __cas_ctx_data_alloc(pages);
 }
 
+/*
+ * Pages of securely erased data, waiting to be cleared in bulk. Their
+ * lru list is free to use, as they are owned by us until freed.
+ */
+static LIST_HEAD(cas_scrub_pages);
+static DEFINE_SPINLOCK(cas_scrub_lock);
+
+static void _cas_ctx_data_scrub_do(struct work_struct *ws)
+{
+	struct bio_vec vec = {};
+	unsigned long flags, i;
+	struct page *page, *next;
+	LIST_HEAD(pages);
+
+	spin_lock_irqsave(&cas_scrub_lock, flags);
+	list_splice_init(&cas_scrub_pages, &pages);
+	spin_unlock_irqrestore(&cas_scrub_lock, flags);
+
+	list_for_each_entry_safe(page, next, &pages, lru) {
+		list_del(&page->lru);
+
+		vec.bv_page = page;
+		vec.bv_len = PAGE_SIZE << compound_order(page);
+		for (i = 0; i < vec.bv_len; i += PAGE_SIZE)
+			clear_page(page_address(page) + i);
+
+		/* Cleared pages go back to reserve pool as any other */
+		_cas_ctx_data_free_vec(&vec);
+
+		cond_resched();
+	}
+}
+
+static DECLARE_WORK(cas_scrub_work, _cas_ctx_data_scrub_do);
+
+/*
+ * Secure erase of data happens right before it is freed, so instead of
+ * clearing pages under I/O they are handed over to background work, which
+ * clears them with clear_page() before they can be used again.
+ */
+static void _cas_ctx_data_scrub(struct blk_data *data)
+{
+	unsigned long flags;
+	uint32_t i;
+
+	spin_lock_irqsave(&cas_scrub_lock, flags);
+	for (i = 0; i < data->size; i++)
+		list_add_tail(&data->vec[i].bv_page->lru, &cas_scrub_pages);
+	spin_unlock_irqrestore(&cas_scrub_lock, flags);
+
+	queue_work(system_unbound_wq, &cas_scrub_work);
+}
+
 /*
  *
  */
 void cas_ctx_data_free(ctx_data_t *ctx_data)
 {
-	uint32_t i;
-	struct page *page = NULL;
 	struct blk_data *data = ctx_data;
+	uint32_t i, pages = 0;
 
 	if (!data)
 		return;
 
 	for (i = 0; i < data->size; i++) {
-		page = data->vec[i].bv_page;
-
-		if (!(_cas_page_test_priv(page) && !cas_rpool_try_put(
-				cas_bvec_pages_rpool,
-				page_address(page),
-				_cas_page_get_cpu(page)))) {
-			__free_page(page);
-			/* It wasn't a page from rpool thus need to stop tracking it explicitly */
-			kmemleak_free(page_address(page));
-		}
+		pages += data->vec[i].bv_len >> PAGE_SHIFT;
+		if (!data->scrub)
+			_cas_ctx_data_free_vec(&data->vec[i]);
 	}
 
-	env_mpool_del(cas_bvec_pool, data, data->size);
+	if (data->scrub)
+		_cas_ctx_data_scrub(data);
+
+	/* Vector has been allocated for number of pages, not chunks */
+	env_mpool_del(cas_bvec_pool, data, pages);
 }
 
 static int _cas_ctx_data_mlock(ctx_data_t *ctx_data)
@@ -188,13 +310,9 @@ static void _cas_ctx_data_munlock(ctx_data_t *ctx_data)
 void cas_ctx_data_secure_erase(ctx_data_t *ctx_data)
 {
 	struct blk_data *data = ctx_data;
-	uint32_t i;
-	void *ptr;
 
-	for (i = 0; i < data->size; i++) {
-		ptr = page_address(data->vec[i].bv_page);
-		memset(ptr, 0, PAGE_SIZE);
-	}
+	/* Pages are cleared once data is freed, see _cas_ctx_data_scrub() */
+	data->scrub = true;
 }
 
 /*
@@ -260,9 +378,32 @@ static uint64_t _cas_ctx_data_copy(ctx_data_t *dst, ctx_data_t *src,
 		uint64_t to, uint64_t from, uint64_t bytes)
 {
 	struct blk_data *src_data = src, *dst_data = dst;
+	bool staging = false;
+
+	/* Copy of request data, e.g. backfilled to cache, belongs to it */
+	if (dst_data->io_class == OCF_IO_CLASS_INVALID) {
+		dst_data->io_class = src_data->io_class;
+		dst_data->dedup = src_data->dedup;
+		staging = true;
+	}
 
-	return cas_data_cpy(dst_data->vec, dst_data->size, src_data->vec,
-			src_data->size, to, from, bytes);
+	if (dst_data->cursor.vec != dst_data->vec ||
+			dst_data->cursor.vec_num != dst_data->size) {
+		cas_data_cursor_init(&dst_data->cursor, dst_data->vec,
+				dst_data->size);
+	}
+	if (src_data->cursor.vec != src_data->vec ||
+			src_data->cursor.vec_num != src_data->size) {
+		cas_data_cursor_init(&src_data->cursor, src_data->vec,
+				src_data->size);
+	}
+
+	/*
+	 * Data allocated by cache itself is staging buffer of cache device
+	 * or core write, which CPU doesn't read again
+	 */
+	return cas_data_cursor_cpy(&dst_data->cursor, &src_data->cursor, to,
+			from, bytes, staging);
 }
 
 static int _cas_ctx_cleaner_init(ocf_cleaner_t c)
@@ -406,6 +547,8 @@ static const struct ocf_ctx_config ctx_cfg = {
 
 /* *** CONTEXT INITIALIZATION *** */
 
+extern u32 mpool_magazine;
+
 int cas_initialize_context(void)
 {
 	int ret;
@@ -424,6 +567,13 @@ int cas_initialize_context(void)
 		goto err_ctx;
 	}
 
+	if (mpool_magazine && env_mpool_enable_magazines(cas_bvec_pool)) {
+		printk(KERN_ERR "Cannot create BIO vector memory pool "
+				"magazines\n");
+		ret = -ENOMEM;
+		goto err_mpool;
+	}
+
 	cas_bvec_pages_rpool = cas_rpool_create(CAS_ALLOC_PAGE_LIMIT,
 			NULL, PAGE_SIZE, _cas_alloc_page_rpool,
 			_cas_free_page_rpool, NULL);
@@ -434,17 +584,26 @@ int cas_initialize_context(void)
 		goto err_mpool;
 	}
 
+	ret = cas_rpool_shrinker_init();
+	if (ret) {
+		printk(KERN_ERR "Cannot register reserve pool shrinker\n");
+		goto err_rpool;
+	}
+
 	cas_garbage_collector_init();
 
 	ret = block_dev_init();
 	if (ret) {
 		printk(KERN_ERR "Cannot initialize block device layer\n");
-		goto err_rpool;
+		goto err_gc;
 
 	}
 
 	return 0;
 
+err_gc:
+	cas_garbage_collector_deinit();
+	cas_rpool_shrinker_deinit();
 err_rpool:
 	cas_rpool_destroy(cas_bvec_pages_rpool, _cas_free_page_rpool, NULL);
 err_mpool:
@@ -457,7 +616,10 @@ err_ctx:
 
 void cas_cleanup_context(void)
 {
+	block_dev_deinit();
 	cas_garbage_collector_deinit();
+	flush_work(&cas_scrub_work);
+	cas_rpool_shrinker_deinit();
 	env_mpool_destroy(cas_bvec_pool);
 	cas_rpool_destroy(cas_bvec_pages_rpool, _cas_free_page_rpool, NULL);
 
@@ -469,12 +631,57 @@ void cas_cleanup_context(void)
 /*
  *
  */
-struct blk_data *cas_alloc_blk_data(uint32_t size, gfp_t flags)
+struct blk_data *cas_alloc_blk_data(struct env_mpool *pool, uint32_t size,
+		gfp_t flags)
+{
+	struct blk_data *data;
+
+	pool = pool ?: cas_bvec_pool;
+	data = env_mpool_new_f(pool, size, flags);
+
+	if (data) {
+		data->pool = pool;
+		data->size = size;
+		data->vec = data->vec_inline;
+		data->inflight = NULL;
+		data->dram_bvol = NULL;
+		data->cgroup_entry = NULL;
+		data->io_class = OCF_IO_CLASS_INVALID;
+		data->dedup = false;
+		data->scrub = false;
+		data->stage_hist = NULL;
+		data->cursor.vec = NULL;
+	}
+
+	return data;
+}
+
+/*
+ * Allocate blk_data which doesn't own its vector but references vector
+ * provided by caller (e.g. bi_io_vec of bio). Caller has to guarantee
+ * that vector stays valid until data is freed.
+ */
+struct blk_data *cas_alloc_blk_data_ref(struct env_mpool *pool,
+		struct bio_vec *vec, uint32_t size, gfp_t flags)
 {
-	struct blk_data *data = env_mpool_new_f(cas_bvec_pool, size, flags);
+	struct blk_data *data;
 
-	if (data)
+	pool = pool ?: cas_bvec_pool;
+	data = env_mpool_new_f(pool, 0, flags);
+
+	if (data) {
+		data->pool = pool;
 		data->size = size;
+		data->vec = vec;
+		data->inflight = NULL;
+		data->dram_bvol = NULL;
+		data->cgroup_entry = NULL;
+		data->io_class = OCF_IO_CLASS_INVALID;
+		data->dedup = false;
+		data->scrub = false;
+		data->stage_hist = NULL;
+		data->cursor.vec = NULL;
+	}
 
 	return data;
 }
@@ -487,6 +694,7 @@ void cas_free_blk_data(struct blk_data *data)
 	if (!data)
 		return;
 
-	env_mpool_del(cas_bvec_pool, data, data->size);
+	env_mpool_del(data->pool, data,
+			data->vec == data->vec_inline ? data->size : 0);
 }
 
@@ -9,6 +9,12 @@
 #define __CONTEXT_H__
 
 #include "linux_kernel_version.h"
+#include "utils/utils_data.h"
+
+struct cas_bd_inflight;
+struct cas_cgroup_stats_entry;
+struct bd_object;
+struct env_mpool;
 
 struct bio_vec_iter {
 	struct bio_vec *vec;
@@ -45,6 +51,101 @@ struct blk_data {
 	 */
 	unsigned long long start_time;
 
+	/**
+	 * @brief Request is accounted in block layer statistics of exported
+	 *	object, fixed on submission so that start and end always pair
+	 */
+	bool io_acct;
+
+	/**
+	 * @brief Latency histogram the request is accounted in, NULL if
+	 *	latency is not collected
+	 */
+	struct kcas_lat_hist __percpu *lat_hist;
+
+	/**
+	 * @brief Timestamp in ns for latency histogram and inflight age
+	 */
+	uint64_t lat_start;
+
+	/**
+	 * @brief Stage latency histograms the request is sampled for, NULL
+	 *	if not sampled
+	 */
+	struct kcas_lat_hist __percpu *stage_hist;
+
+	/**
+	 * @brief Start of each stage in ns, see enum kcas_io_stage, 0 if
+	 *	not reached
+	 */
+	uint64_t stage_ns[KCAS_IO_STAGE_MAX];
+
+	/**
+	 * @brief Inflight list the request is on, NULL if not tracked
+	 */
+	struct cas_bd_inflight *inflight;
+
+	/**
+	 * @brief Inflight list element
+	 */
+	struct list_head inflight_node;
+
+	/**
+	 * @brief CPU of I/O queue request was submitted on
+	 */
+	uint32_t inflight_queue;
+
+	/**
+	 * @brief Stage request waits in, see enum kcas_inflight_stage
+	 */
+	uint8_t inflight_stage;
+
+	/**
+	 * @brief Exported object DRAM tier of cache is updated for once
+	 *	request completes, NULL if none
+	 */
+	struct bd_object *dram_bvol;
+
+	/**
+	 * @brief Token of read miss to be filled into DRAM tier, 0 if none
+	 */
+	uint64_t dram_seq;
+
+	/**
+	 * @brief IO class of exported object request, OCF_IO_CLASS_INVALID
+	 *	for data allocated by cache itself
+	 */
+	uint32_t io_class;
+
+	/**
+	 * @brief Per cgroup statistics entry request is accounted in, NULL
+	 *	if not collected
+	 */
+	struct cas_cgroup_stats_entry *cgroup_entry;
+
+	/**
+	 * @brief Core of exported object request, reads of data forwarded
+	 *	to it make the request a miss, valid with @cgroup_entry
+	 */
+	struct bd_object *cgroup_core;
+
+	/**
+	 * @brief Data of request was read from core, see @cgroup_core
+	 */
+	bool core_read;
+
+	/**
+	 * @brief Data may share slot of identical data on cache device, as it
+	 *	is data of exported object read, which cache lines are clean with
+	 */
+	bool dedup;
+
+	/**
+	 * @brief Data has been securely erased, pages are cleared in
+	 *	background once data is freed
+	 */
+	bool scrub;
+
 	/**
 	 * @brief Request data siz
 	 */
@@ -61,14 +162,37 @@ struct blk_data {
 	struct bio_vec_iter iter;
 
 	/**
-	 * @brief Request data
+	 * @brief Position of last copy between data, vec NULL until first one
 	 */
-	struct bio_vec vec[];
+	struct cas_data_cursor cursor;
+
+	/**
+	 * @brief Request data - points either to vec_inline or directly
+	 *	to bio_vec array of bio the data was created for
+	 */
+	struct bio_vec *vec;
+
+	/**
+	 * @brief Pool data of exported object request is allocated from
+	 */
+	struct env_mpool *pool;
+
+	/**
+	 * @brief Request data storage owned by this structure
+	 */
+	struct bio_vec vec_inline[];
 };
 
-struct blk_data *cas_alloc_blk_data(uint32_t size, gfp_t flags);
+/* Data of exported object request, @pool NULL for pool shared by caches */
+struct blk_data *cas_alloc_blk_data(struct env_mpool *pool, uint32_t size,
+		gfp_t flags);
+struct blk_data *cas_alloc_blk_data_ref(struct env_mpool *pool,
+		struct bio_vec *vec, uint32_t size, gfp_t flags);
 void cas_free_blk_data(struct blk_data *data);
 
+/* Max order of compound pages backing cache data buffers */
+#define CAS_DATA_PAGE_ORDER_MAX 4
+
 ctx_data_t *cas_ctx_data_alloc(uint32_t pages);
 void cas_ctx_data_free(ctx_data_t *ctx_data);
 void cas_ctx_data_secure_erase(ctx_data_t *ctx_data);
@@ -0,0 +1,151 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "cas_cache.h"
+
+/* Sampling interval of dirty data of core */
+#define CAS_DIRTY_THROTTLE_INTERVAL (HZ / 10)
+
+/* Dirty data is kept in units of 0.01% of cache */
+#define CAS_DIRTY_THROTTLE_SCALE 10000
+
+/* Pauses shorter than that are not worth sleeping for */
+#define CAS_DIRTY_THROTTLE_MIN_PAUSE_US 50
+
+#define CAS_DIRTY_THROTTLE_MAX_PAUSE_DEFAULT 100
+
+struct cas_dirty_throttle {
+	ocf_core_t core;
+
+	uint32_t limit;
+		/*< Limit in percent of cache, 0 - throttling disabled */
+
+	uint32_t max_pause;
+		/*< Longest pause of single write in milliseconds */
+
+	uint32_t dirty;
+		/*< Last sample of dirty data of core in 0.01% of cache, 0 if
+		 *  cache mode doesn't make writes dirty */
+
+	struct delayed_work work;
+};
+
+static void _cas_dirty_throttle_sample(struct cas_dirty_throttle *dt)
+{
+	ocf_cache_t cache = ocf_core_get_cache(dt->core);
+	struct ocf_cache_info cache_info;
+	struct ocf_core_info core_info;
+	ocf_cache_mode_t mode;
+	uint32_t dirty = 0;
+
+	/* Previous sample is kept while management operation is running */
+	if (ocf_mngt_cache_read_trylock(cache))
+		return;
+
+	mode = ocf_cache_get_mode(cache);
+	if ((mode == ocf_cache_mode_wb || mode == ocf_cache_mode_wo) &&
+			!ocf_cache_get_info(cache, &cache_info) &&
+			cache_info.size &&
+			!ocf_core_get_info(dt->core, &core_info)) {
+		dirty = div_u64((uint64_t)core_info.dirty *
+				CAS_DIRTY_THROTTLE_SCALE, cache_info.size);
+	}
+
+	ocf_mngt_cache_read_unlock(cache);
+
+	WRITE_ONCE(dt->dirty, dirty);
+}
+
+static void _cas_dirty_throttle_work(struct work_struct *work)
+{
+	struct cas_dirty_throttle *dt = container_of(to_delayed_work(work),
+			struct cas_dirty_throttle, work);
+
+	if (!READ_ONCE(dt->limit))
+		return;
+
+	_cas_dirty_throttle_sample(dt);
+
+	queue_delayed_work(system_unbound_wq, &dt->work,
+			CAS_DIRTY_THROTTLE_INTERVAL);
+}
+
+struct cas_dirty_throttle *cas_dirty_throttle_create(ocf_core_t core)
+{
+	struct cas_dirty_throttle *dt;
+
+	dt = kzalloc(sizeof(*dt), GFP_KERNEL);
+	if (!dt)
+		return NULL;
+
+	dt->core = core;
+	dt->max_pause = CAS_DIRTY_THROTTLE_MAX_PAUSE_DEFAULT;
+	INIT_DELAYED_WORK(&dt->work, _cas_dirty_throttle_work);
+
+	return dt;
+}
+
+void cas_dirty_throttle_destroy(struct cas_dirty_throttle *dt)
+{
+	WRITE_ONCE(dt->limit, 0);
+	cancel_delayed_work_sync(&dt->work);
+
+	kfree(dt);
+}
+
+void cas_dirty_throttle_balance(struct cas_dirty_throttle *dt)
+{
+	uint32_t limit = READ_ONCE(dt->limit) * (CAS_DIRTY_THROTTLE_SCALE / 100);
+	uint32_t dirty = READ_ONCE(dt->dirty);
+	uint32_t freerun = limit / 2;
+	uint64_t pause, span;
+
+	if (!limit || dirty <= freerun)
+		return;
+
+	/*
+	 * Pause grows with square of position between freerun point and
+	 * limit, so that writers barely notice crossing the freerun point
+	 * and converge to rate cleaning keeps up with near the limit
+	 */
+	pause = (uint64_t)READ_ONCE(dt->max_pause) * USEC_PER_MSEC;
+	if (dirty < limit) {
+		span = limit - freerun;
+		pause = div64_u64(pause * (dirty - freerun) * (dirty - freerun),
+				span * span);
+	}
+
+	if (pause < CAS_DIRTY_THROTTLE_MIN_PAUSE_US)
+		return;
+
+	usleep_range(pause, pause + pause / 4);
+}
+
+void cas_dirty_throttle_set_limit(struct cas_dirty_throttle *dt,
+		uint32_t limit)
+{
+	uint32_t old = xchg(&dt->limit, limit);
+
+	if (limit && !old)
+		queue_delayed_work(system_unbound_wq, &dt->work, 0);
+	else if (!limit)
+		WRITE_ONCE(dt->dirty, 0);
+}
+
+uint32_t cas_dirty_throttle_get_limit(struct cas_dirty_throttle *dt)
+{
+	return READ_ONCE(dt->limit);
+}
+
+void cas_dirty_throttle_set_max_pause(struct cas_dirty_throttle *dt,
+		uint32_t ms)
+{
+	WRITE_ONCE(dt->max_pause, ms);
+}
+
+uint32_t cas_dirty_throttle_get_max_pause(struct cas_dirty_throttle *dt)
+{
+	return READ_ONCE(dt->max_pause);
+}
@@ -0,0 +1,38 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __DIRTY_THROTTLE_H__
+#define __DIRTY_THROTTLE_H__
+
+struct cas_dirty_throttle;
+
+/*
+ * Throttling of writes to exported object of core by its dirty data, in the
+ * spirit of balance_dirty_pages(). Once dirty lines of core occupy more than
+ * half of its limit, writers are paused before their writes are submitted,
+ * for time growing quadratically up to max pause as dirty data of core
+ * approaches the limit. Dirty data is sampled periodically while limit is
+ * set, so that I/O path never has to lock cache.
+ */
+struct cas_dirty_throttle *cas_dirty_throttle_create(ocf_core_t core);
+
+void cas_dirty_throttle_destroy(struct cas_dirty_throttle *dt);
+
+/* Pause writer as needed, called in process context before write submission */
+void cas_dirty_throttle_balance(struct cas_dirty_throttle *dt);
+
+/* Limit of dirty data of core in percent of cache, 0 disables throttling */
+void cas_dirty_throttle_set_limit(struct cas_dirty_throttle *dt,
+		uint32_t limit);
+
+uint32_t cas_dirty_throttle_get_limit(struct cas_dirty_throttle *dt);
+
+/* Longest pause of single write in milliseconds */
+void cas_dirty_throttle_set_max_pause(struct cas_dirty_throttle *dt,
+		uint32_t ms);
+
+uint32_t cas_dirty_throttle_get_max_pause(struct cas_dirty_throttle *dt);
+
+#endif /* __DIRTY_THROTTLE_H__ */
@@ -0,0 +1,467 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <linux/hash.h>
+#include <linux/log2.h>
+#include "cas_cache.h"
+#include "utils/utils_data.h"
+
+#define CAS_DRAM_TIER_PAGE_SECTORS (PAGE_SIZE >> SECTOR_SHIFT)
+
+/* Largest read served from tier, in pages */
+#define CAS_DRAM_TIER_IO_PAGES 16
+
+/*
+ * Invalidation sequences are kept per region of core of largest read size,
+ * so that any read eligible for tier spans at most two of them
+ */
+#define CAS_DRAM_TIER_REGION_SECTORS \
+	(CAS_DRAM_TIER_IO_PAGES * CAS_DRAM_TIER_PAGE_SECTORS)
+#define CAS_DRAM_TIER_SEQS 1024
+
+/* Locks of hash buckets are striped */
+#define CAS_DRAM_TIER_LOCKS 1024
+
+/* Longer ranges are invalidated by walking all slots instead of lookups */
+#define CAS_DRAM_TIER_INVALIDATE_PAGES_MAX 2048
+
+/* Slots examined by CLOCK hand before referenced one is evicted anyway */
+#define CAS_DRAM_TIER_CLOCK_SCAN 1024
+
+struct cas_dram_tier_slot {
+	struct hlist_node node;
+	uintptr_t core_key;
+	sector_t sector;
+	uint32_t bucket;
+	/* Slot is in hash table, changed under lock of its bucket */
+	bool hashed;
+	/* Read since CLOCK hand passed the slot */
+	bool referenced;
+	/* Taken by fill copying data into page, skipped by CLOCK hand */
+	bool busy;
+	/* Allocated on first use, kept until tier is destroyed */
+	struct page *page;
+};
+
+struct cas_dram_tier_stats {
+	uint64_t hits;
+	uint64_t misses;
+};
+
+struct cas_dram_tier {
+	uint32_t size_mib;
+	uint64_t slots_count;
+
+	/* Protects CLOCK hand and busy flags of slots */
+	spinlock_t clock_lock;
+	uint64_t hand;
+
+	uint32_t hash_shift;
+	struct hlist_head *buckets;
+	spinlock_t locks[CAS_DRAM_TIER_LOCKS];
+
+	/*
+	 * Bumped by invalidation before pages are dropped. Sequences of tiers
+	 * never overlap, so that token of read is not valid in next tier.
+	 */
+	atomic64_t seq_all;
+	atomic64_t seqs[CAS_DRAM_TIER_SEQS];
+
+	/* Tags of pages missed once, second miss admits page into tier */
+	uint32_t *ghost;
+	uint64_t ghost_mask;
+
+	atomic64_t used;
+	struct cas_dram_tier_stats __percpu *stats;
+
+	struct cas_dram_tier_slot *slots;
+};
+
+static atomic64_t cas_dram_tier_epoch = ATOMIC64_INIT(0);
+
+static inline uint64_t _cas_dram_tier_hash(uintptr_t core_key, sector_t sector)
+{
+	return hash_64(hash_64(core_key, 64) ^ sector, 64);
+}
+
+static inline spinlock_t *_cas_dram_tier_lock(struct cas_dram_tier *tier,
+		uint32_t bucket)
+{
+	return &tier->locks[bucket % CAS_DRAM_TIER_LOCKS];
+}
+
+static inline atomic64_t *_cas_dram_tier_seq(struct cas_dram_tier *tier,
+		uintptr_t core_key, sector_t sector)
+{
+	return &tier->seqs[hash_64(hash_64(core_key, 64) ^
+			(sector / CAS_DRAM_TIER_REGION_SECTORS),
+			ilog2(CAS_DRAM_TIER_SEQS))];
+}
+
+/* Token of read, changed by any invalidation possibly overlapping it */
+static uint64_t _cas_dram_tier_token(struct cas_dram_tier *tier,
+		uintptr_t core_key, sector_t sector, uint32_t sectors)
+{
+	return atomic64_read(&tier->seq_all) +
+		atomic64_read(_cas_dram_tier_seq(tier, core_key, sector)) +
+		atomic64_read(_cas_dram_tier_seq(tier, core_key,
+				sector + sectors - 1));
+}
+
+static bool _cas_dram_tier_eligible(sector_t sector, uint32_t sectors)
+{
+	return sectors && !(sector % CAS_DRAM_TIER_PAGE_SECTORS) &&
+		!(sectors % CAS_DRAM_TIER_PAGE_SECTORS) &&
+		sectors <= CAS_DRAM_TIER_REGION_SECTORS;
+}
+
+struct cas_dram_tier *cas_dram_tier_create(uint32_t size_mib)
+{
+	struct cas_dram_tier *tier;
+	uint64_t buckets, base;
+	int i;
+
+	tier = vzalloc(sizeof(*tier));
+	if (!tier)
+		return NULL;
+
+	tier->size_mib = size_mib;
+	tier->slots_count = ((uint64_t)size_mib * MiB) >> PAGE_SHIFT;
+	buckets = roundup_pow_of_two(tier->slots_count);
+	tier->hash_shift = ilog2(buckets);
+	tier->ghost_mask = buckets - 1;
+
+	tier->slots = vzalloc(tier->slots_count * sizeof(*tier->slots));
+	tier->buckets = vzalloc(buckets * sizeof(*tier->buckets));
+	tier->ghost = vzalloc(buckets * sizeof(*tier->ghost));
+	tier->stats = alloc_percpu(struct cas_dram_tier_stats);
+	if (!tier->slots || !tier->buckets || !tier->ghost || !tier->stats) {
+		cas_dram_tier_destroy(tier);
+		return NULL;
+	}
+
+	spin_lock_init(&tier->clock_lock);
+	for (i = 0; i < CAS_DRAM_TIER_LOCKS; i++)
+		spin_lock_init(&tier->locks[i]);
+
+	base = atomic64_add_return(1ULL << 48, &cas_dram_tier_epoch);
+	atomic64_set(&tier->seq_all, base);
+	for (i = 0; i < CAS_DRAM_TIER_SEQS; i++)
+		atomic64_set(&tier->seqs[i], base);
+	atomic64_set(&tier->used, 0);
+
+	return tier;
+}
+
+void cas_dram_tier_destroy(struct cas_dram_tier *tier)
+{
+	uint64_t i;
+
+	if (tier->slots) {
+		for (i = 0; i < tier->slots_count; i++) {
+			if (tier->slots[i].page)
+				__free_page(tier->slots[i].page);
+			if (!(i % 4096))
+				cond_resched();
+		}
+	}
+
+	free_percpu(tier->stats);
+	vfree(tier->ghost);
+	vfree(tier->buckets);
+	vfree(tier->slots);
+	vfree(tier);
+}
+
+uint32_t cas_dram_tier_get_size(struct cas_dram_tier *tier)
+{
+	return tier->size_mib;
+}
+
+/* Called under lock of bucket */
+static struct cas_dram_tier_slot *_cas_dram_tier_lookup(
+		struct cas_dram_tier *tier, uint32_t bucket,
+		uintptr_t core_key, sector_t sector)
+{
+	struct cas_dram_tier_slot *slot;
+
+	hlist_for_each_entry(slot, &tier->buckets[bucket], node) {
+		if (slot->core_key == core_key && slot->sector == sector)
+			return slot;
+	}
+
+	return NULL;
+}
+
+/* Called under lock of bucket of slot */
+static void _cas_dram_tier_unhash(struct cas_dram_tier *tier,
+		struct cas_dram_tier_slot *slot)
+{
+	hlist_del(&slot->node);
+	WRITE_ONCE(slot->hashed, false);
+	atomic64_dec(&tier->used);
+}
+
+bool cas_dram_tier_read(struct cas_dram_tier *tier, uintptr_t core_key,
+		sector_t sector, uint32_t sectors, struct bio_vec *vec,
+		uint32_t vec_size, uint64_t *seq)
+{
+	struct cas_dram_tier_slot *slot;
+	struct bio_vec src;
+	unsigned long flags;
+	uint32_t bucket, i;
+	spinlock_t *lock;
+
+	*seq = 0;
+	if (!_cas_dram_tier_eligible(sector, sectors))
+		return false;
+
+	/* Taken before lookup, so that any later invalidation changes it */
+	*seq = _cas_dram_tier_token(tier, core_key, sector, sectors);
+
+	for (i = 0; i < sectors / CAS_DRAM_TIER_PAGE_SECTORS; i++) {
+		bucket = hash_64(_cas_dram_tier_hash(core_key, sector),
+				tier->hash_shift);
+		lock = _cas_dram_tier_lock(tier, bucket);
+
+		spin_lock_irqsave(lock, flags);
+		slot = _cas_dram_tier_lookup(tier, bucket, core_key, sector);
+		if (!slot) {
+			spin_unlock_irqrestore(lock, flags);
+			this_cpu_inc(tier->stats->misses);
+			return false;
+		}
+
+		src.bv_page = slot->page;
+		src.bv_offset = 0;
+		src.bv_len = PAGE_SIZE;
+		cas_data_cpy(vec, vec_size, &src, 1, (uint64_t)i * PAGE_SIZE,
+				0, PAGE_SIZE);
+		WRITE_ONCE(slot->referenced, true);
+		spin_unlock_irqrestore(lock, flags);
+
+		sector += CAS_DRAM_TIER_PAGE_SECTORS;
+	}
+
+	this_cpu_inc(tier->stats->hits);
+	return true;
+}
+
+/* Take slot for new page, evicting page held by it */
+static struct cas_dram_tier_slot *_cas_dram_tier_claim(
+		struct cas_dram_tier *tier)
+{
+	struct cas_dram_tier_slot *slot;
+	unsigned long flags;
+	spinlock_t *lock;
+	uint32_t i;
+
+	spin_lock_irqsave(&tier->clock_lock, flags);
+
+	for (i = 0; i < CAS_DRAM_TIER_CLOCK_SCAN; i++) {
+		slot = &tier->slots[tier->hand];
+		if (++tier->hand == tier->slots_count)
+			tier->hand = 0;
+
+		if (slot->busy)
+			continue;
+
+		if (READ_ONCE(slot->referenced) &&
+				i < CAS_DRAM_TIER_CLOCK_SCAN - 1) {
+			WRITE_ONCE(slot->referenced, false);
+			continue;
+		}
+
+		if (READ_ONCE(slot->hashed)) {
+			lock = _cas_dram_tier_lock(tier, slot->bucket);
+			spin_lock(lock);
+			if (slot->hashed)
+				_cas_dram_tier_unhash(tier, slot);
+			spin_unlock(lock);
+		}
+
+		slot->busy = true;
+		spin_unlock_irqrestore(&tier->clock_lock, flags);
+		return slot;
+	}
+
+	spin_unlock_irqrestore(&tier->clock_lock, flags);
+	return NULL;
+}
+
+static void _cas_dram_tier_release(struct cas_dram_tier *tier,
+		struct cas_dram_tier_slot *slot)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&tier->clock_lock, flags);
+	slot->busy = false;
+	spin_unlock_irqrestore(&tier->clock_lock, flags);
+}
+
+/* Page is admitted if it was missed recently already */
+static bool _cas_dram_tier_admit(struct cas_dram_tier *tier, uint64_t hash)
+{
+	uint32_t *ghost = &tier->ghost[hash & tier->ghost_mask];
+	uint32_t tag = (uint32_t)(hash >> 32) | 1;
+
+	if (READ_ONCE(*ghost) == tag)
+		return true;
+
+	WRITE_ONCE(*ghost, tag);
+	return false;
+}
+
+void cas_dram_tier_fill(struct cas_dram_tier *tier, uintptr_t core_key,
+		sector_t sector, uint32_t sectors, struct bio_vec *vec,
+		uint32_t vec_size, uint64_t seq)
+{
+	struct cas_dram_tier_slot *slot;
+	sector_t first = sector;
+	struct bio_vec dst;
+	unsigned long flags;
+	uint32_t bucket, i;
+	spinlock_t *lock;
+	uint64_t hash;
+	bool present;
+
+	for (i = 0; i < sectors / CAS_DRAM_TIER_PAGE_SECTORS; i++,
+			sector += CAS_DRAM_TIER_PAGE_SECTORS) {
+		hash = _cas_dram_tier_hash(core_key, sector);
+		if (!_cas_dram_tier_admit(tier, hash))
+			continue;
+
+		bucket = hash_64(hash, tier->hash_shift);
+		lock = _cas_dram_tier_lock(tier, bucket);
+
+		spin_lock_irqsave(lock, flags);
+		present = _cas_dram_tier_lookup(tier, bucket, core_key,
+				sector) != NULL;
+		spin_unlock_irqrestore(lock, flags);
+		if (present)
+			continue;
+
+		slot = _cas_dram_tier_claim(tier);
+		if (!slot)
+			return;
+
+		if (!slot->page)
+			slot->page = alloc_page(GFP_NOWAIT | __GFP_NOWARN);
+		if (!slot->page) {
+			_cas_dram_tier_release(tier, slot);
+			return;
+		}
+
+		dst.bv_page = slot->page;
+		dst.bv_offset = 0;
+		dst.bv_len = PAGE_SIZE;
+		cas_data_cpy(&dst, 1, vec, vec_size, 0,
+				(uint64_t)i * PAGE_SIZE, PAGE_SIZE);
+
+		/* Data is stale if anything invalidated it since read began */
+		spin_lock_irqsave(lock, flags);
+		if (_cas_dram_tier_token(tier, core_key, first, sectors) ==
+					seq &&
+				!_cas_dram_tier_lookup(tier, bucket, core_key,
+					sector)) {
+			slot->core_key = core_key;
+			slot->sector = sector;
+			slot->bucket = bucket;
+			slot->referenced = false;
+			hlist_add_head(&slot->node, &tier->buckets[bucket]);
+			WRITE_ONCE(slot->hashed, true);
+			atomic64_inc(&tier->used);
+		}
+		spin_unlock_irqrestore(lock, flags);
+
+		_cas_dram_tier_release(tier, slot);
+	}
+}
+
+static void _cas_dram_tier_invalidate_walk(struct cas_dram_tier *tier,
+		uintptr_t core_key, sector_t first, sector_t end)
+{
+	struct cas_dram_tier_slot *slot;
+	unsigned long flags;
+	spinlock_t *lock;
+	uint64_t i;
+
+	atomic64_inc(&tier->seq_all);
+
+	for (i = 0; i < tier->slots_count; i++) {
+		slot = &tier->slots[i];
+		if (!READ_ONCE(slot->hashed) ||
+				READ_ONCE(slot->core_key) != core_key) {
+			continue;
+		}
+
+		lock = _cas_dram_tier_lock(tier, READ_ONCE(slot->bucket));
+		spin_lock_irqsave(lock, flags);
+		/* Slot might have been refilled into other bucket meanwhile */
+		if (slot->hashed && slot->core_key == core_key &&
+				lock == _cas_dram_tier_lock(tier, slot->bucket) &&
+				slot->sector >= first && slot->sector < end) {
+			_cas_dram_tier_unhash(tier, slot);
+		}
+		spin_unlock_irqrestore(lock, flags);
+	}
+}
+
+void cas_dram_tier_invalidate(struct cas_dram_tier *tier, uintptr_t core_key,
+		sector_t sector, uint64_t sectors)
+{
+	sector_t first = round_down(sector, CAS_DRAM_TIER_PAGE_SECTORS);
+	sector_t end = sector + sectors;
+	struct cas_dram_tier_slot *slot;
+	unsigned long flags;
+	spinlock_t *lock;
+	uint32_t bucket;
+
+	if (!sectors)
+		return;
+
+	if (end - first > (uint64_t)CAS_DRAM_TIER_INVALIDATE_PAGES_MAX *
+			CAS_DRAM_TIER_PAGE_SECTORS) {
+		_cas_dram_tier_invalidate_walk(tier, core_key, first, end);
+		return;
+	}
+
+	for (; first < end; first += CAS_DRAM_TIER_PAGE_SECTORS) {
+		atomic64_inc(_cas_dram_tier_seq(tier, core_key, first));
+
+		bucket = hash_64(_cas_dram_tier_hash(core_key, first),
+				tier->hash_shift);
+		lock = _cas_dram_tier_lock(tier, bucket);
+
+		spin_lock_irqsave(lock, flags);
+		slot = _cas_dram_tier_lookup(tier, bucket, core_key, first);
+		if (slot)
+			_cas_dram_tier_unhash(tier, slot);
+		spin_unlock_irqrestore(lock, flags);
+	}
+}
+
+void cas_dram_tier_invalidate_core(struct cas_dram_tier *tier,
+		uintptr_t core_key)
+{
+	_cas_dram_tier_invalidate_walk(tier, core_key, 0, ~(sector_t)0);
+}
+
+void cas_dram_tier_get_stats(struct cas_dram_tier *tier, uint64_t *used,
+		uint64_t *hits, uint64_t *misses)
+{
+	struct cas_dram_tier_stats *stats;
+	int cpu;
+
+	*used = atomic64_read(&tier->used);
+	*hits = 0;
+	*misses = 0;
+
+	for_each_possible_cpu(cpu) {
+		stats = per_cpu_ptr(tier->stats, cpu);
+		*hits += stats->hits;
+		*misses += stats->misses;
+	}
+}
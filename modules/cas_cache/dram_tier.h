@@ -0,0 +1,52 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __DRAM_TIER_H__
+#define __DRAM_TIER_H__
+
+struct cas_dram_tier;
+
+/*
+ * In-memory tier of cache in front of OCF. It keeps clean copies of pages of
+ * cores read repeatedly, so that page aligned reads of exported objects found
+ * there entirely are completed from memory without reaching cache device.
+ * Pages are admitted on second read miss and evicted by CLOCK. Writes and
+ * discards invalidate pages they cover, both before submission and once
+ * completed, and read misses racing with invalidation are not filled in.
+ */
+struct cas_dram_tier *cas_dram_tier_create(uint32_t size_mib);
+
+/* Called once no request uses tier anymore */
+void cas_dram_tier_destroy(struct cas_dram_tier *tier);
+
+uint32_t cas_dram_tier_get_size(struct cas_dram_tier *tier);
+
+/*
+ * Copy read of core identified by @core_key into @vec if all its pages are
+ * in tier. Otherwise @seq is set to token to be passed to fill once read is
+ * completed, or to 0 if read is not eligible for tier.
+ */
+bool cas_dram_tier_read(struct cas_dram_tier *tier, uintptr_t core_key,
+		sector_t sector, uint32_t sectors, struct bio_vec *vec,
+		uint32_t vec_size, uint64_t *seq);
+
+/* Fill data of completed read miss, may be called in atomic context */
+void cas_dram_tier_fill(struct cas_dram_tier *tier, uintptr_t core_key,
+		sector_t sector, uint32_t sectors, struct bio_vec *vec,
+		uint32_t vec_size, uint64_t seq);
+
+/* Drop pages overlapping range, may be called in atomic context */
+void cas_dram_tier_invalidate(struct cas_dram_tier *tier, uintptr_t core_key,
+		sector_t sector, uint64_t sectors);
+
+/* Drop all pages of core */
+void cas_dram_tier_invalidate_core(struct cas_dram_tier *tier,
+		uintptr_t core_key);
+
+/* Pages held, reads served from tier and eligible reads missing it */
+void cas_dram_tier_get_stats(struct cas_dram_tier *tier, uint64_t *used,
+		uint64_t *hits, uint64_t *misses);
+
+#endif /* __DRAM_TIER_H__ */
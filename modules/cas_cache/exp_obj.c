@@ -50,6 +50,18 @@ int __init cas_init_exp_objs(void)
 		return -ENOMEM;
 	}
 
+	/*
+	 * Shared by all exported objects, so that creating hundreds of them
+	 * at cache start doesn't create as many workqueues and rescuers
+	 */
+	cas_module.exp_obj_wq = alloc_workqueue("cas_exp_obj",
+			WQ_MEM_RECLAIM | WQ_HIGHPRI, 0);
+	if (!cas_module.exp_obj_wq) {
+		kmem_cache_destroy(cas_module.exp_obj_cache);
+		unregister_blkdev(cas_module.disk_major, "cas");
+		return -ENOMEM;
+	}
+
 	return 0;
 }
 
@@ -57,6 +69,7 @@ void cas_deinit_exp_objs(void)
 {
 	CAS_DEBUG_TRACE();
 
+	destroy_workqueue(cas_module.exp_obj_wq);
 	kmem_cache_destroy(cas_module.exp_obj_cache);
 	unregister_blkdev(cas_module.disk_major, "cas");
 }
@@ -184,14 +197,19 @@ static int _cas_exp_obj_hide_parts(struct cas_disk *dsk)
 	return 0;
 }
 
+/* Exported objects of cache cores are created in parallel */
+static DEFINE_SPINLOCK(cas_exp_obj_minors_lock);
+
 static int _cas_exp_obj_allocate_minors(int count)
 {
 	int minor = -1;
 
+	spin_lock(&cas_exp_obj_minors_lock);
 	if (cas_module.next_minor + count <= (1 << MINORBITS)) {
 		minor = cas_module.next_minor;
 		cas_module.next_minor += count;
 	}
+	spin_unlock(&cas_exp_obj_minors_lock);
 
 	return minor;
 }
@@ -276,11 +294,35 @@ CAS_BDEV_CLOSE(_cas_exp_obj_close, struct gendisk *gd)
 
 }
 
+#ifdef CAS_ZONED_DISK
+static int _cas_exp_obj_report_zones(struct gendisk *gd, sector_t sector,
+		unsigned int nr_zones, report_zones_cb cb, void *data)
+{
+	struct cas_disk *dsk = gd->private_data;
+	struct cas_exp_obj *exp_obj = dsk->exp_obj;
+
+	if (!exp_obj->ops->report_zones)
+		return -EOPNOTSUPP;
+
+	return exp_obj->ops->report_zones(dsk, sector, nr_zones, cb, data,
+			exp_obj->private);
+}
+#endif
+
 static const struct block_device_operations _cas_exp_obj_ops = {
 	.owner = THIS_MODULE,
 	.open = CAS_REFER_BDEV_OPEN_CALLBACK(_cas_exp_obj_open),
 	.release = CAS_REFER_BDEV_CLOSE_CALLBACK(_cas_exp_obj_close),
 	CAS_SET_SUBMIT_BIO(_cas_exp_obj_submit_bio)
+#ifdef CAS_ZONED_DISK
+	.report_zones = _cas_exp_obj_report_zones,
+#endif
+};
+
+static const struct block_device_operations _cas_exp_obj_rq_ops = {
+	.owner = THIS_MODULE,
+	.open = CAS_REFER_BDEV_OPEN_CALLBACK(_cas_exp_obj_open),
+	.release = CAS_REFER_BDEV_CLOSE_CALLBACK(_cas_exp_obj_close),
 };
 
 static int cas_exp_obj_alloc(struct cas_disk *dsk)
@@ -312,14 +354,176 @@ static void cas_exp_obj_free(struct cas_disk *dsk)
 	dsk->exp_obj = NULL;
 }
 
+static void _cas_exp_obj_dispatch_rq(struct cas_disk *dsk,
+		struct request *rq, unsigned int hw_queue)
+{
+	struct cas_exp_obj *exp_obj = dsk->exp_obj;
+	int result;
+
+	result = exp_obj->ops->queue_rq(dsk, rq, hw_queue, exp_obj->private);
+	if (result)
+		cas_exp_obj_end_request(rq, result);
+}
+
+/*
+ * Index of hw queue within its type, as poll queues are placed after
+ * default queues in tag set.
+ */
+static inline unsigned int _cas_exp_obj_hw_queue_idx(
+		struct blk_mq_hw_ctx *hctx)
+{
+#ifdef CAS_BLK_MQ_POLL
+	return hctx->queue_num -
+		hctx->queue->tag_set->map[hctx->type].queue_offset;
+#else
+	return hctx->queue_num;
+#endif
+}
+
+#ifdef CAS_BLK_MQ_OPS_COMMIT_RQS
+/*
+ * Requests which are not last in the batch are gathered on hw queue list
+ * and are handed over to cache together, when block layer either queues
+ * the last request or calls commit_rqs.
+ */
+static bool _cas_exp_obj_gather_rq(struct cas_exp_obj_hw_queue *hwq,
+		struct request *rq, bool last)
+{
+	unsigned long flags;
+
+	if (last)
+		return false;
+
+	spin_lock_irqsave(&hwq->lock, flags);
+	list_add_tail(&rq->queuelist, &hwq->rqs);
+	spin_unlock_irqrestore(&hwq->lock, flags);
+
+	return true;
+}
+
+static void _cas_exp_obj_dispatch_gathered(struct cas_disk *dsk,
+		struct cas_exp_obj_hw_queue *hwq, unsigned int hw_queue)
+{
+	struct request *rq, *next;
+	unsigned long flags;
+	LIST_HEAD(rqs);
+
+	spin_lock_irqsave(&hwq->lock, flags);
+	list_splice_init(&hwq->rqs, &rqs);
+	spin_unlock_irqrestore(&hwq->lock, flags);
+
+	list_for_each_entry_safe(rq, next, &rqs, queuelist) {
+		list_del_init(&rq->queuelist);
+		_cas_exp_obj_dispatch_rq(dsk, rq, hw_queue);
+	}
+}
+
+static void _cas_exp_obj_commit_rqs(struct blk_mq_hw_ctx *hctx)
+{
+	struct cas_disk *dsk = hctx->queue->queuedata;
+
+	_cas_exp_obj_dispatch_gathered(dsk,
+			&dsk->exp_obj->hw_queues[hctx->queue_num],
+			_cas_exp_obj_hw_queue_idx(hctx));
+}
+#else
+static inline bool _cas_exp_obj_gather_rq(struct cas_exp_obj_hw_queue *hwq,
+		struct request *rq, bool last)
+{
+	return false;
+}
+
+static inline void _cas_exp_obj_dispatch_gathered(struct cas_disk *dsk,
+		struct cas_exp_obj_hw_queue *hwq, unsigned int hw_queue)
+{
+}
+#endif
+
 static CAS_BLK_STATUS_T _cas_exp_obj_queue_rq(struct blk_mq_hw_ctx *hctx,
 		const struct blk_mq_queue_data *bd)
 {
-	return CAS_BLK_STS_NOTSUPP;
+	struct cas_disk *dsk = hctx->queue->queuedata;
+	struct cas_exp_obj *exp_obj = dsk->exp_obj;
+	struct cas_exp_obj_hw_queue *hwq;
+	struct request *rq = bd->rq;
+
+	if (!exp_obj->ops->queue_rq)
+		return CAS_BLK_STS_NOTSUPP;
+
+	hwq = &exp_obj->hw_queues[hctx->queue_num];
+
+	blk_mq_start_request(rq);
+
+	if (_cas_exp_obj_gather_rq(hwq, rq, bd->last))
+		return CAS_BLK_STS_OK;
+
+	_cas_exp_obj_dispatch_gathered(dsk, hwq, _cas_exp_obj_hw_queue_idx(hctx));
+	_cas_exp_obj_dispatch_rq(dsk, rq, _cas_exp_obj_hw_queue_idx(hctx));
+
+	return CAS_BLK_STS_OK;
+}
+
+#ifdef CAS_BLK_MQ_POLL
+static CAS_BLK_MQ_MAP_QUEUES_RET_TYPE _cas_exp_obj_map_queues(
+		struct blk_mq_tag_set *set)
+{
+	struct cas_disk *dsk = set->driver_data;
+	unsigned int nr_poll_queues = dsk->exp_obj->nr_poll_queues;
+	struct blk_mq_queue_map *map;
+
+	map = &set->map[HCTX_TYPE_DEFAULT];
+	map->nr_queues = set->nr_hw_queues - nr_poll_queues;
+	map->queue_offset = 0;
+	blk_mq_map_queues(map);
+
+	if (nr_poll_queues) {
+		set->map[HCTX_TYPE_READ].nr_queues = 0;
+
+		map = &set->map[HCTX_TYPE_POLL];
+		map->nr_queues = nr_poll_queues;
+		map->queue_offset = set->nr_hw_queues - nr_poll_queues;
+		blk_mq_map_queues(map);
+	}
+
+	CAS_BLK_MQ_MAP_QUEUES_RETURN(0);
+}
+
+/*
+ * Requests are completed by cache in context of its queues, so polling
+ * only reports requests on poll queue completed since previous call.
+ */
+static int _cas_exp_obj_poll(struct blk_mq_hw_ctx *hctx,
+		struct io_comp_batch *iob)
+{
+	struct cas_disk *dsk = hctx->queue->queuedata;
+
+	return atomic_xchg(&dsk->exp_obj->hw_queues[hctx->queue_num].completed,
+			0);
+}
+#endif
+
+void cas_exp_obj_end_request(struct request *rq, int error)
+{
+#ifdef CAS_BLK_MQ_POLL
+	struct cas_disk *dsk = rq->q->queuedata;
+
+	if (rq->mq_hctx->type == HCTX_TYPE_POLL) {
+		atomic_inc(&dsk->exp_obj->hw_queues[
+				rq->mq_hctx->queue_num].completed);
+	}
+#endif
+	blk_mq_end_request(rq, CAS_ERRNO_TO_BLK_STS(error));
 }
 
 static struct blk_mq_ops cas_mq_ops = {
 	.queue_rq       = _cas_exp_obj_queue_rq,
+#ifdef CAS_BLK_MQ_OPS_COMMIT_RQS
+	.commit_rqs	= _cas_exp_obj_commit_rqs,
+#endif
+#ifdef CAS_BLK_MQ_POLL
+	.map_queues	= _cas_exp_obj_map_queues,
+	.poll		= _cas_exp_obj_poll,
+#endif
 #ifdef CAS_BLK_MQ_OPS_MAP_QUEUE
 	.map_queue	= blk_mq_map_queue,
 #endif
@@ -339,18 +543,38 @@ static void _cas_init_queues(struct cas_disk *dsk)
 	}
 }
 
-static int _cas_init_tag_set(struct cas_disk *dsk, struct blk_mq_tag_set *set)
+static int _cas_init_tag_set(struct cas_disk *dsk, struct blk_mq_tag_set *set,
+		void *priv)
 {
+	struct cas_exp_obj *exp_obj;
+	struct cas_exp_obj_ops *ops;
+	unsigned int nr_poll_queues = 0;
+
 	BUG_ON(!dsk);
 	BUG_ON(!set);
 
+	exp_obj = dsk->exp_obj;
+	ops = exp_obj->ops;
+
 	set->ops = &cas_mq_ops;
 	set->nr_hw_queues = num_online_cpus();
 	set->numa_node = NUMA_NO_NODE;
-	/*TODO: Should we inherit qd from core device? */
 	set->queue_depth = CAS_BLKDEV_DEFAULT_RQ;
 
-	set->cmd_size = 0;
+	if (ops->set_queue_params) {
+		ops->set_queue_params(dsk, &set->queue_depth,
+				&set->nr_hw_queues, &nr_poll_queues, priv);
+	}
+
+#ifdef CAS_BLK_MQ_POLL
+	/* Poll queues are served only by request based exported object */
+	if (ops->queue_rq && nr_poll_queues < set->nr_hw_queues)
+		exp_obj->nr_poll_queues = nr_poll_queues;
+	if (exp_obj->nr_poll_queues)
+		set->nr_maps = HCTX_TYPE_POLL + 1;
+#endif
+
+	set->cmd_size = ops->cmd_size;
 	set->flags = BLK_MQ_F_SHOULD_MERGE | CAS_BLK_MQ_F_STACKING | CAS_BLK_MQ_F_BLOCKING;
 
 	set->driver_data = dsk;
@@ -358,6 +582,26 @@ static int _cas_init_tag_set(struct cas_disk *dsk, struct blk_mq_tag_set *set)
 	return blk_mq_alloc_tag_set(set);
 }
 
+static int _cas_init_hw_queues(struct cas_exp_obj *exp_obj)
+{
+	unsigned int i;
+
+	if (!exp_obj->ops->queue_rq)
+		return 0;
+
+	exp_obj->hw_queues = kcalloc(exp_obj->tag_set.nr_hw_queues,
+			sizeof(*exp_obj->hw_queues), GFP_KERNEL);
+	if (!exp_obj->hw_queues)
+		return -ENOMEM;
+
+	for (i = 0; i < exp_obj->tag_set.nr_hw_queues; i++) {
+		spin_lock_init(&exp_obj->hw_queues[i].lock);
+		INIT_LIST_HEAD(&exp_obj->hw_queues[i].rqs);
+	}
+
+	return 0;
+}
+
 static int _cas_exp_obj_check_path(const char *dev_name)
 {
 	struct file *exported;
@@ -437,11 +681,15 @@ int cas_exp_obj_create(struct cas_disk *dsk, const char *dev_name,
 	exp_obj->owner = owner;
 	exp_obj->ops = ops;
 
-	result = _cas_init_tag_set(dsk, &exp_obj->tag_set);
+	result = _cas_init_tag_set(dsk, &exp_obj->tag_set, priv);
 	if (result) {
 		goto error_init_tag_set;
 	}
 
+	result = _cas_init_hw_queues(exp_obj);
+	if (result)
+		goto error_init_hw_queues;
+
 	result = cas_alloc_mq_disk(&gd, &queue, &exp_obj->tag_set);
 	if (result) {
 		goto error_alloc_mq_disk;
@@ -461,11 +709,15 @@ int cas_exp_obj_create(struct cas_disk *dsk, const char *dev_name,
 
 	_cas_init_queues(dsk);
 
-	gd->fops = &_cas_exp_obj_ops;
 	gd->private_data = dsk;
 	strscpy(gd->disk_name, exp_obj->dev_name, sizeof(gd->disk_name));
 
-	cas_blk_queue_make_request(queue, _cas_exp_obj_make_rq_fn);
+	if (exp_obj->ops->queue_rq) {
+		gd->fops = &_cas_exp_obj_rq_ops;
+	} else {
+		gd->fops = &_cas_exp_obj_ops;
+		cas_blk_queue_make_request(queue, _cas_exp_obj_make_rq_fn);
+	}
 
 	if (exp_obj->ops->set_geometry) {
 		result = exp_obj->ops->set_geometry(dsk, exp_obj->private);
@@ -476,6 +728,9 @@ int cas_exp_obj_create(struct cas_disk *dsk, const char *dev_name,
 	if (cas_add_disk(gd))
 		goto error_add_disk;
 
+	if (exp_obj->ops->set_read_ahead)
+		exp_obj->ops->set_read_ahead(dsk, exp_obj->private);
+
 	result = bd_claim_by_disk(cas_disk_get_blkdev(dsk), dsk, gd);
 	if (result)
 		goto error_bd_claim;
@@ -492,6 +747,9 @@ error_exp_obj_set_dev_t:
 	cas_cleanup_mq_disk(gd);
 	exp_obj->gd = NULL;
 error_alloc_mq_disk:
+	kfree(exp_obj->hw_queues);
+	exp_obj->hw_queues = NULL;
+error_init_hw_queues:
 	blk_mq_free_tag_set(&exp_obj->tag_set);
 error_init_tag_set:
 	module_put(owner);
@@ -526,6 +784,9 @@ int cas_exp_obj_destroy(struct cas_disk *dsk)
 
 	blk_mq_free_tag_set(&exp_obj->tag_set);
 
+	kfree(exp_obj->hw_queues);
+	exp_obj->hw_queues = NULL;
+
 	put_disk(exp_obj->gd);
 
 	return 0;
@@ -9,6 +9,8 @@
 #include <linux/fs.h>
 
 struct cas_disk;
+struct request;
+struct blk_zone;
 
 struct cas_exp_obj_ops {
 	/**
@@ -17,12 +19,62 @@ struct cas_exp_obj_ops {
 	 */
 	int (*set_geometry)(struct cas_disk *dsk, void *private);
 
+	/**
+	 * @brief Set read-ahead of exported object (top) block device.
+	 *	Called once disk is added, as adding it resets read-ahead to
+	 *	kernel default. Could be NULL.
+	 */
+	void (*set_read_ahead)(struct cas_disk *dsk, void *private);
+
+	/**
+	 * @brief Set queue depth, number of hw queues and number of poll
+	 *	queues (included in hw queues) of exported object (top) block
+	 *	device. Values are initialized with defaults before the call.
+	 *	Could be NULL.
+	 */
+	void (*set_queue_params)(struct cas_disk *dsk,
+			unsigned int *queue_depth, unsigned int *nr_hw_queues,
+			unsigned int *nr_poll_queues, void *private);
+
 	/**
 	 * @brief submit_bio of exported object (top) block device.
 	 *
 	 */
 	void (*submit_bio)(struct cas_disk *dsk,
 			       struct bio *bio, void *private);
+
+	/**
+	 * @brief queue_rq of exported object (top) block device.
+	 *	Could be NULL, in which case exported object is bio based.
+	 *	Request is already started. On success request is owned and
+	 *	ended by callee with cas_exp_obj_end_request(), on error it is
+	 *	ended by exported object. hw_queue is index of hw queue within
+	 *	its type (default or poll).
+	 */
+	int (*queue_rq)(struct cas_disk *dsk, struct request *rq,
+			unsigned int hw_queue, void *private);
+
+	/**
+	 * @brief Size of per-request private data (request PDU) used by
+	 *	queue_rq
+	 */
+	unsigned int cmd_size;
+
+	/**
+	 * @brief Report zones of zoned exported object (top) block device.
+	 *	Could be NULL.
+	 */
+	int (*report_zones)(struct cas_disk *dsk, sector_t sector,
+			unsigned int nr_zones,
+			int (*cb)(struct blk_zone *zone, unsigned int idx,
+				void *data),
+			void *data, void *private);
+};
+
+struct cas_exp_obj_hw_queue {
+	spinlock_t lock;
+	struct list_head rqs;
+	atomic_t completed;
 };
 
 struct cas_exp_obj {
@@ -47,6 +99,9 @@ struct cas_exp_obj {
 
 	struct blk_mq_tag_set tag_set;
 
+	struct cas_exp_obj_hw_queue *hw_queues;
+	unsigned int nr_poll_queues;
+
 	void *private;
 };
 
@@ -67,6 +122,13 @@ void cas_exp_obj_cleanup(struct cas_disk *dsk);
 int cas_exp_obj_create(struct cas_disk *dsk, const char *dev_name,
 		struct module *owner, struct cas_exp_obj_ops *ops, void *priv);
 
+/**
+ * @brief End request of request based exported object (top) block device
+ * @param rq Request to be ended
+ * @param error 0 if success, errno if failure
+ */
+void cas_exp_obj_end_request(struct request *rq, int error);
+
 /**
  * @brief Get request queue of exported object (top) block device
  * @param dsk Pointer to cas_disk structure representing a block device
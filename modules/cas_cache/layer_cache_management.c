@@ -6,12 +6,36 @@
 
 #include "cas_cache.h"
 #include "threads.h"
+#include "utils/utils_rpool.h"
 
 extern u32 max_writeback_queue_size;
 extern u32 writeback_queue_unblock_size;
 extern u32 unaligned_io;
 extern u32 seq_cut_off_mb;
 extern u32 use_io_scheduler;
+extern u32 numa_io_steering;
+extern u32 numa_shard_size_mb;
+extern u32 queue_topology;
+extern u32 queue_count;
+extern u32 idle_io_queues;
+extern u32 flush_unthrottled;
+extern u32 dax_cache_volume;
+extern u32 compressed_cache_volume;
+extern u32 per_cache_bvec_pool;
+extern u32 cgroup_stats;
+extern u32 mpool_magazine;
+extern u32 metadata_write_elision;
+extern u32 stage_latency_sample;
+extern struct env_mpool *cas_bvec_pool;
+
+/* Dynamic CPU hotplug state of cache queues, negative if not registered */
+static int cas_cpuhp_state = -1;
+
+static void _cache_mngt_set_io_steering(ocf_cache_t cache);
+static void _cache_mngt_stop_queues_hotplug(ocf_cache_t cache);
+
+extern const struct ocf_queue_ops queue_ops;
+int cas_init_cleaner_queue_thread(ocf_cache_t cache, ocf_queue_t q, int cpu);
 
 struct cas_lazy_thread {
 	char name[64];
@@ -276,11 +300,47 @@ static int _cache_mngt_save_sync(ocf_cache_t cache)
 	return result;
 }
 
+struct _cache_mngt_flush_throttle {
+	bool unthrottled;
+	uint64_t rate_limit;
+};
+
+static int _cache_mngt_core_set_flush_throttle(ocf_core_t core, void *cntx)
+{
+	struct _cache_mngt_flush_throttle *throttle = cntx;
+	ocf_volume_t volume = ocf_core_get_volume(core);
+
+	block_dev_set_inflight_unthrottled(volume, throttle->unthrottled);
+	block_dev_set_background_rate(volume, throttle->rate_limit);
+
+	return 0;
+}
+
+/*
+ * Flush of whole cache writes back all cores at once, don't let background
+ * inflight limits of core devices stretch it. Rate limited flush instead
+ * caps writeback to each core device at rate_limit MiB/s and keeps yielding
+ * to foreground I/O. Once flush is done both are reverted.
+ */
+static void _cache_mngt_cache_flush_throttle(ocf_cache_t cache, bool start,
+		uint32_t rate_limit)
+{
+	struct _cache_mngt_flush_throttle throttle = {
+		.unthrottled = start && !rate_limit && flush_unthrottled,
+		.rate_limit = start ? (uint64_t)rate_limit << 20 : 0,
+	};
+
+	ocf_core_visit(cache, _cache_mngt_core_set_flush_throttle, &throttle,
+			true);
+}
+
 static void _cache_mngt_cache_flush_uninterruptible_complete(ocf_cache_t cache,
 		void *priv, int error)
 {
 	struct _cache_mngt_sync_context *context = priv;
 
+	_cache_mngt_cache_flush_throttle(cache, false, 0);
+
 	*context->result = error;
 	complete(&context->cmpl);
 }
@@ -299,6 +359,7 @@ static int _cache_mngt_cache_flush_uninterruptible(ocf_cache_t cache)
 	context.result = &result;
 	atomic_set(&cache_priv->flush_interrupt_enabled, 0);
 
+	_cache_mngt_cache_flush_throttle(cache, true, 0);
 	ocf_mngt_cache_flush(cache, _cache_mngt_cache_flush_uninterruptible_complete,
 			&context);
 	wait_for_completion(&context.cmpl);
@@ -308,96 +369,212 @@ static int _cache_mngt_cache_flush_uninterruptible(ocf_cache_t cache)
 	return result;
 }
 
-static void _cache_mngt_cache_purge_complete(ocf_cache_t cache, void *priv,
-		int error)
+#define CAS_PURGE_RETRY_DELAY (HZ / 10)
+
+/* Finish purge, reporting result to waiting caller if there is one */
+static void _cache_mngt_purge_end(struct cache_priv *cache_priv, int error)
 {
-	struct _cache_mngt_async_context *context = priv;
-	int result;
+	struct _cache_mngt_async_context *context;
 
-	if (context->compl_func)
-		context->compl_func(cache);
+	spin_lock(&cache_priv->purge.lock);
+	context = cache_priv->purge.context;
+	cache_priv->purge.context = NULL;
+	cache_priv->purge.active = false;
+	spin_unlock(&cache_priv->purge.lock);
 
-	result = _cache_mngt_async_callee_set_result(context, error);
+	if (!context) {
+		if (error) {
+			printk(KERN_ERR "%s: Background purge failed\n",
+					ocf_cache_get_name(cache_priv->cache));
+		}
+		return;
+	}
 
-	if (result == -KCAS_ERR_WAITING_INTERRUPTED)
+	if (_cache_mngt_async_callee_set_result(context, error) ==
+			-KCAS_ERR_WAITING_INTERRUPTED) {
 		kfree(context);
+	}
+}
+
+static void _cache_mngt_purge_chunk_end(struct cache_priv *cache_priv,
+		int error)
+{
+	spin_lock(&cache_priv->purge.lock);
+	cache_priv->purge.done++;
+	spin_unlock(&cache_priv->purge.lock);
+
+	/* Queued before unlocking to not race with stopping cache */
+	if (error)
+		_cache_mngt_purge_end(cache_priv, error);
+	else
+		schedule_delayed_work(&cache_priv->purge.work, 0);
+
+	ocf_mngt_cache_read_unlock(cache_priv->cache);
+}
+
+static void _cache_mngt_purge_core_complete(ocf_core_t core, void *priv,
+		int error)
+{
+	_cache_mngt_purge_chunk_end(priv, error);
+}
+
+static void _cache_mngt_purge_cache_complete(ocf_cache_t cache, void *priv,
+		int error)
+{
+	_cache_mngt_purge_chunk_end(priv, error);
 }
 
 /*
- * Possible return values:
- * 0 - completion was called and operation succeded
- * -KCAS_ERR_WAITING_INTERRUPTED - operation was canceled, caller must
- *		propagate error
- * other values - completion was called and operation failed
+ * Purge of whole cache goes core by core, each core being one chunk under
+ * management read lock. Lock is released between chunks, so management
+ * operations and readers of stats don't wait for the whole purge. Inactive
+ * cores can't be purged on their own, if there are any, whole cache purge
+ * finishes the job.
  */
-static int _cache_mngt_cache_purge_sync(ocf_cache_t cache,
-		void (*compl)(ocf_cache_t cache))
+static void _cache_mngt_purge_work(struct work_struct *work)
 {
-	int result;
-	struct _cache_mngt_async_context *context;
+	struct cache_priv *cache_priv = container_of(to_delayed_work(work),
+			struct cache_priv, purge.work);
+	ocf_cache_t cache = cache_priv->cache;
+	ocf_core_id_t id, end, core_id;
+	ocf_core_t core = NULL;
+	bool all, final;
 
-	context = kmalloc(sizeof(*context), GFP_KERNEL);
-	if (!context) {
-		if (compl)
-			compl(cache);
-		return -ENOMEM;
+	/* Don't wait for management operation, possibly stopping cache */
+	if (ocf_mngt_cache_read_trylock(cache)) {
+		schedule_delayed_work(&cache_priv->purge.work,
+				CAS_PURGE_RETRY_DELAY);
+		return;
 	}
 
-	_cache_mngt_async_context_init(context);
-	context->compl_func = compl;
+	spin_lock(&cache_priv->purge.lock);
+	core_id = cache_priv->purge.core_id;
+	id = cache_priv->purge.next;
+	spin_unlock(&cache_priv->purge.lock);
 
-	ocf_mngt_cache_purge(cache, _cache_mngt_cache_purge_complete, context);
-	result = wait_for_completion_interruptible(&context->cmpl);
+	all = (core_id == OCF_CORE_ID_INVALID);
+	end = all ? OCF_CORE_MAX : core_id + 1;
 
-	result = _cache_mngt_async_caller_set_result(context, result);
+	for (; id < end; id++) {
+		if (get_core_by_id(cache, id, &core))
+			continue;
+		if (!all || ocf_core_get_state(core) == ocf_core_state_active)
+			break;
+		spin_lock(&cache_priv->purge.lock);
+		if (!cache_priv->purge.skipped) {
+			cache_priv->purge.skipped = true;
+			cache_priv->purge.total++;
+		}
+		spin_unlock(&cache_priv->purge.lock);
+	}
 
-	if (result != -KCAS_ERR_WAITING_INTERRUPTED)
-		kfree(context);
+	spin_lock(&cache_priv->purge.lock);
+	cache_priv->purge.next = id + 1;
+	final = all && id >= end && cache_priv->purge.skipped;
+	if (final)
+		cache_priv->purge.skipped = false;
+	spin_unlock(&cache_priv->purge.lock);
 
-	return result;
+	if (id < end) {
+		ocf_mngt_core_purge(core, _cache_mngt_purge_core_complete,
+				cache_priv);
+		return;
+	}
+
+	if (final) {
+		ocf_mngt_cache_purge(cache, _cache_mngt_purge_cache_complete,
+				cache_priv);
+		return;
+	}
+
+	/* Purged core has been removed in the meantime */
+	if (!all && cache_priv->purge.done == 0)
+		_cache_mngt_purge_end(cache_priv, -OCF_ERR_CORE_NOT_AVAIL);
+	else
+		_cache_mngt_purge_end(cache_priv, 0);
+
+	ocf_mngt_cache_read_unlock(cache);
 }
 
-static void _cache_mngt_core_purge_complete(ocf_core_t core, void *priv,
-		int error)
+static void _cache_mngt_purge_init(struct cache_priv *cache_priv)
 {
-	struct _cache_mngt_async_context *context = priv;
-	int result;
-	ocf_cache_t cache = ocf_core_get_cache(core);
+	spin_lock_init(&cache_priv->purge.lock);
+	INIT_DELAYED_WORK(&cache_priv->purge.work, _cache_mngt_purge_work);
+}
 
-	if (context->compl_func)
-		context->compl_func(cache);
+/* Called once cache is locked for stopping or has never been started */
+static void _cache_mngt_purge_stop(struct cache_priv *cache_priv)
+{
+	cancel_delayed_work_sync(&cache_priv->purge.work);
 
-	result = _cache_mngt_async_callee_set_result(context, error);
+	if (cache_priv->purge.active)
+		_cache_mngt_purge_end(cache_priv, -OCF_ERR_INTR);
+}
 
-	if (result == -KCAS_ERR_WAITING_INTERRUPTED)
-		kfree(context);
+/*
+ * Start purge of given core or of whole cache when core is NULL, called
+ * under management read lock. Without context purge runs in background,
+ * otherwise the context is completed when purge ends.
+ */
+static int _cache_mngt_purge_start(ocf_cache_t cache, ocf_core_t core,
+		struct _cache_mngt_async_context *context)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+
+	spin_lock(&cache_priv->purge.lock);
+	if (cache_priv->purge.active) {
+		spin_unlock(&cache_priv->purge.lock);
+		return -KCAS_ERR_PURGE_IN_PROGRESS;
+	}
+
+	cache_priv->purge.active = true;
+	cache_priv->purge.core_id = core ? ocf_core_get_id(core) :
+			OCF_CORE_ID_INVALID;
+	cache_priv->purge.next = core ? ocf_core_get_id(core) : 0;
+	cache_priv->purge.skipped = false;
+	cache_priv->purge.done = 0;
+	cache_priv->purge.total = core ? 1 : ocf_cache_get_core_count(cache);
+	cache_priv->purge.context = context;
+	spin_unlock(&cache_priv->purge.lock);
+
+	schedule_delayed_work(&cache_priv->purge.work, 0);
+
+	return 0;
 }
 
 /*
+ * Called with management read lock and cache reference held, releases both.
  * Possible return values:
- * 0 - completion was called and operation succeded
- * -KCAS_ERR_WAITING_INTERRUPTED - operation was canceled, caller must
- *		propagate error
- * other values - completion was called and operation failed
+ * 0 - purge finished successfully or has been started in background
+ * -KCAS_ERR_WAITING_INTERRUPTED - waiting was interrupted, purge continues
+ *		in background
+ * other values - purge failed
  */
-static int _cache_mngt_core_purge_sync(ocf_core_t core, bool interruption,
-		void (*compl)(ocf_cache_t cache))
+static int _cache_mngt_purge_run(ocf_cache_t cache, ocf_core_t core,
+		bool background)
 {
+	struct _cache_mngt_async_context *context = NULL;
 	int result;
-	struct _cache_mngt_async_context *context;
-	ocf_cache_t cache = ocf_core_get_cache(core);
 
-	context = kmalloc(sizeof(*context), GFP_KERNEL);
-	if (!context) {
-		if (compl)
-			compl(cache);
-		return -ENOMEM;
+	if (!background) {
+		context = kmalloc(sizeof(*context), GFP_KERNEL);
+		if (!context) {
+			ocf_mngt_cache_read_unlock(cache);
+			ocf_mngt_cache_put(cache);
+			return -ENOMEM;
+		}
+		_cache_mngt_async_context_init(context);
 	}
 
-	_cache_mngt_async_context_init(context);
-	context->compl_func = compl;
+	result = _cache_mngt_purge_start(cache, core, context);
+	ocf_mngt_cache_read_unlock(cache);
+
+	if (result || background) {
+		kfree(context);
+		ocf_mngt_cache_put(cache);
+		return result;
+	}
 
-	ocf_mngt_core_purge(core, _cache_mngt_core_purge_complete, context);
 	result = wait_for_completion_interruptible(&context->cmpl);
 
 	result = _cache_mngt_async_caller_set_result(context, result);
@@ -405,6 +582,8 @@ static int _cache_mngt_core_purge_sync(ocf_core_t core, bool interruption,
 	if (result != -KCAS_ERR_WAITING_INTERRUPTED)
 		kfree(context);
 
+	ocf_mngt_cache_put(cache);
+
 	return result;
 }
 
@@ -414,6 +593,8 @@ static void _cache_mngt_cache_flush_complete(ocf_cache_t cache, void *priv,
 	struct _cache_mngt_async_context *context = priv;
 	int result;
 
+	_cache_mngt_cache_flush_throttle(cache, false, 0);
+
 	if (context->compl_func)
 		context->compl_func(cache);
 
@@ -431,7 +612,7 @@ static void _cache_mngt_cache_flush_complete(ocf_cache_t cache, void *priv,
  * other values - completion was called and operation failed
  */
 static int _cache_mngt_cache_flush_sync(ocf_cache_t cache, bool interruption,
-		void (*compl)(ocf_cache_t cache))
+		uint32_t rate_limit, void (*compl)(ocf_cache_t cache))
 {
 	int result;
 	struct _cache_mngt_async_context *context;
@@ -448,6 +629,7 @@ static int _cache_mngt_cache_flush_sync(ocf_cache_t cache, bool interruption,
 	context->compl_func = compl;
 	atomic_set(&cache_priv->flush_interrupt_enabled, interruption);
 
+	_cache_mngt_cache_flush_throttle(cache, true, rate_limit);
 	ocf_mngt_cache_flush(cache, _cache_mngt_cache_flush_complete, context);
 	result = wait_for_completion_interruptible(&context->cmpl);
 
@@ -470,6 +652,8 @@ static void _cache_mngt_core_flush_complete(ocf_core_t core, void *priv,
 	int result;
 	ocf_cache_t cache = ocf_core_get_cache(core);
 
+	block_dev_set_background_rate(ocf_core_get_volume(core), 0);
+
 	if (context->compl_func)
 		context->compl_func(cache);
 
@@ -487,7 +671,7 @@ static void _cache_mngt_core_flush_complete(ocf_core_t core, void *priv,
  * other values - completion was called and operation failed
  */
 static int _cache_mngt_core_flush_sync(ocf_core_t core, bool interruption,
-		void (*compl)(ocf_cache_t cache))
+		uint32_t rate_limit, void (*compl)(ocf_cache_t cache))
 {
 	int result;
 	struct _cache_mngt_async_context *context;
@@ -505,6 +689,9 @@ static int _cache_mngt_core_flush_sync(ocf_core_t core, bool interruption,
 	context->compl_func = compl;
 	atomic_set(&cache_priv->flush_interrupt_enabled, interruption);
 
+	/* Rate limited writeback to core device, reverted on completion */
+	block_dev_set_background_rate(ocf_core_get_volume(core),
+			(uint64_t)rate_limit << 20);
 	ocf_mngt_core_flush(core, _cache_mngt_core_flush_complete, context);
 	result = wait_for_completion_interruptible(&context->cmpl);
 
@@ -561,11 +748,176 @@ struct _cache_mngt_stop_context {
 	struct cas_lazy_thread *finish_thread;
 };
 
+static void _cache_mngt_fs_meta_learn_stop(struct cache_priv *cache_priv);
+static void _cache_mngt_mode_drain_stop(struct cache_priv *cache_priv);
+static void _cache_mngt_nhit_adapt_stop(struct cache_priv *cache_priv);
+static void _cache_mngt_seq_absorb_stop(ocf_cache_t cache);
+static void _cache_mngt_prio_adapt_stop(struct cache_priv *cache_priv);
+static void _cache_mngt_trim_stop(struct cache_priv *cache_priv);
+
+/*
+ * Statistics snapshots are read without management lock, under RCU only.
+ * Private data is unset first, so no reader can find them once freed.
+ */
+static void _cache_mngt_stats_snapshot_free(ocf_cache_t cache)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	uint32_t i;
+
+	ocf_cache_set_priv(cache, NULL);
+	synchronize_rcu();
+
+	for (i = 0; i <= OCF_CORE_MAX; i++)
+		kfree(rcu_access_pointer(cache_priv->stats_snapshot[i]));
+}
+
+/* Forget statistics of removed core, called under management lock */
+static void _cache_mngt_stats_snapshot_drop(struct cache_priv *cache_priv,
+		ocf_core_id_t core_id)
+{
+	struct cas_stats_snapshot *snap;
+
+	snap = rcu_dereference_protected(cache_priv->stats_snapshot[core_id],
+			true);
+	RCU_INIT_POINTER(cache_priv->stats_snapshot[core_id], NULL);
+	if (snap)
+		kfree_rcu(snap, rcu);
+}
+
+/*
+ * Find snapshot entry of statistics requested, returns NULL if there is no
+ * slot for given ids.
+ */
+static struct cas_stats_snapshot_entry *_cache_mngt_stats_snapshot_entry(
+		struct cas_stats_snapshot *snap, uint16_t part_id)
+{
+	if (!snap)
+		return NULL;
+
+	if (part_id == OCF_IO_CLASS_INVALID)
+		return &snap->part[OCF_IO_CLASS_MAX];
+
+	return part_id < OCF_IO_CLASS_MAX ? &snap->part[part_id] : NULL;
+}
+
+static int _cache_mngt_stats_snapshot_slot(uint16_t core_id)
+{
+	if (core_id == OCF_CORE_ID_INVALID)
+		return OCF_CORE_MAX;
+
+	return core_id < OCF_CORE_MAX ? core_id : -1;
+}
+
+/* Keep collected statistics, called under management read lock */
+static void _cache_mngt_stats_snapshot_store(ocf_cache_t cache,
+		const struct kcas_get_stats *stats)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	int slot = _cache_mngt_stats_snapshot_slot(stats->core_id);
+	struct cas_stats_snapshot_entry *entry;
+	struct cas_stats_snapshot *snap, *new;
+	uint32_t i;
+
+	if (slot < 0)
+		return;
+
+	/* Core can't be removed while management lock is held */
+	snap = rcu_dereference_protected(cache_priv->stats_snapshot[slot],
+			true);
+	if (!snap) {
+		new = kzalloc(sizeof(*new), GFP_KERNEL | __GFP_NOWARN);
+		if (!new)
+			return;
+
+		for (i = 0; i <= OCF_IO_CLASS_MAX; i++)
+			seqlock_init(&new->part[i].lock);
+
+		/* Concurrent reader under the same lock might have won */
+		snap = cmpxchg(&cache_priv->stats_snapshot[slot], NULL, new);
+		if (snap)
+			kfree(new);
+		else
+			snap = new;
+	}
+
+	entry = _cache_mngt_stats_snapshot_entry(snap, stats->part_id);
+	if (!entry)
+		return;
+
+	write_seqlock(&entry->lock);
+	entry->usage = stats->usage;
+	entry->req = stats->req;
+	entry->blocks = stats->blocks;
+	entry->errors = stats->errors;
+	entry->valid = true;
+	write_sequnlock(&entry->lock);
+}
+
+/*
+ * Fill statistics from last snapshot without taking management lock.
+ * Returns false if there is no snapshot of requested statistics yet.
+ */
+static bool _cache_mngt_stats_snapshot_read(ocf_cache_t cache,
+		struct kcas_get_stats *stats)
+{
+	int slot = _cache_mngt_stats_snapshot_slot(stats->core_id);
+	struct cas_stats_snapshot_entry *entry;
+	struct cache_priv *cache_priv;
+	unsigned int seq;
+	bool valid = false;
+
+	if (slot < 0)
+		return false;
+
+	rcu_read_lock();
+	cache_priv = ocf_cache_get_priv(cache);
+	if (!cache_priv)
+		goto unlock;
+
+	entry = _cache_mngt_stats_snapshot_entry(
+			rcu_dereference(cache_priv->stats_snapshot[slot]),
+			stats->part_id);
+	if (!entry)
+		goto unlock;
+
+	do {
+		seq = read_seqbegin(&entry->lock);
+		valid = entry->valid;
+		stats->usage = entry->usage;
+		stats->req = entry->req;
+		stats->blocks = entry->blocks;
+		stats->errors = entry->errors;
+	} while (read_seqretry(&entry->lock, seq));
+
+unlock:
+	rcu_read_unlock();
+	return valid;
+}
+
 static void _cache_mngt_cache_priv_deinit(ocf_cache_t cache)
 {
 	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
 
+	_cache_mngt_fs_meta_learn_stop(cache_priv);
+	_cache_mngt_mode_drain_stop(cache_priv);
+	_cache_mngt_purge_stop(cache_priv);
+	_cache_mngt_nhit_adapt_stop(cache_priv);
+	_cache_mngt_seq_absorb_stop(cache);
+	_cache_mngt_prio_adapt_stop(cache_priv);
+	_cache_mngt_trim_stop(cache_priv);
+	cas_prefetch_stop(cache_priv);
+	_cache_mngt_stats_snapshot_free(cache);
 	kfree(cache_priv->stop_context);
+	if (rcu_access_pointer(cache_priv->tinylfu))
+		cas_tinylfu_destroy(rcu_access_pointer(cache_priv->tinylfu));
+	if (rcu_access_pointer(cache_priv->dram_tier))
+		cas_dram_tier_destroy(rcu_access_pointer(cache_priv->dram_tier));
+	if (rcu_access_pointer(cache_priv->cleaner.rewrite))
+		cas_rewrite_destroy(rcu_access_pointer(cache_priv->cleaner.rewrite));
+	if (cache_priv->cgroup_stats)
+		cas_cgroup_stats_destroy(cache_priv->cgroup_stats);
+	if (cache_priv->bvec_pool)
+		env_mpool_destroy(cache_priv->bvec_pool);
 
 	vfree(cache_priv);
 }
@@ -592,11 +944,20 @@ static int exit_instance_finish(void *data)
 	if (!ocf_cache_is_standby(ctx->cache))
 		cas_cls_deinit(ctx->cache);
 
-	for (i = 0; i < OCF_CORE_MAX; i ++) {
-		if (cache_priv->fs_meta_dict[i].length && cache_priv->fs_meta_dict[i].data) {
-			vfree(cache_priv->fs_meta_dict[i].data);
-		}
-	}
+	/* Cache is stopped, nobody looks up metadata anymore */
+	for (i = 0; i < OCF_CORE_MAX; i ++)
+		vfree(rcu_access_pointer(cache_priv->fs_meta[i]));
+	_cache_mngt_stats_snapshot_free(ctx->cache);
+	if (rcu_access_pointer(cache_priv->tinylfu))
+		cas_tinylfu_destroy(rcu_access_pointer(cache_priv->tinylfu));
+	if (rcu_access_pointer(cache_priv->dram_tier))
+		cas_dram_tier_destroy(rcu_access_pointer(cache_priv->dram_tier));
+	if (rcu_access_pointer(cache_priv->cleaner.rewrite))
+		cas_rewrite_destroy(rcu_access_pointer(cache_priv->cleaner.rewrite));
+	if (cache_priv->cgroup_stats)
+		cas_cgroup_stats_destroy(cache_priv->cgroup_stats);
+	if (cache_priv->bvec_pool)
+		env_mpool_destroy(cache_priv->bvec_pool);
 	vfree(cache_priv);
 
 	ocf_mngt_cache_unlock(ctx->cache);
@@ -695,6 +1056,15 @@ static int _cache_mngt_cache_stop_sync(ocf_cache_t cache)
 	context->error = 0;
 	context->cache = cache;
 
+	_cache_mngt_fs_meta_learn_stop(cache_priv);
+	_cache_mngt_mode_drain_stop(cache_priv);
+	_cache_mngt_purge_stop(cache_priv);
+	_cache_mngt_nhit_adapt_stop(cache_priv);
+	_cache_mngt_seq_absorb_stop(cache);
+	_cache_mngt_prio_adapt_stop(cache_priv);
+	_cache_mngt_trim_stop(cache_priv);
+	cas_prefetch_stop(cache_priv);
+	_cache_mngt_stop_queues_hotplug(cache);
 	ocf_mngt_cache_stop(cache, _cache_mngt_cache_stop_complete, context);
 	result = wait_for_completion_interruptible(&context->async.cmpl);
 
@@ -706,25 +1076,70 @@ static int _cache_mngt_cache_stop_sync(ocf_cache_t cache)
 	return result;
 }
 
+#define CAS_CACHE_ID_BITS (OCF_CACHE_ID_MAX + 1)
+
+/* Ids handed out by find_free_cache_id() to starts still in progress */
+static unsigned long cas_cache_ids_reserved[BITS_TO_LONGS(CAS_CACHE_ID_BITS)];
+static DEFINE_SPINLOCK(cas_cache_ids_lock);
+
+static int _cache_mngt_mark_cache_id(ocf_cache_t cache, void *cntx)
+{
+	unsigned long *used = cntx;
+	uint32_t id;
+
+	if (!cache_id_from_name(&id, ocf_cache_get_name(cache)) &&
+			id < CAS_CACHE_ID_BITS) {
+		set_bit(id, used);
+	}
+
+	return 0;
+}
+
+/*
+ * Find lowest id neither used by a cache nor reserved by another start.
+ * Caches are visited once instead of looking up each id, which would take
+ * context lock of OCF for every id in use. The id returned stays reserved
+ * until cache_mngt_release_cache_id(), so concurrent starts don't race for
+ * it.
+ */
 static uint32_t find_free_cache_id(ocf_ctx_t ctx)
 {
-	ocf_cache_t cache;
+	unsigned long *used;
 	uint32_t id;
-	int result;
 
-	for (id = OCF_CACHE_ID_MIN; id < OCF_CACHE_ID_MAX; id++) {
-		result = mngt_get_cache_by_id(ctx, id, &cache);
-		if (!result)
-			ocf_mngt_cache_put(cache);
-		else if (result == -OCF_ERR_CACHE_NOT_EXIST)
-			break;
-		else
-			return OCF_CACHE_ID_INVALID;
+	used = kcalloc(BITS_TO_LONGS(CAS_CACHE_ID_BITS), sizeof(*used),
+			GFP_KERNEL);
+	if (!used)
+		return OCF_CACHE_ID_INVALID;
+
+	if (ocf_mngt_cache_visit(ctx, _cache_mngt_mark_cache_id, used)) {
+		kfree(used);
+		return OCF_CACHE_ID_INVALID;
 	}
 
+	spin_lock(&cas_cache_ids_lock);
+	bitmap_or(used, used, cas_cache_ids_reserved, CAS_CACHE_ID_BITS);
+	id = find_next_zero_bit(used, OCF_CACHE_ID_MAX, OCF_CACHE_ID_MIN);
+	if (id < OCF_CACHE_ID_MAX)
+		set_bit(id, cas_cache_ids_reserved);
+	else
+		id = OCF_CACHE_ID_INVALID;
+	spin_unlock(&cas_cache_ids_lock);
+
+	kfree(used);
 	return id;
 }
 
+void cache_mngt_release_cache_id(uint32_t cache_id)
+{
+	if (cache_id >= CAS_CACHE_ID_BITS)
+		return;
+
+	spin_lock(&cas_cache_ids_lock);
+	clear_bit(cache_id, cas_cache_ids_reserved);
+	spin_unlock(&cas_cache_ids_lock);
+}
+
 static uint64_t _ffz(uint64_t word)
 {
 	int i;
@@ -785,7 +1200,8 @@ static void _cache_read_unlock_put_cmpl(ocf_cache_t cache)
 }
 
 int cache_mngt_purge_object(const char *cache_name, size_t cache_name_len,
-			const char *core_name, size_t core_name_len)
+			const char *core_name, size_t core_name_len,
+			bool background)
 {
 	ocf_cache_t cache;
 	ocf_core_t core;
@@ -814,14 +1230,12 @@ int cache_mngt_purge_object(const char *cache_name, size_t cache_name_len,
 		return result;
 	}
 
-	result = _cache_mngt_core_purge_sync(core, true,
-			_cache_read_unlock_put_cmpl);
-
-	return result;
+	return _cache_mngt_purge_run(cache, core, background);
 }
 
 int cache_mngt_flush_object(const char *cache_name, size_t cache_name_len,
-			const char *core_name, size_t core_name_len)
+			const char *core_name, size_t core_name_len,
+			uint32_t rate_limit)
 {
 	ocf_cache_t cache;
 	ocf_core_t core;
@@ -845,13 +1259,14 @@ int cache_mngt_flush_object(const char *cache_name, size_t cache_name_len,
 		return result;
 	}
 
-	result = _cache_mngt_core_flush_sync(core, true,
+	result = _cache_mngt_core_flush_sync(core, true, rate_limit,
 			_cache_read_unlock_put_cmpl);
 
 	return result;
 }
 
-int cache_mngt_purge_device(const char *cache_name, size_t name_len)
+int cache_mngt_purge_device(const char *cache_name, size_t name_len,
+		bool background)
 {
 	int result;
 	ocf_cache_t cache;
@@ -867,12 +1282,11 @@ int cache_mngt_purge_device(const char *cache_name, size_t name_len)
 		return result;
 	}
 
-	result = _cache_mngt_cache_purge_sync(cache, _cache_read_unlock_put_cmpl);
-
-	return result;
+	return _cache_mngt_purge_run(cache, NULL, background);
 }
 
-int cache_mngt_flush_device(const char *cache_name, size_t name_len)
+int cache_mngt_flush_device(const char *cache_name, size_t name_len,
+		uint32_t rate_limit)
 {
 	int result;
 	ocf_cache_t cache;
@@ -888,7 +1302,7 @@ int cache_mngt_flush_device(const char *cache_name, size_t name_len)
 		return result;
 	}
 
-	result = _cache_mngt_cache_flush_sync(cache, true,
+	result = _cache_mngt_cache_flush_sync(cache, true, rate_limit,
 			_cache_read_unlock_put_cmpl);
 
 	return result;
@@ -918,35 +1332,257 @@ int cache_mngt_get_dirty_data_chunk(ocf_cache_t cache, uint32_t *control)
 	return result;
 }
 
+static int _cache_mngt_sum_core_flushes_elided(ocf_core_t core, void *cntx)
+{
+	uint64_t *count = cntx;
 
-int cache_mngt_set_cleaner_policy(ocf_cache_t cache, uint32_t control)
+	*count += block_dev_get_flushes_elided(ocf_core_get_volume(core));
+
+	return 0;
+}
+
+/* Called under management lock */
+static uint64_t _cache_mngt_get_flushes_elided(ocf_cache_t cache)
 {
-	int result;
+	uint64_t elided = 0;
 
-	result = _cache_mngt_lock_sync(cache);
+	if (ocf_cache_is_device_attached(cache)) {
+		elided += block_dev_get_flushes_elided(
+				ocf_cache_get_volume(cache));
+	}
+	ocf_core_visit(cache, _cache_mngt_sum_core_flushes_elided, &elided,
+			true);
+
+	return elided;
+}
+
+static int cache_mngt_set_queue_poll_time(ocf_cache_t cache, uint32_t poll_us)
+{
+	struct cache_priv *cache_priv;
+	int result, i;
+
+	if (poll_us > CAS_QUEUE_POLL_TIME_MAX)
+		return -EINVAL;
+
+	result = _cache_mngt_read_lock_sync(cache);
 	if (result)
 		return result;
 
-	result = ocf_mngt_cache_cleaner_set_policy(cache, control);
-	if (result)
-		goto out;
+	cache_priv = ocf_cache_get_priv(cache);
+	cache_priv->queue_poll_us = poll_us;
+	for (i = 0; i < nr_cpu_ids; i++) {
+		if (!cache_priv_owns_queue(cache_priv, i))
+			continue;
+		cas_set_queue_thread_poll(cache_priv->queues[i].worker_queue,
+				poll_us);
+		cas_set_queue_thread_poll(cache_priv->queues[i].porter_queue,
+				poll_us);
+		if (cache_priv->queues[i].idle_queue) {
+			cas_set_queue_thread_poll(
+					cache_priv->queues[i].idle_queue,
+					poll_us);
+		}
+	}
 
-	result = _cache_mngt_save_sync(cache);
+	mutex_lock(&cache_priv->cleaner.lock);
+	for (i = 0; i < CAS_CLEANER_WORKERS_MAX; i++) {
+		if (cache_priv->cleaner.queues[i])
+			cas_set_queue_thread_poll(cache_priv->cleaner.queues[i],
+					poll_us);
+	}
+	mutex_unlock(&cache_priv->cleaner.lock);
 
-out:
-	ocf_mngt_cache_unlock(cache);
+	ocf_mngt_cache_read_unlock(cache);
 	return result;
 }
 
-int cache_mngt_get_cleaner_policy(ocf_cache_t cache, uint32_t *control)
+static int cache_mngt_get_queue_poll_time(ocf_cache_t cache, uint32_t *poll_us)
 {
-	int result;
-
-	result = _cache_mngt_read_lock_sync(cache);
+	struct cache_priv *cache_priv;
+	int result = _cache_mngt_read_lock_sync(cache);
 	if (result)
 		return result;
 
-	result = ocf_mngt_cache_cleaner_get_policy(cache, control);
+	cache_priv = ocf_cache_get_priv(cache);
+	*poll_us = cache_priv->queue_poll_us;
+
+	ocf_mngt_cache_read_unlock(cache);
+	return result;
+}
+
+int cache_mngt_set_cleaner_policy(ocf_cache_t cache, uint32_t control)
+{
+	int result;
+
+	result = _cache_mngt_lock_sync(cache);
+	if (result)
+		return result;
+
+	result = ocf_mngt_cache_cleaner_set_policy(cache, control);
+	if (result)
+		goto out;
+
+	result = _cache_mngt_save_sync(cache);
+
+out:
+	ocf_mngt_cache_unlock(cache);
+	return result;
+}
+
+int cache_mngt_get_cleaner_policy(ocf_cache_t cache, uint32_t *control)
+{
+	int result;
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	result = ocf_mngt_cache_cleaner_get_policy(cache, control);
+
+	ocf_mngt_cache_read_unlock(cache);
+	return result;
+}
+
+/*
+ * Cleaning passes of single cache cannot overlap, but each pass pushes all
+ * its flush requests through one queue. Dedicated queues keep that work
+ * off porter queues serving read misses, and consecutive passes rotate
+ * over them to spread cleaning work over several threads. Queues being
+ * released are kept alive by running pass reference.
+ */
+static int cache_mngt_set_cleaner_workers(ocf_cache_t cache, uint32_t workers)
+{
+	struct cache_priv *cache_priv;
+	ocf_queue_t queues[CAS_CLEANER_WORKERS_MAX] = {};
+	uint32_t i, queues_no;
+	int result;
+
+	if (workers < 1 || workers > CAS_CLEANER_WORKERS_MAX)
+		return -EINVAL;
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	cache_priv = ocf_cache_get_priv(cache);
+
+	mutex_lock(&cache_priv->cleaner.lock);
+
+	queues_no = cache_priv->cleaner.workers > 1 ?
+			cache_priv->cleaner.workers : 0;
+	memcpy(queues, cache_priv->cleaner.queues, sizeof(queues));
+
+	for (i = queues_no; workers > 1 && i < workers; i++) {
+		result = ocf_queue_create(cache, &queues[i], &queue_ops);
+		if (result)
+			goto err;
+
+		result = cas_init_cleaner_queue_thread(cache, queues[i],
+				CAS_CPUS_ALL);
+		if (result) {
+			ocf_queue_put(queues[i]);
+			queues[i] = NULL;
+			goto err;
+		}
+
+		cas_set_queue_thread_poll(queues[i], cache_priv->queue_poll_us);
+	}
+
+	for (i = workers > 1 ? workers : 0; i < queues_no; i++) {
+		ocf_queue_put(queues[i]);
+		queues[i] = NULL;
+	}
+
+	memcpy(cache_priv->cleaner.queues, queues, sizeof(queues));
+	cache_priv->cleaner.workers = workers;
+	cache_priv->cleaner.next = 0;
+
+	mutex_unlock(&cache_priv->cleaner.lock);
+	ocf_mngt_cache_read_unlock(cache);
+	return 0;
+
+err:
+	while (i-- > queues_no) {
+		ocf_queue_put(queues[i]);
+	}
+	mutex_unlock(&cache_priv->cleaner.lock);
+	ocf_mngt_cache_read_unlock(cache);
+	return result;
+}
+
+static int cache_mngt_get_cleaner_workers(ocf_cache_t cache, uint32_t *workers)
+{
+	struct cache_priv *cache_priv;
+	int result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	cache_priv = ocf_cache_get_priv(cache);
+	*workers = cache_priv->cleaner.workers;
+
+	ocf_mngt_cache_read_unlock(cache);
+	return result;
+}
+
+/**
+ * @brief Set dirty ratio below which cleaning is deferred while most writes
+ * rewrite recently written cache lines
+ * @param[in] cache cache to which the change pertains
+ * @param[in] percent dirty ratio in percent, 0 - cleaning is never deferred
+ * @return exit code of successful completion is 0;
+ * nonzero exit code means failure
+ */
+static int cache_mngt_set_cleaner_rewrite_defer(ocf_cache_t cache,
+		uint32_t percent)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	struct cas_rewrite *rw = NULL, *old;
+	int result;
+
+	if (percent > 100)
+		return -OCF_ERR_INVAL;
+
+	result = _cache_mngt_lock_sync(cache);
+	if (result)
+		return result;
+
+	old = rcu_access_pointer(cache_priv->cleaner.rewrite);
+	if (percent && !old) {
+		rw = cas_rewrite_create(ocf_cache_get_line_size(cache) >>
+				SECTOR_SHIFT);
+		if (!rw) {
+			result = -OCF_ERR_NO_MEM;
+			goto out;
+		}
+		rcu_assign_pointer(cache_priv->cleaner.rewrite, rw);
+		rw = NULL;
+	} else if (!percent && old) {
+		RCU_INIT_POINTER(cache_priv->cleaner.rewrite, NULL);
+		/* Freed after unlocking, once nobody uses it */
+		rw = old;
+	}
+
+	WRITE_ONCE(cache_priv->cleaner.rewrite_defer, percent);
+
+out:
+	ocf_mngt_cache_unlock(cache);
+	if (rw) {
+		synchronize_rcu();
+		cas_rewrite_destroy(rw);
+	}
+	return result;
+}
+
+static int cache_mngt_get_cleaner_rewrite_defer(ocf_cache_t cache,
+		uint32_t *percent)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	int result = _cache_mngt_read_lock_sync(cache);
+
+	if (result)
+		return result;
+
+	*percent = cache_priv->cleaner.rewrite_defer;
 
 	ocf_mngt_cache_read_unlock(cache);
 	return result;
@@ -1041,2725 +1677,7577 @@ int cache_mngt_get_cleaning_param(ocf_cache_t cache, ocf_cleaning_t type,
 	return result;
 }
 
-int cache_mngt_set_promotion_policy(ocf_cache_t cache, uint32_t type)
+/* Period of adaptive nhit insertion threshold updates */
+#define CAS_NHIT_ADAPT_INTERVAL (10 * HZ)
+
+/* Free space [0.01%] above which filtering only delays warming cache up */
+#define CAS_NHIT_ADAPT_FREE 500
+
+/* Cache writes per interval [0.01% of cache] considered high churn */
+#define CAS_NHIT_ADAPT_CHURN_HIGH 100
+
+/* Cache writes per interval [0.01% of cache] considered stable cache */
+#define CAS_NHIT_ADAPT_CHURN_LOW 10
+
+/* Hit ratio gain [0.01%] below which hit ratio is considered flat */
+#define CAS_NHIT_ADAPT_FLAT 100
+
+/* Counters are reset along with statistics of cache */
+static inline uint64_t _cache_mngt_nhit_adapt_delta(uint64_t *last,
+		uint64_t value)
 {
-	int result;
+	uint64_t delta = value >= *last ? value - *last : value;
 
-	result = _cache_mngt_lock_sync(cache);
-	if (result) {
-		return result;
+	*last = value;
+	return delta;
+}
+
+/*
+ * Insertion threshold is raised once cache is full, a lot of it is rewritten
+ * every interval (i.e. inserts evict lines) and hit ratio doesn't improve.
+ * It is lowered when cache has free space or is barely rewritten.
+ */
+static void _cache_mngt_nhit_adapt_update(ocf_cache_t cache)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	struct ocf_stats_usage usage;
+	struct ocf_stats_requests req;
+	struct ocf_stats_blocks blocks;
+	struct ocf_stats_errors errors;
+	uint64_t hits, misses, writes, size;
+	uint32_t policy, threshold, step, hit_ratio, free, churn;
+	bool flat;
+
+	if (!ocf_cache_is_device_attached(cache))
+		return;
+
+	if (ocf_mngt_cache_promotion_get_policy(cache, &policy) ||
+			policy != ocf_promotion_nhit) {
+		return;
 	}
 
-	result = ocf_mngt_cache_promotion_set_policy(cache, type);
-	if (result)
-		goto out;
+	if (ocf_stats_collect_cache(cache, &usage, &req, &blocks, &errors))
+		return;
 
-	result = _cache_mngt_save_sync(cache);
+	if (ocf_mngt_cache_promotion_get_param(cache, ocf_promotion_nhit,
+			ocf_nhit_insertion_threshold, &threshold)) {
+		return;
+	}
 
-out:
-	ocf_mngt_cache_unlock(cache);
-	return result;
+	hits = _cache_mngt_nhit_adapt_delta(&cache_priv->nhit_adapt.hits,
+			req.rd_hits.value + req.wr_hits.value);
+	misses = _cache_mngt_nhit_adapt_delta(&cache_priv->nhit_adapt.misses,
+			req.rd_partial_misses.value + req.rd_full_misses.value +
+			req.wr_partial_misses.value + req.wr_full_misses.value);
+	writes = _cache_mngt_nhit_adapt_delta(
+			&cache_priv->nhit_adapt.cache_writes,
+			blocks.cache_volume_wr.value);
+	size = usage.occupancy.value + usage.free.value;
+
+	if (!size || !(hits + misses))
+		return;
+
+	hit_ratio = div64_u64(hits * 10000, hits + misses);
+	free = div64_u64(usage.free.value * 10000, size);
+	churn = div64_u64(min_t(uint64_t, writes, size) * 10000, size);
+	flat = hit_ratio < cache_priv->nhit_adapt.hit_ratio +
+			CAS_NHIT_ADAPT_FLAT;
+	cache_priv->nhit_adapt.hit_ratio = hit_ratio;
+
+	/* First interval only sets baseline of statistics */
+	if (!cache_priv->nhit_adapt.primed) {
+		cache_priv->nhit_adapt.primed = true;
+		return;
+	}
+
+	step = max(threshold / 4, 1U);
+	if (free >= CAS_NHIT_ADAPT_FREE || churn < CAS_NHIT_ADAPT_CHURN_LOW) {
+		threshold = max_t(uint32_t, threshold - min(step, threshold),
+				OCF_NHIT_MIN_THRESHOLD);
+	} else if (churn >= CAS_NHIT_ADAPT_CHURN_HIGH && flat) {
+		threshold = min_t(uint32_t, threshold + step,
+				OCF_NHIT_MAX_THRESHOLD);
+	} else {
+		return;
+	}
+
+	ocf_mngt_cache_promotion_set_param(cache, ocf_promotion_nhit,
+			ocf_nhit_insertion_threshold, threshold);
 }
 
-int cache_mngt_get_promotion_policy(ocf_cache_t cache, uint32_t *type)
+static void _cache_mngt_nhit_adapt_work(struct work_struct *work)
 {
-	int result;
+	struct cache_priv *cache_priv = container_of(to_delayed_work(work),
+			struct cache_priv, nhit_adapt.work);
+	ocf_cache_t cache = cache_priv->cache;
 
-	result = _cache_mngt_read_lock_sync(cache);
-	if (result) {
-		return result;
+	/* Don't wait for management operation, possibly stopping cache */
+	if (ocf_mngt_cache_trylock(cache)) {
+		schedule_delayed_work(&cache_priv->nhit_adapt.work,
+				CAS_NHIT_ADAPT_INTERVAL);
+		return;
 	}
 
-	result = ocf_mngt_cache_promotion_get_policy(cache, type);
+	if (cache_priv->nhit_adapt.enabled) {
+		_cache_mngt_nhit_adapt_update(cache);
+		schedule_delayed_work(&cache_priv->nhit_adapt.work,
+				CAS_NHIT_ADAPT_INTERVAL);
+	}
 
-	ocf_mngt_cache_read_unlock(cache);
-	return result;
+	ocf_mngt_cache_unlock(cache);
 }
 
-int cache_mngt_set_promotion_param(ocf_cache_t cache, ocf_promotion_t type,
-		uint32_t param_id, uint32_t param_value)
+static void _cache_mngt_nhit_adapt_init(struct cache_priv *cache_priv)
 {
+	cache_priv->nhit_adapt.enabled = false;
+	INIT_DELAYED_WORK(&cache_priv->nhit_adapt.work,
+			_cache_mngt_nhit_adapt_work);
+}
+
+/* Called once cache is locked for stopping or has never been started */
+static void _cache_mngt_nhit_adapt_stop(struct cache_priv *cache_priv)
+{
+	cancel_delayed_work_sync(&cache_priv->nhit_adapt.work);
+}
+
+static int cache_mngt_set_nhit_adapt(ocf_cache_t cache, uint32_t enabled)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
 	int result;
 
+	if (enabled > 1)
+		return -OCF_ERR_INVAL;
+
 	result = _cache_mngt_lock_sync(cache);
-	if (result) {
+	if (result)
 		return result;
-	}
 
-	result = ocf_mngt_cache_promotion_set_param(cache, type, param_id,
-			param_value);
+	if (enabled && !cache_priv->nhit_adapt.enabled) {
+		cache_priv->nhit_adapt.primed = false;
+		schedule_delayed_work(&cache_priv->nhit_adapt.work,
+				CAS_NHIT_ADAPT_INTERVAL);
+	}
+	cache_priv->nhit_adapt.enabled = enabled;
 
 	ocf_mngt_cache_unlock(cache);
-	return result;
+	return 0;
 }
 
-int cache_mngt_get_promotion_param(ocf_cache_t cache, ocf_promotion_t type,
-		uint32_t param_id, uint32_t *param_value)
+static int cache_mngt_get_nhit_adapt(ocf_cache_t cache, uint32_t *enabled)
 {
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
 	int result;
 
 	result = _cache_mngt_read_lock_sync(cache);
-	if (result) {
+	if (result)
 		return result;
-	}
 
-	result = ocf_mngt_cache_promotion_get_param(cache, type, param_id,
-			param_value);
+	*enabled = cache_priv->nhit_adapt.enabled;
 
 	ocf_mngt_cache_read_unlock(cache);
-	return result;
+	return 0;
 }
 
-struct get_paths_ctx {
-	char *core_path_name_tab;
-	int max_count;
-	int position;
-};
+/* Period of sequential write absorb state updates */
+#define CAS_SEQ_ABSORB_INTERVAL HZ
 
-static int _cache_mngt_core_pool_get_paths_visitor(ocf_uuid_t uuid, void *ctx)
+/* Margin [%] above thresholds needed to start absorbing again */
+#define CAS_SEQ_ABSORB_HYSTERESIS 2
+
+static int _cache_mngt_seq_absorb_core(ocf_core_t core, void *cntx)
 {
-	struct get_paths_ctx *visitor_ctx = ctx;
+	struct cache_priv *cache_priv = cntx;
+	ocf_core_id_t core_id = ocf_core_get_id(core);
+	ocf_seq_cutoff_policy policy;
 
-	if (visitor_ctx->position >= visitor_ctx->max_count)
+	if (ocf_mngt_core_get_seq_cutoff_policy(core, &policy) ||
+			policy == ocf_seq_cutoff_policy_never) {
 		return 0;
-
-	if (copy_to_user((void __user *)visitor_ctx->core_path_name_tab +
-			(visitor_ctx->position * MAX_STR_LEN),
-			uuid->data, uuid->size)) {
-		return -ENODATA;
 	}
 
-	visitor_ctx->position++;
+	/* Policy set while absorbing is picked up here as well */
+	cache_priv->seq_absorb.policy[core_id] = policy;
+	set_bit(core_id, cache_priv->seq_absorb.saved);
+	ocf_mngt_core_set_seq_cutoff_policy(core,
+			ocf_seq_cutoff_policy_never);
 
 	return 0;
 }
 
-int cache_mngt_core_pool_get_paths(struct kcas_core_pool_path *cmd_info)
+static int _cache_mngt_seq_absorb_restore_core(ocf_core_t core, void *cntx)
 {
-	struct get_paths_ctx visitor_ctx = {0};
-	int result;
-
-	if (cmd_info->core_path_tab == NULL)
-		return -EINVAL;
+	struct cache_priv *cache_priv = cntx;
+	ocf_core_id_t core_id = ocf_core_get_id(core);
 
-	visitor_ctx.core_path_name_tab = cmd_info->core_path_tab;
-	visitor_ctx.max_count = cmd_info->core_pool_count;
-
-	result = ocf_mngt_core_pool_visit(cas_ctx,
-			_cache_mngt_core_pool_get_paths_visitor,
-			&visitor_ctx);
+	if (test_and_clear_bit(core_id, cache_priv->seq_absorb.saved)) {
+		ocf_mngt_core_set_seq_cutoff_policy(core,
+				cache_priv->seq_absorb.policy[core_id]);
+	}
 
-	cmd_info->core_pool_count = visitor_ctx.position;
-	return result;
+	return 0;
 }
 
-int cache_mngt_core_pool_remove(struct kcas_core_pool_remove *cmd_info)
+/*
+ * Called under management lock before core is detached or removed. Detached
+ * core keeps its configured policy in metadata and core added later under
+ * the same id is not given policy of the removed one.
+ */
+static void _cache_mngt_seq_absorb_drop_core(ocf_cache_t cache,
+		ocf_core_t core)
 {
-	struct ocf_volume_uuid uuid = {};
-	ocf_volume_t vol;
+	_cache_mngt_seq_absorb_restore_core(core, ocf_cache_get_priv(cache));
+}
 
-	uuid.data = cmd_info->core_path_name;
-	uuid.size = strnlen(cmd_info->core_path_name, MAX_STR_LEN) + 1;
+/* Called under management lock */
+static void _cache_mngt_seq_absorb_leave(ocf_cache_t cache)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
 
-	vol = ocf_mngt_core_pool_lookup(cas_ctx, &uuid,
-			ocf_ctx_get_volume_type(cas_ctx,
-					BLOCK_DEVICE_VOLUME));
-	if (!vol)
-		return -OCF_ERR_CORE_NOT_AVAIL;
+	if (!cache_priv->seq_absorb.active)
+		return;
 
-	ocf_volume_close(vol);
-	ocf_mngt_core_pool_remove(cas_ctx, vol);
+	ocf_core_visit(cache, _cache_mngt_seq_absorb_restore_core,
+			cache_priv, false);
+	bitmap_zero(cache_priv->seq_absorb.saved, OCF_CORE_MAX);
 
-	return 0;
+	cache_priv->seq_absorb.total_ms += jiffies_to_msecs(
+			jiffies - cache_priv->seq_absorb.since);
+	cache_priv->seq_absorb.active = false;
 }
 
-struct cache_mngt_metadata_probe_context {
-	struct completion cmpl;
-	struct kcas_cache_check_device *cmd_info;
-	int *result;
-};
-
-static void cache_mngt_metadata_probe_end(void *priv, int error,
-		struct ocf_metadata_probe_status *status)
+/*
+ * Sequential cutoff of cores is turned off while cache in lazy write mode
+ * has free space and clean space above thresholds, so sequential writes are
+ * absorbed in cache and written back by cleaner later. Once either falls
+ * below its threshold configured policies are restored.
+ */
+static void _cache_mngt_seq_absorb_update(ocf_cache_t cache)
 {
-	struct cache_mngt_metadata_probe_context *context = priv;
-	struct kcas_cache_check_device *cmd_info = context->cmd_info;
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	struct ocf_stats_usage usage;
+	struct ocf_stats_requests req;
+	struct ocf_stats_blocks blocks;
+	struct ocf_stats_errors errors;
+	uint32_t free, headroom, margin;
+	uint64_t size;
+	bool absorb;
+
+	if (!ocf_cache_is_device_attached(cache) ||
+			!ocf_mngt_cache_mode_has_lazy_write(
+				ocf_cache_get_mode(cache)) ||
+			ocf_stats_collect_cache(cache, &usage, &req, &blocks,
+				&errors)) {
+		_cache_mngt_seq_absorb_leave(cache);
+		return;
+	}
 
-	*context->result = error;
+	size = usage.occupancy.value + usage.free.value;
+	if (!size)
+		return;
 
-	if (error == -OCF_ERR_NO_METADATA) {
-		cmd_info->is_cache_device = false;
-		cmd_info->metadata_compatible = false;
-		*context->result = 0;
-	} else if (error == -OCF_ERR_METADATA_VER || error == 0) {
-		cmd_info->is_cache_device = true;
-		cmd_info->metadata_compatible = !error;
-		cmd_info->clean_shutdown = status->clean_shutdown;
-		cmd_info->cache_dirty = status->cache_dirty;
-		*context->result = 0;
+	free = div64_u64(usage.free.value * 100, size);
+	headroom = div64_u64((size - min(usage.dirty.value, size)) * 100,
+			size);
+	margin = cache_priv->seq_absorb.active ? 0 : CAS_SEQ_ABSORB_HYSTERESIS;
+	absorb = free >= cache_priv->seq_absorb.free + margin &&
+			headroom >= cache_priv->seq_absorb.headroom + margin;
+
+	if (!absorb) {
+		_cache_mngt_seq_absorb_leave(cache);
+		return;
 	}
 
-	complete(&context->cmpl);
+	if (!cache_priv->seq_absorb.active) {
+		cache_priv->seq_absorb.active = true;
+		cache_priv->seq_absorb.since = jiffies;
+	}
+
+	/* Cores added while absorbing join it */
+	ocf_core_visit(cache, _cache_mngt_seq_absorb_core, cache_priv, true);
 }
 
-static int cas_create_volume_by_path(ocf_volume_t *vol, ocf_volume_form_t form, char *path)
+static void _cache_mngt_seq_absorb_work(struct work_struct *work)
 {
-	int path_length = strnlen(path, MAX_STR_LEN);
-	struct ocf_volume_uuid uuid = {};
-	uint8_t volume_type_id;
-	int ret;
+	struct cache_priv *cache_priv = container_of(to_delayed_work(work),
+			struct cache_priv, seq_absorb.work);
+	ocf_cache_t cache = cache_priv->cache;
 
-	if (path_length == MAX_STR_LEN || path_length == 0)
-		return -OCF_ERR_INVAL;
+	/* Don't wait for management operation, possibly stopping cache */
+	if (ocf_mngt_cache_trylock(cache)) {
+		schedule_delayed_work(&cache_priv->seq_absorb.work,
+				CAS_SEQ_ABSORB_INTERVAL);
+		return;
+	}
 
-	ret = cas_blk_identify_type(path, &volume_type_id);
-	if (ret)
-		return ret;
+	if (cache_priv->seq_absorb.free) {
+		_cache_mngt_seq_absorb_update(cache);
+		schedule_delayed_work(&cache_priv->seq_absorb.work,
+				CAS_SEQ_ABSORB_INTERVAL);
+	}
 
-	uuid.copy = true;
-	uuid.data = env_strdup(path, MAX_STR_LEN);
-	uuid.size = path_length + 1;
+	ocf_mngt_cache_unlock(cache);
+}
 
-	ret = ocf_ctx_volume_create(cas_ctx, vol, form, &uuid, volume_type_id);
-	if (ret)
-		return ret;
+static void _cache_mngt_seq_absorb_init(struct cache_priv *cache_priv)
+{
+	cache_priv->seq_absorb.free = 0;
+	cache_priv->seq_absorb.headroom = KCAS_SEQ_ABSORB_HEADROOM_DEFAULT;
+	cache_priv->seq_absorb.active = false;
+	bitmap_zero(cache_priv->seq_absorb.saved, OCF_CORE_MAX);
+	INIT_DELAYED_WORK(&cache_priv->seq_absorb.work,
+			_cache_mngt_seq_absorb_work);
+}
 
-	return ret;
+/*
+ * Called once cache is locked for stopping or has never been started,
+ * configured policies are restored before they are stored in metadata
+ */
+static void _cache_mngt_seq_absorb_stop(ocf_cache_t cache)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+
+	cancel_delayed_work_sync(&cache_priv->seq_absorb.work);
+	_cache_mngt_seq_absorb_leave(cache);
 }
 
-int cache_mngt_cache_check_device(struct kcas_cache_check_device *cmd_info)
+static int cache_mngt_set_seq_absorb(ocf_cache_t cache,
+		enum kcas_cache_param_id param_id, uint32_t value)
 {
-	struct cache_mngt_metadata_probe_context context;
-	cas_bdev_handle_t bdev_handle;
-	struct block_device *bdev;
-	ocf_volume_t volume;
-	char holder[] = "CAS CHECK CACHE DEVICE\n";
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
 	int result;
 
-	bdev_handle = cas_bdev_open_by_path(cmd_info->path_name,
-			(CAS_BLK_MODE_EXCL | CAS_BLK_MODE_READ), holder);
-	if (IS_ERR(bdev_handle)) {
-		return (PTR_ERR(bdev_handle) == -EBUSY) ?
-				-OCF_ERR_NOT_OPEN_EXC :
-				-OCF_ERR_INVAL_VOLUME_TYPE;
-	}
-	bdev = cas_bdev_get_from_handle(bdev_handle);
+	if (value > 100)
+		return -OCF_ERR_INVAL;
 
-	result = cas_blk_open_volume_by_bdev(&volume, bdev);
+	result = _cache_mngt_lock_sync(cache);
 	if (result)
-		goto out_bdev;
-
-	init_completion(&context.cmpl);
-	context.cmd_info = cmd_info;
-	context.result = &result;
+		return result;
 
-	ocf_metadata_probe(cas_ctx, volume, cache_mngt_metadata_probe_end,
-			&context);
-	wait_for_completion(&context.cmpl);
+	if (param_id == cache_param_seq_absorb_headroom) {
+		cache_priv->seq_absorb.headroom = value;
+	} else {
+		if (value && !cache_priv->seq_absorb.free) {
+			schedule_delayed_work(&cache_priv->seq_absorb.work,
+					CAS_SEQ_ABSORB_INTERVAL);
+		} else if (!value) {
+			_cache_mngt_seq_absorb_leave(cache);
+		}
+		cache_priv->seq_absorb.free = value;
+	}
 
-	cas_blk_close_volume(volume);
-out_bdev:
-	cas_bdev_release(bdev_handle,
-			(CAS_BLK_MODE_EXCL | CAS_BLK_MODE_READ), holder);
-	return result;
+	ocf_mngt_cache_unlock(cache);
+	return 0;
 }
 
-int cache_mngt_prepare_core_cfg(struct ocf_mngt_core_config *cfg,
-		struct kcas_insert_core *cmd_info)
+static int cache_mngt_get_seq_absorb(ocf_cache_t cache,
+		enum kcas_cache_param_id param_id, uint32_t *value)
 {
-	char core_name[OCF_CORE_NAME_SIZE] = {};
-	ocf_cache_t cache = NULL;
-	uint16_t core_id;
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
 	int result;
 
-	if (strnlen(cmd_info->core_path_name, MAX_STR_LEN) >= MAX_STR_LEN)
-		return -OCF_ERR_INVAL;
-	
-	if (cmd_info->try_add && cmd_info->core_id == OCF_CORE_MAX)
-		return -OCF_ERR_INVAL;
-	
-	result = mngt_get_cache_by_id(cas_ctx, cmd_info->cache_id, &cache);
-	if (result && result != -OCF_ERR_CACHE_NOT_EXIST) {
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
 		return result;
-	} else if (!result && ocf_cache_is_standby(cache)) {
-		ocf_mngt_cache_put(cache);
-		return -OCF_ERR_CACHE_STANDBY;
-	}
-
-	if (cmd_info->core_id == OCF_CORE_MAX) {
-		struct cache_priv *cache_priv;
-
-		if (!cache)
-			return -OCF_ERR_CACHE_NOT_EXIST;
-
-		cache_priv = ocf_cache_get_priv(cache);
-		core_id = find_free_core_id(cache_priv->core_id_bitmap);
-		if (core_id == OCF_CORE_MAX)
-			return -OCF_ERR_INVAL;
-
-		cmd_info->core_id = core_id;
-	}
 
-	if (cache) {
-		ocf_mngt_cache_put(cache);
-		cache = NULL;
+	switch (param_id) {
+	case cache_param_seq_absorb_free:
+		*value = cache_priv->seq_absorb.free;
+		break;
+	case cache_param_seq_absorb_headroom:
+		*value = cache_priv->seq_absorb.headroom;
+		break;
+	default:
+		*value = cache_priv->seq_absorb.active;
+		break;
 	}
 
-	snprintf(core_name, sizeof(core_name), "core%d", cmd_info->core_id);
+	ocf_mngt_cache_read_unlock(cache);
+	return 0;
+}
 
-	memset(cfg, 0, sizeof(*cfg));
-	env_strncpy(cfg->name, OCF_CORE_NAME_SIZE, core_name, OCF_CORE_NAME_SIZE);
+static int _cache_mngt_add_bypass_class(ocf_cache_t cache);
 
-	cfg->uuid.data = cmd_info->core_path_name;
-	cfg->uuid.size = strnlen(cmd_info->core_path_name, MAX_STR_LEN) + 1;
-	cfg->try_add = cmd_info->try_add;
-	cfg->seq_cutoff_promote_on_threshold = true;
+/* Admission of tinylfu is done by CAS with OCF promoting always */
+static int _cache_mngt_tinylfu_create(ocf_cache_t cache,
+		struct cas_tinylfu **tlfu)
+{
+	struct ocf_cache_info info;
+	int result;
 
-	if (!cas_bdev_exist(cfg->uuid.data))
-		return -OCF_ERR_INVAL_VOLUME_TYPE;
+	result = ocf_cache_get_info(cache, &info);
+	if (result)
+		return result;
 
-	if (cmd_info->update_path)
-		return 0;
+	*tlfu = cas_tinylfu_create(info.size,
+			ocf_cache_get_line_size(cache) >> SECTOR_SHIFT);
+	if (!*tlfu)
+		return -OCF_ERR_NO_MEM;
 
-	result = cas_blk_identify_type(cfg->uuid.data, &cfg->volume_type);
-	if (OCF_ERR_NOT_OPEN_EXC == abs(result)) {
-		printk(KERN_WARNING OCF_PREFIX_SHORT
-			"Cannot open device %s exclusively. "
-		        "It is already opened by another program!\n",
-			cmd_info->core_path_name);
+	result = _cache_mngt_add_bypass_class(cache);
+	if (result) {
+		cas_tinylfu_destroy(*tlfu);
+		*tlfu = NULL;
 	}
 
 	return result;
 }
 
-static int cache_mngt_update_core_uuid(ocf_cache_t cache, const char *core_name,
-				size_t name_len, ocf_uuid_t uuid_ptr)
+int cache_mngt_set_promotion_policy(ocf_cache_t cache, uint32_t type)
 {
-	ocf_core_t core;
-	ocf_volume_t vol;
-	struct bd_object *bdvol;
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	struct cas_tinylfu *tlfu = NULL, *old;
+	bool tinylfu = (type == KCAS_PROMOTION_TINYLFU);
 	int result;
-	struct ocf_volume_uuid uuid = {};
 
-	if (ocf_core_get_by_name(cache, core_name, name_len, &core)) {
-		/* no such core */
-		return -ENODEV;
+	result = _cache_mngt_lock_sync(cache);
+	if (result) {
+		return result;
 	}
 
-	if (ocf_core_get_state(core) != ocf_core_state_active) {
-		/* core inactive */
-		return -ENODEV;
+	old = rcu_access_pointer(cache_priv->tinylfu);
+	if (tinylfu && !old) {
+		result = _cache_mngt_tinylfu_create(cache, &tlfu);
+		if (result)
+			goto out;
 	}
 
-	/* get bottom device volume for this core */
-	vol = ocf_core_get_volume(core);
-	bdvol = bd_object(vol);
+	result = ocf_mngt_cache_promotion_set_policy(cache,
+			tinylfu ? ocf_promotion_always : type);
+	if (result)
+		goto out;
 
-	if (!cas_bdev_match(uuid_ptr->data, bdvol->btm_bd)) {
-		printk(KERN_ERR "UUID provided does not match target core device\n");
-		return -ENODEV;
+	result = _cache_mngt_save_sync(cache);
+	if (result)
+		goto out;
+
+	if (tlfu) {
+		rcu_assign_pointer(cache_priv->tinylfu, tlfu);
+		tlfu = NULL;
+	} else if (!tinylfu && old) {
+		RCU_INIT_POINTER(cache_priv->tinylfu, NULL);
+		/* Freed after unlocking, once no request uses it */
+		tlfu = old;
 	}
 
-	uuid.copy = true;
-	uuid.data = env_strdup(uuid_ptr->data, MAX_STR_LEN);
-	uuid.size = strnlen(uuid_ptr->data, MAX_STR_LEN) + 1;
+out:
+	ocf_mngt_cache_unlock(cache);
+	if (tlfu) {
+		synchronize_rcu();
+		cas_tinylfu_destroy(tlfu);
+	}
+	return result;
+}
 
-	result = ocf_mngt_core_set_uuid(core, &uuid);
+int cache_mngt_get_promotion_policy(ocf_cache_t cache, uint32_t *type)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	int result;
+
+	result = _cache_mngt_read_lock_sync(cache);
 	if (result) {
-		env_free(uuid.data);
 		return result;
 	}
 
-	if (ocf_cache_is_device_attached(cache))
-		result = _cache_mngt_save_sync(cache);
+	if (rcu_access_pointer(cache_priv->tinylfu))
+		*type = KCAS_PROMOTION_TINYLFU;
+	else
+		result = ocf_mngt_cache_promotion_get_policy(cache, type);
 
+	ocf_mngt_cache_read_unlock(cache);
 	return result;
 }
 
-static void _cache_mngt_log_core_device_path(ocf_core_t core)
+int cache_mngt_set_promotion_param(ocf_cache_t cache, ocf_promotion_t type,
+		uint32_t param_id, uint32_t param_value)
 {
-	ocf_cache_t cache = ocf_core_get_cache(core);
-	const ocf_uuid_t core_uuid = (const ocf_uuid_t)ocf_core_get_uuid(core);
+	int result;
 
-	printk(KERN_INFO OCF_PREFIX_SHORT "Adding device %s as core %s "
-			"to cache %s\n", (const char*)core_uuid->data,
-			ocf_core_get_name(core), ocf_cache_get_name(cache));
+	result = _cache_mngt_lock_sync(cache);
+	if (result) {
+		return result;
+	}
+
+	result = ocf_mngt_cache_promotion_set_param(cache, type, param_id,
+			param_value);
+
+	ocf_mngt_cache_unlock(cache);
+	return result;
 }
 
-static int _cache_mngt_core_device_loaded_visitor(ocf_core_t core, void *cntx)
+int cache_mngt_get_promotion_param(ocf_cache_t cache, ocf_promotion_t type,
+		uint32_t param_id, uint32_t *param_value)
 {
-	uint16_t core_id = OCF_CORE_ID_INVALID;
-	ocf_cache_t cache = ocf_core_get_cache(core);
-
-	_cache_mngt_log_core_device_path(core);
+	int result;
 
-	core_id_from_name(&core_id, ocf_core_get_name(core));
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result) {
+		return result;
+	}
 
-	mark_core_id_used(cache, core_id);
+	result = ocf_mngt_cache_promotion_get_param(cache, type, param_id,
+			param_value);
 
-	return 0;
+	ocf_mngt_cache_read_unlock(cache);
+	return result;
 }
 
-struct _cache_mngt_add_core_context {
-	struct completion cmpl;
-	ocf_core_t *core;
-	int *result;
+struct get_paths_ctx {
+	char *core_path_name_tab;
+	int max_count;
+	int position;
 };
 
-/************************************************************
- * Function for adding a CORE object to the cache instance. *
- ************************************************************/
-
-static void _cache_mngt_add_core_complete(ocf_cache_t cache,
-		ocf_core_t core, void *priv, int error)
+static int _cache_mngt_core_pool_get_paths_visitor(ocf_uuid_t uuid, void *ctx)
 {
-	struct _cache_mngt_add_core_context *context = priv;
+	struct get_paths_ctx *visitor_ctx = ctx;
 
-	*context->core = core;
-	*context->result = error;
-	complete(&context->cmpl);
-}
+	if (visitor_ctx->position >= visitor_ctx->max_count)
+		return 0;
 
-static void _cache_mngt_generic_complete(void *priv, int error);
+	if (copy_to_user((void __user *)visitor_ctx->core_path_name_tab +
+			(visitor_ctx->position * MAX_STR_LEN),
+			uuid->data, uuid->size)) {
+		return -ENODATA;
+	}
 
-int cache_mngt_add_core_to_cache(const char *cache_name, size_t name_len,
-		struct ocf_mngt_core_config *cfg,
-		struct kcas_insert_core *cmd_info)
+	visitor_ctx->position++;
+
+	return 0;
+}
+
+int cache_mngt_core_pool_get_paths(struct kcas_core_pool_path *cmd_info)
 {
-	struct _cache_mngt_add_core_context add_context;
-	struct _cache_mngt_sync_context remove_context;
-	ocf_cache_t cache;
-	ocf_core_t core;
-	ocf_core_id_t core_id;
-	int result, remove_core_result;
-	struct ocf_volume_uuid uuid = {};
-	struct cache_priv *cache_priv = NULL;
+	struct get_paths_ctx visitor_ctx = {0};
+	int result;
 
-	result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name,
-					name_len, &cache);
-	if (cfg->try_add && (result == -OCF_ERR_CACHE_NOT_EXIST)) {
-		uuid.copy = true;
-		uuid.data = env_strdup(cfg->uuid.data, MAX_STR_LEN);
-		uuid.size = strnlen(cfg->uuid.data, MAX_STR_LEN) + 1;
+	if (cmd_info->core_path_tab == NULL)
+		return -EINVAL;
 
-		result = ocf_mngt_core_pool_add(cas_ctx, &uuid,
-				cfg->volume_type);
-		if (result) {
-			env_free(uuid.data);
-			cmd_info->ext_err_code =
-					-OCF_ERR_CANNOT_ADD_CORE_TO_POOL;
-			printk(KERN_ERR OCF_PREFIX_SHORT
-					"Error occurred during"
-					" adding core to detached core pool\n");
-		} else {
-			printk(KERN_INFO OCF_PREFIX_SHORT
-					"Successfully added"
-					" core to core pool\n");
-		}
-		return result;
-	} else if (result) {
-		return result;
-	}
+	visitor_ctx.core_path_name_tab = cmd_info->core_path_tab;
+	visitor_ctx.max_count = cmd_info->core_pool_count;
 
-	result = _cache_mngt_lock_sync(cache);
-	if (result) {
-		ocf_mngt_cache_put(cache);
-		return result;
-	}
+	result = ocf_mngt_core_pool_visit(cas_ctx,
+			_cache_mngt_core_pool_get_paths_visitor,
+			&visitor_ctx);
 
-	if (cmd_info && cmd_info->update_path) {
-		result = cache_mngt_update_core_uuid(cache, cfg->name,
-						OCF_CORE_NAME_SIZE, &cfg->uuid);
-		ocf_mngt_cache_unlock(cache);
-		ocf_mngt_cache_put(cache);
-		return result;
-	}
+	cmd_info->core_pool_count = visitor_ctx.position;
+	return result;
+}
 
-	result = core_id_from_name(&core_id, cfg->name);
-	if (result)
-		goto error_affter_lock;
-	if (cmd_info->fs_meta_dict.length && cmd_info->fs_meta_dict.data) {
-		cache_priv = ocf_cache_get_priv(cache);
-		if (cache_priv->fs_meta_dict[core_id].length == 0) {
-			cache_priv->fs_meta_dict[core_id].data = vmalloc(cmd_info->fs_meta_dict.length);
-			memcpy(cache_priv->fs_meta_dict[core_id].data, cmd_info->fs_meta_dict.data, cmd_info->fs_meta_dict.length);
-			cache_priv->fs_meta_dict[core_id].length = cmd_info->fs_meta_dict.length;
-		}
-	}
+/*
+ * Index of core pool by path and device number. OCF keeps the pool as a list
+ * it walks for each lookup, so pooled device is found here first, also when
+ * given by another path than it was added with. Entry is only a hint: it is
+ * dropped once OCF attaches its device to loaded cache, or found missing
+ * from the pool.
+ */
+#define CAS_CORE_POOL_HASH_BITS 10
 
-	cfg->seq_cutoff_threshold = seq_cut_off_mb * MiB;
-	cfg->seq_cutoff_promotion_count = 8;
+struct cas_core_pool_entry {
+	struct hlist_node path_node;
+	struct hlist_node dev_node;
+	dev_t dev;
+	char *path;
+};
 
-	/* Due to linux thread scheduling nature, we prefer to promote streams
-	 * as early as we reasonably can. One way to achieve that is to set
-	 * promotion count really low, which unfortunately significantly increases
-	 * number of accesses to shared structures. The other way is to promote
-	 * streams which reach cutoff threshold, as we can reasonably assume that
-	 * they are likely be continued after thread is rescheduled to another CPU.
-	 */
-	cfg->seq_cutoff_promote_on_threshold = true;
+static DEFINE_HASHTABLE(cas_core_pool_paths, CAS_CORE_POOL_HASH_BITS);
+static DEFINE_HASHTABLE(cas_core_pool_devs, CAS_CORE_POOL_HASH_BITS);
+static DEFINE_MUTEX(cas_core_pool_lock);
 
-	init_completion(&add_context.cmpl);
-	add_context.core = &core;
-	add_context.result = &result;
+static inline u32 _cache_mngt_core_pool_hash(const char *path)
+{
+	return jhash(path, strnlen(path, MAX_STR_LEN), 0);
+}
 
-	ocf_mngt_cache_add_core(cache, cfg, _cache_mngt_add_core_complete,
-			&add_context);
-	wait_for_completion(&add_context.cmpl);
-#if 0
-	if (result == -OCF_ERR_CORE_UUID_EXISTS) {
-		cmd_info->core_id = ocf_core_get_id(core);
+/* Entry of device given by path, or by number if not 0. Called under lock. */
+static struct cas_core_pool_entry *_cache_mngt_core_pool_find(
+		const char *path, dev_t dev)
+{
+	struct cas_core_pool_entry *entry;
+
+	hash_for_each_possible(cas_core_pool_paths, entry, path_node,
+			_cache_mngt_core_pool_hash(path)) {
+		if (!strncmp(entry->path, path, MAX_STR_LEN))
+			return entry;
 	}
-#endif
-	if (result)
-		goto error_affter_lock;
 
-	result = kcas_core_create_exported_object(core);
-	if (result)
-		goto error_after_add_core;
+	if (!dev)
+		return NULL;
 
-	result = core_id_from_name(&core_id, cfg->name);
-	if (result)
-		goto error_after_create_exported_object;
+	hash_for_each_possible(cas_core_pool_devs, entry, dev_node, dev) {
+		if (entry->dev == dev)
+			return entry;
+	}
 
-	mark_core_id_used(cache, core_id);
+	return NULL;
+}
 
-	ocf_mngt_cache_unlock(cache);
-	ocf_mngt_cache_put(cache);
+static void _cache_mngt_core_pool_drop(struct cas_core_pool_entry *entry)
+{
+	hash_del(&entry->path_node);
+	hash_del(&entry->dev_node);
+	kfree(entry->path);
+	kfree(entry);
+}
 
-	_cache_mngt_log_core_device_path(core);
+/* Lookups fall back to OCF pool if device cannot be indexed */
+static void _cache_mngt_core_pool_index_add(const char *path)
+{
+	struct cas_core_pool_entry *entry;
 
-	return 0;
+	entry = kzalloc(sizeof(*entry), GFP_KERNEL);
+	if (!entry)
+		return;
 
-error_after_create_exported_object:
-	kcas_core_destroy_exported_object(core);
+	entry->path = kstrdup(path, GFP_KERNEL);
+	if (!entry->path) {
+		kfree(entry);
+		return;
+	}
 
-error_after_add_core:
-	init_completion(&remove_context.cmpl);
-	remove_context.result = &remove_core_result;
-	ocf_mngt_cache_remove_core(core, _cache_mngt_generic_complete,
-			&remove_context);
-	wait_for_completion(&remove_context.cmpl);
+	if (cas_bdev_lookup_dev(cas_blk_device_path(path), &entry->dev))
+		entry->dev = 0;
 
-error_affter_lock:
-	ocf_mngt_cache_unlock(cache);
-	ocf_mngt_cache_put(cache);
+	mutex_lock(&cas_core_pool_lock);
+	hash_add(cas_core_pool_paths, &entry->path_node,
+			_cache_mngt_core_pool_hash(path));
+	INIT_HLIST_NODE(&entry->dev_node);
+	if (entry->dev)
+		hash_add(cas_core_pool_devs, &entry->dev_node, entry->dev);
+	mutex_unlock(&cas_core_pool_lock);
+}
 
-	return result;
+static void _cache_mngt_core_pool_index_remove(const char *path)
+{
+	struct cas_core_pool_entry *entry;
+
+	mutex_lock(&cas_core_pool_lock);
+	entry = _cache_mngt_core_pool_find(path, 0);
+	if (entry)
+		_cache_mngt_core_pool_drop(entry);
+	mutex_unlock(&cas_core_pool_lock);
 }
 
-static int _cache_mngt_remove_core_flush(ocf_cache_t cache,
-		struct kcas_remove_core *cmd)
+void cache_mngt_core_pool_index_deinit(void)
 {
-	int result = 0;
-	ocf_core_t core;
-	bool core_active;
+	struct cas_core_pool_entry *entry;
+	struct hlist_node *tmp;
+	int bkt;
 
-	if (cmd->force_no_flush)
-		return 0;
+	mutex_lock(&cas_core_pool_lock);
+	hash_for_each_safe(cas_core_pool_paths, bkt, tmp, entry, path_node)
+		_cache_mngt_core_pool_drop(entry);
+	mutex_unlock(&cas_core_pool_lock);
+}
 
-	/* Getting cache for the second time is workaround to make flush error
-	   handling easier and avoid dealing with synchronizing issues */
-	result = ocf_mngt_cache_get(cache);
-	if (result)
-		return result;
+int cache_mngt_core_pool_remove(struct kcas_core_pool_remove *cmd_info)
+{
+	struct cas_core_pool_entry *entry;
+	struct ocf_volume_uuid uuid = {};
+	uint8_t volume_type_id;
+	ocf_volume_t vol;
+	dev_t dev;
 
-	result = _cache_mngt_read_lock_sync(cache);
-	if (result)
-		goto put;
+	if (cas_bdev_lookup_dev(cas_blk_device_path(cmd_info->core_path_name),
+				&dev)) {
+		dev = 0;
+	}
 
-	result = get_core_by_id(cache, cmd->core_id, &core);
-	if (result < 0)
-		goto unlock;
+	mutex_lock(&cas_core_pool_lock);
 
-	core_active = (ocf_core_get_state(core) == ocf_core_state_active);
+	/* OCF pool knows device by path it has been added with */
+	entry = _cache_mngt_core_pool_find(cmd_info->core_path_name, dev);
+	uuid.data = entry ? entry->path : cmd_info->core_path_name;
+	uuid.size = strnlen(uuid.data, MAX_STR_LEN) + 1;
+	volume_type_id = cas_blk_path_prefix_type(uuid.data) ?:
+			BLOCK_DEVICE_VOLUME;
 
-	if (!core_active) {
-		result = -OCF_ERR_CORE_IN_INACTIVE_STATE;
-		goto unlock;
-	}
+	vol = ocf_mngt_core_pool_lookup(cas_ctx, &uuid,
+			ocf_ctx_get_volume_type(cas_ctx, volume_type_id));
+	if (entry)
+		_cache_mngt_core_pool_drop(entry);
 
-	if (!ocf_mngt_core_is_dirty(core)) {
-		result = 0;
-		goto unlock;
-	}
+	mutex_unlock(&cas_core_pool_lock);
 
-	return _cache_mngt_core_flush_sync(core, true,
-				_cache_read_unlock_put_cmpl);
+	if (!vol)
+		return -OCF_ERR_CORE_NOT_AVAIL;
 
-unlock:
-	ocf_mngt_cache_read_unlock(cache);
-put:
-	ocf_mngt_cache_put(cache);
-	return result;
+	ocf_volume_close(vol);
+	ocf_mngt_core_pool_remove(cas_ctx, vol);
+
+	return 0;
 }
 
-static void _cache_mngt_generic_complete(void *priv, int error)
+struct cache_mngt_metadata_probe_context {
+	struct completion cmpl;
+	struct kcas_cache_check_device *cmd_info;
+	int *result;
+};
+
+static void cache_mngt_metadata_probe_end(void *priv, int error,
+		struct ocf_metadata_probe_status *status)
 {
-	struct _cache_mngt_sync_context *context = priv;
+	struct cache_mngt_metadata_probe_context *context = priv;
+	struct kcas_cache_check_device *cmd_info = context->cmd_info;
 
 	*context->result = error;
+
+	if (error == -OCF_ERR_NO_METADATA) {
+		cmd_info->is_cache_device = false;
+		cmd_info->metadata_compatible = false;
+		*context->result = 0;
+	} else if (error == -OCF_ERR_METADATA_VER || error == 0) {
+		cmd_info->is_cache_device = true;
+		cmd_info->metadata_compatible = !error;
+		cmd_info->clean_shutdown = status->clean_shutdown;
+		cmd_info->cache_dirty = status->cache_dirty;
+		*context->result = 0;
+	}
+
 	complete(&context->cmpl);
 }
 
-static void _cache_mngt_remove_core_fallback(ocf_cache_t cache, ocf_core_t core)
+static int cas_create_volume_by_path(ocf_volume_t *vol, ocf_volume_form_t form, char *path)
 {
-	struct _cache_mngt_sync_context context;
-	int result;
+	int path_length = strnlen(path, MAX_STR_LEN);
+	struct ocf_volume_uuid uuid = {};
+	uint8_t volume_type_id;
+	int ret;
 
-	printk(KERN_ERR "Removing core failed. Detaching %s.%s\n",
-			ocf_cache_get_name(cache),
-			ocf_core_get_name(core));
+	if (path_length == MAX_STR_LEN || path_length == 0)
+		return -OCF_ERR_INVAL;
 
-	init_completion(&context.cmpl);
-	context.result = &result;
+	ret = cas_blk_identify_type(path, &volume_type_id);
+	if (ret)
+		return ret;
 
-	ocf_mngt_cache_detach_core(core,
-			_cache_mngt_generic_complete, &context);
+	/* Compression needs bios, so it takes precedence over DAX */
+	if (form == ocf_volume_form_cache && compressed_cache_volume &&
+			volume_type_id == BLOCK_DEVICE_VOLUME) {
+		volume_type_id = COMPRESSED_DEVICE_VOLUME;
+	}
 
-	wait_for_completion(&context.cmpl);
+	if (form == ocf_volume_form_cache && dax_cache_volume &&
+			volume_type_id == BLOCK_DEVICE_VOLUME &&
+			cas_blk_dax_supported(path)) {
+		volume_type_id = DAX_DEVICE_VOLUME;
+	}
 
-	if (!result)
-		return;
+	uuid.copy = true;
+	uuid.data = env_strdup(path, MAX_STR_LEN);
+	uuid.size = path_length + 1;
 
-	printk(KERN_ERR "Detaching %s.%s\n failed. Please retry the remove operation",
-			ocf_cache_get_name(cache),
-			ocf_core_get_name(core));
+	ret = ocf_ctx_volume_create(cas_ctx, vol, form, &uuid, volume_type_id);
+	if (ret)
+		return ret;
+
+	return ret;
 }
 
-static int _cache_mngt_remove_core_prepare(ocf_cache_t cache, ocf_core_t core,
-		struct kcas_remove_core *cmd)
+int cache_mngt_cache_check_device(struct kcas_cache_check_device *cmd_info)
 {
-	int result = 0;
-	bool core_active;
-
-	core_active = ocf_core_get_state(core) == ocf_core_state_active;
-
-	if (!core_active)
-		return -OCF_ERR_CORE_IN_INACTIVE_STATE;
-
-	result = kcas_core_destroy_exported_object(core);
-	if (result)
-		return result;
-
-	if (cmd->force_no_flush)
-		return 0;
-
-	result = _cache_mngt_core_flush_uninterruptible(core);
-
-	if (!result)
-		return 0;
-
-	_cache_mngt_remove_core_fallback(cache, core);
-
-	return -KCAS_ERR_DETACHED;
-}
-
-int cache_mngt_remove_core_from_cache(struct kcas_remove_core *cmd)
-{
-	struct _cache_mngt_sync_context context;
+	struct cache_mngt_metadata_probe_context context;
+	cas_bdev_handle_t bdev_handle;
+	struct block_device *bdev;
+	ocf_volume_t volume;
+	char holder[] = "CAS CHECK CACHE DEVICE\n";
 	int result;
-	ocf_cache_t cache;
-	ocf_core_t core;
-	struct cache_priv *cache_priv = NULL;
 
-	result = mngt_get_cache_by_id(cas_ctx, cmd->cache_id, &cache);
-	if (result)
-		return result;
-
-	result = _cache_mngt_remove_core_flush(cache, cmd);
-	if (result)
-		goto put;
+	/* Volume of multiple devices is opened as whole with all members */
+	if (cas_blk_is_multi_device_path(cmd_info->path_name)) {
+		bdev_handle = NULL;
+		result = cas_create_volume_by_path(&volume,
+				ocf_volume_form_cache, cmd_info->path_name);
+		if (result)
+			return result;
 
-	result = _cache_mngt_lock_sync(cache);
-	if (result)
-		goto put;
+		result = ocf_volume_open(volume, NULL);
+		if (result) {
+			ocf_volume_destroy(volume);
+			return result;
+		}
+	} else {
+		bdev_handle = cas_bdev_open_by_path(
+				cas_blk_device_path(cmd_info->path_name),
+				(CAS_BLK_MODE_EXCL | CAS_BLK_MODE_READ),
+				holder);
+		if (IS_ERR(bdev_handle)) {
+			return (PTR_ERR(bdev_handle) == -EBUSY) ?
+					-OCF_ERR_NOT_OPEN_EXC :
+					-OCF_ERR_INVAL_VOLUME_TYPE;
+		}
+		bdev = cas_bdev_get_from_handle(bdev_handle);
 
-	result = get_core_by_id(cache, cmd->core_id, &core);
-	if (result < 0) {
-		goto unlock;
+		result = cas_blk_open_volume_by_bdev(&volume, bdev);
+		if (result)
+			goto out_bdev;
 	}
 
-	result = _cache_mngt_remove_core_prepare(cache, core, cmd);
-	if (result)
-		goto unlock;
-
 	init_completion(&context.cmpl);
+	context.cmd_info = cmd_info;
 	context.result = &result;
 
-	if (cmd->detach) {
-		ocf_mngt_cache_detach_core(core,
-				_cache_mngt_generic_complete, &context);
-	} else {
-		ocf_mngt_cache_remove_core(core,
-				_cache_mngt_generic_complete, &context);
-	}
-
+	ocf_metadata_probe(cas_ctx, volume, cache_mngt_metadata_probe_end,
+			&context);
 	wait_for_completion(&context.cmpl);
 
-	if (result != -OCF_ERR_CORE_NOT_REMOVED && !cmd->detach) {
-		mark_core_id_free(cache, cmd->core_id);
-		cache_priv = ocf_cache_get_priv(cache);
-		if (cache_priv->fs_meta_dict[cmd->core_id].length && cache_priv->fs_meta_dict[cmd->core_id].data) {
-			vfree(cache_priv->fs_meta_dict[cmd->core_id].data);
-			cache_priv->fs_meta_dict[cmd->core_id].data = NULL;
-			cache_priv->fs_meta_dict[cmd->core_id].length = 0;
-		}
+	cas_blk_close_volume(volume);
+out_bdev:
+	if (bdev_handle) {
+		cas_bdev_release(bdev_handle,
+				(CAS_BLK_MODE_EXCL | CAS_BLK_MODE_READ),
+				holder);
 	}
-
-unlock:
-	ocf_mngt_cache_unlock(cache);
-put:
-	ocf_mngt_cache_put(cache);
 	return result;
 }
 
-int cache_mngt_remove_inactive_core(struct kcas_remove_inactive *cmd)
+int cache_mngt_prepare_core_cfg(struct ocf_mngt_core_config *cfg,
+		struct kcas_insert_core *cmd_info)
 {
-	struct _cache_mngt_sync_context context;
-	int result = 0;
-	ocf_cache_t cache;
-	ocf_core_t core;
-	struct cache_priv *cache_priv = NULL;
+	char core_name[OCF_CORE_NAME_SIZE] = {};
+	ocf_cache_t cache = NULL;
+	uint16_t core_id;
+	int result;
 
-	result = mngt_get_cache_by_id(cas_ctx, cmd->cache_id, &cache);
-	if (result)
-		return result;
+	if (strnlen(cmd_info->core_path_name, MAX_STR_LEN) >= MAX_STR_LEN)
+		return -OCF_ERR_INVAL;
+	
+	if (cmd_info->try_add && cmd_info->core_id == OCF_CORE_MAX)
+		return -OCF_ERR_INVAL;
 
-	result = _cache_mngt_lock_sync(cache);
-	if (result)
-		goto put;
+	if (cmd_info->queue_depth > BLK_MQ_MAX_DEPTH)
+		return -OCF_ERR_INVAL;
 
-	result = get_core_by_id(cache, cmd->core_id, &core);
-	if (result < 0) {
-		goto unlock;
+	if (cmd_info->read_ahead_kb > KCAS_EXP_OBJ_IO_HINT_KB_MAX ||
+			cmd_info->io_opt_kb > KCAS_EXP_OBJ_IO_HINT_KB_MAX)
+		return -OCF_ERR_INVAL;
+	
+	result = mngt_get_cache_by_id(cas_ctx, cmd_info->cache_id, &cache);
+	if (result && result != -OCF_ERR_CACHE_NOT_EXIST) {
+		return result;
+	} else if (!result && ocf_cache_is_standby(cache)) {
+		ocf_mngt_cache_put(cache);
+		return -OCF_ERR_CACHE_STANDBY;
 	}
 
-	result = (ocf_core_get_state(core) == ocf_core_state_active);
-	if (result) {
-		result = -KCAS_ERR_CORE_IN_ACTIVE_STATE;
-		goto unlock;
+	if (cmd_info->core_id == OCF_CORE_MAX) {
+		struct cache_priv *cache_priv;
+
+		if (!cache)
+			return -OCF_ERR_CACHE_NOT_EXIST;
+
+		cache_priv = ocf_cache_get_priv(cache);
+		core_id = find_free_core_id(cache_priv->core_id_bitmap);
+		if (core_id == OCF_CORE_MAX)
+			return -OCF_ERR_INVAL;
+
+		cmd_info->core_id = core_id;
 	}
 
-	if (ocf_mngt_core_is_dirty(core) && !cmd->force) {
-		result = -KCAS_ERR_INACTIVE_CORE_IS_DIRTY;
-		goto unlock;
+	if (cache) {
+		ocf_mngt_cache_put(cache);
+		cache = NULL;
 	}
 
-	/*
-	 * Destroy exported object - in case of error during destruction of
-	 * exported object, instead of trying rolling this back we rather
-	 * inform user about error.
-	 */
-	result = kcas_core_destroy_exported_object(core);
-	if (result)
-		goto unlock;
+	snprintf(core_name, sizeof(core_name), "core%d", cmd_info->core_id);
 
-	init_completion(&context.cmpl);
-	context.result = &result;
+	memset(cfg, 0, sizeof(*cfg));
+	env_strncpy(cfg->name, OCF_CORE_NAME_SIZE, core_name, OCF_CORE_NAME_SIZE);
 
-	ocf_mngt_cache_remove_core(core, _cache_mngt_generic_complete,
-			&context);
+	cfg->uuid.data = cmd_info->core_path_name;
+	cfg->uuid.size = strnlen(cmd_info->core_path_name, MAX_STR_LEN) + 1;
+	cfg->try_add = cmd_info->try_add;
+	cfg->seq_cutoff_promote_on_threshold = true;
 
-	wait_for_completion(&context.cmpl);
+	if (!cas_bdev_exist(cas_blk_device_path(cfg->uuid.data)))
+		return -OCF_ERR_INVAL_VOLUME_TYPE;
 
-	if (!result) {
-		mark_core_id_free(cache, cmd->core_id);
-		cache_priv = ocf_cache_get_priv(cache);
-		if (cache_priv->fs_meta_dict[cmd->core_id].length && cache_priv->fs_meta_dict[cmd->core_id].data) {
-			vfree(cache_priv->fs_meta_dict[cmd->core_id].data);
-			cache_priv->fs_meta_dict[cmd->core_id].data = NULL;
-			cache_priv->fs_meta_dict[cmd->core_id].length = 0;
-		}
+	if (cmd_info->update_path)
+		return 0;
+
+	result = cas_blk_identify_type(cfg->uuid.data, &cfg->volume_type);
+	if (OCF_ERR_NOT_OPEN_EXC == abs(result)) {
+		printk(KERN_WARNING OCF_PREFIX_SHORT
+			"Cannot open device %s exclusively. "
+		        "It is already opened by another program!\n",
+			cmd_info->core_path_name);
 	}
 
-unlock:
-	ocf_mngt_cache_unlock(cache);
-put:
-	ocf_mngt_cache_put(cache);
 	return result;
 }
 
-int cache_mngt_reset_stats(const char *cache_name, size_t cache_name_len,
-				const char *core_name, size_t core_name_len)
+static int cache_mngt_update_core_uuid(ocf_cache_t cache, const char *core_name,
+				size_t name_len, ocf_uuid_t uuid_ptr)
 {
-	ocf_cache_t cache;
 	ocf_core_t core;
-	int result = 0;
+	ocf_volume_t vol;
+	struct bd_object *bdvol;
+	int result;
+	struct ocf_volume_uuid uuid = {};
 
-	result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name, cache_name_len,
-						&cache);
-	if (result)
-		return result;
+	if (ocf_core_get_by_name(cache, core_name, name_len, &core)) {
+		/* no such core */
+		return -ENODEV;
+	}
 
-	result = _cache_mngt_lock_sync(cache);
-	if (result) {
-		ocf_mngt_cache_put(cache);
-		return result;
+	if (ocf_core_get_state(core) != ocf_core_state_active) {
+		/* core inactive */
+		return -ENODEV;
 	}
 
-	if (core_name) {
-		result = ocf_core_get_by_name(cache, core_name,
-					core_name_len, &core);
-		if (result)
-			goto out;
+	/* get bottom device volume for this core */
+	vol = ocf_core_get_volume(core);
+	bdvol = bd_object(vol);
 
-		ocf_core_stats_initialize(core);
-	} else {
-		result = ocf_core_stats_initialize_all(cache);
+	if (!cas_bdev_match(uuid_ptr->data, bdvol->btm_bd)) {
+		printk(KERN_ERR "UUID provided does not match target core device\n");
+		return -ENODEV;
 	}
 
-out:
-	ocf_mngt_cache_unlock(cache);
-	ocf_mngt_cache_put(cache);
+	uuid.copy = true;
+	uuid.data = env_strdup(uuid_ptr->data, MAX_STR_LEN);
+	uuid.size = strnlen(uuid_ptr->data, MAX_STR_LEN) + 1;
+
+	result = ocf_mngt_core_set_uuid(core, &uuid);
+	if (result) {
+		env_free(uuid.data);
+		return result;
+	}
+
+	if (ocf_cache_is_device_attached(cache))
+		result = _cache_mngt_save_sync(cache);
+
 	return result;
 }
 
-static inline void io_class_info2cfg(ocf_part_id_t part_id,
-		struct ocf_io_class_info *info, struct ocf_mngt_io_class_config *cfg)
+static void _cache_mngt_log_core_device_path(ocf_core_t core)
 {
-	cfg->class_id = part_id;
-	cfg->name = info->name;
-	cfg->prio = info->priority;
-	cfg->cache_mode = info->cache_mode;
-	cfg->max_size = info->max_size;
+	ocf_cache_t cache = ocf_core_get_cache(core);
+	const ocf_uuid_t core_uuid = (const ocf_uuid_t)ocf_core_get_uuid(core);
+
+	printk(KERN_INFO OCF_PREFIX_SHORT "Adding device %s as core %s "
+			"to cache %s\n", (const char*)core_uuid->data,
+			ocf_core_get_name(core), ocf_cache_get_name(cache));
 }
 
-int cache_mngt_set_partitions(const char *cache_name, size_t name_len,
-		struct kcas_io_classes *cfg)
+static int _cache_mngt_core_device_loaded_visitor(ocf_core_t core, void *cntx)
 {
-	ocf_cache_t cache;
-	struct ocf_mngt_io_classes_config *io_class_cfg;
-	struct cas_cls_rule *cls_rule[OCF_USER_IO_CLASS_MAX];
-	ocf_part_id_t class_id;
-	int result;
+	uint16_t core_id = OCF_CORE_ID_INVALID;
+	ocf_cache_t cache = ocf_core_get_cache(core);
 
-	io_class_cfg = kzalloc(sizeof(struct ocf_mngt_io_class_config) *
-			OCF_USER_IO_CLASS_MAX, GFP_KERNEL);
-	if (!io_class_cfg)
-		return -OCF_ERR_NO_MEM;
+	_cache_mngt_log_core_device_path(core);
 
-	for (class_id = 0; class_id < OCF_USER_IO_CLASS_MAX; class_id++) {
-		io_class_cfg->config[class_id].class_id = class_id;
+	core_id_from_name(&core_id, ocf_core_get_name(core));
 
-		if (!cfg->info[class_id].name[0]) {
-			io_class_cfg->config[class_id].class_id = class_id;
-			continue;
-		}
+	mark_core_id_used(cache, core_id);
 
-		io_class_info2cfg(class_id, &cfg->info[class_id],
-				&io_class_cfg->config[class_id]);
+	/* Device of active core has been taken from core pool by OCF */
+	if (ocf_core_get_state(core) == ocf_core_state_active) {
+		_cache_mngt_core_pool_index_remove(
+				ocf_core_get_uuid(core)->data);
 	}
 
-	result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name,
-					name_len, &cache);
-	if (result)
-		goto out_get;
+	return 0;
+}
 
-	if (ocf_cache_is_standby(cache)) {
-		result = -OCF_ERR_CACHE_STANDBY;
-		goto out_not_running;
-	}
+struct _cache_mngt_add_core_context {
+	struct completion cmpl;
+	ocf_core_t *core;
+	int *result;
+};
 
-	if (!ocf_cache_is_device_attached(cache)) {
-		result = -OCF_ERR_CACHE_DETACHED;
-		goto out_not_running;
-	}
+/************************************************************
+ * Function for adding a CORE object to the cache instance. *
+ ************************************************************/
 
-	for (class_id = 0; class_id < OCF_USER_IO_CLASS_MAX; class_id++) {
-		result = cas_cls_rule_create(cache, class_id,
-				cfg->info[class_id].name,
-				&cls_rule[class_id]);
-		if (result)
-			goto out_cls;
-	}
+static void _cache_mngt_add_core_complete(ocf_cache_t cache,
+		ocf_core_t core, void *priv, int error)
+{
+	struct _cache_mngt_add_core_context *context = priv;
 
-	result = _cache_mngt_lock_sync(cache);
-	if (result)
-		goto out_cls;
+	*context->core = core;
+	*context->result = error;
+	complete(&context->cmpl);
+}
 
-	result = ocf_mngt_cache_io_classes_configure(cache, io_class_cfg);
-	if (result == -OCF_ERR_IO_CLASS_NOT_EXIST)
-		result = 0;
-	if(result)
-		goto out_configure;
+static void _cache_mngt_generic_complete(void *priv, int error);
 
-	result = _cache_mngt_save_sync(cache);
-	if (result)
-		goto out_configure;
+static int _cache_mngt_fs_meta_cmp(const void *a, const void *b)
+{
+	const struct fs_meta_lba *la = a, *lb = b;
 
-	for (class_id = 0; class_id < OCF_USER_IO_CLASS_MAX; class_id++)
-		cas_cls_rule_apply(cache, class_id, cls_rule[class_id]);
+	if (la->lba_beg < lb->lba_beg)
+		return -1;
 
-out_configure:
-	ocf_mngt_cache_unlock(cache);
-out_cls:
-	if (result) {
-		while (class_id--)
-			cas_cls_rule_destroy(cache, cls_rule[class_id]);
-	}
-out_not_running:
-	ocf_mngt_cache_put(cache);
-out_get:
-	kfree(io_class_cfg);
-	return result;
+	return la->lba_beg > lb->lba_beg;
 }
 
-static int _cache_mngt_create_core_exported_object(ocf_core_t core, void *cntx)
+static uint32_t _cache_mngt_fs_meta_varint_len(uint64_t v)
 {
-	int result;
+	uint32_t len = 1;
 
-	result = kcas_core_create_exported_object(core);
+	for (; v >= 0x80; v >>= 7)
+		len++;
 
-	return result;
+	return len;
 }
 
-static int _cache_mngt_destroy_core_exported_object(ocf_core_t core, void *cntx)
+static uint8_t *_cache_mngt_fs_meta_varint_put(uint8_t *p, uint64_t v)
 {
-	if (kcas_core_destroy_exported_object(core)) {
-		ocf_cache_t cache = ocf_core_get_cache(core);
+	for (; v >= 0x80; v >>= 7)
+		*p++ = (v & 0x7f) | 0x80;
+	*p++ = v;
 
-		printk(KERN_ERR "Cannot to destroy exported object, %s.%s\n",
-				ocf_cache_get_name(cache),
-				ocf_core_get_name(core));
-	}
+	return p;
+}
 
-	return 0;
+static const uint8_t *_cache_mngt_fs_meta_varint_get(const uint8_t *p,
+		uint64_t *v)
+{
+	uint64_t result = 0;
+	uint32_t shift = 0;
+
+	for (; *p & 0x80; shift += 7)
+		result |= (uint64_t)(*p++ & 0x7f) << shift;
+	result |= (uint64_t)*p++ << shift;
+
+	*v = result;
+	return p;
 }
 
-static int cache_mngt_initialize_core_exported_objects(ocf_cache_t cache)
+/* Number of extents in block @b of @map */
+static uint32_t _cache_mngt_fs_meta_block_count(const struct cas_fs_meta *map,
+		uint32_t b)
 {
-	int result;
+	return min_t(uint32_t, CAS_FS_META_BLOCK_EXTENTS,
+			map->count - b * CAS_FS_META_BLOCK_EXTENTS);
+}
 
-	result = ocf_core_visit(cache, _cache_mngt_create_core_exported_object, NULL,
-			true);
-	if (result) {
-		/* Need to cleanup */
-		ocf_core_visit(cache, _cache_mngt_destroy_core_exported_object, NULL,
-				true);
+/* Decode extent following one ending at @prev in block data at @p */
+static const uint8_t *_cache_mngt_fs_meta_next(const uint8_t *p,
+		uint64_t prev, struct fs_meta_lba *extent)
+{
+	uint64_t gap, len;
+
+	p = _cache_mngt_fs_meta_varint_get(p, &gap);
+	p = _cache_mngt_fs_meta_varint_get(p, &len);
+	extent->lba_beg = prev + gap;
+	extent->lba_end = extent->lba_beg + len;
+
+	return p;
+}
+
+/*
+ * Find first extent of @map ending past block @lba. Only the block found
+ * in skip index and possibly the first extent of the next one is decoded.
+ */
+static bool _cache_mngt_fs_meta_lookup(const struct cas_fs_meta *map,
+		uint64_t lba, struct fs_meta_lba *extent)
+{
+	uint32_t l = 0, r = map->blocks_no, m, b, i, count;
+	const uint8_t *p;
+	uint64_t prev;
+
+	/* Find last block starting at or before lba */
+	while (l < r) {
+		m = l + (r - l) / 2;
+		if (map->blocks[m].lba_beg <= lba)
+			l = m + 1;
+		else
+			r = m;
 	}
 
-	return result;
+	for (b = l ? l - 1 : 0; b < map->blocks_no; b++) {
+		p = map->data + map->blocks[b].offset;
+		prev = map->blocks[b].lba_beg;
+		count = _cache_mngt_fs_meta_block_count(map, b);
+
+		for (i = 0; i < count; i++) {
+			p = _cache_mngt_fs_meta_next(p, prev, extent);
+			if (extent->lba_end > lba)
+				return true;
+			prev = extent->lba_end;
+		}
+	}
+
+	return false;
 }
 
-static int cache_mngt_destroy_cache_exported_object(ocf_cache_t cache)
+/* Decode all extents of @map into @table */
+static void _cache_mngt_fs_meta_decode(const struct cas_fs_meta *map,
+		struct fs_meta_lba *table)
 {
-	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
-	int ret;
+	uint32_t b, i, count;
+	const uint8_t *p;
+	uint64_t prev;
 
-	if (!cache_priv->cache_exported_object_initialized)
-		return 0;
+	for (b = 0; b < map->blocks_no; b++) {
+		p = map->data + map->blocks[b].offset;
+		prev = map->blocks[b].lba_beg;
+		count = _cache_mngt_fs_meta_block_count(map, b);
 
-	ret = kcas_cache_destroy_exported_object(cache);
+		for (i = 0; i < count; i++, table++) {
+			p = _cache_mngt_fs_meta_next(p, prev, table);
+			prev = table->lba_end;
+		}
+	}
+}
 
-	if (ret) {
-		printk(KERN_ERR "Cannot destroy %s exported object\n",
-				ocf_cache_get_name(cache));
-	} else {
-		cache_priv->cache_exported_object_initialized = false;
+/*
+ * Encode sorted, disjoint extents of @table. Each extent is stored as
+ * varint distance from end of previous extent and varint length, blocks of
+ * CAS_FS_META_BLOCK_EXTENTS extents start from extent beginning stored in
+ * skip index. Returns NULL if @table is empty.
+ */
+static struct cas_fs_meta *_cache_mngt_fs_meta_encode(
+		const struct fs_meta_lba *table, uint32_t count)
+{
+	uint32_t blocks_no = DIV_ROUND_UP(count, CAS_FS_META_BLOCK_EXTENTS);
+	struct cas_fs_meta *map;
+	uint64_t prev = 0;
+	size_t size = 0;
+	uint8_t *p;
+	uint32_t i;
+
+	if (!count)
+		return NULL;
+
+	for (i = 0; i < count; i++) {
+		if (i % CAS_FS_META_BLOCK_EXTENTS == 0)
+			prev = table[i].lba_beg;
+		size += _cache_mngt_fs_meta_varint_len(table[i].lba_beg - prev);
+		size += _cache_mngt_fs_meta_varint_len(table[i].lba_end -
+				table[i].lba_beg);
+		prev = table[i].lba_end;
 	}
 
-	return ret;
+	size += sizeof(*map) + blocks_no * sizeof(*map->blocks);
+	map = vmalloc(size);
+	if (!map)
+		return ERR_PTR(-OCF_ERR_NO_MEM);
+
+	map->count = count;
+	map->blocks_no = blocks_no;
+	map->size = size;
+	map->blocks = (struct cas_fs_meta_block *)map->buf;
+	map->data = map->buf + blocks_no * sizeof(*map->blocks);
+
+	p = map->data;
+	for (i = 0; i < count; i++) {
+		if (i % CAS_FS_META_BLOCK_EXTENTS == 0) {
+			prev = table[i].lba_beg;
+			map->blocks[i / CAS_FS_META_BLOCK_EXTENTS].lba_beg = prev;
+			map->blocks[i / CAS_FS_META_BLOCK_EXTENTS].offset =
+				p - map->data;
+		}
+		p = _cache_mngt_fs_meta_varint_put(p, table[i].lba_beg - prev);
+		p = _cache_mngt_fs_meta_varint_put(p, table[i].lba_end -
+				table[i].lba_beg);
+		prev = table[i].lba_end;
+	}
+
+	return map;
 }
 
-static int cache_mngt_initialize_cache_exported_object(ocf_cache_t cache)
+/*
+ * Sort @table by start, merge overlapping or adjacent extents and drop
+ * empty ones. Returns number of extents left.
+ */
+static uint32_t _cache_mngt_fs_meta_merge(struct fs_meta_lba *table,
+		uint32_t count)
 {
-	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
-	int result;
+	uint32_t i, merged = 0;
 
-	result = kcas_cache_create_exported_object(cache);
-	if (result)
-		return result;
+	sort(table, count, sizeof(*table), _cache_mngt_fs_meta_cmp, NULL);
 
-	cache_priv->cache_exported_object_initialized = true;
+	for (i = 0; i < count; i++) {
+		if (table[i].lba_end <= table[i].lba_beg)
+			continue;
 
-	return 0;
+		if (merged && table[i].lba_beg <= table[merged - 1].lba_end) {
+			table[merged - 1].lba_end = max(table[merged - 1].lba_end,
+					table[i].lba_end);
+		} else {
+			table[merged++] = table[i];
+		}
+	}
+
+	return merged;
 }
 
-static int cache_mngt_create_cache_device_cfg(
-		struct ocf_mngt_cache_device_config *cfg, char *cache_path)
+/*
+ * Build filesystem metadata map out of union of extents of @map (may be
+ * NULL) and extent table @b. Returns NULL if no extent is left.
+ */
+static struct cas_fs_meta *_cache_mngt_fs_meta_build(
+		const struct cas_fs_meta *map,
+		const struct fs_meta_lba *b, uint32_t b_count)
 {
-	int result = 0;
-	ocf_volume_t volume;
+	uint32_t a_count = map ? map->count : 0;
+	uint32_t count = a_count + b_count;
+	struct cas_fs_meta *result;
+	struct fs_meta_lba *table;
 
-	memset(cfg, 0, sizeof(*cfg));
+	if (!count)
+		return NULL;
 
-	result = cas_create_volume_by_path(&volume, ocf_volume_form_cache, cache_path);
-	if (result)
-		return result;
+	table = vmalloc(count * sizeof(*table));
+	if (!table)
+		return ERR_PTR(-OCF_ERR_NO_MEM);
 
-	cfg->perform_test = false;
-	cfg->volume = volume;
+	if (a_count)
+		_cache_mngt_fs_meta_decode(map, table);
+	if (b_count)
+		memcpy(table + a_count, b, b_count * sizeof(*table));
 
-	return 0;
+	result = _cache_mngt_fs_meta_encode(table,
+			_cache_mngt_fs_meta_merge(table, count));
+	vfree(table);
+
+	return result;
 }
 
-int cache_mngt_attach_cache_cfg(char *cache_name, size_t name_len,
-		struct ocf_mngt_cache_config *cfg,
-		struct ocf_mngt_cache_attach_config *attach_cfg,
-		struct kcas_start_cache *cmd)
+/* Build map of extents of @map not covered by any extent of @b */
+static struct cas_fs_meta *_cache_mngt_fs_meta_subtract(
+		const struct cas_fs_meta *map,
+		const struct fs_meta_lba *b, uint32_t b_count)
 {
-	int result;
+	struct fs_meta_lba cur, *rm, *table, *kept, *out;
+	struct cas_fs_meta *result;
+	uint32_t rm_count, i, j = 0;
 
-	if (!cmd)
-		return -OCF_ERR_INVAL;
+	rm = vmalloc((b_count + map->count + map->count + b_count) *
+			sizeof(*rm));
+	if (!rm)
+		return ERR_PTR(-OCF_ERR_NO_MEM);
 
-	memset(cfg, 0, sizeof(*cfg));
-	memset(attach_cfg, 0, sizeof(*attach_cfg));
+	if (b_count)
+		memcpy(rm, b, b_count * sizeof(*rm));
+	rm_count = _cache_mngt_fs_meta_merge(rm, b_count);
 
-	result = cache_mngt_create_cache_device_cfg(&attach_cfg->device,
-			cmd->cache_path_name);
-	if (result)
-		return result;
+	/* Each removed extent splits at most one extent in two */
+	table = rm + b_count;
+	kept = out = table + map->count;
+	_cache_mngt_fs_meta_decode(map, table);
 
-	//TODO maybe attach should allow to change cache line size?
-	//cfg->cache_line_size = cmd->line_size;
-	cfg->use_submit_io_fast = !use_io_scheduler;
-	cfg->locked = true;
-	cfg->metadata_volatile = true;
+	for (i = 0; i < map->count; i++) {
+		cur = table[i];
 
-	cfg->backfill.max_queue_size = max_writeback_queue_size;
-	cfg->backfill.queue_unblock_size = writeback_queue_unblock_size;
-	attach_cfg->cache_line_size = cmd->line_size;
-	attach_cfg->force = cmd->force;
-	attach_cfg->discard_on_start = true;
+		/* Skip removed extents ending before current one */
+		while (j < rm_count && rm[j].lba_end <= cur.lba_beg)
+			j++;
 
-	return 0;
+		while (j < rm_count && rm[j].lba_beg < cur.lba_end) {
+			if (rm[j].lba_beg > cur.lba_beg) {
+				out->lba_beg = cur.lba_beg;
+				out->lba_end = rm[j].lba_beg;
+				out++;
+			}
+			if (rm[j].lba_end >= cur.lba_end) {
+				cur.lba_beg = cur.lba_end;
+				break;
+			}
+			cur.lba_beg = rm[j].lba_end;
+			j++;
+		}
+
+		if (cur.lba_beg < cur.lba_end)
+			*out++ = cur;
+	}
+
+	result = _cache_mngt_fs_meta_encode(kept, out - kept);
+	vfree(rm);
+
+	return result;
 }
 
-static void cache_mngt_destroy_cache_device_cfg(
-		struct ocf_mngt_cache_device_config *cfg)
+/* Publish new metadata map of core, called under cache management lock */
+static void _cache_mngt_fs_meta_replace(struct cache_priv *cache_priv,
+		ocf_core_id_t core_id, struct cas_fs_meta *map)
 {
-	ocf_volume_destroy(cfg->volume);
+	struct cas_fs_meta *old;
+
+	old = rcu_dereference_protected(cache_priv->fs_meta[core_id], true);
+	rcu_assign_pointer(cache_priv->fs_meta[core_id], map);
+
+	if (old) {
+		/* Wait for metadata lookups still using old map */
+		synchronize_rcu();
+		vfree(old);
+	}
 }
 
-int cache_mngt_create_cache_cfg(struct ocf_mngt_cache_config *cfg,
-		struct ocf_mngt_cache_attach_config *attach_cfg,
-		struct kcas_start_cache *cmd)
+#define CAS_FS_META_LEARN_DELAY HZ
+
+static int _cache_mngt_fs_meta_learned_cmp(const void *a, const void *b)
 {
-	int init_cache, result;
-	char cache_name[OCF_CACHE_NAME_SIZE];
-	uint32_t cache_id;
+	const struct cas_fs_meta_learned *la = a, *lb = b;
 
-	switch (cmd->init_cache) {
-		case CACHE_INIT_STANDBY_NEW:
-		case CACHE_INIT_STANDBY_LOAD:
-			printk(KERN_ERR "Standby mode is not supported!\n");
-			return -ENOTSUP;
-		default:
-			break;
+	return (int)la->core_id - (int)lb->core_id;
+}
+
+/* Merge extents learned from metadata I/O into maps of cores */
+static void _cache_mngt_fs_meta_learn_work(struct work_struct *work)
+{
+	struct cache_priv *cache_priv = container_of(to_delayed_work(work),
+			struct cache_priv, fs_meta_learn.work);
+	struct cas_fs_meta_learned *merging = cache_priv->fs_meta_learn.merging;
+	struct fs_meta_lba *extents = cache_priv->fs_meta_learn.extents;
+	ocf_cache_t cache = cache_priv->cache;
+	struct cas_fs_meta *old, *map;
+	ocf_core_id_t core_id;
+	uint32_t i, j, count;
+
+	/* Don't wait for management operation, possibly stopping cache */
+	if (ocf_mngt_cache_trylock(cache)) {
+		schedule_delayed_work(&cache_priv->fs_meta_learn.work,
+				CAS_FS_META_LEARN_DELAY);
+		return;
 	}
 
-	if (!cmd)
-		return -OCF_ERR_INVAL;
+	spin_lock_irq(&cache_priv->fs_meta_learn.lock);
+	count = cache_priv->fs_meta_learn.count;
+	memcpy(merging, cache_priv->fs_meta_learn.pending,
+			count * sizeof(*merging));
+	cache_priv->fs_meta_learn.count = 0;
+	spin_unlock_irq(&cache_priv->fs_meta_learn.lock);
 
-	if (cmd->init_cache == CACHE_INIT_LOAD ||
-			cmd->init_cache == CACHE_INIT_STANDBY_LOAD) {
-		if (cmd->cache_id != OCF_CACHE_ID_INVALID) {
-			printk(KERN_WARNING "Specifying cache id while loading "
-					"cache is forbidden\n");
-			return -OCF_ERR_INVAL;
-		}
+	sort(merging, count, sizeof(*merging),
+			_cache_mngt_fs_meta_learned_cmp, NULL);
 
-		if (cmd->line_size != ocf_cache_line_size_none) {
-			printk(KERN_WARNING "Specifying cache line size while "
-					"loading cache is forbidden\n");
-			return -OCF_ERR_INVAL;
-		}
-		if (cmd->caching_mode != ocf_cache_mode_none) {
-			printk(KERN_WARNING "Specifying cache mode while "
-					"loading cache is forbidden\n");
-			return -OCF_ERR_INVAL;
-		}
-	} else if (cmd->cache_id == OCF_CACHE_ID_INVALID) {
-		cache_id = find_free_cache_id(cas_ctx);
-		if (cache_id == OCF_CACHE_ID_INVALID)
-			return -OCF_ERR_INVAL;
+	for (i = 0; i < count; i = j) {
+		core_id = merging[i].core_id;
+		for (j = i; j < count && merging[j].core_id == core_id; j++)
+			extents[j - i] = merging[j].extent;
 
-		cmd->cache_id = cache_id;
+		old = rcu_dereference_protected(cache_priv->fs_meta[core_id],
+				true);
+		map = _cache_mngt_fs_meta_build(old, extents, j - i);
+		/* On failure drop extents, they are learned again later */
+		if (IS_ERR_OR_NULL(map))
+			continue;
+
+		_cache_mngt_fs_meta_replace(cache_priv, core_id, map);
 	}
 
-	cache_name_from_id(cache_name, cmd->cache_id);
+	ocf_mngt_cache_unlock(cache);
+}
 
-	memset(cfg, 0, sizeof(*cfg));
-	memset(attach_cfg, 0, sizeof(*attach_cfg));
+static void _cache_mngt_fs_meta_learn_init(struct cache_priv *cache_priv)
+{
+	spin_lock_init(&cache_priv->fs_meta_learn.lock);
+	INIT_DELAYED_WORK(&cache_priv->fs_meta_learn.work,
+			_cache_mngt_fs_meta_learn_work);
+}
 
-	result = cache_mngt_create_cache_device_cfg(&attach_cfg->device,
-			cmd->cache_path_name);
-	if (result)
-		return result;
+/* Stop learning, called once no I/O is submitted to exported objects */
+static void _cache_mngt_fs_meta_learn_stop(struct cache_priv *cache_priv)
+{
+	spin_lock_irq(&cache_priv->fs_meta_learn.lock);
+	cache_priv->fs_meta_learn.stopped = true;
+	spin_unlock_irq(&cache_priv->fs_meta_learn.lock);
 
-	strncpy(cfg->name, cache_name, OCF_CACHE_NAME_SIZE - 1);
-	cfg->cache_mode = cmd->caching_mode;
-	cfg->cache_line_size = cmd->line_size;
-	cfg->promotion_policy = ocf_promotion_default;
-	cfg->cache_line_size = cmd->line_size;
-	cfg->pt_unaligned_io = !unaligned_io;
-	cfg->use_submit_io_fast = !use_io_scheduler;
-	cfg->locked = true;
-	cfg->metadata_volatile = false;
+	cancel_delayed_work_sync(&cache_priv->fs_meta_learn.work);
+}
 
-	cfg->backfill.max_queue_size = max_writeback_queue_size;
-	cfg->backfill.queue_unblock_size = writeback_queue_unblock_size;
-	attach_cfg->cache_line_size = cmd->line_size;
-	attach_cfg->force = cmd->force;
-	attach_cfg->discard_on_start = true;
+/* Forget extents learned for removed core, called under management lock */
+static void _cache_mngt_fs_meta_learn_drop(struct cache_priv *cache_priv,
+		ocf_core_id_t core_id)
+{
+	struct cas_fs_meta_learned *pending = cache_priv->fs_meta_learn.pending;
+	uint32_t i, count = 0;
 
-	init_cache = cmd->init_cache;
+	spin_lock_irq(&cache_priv->fs_meta_learn.lock);
+	for (i = 0; i < cache_priv->fs_meta_learn.count; i++) {
+		if (pending[i].core_id != core_id)
+			pending[count++] = pending[i];
+	}
+	cache_priv->fs_meta_learn.count = count;
+	spin_unlock_irq(&cache_priv->fs_meta_learn.lock);
+}
 
-	switch (init_cache) {
-	case CACHE_INIT_LOAD:
-		attach_cfg->open_cores = true;
-	case CACHE_INIT_NEW:
-	case CACHE_INIT_STANDBY_NEW:
-	case CACHE_INIT_STANDBY_LOAD:
-		break;
-	default:
-		return -OCF_ERR_INVAL;
+void cache_mngt_fs_meta_learn(ocf_cache_t cache, ocf_core_id_t core_id,
+		sector_t sector, uint32_t sectors)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	struct fs_meta_lba extent = {
+		.lba_beg = sector >> 3,
+		.lba_end = DIV_ROUND_UP(sector + sectors, 8),
+	};
+	struct cas_fs_meta_learned *last;
+	struct fs_meta_lba found;
+	struct cas_fs_meta *map;
+	unsigned long flags;
+	bool known = false;
+
+	/* Metadata is read over and over, skip extents already in map */
+	rcu_read_lock();
+	map = rcu_dereference(cache_priv->fs_meta[core_id]);
+	if (map && _cache_mngt_fs_meta_lookup(map, extent.lba_beg, &found)) {
+		known = found.lba_beg <= extent.lba_beg &&
+			found.lba_end >= extent.lba_end;
 	}
+	rcu_read_unlock();
 
+	if (known)
+		return;
 
-	return 0;
-}
+	spin_lock_irqsave(&cache_priv->fs_meta_learn.lock, flags);
 
-static void _cache_mngt_log_cache_device_path(ocf_cache_t cache,
-		const char *cache_path)
-{
-	printk(KERN_INFO OCF_PREFIX_SHORT "Adding device %s as cache %s\n",
-			cache_path, ocf_cache_get_name(cache));
+	if (cache_priv->fs_meta_learn.stopped)
+		goto unlock;
+
+	/* Extend last extent on sequential metadata I/O */
+	if (cache_priv->fs_meta_learn.count) {
+		last = &cache_priv->fs_meta_learn.pending[
+				cache_priv->fs_meta_learn.count - 1];
+		if (last->core_id == core_id &&
+				extent.lba_beg <= last->extent.lba_end &&
+				extent.lba_end >= last->extent.lba_beg) {
+			last->extent.lba_beg = min(last->extent.lba_beg,
+					extent.lba_beg);
+			last->extent.lba_end = max(last->extent.lba_end,
+					extent.lba_end);
+			goto unlock;
+		}
+	}
+
+	/* When full drop extent, it's learned on next access */
+	if (cache_priv->fs_meta_learn.count == CAS_FS_META_LEARN_MAX)
+		goto unlock;
+
+	last = &cache_priv->fs_meta_learn.pending[
+			cache_priv->fs_meta_learn.count];
+	last->core_id = core_id;
+	last->extent = extent;
+
+	if (!cache_priv->fs_meta_learn.count++) {
+		schedule_delayed_work(&cache_priv->fs_meta_learn.work,
+				CAS_FS_META_LEARN_DELAY);
+	}
+
+unlock:
+	spin_unlock_irqrestore(&cache_priv->fs_meta_learn.lock, flags);
 }
 
-static void _cas_queue_kick(ocf_queue_t q)
+/* Build metadata map out of table supplied by user */
+static struct cas_fs_meta *_cache_mngt_fs_meta_from_user(
+		const struct fs_meta_map *src)
 {
-	cas_kick_queue_thread(q);
+	return _cache_mngt_fs_meta_build(NULL, src->data,
+			src->length / sizeof(struct fs_meta_lba));
 }
 
-static void _cas_queue_stop(ocf_queue_t q)
+/* Add core to cache locked for management, with defaults of this module */
+static int _cache_mngt_add_core(ocf_cache_t cache,
+		struct ocf_mngt_core_config *cfg,
+		struct kcas_insert_core *cmd_info, ocf_core_id_t core_id,
+		ocf_core_t *core)
 {
-	cas_stop_queue_thread(q);
-}
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	struct _cache_mngt_add_core_context add_context;
+	int result;
 
-const struct ocf_queue_ops queue_ops = {
-	.kick = _cas_queue_kick,
-	.stop = _cas_queue_stop,
-};
+	cache_priv->exp_obj_queue_cfg[core_id].queue_depth =
+			cmd_info->queue_depth;
+	cache_priv->exp_obj_queue_cfg[core_id].hw_queues =
+			cmd_info->hw_queues;
+	cache_priv->exp_obj_queue_cfg[core_id].read_ahead_kb =
+			cmd_info->read_ahead_kb;
+	cache_priv->exp_obj_queue_cfg[core_id].io_opt_kb =
+			cmd_info->io_opt_kb;
 
-int cas_init_mngt_queue_thread(ocf_cache_t cache, ocf_queue_t q, int cpu)
-{
-	const char *cache_num = ocf_cache_get_name(cache) + 5;
-	char name[48] = {};
-	snprintf(name, sizeof(name), "cas_mngt_%s", cache_num);
+	cfg->seq_cutoff_threshold = seq_cut_off_mb * MiB;
+	cfg->seq_cutoff_promotion_count = 8;
 
-	return cas_create_queue_thread(q, name, cpu);
-}
-int cas_init_io_queue_thread(ocf_cache_t cache, ocf_queue_t q, int cpu)
-{
-	const char *cache_num = ocf_cache_get_name(cache) + 5;
-	char name[48] = {};
-	snprintf(name, sizeof(name), "cas_io_%s", cache_num);
+	/* Due to linux thread scheduling nature, we prefer to promote streams
+	 * as early as we reasonably can. One way to achieve that is to set
+	 * promotion count really low, which unfortunately significantly increases
+	 * number of accesses to shared structures. The other way is to promote
+	 * streams which reach cutoff threshold, as we can reasonably assume that
+	 * they are likely be continued after thread is rescheduled to another CPU.
+	 */
+	cfg->seq_cutoff_promote_on_threshold = true;
+
+	init_completion(&add_context.cmpl);
+	add_context.core = core;
+	add_context.result = &result;
+
+	ocf_mngt_cache_add_core(cache, cfg, _cache_mngt_add_core_complete,
+			&add_context);
+	wait_for_completion(&add_context.cmpl);
 
-	return cas_create_queue_thread(q, name, cpu);
+	return result;
 }
-int cas_init_porter_queue_thread(ocf_cache_t cache, ocf_queue_t q, int cpu)
+
+/* Roll back addition of core whose exported object couldn't be set up */
+static void _cache_mngt_remove_added_core(ocf_core_t core)
 {
-	const char *cache_num = ocf_cache_get_name(cache) + 5;
-	char name[48] = {};
-	snprintf(name, sizeof(name), "cas_porter_%s", cache_num);
+	struct _cache_mngt_sync_context remove_context;
+	int result;
 
-	return cas_create_queue_thread(q, name, cpu);
+	init_completion(&remove_context.cmpl);
+	remove_context.result = &result;
+	ocf_mngt_cache_remove_core(core, _cache_mngt_generic_complete,
+			&remove_context);
+	wait_for_completion(&remove_context.cmpl);
 }
-static int _cache_mngt_start_queues(ocf_cache_t cache)
-{
-	uint32_t cpus_no = num_online_cpus();
-	struct cache_priv *cache_priv;
-	int result, i;
 
-	cache_priv = ocf_cache_get_priv(cache);
+int cache_mngt_add_core_to_cache(const char *cache_name, size_t name_len,
+		struct ocf_mngt_core_config *cfg,
+		struct kcas_insert_core *cmd_info)
+{
+	ocf_cache_t cache;
+	ocf_core_t core;
+	ocf_core_id_t core_id;
+	int result;
+	struct ocf_volume_uuid uuid = {};
+	struct cache_priv *cache_priv = NULL;
+	struct cas_fs_meta *map;
 
-	for (i = 0; i < cpus_no; i++) {
-		result = ocf_queue_create(cache, &cache_priv->queues[i].worker_queue,
-				&queue_ops);
-		if (result)
-			goto err_worker_queue;
+	result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name,
+					name_len, &cache);
+	if (cfg->try_add && (result == -OCF_ERR_CACHE_NOT_EXIST)) {
+		uuid.copy = true;
+		uuid.data = env_strdup(cfg->uuid.data, MAX_STR_LEN);
+		uuid.size = strnlen(cfg->uuid.data, MAX_STR_LEN) + 1;
 
-		result = cas_init_io_queue_thread(cache, cache_priv->queues[i].worker_queue, i);
+		result = ocf_mngt_core_pool_add(cas_ctx, &uuid,
+				cfg->volume_type);
 		if (result) {
-			ocf_queue_put(cache_priv->queues[i].worker_queue);
-			goto err_worker_queue;
+			env_free(uuid.data);
+			cmd_info->ext_err_code =
+					-OCF_ERR_CANNOT_ADD_CORE_TO_POOL;
+			printk(KERN_ERR OCF_PREFIX_SHORT
+					"Error occurred during"
+					" adding core to detached core pool\n");
+		} else {
+			_cache_mngt_core_pool_index_add(uuid.data);
+			printk(KERN_INFO OCF_PREFIX_SHORT
+					"Successfully added"
+					" core to core pool\n");
 		}
+		return result;
+	} else if (result) {
+		return result;
 	}
 
-	for (i = 0; i < cpus_no; i++) {
-		result = ocf_queue_create(cache, &cache_priv->queues[i].porter_queue,
-				&queue_ops);
-		if (result)
-			goto err_porter_queue;
+	result = _cache_mngt_lock_sync(cache);
+	if (result) {
+		ocf_mngt_cache_put(cache);
+		return result;
+	}
 
-		result = cas_init_porter_queue_thread(cache, cache_priv->queues[i].porter_queue, i);
-		if (result) {
-			ocf_queue_put(cache_priv->queues[i].porter_queue);
-			goto err_porter_queue;
-		}
+	if (cmd_info && cmd_info->update_path) {
+		result = cache_mngt_update_core_uuid(cache, cfg->name,
+						OCF_CORE_NAME_SIZE, &cfg->uuid);
+		ocf_mngt_cache_unlock(cache);
+		ocf_mngt_cache_put(cache);
+		return result;
 	}
 
-	result = ocf_queue_create_mngt(cache, &cache_priv->mngt_queue,
-			&queue_ops);
+	result = core_id_from_name(&core_id, cfg->name);
 	if (result)
-		goto err_porter_queue;
+		goto error_affter_lock;
+	if (cmd_info->fs_meta_dict.length && cmd_info->fs_meta_dict.data) {
+		cache_priv = ocf_cache_get_priv(cache);
+		if (!rcu_access_pointer(cache_priv->fs_meta[core_id])) {
+			map = _cache_mngt_fs_meta_from_user(
+					&cmd_info->fs_meta_dict);
+			if (IS_ERR(map)) {
+				result = PTR_ERR(map);
+				goto error_affter_lock;
+			}
+			rcu_assign_pointer(cache_priv->fs_meta[core_id], map);
+		}
+	}
 
-	result = cas_init_mngt_queue_thread(cache, cache_priv->mngt_queue, CAS_CPUS_ALL);
-	if (result) {
-		goto err_mngt_queue;
+	result = _cache_mngt_add_core(cache, cfg, cmd_info, core_id, &core);
+#if 0
+	if (result == -OCF_ERR_CORE_UUID_EXISTS) {
+		cmd_info->core_id = ocf_core_get_id(core);
 	}
+#endif
+	if (result)
+		goto error_affter_lock;
 
-	return 0;
+	result = kcas_core_create_exported_object(core);
+	if (result)
+		goto error_after_add_core;
 
-err_mngt_queue:
-	ocf_queue_put(cache_priv->mngt_queue);
-	cache_priv->mngt_queue = NULL;
-	i = cpus_no;
-err_porter_queue:
-	while (--i >= 0)
-		ocf_queue_put(cache_priv->queues[i].porter_queue);
-	i = cpus_no;
-err_worker_queue:
-	while (--i >= 0) {
-		ocf_queue_put(cache_priv->queues[i].worker_queue);
-	}
+	result = core_id_from_name(&core_id, cfg->name);
+	if (result)
+		goto error_after_create_exported_object;
 
-	return result;
-}
+	mark_core_id_used(cache, core_id);
 
-static void init_instance_complete(struct _cache_mngt_attach_context *ctx,
-		ocf_cache_t cache)
-{
-	ocf_volume_t cache_obj;
-	struct bd_object *bd_cache_obj;
-	struct block_device *bdev;
+	ocf_mngt_cache_unlock(cache);
+	ocf_mngt_cache_put(cache);
 
-	cache_obj = ocf_cache_get_volume(cache);
-	BUG_ON(!cache_obj);
+	_cache_mngt_log_core_device_path(core);
 
-	bd_cache_obj = bd_object(cache_obj);
-	bdev = bd_cache_obj->btm_bd;
+	return 0;
 
-	/* If we deal with whole device, reread partitions */
-	if (cas_bdev_whole(bdev) == bdev)
-		cas_reread_partitions(bdev);
+error_after_create_exported_object:
+	kcas_core_destroy_exported_object(core);
+
+error_after_add_core:
+	_cache_mngt_remove_added_core(core);
+
+error_affter_lock:
+	ocf_mngt_cache_unlock(cache);
+	ocf_mngt_cache_put(cache);
 
+	return result;
 }
 
-static void calculate_min_ram_size(ocf_cache_t cache,
-		struct _cache_mngt_attach_context *ctx)
+static int _cache_mngt_remove_core_flush(ocf_cache_t cache,
+		struct kcas_remove_core *cmd)
 {
-	uint64_t volume_size;
-	int result;
+	int result = 0;
+	ocf_core_t core;
+	bool core_active;
 
-	ctx->min_free_ram = 0;
+	if (cmd->force_no_flush)
+		return 0;
 
-	result = cache_mngt_create_cache_device_cfg(&ctx->device_cfg,
-			ctx->cache_path);
+	/* Getting cache for the second time is workaround to make flush error
+	   handling easier and avoid dealing with synchronizing issues */
+	result = ocf_mngt_cache_get(cache);
 	if (result)
-			goto end;
+		return result;
 
-	result = ocf_volume_open(ctx->device_cfg.volume,
-			ctx->device_cfg.volume_params);
+	result = _cache_mngt_read_lock_sync(cache);
 	if (result)
-		goto destroy_config;
+		goto put;
 
-	volume_size = ocf_volume_get_length(ctx->device_cfg.volume);
-	ctx->min_free_ram = ocf_mngt_get_ram_needed(cache, volume_size);
-	ocf_volume_close(ctx->device_cfg.volume);
+	result = get_core_by_id(cache, cmd->core_id, &core);
+	if (result < 0)
+		goto unlock;
 
-destroy_config:
-	cache_mngt_destroy_cache_device_cfg(&ctx->device_cfg);
-end:
-	if (result)
-		printk(KERN_WARNING "Cannot calculate amount of DRAM needed\n");
-}
+	core_active = (ocf_core_get_state(core) == ocf_core_state_active);
 
-static void _cache_mngt_attach_complete(ocf_cache_t cache, void *priv,
-		int error)
-{
-	struct _cache_mngt_attach_context *ctx = priv;
-	int caller_status;
-	char *path;
-
-	cache_mngt_destroy_cache_device_cfg(&ctx->device_cfg);
+	if (!core_active) {
+		result = -OCF_ERR_CORE_IN_INACTIVE_STATE;
+		goto unlock;
+	}
 
-	if (!error) {
-		path = (char *)ocf_volume_get_uuid(ocf_cache_get_volume(
-					cache))->data;
-		printk(KERN_INFO "Succsessfully attached %s\n", path);
+	if (!ocf_mngt_core_is_dirty(core)) {
+		result = 0;
+		goto unlock;
 	}
 
-	caller_status = _cache_mngt_async_callee_set_result(&ctx->async, error);
-	if (caller_status != -KCAS_ERR_WAITING_INTERRUPTED)
-		return;
+	return _cache_mngt_core_flush_sync(core, true, 0,
+				_cache_read_unlock_put_cmpl);
 
-	kfree(ctx);
-	ocf_mngt_cache_unlock(cache);
+unlock:
+	ocf_mngt_cache_read_unlock(cache);
+put:
 	ocf_mngt_cache_put(cache);
+	return result;
 }
 
-static void _cache_mngt_start_complete(ocf_cache_t cache, void *priv, int error)
+static void _cache_mngt_generic_complete(void *priv, int error)
 {
-	struct _cache_mngt_attach_context *ctx = priv;
-	int caller_status;
-
-	cache_mngt_destroy_cache_device_cfg(&ctx->device_cfg);
-
-	if (error == -OCF_ERR_NO_FREE_RAM)
-		calculate_min_ram_size(cache, ctx);
+	struct _cache_mngt_sync_context *context = priv;
 
-	caller_status =_cache_mngt_async_callee_set_result(&ctx->async, error);
-	if (caller_status == -KCAS_ERR_WAITING_INTERRUPTED) {
-		/* Attach/load was interrupted. Rollback asynchronously. */
-		if (!error) {
-			printk(KERN_WARNING "Cache added successfully, "
-					"but waiting interrupted. Rollback\n");
-		}
-		ctx->ocf_start_error = error;
-		ocf_mngt_cache_stop(cache,
-				_cache_mngt_cache_stop_rollback_complete, ctx);
-	}
+	*context->result = error;
+	complete(&context->cmpl);
 }
 
-static int _cache_mngt_cache_priv_init(ocf_cache_t cache)
+static void _cache_mngt_remove_core_fallback(ocf_cache_t cache, ocf_core_t core)
 {
-	struct cache_priv *cache_priv;
-	uint32_t cpus_no = num_online_cpus();
+	struct _cache_mngt_sync_context context;
+	int result;
 
-	cache_priv = vzalloc(sizeof(*cache_priv) +
-			cpus_no * sizeof(*cache_priv->queues));
-	if (!cache_priv)
-		return -ENOMEM;
+	printk(KERN_ERR "Removing core failed. Detaching %s.%s\n",
+			ocf_cache_get_name(cache),
+			ocf_core_get_name(core));
 
-	cache_priv->stop_context =
-		env_malloc(sizeof(*cache_priv->stop_context), GFP_KERNEL);
-	if (!cache_priv->stop_context) {
-		vfree(cache_priv);
-		return -ENOMEM;
-	}
+	init_completion(&context.cmpl);
+	context.result = &result;
 
-	atomic_set(&cache_priv->flush_interrupt_enabled, 1);
+	ocf_mngt_cache_detach_core(core,
+			_cache_mngt_generic_complete, &context);
 
-	ocf_cache_set_priv(cache, cache_priv);
+	wait_for_completion(&context.cmpl);
 
-	return 0;
+	if (!result)
+		return;
+
+	printk(KERN_ERR "Detaching %s.%s\n failed. Please retry the remove operation",
+			ocf_cache_get_name(cache),
+			ocf_core_get_name(core));
 }
 
-struct cache_mngt_probe_metadata_context {
-	struct completion cmpl;
-	char *cache_name;
-	int *result;
+static int _cache_mngt_remove_core_prepare(ocf_cache_t cache, ocf_core_t core,
+		struct kcas_remove_core *cmd)
+{
+	int result = 0;
+	bool core_active;
 
-	char *cache_name_meta;
-	ocf_cache_mode_t *cache_mode_meta;
-	ocf_cache_line_size_t *cache_line_size_meta;
-};
+	core_active = ocf_core_get_state(core) == ocf_core_state_active;
 
-static void cache_mngt_probe_metadata_end(void *priv, int error,
-		struct ocf_metadata_probe_status *status)
-{
-	struct cache_mngt_probe_metadata_context *context = priv;
+	if (!core_active)
+		return -OCF_ERR_CORE_IN_INACTIVE_STATE;
 
-	*context->result = error;
+	result = kcas_core_destroy_exported_object(core);
+	if (result)
+		return result;
 
-	if (error == -OCF_ERR_NO_METADATA) {
-		printk(KERN_ERR "No cache metadata found!\n");
-		goto err;
-	} else if (error == -OCF_ERR_METADATA_VER) {
-		printk(KERN_ERR "Cache metadata version mismatch\n");
-		goto err;
-	} else if (error) {
-		printk(KERN_ERR "Failed to load cache metadata!\n");
-		goto err;
-	}
+	if (cmd->force_no_flush)
+		return 0;
 
-	strscpy(context->cache_name_meta, status->cache_name,
-			OCF_CACHE_NAME_SIZE);
-	*(context->cache_mode_meta) = status->cache_mode;
-	*(context->cache_line_size_meta) = status->cache_line_size;
-err:
-	complete(&context->cmpl);
+	result = _cache_mngt_core_flush_uninterruptible(core);
+
+	if (!result)
+		return 0;
+
+	_cache_mngt_remove_core_fallback(cache, core);
+
+	return -KCAS_ERR_DETACHED;
 }
 
-static int _cache_mngt_probe_metadata(char *cache_path_name,
-		char *cache_name_meta, ocf_cache_mode_t *cache_mode_meta,
-		ocf_cache_line_size_t *cache_line_size_meta)
+int cache_mngt_remove_core_from_cache(struct kcas_remove_core *cmd)
 {
-	struct cache_mngt_probe_metadata_context context;
-	cas_bdev_handle_t bdev_handle;
-	struct block_device *bdev;
-	ocf_volume_t volume;
-	char holder[] = "CAS CHECK METADATA\n";
+	struct _cache_mngt_sync_context context;
 	int result;
+	ocf_cache_t cache;
+	ocf_core_t core;
+	struct cache_priv *cache_priv = NULL;
 
-	bdev_handle = cas_bdev_open_by_path(cache_path_name,
-			(CAS_BLK_MODE_EXCL | CAS_BLK_MODE_READ), holder);
-	if (IS_ERR(bdev_handle)) {
-		return (PTR_ERR(bdev_handle) == -EBUSY) ?
-				-OCF_ERR_NOT_OPEN_EXC :
-				-OCF_ERR_INVAL_VOLUME_TYPE;
-	}
-	bdev = cas_bdev_get_from_handle(bdev_handle);
+	result = mngt_get_cache_by_id(cas_ctx, cmd->cache_id, &cache);
+	if (result)
+		return result;
 
-	result = cas_blk_open_volume_by_bdev(&volume, bdev);
+	result = _cache_mngt_remove_core_flush(cache, cmd);
 	if (result)
-		goto out_bdev;
+		goto put;
 
-	init_completion(&context.cmpl);
-	context.result = &result;
-	context.cache_name_meta = cache_name_meta;
-	context.cache_mode_meta = cache_mode_meta;
-	context.cache_line_size_meta = cache_line_size_meta;
+	result = _cache_mngt_lock_sync(cache);
+	if (result)
+		goto put;
 
-	ocf_metadata_probe(cas_ctx, volume, cache_mngt_probe_metadata_end,
-			&context);
-	wait_for_completion(&context.cmpl);
+	result = get_core_by_id(cache, cmd->core_id, &core);
+	if (result < 0) {
+		goto unlock;
+	}
 
-	cas_blk_close_volume(volume);
-out_bdev:
-	cas_bdev_release(bdev_handle,
-			(CAS_BLK_MODE_EXCL | CAS_BLK_MODE_READ), holder);
-	return result;
-}
+	/* Before prepare, which detaches core if flushing it fails */
+	_cache_mngt_seq_absorb_drop_core(cache, core);
 
-static void volume_set_no_merges_flag_helper(ocf_cache_t cache)
-{
-	struct request_queue *cache_q;
-	struct bd_object *bvol;
-	struct block_device *bd;
-	ocf_volume_t volume;
+	result = _cache_mngt_remove_core_prepare(cache, core, cmd);
+	if (result)
+		goto unlock;
 
-	volume = ocf_cache_get_volume(cache);
-	if (!volume)
-		return;
+	cas_prefetch_cancel(cache, cmd->core_id);
 
-	bvol = bd_object(volume);
-	bd = cas_disk_get_blkdev(bvol->dsk);
-	cache_q = bd->bd_disk->queue;
+	init_completion(&context.cmpl);
+	context.result = &result;
 
-	cas_cache_set_no_merges_flag(cache_q);
-}
+	if (cmd->detach) {
+		ocf_mngt_cache_detach_core(core,
+				_cache_mngt_generic_complete, &context);
+	} else {
+		ocf_mngt_cache_remove_core(core,
+				_cache_mngt_generic_complete, &context);
+	}
 
-static void _cache_save_device_properties(ocf_cache_t cache)
-{
-	struct block_device *bd;
-	struct bd_object *bvol;
-	struct request_queue *cache_q;
-	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	wait_for_completion(&context.cmpl);
 
-	bvol = bd_object(ocf_cache_get_volume(cache));
-	bd = cas_disk_get_blkdev(bvol->dsk);
-	cache_q = bd->bd_disk->queue;
+	if (result != -OCF_ERR_CORE_NOT_REMOVED && !cmd->detach) {
+		mark_core_id_free(cache, cmd->core_id);
+		cache_priv = ocf_cache_get_priv(cache);
+		_cache_mngt_fs_meta_learn_drop(cache_priv, cmd->core_id);
+		_cache_mngt_fs_meta_replace(cache_priv, cmd->core_id, NULL);
+		_cache_mngt_stats_snapshot_drop(cache_priv, cmd->core_id);
+	}
 
-	cache_priv->device_properties.queue_limits = cache_q->limits;
-	cache_priv->device_properties.flush =
-				CAS_CHECK_QUEUE_FLUSH(cache_q);
-	cache_priv->device_properties.fua =
-				CAS_CHECK_QUEUE_FUA(cache_q);
+unlock:
+	ocf_mngt_cache_unlock(cache);
+put:
+	ocf_mngt_cache_put(cache);
+	return result;
 }
 
-static int _cache_start_finalize(ocf_cache_t cache, int init_mode,
-		bool activate)
+int cache_mngt_update_fs_meta(struct kcas_update_fs_meta *cmd)
 {
-	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
-	struct _cache_mngt_attach_context *ctx = cache_priv->attach_context;
+	const struct fs_meta_lba *extents = cmd->fs_meta_dict.data;
+	uint32_t count = cmd->fs_meta_dict.length / sizeof(*extents);
+	struct cas_fs_meta *old, *map;
+	struct cache_priv *cache_priv;
+	ocf_cache_t cache;
+	ocf_core_t core;
 	int result;
 
-	_cache_mngt_log_cache_device_path(cache, ctx->cache_path);
+	result = mngt_get_cache_by_id(cas_ctx, cmd->cache_id, &cache);
+	if (result)
+		return result;
 
-	if (activate || (init_mode != CACHE_INIT_STANDBY_NEW &&
-			init_mode != CACHE_INIT_STANDBY_LOAD)) {
-		result = cas_cls_init(cache);
-		if (result) {
-			ctx->ocf_start_error = result;
-			return result;
-		}
-		ctx->cls_inited = true;
+	/* Serializes with other updates and core add/removal */
+	result = _cache_mngt_lock_sync(cache);
+	if (result)
+		goto put;
 
-		volume_set_no_merges_flag_helper(cache);
+	result = get_core_by_id(cache, cmd->core_id, &core);
+	if (result < 0)
+		goto unlock;
 
-		_cache_save_device_properties(cache);
+	cache_priv = ocf_cache_get_priv(cache);
+	old = rcu_dereference_protected(cache_priv->fs_meta[cmd->core_id],
+			true);
+
+	if (cmd->remove) {
+		if (!old)
+			goto unlock;
+		map = _cache_mngt_fs_meta_subtract(old, extents, count);
+	} else {
+		map = _cache_mngt_fs_meta_build(old, extents, count);
+	}
+
+	if (IS_ERR(map)) {
+		result = PTR_ERR(map);
+		goto unlock;
+	}
+
+	_cache_mngt_fs_meta_replace(cache_priv, cmd->core_id, map);
+
+unlock:
+	ocf_mngt_cache_unlock(cache);
+put:
+	ocf_mngt_cache_put(cache);
+	return result;
+}
+
+int cache_mngt_remove_inactive_core(struct kcas_remove_inactive *cmd)
+{
+	struct _cache_mngt_sync_context context;
+	int result = 0;
+	ocf_cache_t cache;
+	ocf_core_t core;
+	struct cache_priv *cache_priv = NULL;
+
+	result = mngt_get_cache_by_id(cas_ctx, cmd->cache_id, &cache);
+	if (result)
+		return result;
+
+	result = _cache_mngt_lock_sync(cache);
+	if (result)
+		goto put;
+
+	result = get_core_by_id(cache, cmd->core_id, &core);
+	if (result < 0) {
+		goto unlock;
+	}
+
+	result = (ocf_core_get_state(core) == ocf_core_state_active);
+	if (result) {
+		result = -KCAS_ERR_CORE_IN_ACTIVE_STATE;
+		goto unlock;
+	}
+
+	if (ocf_mngt_core_is_dirty(core) && !cmd->force) {
+		result = -KCAS_ERR_INACTIVE_CORE_IS_DIRTY;
+		goto unlock;
+	}
+
+	/*
+	 * Destroy exported object - in case of error during destruction of
+	 * exported object, instead of trying rolling this back we rather
+	 * inform user about error.
+	 */
+	result = kcas_core_destroy_exported_object(core);
+	if (result)
+		goto unlock;
+
+	cas_prefetch_cancel(cache, cmd->core_id);
+	_cache_mngt_seq_absorb_drop_core(cache, core);
+
+	init_completion(&context.cmpl);
+	context.result = &result;
+
+	ocf_mngt_cache_remove_core(core, _cache_mngt_generic_complete,
+			&context);
+
+	wait_for_completion(&context.cmpl);
+
+	if (!result) {
+		mark_core_id_free(cache, cmd->core_id);
+		cache_priv = ocf_cache_get_priv(cache);
+		_cache_mngt_fs_meta_learn_drop(cache_priv, cmd->core_id);
+		_cache_mngt_fs_meta_replace(cache_priv, cmd->core_id, NULL);
+		_cache_mngt_stats_snapshot_drop(cache_priv, cmd->core_id);
+	}
+
+unlock:
+	ocf_mngt_cache_unlock(cache);
+put:
+	ocf_mngt_cache_put(cache);
+	return result;
+}
+
+int cache_mngt_reset_stats(const char *cache_name, size_t cache_name_len,
+				const char *core_name, size_t core_name_len)
+{
+	ocf_cache_t cache;
+	ocf_core_t core;
+	int result = 0;
+
+	result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name, cache_name_len,
+						&cache);
+	if (result)
+		return result;
+
+	result = _cache_mngt_lock_sync(cache);
+	if (result) {
+		ocf_mngt_cache_put(cache);
+		return result;
+	}
+
+	if (core_name) {
+		result = ocf_core_get_by_name(cache, core_name,
+					core_name_len, &core);
+		if (result)
+			goto out;
+
+		ocf_core_stats_initialize(core);
+	} else {
+		result = ocf_core_stats_initialize_all(cache);
+	}
+
+out:
+	ocf_mngt_cache_unlock(cache);
+	ocf_mngt_cache_put(cache);
+	return result;
+}
+
+static inline void io_class_info2cfg(ocf_part_id_t part_id,
+		struct ocf_io_class_info *info, struct ocf_mngt_io_class_config *cfg)
+{
+	cfg->class_id = part_id;
+	cfg->name = info->name;
+	cfg->prio = info->priority;
+	cfg->cache_mode = info->cache_mode;
+	cfg->max_size = info->max_size;
+}
+
+/* Validate sequential cutoff overrides, @any is set if there is one */
+static int _cache_mngt_check_seq_cutoff_overrides(struct kcas_io_classes *cfg,
+		bool *any)
+{
+	ocf_part_id_t class_id;
+	uint32_t threshold;
+
+	*any = false;
+
+	for (class_id = 0; class_id < OCF_USER_IO_CLASS_MAX; class_id++) {
+		threshold = cfg->seq_cutoff_threshold[class_id];
+		if (!threshold)
+			continue;
+
+		if (class_id == KCAS_IO_CLASS_BYPASS)
+			return -KCAS_ERR_IO_CLASS_RESERVED;
+
+		if (!cfg->info[class_id].name[0] ||
+				threshold > OCF_SEQ_CUTOFF_MAX_THRESHOLD / KiB) {
+			return -OCF_ERR_INVAL;
+		}
+
+		*any = true;
+	}
+
+	return 0;
+}
+
+/* Requests kept out of cache by CAS are handled in pass-through */
+static void _cache_mngt_bypass_class_info(struct ocf_io_class_info *info)
+{
+	*info = (struct ocf_io_class_info) {
+		.name = KCAS_IO_CLASS_BYPASS_NAME,
+		.priority = OCF_IO_CLASS_PRIO_LOWEST,
+		.cache_mode = ocf_cache_mode_pt,
+		.min_size = 0,
+		.max_size = 0,
+	};
+}
+
+/* Add bypass class to current io classes, called under cache lock */
+static int _cache_mngt_add_bypass_class(ocf_cache_t cache)
+{
+	struct ocf_mngt_io_classes_config *io_class_cfg;
+	struct ocf_io_class_info *info;
+	ocf_part_id_t class_id;
+	int result = 0;
+
+	io_class_cfg = kzalloc(sizeof(struct ocf_mngt_io_class_config) *
+			OCF_USER_IO_CLASS_MAX, GFP_KERNEL);
+	info = kcalloc(OCF_USER_IO_CLASS_MAX, sizeof(*info), GFP_KERNEL);
+	if (!io_class_cfg || !info) {
+		result = -OCF_ERR_NO_MEM;
+		goto out;
+	}
+
+	for (class_id = 0; class_id < OCF_USER_IO_CLASS_MAX; class_id++) {
+		io_class_cfg->config[class_id].class_id = class_id;
+
+		result = ocf_cache_io_class_get_info(cache, class_id,
+				&info[class_id]);
+		if (result == -OCF_ERR_IO_CLASS_NOT_EXIST) {
+			info[class_id].name[0] = '\0';
+			result = 0;
+			continue;
+		}
+		if (result)
+			goto out;
+
+		io_class_info2cfg(class_id, &info[class_id],
+				&io_class_cfg->config[class_id]);
+	}
+
+	if (info[KCAS_IO_CLASS_BYPASS].name[0]) {
+		if (strncmp(info[KCAS_IO_CLASS_BYPASS].name,
+				KCAS_IO_CLASS_BYPASS_NAME,
+				OCF_IO_CLASS_NAME_MAX)) {
+			result = -KCAS_ERR_IO_CLASS_RESERVED;
+		}
+		goto out;
+	}
+
+	_cache_mngt_bypass_class_info(&info[KCAS_IO_CLASS_BYPASS]);
+	io_class_info2cfg(KCAS_IO_CLASS_BYPASS, &info[KCAS_IO_CLASS_BYPASS],
+			&io_class_cfg->config[KCAS_IO_CLASS_BYPASS]);
+
+	result = ocf_mngt_cache_io_classes_configure(cache, io_class_cfg);
+	if (result == -OCF_ERR_IO_CLASS_NOT_EXIST)
+		result = 0;
+
+out:
+	kfree(info);
+	kfree(io_class_cfg);
+	return result;
+}
+
+int cache_mngt_set_partitions(const char *cache_name, size_t name_len,
+		struct kcas_io_classes *cfg)
+{
+	ocf_cache_t cache;
+	struct cache_priv *cache_priv;
+	struct ocf_mngt_io_classes_config *io_class_cfg;
+	struct cas_cls_rule *cls_rule[OCF_USER_IO_CLASS_MAX] = {};
+	ocf_part_id_t class_id;
+	bool seq_cutoff;
+	uint64_t keep = 0;
+	int result;
+
+	result = _cache_mngt_check_seq_cutoff_overrides(cfg, &seq_cutoff);
+	if (result)
+		return result;
+
+	io_class_cfg = kzalloc(sizeof(struct ocf_mngt_io_class_config) *
+			OCF_USER_IO_CLASS_MAX, GFP_KERNEL);
+	if (!io_class_cfg)
+		return -OCF_ERR_NO_MEM;
+
+	for (class_id = 0; class_id < OCF_USER_IO_CLASS_MAX; class_id++) {
+		io_class_cfg->config[class_id].class_id = class_id;
+
+		if (!cfg->info[class_id].name[0]) {
+			io_class_cfg->config[class_id].class_id = class_id;
+			continue;
+		}
+
+		io_class_info2cfg(class_id, &cfg->info[class_id],
+				&io_class_cfg->config[class_id]);
+	}
+
+	result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name,
+					name_len, &cache);
+	if (result)
+		goto out_get;
+
+	if (ocf_cache_is_standby(cache)) {
+		result = -OCF_ERR_CACHE_STANDBY;
+		goto out_not_running;
+	}
+
+	if (!ocf_cache_is_device_attached(cache)) {
+		result = -OCF_ERR_CACHE_DETACHED;
+		goto out_not_running;
+	}
+
+	/* Unchanged rules keep their state, e.g. resolved directories */
+	for (class_id = 0; class_id < OCF_USER_IO_CLASS_MAX; class_id++) {
+		if (cas_cls_rule_unchanged(cache, class_id,
+				cfg->info[class_id].name)) {
+			keep |= 1ULL << class_id;
+			continue;
+		}
+
+		result = cas_cls_rule_create(cache, class_id,
+				cfg->info[class_id].name,
+				&cls_rule[class_id]);
+		if (result)
+			goto out_cls;
+	}
+
+	result = _cache_mngt_lock_sync(cache);
+	if (result)
+		goto out_cls;
+
+	/* Bypass class has no rule, requests are moved there by CAS only */
+	cache_priv = ocf_cache_get_priv(cache);
+	if (seq_cutoff || rcu_access_pointer(cache_priv->tinylfu)) {
+		if (cfg->info[KCAS_IO_CLASS_BYPASS].name[0]) {
+			result = -KCAS_ERR_IO_CLASS_RESERVED;
+			goto out_configure;
+		}
+		_cache_mngt_bypass_class_info(&cfg->info[KCAS_IO_CLASS_BYPASS]);
+		io_class_info2cfg(KCAS_IO_CLASS_BYPASS,
+				&cfg->info[KCAS_IO_CLASS_BYPASS],
+				&io_class_cfg->config[KCAS_IO_CLASS_BYPASS]);
+	}
+
+	result = ocf_mngt_cache_io_classes_configure(cache, io_class_cfg);
+	if (result == -OCF_ERR_IO_CLASS_NOT_EXIST)
+		result = 0;
+	if(result)
+		goto out_configure;
+
+	result = _cache_mngt_save_sync(cache);
+	if (result)
+		goto out_configure;
+
+	cas_cls_rules_apply(cache, cls_rule, keep);
+
+	for (class_id = 0; class_id < OCF_USER_IO_CLASS_MAX; class_id++) {
+		WRITE_ONCE(cache_priv->seq_cutoff_threshold[class_id],
+				(uint64_t)cfg->seq_cutoff_threshold[class_id] *
+				(KiB >> SECTOR_SHIFT));
+		cache_priv->prio_adapt.prio[class_id] =
+				cfg->info[class_id].priority;
+	}
+	/* Adapting starts over from priorities of new configuration */
+	cache_priv->prio_adapt.primed = false;
+
+out_configure:
+	ocf_mngt_cache_unlock(cache);
+out_cls:
+	if (result) {
+		while (class_id--)
+			cas_cls_rule_destroy(cache, cls_rule[class_id]);
+	}
+out_not_running:
+	ocf_mngt_cache_put(cache);
+out_get:
+	kfree(io_class_cfg);
+	return result;
+}
+
+/* Period of adaptive io class priorities updates */
+#define CAS_PRIO_ADAPT_INTERVAL (30 * HZ)
+
+/*
+ * Set priorities of io classes to configured ones shifted by @shift, bypass
+ * class is left as is. Called under cache lock.
+ */
+static int _cache_mngt_prio_adapt_apply(ocf_cache_t cache,
+		const int32_t *shift)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	struct ocf_mngt_io_classes_config *io_class_cfg;
+	struct ocf_io_class_info *info;
+	ocf_part_id_t class_id;
+	int result = 0;
+
+	io_class_cfg = kzalloc(sizeof(struct ocf_mngt_io_class_config) *
+			OCF_USER_IO_CLASS_MAX, GFP_KERNEL);
+	info = kcalloc(OCF_USER_IO_CLASS_MAX, sizeof(*info), GFP_KERNEL);
+	if (!io_class_cfg || !info) {
+		result = -OCF_ERR_NO_MEM;
+		goto out;
+	}
+
+	for (class_id = 0; class_id < OCF_USER_IO_CLASS_MAX; class_id++) {
+		io_class_cfg->config[class_id].class_id = class_id;
+
+		result = ocf_cache_io_class_get_info(cache, class_id,
+				&info[class_id]);
+		if (result == -OCF_ERR_IO_CLASS_NOT_EXIST) {
+			info[class_id].name[0] = '\0';
+			result = 0;
+			continue;
+		}
+		if (result)
+			goto out;
+
+		io_class_info2cfg(class_id, &info[class_id],
+				&io_class_cfg->config[class_id]);
+
+		/* Pinned classes are never evicted, so they stay pinned */
+		if (shift[class_id] == S32_MAX ||
+				cache_priv->prio_adapt.prio[class_id] <
+				OCF_IO_CLASS_PRIO_HIGHEST) {
+			continue;
+		}
+
+		io_class_cfg->config[class_id].prio = clamp_t(int32_t,
+				cache_priv->prio_adapt.prio[class_id] +
+				shift[class_id], OCF_IO_CLASS_PRIO_HIGHEST,
+				OCF_IO_CLASS_PRIO_LOWEST);
+	}
+
+	result = ocf_mngt_cache_io_classes_configure(cache, io_class_cfg);
+	if (result == -OCF_ERR_IO_CLASS_NOT_EXIST)
+		result = 0;
+
+out:
+	kfree(info);
+	kfree(io_class_cfg);
+	return result;
+}
+
+/*
+ * Reuse of io class is its hits over interval per line it occupies. Classes
+ * reused more than average of all classes get priority raised, the ones
+ * reused less get it lowered, proportionally to distance from average, so
+ * that the most distant class is shifted by the bound.
+ */
+static void _cache_mngt_prio_adapt_update(ocf_cache_t cache)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	int32_t bound = cache_priv->prio_adapt.bound;
+	int32_t shift[OCF_USER_IO_CLASS_MAX];
+	int64_t reuse[OCF_USER_IO_CLASS_MAX];
+	int64_t mean = 0, deviation = 0;
+	struct ocf_stats_usage usage;
+	struct ocf_stats_requests req;
+	struct ocf_stats_blocks blocks;
+	struct ocf_io_class_info info;
+	ocf_part_id_t class_id;
+	uint32_t count = 0;
+	uint64_t hits;
+
+	if (!ocf_cache_is_device_attached(cache))
+		return;
+
+	for (class_id = 0; class_id < OCF_USER_IO_CLASS_MAX; class_id++) {
+		shift[class_id] = S32_MAX;
+
+		if (ocf_cache_io_class_get_info(cache, class_id, &info))
+			continue;
+
+		/* Bypass class holds no lines and pinned ones aren't evicted */
+		if (info.cache_mode == ocf_cache_mode_pt || !info.max_size ||
+				info.priority < OCF_IO_CLASS_PRIO_HIGHEST) {
+			continue;
+		}
+
+		if (ocf_stats_collect_part_cache(cache, class_id, &usage, &req,
+				&blocks)) {
+			continue;
+		}
+
+		hits = _cache_mngt_nhit_adapt_delta(
+				&cache_priv->prio_adapt.hits[class_id],
+				req.rd_hits.value + req.wr_hits.value);
+		reuse[class_id] = div64_u64(hits * 1000,
+				max_t(uint64_t, usage.occupancy.value, 1));
+		shift[class_id] = 0;
+		mean += reuse[class_id];
+		count++;
+	}
+
+	/* First interval only sets baseline of statistics */
+	if (!cache_priv->prio_adapt.primed) {
+		cache_priv->prio_adapt.primed = true;
+		return;
+	}
+
+	if (count < 2)
+		return;
+
+	mean = div64_s64(mean, count);
+	for (class_id = 0; class_id < OCF_USER_IO_CLASS_MAX; class_id++) {
+		if (shift[class_id] != S32_MAX)
+			deviation = max(deviation, abs(reuse[class_id] - mean));
+	}
+
+	for (class_id = 0; class_id < OCF_USER_IO_CLASS_MAX; class_id++) {
+		if (shift[class_id] == S32_MAX || !deviation)
+			continue;
+
+		/* Lower value is higher priority */
+		shift[class_id] = div64_s64((mean - reuse[class_id]) * bound,
+				deviation);
+	}
+
+	_cache_mngt_prio_adapt_apply(cache, shift);
+}
+
+static void _cache_mngt_prio_adapt_work(struct work_struct *work)
+{
+	struct cache_priv *cache_priv = container_of(to_delayed_work(work),
+			struct cache_priv, prio_adapt.work);
+	ocf_cache_t cache = cache_priv->cache;
+
+	/* Don't wait for management operation, possibly stopping cache */
+	if (ocf_mngt_cache_trylock(cache)) {
+		schedule_delayed_work(&cache_priv->prio_adapt.work,
+				CAS_PRIO_ADAPT_INTERVAL);
+		return;
+	}
+
+	if (cache_priv->prio_adapt.bound) {
+		_cache_mngt_prio_adapt_update(cache);
+		schedule_delayed_work(&cache_priv->prio_adapt.work,
+				CAS_PRIO_ADAPT_INTERVAL);
+	}
+
+	ocf_mngt_cache_unlock(cache);
+}
+
+static void _cache_mngt_prio_adapt_init(struct cache_priv *cache_priv)
+{
+	cache_priv->prio_adapt.bound = 0;
+	INIT_DELAYED_WORK(&cache_priv->prio_adapt.work,
+			_cache_mngt_prio_adapt_work);
+}
+
+/* Called once cache is locked for stopping or has never been started */
+static void _cache_mngt_prio_adapt_stop(struct cache_priv *cache_priv)
+{
+	cancel_delayed_work_sync(&cache_priv->prio_adapt.work);
+}
+
+/**
+ * @brief Set max shift of io class priorities adapted to reuse of classes
+ * @param[in] cache cache to which the change pertains
+ * @param[in] bound max shift of priority from configured one, 0 - priorities
+ * are not adapted and configured ones are restored
+ * @return exit code of successful completion is 0;
+ * nonzero exit code means failure
+ */
+static int cache_mngt_set_prio_adapt(ocf_cache_t cache, uint32_t bound)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	struct ocf_io_class_info info;
+	int32_t shift[OCF_USER_IO_CLASS_MAX];
+	ocf_part_id_t class_id;
+	int result;
+
+	if (bound > OCF_IO_CLASS_PRIO_LOWEST)
+		return -OCF_ERR_INVAL;
+
+	result = _cache_mngt_lock_sync(cache);
+	if (result)
+		return result;
+
+	if (bound && !cache_priv->prio_adapt.bound) {
+		/* Priorities currently set are the configured ones */
+		for (class_id = 0; class_id < OCF_USER_IO_CLASS_MAX; class_id++) {
+			if (!ocf_cache_io_class_get_info(cache, class_id,
+					&info)) {
+				cache_priv->prio_adapt.prio[class_id] =
+						info.priority;
+			}
+		}
+		cache_priv->prio_adapt.primed = false;
+		schedule_delayed_work(&cache_priv->prio_adapt.work,
+				CAS_PRIO_ADAPT_INTERVAL);
+	} else if (!bound && cache_priv->prio_adapt.bound) {
+		for (class_id = 0; class_id < OCF_USER_IO_CLASS_MAX; class_id++)
+			shift[class_id] = 0;
+		shift[KCAS_IO_CLASS_BYPASS] = S32_MAX;
+		result = _cache_mngt_prio_adapt_apply(cache, shift);
+		if (result)
+			goto out;
+	}
+	cache_priv->prio_adapt.bound = bound;
+
+out:
+	ocf_mngt_cache_unlock(cache);
+	return result;
+}
+
+static int cache_mngt_get_prio_adapt(ocf_cache_t cache, uint32_t *bound)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	int result;
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	*bound = cache_priv->prio_adapt.bound;
+
+	ocf_mngt_cache_read_unlock(cache);
+	return 0;
+}
+
+/* Called with cache locked */
+static void _cache_mngt_trim_stop(struct cache_priv *cache_priv)
+{
+	if (!cache_priv->trim)
+		return;
+
+	cas_cache_trim_destroy(cache_priv->trim);
+	cache_priv->trim = NULL;
+}
+
+/**
+ * @brief Set rate of background discard of unused cache data area
+ * @param[in] cache cache to which the change pertains
+ * @param[in] rate MiB per second, 0 - data area is not discarded
+ * @return exit code of successful completion is 0;
+ * nonzero exit code means failure
+ */
+static int cache_mngt_set_trim_rate(ocf_cache_t cache, uint32_t rate)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	int result;
+
+	if (rate > KCAS_CACHE_TRIM_RATE_MAX)
+		return -OCF_ERR_INVAL;
+
+	result = _cache_mngt_lock_sync(cache);
+	if (result)
+		return result;
+
+	if (!rate) {
+		_cache_mngt_trim_stop(cache_priv);
+		goto out;
+	}
+
+	if (!cache_priv->trim) {
+		if (!ocf_cache_is_device_attached(cache)) {
+			result = -OCF_ERR_INVAL;
+			goto out;
+		}
+
+		cache_priv->trim = cas_cache_trim_create(cache);
+		if (!cache_priv->trim) {
+			result = -OCF_ERR_NO_MEM;
+			goto out;
+		}
+	}
+	cas_cache_trim_set_rate(cache_priv->trim, rate);
+
+out:
+	ocf_mngt_cache_unlock(cache);
+	return result;
+}
+
+static int cache_mngt_get_trim(ocf_cache_t cache, uint32_t *value)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	int result;
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	*value = cache_priv->trim ?
+		cas_cache_trim_get_rate(cache_priv->trim) : 0;
+
+	ocf_mngt_cache_read_unlock(cache);
+	return 0;
+}
+
+/**
+ * @brief Set size of in-memory tier in front of cache
+ * @param[in] cache cache to which the change pertains
+ * @param[in] size MiB, 0 - tier is not used
+ * @return exit code of successful completion is 0;
+ * nonzero exit code means failure
+ */
+static int cache_mngt_set_dram_tier_size(ocf_cache_t cache, uint32_t size)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	struct cas_dram_tier *tier = NULL, *old;
+	int result;
+
+	if (size > KCAS_DRAM_TIER_SIZE_MAX)
+		return -OCF_ERR_INVAL;
+
+	result = _cache_mngt_lock_sync(cache);
+	if (result)
+		return result;
+
+	old = rcu_access_pointer(cache_priv->dram_tier);
+	if (old && cas_dram_tier_get_size(old) == size)
+		goto out;
+
+	/* Resized tier starts empty */
+	if (size) {
+		tier = cas_dram_tier_create(size);
+		if (!tier) {
+			result = -OCF_ERR_NO_MEM;
+			goto out;
+		}
+	}
+
+	rcu_assign_pointer(cache_priv->dram_tier, tier);
+
+out:
+	ocf_mngt_cache_unlock(cache);
+	if (!result && old && old != rcu_access_pointer(cache_priv->dram_tier)) {
+		synchronize_rcu();
+		cas_dram_tier_destroy(old);
+	}
+	return result;
+}
+
+static int cache_mngt_get_dram_tier(ocf_cache_t cache, uint32_t *size)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	struct cas_dram_tier *tier;
+	int result;
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	tier = rcu_access_pointer(cache_priv->dram_tier);
+	*size = tier ? cas_dram_tier_get_size(tier) : 0;
+
+	ocf_mngt_cache_read_unlock(cache);
+	return 0;
+}
+
+/**
+ * @brief Rebuild member of mirrored cache device from the other member
+ * @param[in] cache cache to which the change pertains
+ * @param[in] member index of member to be rebuilt
+ * @return exit code of successful completion is 0;
+ * nonzero exit code means failure
+ */
+static int cache_mngt_set_mirror_rebuild(ocf_cache_t cache, uint32_t member)
+{
+	int result;
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	if (ocf_cache_is_device_attached(cache)) {
+		result = block_dev_mirror_rebuild(ocf_cache_get_volume(cache),
+				member);
+	} else {
+		result = -OCF_ERR_INVAL;
+	}
+
+	ocf_mngt_cache_read_unlock(cache);
+	return result;
+}
+
+static int cache_mngt_get_mirror(ocf_cache_t cache,
+		enum kcas_cache_param_id param_id, uint32_t *value)
+{
+	ocf_volume_t volume;
+	int result;
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	if (!ocf_cache_is_device_attached(cache)) {
+		result = -OCF_ERR_INVAL;
+		goto out;
+	}
+
+	volume = ocf_cache_get_volume(cache);
+	if (param_id == cache_param_get_mirror_member0_state) {
+		result = block_dev_mirror_get_state(volume, 0, value);
+	} else if (param_id == cache_param_get_mirror_member1_state) {
+		result = block_dev_mirror_get_state(volume, 1, value);
+	} else {
+		/* Fails unless cache device is mirrored */
+		result = block_dev_mirror_get_state(volume, 0, value);
+		if (!result)
+			*value = block_dev_mirror_get_rebuild_progress(volume);
+	}
+
+out:
+	ocf_mngt_cache_read_unlock(cache);
+	return result;
+}
+
+/**
+ * @brief Enable or disable compression of data of io class
+ * @param[in] cache cache to which the change pertains
+ * @param[in] io_class io class, OCF_IO_CLASS_INVALID for all of them and
+ *	for data without io class
+ * @param[in] enabled 1 if data is to be compressed
+ * @return exit code of successful completion is 0;
+ * nonzero exit code means failure
+ */
+static int cache_mngt_set_compress(ocf_cache_t cache, uint32_t io_class,
+		uint32_t enabled)
+{
+	struct cas_compress *comp;
+	uint32_t i;
+	int result;
+
+	if (enabled > 1 || (io_class != OCF_IO_CLASS_INVALID &&
+			io_class >= OCF_USER_IO_CLASS_MAX)) {
+		return -OCF_ERR_INVAL;
+	}
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	comp = ocf_cache_is_device_attached(cache) ?
+		bd_object(ocf_cache_get_volume(cache))->comp : NULL;
+	if (!comp) {
+		result = -OCF_ERR_INVAL;
+		goto out;
+	}
+
+	/* Blocks already stored are left as they are until overwritten */
+	if (io_class != OCF_IO_CLASS_INVALID) {
+		cas_compress_set_enabled(comp, io_class, enabled);
+	} else {
+		for (i = 0; i <= CAS_COMPRESS_IO_CLASS_OTHER; i++)
+			cas_compress_set_enabled(comp, i, enabled);
+	}
+
+out:
+	ocf_mngt_cache_read_unlock(cache);
+	return result;
+}
+
+static int cache_mngt_get_compress(ocf_cache_t cache,
+		enum kcas_cache_param_id param_id, uint32_t io_class,
+		uint32_t *value)
+{
+	uint64_t stored = 0, packed = 0, class_stored, class_packed;
+	uint32_t i, first = io_class, last = io_class;
+	struct cas_compress *comp;
+	bool enabled = true;
+	int result;
+
+	if (io_class == OCF_IO_CLASS_INVALID) {
+		first = 0;
+		last = CAS_COMPRESS_IO_CLASS_OTHER;
+	} else if (io_class >= OCF_USER_IO_CLASS_MAX) {
+		return -OCF_ERR_INVAL;
+	}
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	comp = ocf_cache_is_device_attached(cache) ?
+		bd_object(ocf_cache_get_volume(cache))->comp : NULL;
+	if (!comp) {
+		result = -OCF_ERR_INVAL;
+		goto out;
+	}
+
+	for (i = first; i <= last; i++) {
+		enabled &= cas_compress_get_enabled(comp, i);
+		cas_compress_get_stats(comp, i, &class_stored, &class_packed);
+		stored += class_stored;
+		packed += class_packed;
+	}
+
+	switch (param_id) {
+	case cache_param_compress_enabled:
+		/* Whole cache is reported enabled if all io classes are */
+		*value = enabled;
+		break;
+	case cache_param_get_compress_ratio:
+		*value = packed ? div64_u64(stored * 100, packed) : 0;
+		break;
+	default:
+		cas_compress_get_dev_usage(comp, &stored, &packed);
+		*value = packed ? div64_u64(stored * 100, packed) : 0;
+		break;
+	}
+
+out:
+	ocf_mngt_cache_read_unlock(cache);
+	return result;
+}
+
+static int cache_mngt_set_dedup(ocf_cache_t cache, uint32_t enabled)
+{
+	struct cas_compress *comp;
+	int result;
+
+	if (enabled > 1)
+		return -OCF_ERR_INVAL;
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	comp = ocf_cache_is_device_attached(cache) ?
+		bd_object(ocf_cache_get_volume(cache))->comp : NULL;
+	if (comp)
+		cas_compress_set_dedup(comp, enabled);
+	else
+		result = -OCF_ERR_INVAL;
+
+	ocf_mngt_cache_read_unlock(cache);
+	return result;
+}
+
+static int cache_mngt_get_dedup(ocf_cache_t cache, uint32_t *enabled)
+{
+	struct cas_compress *comp;
+	int result;
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	comp = ocf_cache_is_device_attached(cache) ?
+		bd_object(ocf_cache_get_volume(cache))->comp : NULL;
+	if (!comp) {
+		result = -OCF_ERR_INVAL;
+		goto out;
+	}
+
+	*enabled = cas_compress_get_dedup(comp);
+
+out:
+	ocf_mngt_cache_read_unlock(cache);
+	return result;
+}
+
+/**
+ * @brief Enable or disable checksums of data of cache device
+ * @param[in] cache cache to which the change pertains
+ * @param[in] enabled 1 if blocks are to be checksummed
+ * @return exit code of successful completion is 0;
+ * nonzero exit code means failure
+ */
+static int cache_mngt_set_checksum(ocf_cache_t cache, uint32_t enabled)
+{
+	int result;
+
+	if (enabled > 1)
+		return -OCF_ERR_INVAL;
+
+	result = _cache_mngt_lock_sync(cache);
+	if (result)
+		return result;
+
+	if (!ocf_cache_is_device_attached(cache))
+		result = -OCF_ERR_INVAL;
+	else if (enabled)
+		result = block_dev_csum_start(ocf_cache_get_volume(cache));
+	else
+		block_dev_csum_stop(ocf_cache_get_volume(cache));
+
+	ocf_mngt_cache_unlock(cache);
+	return result;
+}
+
+static int cache_mngt_get_checksum(ocf_cache_t cache, uint32_t *enabled)
+{
+	int result;
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	*enabled = ocf_cache_is_device_attached(cache) &&
+		block_dev_csum_enabled(ocf_cache_get_volume(cache));
+
+	ocf_mngt_cache_read_unlock(cache);
+	return 0;
+}
+
+/* Time spent bypassing slow cache device, including bypass in progress */
+static uint64_t _cache_mngt_slow_bypass_ns(struct cache_priv *cache_priv)
+{
+	uint64_t total = atomic64_read(&cache_priv->slow_bypass.total_ns);
+
+	if (atomic_read(&cache_priv->slow_bypass.active)) {
+		total += ktime_get_ns() -
+			READ_ONCE(cache_priv->slow_bypass.since);
+	}
+
+	return total;
+}
+
+static int cache_mngt_set_slow_bypass(ocf_cache_t cache, uint32_t threshold)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	int result;
+
+	if (threshold > KCAS_SLOW_BYPASS_THRESHOLD_MAX)
+		return -OCF_ERR_INVAL;
+
+	result = _cache_mngt_lock_sync(cache);
+	if (result)
+		return result;
+
+	WRITE_ONCE(cache_priv->slow_bypass.threshold, threshold);
+
+	/* Bypass in progress is not checked against threshold anymore */
+	if (!threshold && atomic_cmpxchg(&cache_priv->slow_bypass.active,
+				1, 0)) {
+		atomic64_add(ktime_get_ns() - cache_priv->slow_bypass.since,
+				&cache_priv->slow_bypass.total_ns);
+	}
+
+	ocf_mngt_cache_unlock(cache);
+	return 0;
+}
+
+static int cache_mngt_get_slow_bypass(ocf_cache_t cache,
+		enum kcas_cache_param_id param_id, uint32_t *value)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	int result;
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	switch (param_id) {
+	case cache_param_slow_bypass_threshold:
+		*value = cache_priv->slow_bypass.threshold;
+		break;
+	default:
+		*value = atomic_read(&cache_priv->slow_bypass.active);
+		break;
+	}
+
+	ocf_mngt_cache_read_unlock(cache);
+	return 0;
+}
+
+/**
+ * @brief Set time metadata writes of cache device are coalesced for
+ * @param[in] cache cache to which the change pertains
+ * @param[in] window_us coalescing window in microseconds, 0 - metadata is
+ *	written as it is updated
+ * @return exit code of successful completion is 0;
+ * nonzero exit code means failure
+ */
+static int cache_mngt_set_meta_coalesce(ocf_cache_t cache, uint32_t window_us)
+{
+	struct ocf_cache_info info;
+	ocf_volume_t volume;
+	int result;
+
+	if (window_us > KCAS_META_COALESCE_WINDOW_MAX)
+		return -OCF_ERR_INVAL;
+
+	result = _cache_mngt_lock_sync(cache);
+	if (result)
+		return result;
+
+	if (!ocf_cache_is_device_attached(cache)) {
+		result = -OCF_ERR_INVAL;
+		goto out;
+	}
+
+	volume = ocf_cache_get_volume(cache);
+	if (!window_us) {
+		block_dev_meta_co_stop(volume);
+		goto out;
+	}
+
+	result = ocf_cache_get_info(cache, &info);
+	if (result)
+		goto out;
+
+	/* Metadata end offset is given in 4 KiB blocks */
+	result = block_dev_meta_co_start(volume,
+			(uint64_t)info.metadata_end_offset * 4096, window_us);
+
+out:
+	ocf_mngt_cache_unlock(cache);
+	return result;
+}
+
+static int cache_mngt_get_meta_coalesce(ocf_cache_t cache,
+		uint32_t *window_us)
+{
+	int result;
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	*window_us = ocf_cache_is_device_attached(cache) ?
+		block_dev_meta_co_get_window(ocf_cache_get_volume(cache)) : 0;
+
+	ocf_mngt_cache_read_unlock(cache);
+	return 0;
+}
+
+struct _cache_mngt_exp_obj_create {
+	struct work_struct work;
+	ocf_core_t core;
+	int result;
+};
+
+struct _cache_mngt_exp_obj_create_ctx {
+	struct _cache_mngt_exp_obj_create *creates;
+	uint32_t count;
+};
+
+static void _cache_mngt_create_core_exported_object_work(
+		struct work_struct *work)
+{
+	struct _cache_mngt_exp_obj_create *create = container_of(work,
+			struct _cache_mngt_exp_obj_create, work);
+
+	create->result = kcas_core_create_exported_object(create->core);
+}
+
+static int _cache_mngt_count_core_visitor(ocf_core_t core, void *cntx)
+{
+	(*(uint32_t *)cntx)++;
+
+	return 0;
+}
+
+static int _cache_mngt_create_core_exported_object(ocf_core_t core,
+		void *cntx)
+{
+	struct _cache_mngt_exp_obj_create_ctx *ctx = cntx;
+	struct _cache_mngt_exp_obj_create *create = &ctx->creates[ctx->count++];
+
+	create->core = core;
+	INIT_WORK(&create->work, _cache_mngt_create_core_exported_object_work);
+	queue_work(system_unbound_wq, &create->work);
+
+	return 0;
+}
+
+static int _cache_mngt_destroy_core_exported_object(ocf_core_t core, void *cntx)
+{
+	if (kcas_core_destroy_exported_object(core)) {
+		ocf_cache_t cache = ocf_core_get_cache(core);
+
+		printk(KERN_ERR "Cannot to destroy exported object, %s.%s\n",
+				ocf_cache_get_name(cache),
+				ocf_core_get_name(core));
+	}
+
+	return 0;
+}
+
+/*
+ * Exported objects of cores are created in parallel, as each of them sets up
+ * its gendisk and tag set, which adds up for caches with hundreds of cores
+ */
+static int cache_mngt_initialize_core_exported_objects(ocf_cache_t cache)
+{
+	struct _cache_mngt_exp_obj_create_ctx ctx = {};
+	uint32_t count = 0, i;
+	int result = 0;
+
+	ocf_core_visit(cache, _cache_mngt_count_core_visitor, &count, true);
+	if (!count)
+		return 0;
+
+	ctx.creates = vzalloc(array_size(count, sizeof(*ctx.creates)));
+	if (!ctx.creates)
+		return -OCF_ERR_NO_MEM;
+
+	/* Core list doesn't change under management lock */
+	ocf_core_visit(cache, _cache_mngt_create_core_exported_object, &ctx,
+			true);
+
+	for (i = 0; i < ctx.count; i++) {
+		flush_work(&ctx.creates[i].work);
+		if (!result)
+			result = ctx.creates[i].result;
+	}
+
+	vfree(ctx.creates);
+
+	if (result) {
+		/* Need to cleanup */
+		ocf_core_visit(cache, _cache_mngt_destroy_core_exported_object, NULL,
+				true);
+	}
+
+	return result;
+}
+
+struct _cache_mngt_core_add {
+	struct work_struct work;
+	struct kcas_insert_core *cmd_info;
+	struct ocf_mngt_core_config cfg;
+	struct _cache_mngt_exp_obj_create create;
+	int result;
+};
+
+static void _cache_mngt_prepare_core_cfg_work(struct work_struct *work)
+{
+	struct _cache_mngt_core_add *add = container_of(work,
+			struct _cache_mngt_core_add, work);
+
+	add->result = cache_mngt_prepare_core_cfg(&add->cfg, add->cmd_info);
+}
+
+/*
+ * Add cores in single call, taking cache management lock once. Core devices
+ * are identified in parallel, then added to OCF one by one, each exported
+ * object being created in background while the next core is added. Cores
+ * failed to be added don't stop the others, each entry has its own status.
+ */
+int cache_mngt_add_cores_to_cache(struct kcas_insert_cores *cmd_info)
+{
+	uint64_t bitmap[DIV_ROUND_UP(OCF_CORE_MAX, 8 * sizeof(uint64_t))];
+	char cache_name[OCF_CACHE_NAME_SIZE];
+	struct _cache_mngt_core_add *adds;
+	struct kcas_insert_core *cores;
+	struct cache_priv *cache_priv;
+	uint32_t count = cmd_info->cores_count, i;
+	ocf_cache_t cache;
+	int result;
+
+	if (!count || count > OCF_CORE_MAX || !cmd_info->cores)
+		return -OCF_ERR_INVAL;
+
+	cores = vmalloc(array_size(count, sizeof(*cores)));
+	if (!cores)
+		return -OCF_ERR_NO_MEM;
+
+	adds = vzalloc(array_size(count, sizeof(*adds)));
+	if (!adds) {
+		result = -OCF_ERR_NO_MEM;
+		goto out_cores;
+	}
+
+	if (copy_from_user(cores, (void __user *)cmd_info->cores,
+				count * sizeof(*cores))) {
+		result = -EFAULT;
+		goto out_adds;
+	}
+
+	cache_name_from_id(cache_name, cmd_info->cache_id);
+
+	result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name,
+			OCF_CACHE_NAME_SIZE, &cache);
+	if (result)
+		goto out_adds;
+
+	if (ocf_cache_is_standby(cache)) {
+		result = -OCF_ERR_CACHE_STANDBY;
+		goto out_put;
+	}
+
+	result = _cache_mngt_lock_sync(cache);
+	if (result)
+		goto out_put;
+
+	/* Free ids are handed out in order of entries, under management lock */
+	cache_priv = ocf_cache_get_priv(cache);
+	memcpy(bitmap, cache_priv->core_id_bitmap, sizeof(bitmap));
+
+	for (i = 0; i < count; i++) {
+		struct kcas_insert_core *core_info = &cores[i];
+
+		/* Only plain addition of core to running cache is batched */
+		if (core_info->try_add || core_info->update_path ||
+				core_info->fs_meta_dict.length) {
+			adds[i].result = -OCF_ERR_INVAL;
+			continue;
+		}
+
+		if (core_info->read_ahead_kb > KCAS_EXP_OBJ_IO_HINT_KB_MAX ||
+				core_info->io_opt_kb >
+					KCAS_EXP_OBJ_IO_HINT_KB_MAX) {
+			adds[i].result = -OCF_ERR_INVAL;
+			continue;
+		}
+
+		if (core_info->core_id == OCF_CORE_MAX)
+			core_info->core_id = find_free_core_id(bitmap);
+		if (core_info->core_id >= OCF_CORE_MAX) {
+			adds[i].result = -OCF_ERR_INVAL;
+			continue;
+		}
+		set_bit(core_info->core_id, (unsigned long *)bitmap);
+
+		core_info->cache_id = cmd_info->cache_id;
+		adds[i].cmd_info = core_info;
+		INIT_WORK(&adds[i].work, _cache_mngt_prepare_core_cfg_work);
+		queue_work(system_unbound_wq, &adds[i].work);
+	}
+
+	for (i = 0; i < count; i++) {
+		if (adds[i].cmd_info)
+			flush_work(&adds[i].work);
+	}
+
+	for (i = 0; i < count; i++) {
+		if (adds[i].result)
+			continue;
+
+		adds[i].result = _cache_mngt_add_core(cache, &adds[i].cfg,
+				&cores[i], cores[i].core_id,
+				&adds[i].create.core);
+		if (adds[i].result)
+			continue;
+
+		INIT_WORK(&adds[i].create.work,
+				_cache_mngt_create_core_exported_object_work);
+		queue_work(system_unbound_wq, &adds[i].create.work);
+	}
+
+	for (i = 0; i < count; i++) {
+		if (adds[i].result)
+			continue;
+
+		flush_work(&adds[i].create.work);
+		adds[i].result = adds[i].create.result;
+		if (adds[i].result) {
+			_cache_mngt_remove_added_core(adds[i].create.core);
+			continue;
+		}
+
+		mark_core_id_used(cache, cores[i].core_id);
+	}
+
+	ocf_mngt_cache_unlock(cache);
+
+	for (i = 0; i < count; i++) {
+		cores[i].ext_err_code = abs(adds[i].result);
+		if (!adds[i].result)
+			_cache_mngt_log_core_device_path(adds[i].create.core);
+		else if (!result)
+			result = adds[i].result;
+	}
+
+	if (copy_to_user((void __user *)cmd_info->cores, cores,
+				count * sizeof(*cores))) {
+		result = -EFAULT;
+	}
+
+out_put:
+	ocf_mngt_cache_put(cache);
+out_adds:
+	vfree(adds);
+out_cores:
+	vfree(cores);
+	return result;
+}
+
+static int cache_mngt_destroy_cache_exported_object(ocf_cache_t cache)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	int ret;
+
+	if (!cache_priv->cache_exported_object_initialized)
+		return 0;
+
+	ret = kcas_cache_destroy_exported_object(cache);
+
+	if (ret) {
+		printk(KERN_ERR "Cannot destroy %s exported object\n",
+				ocf_cache_get_name(cache));
+	} else {
+		cache_priv->cache_exported_object_initialized = false;
+	}
+
+	return ret;
+}
+
+static int cache_mngt_initialize_cache_exported_object(ocf_cache_t cache)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	int result;
+
+	result = kcas_cache_create_exported_object(cache);
+	if (result)
+		return result;
+
+	cache_priv->cache_exported_object_initialized = true;
+
+	return 0;
+}
+
+static bool _cache_mngt_volume_is_compressed(ocf_volume_t volume)
+{
+	return ocf_volume_get_type(volume) == ocf_ctx_get_volume_type(
+			cas_ctx, COMPRESSED_DEVICE_VOLUME);
+}
+
+/*
+ * Map of compressed volume is not persisted, so data of cache is lost once
+ * volume is closed. Only cache modes never holding dirty data are allowed,
+ * and cache is never loaded from compressed volume.
+ */
+static int _cache_mngt_check_compressed(ocf_volume_t volume, bool load,
+		ocf_cache_mode_t mode)
+{
+	if (!_cache_mngt_volume_is_compressed(volume))
+		return 0;
+
+	if (load) {
+		printk(KERN_ERR OCF_PREFIX_SHORT "Cache cannot be loaded "
+				"from compressed cache device\n");
+		return -KCAS_ERR_COMPRESSED_LOAD;
+	}
+
+	if (ocf_mngt_cache_mode_has_lazy_write(mode)) {
+		printk(KERN_ERR OCF_PREFIX_SHORT "Compressed cache device "
+				"supports only wt, wa and pt cache modes\n");
+		return -OCF_ERR_INVAL;
+	}
+
+	return 0;
+}
+
+static int cache_mngt_create_cache_device_cfg(
+		struct ocf_mngt_cache_device_config *cfg, char *cache_path)
+{
+	int result = 0;
+	ocf_volume_t volume;
+
+	memset(cfg, 0, sizeof(*cfg));
+
+	result = cas_create_volume_by_path(&volume, ocf_volume_form_cache, cache_path);
+	if (result)
+		return result;
+
+	/* Hashes are learned from metadata read while cache is loaded */
+	if (metadata_write_elision)
+		bd_object(volume)->meta_elide = true;
+
+	cfg->perform_test = false;
+	cfg->volume = volume;
+
+	return 0;
+}
+
+int cache_mngt_attach_cache_cfg(char *cache_name, size_t name_len,
+		struct ocf_mngt_cache_config *cfg,
+		struct ocf_mngt_cache_attach_config *attach_cfg,
+		struct kcas_start_cache *cmd)
+{
+	int result;
+
+	if (!cmd)
+		return -OCF_ERR_INVAL;
+
+	memset(cfg, 0, sizeof(*cfg));
+	memset(attach_cfg, 0, sizeof(*attach_cfg));
+
+	result = cache_mngt_create_cache_device_cfg(&attach_cfg->device,
+			cmd->cache_path_name);
+	if (result)
+		return result;
+
+	//TODO maybe attach should allow to change cache line size?
+	//cfg->cache_line_size = cmd->line_size;
+	cfg->use_submit_io_fast = !use_io_scheduler;
+	cfg->locked = true;
+	cfg->metadata_volatile = true;
+
+	cfg->backfill.max_queue_size = max_writeback_queue_size;
+	cfg->backfill.queue_unblock_size = writeback_queue_unblock_size;
+	attach_cfg->cache_line_size = cmd->line_size;
+	attach_cfg->force = cmd->force;
+	attach_cfg->discard_on_start = true;
+
+	return 0;
+}
+
+static void cache_mngt_destroy_cache_device_cfg(
+		struct ocf_mngt_cache_device_config *cfg)
+{
+	ocf_volume_destroy(cfg->volume);
+}
+
+int cache_mngt_create_cache_cfg(struct ocf_mngt_cache_config *cfg,
+		struct ocf_mngt_cache_attach_config *attach_cfg,
+		struct kcas_start_cache *cmd)
+{
+	int init_cache, result;
+	char cache_name[OCF_CACHE_NAME_SIZE];
+	uint32_t cache_id;
+
+	switch (cmd->init_cache) {
+		case CACHE_INIT_STANDBY_NEW:
+		case CACHE_INIT_STANDBY_LOAD:
+			printk(KERN_ERR "Standby mode is not supported!\n");
+			return -ENOTSUP;
+		default:
+			break;
+	}
+
+	if (!cmd)
+		return -OCF_ERR_INVAL;
+
+	if (cmd->init_cache == CACHE_INIT_LOAD ||
+			cmd->init_cache == CACHE_INIT_STANDBY_LOAD) {
+		if (cmd->cache_id != OCF_CACHE_ID_INVALID) {
+			printk(KERN_WARNING "Specifying cache id while loading "
+					"cache is forbidden\n");
+			return -OCF_ERR_INVAL;
+		}
+
+		if (cmd->line_size != ocf_cache_line_size_none) {
+			printk(KERN_WARNING "Specifying cache line size while "
+					"loading cache is forbidden\n");
+			return -OCF_ERR_INVAL;
+		}
+		if (cmd->caching_mode != ocf_cache_mode_none) {
+			printk(KERN_WARNING "Specifying cache mode while "
+					"loading cache is forbidden\n");
+			return -OCF_ERR_INVAL;
+		}
+	} else if (cmd->cache_id == OCF_CACHE_ID_INVALID) {
+		cache_id = find_free_cache_id(cas_ctx);
+		if (cache_id == OCF_CACHE_ID_INVALID)
+			return -OCF_ERR_INVAL;
+
+		cmd->cache_id = cache_id;
+	}
+
+	cache_name_from_id(cache_name, cmd->cache_id);
+
+	memset(cfg, 0, sizeof(*cfg));
+	memset(attach_cfg, 0, sizeof(*attach_cfg));
+
+	result = cache_mngt_create_cache_device_cfg(&attach_cfg->device,
+			cmd->cache_path_name);
+	if (result)
+		return result;
+
+	result = _cache_mngt_check_compressed(attach_cfg->device.volume,
+			cmd->init_cache == CACHE_INIT_LOAD, cmd->caching_mode);
+	if (result) {
+		cache_mngt_destroy_cache_device_cfg(&attach_cfg->device);
+		return result;
+	}
+
+	strncpy(cfg->name, cache_name, OCF_CACHE_NAME_SIZE - 1);
+	cfg->cache_mode = cmd->caching_mode;
+	cfg->cache_line_size = cmd->line_size;
+	cfg->promotion_policy = ocf_promotion_default;
+	cfg->cache_line_size = cmd->line_size;
+	/*
+	 * Handled unaligned write marks only sectors it covers valid (and
+	 * dirty), core is read later only for invalid sectors being read
+	 */
+	cfg->pt_unaligned_io = !unaligned_io;
+	cfg->use_submit_io_fast = !use_io_scheduler;
+	cfg->locked = true;
+	cfg->metadata_volatile = false;
+
+	cfg->backfill.max_queue_size = max_writeback_queue_size;
+	cfg->backfill.queue_unblock_size = writeback_queue_unblock_size;
+	attach_cfg->cache_line_size = cmd->line_size;
+	attach_cfg->force = cmd->force;
+	attach_cfg->discard_on_start = true;
+
+	init_cache = cmd->init_cache;
+
+	switch (init_cache) {
+	case CACHE_INIT_LOAD:
+		attach_cfg->open_cores = true;
+	case CACHE_INIT_NEW:
+	case CACHE_INIT_STANDBY_NEW:
+	case CACHE_INIT_STANDBY_LOAD:
+		break;
+	default:
+		return -OCF_ERR_INVAL;
+	}
+
+
+	return 0;
+}
+
+static void _cache_mngt_log_cache_device_path(ocf_cache_t cache,
+		const char *cache_path)
+{
+	printk(KERN_INFO OCF_PREFIX_SHORT "Adding device %s as cache %s\n",
+			cache_path, ocf_cache_get_name(cache));
+}
+
+static void _cas_queue_kick(ocf_queue_t q)
+{
+	cas_kick_queue_thread(q);
+}
+
+static void _cas_queue_stop(ocf_queue_t q)
+{
+	cas_stop_queue_thread(q);
+}
+
+const struct ocf_queue_ops queue_ops = {
+	.kick = _cas_queue_kick,
+	.stop = _cas_queue_stop,
+};
+
+int cas_init_mngt_queue_thread(ocf_cache_t cache, ocf_queue_t q, int cpu)
+{
+	const char *cache_num = ocf_cache_get_name(cache) + 5;
+	char name[48] = {};
+	snprintf(name, sizeof(name), "cas_mngt_%s", cache_num);
+
+	return cas_create_queue_thread(q, name, cpu, CAS_THREAD_MNGT);
+}
+int cas_init_io_queue_thread(ocf_cache_t cache, ocf_queue_t q, int cpu)
+{
+	const char *cache_num = ocf_cache_get_name(cache) + 5;
+	char name[48] = {};
+	snprintf(name, sizeof(name), "cas_io_%s", cache_num);
+
+	return cas_create_queue_thread(q, name, cpu, CAS_THREAD_IO);
+}
+int cas_init_porter_queue_thread(ocf_cache_t cache, ocf_queue_t q, int cpu)
+{
+	const char *cache_num = ocf_cache_get_name(cache) + 5;
+	char name[48] = {};
+	snprintf(name, sizeof(name), "cas_porter_%s", cache_num);
+
+	return cas_create_queue_thread(q, name, cpu, CAS_THREAD_PORTER);
+}
+int cas_init_cleaner_queue_thread(ocf_cache_t cache, ocf_queue_t q, int cpu)
+{
+	const char *cache_num = ocf_cache_get_name(cache) + 5;
+	char name[48] = {};
+	snprintf(name, sizeof(name), "cas_clean_%s", cache_num);
+
+	return cas_create_queue_thread(q, name, cpu, CAS_THREAD_CLEANER);
+}
+int cas_init_idle_io_queue_thread(ocf_cache_t cache, ocf_queue_t q, int cpu)
+{
+	const char *cache_num = ocf_cache_get_name(cache) + 5;
+	char name[48] = {};
+	snprintf(name, sizeof(name), "cas_idle_%s", cache_num);
+
+	return cas_create_queue_thread(q, name, cpu, CAS_THREAD_IDLE_IO);
+}
+/*
+ * Index of CPU owning queue which serves given CPU with configured queue
+ * topology. Owner is always the lowest CPU of a group, so it never exceeds
+ * the index of CPU being mapped.
+ */
+static uint32_t _cache_mngt_queue_owner(uint32_t cpu)
+{
+	uint32_t groups_no;
+
+	switch (queue_topology) {
+	case CAS_QUEUE_TOPOLOGY_LLC:
+		return cpumask_first(CAS_CPU_LLC_MASK(cpu));
+	case CAS_QUEUE_TOPOLOGY_NODE:
+		return cpumask_first(cpumask_of_node(cpu_to_node(cpu)));
+	case CAS_QUEUE_TOPOLOGY_FIXED:
+		/* Neighbouring CPU ids are usually topologically close */
+		groups_no = min(queue_count, nr_cpu_ids);
+		return DIV_ROUND_UP((cpu * groups_no / nr_cpu_ids) * nr_cpu_ids,
+				groups_no);
+	case CAS_QUEUE_TOPOLOGY_CPU:
+	default:
+		return cpu;
+	}
+}
+
+/*
+ * Find queue serving CPU group of given CPU. Group owner might have been
+ * offline when queues were created, so any queue created by a CPU of the
+ * same group is as good.
+ */
+static int _cache_mngt_find_queue(struct cache_priv *cache_priv, uint32_t cpu)
+{
+	uint32_t owner = _cache_mngt_queue_owner(cpu);
+	int i;
+
+	if (cache_priv_owns_queue(cache_priv, owner))
+		return owner;
+
+	for_each_online_cpu(i) {
+		if (cache_priv_owns_queue(cache_priv, i) &&
+				_cache_mngt_queue_owner(i) == owner) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/*
+ * Let threads of queue owned by given CPU run on online CPUs served by
+ * the queue, except CPU going offline. When no such CPU is left, threads
+ * move to the NUMA node of the owner or anywhere as a last resort.
+ */
+static void _cache_mngt_set_queue_affinity(struct cache_priv *cache_priv,
+		uint32_t owner, int offline_cpu)
+{
+	cpumask_var_t mask;
+	int i;
+
+	if (!zalloc_cpumask_var(&mask, GFP_KERNEL))
+		return;
+
+	for_each_online_cpu(i) {
+		if (i != offline_cpu && cache_priv->queues[i].queue_idx == owner)
+			cpumask_set_cpu(i, mask);
+	}
+
+	if (cpumask_empty(mask)) {
+		cpumask_and(mask, cpumask_of_node(cpu_to_node(owner)),
+				cpu_online_mask);
+		if (offline_cpu >= 0)
+			cpumask_clear_cpu(offline_cpu, mask);
+	}
+
+	if (cpumask_empty(mask)) {
+		cpumask_copy(mask, cpu_online_mask);
+		if (offline_cpu >= 0)
+			cpumask_clear_cpu(offline_cpu, mask);
+	}
+
+	cas_set_queue_thread_affinity(cache_priv->queues[owner].worker_queue,
+			mask);
+	cas_set_queue_thread_affinity(cache_priv->queues[owner].porter_queue,
+			mask);
+	if (cache_priv->queues[owner].idle_queue) {
+		cas_set_queue_thread_affinity(
+				cache_priv->queues[owner].idle_queue, mask);
+	}
+
+	free_cpumask_var(mask);
+}
+
+static int _cache_mngt_create_cpu_queues(ocf_cache_t cache, uint32_t cpu)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	/* Per CPU queues are bound, others float within their group */
+	int bind_cpu = queue_topology == CAS_QUEUE_TOPOLOGY_CPU ?
+			cpu : CAS_CPUS_ALL;
+	ocf_queue_t worker_queue, porter_queue, idle_queue = NULL;
+	int result;
+
+	result = ocf_queue_create(cache, &worker_queue, &queue_ops);
+	if (result)
+		return result;
+
+	result = cas_init_io_queue_thread(cache, worker_queue, bind_cpu);
+	if (result)
+		goto err_worker_queue;
+
+	result = ocf_queue_create(cache, &porter_queue, &queue_ops);
+	if (result)
+		goto err_worker_queue;
+
+	result = cas_init_porter_queue_thread(cache, porter_queue, bind_cpu);
+	if (result)
+		goto err_porter_queue;
+
+	if (idle_io_queues) {
+		result = ocf_queue_create(cache, &idle_queue, &queue_ops);
+		if (result)
+			goto err_porter_queue;
+
+		result = cas_init_idle_io_queue_thread(cache, idle_queue,
+				bind_cpu);
+		if (result)
+			goto err_idle_queue;
+
+		cas_set_queue_thread_poll(idle_queue,
+				cache_priv->queue_poll_us);
+	}
+
+	cas_set_queue_thread_poll(worker_queue, cache_priv->queue_poll_us);
+	cas_set_queue_thread_poll(porter_queue, cache_priv->queue_poll_us);
+
+	cache_priv->queues[cpu].queue_idx = cpu;
+	WRITE_ONCE(cache_priv->queues[cpu].idle_queue, idle_queue);
+	WRITE_ONCE(cache_priv->queues[cpu].worker_queue, worker_queue);
+	WRITE_ONCE(cache_priv->queues[cpu].porter_queue, porter_queue);
+
+	return 0;
+
+err_idle_queue:
+	ocf_queue_put(idle_queue);
+err_porter_queue:
+	ocf_queue_put(porter_queue);
+err_worker_queue:
+	ocf_queue_put(worker_queue);
+	return result;
+}
+
+static int _cache_mngt_start_queues(ocf_cache_t cache)
+{
+	bool grouped = queue_topology != CAS_QUEUE_TOPOLOGY_CPU;
+	struct cache_priv *cache_priv;
+	uint32_t fallback_idx;
+	int result, i, idx;
+
+	cache_priv = ocf_cache_get_priv(cache);
+
+	/*
+	 * CPU going online meanwhile is served by fallback queue until next
+	 * time it goes online, so hotplug lock is not needed here.
+	 */
+	for_each_online_cpu(i) {
+		idx = _cache_mngt_find_queue(cache_priv, i);
+		if (idx < 0) {
+			result = _cache_mngt_create_cpu_queues(cache, i);
+			if (result)
+				goto err_queues;
+			idx = i;
+		}
+		cache_priv->queues[i].queue_idx = idx;
+	}
+
+	/* Offline CPUs submit nothing, but their map entries must be valid */
+	fallback_idx = cache_priv->queues[cpumask_first(cpu_online_mask)].queue_idx;
+	for (i = 0; i < nr_cpu_ids; i++) {
+		if (!cpu_online(i) && !cache_priv_owns_queue(cache_priv, i))
+			cache_priv->queues[i].queue_idx = fallback_idx;
+		cache_priv->queues[i].steer_idx =
+				cache_priv->queues[i].queue_idx;
+	}
+
+	if (grouped) {
+		for (i = 0; i < nr_cpu_ids; i++) {
+			if (cache_priv_owns_queue(cache_priv, i))
+				_cache_mngt_set_queue_affinity(cache_priv, i, -1);
+		}
+	}
+
+	result = ocf_queue_create_mngt(cache, &cache_priv->mngt_queue,
+			&queue_ops);
+	if (result)
+		goto err_queues;
+
+	result = cas_init_mngt_queue_thread(cache, cache_priv->mngt_queue, CAS_CPUS_ALL);
+	if (result) {
+		goto err_mngt_queue;
+	}
+
+	cache_priv->cache = cache;
+	if (cas_cpuhp_state >= 0) {
+		result = CAS_CPUHP_ADD_INSTANCE(cas_cpuhp_state,
+				&cache_priv->cpuhp_node);
+		cache_priv->cpuhp_registered = !result;
+	}
+
+	return 0;
+
+err_mngt_queue:
+	ocf_queue_put(cache_priv->mngt_queue);
+	cache_priv->mngt_queue = NULL;
+err_queues:
+	for (i = 0; i < nr_cpu_ids; i++) {
+		if (!cache_priv_owns_queue(cache_priv, i))
+			continue;
+		if (cache_priv->queues[i].idle_queue)
+			ocf_queue_put(cache_priv->queues[i].idle_queue);
+		ocf_queue_put(cache_priv->queues[i].porter_queue);
+		ocf_queue_put(cache_priv->queues[i].worker_queue);
+		cache_priv->queues[i].idle_queue = NULL;
+		cache_priv->queues[i].porter_queue = NULL;
+		cache_priv->queues[i].worker_queue = NULL;
+	}
+
+	return result;
+}
+
+/* Stop reacting to CPU hotplug before cache queues go away */
+static void _cache_mngt_stop_queues_hotplug(ocf_cache_t cache)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+
+	if (!cache_priv || !cache_priv->cpuhp_registered)
+		return;
+
+	CAS_CPUHP_REMOVE_INSTANCE(cas_cpuhp_state, &cache_priv->cpuhp_node);
+	cache_priv->cpuhp_registered = false;
+}
+
+static int _cache_mngt_cpu_online(unsigned int cpu, struct hlist_node *node)
+{
+	struct cache_priv *cache_priv =
+			hlist_entry(node, struct cache_priv, cpuhp_node);
+	int idx;
+
+	idx = _cache_mngt_find_queue(cache_priv, cpu);
+	if (idx < 0) {
+		if (_cache_mngt_create_cpu_queues(cache_priv->cache, cpu)) {
+			/* Keep using fallback queue, don't fail the hotplug */
+			printk(KERN_WARNING OCF_PREFIX_SHORT "Cannot create queues "
+					"of cache %s for CPU %u\n",
+					ocf_cache_get_name(cache_priv->cache),
+					cpu);
+			return 0;
+		}
+		idx = cpu;
+	}
+
+	cache_priv->queues[cpu].queue_idx = idx;
+	if (queue_topology == CAS_QUEUE_TOPOLOGY_CPU && idx == cpu) {
+		cas_set_queue_thread_affinity(cache_priv->queues[cpu].worker_queue,
+				cpumask_of(cpu));
+		cas_set_queue_thread_affinity(cache_priv->queues[cpu].porter_queue,
+				cpumask_of(cpu));
+		if (cache_priv->queues[cpu].idle_queue) {
+			cas_set_queue_thread_affinity(
+					cache_priv->queues[cpu].idle_queue,
+					cpumask_of(cpu));
+		}
+	} else {
+		_cache_mngt_set_queue_affinity(cache_priv, idx, -1);
+	}
+
+	_cache_mngt_set_io_steering(cache_priv->cache);
+
+	return 0;
+}
+
+static int _cache_mngt_cpu_offline(unsigned int cpu, struct hlist_node *node)
+{
+	struct cache_priv *cache_priv =
+			hlist_entry(node, struct cache_priv, cpuhp_node);
+	int i;
+
+	/* Move threads of queues this CPU was running to remaining CPUs */
+	for (i = 0; i < nr_cpu_ids; i++) {
+		if (cache_priv_owns_queue(cache_priv, i) &&
+				(i == cpu || cache_priv->queues[cpu].queue_idx == i)) {
+			_cache_mngt_set_queue_affinity(cache_priv, i, cpu);
+		}
+	}
+
+	return 0;
+}
+
+int cache_mngt_init_cpu_hotplug(void)
+{
+	int result;
+
+	result = CAS_CPUHP_SETUP("block/cas_cache:online",
+			_cache_mngt_cpu_online, _cache_mngt_cpu_offline);
+	if (result < 0) {
+		printk(KERN_WARNING OCF_PREFIX_SHORT "CPU hotplug not supported, "
+				"CPUs going online won't get cache queues\n");
+		return 0;
+	}
+
+	cas_cpuhp_state = result;
+
+	return 0;
+}
+
+void cache_mngt_deinit_cpu_hotplug(void)
+{
+	if (cas_cpuhp_state >= 0)
+		CAS_CPUHP_REMOVE(cas_cpuhp_state);
+	cas_cpuhp_state = -1;
+}
+
+static void init_instance_complete(struct _cache_mngt_attach_context *ctx,
+		ocf_cache_t cache)
+{
+	ocf_volume_t cache_obj;
+	struct bd_object *bd_cache_obj;
+	struct block_device *bdev;
+
+	cache_obj = ocf_cache_get_volume(cache);
+	BUG_ON(!cache_obj);
+
+	bd_cache_obj = bd_object(cache_obj);
+	bdev = bd_cache_obj->btm_bd;
+
+	/* If we deal with whole device, reread partitions */
+	if (cas_bdev_whole(bdev) == bdev)
+		cas_reread_partitions(bdev);
+
+}
+
+/* Amount of DRAM needed for metadata of cache on device @cache_path */
+static uint64_t _cache_mngt_get_ram_needed(ocf_cache_t cache,
+		char *cache_path)
+{
+	struct ocf_mngt_cache_device_config device_cfg = {};
+	uint64_t volume_size, ram_needed = 0;
+	int result;
+
+	result = cache_mngt_create_cache_device_cfg(&device_cfg, cache_path);
+	if (result)
+		return 0;
+
+	result = ocf_volume_open(device_cfg.volume, device_cfg.volume_params);
+	if (result)
+		goto destroy_config;
+
+	volume_size = ocf_volume_get_length(device_cfg.volume);
+	ram_needed = ocf_mngt_get_ram_needed(cache, volume_size);
+	ocf_volume_close(device_cfg.volume);
+
+destroy_config:
+	cache_mngt_destroy_cache_device_cfg(&device_cfg);
+	return ram_needed;
+}
+
+static void calculate_min_ram_size(ocf_cache_t cache,
+		struct _cache_mngt_attach_context *ctx)
+{
+	ctx->min_free_ram = _cache_mngt_get_ram_needed(cache, ctx->cache_path);
+	if (!ctx->min_free_ram)
+		printk(KERN_WARNING "Cannot calculate amount of DRAM needed\n");
+}
+
+/*
+ * Caches whose metadata is being loaded. Start ioctl is blocked until
+ * load completes, so casadm polls these for progress with separate ioctl.
+ */
+struct cas_load_progress {
+	struct list_head list;
+	uint32_t cache_id;
+	/* Metadata held in DRAM is what load reads from cache device */
+	uint64_t metadata_size;
+	unsigned long start;
+};
+
+static LIST_HEAD(cas_load_progress_list);
+static DEFINE_SPINLOCK(cas_load_progress_lock);
+
+static void _cache_mngt_load_progress_start(struct cas_load_progress *progress,
+		ocf_cache_t cache, uint32_t cache_id, char *cache_path)
+{
+	progress->cache_id = cache_id;
+	progress->metadata_size = _cache_mngt_get_ram_needed(cache, cache_path);
+	progress->start = jiffies;
+
+	spin_lock(&cas_load_progress_lock);
+	list_add(&progress->list, &cas_load_progress_list);
+	spin_unlock(&cas_load_progress_lock);
+}
+
+static void _cache_mngt_load_progress_end(struct cas_load_progress *progress)
+{
+	spin_lock(&cas_load_progress_lock);
+	list_del(&progress->list);
+	spin_unlock(&cas_load_progress_lock);
+}
+
+int cache_mngt_get_load_progress(struct kcas_load_progress *cmd)
+{
+	struct cas_load_progress *progress;
+	int result = -OCF_ERR_CACHE_NOT_EXIST;
+
+	spin_lock(&cas_load_progress_lock);
+	list_for_each_entry(progress, &cas_load_progress_list, list) {
+		if (progress->cache_id != cmd->cache_id)
+			continue;
+
+		cmd->metadata_size = progress->metadata_size;
+		cmd->elapsed_ms = jiffies_to_msecs(jiffies - progress->start);
+		result = 0;
+		break;
+	}
+	spin_unlock(&cas_load_progress_lock);
+
+	return result;
+}
+
+static void _cache_mngt_attach_complete(ocf_cache_t cache, void *priv,
+		int error)
+{
+	struct _cache_mngt_attach_context *ctx = priv;
+	int caller_status;
+	char *path;
+
+	cache_mngt_destroy_cache_device_cfg(&ctx->device_cfg);
+
+	if (!error) {
+		path = (char *)ocf_volume_get_uuid(ocf_cache_get_volume(
+					cache))->data;
+		printk(KERN_INFO "Succsessfully attached %s\n", path);
+	}
+
+	caller_status = _cache_mngt_async_callee_set_result(&ctx->async, error);
+	if (caller_status != -KCAS_ERR_WAITING_INTERRUPTED)
+		return;
+
+	kfree(ctx);
+	ocf_mngt_cache_unlock(cache);
+	ocf_mngt_cache_put(cache);
+}
+
+static void _cache_mngt_start_complete(ocf_cache_t cache, void *priv, int error)
+{
+	struct _cache_mngt_attach_context *ctx = priv;
+	int caller_status;
+
+	cache_mngt_destroy_cache_device_cfg(&ctx->device_cfg);
+
+	if (error == -OCF_ERR_NO_FREE_RAM)
+		calculate_min_ram_size(cache, ctx);
+
+	caller_status =_cache_mngt_async_callee_set_result(&ctx->async, error);
+	if (caller_status == -KCAS_ERR_WAITING_INTERRUPTED) {
+		/* Attach/load was interrupted. Rollback asynchronously. */
+		if (!error) {
+			printk(KERN_WARNING "Cache added successfully, "
+					"but waiting interrupted. Rollback\n");
+		}
+		ctx->ocf_start_error = error;
+		_cache_mngt_stop_queues_hotplug(cache);
+		ocf_mngt_cache_stop(cache,
+				_cache_mngt_cache_stop_rollback_complete, ctx);
+	}
+}
+
+#define CAS_MODE_DRAIN_INTERVAL HZ
+
+static void _cache_mngt_mode_drain_flush_complete(ocf_cache_t cache,
+		void *priv, int error)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+
+	/* Check again once flushed, queued before unlocking to not race
+	 * with stopping cache */
+	schedule_delayed_work(&cache_priv->mode_drain.work,
+			error ? CAS_MODE_DRAIN_INTERVAL : 0);
+	ocf_mngt_cache_read_unlock(cache);
+}
+
+/*
+ * Dirty data left by switch out of lazy write mode is written back by the
+ * cleaner while new writes already follow the new mode. Once no dirty data
+ * is left the switch is complete.
+ */
+static void _cache_mngt_mode_drain_work(struct work_struct *work)
+{
+	struct cache_priv *cache_priv = container_of(to_delayed_work(work),
+			struct cache_priv, mode_drain.work);
+	ocf_cache_t cache = cache_priv->cache;
+	ocf_cleaning_t cleaning;
+
+	/* Don't wait for management operation, possibly stopping cache */
+	if (ocf_mngt_cache_read_trylock(cache)) {
+		schedule_delayed_work(&cache_priv->mode_drain.work,
+				CAS_MODE_DRAIN_INTERVAL);
+		return;
+	}
+
+	if (READ_ONCE(cache_priv->mode_drain.from) == ocf_cache_mode_none)
+		goto unlock;
+
+	if (!ocf_cache_is_device_attached(cache) ||
+			!ocf_mngt_cache_is_dirty(cache)) {
+		WRITE_ONCE(cache_priv->mode_drain.from, ocf_cache_mode_none);
+		printk(KERN_INFO "%s: Dirty data drained, cache mode switch "
+				"completed\n", ocf_cache_get_name(cache));
+		goto unlock;
+	}
+
+	/* Nothing cleans cache without cleaning policy, flush it instead.
+	 * Readers are not blocked, management lock is released on completion.
+	 */
+	if (!ocf_mngt_cache_cleaning_get_policy(cache, &cleaning) &&
+			cleaning == ocf_cleaning_nop) {
+		ocf_mngt_cache_flush(cache,
+				_cache_mngt_mode_drain_flush_complete, NULL);
+		return;
+	}
+
+	schedule_delayed_work(&cache_priv->mode_drain.work,
+			CAS_MODE_DRAIN_INTERVAL);
+unlock:
+	ocf_mngt_cache_read_unlock(cache);
+}
+
+static void _cache_mngt_mode_drain_init(struct cache_priv *cache_priv)
+{
+	cache_priv->mode_drain.from = ocf_cache_mode_none;
+	INIT_DELAYED_WORK(&cache_priv->mode_drain.work,
+			_cache_mngt_mode_drain_work);
+}
+
+/* Called once cache is locked for stopping or has never been started */
+static void _cache_mngt_mode_drain_stop(struct cache_priv *cache_priv)
+{
+	cancel_delayed_work_sync(&cache_priv->mode_drain.work);
+}
+
+/*
+ * Start or end tracking of dirty data drain on mode switch, called under
+ * management lock
+ */
+static void _cache_mngt_mode_drain_update(ocf_cache_t cache,
+		ocf_cache_mode_t old_mode, ocf_cache_mode_t mode, uint8_t flush)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	ocf_cache_mode_t from = ocf_cache_mode_none;
+
+	if (flush == CACHE_MODE_FLUSH_BACKGROUND &&
+			!ocf_mngt_cache_mode_has_lazy_write(mode)) {
+		/* Another switch during drain keeps original lazy mode */
+		from = cache_priv->mode_drain.from;
+		if (from == ocf_cache_mode_none &&
+				ocf_mngt_cache_mode_has_lazy_write(old_mode)) {
+			from = old_mode;
+		}
+	}
+
+	WRITE_ONCE(cache_priv->mode_drain.from, from);
+
+	if (from != ocf_cache_mode_none)
+		mod_delayed_work(system_wq, &cache_priv->mode_drain.work, 0);
+}
+
+static int _cache_mngt_cache_priv_init(ocf_cache_t cache)
+{
+	struct cache_priv *cache_priv;
+	uint32_t i;
+
+	cache_priv = vzalloc(sizeof(*cache_priv) +
+			nr_cpu_ids * sizeof(*cache_priv->queues));
+	if (!cache_priv)
+		return -ENOMEM;
+
+	cache_priv->stop_context =
+		env_malloc(sizeof(*cache_priv->stop_context), GFP_KERNEL);
+	if (!cache_priv->stop_context) {
+		vfree(cache_priv);
+		return -ENOMEM;
+	}
+
+	/*
+	 * Cache gets reserves of its own, so that busy cache doesn't drain
+	 * pool shared by all caches and push them to page allocator
+	 */
+	if (per_cache_bvec_pool) {
+		char name[MPOOL_ALLOCATOR_NAME_MAX];
+
+		snprintf(name, sizeof(name), "cas_biovec_%s",
+				ocf_cache_get_name(cache));
+		cache_priv->bvec_pool = env_mpool_create(
+				sizeof(struct blk_data), sizeof(struct bio_vec),
+				GFP_NOIO, 7, true, NULL, name, true);
+		if (!cache_priv->bvec_pool || (mpool_magazine &&
+				env_mpool_enable_magazines(
+					cache_priv->bvec_pool))) {
+			if (cache_priv->bvec_pool)
+				env_mpool_destroy(cache_priv->bvec_pool);
+			kfree(cache_priv->stop_context);
+			vfree(cache_priv);
+			return -ENOMEM;
+		}
+	}
+
+	if (cgroup_stats) {
+		cache_priv->cgroup_stats = cas_cgroup_stats_create();
+		if (!cache_priv->cgroup_stats) {
+			if (cache_priv->bvec_pool)
+				env_mpool_destroy(cache_priv->bvec_pool);
+			kfree(cache_priv->stop_context);
+			vfree(cache_priv);
+			return -ENOMEM;
+		}
+	}
+
+	atomic_set(&cache_priv->flush_interrupt_enabled, 1);
+
+	mutex_init(&cache_priv->cleaner.lock);
+	cache_priv->cleaner.workers = CAS_CLEANER_WORKERS_DEFAULT;
+
+	_cache_mngt_fs_meta_learn_init(cache_priv);
+	_cache_mngt_mode_drain_init(cache_priv);
+	_cache_mngt_purge_init(cache_priv);
+	_cache_mngt_nhit_adapt_init(cache_priv);
+	_cache_mngt_seq_absorb_init(cache_priv);
+	_cache_mngt_prio_adapt_init(cache_priv);
+	cas_prefetch_init(cache_priv);
+
+	cache_priv->home_node = NUMA_NO_NODE;
+	for (i = 0; i < nr_cpu_ids; i++) {
+		cache_priv->queues[i].queue_idx = i;
+		cache_priv->queues[i].steer_idx = i;
+	}
+
+	ocf_cache_set_priv(cache, cache_priv);
+
+	return 0;
+}
+
+struct cache_mngt_probe_metadata_context {
+	struct completion cmpl;
+	char *cache_name;
+	int *result;
+
+	char *cache_name_meta;
+	ocf_cache_mode_t *cache_mode_meta;
+	ocf_cache_line_size_t *cache_line_size_meta;
+};
+
+static void cache_mngt_probe_metadata_end(void *priv, int error,
+		struct ocf_metadata_probe_status *status)
+{
+	struct cache_mngt_probe_metadata_context *context = priv;
+
+	*context->result = error;
+
+	if (error == -OCF_ERR_NO_METADATA) {
+		printk(KERN_ERR "No cache metadata found!\n");
+		goto err;
+	} else if (error == -OCF_ERR_METADATA_VER) {
+		printk(KERN_ERR "Cache metadata version mismatch\n");
+		goto err;
+	} else if (error) {
+		printk(KERN_ERR "Failed to load cache metadata!\n");
+		goto err;
+	}
+
+	strscpy(context->cache_name_meta, status->cache_name,
+			OCF_CACHE_NAME_SIZE);
+	*(context->cache_mode_meta) = status->cache_mode;
+	*(context->cache_line_size_meta) = status->cache_line_size;
+err:
+	complete(&context->cmpl);
+}
+
+static int _cache_mngt_probe_metadata(char *cache_path_name,
+		char *cache_name_meta, ocf_cache_mode_t *cache_mode_meta,
+		ocf_cache_line_size_t *cache_line_size_meta)
+{
+	struct cache_mngt_probe_metadata_context context;
+	cas_bdev_handle_t bdev_handle;
+	struct block_device *bdev;
+	ocf_volume_t volume;
+	char holder[] = "CAS CHECK METADATA\n";
+	int result;
+
+	/* Volume of multiple devices is opened as whole with all members */
+	if (cas_blk_is_multi_device_path(cache_path_name)) {
+		bdev_handle = NULL;
+		result = cas_create_volume_by_path(&volume,
+				ocf_volume_form_cache, cache_path_name);
+		if (result)
+			return result;
+
+		result = ocf_volume_open(volume, NULL);
+		if (result) {
+			ocf_volume_destroy(volume);
+			return result;
+		}
+	} else {
+		bdev_handle = cas_bdev_open_by_path(
+				cas_blk_device_path(cache_path_name),
+				(CAS_BLK_MODE_EXCL | CAS_BLK_MODE_READ),
+				holder);
+		if (IS_ERR(bdev_handle)) {
+			return (PTR_ERR(bdev_handle) == -EBUSY) ?
+					-OCF_ERR_NOT_OPEN_EXC :
+					-OCF_ERR_INVAL_VOLUME_TYPE;
+		}
+		bdev = cas_bdev_get_from_handle(bdev_handle);
+
+		result = cas_blk_open_volume_by_bdev(&volume, bdev);
+		if (result)
+			goto out_bdev;
+	}
+
+	init_completion(&context.cmpl);
+	context.result = &result;
+	context.cache_name_meta = cache_name_meta;
+	context.cache_mode_meta = cache_mode_meta;
+	context.cache_line_size_meta = cache_line_size_meta;
+
+	ocf_metadata_probe(cas_ctx, volume, cache_mngt_probe_metadata_end,
+			&context);
+	wait_for_completion(&context.cmpl);
+
+	cas_blk_close_volume(volume);
+out_bdev:
+	if (bdev_handle) {
+		cas_bdev_release(bdev_handle,
+				(CAS_BLK_MODE_EXCL | CAS_BLK_MODE_READ),
+				holder);
+	}
+	return result;
+}
+
+static void volume_set_no_merges_flag_helper(ocf_cache_t cache)
+{
+	struct request_queue *cache_q;
+	struct bd_object *bvol;
+	struct block_device *bd;
+	ocf_volume_t volume;
+
+	volume = ocf_cache_get_volume(cache);
+	if (!volume)
+		return;
+
+	bvol = bd_object(volume);
+	bd = cas_disk_get_blkdev(bvol->dsk);
+	cache_q = bd->bd_disk->queue;
+
+	cas_cache_set_no_merges_flag(cache_q);
+}
+
+/*
+ * Metadata pages written to cache device supporting untorn writes are sent
+ * as atomic writes, so that power failure never leaves a page half written
+ */
+static void _cache_mngt_set_atomic_meta(ocf_cache_t cache)
+{
+	ocf_volume_t volume = ocf_cache_get_volume(cache);
+	struct ocf_cache_info info;
+
+	if (!block_dev_get_atomic_write_unit(volume) ||
+			ocf_cache_get_info(cache, &info)) {
+		return;
+	}
+
+	/* Metadata end offset is given in 4 KiB blocks */
+	block_dev_set_atomic_meta(volume,
+			(uint64_t)info.metadata_end_offset * 4096);
+
+	printk(KERN_INFO OCF_PREFIX_SHORT "Cache %s metadata is written "
+			"atomically, device atomic write unit %u KiB\n",
+			ocf_cache_get_name(cache),
+			block_dev_get_atomic_write_unit(volume) / 1024);
+}
+
+/*
+ * Volume of cache device learns page hashes of all of it until metadata end
+ * is known, which is once cache is started or loaded
+ */
+static void _cache_mngt_set_meta_elide(ocf_cache_t cache)
+{
+	ocf_volume_t volume = ocf_cache_get_volume(cache);
+	struct ocf_cache_info info;
+
+	if (ocf_cache_get_info(cache, &info)) {
+		block_dev_meta_elide_set_end(volume, 0);
+		return;
+	}
+
+	/* Metadata end offset is given in 4 KiB blocks */
+	block_dev_meta_elide_set_end(volume,
+			(uint64_t)info.metadata_end_offset * 4096);
+}
+
+static void _cache_save_device_properties(ocf_cache_t cache)
+{
+	struct block_device *bd;
+	struct bd_object *bvol;
+	struct request_queue *cache_q;
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+
+	bvol = bd_object(ocf_cache_get_volume(cache));
+	bd = cas_disk_get_blkdev(bvol->dsk);
+	cache_q = bd->bd_disk->queue;
+
+	cache_priv->device_properties.queue_limits = cache_q->limits;
+	cache_priv->device_properties.flush =
+				CAS_CHECK_QUEUE_FLUSH(cache_q);
+	cache_priv->device_properties.fua =
+				CAS_CHECK_QUEUE_FUA(cache_q);
+
+	cache_priv->home_node = dev_to_node(disk_to_dev(bd->bd_disk));
+
+	_cache_mngt_set_atomic_meta(cache);
+	_cache_mngt_set_meta_elide(cache);
+}
+
+/* Queue of online CPU of @node serving I/O of @cpu steered there, -1 if
+ * node has no online CPU */
+static int _cache_mngt_node_queue(struct cache_priv *cache_priv,
+		int node, uint32_t cpu)
+{
+	uint32_t node_cpus_no = 0, j, k;
+
+	if (cpu_to_node(cpu) == node)
+		return cache_priv->queues[cpu].queue_idx;
+
+	for_each_online_cpu(j) {
+		if (cpu_to_node(j) == node)
+			node_cpus_no++;
+	}
+
+	if (!node_cpus_no)
+		return -1;
+
+	/* Spread remote CPUs evenly among node queues */
+	k = cpu % node_cpus_no;
+	for_each_online_cpu(j) {
+		if (cpu_to_node(j) == node && k-- == 0)
+			return cache_priv->queues[j].queue_idx;
+	}
+
+	return -1;
+}
+
+/*
+ * With LBA sharding, ranges of numa_shard_size_mb of each core are hashed
+ * to NUMA nodes with online CPUs, and data I/O of a range is served by queues
+ * of CPUs of its node only. Cache lines of a range are then looked up,
+ * locked and touched from single node, so their metadata doesn't bounce
+ * between sockets on hit path.
+ */
+static void _cache_mngt_set_lba_shards(ocf_cache_t cache)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	int nodes[CAS_NUMA_SHARDS_MAX];
+	uint32_t shards = 0, i, s;
+	int node, idx;
+
+	if (numa_io_steering != CAS_IO_STEERING_LBA_SHARDS)
+		return;
+
+	for_each_online_node(node) {
+		if (shards == CAS_NUMA_SHARDS_MAX)
+			break;
+		if (cpumask_intersects(cpumask_of_node(node), cpu_online_mask))
+			nodes[shards++] = node;
+	}
+
+	/* Shrink first, so that no reader picks shard being changed */
+	if (shards < cache_priv->numa_shards)
+		WRITE_ONCE(cache_priv->numa_shards, shards);
+
+	cache_priv->numa_shard_shift = ilog2(numa_shard_size_mb) + 20 -
+			SECTOR_SHIFT;
+
+	for (i = 0; i < nr_cpu_ids; i++) {
+		for (s = 0; s < shards; s++) {
+			idx = _cache_mngt_node_queue(cache_priv, nodes[s], i);
+			WRITE_ONCE(cache_priv->queues[i].shard_idx[s],
+				idx < 0 ? cache_priv->queues[i].queue_idx : idx);
+		}
+	}
+
+	/* Single node leaves nothing to shard */
+	WRITE_ONCE(cache_priv->numa_shards, shards > 1 ? shards : 0);
+}
+
+/*
+ * With NUMA I/O steering enabled, I/O submitted on CPUs outside of cache
+ * device home node is served by queues of home node CPUs, so that cache
+ * buffers, metadata and device completions stay node local.
+ */
+static void _cache_mngt_set_io_steering(ocf_cache_t cache)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	int node = cache_priv->home_node;
+	int idx;
+	uint32_t i;
+
+	/* Entries are read locklessly on I/O path, each must stay valid */
+	for (i = 0; i < nr_cpu_ids; i++) {
+		WRITE_ONCE(cache_priv->queues[i].steer_idx,
+				cache_priv->queues[i].queue_idx);
+	}
+
+	_cache_mngt_set_lba_shards(cache);
+
+	if (numa_io_steering != CAS_IO_STEERING_HOME_NODE ||
+			node == NUMA_NO_NODE) {
+		return;
+	}
+
+	for_each_online_cpu(i) {
+		idx = _cache_mngt_node_queue(cache_priv, node, i);
+		if (idx >= 0)
+			WRITE_ONCE(cache_priv->queues[i].steer_idx, idx);
+	}
+}
+
+static int _cache_start_finalize(ocf_cache_t cache, int init_mode,
+		bool activate)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	struct _cache_mngt_attach_context *ctx = cache_priv->attach_context;
+	int result;
+
+	_cache_mngt_log_cache_device_path(cache, ctx->cache_path);
+
+	if (activate || (init_mode != CACHE_INIT_STANDBY_NEW &&
+			init_mode != CACHE_INIT_STANDBY_LOAD)) {
+		result = cas_cls_init(cache);
+		if (result) {
+			ctx->ocf_start_error = result;
+			return result;
+		}
+		ctx->cls_inited = true;
+
+		volume_set_no_merges_flag_helper(cache);
+
+		_cache_save_device_properties(cache);
+		_cache_mngt_set_io_steering(cache);
+	} else {
+		/* Standby cache has no metadata of its own to save */
+		block_dev_meta_elide_set_end(ocf_cache_get_volume(cache), 0);
 	}
 
 	if (activate)
 		cache_mngt_destroy_cache_exported_object(cache);
 
-	/* after destroying exported object activate should follow
-	 * load path */
-	init_mode = activate ? CACHE_INIT_LOAD : init_mode;
+	/* after destroying exported object activate should follow
+	 * load path */
+	init_mode = activate ? CACHE_INIT_LOAD : init_mode;
+
+	switch(init_mode) {
+	case CACHE_INIT_LOAD:
+		result = cache_mngt_initialize_core_exported_objects(cache);
+		if (result) {
+			ctx->ocf_start_error = result;
+			return result;
+		}
+		ocf_core_visit(cache, _cache_mngt_core_device_loaded_visitor,
+				NULL, false);
+		break;
+	case CACHE_INIT_STANDBY_NEW:
+	case CACHE_INIT_STANDBY_LOAD:
+		result = cache_mngt_initialize_cache_exported_object(cache);
+		if (result) {
+			ctx->ocf_start_error = result;
+			return result;
+		}
+		break;
+	case CACHE_INIT_NEW:
+		break;
+	default:
+		BUG();
+	}
+
+	init_instance_complete(ctx, cache);
+
+	return 0;
+}
+
+static int _cache_mngt_check_member_bdev(const char *path, bool force,
+		bool reattach, ocf_cache_t cache)
+{
+	char holder[] = "CAS START\n";
+	cas_bdev_handle_t bdev_handle;
+	struct block_device *bdev;
+	int part_count;
+	bool is_part;
+	bool reattach_properties_diff = false;
+	struct cache_priv *cache_priv;
+	/* The only reason to use blk_stack_limits() is checking compatibility of
+	 * the new device with the original cache. But since the functions modifies
+	 * content of queue_limits, we use copy of the original struct.
+	 */
+	struct queue_limits tmp_limits;
+
+	bdev_handle = cas_bdev_open_by_path(path,
+			(CAS_BLK_MODE_EXCL | CAS_BLK_MODE_READ), holder);
+	if (IS_ERR(bdev_handle)) {
+		return (PTR_ERR(bdev_handle) == -EBUSY) ?
+				-OCF_ERR_NOT_OPEN_EXC :
+				-OCF_ERR_INVAL_VOLUME_TYPE;
+	}
+	bdev = cas_bdev_get_from_handle(bdev_handle);
+
+	is_part = (cas_bdev_whole(bdev) != bdev);
+	part_count = cas_blk_get_part_count(bdev);
+
+	if (reattach) {
+		ENV_BUG_ON(!cache);
+
+		cache_priv = ocf_cache_get_priv(cache);
+		tmp_limits = cache_priv->device_properties.queue_limits;
+
+		if (blk_stack_limits(&tmp_limits, &bdev->bd_disk->queue->limits, 0)) {
+			reattach_properties_diff = true;
+			printk(KERN_WARNING "New cache device block properties "
+					"differ from the previous one.\n");
+		}
+		if (tmp_limits.misaligned) {
+			reattach_properties_diff = true;
+			printk(KERN_WARNING "New cache device block interval "
+					"doesn't line up with the previous one.\n");
+		}
+		if (CAS_CHECK_QUEUE_FLUSH(bdev->bd_disk->queue) !=
+				cache_priv->device_properties.flush) {
+			reattach_properties_diff = true;
+			printk(KERN_WARNING "New cache device %s support flush "
+					"in contrary to the previous cache device.\n",
+					cache_priv->device_properties.flush ? "doesn't" : "does");
+		}
+		if (CAS_CHECK_QUEUE_FUA(bdev->bd_disk->queue) !=
+				cache_priv->device_properties.fua) {
+			reattach_properties_diff = true;
+			printk(KERN_WARNING "New cache device %s support fua "
+					"in contrary to the previous cache device.\n",
+					cache_priv->device_properties.fua ? "doesn't" : "does");
+		}
+	}
+
+	cas_bdev_release(bdev_handle,
+			(CAS_BLK_MODE_EXCL | CAS_BLK_MODE_READ), holder);
+
+	if (!is_part && part_count > 1 && !force)
+		return -KCAS_ERR_CONTAINS_PART;
+
+	if (reattach_properties_diff)
+		return -KCAS_ERR_DEVICE_PROPERTIES_MISMATCH;
+
+	return 0;
+}
+
+/* Each member of cache volume is checked as separate device */
+static int cache_mngt_check_bdev(struct ocf_mngt_cache_device_config *cfg,
+		bool force, bool reattach, ocf_cache_t cache)
+{
+	const struct ocf_volume_uuid *uuid = ocf_volume_get_uuid(cfg->volume);
+	char *paths, *cursor, *path;
+	int result = 0;
+
+	paths = kstrndup(uuid->data, uuid->size, GFP_KERNEL);
+	if (!paths)
+		return -OCF_ERR_NO_MEM;
+
+	cursor = paths;
+	while ((path = strsep(&cursor, CAS_BD_MEMBERS_SEPARATOR
+					CAS_BD_MIRROR_SEPARATOR))) {
+		result = _cache_mngt_check_member_bdev(
+				cas_blk_device_path(path), force, reattach,
+				cache);
+		if (result)
+			break;
+	}
+	kfree(paths);
+
+	return result;
+}
+
+int cache_mngt_standby_detach(struct kcas_standby_detach *cmd)
+{
+	ocf_cache_t cache;
+	struct cache_priv *cache_priv;
+	char cache_name[OCF_CACHE_NAME_SIZE];
+	int result = 0;
+	struct _cache_mngt_sync_context context = {
+		.result = &result
+	};
+
+	init_completion(&context.cmpl);
+
+	if (!try_module_get(THIS_MODULE))
+		return -KCAS_ERR_SYSTEM;
+
+	cache_name_from_id(cache_name, cmd->cache_id);
+
+	result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name,
+			OCF_CACHE_NAME_SIZE, &cache);
+	if (result)
+		goto out_module_put;
+
+	if (!ocf_cache_is_standby(cache)) {
+		result = -OCF_ERR_CACHE_EXIST;
+		goto out_cache_put;
+	}
+
+	cache_priv = ocf_cache_get_priv(cache);
+	if (!cache_priv->cache_exported_object_initialized) {
+		result = -KCAS_ERR_STANDBY_DETACHED;
+		goto out_cache_put;
+	}
+
+	result = cache_mngt_destroy_cache_exported_object(cache);
+	if (result)
+		goto out_cache_put;
+
+	result = _cache_mngt_lock_sync(cache);
+	if (result)
+		goto out_cache_put;
+
+	ocf_mngt_cache_standby_detach(cache, _cache_mngt_generic_complete,
+			&context);
+
+	wait_for_completion(&context.cmpl);
+	ocf_mngt_cache_unlock(cache);
+
+out_cache_put:
+	ocf_mngt_cache_put(cache);
+out_module_put:
+	module_put(THIS_MODULE);
+	return result;
+}
+
+int cache_mngt_create_cache_standby_activate_cfg(
+		struct ocf_mngt_cache_standby_activate_config *cfg,
+		struct kcas_standby_activate *cmd)
+{
+	int result;
+
+	if (cmd->cache_id == OCF_CACHE_ID_INVALID)
+		return -OCF_ERR_INVAL;
+
+	memset(cfg, 0, sizeof(*cfg));
+
+	result = cache_mngt_create_cache_device_cfg(&cfg->device,
+			cmd->cache_path);
+	if (result)
+		return result;
+
+	result = _cache_mngt_check_compressed(cfg->device.volume, true,
+			ocf_cache_mode_none);
+	if (result) {
+		ocf_volume_destroy(cfg->device.volume);
+		return result;
+	}
+
+	cfg->open_cores = true;
+
+	return 0;
+}
+
+static void _cache_mngt_detach_cache_complete(ocf_cache_t cache, void *priv,
+		int error)
+{
+	struct _cache_mngt_async_context *context = priv;
+	int result;
+
+	result = _cache_mngt_async_callee_set_result(context, error);
+
+	if (result != -KCAS_ERR_WAITING_INTERRUPTED)
+		return;
+
+	kfree(context);
+	ocf_mngt_cache_unlock(cache);
+	kfree(context);
+}
+
+int cache_mngt_attach_device(const char *cache_name, size_t name_len,
+		const char *device, struct ocf_mngt_cache_attach_config *attach_cfg)
+{
+	struct _cache_mngt_attach_context *context;
+	ocf_cache_t cache;
+	int result = 0;
+
+	result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name,
+			OCF_CACHE_NAME_SIZE, &cache);
+	if (result) {
+		ocf_volume_destroy(attach_cfg->device.volume);
+		goto err_get;
+	}
+
+	result = _cache_mngt_lock_sync(cache);
+	if (result) {
+		ocf_volume_destroy(attach_cfg->device.volume);
+		goto err_lock;
+	}
+
+	result = cache_mngt_check_bdev(&attach_cfg->device,
+			attach_cfg->force, true, cache);
+	if (result) {
+		ocf_volume_destroy(attach_cfg->device.volume);
+		goto err_ctx;
+	}
+
+	result = _cache_mngt_check_compressed(attach_cfg->device.volume,
+			false, ocf_cache_get_mode(cache));
+	if (result) {
+		ocf_volume_destroy(attach_cfg->device.volume);
+		goto err_ctx;
+	}
+
+	context = kzalloc(sizeof(*context), GFP_KERNEL);
+	if (!context) {
+		ocf_volume_destroy(attach_cfg->device.volume);
+		result = -ENOMEM;
+		goto err_ctx;
+	}
+
+	context->device_cfg = attach_cfg->device;
+
+	_cache_mngt_async_context_init(&context->async);
+
+	ocf_mngt_cache_attach(cache, attach_cfg, _cache_mngt_attach_complete,
+			context);
+	result = wait_for_completion_interruptible(&context->async.cmpl);
+
+	result = _cache_mngt_async_caller_set_result(&context->async, result);
+	if (result == -KCAS_ERR_WAITING_INTERRUPTED)
+		goto err_get;
+
+	volume_set_no_merges_flag_helper(cache);
+
+	kfree(context);
+err_ctx:
+	ocf_mngt_cache_unlock(cache);
+err_lock:
+	ocf_mngt_cache_put(cache);
+err_get:
+	return result;
+}
+
+int cache_mngt_activate(struct ocf_mngt_cache_standby_activate_config *cfg,
+		struct kcas_standby_activate *cmd)
+{
+	struct _cache_mngt_attach_context *context;
+	ocf_cache_t cache;
+	struct cache_priv *cache_priv;
+	char cache_name[OCF_CACHE_NAME_SIZE];
+	int result = 0, rollback_result = 0;
+	uint64_t start;
+
+	if (!try_module_get(THIS_MODULE))
+		return -KCAS_ERR_SYSTEM;
+
+	cache_name_from_id(cache_name, cmd->cache_id);
+
+	result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name,
+			OCF_CACHE_NAME_SIZE, &cache);
+	if (result)
+		goto out_module_put;
+
+	if (!ocf_cache_is_standby(cache)) {
+		result = -OCF_ERR_CACHE_EXIST;
+		goto out_cache_put;
+	}
+
+	result = _cache_mngt_lock_sync(cache);
+	if (result)
+		goto out_cache_put;
+
+	/*
+	 * We ignore partitions detected on the cache device despite we
+	 * know at this point that activate is gonna fail. We want OCF
+	 * to compare data on drive and in DRAM to provide more specific
+	 * error code.
+	 */
+	result = cache_mngt_check_bdev(&cfg->device, true, false, NULL);
+	if (result)
+		goto out_cache_unlock;
+
+	context = kzalloc(sizeof(*context), GFP_KERNEL);
+	if (!context) {
+		result = -ENOMEM;
+		goto out_cache_unlock;
+	}
+
+	strncpy(context->cache_path, cmd->cache_path, MAX_STR_LEN-1);
+	context->device_cfg = cfg->device;
+	context->cache = cache;
+
+	cache_priv = ocf_cache_get_priv(cache);
+	cache_priv->attach_context = context;
+	/* All the required memory has been alocated and initialized on cache_init,
+	 * just set the flag to allow deinit*/
+	context->priv_inited = true;
+
+	context->rollback_thread = cas_lazy_thread_create(cache_start_rollback,
+			context, "cas_cache_rollback_complete");
+	if (IS_ERR(context->rollback_thread)) {
+		result = PTR_ERR(context->rollback_thread);
+		goto err_free_context;
+	}
+	_cache_mngt_async_context_init(&context->async);
+
+	start = ktime_get_ns();
+	ocf_mngt_cache_standby_activate(cache, cfg, _cache_mngt_start_complete,
+			context);
+	result = wait_for_completion_interruptible(&context->async.cmpl);
+
+	result = _cache_mngt_async_caller_set_result(&context->async, result);
+	if (result == -KCAS_ERR_WAITING_INTERRUPTED)
+		goto out_cache_put;
+	if (result)
+		goto activate_err;
+
+	result = _cache_start_finalize(cache, -1, true);
+	if (result)
+		goto finalize_err;
+
+	cache_priv->activate_ms = div_u64(ktime_get_ns() - start,
+			NSEC_PER_MSEC);
+	printk(KERN_INFO OCF_PREFIX_SHORT "%s activated in %u ms\n",
+			cache_name, cache_priv->activate_ms);
+
+activate_err:
+	cas_lazy_thread_stop(context->rollback_thread);
+
+err_free_context:
+	kfree(context);
+	cache_priv->attach_context = NULL;
+
+out_cache_unlock:
+	ocf_mngt_cache_unlock(cache);
+out_cache_put:
+	ocf_mngt_cache_put(cache);
+out_module_put:
+	module_put(THIS_MODULE);
+	return result;
+
+finalize_err:
+	_cache_mngt_async_context_reinit(&context->async);
+	_cache_mngt_stop_queues_hotplug(cache);
+	ocf_mngt_cache_stop(cache, _cache_mngt_cache_stop_rollback_complete,
+			context);
+	rollback_result = wait_for_completion_interruptible(&context->async.cmpl);
+
+	rollback_result = _cache_mngt_async_caller_set_result(&context->async,
+							rollback_result);
+
+	if (rollback_result != -KCAS_ERR_WAITING_INTERRUPTED)
+		kfree(context);
+
+	module_put(THIS_MODULE);
+	return result;
+}
+
+static bool _has_fs_meta_cb(ocf_cache_t cache, ocf_core_id_t core_id, uint64_t lba_beg, uint64_t lba_end, void *args)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	struct fs_meta_lba extent;
+	struct cas_fs_meta *map;
+	bool found;
+
+	rcu_read_lock();
+	map = rcu_dereference(cache_priv->fs_meta[core_id]);
+	if (!map) {
+		rcu_read_unlock();
+		return false;
+	}
+
+	/* Extents are sorted and disjoint, first one ending past lba_beg
+	 * is the only candidate to overlap */
+	found = _cache_mngt_fs_meta_lookup(map, lba_beg >> 12, &extent) &&
+		lba_end > extent.lba_beg * (1ULL << 12);
+	rcu_read_unlock();
+
+	return found;
+}
+
+int cache_mngt_init_instance(struct ocf_mngt_cache_config *cfg,
+		struct ocf_mngt_cache_attach_config *attach_cfg,
+		struct kcas_start_cache *cmd)
+{
+	struct _cache_mngt_attach_context *context;
+	ocf_cache_t cache, tmp_cache = NULL;
+	char cache_name_meta[OCF_CACHE_NAME_SIZE];
+	struct cache_priv *cache_priv;
+	int result = 0, rollback_result = 0;
+	ocf_cache_mode_t cache_mode_meta;
+	ocf_cache_line_size_t cache_line_size_meta;
+	struct cas_load_progress load_progress;
+	bool loading = false;
+	struct cas_fs_meta *map;
+	uint16_t i;
+
+	switch (cmd->init_cache) {
+		case CACHE_INIT_STANDBY_NEW:
+		case CACHE_INIT_STANDBY_LOAD:
+			ocf_volume_destroy(attach_cfg->device.volume);
+			printk(KERN_ERR "Standby mode is not supported!\n");
+			return -ENOTSUP;
+		default:
+			break;
+	}
+
+	if (!try_module_get(THIS_MODULE)) {
+		ocf_volume_destroy(attach_cfg->device.volume);
+		return -KCAS_ERR_SYSTEM;
+	}
+
+	result = cache_mngt_check_bdev(&attach_cfg->device, attach_cfg->force, false, NULL);
+	if (result) {
+		ocf_volume_destroy(attach_cfg->device.volume);
+		module_put(THIS_MODULE);
+		return result;
+	}
+
+	switch (cmd->init_cache) {
+	case CACHE_INIT_LOAD:
+	case CACHE_INIT_STANDBY_LOAD:
+		result = _cache_mngt_probe_metadata(cmd->cache_path_name,
+				cache_name_meta, &cache_mode_meta,
+				&cache_line_size_meta);
+		if (result) {
+			ocf_volume_destroy(attach_cfg->device.volume);
+			module_put(THIS_MODULE);
+			return result;
+		}
+
+		/* Need to return name from metadata now for caller to properly
+		 * communicate the error to user */
+		if (cache_id_from_name(&cmd->cache_id, cache_name_meta)) {
+			printk(KERN_ERR "Improper cache name format on %s.\n",
+					cmd->cache_path_name);
+
+			ocf_volume_destroy(attach_cfg->device.volume);
+			module_put(THIS_MODULE);
+			return -OCF_ERR_START_CACHE_FAIL;
+		}
+
+		result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name_meta,
+				OCF_CACHE_NAME_SIZE, &tmp_cache);
+
+		if (result != -OCF_ERR_CACHE_NOT_EXIST) {
+			printk(KERN_ERR "Can't load %s. Cache using that name "
+					"already exists.\n", cache_name_meta);
+
+			ocf_mngt_cache_put(tmp_cache);
+			ocf_volume_destroy(attach_cfg->device.volume);
+			module_put(THIS_MODULE);
+			return -OCF_ERR_CACHE_EXIST;
+		}
+
+		result = 0;
+		strscpy(cfg->name, cache_name_meta, OCF_CACHE_NAME_SIZE);
+		cfg->cache_mode = cache_mode_meta;
+		cfg->cache_line_size = cache_line_size_meta;
+	default:
+		break;
+	}
+
+	context = kzalloc(sizeof(*context), GFP_KERNEL);
+	if (!context) {
+		ocf_volume_destroy(attach_cfg->device.volume);
+		module_put(THIS_MODULE);
+		return -ENOMEM;
+	}
+
+	context->rollback_thread = cas_lazy_thread_create(cache_start_rollback,
+			context, "cas_cache_rollback_complete");
+	if (IS_ERR(context->rollback_thread)) {
+		result = PTR_ERR(context->rollback_thread);
+		kfree(context);
+		ocf_volume_destroy(attach_cfg->device.volume);
+		module_put(THIS_MODULE);
+		return result;
+	}
+
+	strncpy(context->cache_path, cmd->cache_path_name, MAX_STR_LEN-1);
+	context->device_cfg = attach_cfg->device;
+	_cache_mngt_async_context_init(&context->async);
+
+	/* Start cache. Returned cache instance will be locked as it was set
+	 * in configuration.
+	 */
+	result = ocf_mngt_cache_start(cas_ctx, &cache, cfg, NULL);
+	if (result) {
+		cas_lazy_thread_stop(context->rollback_thread);
+		kfree(context);
+		ocf_volume_destroy(attach_cfg->device.volume);
+		module_put(THIS_MODULE);
+		return result;
+	}
+	context->cache = cache;
+
+	result = _cache_mngt_cache_priv_init(cache);
+	if (result)
+		goto err_deinit_config;
+	context->priv_inited = true;
+
+	result = _cache_mngt_start_queues(cache);
+	if (result)
+		goto err_deinit_config;
+
+	cache_priv = ocf_cache_get_priv(cache);
+	cache_priv->attach_context = context;
+	ocf_cache_set_hook_has_fs_meta(cache, _has_fs_meta_cb, NULL);
+
+	switch (cmd->init_cache) {
+	case CACHE_INIT_NEW:
+		ocf_mngt_cache_attach(cache, attach_cfg,
+				_cache_mngt_start_complete, context);
+		break;
+	case CACHE_INIT_LOAD:
+		_cache_mngt_load_progress_start(&load_progress, cache,
+				cmd->cache_id, context->cache_path);
+		loading = true;
+		for (i = 0; i < OCF_CORE_MAX; i ++) {
+			if (cmd->fs_meta_dict[i].length && cmd->fs_meta_dict[i].data) {
+				map = _cache_mngt_fs_meta_from_user(
+						&cmd->fs_meta_dict[i]);
+				/* Without the map metadata just isn't recognized */
+				if (!IS_ERR(map))
+					rcu_assign_pointer(cache_priv->fs_meta[i], map);
+			}
+		}
+		ocf_mngt_cache_load(cache, attach_cfg,
+				_cache_mngt_start_complete, context);
+		break;
+	case CACHE_INIT_STANDBY_NEW:
+		ocf_mngt_cache_standby_attach(cache, attach_cfg,
+				_cache_mngt_start_complete, context);
+		break;
+	case CACHE_INIT_STANDBY_LOAD:
+		ocf_mngt_cache_standby_load(cache, attach_cfg,
+				_cache_mngt_start_complete, context);
+		break;
+	default:
+		result = -OCF_ERR_INVAL;
+		goto err;
+	}
+	result = wait_for_completion_interruptible(&context->async.cmpl);
+
+	if (loading)
+		_cache_mngt_load_progress_end(&load_progress);
+
+	result = _cache_mngt_async_caller_set_result(&context->async, result);
+	if (result == -KCAS_ERR_WAITING_INTERRUPTED)
+		return result;
+
+	if (result)
+		goto err;
+
+	result = _cache_start_finalize(cache, cmd->init_cache, false);
+	if (result)
+		goto err;
+
+	cas_lazy_thread_stop(context->rollback_thread);
+
+	kfree(context);
+	cache_priv->attach_context = NULL;
+
+	ocf_mngt_cache_unlock(cache);
+
+	return result;
+
+err_deinit_config:
+	ocf_volume_destroy(attach_cfg->device.volume);
+err:
+	cmd->min_free_ram = context->min_free_ram;
+
+	_cache_mngt_async_context_reinit(&context->async);
+	_cache_mngt_stop_queues_hotplug(cache);
+	ocf_mngt_cache_stop(cache, _cache_mngt_cache_stop_rollback_complete,
+			context);
+	rollback_result = wait_for_completion_interruptible(&context->async.cmpl);
+
+	rollback_result = _cache_mngt_async_caller_set_result(&context->async,
+			rollback_result);
+
+	if (rollback_result != -KCAS_ERR_WAITING_INTERRUPTED)
+		kfree(context);
+
+	return result;
+}
+
+/**
+ * @brief routine implementing dynamic sequential cutoff parameter switching
+ * @param[in] cache cache to which the change pertains
+ * @param[in] core core to which the change pertains
+ * or NULL for setting value for all cores attached to specified cache
+ * @param[in] thresh new sequential cutoff threshold value
+ * @return exit code of successful completion is 0;
+ * nonzero exit code means failure
+ */
+
+static int _cache_mngt_update_core_read_ahead(ocf_core_t core, void *cntx)
+{
+	kcas_core_update_read_ahead(core);
+	return 0;
+}
+
+/* Exported objects' read-ahead follows sequential cutoff settings */
+static void _cache_mngt_update_read_ahead(ocf_cache_t cache, ocf_core_t core)
+{
+	if (core) {
+		kcas_core_update_read_ahead(core);
+		return;
+	}
+
+	ocf_core_visit(cache, _cache_mngt_update_core_read_ahead, NULL, true);
+}
+
+int cache_mngt_set_seq_cutoff_threshold(ocf_cache_t cache, ocf_core_t core,
+		uint32_t thresh)
+{
+	int result;
+
+	result = _cache_mngt_lock_sync(cache);
+	if (result)
+		return result;
+
+	if (core) {
+		result = ocf_mngt_core_set_seq_cutoff_threshold(core, thresh);
+	} else {
+		result = ocf_mngt_core_set_seq_cutoff_threshold_all(cache,
+				thresh);
+	}
+
+	if (result)
+		goto out;
+
+	_cache_mngt_update_read_ahead(cache, core);
+
+	result = _cache_mngt_save_sync(cache);
+
+out:
+	ocf_mngt_cache_unlock(cache);
+	return result;
+}
+
+/**
+ * @brief routine implementing dynamic sequential cutoff parameter switching
+ * @param[in] cache cache to which the change pertains
+ * @param[in] core core to which the change pertains
+ * or NULL for setting value for all cores attached to specified cache
+ * @param[in] policy new sequential cutoff policy value
+ * @return exit code of successful completion is 0;
+ * nonzero exit code means failure
+ */
+
+int cache_mngt_set_seq_cutoff_policy(ocf_cache_t cache, ocf_core_t core,
+		ocf_seq_cutoff_policy policy)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	int result;
+
+	result = _cache_mngt_lock_sync(cache);
+	if (result)
+		return result;
+
+	if (core)
+		result = ocf_mngt_core_set_seq_cutoff_policy(core, policy);
+	else
+		result = ocf_mngt_core_set_seq_cutoff_policy_all(cache, policy);
+
+	if (result)
+		goto out;
+
+	/* New policy replaces one restored after absorbing sequential writes */
+	if (core)
+		clear_bit(ocf_core_get_id(core), cache_priv->seq_absorb.saved);
+	else
+		bitmap_zero(cache_priv->seq_absorb.saved, OCF_CORE_MAX);
+
+	_cache_mngt_update_read_ahead(cache, core);
+
+	result = _cache_mngt_save_sync(cache);
+
+out:
+	ocf_mngt_cache_unlock(cache);
+	return result;
+}
+
+/**
+ * @brief routine implementing dynamic sequential cutoff parameter switching
+ * @param[in] cache cache to which the change pertains
+ * @param[in] core core to which the change pertains
+ * or NULL for setting value for all cores attached to specified cache
+ * @param[in] count new sequential cutoff promotion request count value
+ * @return exit code of successful completion is 0;
+ * nonzero exit code means failure
+ */
+
+static int cache_mngt_set_seq_cutoff_promotion_count(ocf_cache_t cache,
+		ocf_core_t core, uint32_t count)
+{
+	int result;
+
+	result = _cache_mngt_lock_sync(cache);
+	if (result)
+		return result;
+
+	if (core) {
+		result = ocf_mngt_core_set_seq_cutoff_promotion_count(core,
+				count);
+	} else {
+		result = ocf_mngt_core_set_seq_cutoff_promotion_count_all(cache,
+				count);
+	}
+
+	if (result)
+		goto out;
+
+	result = _cache_mngt_save_sync(cache);
+
+out:
+	ocf_mngt_cache_unlock(cache);
+	return result;
+}
+
+/**
+ * @brief Get sequential cutoff threshold value
+ * @param[in] core OCF core
+ * @param[out] thresh sequential cutoff threshold value
+ * @return exit code of successful completion is 0;
+ * nonzero exit code means failure
+ */
+
+int cache_mngt_get_seq_cutoff_threshold(ocf_core_t core, uint32_t *thresh)
+{
+	ocf_cache_t cache = ocf_core_get_cache(core);
+	int result;
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	result = ocf_mngt_core_get_seq_cutoff_threshold(core, thresh);
+
+	ocf_mngt_cache_read_unlock(cache);
+	return result;
+}
+
+/**
+ * @brief Get sequential cutoff policy
+ * @param[in] core OCF core
+ * @param[out] thresh sequential cutoff policy
+ * @return exit code of successful completion is 0;
+ * nonzero exit code means failure
+ */
+
+int cache_mngt_get_seq_cutoff_policy(ocf_core_t core,
+		ocf_seq_cutoff_policy *policy)
+{
+	ocf_cache_t cache = ocf_core_get_cache(core);
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	int result;
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	result = ocf_mngt_core_get_seq_cutoff_policy(core, policy);
+
+	/* Configured policy is reported while sequential writes are absorbed */
+	if (!result && test_bit(ocf_core_get_id(core),
+				cache_priv->seq_absorb.saved)) {
+		*policy = cache_priv->seq_absorb.policy[ocf_core_get_id(core)];
+	}
+
+	ocf_mngt_cache_read_unlock(cache);
+	return result;
+}
+
+/**
+ * @brief Get sequential cutoff promotion request count value
+ * @param[in] core OCF core
+ * @param[out] count sequential cutoff promotion request count value
+ * @return exit code of successful completion is 0;
+ * nonzero exit code means failure
+ */
+
+static int cache_mngt_get_seq_cutoff_promotion_count(ocf_core_t core,
+		uint32_t *count)
+{
+	ocf_cache_t cache = ocf_core_get_cache(core);
+	int result;
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	result = ocf_mngt_core_get_seq_cutoff_promotion_count(core, count);
+
+	ocf_mngt_cache_read_unlock(cache);
+	return result;
+}
+
+static int _cache_flush_with_lock(ocf_cache_t cache)
+{
+	int result = 0;
+
+	result = ocf_mngt_cache_get(cache);
+	if (result)
+		return result;
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result) {
+		ocf_mngt_cache_put(cache);
+		return result;
+	}
+
+	result = _cache_mngt_cache_flush_sync(cache, true, 0,
+			_cache_read_unlock_put_cmpl);
+
+	return result;
+}
+
+/**
+ * @brief routine implementing dynamic cache mode switching
+ * @param cache_name name of cache to which operation applies
+ * @param mode target mode (WRITE_THROUGH, WRITE_BACK, WRITE_AROUND etc.)
+ * @param flush shall we flush dirty data during switch, or shall we flush
+ *            all remaining dirty data before entering new mode?
+ */
+int cache_mngt_set_cache_mode(const char *cache_name, size_t name_len,
+			ocf_cache_mode_t mode, uint8_t flush)
+{
+	ocf_cache_mode_t old_mode;
+	ocf_cache_t cache;
+	int result;
+
+	result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name,
+					name_len, &cache);
+	if (result)
+		return result;
+
+	if (ocf_cache_is_standby(cache)) {
+		result = -OCF_ERR_CACHE_STANDBY;
+		goto put;
+	}
+
+	if (!ocf_cache_is_device_attached(cache)) {
+		result = -OCF_ERR_CACHE_DETACHED;
+		goto put;
+	}
+
+	result = _cache_mngt_check_compressed(ocf_cache_get_volume(cache),
+			false, mode);
+	if (result)
+		goto put;
+
+	old_mode = ocf_cache_get_mode(cache);
+	if (old_mode == mode) {
+		printk(KERN_INFO "%s is in requested cache mode already\n", cache_name);
+		result = 0;
+		goto put;
+	}
+
+	if (flush == CACHE_MODE_FLUSH_YES) {
+		result = _cache_flush_with_lock(cache);
+		if (result)
+			goto put;
+	}
+
+	result = _cache_mngt_lock_sync(cache);
+	if (result)
+		goto put;
+
+	if (old_mode != ocf_cache_get_mode(cache)) {
+		printk(KERN_WARNING "%s cache mode changed during flush\n",
+				ocf_cache_get_name(cache));
+		goto unlock;
+	}
+
+	if (flush == CACHE_MODE_FLUSH_YES) {
+		result = _cache_mngt_cache_flush_uninterruptible(cache);
+		if (result)
+			goto unlock;
+	}
+
+	result = ocf_mngt_cache_set_mode(cache, mode);
+	if (result)
+		goto unlock;
+
+	result = _cache_mngt_save_sync(cache);
+	if (result) {
+		printk(KERN_ERR "%s: Failed to save new cache mode. "
+				"Restoring old one!\n", cache_name);
+		ocf_mngt_cache_set_mode(cache, old_mode);
+		goto unlock;
+	}
+
+	_cache_mngt_mode_drain_update(cache, old_mode, mode, flush);
+
+unlock:
+	ocf_mngt_cache_unlock(cache);
+put:
+	ocf_mngt_cache_put(cache);
+	return result;
+}
+
+int cache_mngt_detach_cache(const char *cache_name, size_t name_len)
+{
+	ocf_cache_t cache;
+	int status = 0;
+	struct _cache_mngt_async_context *context;
+
+	context = kmalloc(sizeof(*context), GFP_KERNEL);
+	if (!context)
+		return -ENOMEM;
+
+	_cache_mngt_async_context_init(context);
+
+	status = ocf_mngt_cache_get_by_name(cas_ctx, cache_name,
+					name_len, &cache);
+	if (status)
+		goto err_get_cache;
+
+	if (ocf_cache_is_running(cache))
+		status = _cache_flush_with_lock(cache);
+	if (status)
+		goto err_flush;
+
+	status = _cache_mngt_lock_sync(cache);
+	if (status)
+		goto err_lock;
+
+	/* Cache volume goes away, so tracking of its writes does as well */
+	_cache_mngt_trim_stop(ocf_cache_get_priv(cache));
+
+	ocf_mngt_cache_detach(cache, _cache_mngt_detach_cache_complete, context);
+
+	status = wait_for_completion_interruptible(&context->cmpl);
+	status = _cache_mngt_async_caller_set_result(context, status);
+
+	if (status == -KCAS_ERR_WAITING_INTERRUPTED) {
+		printk(KERN_WARNING "Waiting for cache detach interrupted. "
+				"The operation will finish asynchronously.\n");
+		goto err_int;
+	}
+
+	ocf_mngt_cache_unlock(cache);
+err_lock:
+err_flush:
+	ocf_mngt_cache_put(cache);
+err_get_cache:
+	kfree(context);
+err_int:
+	return status;
+}
+
+/**
+ * @brief routine implements --stop-cache command.
+ * @param[in] cache_name caching device name to be removed
+ * @param[in] flush Boolean: shall we flush dirty data before removing cache.
+ *		if yes, flushing may still be interrupted by user (in which case
+ *		device won't be actually removed and error will be returned)
+ */
+int cache_mngt_exit_instance(const char *cache_name, size_t name_len, int flush)
+{
+	ocf_cache_t cache;
+	struct cache_priv *cache_priv;
+	ocf_queue_t mngt_queue;
+	int status = 0, flush_status = 0;
+	struct _cache_mngt_stop_context *context;
+
+	status = ocf_mngt_cache_get_by_name(cas_ctx, cache_name,
+					name_len, &cache);
+	if (status)
+		return status;
 
-	switch(init_mode) {
-	case CACHE_INIT_LOAD:
-		result = cache_mngt_initialize_core_exported_objects(cache);
-		if (result) {
-			ctx->ocf_start_error = result;
-			return result;
+	/*
+	 * Flush cache. Flushing may take a long time, so we allow user
+	 * to interrupt this operation. Hence we do first flush before
+	 * disabling exported object to avoid restoring it in case
+	 * of interruption. That means some new dirty data could appear
+	 * in cache during flush operation which will not be flushed
+	 * this time, so we need to flush cache again after disabling
+	 * exported object. The second flush should be much faster.
+	*/
+	if (flush && ocf_cache_is_running(cache))
+		status = _cache_flush_with_lock(cache);
+	if (status)
+		goto put;
+
+	status = _cache_mngt_lock_sync(cache);
+	if (status)
+		goto put;
+
+	cache_priv = ocf_cache_get_priv(cache);
+	mngt_queue = cache_priv->mngt_queue;
+	context = cache_priv->stop_context;
+
+	context->finish_thread = cas_lazy_thread_create(exit_instance_finish,
+			context, "cas_%s_stop", cache_name);
+	if (IS_ERR(context->finish_thread)) {
+		status = PTR_ERR(context->finish_thread);
+		goto unlock;
+	}
+
+	if (!ocf_cache_is_standby(cache)) {
+		status = kcas_cache_destroy_all_core_exported_objects(cache);
+		if (status != 0) {
+			printk(KERN_WARNING
+					"Failed to remove all cached devices\n");
+			goto stop_thread;
 		}
-		ocf_core_visit(cache, _cache_mngt_core_device_loaded_visitor,
-				NULL, false);
-		break;
-	case CACHE_INIT_STANDBY_NEW:
-	case CACHE_INIT_STANDBY_LOAD:
-		result = cache_mngt_initialize_cache_exported_object(cache);
-		if (result) {
-			ctx->ocf_start_error = result;
-			return result;
+	} else {
+		status = cache_mngt_destroy_cache_exported_object(cache);
+		if (status != 0) {
+			printk(KERN_WARNING
+					"Failed to remove cache exported object\n");
+			goto stop_thread;
 		}
-		break;
-	case CACHE_INIT_NEW:
-		break;
-	default:
-		BUG();
 	}
 
-	init_instance_complete(ctx, cache);
+	/* Flush cache again. This time we don't allow interruption. */
+	if (flush && ocf_cache_is_running(cache))
+		flush_status = _cache_mngt_cache_flush_uninterruptible(cache);
+	context->flush_status = flush_status;
+
+	if (flush && !flush_status)
+		BUG_ON(ocf_mngt_cache_is_dirty(cache));
+
+	/* Stop cache device - ignore interrupts */
+	status = _cache_mngt_cache_stop_sync(cache);
+	if (status == -KCAS_ERR_WAITING_INTERRUPTED)
+		printk(KERN_WARNING
+				"Waiting for cache stop interrupted. "
+				"Stop will finish asynchronously.\n");
+
+	if ((status == 0 || status == -KCAS_ERR_WAITING_INTERRUPTED) &&
+			flush_status) {
+		/* "removed dirty" error has a precedence over "interrupted" */
+		return KCAS_ERR_STOPPED_DIRTY;
+	}
+
+	return status;
+
+stop_thread:
+	cas_lazy_thread_stop(context->finish_thread);
+unlock:
+	ocf_mngt_cache_unlock(cache);
+put:
+	ocf_mngt_cache_put(cache);
+	return status;
+}
+
+struct cache_mngt_list_ctx {
+	struct kcas_cache_list *list;
+	int pos;
+};
+
+static int cache_mngt_list_caches_visitor(ocf_cache_t cache, void *cntx)
+{
+	struct cache_mngt_list_ctx *context = cntx;
+	struct kcas_cache_list *list = context->list;
+	uint32_t id;
+
+	BUG_ON(cache_id_from_name(&id, ocf_cache_get_name(cache)));
+
+	if (context->pos++ < list->id_position)
+		return 0;
+
+	if (list->in_out_num >= ARRAY_SIZE(list->cache_id_tab))
+		return 1;
+
+	list->cache_id_tab[list->in_out_num] = id;
+	list->in_out_num++;
 
 	return 0;
 }
 
-static int cache_mngt_check_bdev(struct ocf_mngt_cache_device_config *cfg,
-		bool force, bool reattach, ocf_cache_t cache)
+int cache_mngt_list_caches(struct kcas_cache_list *list)
 {
-	char holder[] = "CAS START\n";
-	cas_bdev_handle_t bdev_handle;
-	struct block_device *bdev;
-	int part_count;
-	bool is_part;
-	bool reattach_properties_diff = false;
+	struct cache_mngt_list_ctx context = {
+		.list = list,
+		.pos = 0
+	};
+
+	list->in_out_num = 0;
+	return ocf_mngt_cache_visit(cas_ctx, cache_mngt_list_caches_visitor,
+			&context);
+}
+
+int cache_mngt_interrupt_flushing(const char *cache_name, size_t name_len)
+{
+	ocf_cache_t cache;
 	struct cache_priv *cache_priv;
-	const struct ocf_volume_uuid *uuid = ocf_volume_get_uuid(cfg->volume);
-	/* The only reason to use blk_stack_limits() is checking compatibility of
-	 * the new device with the original cache. But since the functions modifies
-	 * content of queue_limits, we use copy of the original struct.
-	 */
-	struct queue_limits tmp_limits;
+	int result;
 
-	bdev_handle = cas_bdev_open_by_path(uuid->data,
-			(CAS_BLK_MODE_EXCL | CAS_BLK_MODE_READ), holder);
-	if (IS_ERR(bdev_handle)) {
-		return (PTR_ERR(bdev_handle) == -EBUSY) ?
-				-OCF_ERR_NOT_OPEN_EXC :
-				-OCF_ERR_INVAL_VOLUME_TYPE;
+	result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name,
+					name_len, &cache);
+	if (result)
+		return result;
+
+	cache_priv = ocf_cache_get_priv(cache);
+
+	if (atomic_read(&cache_priv->flush_interrupt_enabled))
+		ocf_mngt_cache_flush_interrupt(cache);
+
+	ocf_mngt_cache_put(cache);
+
+	return 0;
+
+}
+
+/*
+ * Management operations run in background on behalf of caller which
+ * doesn't want to stay blocked in ioctl. Operation is kept until caller
+ * releases it after completion. When limit is reached the oldest completed
+ * operation is dropped to make room for new one.
+ */
+struct cas_async_op {
+	struct list_head list;
+	struct kref ref;
+	struct work_struct work;
+	struct completion cmpl;
+	struct kcas_async_op cmd;
+	struct eventfd_ctx *eventfd;
+	unsigned long start;
+	unsigned long end;
+	uint64_t dirty_start;
+	uint64_t dirty;
+	bool done;
+	int result;
+};
+
+static LIST_HEAD(cas_async_op_list);
+static DEFINE_SPINLOCK(cas_async_op_lock);
+static unsigned int cas_async_op_count;
+static uint64_t cas_async_op_next_id = 1;
+static struct workqueue_struct *cas_async_op_wq;
+
+static void _cache_mngt_async_op_free(struct kref *ref)
+{
+	struct cas_async_op *op = container_of(ref, struct cas_async_op, ref);
+
+	if (op->eventfd)
+		eventfd_ctx_put(op->eventfd);
+	kfree(op);
+}
+
+static void _cache_mngt_async_op_put(struct cas_async_op *op)
+{
+	kref_put(&op->ref, _cache_mngt_async_op_free);
+}
+
+static bool _cache_mngt_async_op_is_core(struct kcas_async_op *cmd)
+{
+	return cmd->type == KCAS_ASYNC_OP_FLUSH_CORE ||
+			cmd->type == KCAS_ASYNC_OP_PURGE_CORE;
+}
+
+/*
+ * Dirty lines are sampled without waiting for cache lock, so that status
+ * query doesn't block behind operation holding it exclusively.
+ */
+static int _cache_mngt_async_op_get_dirty(struct kcas_async_op *cmd,
+		uint64_t *dirty)
+{
+	struct ocf_cache_info cache_info;
+	struct ocf_core_info core_info;
+	ocf_cache_t cache;
+	ocf_core_t core;
+	int result;
+
+	result = mngt_get_cache_by_id(cas_ctx, cmd->cache_id, &cache);
+	if (result)
+		return result;
+
+	if (ocf_mngt_cache_read_trylock(cache)) {
+		result = -EBUSY;
+		goto put;
 	}
-	bdev = cas_bdev_get_from_handle(bdev_handle);
 
-	is_part = (cas_bdev_whole(bdev) != bdev);
-	part_count = cas_blk_get_part_count(bdev);
+	if (_cache_mngt_async_op_is_core(cmd)) {
+		result = get_core_by_id(cache, cmd->core_id, &core);
+		if (!result)
+			result = ocf_core_get_info(core, &core_info);
+		if (!result)
+			*dirty = core_info.dirty;
+	} else {
+		result = ocf_cache_get_info(cache, &cache_info);
+		if (!result)
+			*dirty = cache_info.dirty;
+	}
 
-	if (reattach) {
-		ENV_BUG_ON(!cache);
+	ocf_mngt_cache_read_unlock(cache);
+put:
+	ocf_mngt_cache_put(cache);
+	return result;
+}
 
-		cache_priv = ocf_cache_get_priv(cache);
-		tmp_limits = cache_priv->device_properties.queue_limits;
+static void _cache_mngt_async_op_work(struct work_struct *work)
+{
+	struct cas_async_op *op = container_of(work, struct cas_async_op, work);
+	struct kcas_async_op *cmd = &op->cmd;
+	char cache_name[OCF_CACHE_NAME_SIZE];
+	char core_name[OCF_CORE_NAME_SIZE];
+	uint64_t dirty = op->dirty;
+	int result;
 
-		if (blk_stack_limits(&tmp_limits, &bdev->bd_disk->queue->limits, 0)) {
-			reattach_properties_diff = true;
-			printk(KERN_WARNING "New cache device block properties "
-					"differ from the previous one.\n");
-		}
-		if (tmp_limits.misaligned) {
-			reattach_properties_diff = true;
-			printk(KERN_WARNING "New cache device block interval "
-					"doesn't line up with the previous one.\n");
-		}
-		if (CAS_CHECK_QUEUE_FLUSH(bdev->bd_disk->queue) !=
-				cache_priv->device_properties.flush) {
-			reattach_properties_diff = true;
-			printk(KERN_WARNING "New cache device %s support flush "
-					"in contrary to the previous cache device.\n",
-					cache_priv->device_properties.flush ? "doesn't" : "does");
-		}
-		if (CAS_CHECK_QUEUE_FUA(bdev->bd_disk->queue) !=
-				cache_priv->device_properties.fua) {
-			reattach_properties_diff = true;
-			printk(KERN_WARNING "New cache device %s support fua "
-					"in contrary to the previous cache device.\n",
-					cache_priv->device_properties.fua ? "doesn't" : "does");
-		}
+	cache_name_from_id(cache_name, cmd->cache_id);
+	core_name_from_id(core_name, cmd->core_id);
+
+	switch (cmd->type) {
+	case KCAS_ASYNC_OP_FLUSH_CACHE:
+		result = cache_mngt_flush_device(cache_name,
+				OCF_CACHE_NAME_SIZE, cmd->rate_limit);
+		break;
+	case KCAS_ASYNC_OP_FLUSH_CORE:
+		result = cache_mngt_flush_object(cache_name,
+				OCF_CACHE_NAME_SIZE, core_name,
+				OCF_CORE_NAME_SIZE, cmd->rate_limit);
+		break;
+	case KCAS_ASYNC_OP_PURGE_CACHE:
+		result = cache_mngt_purge_device(cache_name,
+				OCF_CACHE_NAME_SIZE, false);
+		break;
+	case KCAS_ASYNC_OP_PURGE_CORE:
+		result = cache_mngt_purge_object(cache_name,
+				OCF_CACHE_NAME_SIZE, core_name,
+				OCF_CORE_NAME_SIZE, false);
+		break;
+	case KCAS_ASYNC_OP_STOP_CACHE:
+		result = cache_mngt_exit_instance(cache_name,
+				OCF_CACHE_NAME_SIZE, cmd->flush_data);
+		break;
+	default:
+		result = -EINVAL;
+		break;
 	}
 
-	cas_bdev_release(bdev_handle,
-			(CAS_BLK_MODE_EXCL | CAS_BLK_MODE_READ), holder);
+	/* Stopped cache keeps dirty count sampled last */
+	_cache_mngt_async_op_get_dirty(cmd, &dirty);
 
-	if (!is_part && part_count > 1 && !force)
-		return -KCAS_ERR_CONTAINS_PART;
+	spin_lock(&cas_async_op_lock);
+	op->result = result;
+	op->dirty = dirty;
+	op->end = jiffies;
+	op->done = true;
+	complete_all(&op->cmpl);
+	spin_unlock(&cas_async_op_lock);
 
-	if (reattach_properties_diff)
-		return -KCAS_ERR_DEVICE_PROPERTIES_MISMATCH;
+	if (op->eventfd)
+		CAS_EVENTFD_SIGNAL(op->eventfd);
 
-	return 0;
+	_cache_mngt_async_op_put(op);
 }
 
-int cache_mngt_standby_detach(struct kcas_standby_detach *cmd)
+int cache_mngt_async_op_start(struct kcas_async_op *cmd)
 {
+	struct cas_async_op *op, *iter, *victim = NULL;
 	ocf_cache_t cache;
-	struct cache_priv *cache_priv;
-	char cache_name[OCF_CACHE_NAME_SIZE];
-	int result = 0;
-	struct _cache_mngt_sync_context context = {
-		.result = &result
-	};
-
-	init_completion(&context.cmpl);
-
-	if (!try_module_get(THIS_MODULE))
-		return -KCAS_ERR_SYSTEM;
+	int result;
 
-	cache_name_from_id(cache_name, cmd->cache_id);
+	if (cmd->type >= KCAS_ASYNC_OP_TYPE_MAX)
+		return -EINVAL;
 
-	result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name,
-			OCF_CACHE_NAME_SIZE, &cache);
+	/* Report missing cache right away instead of as operation result */
+	result = mngt_get_cache_by_id(cas_ctx, cmd->cache_id, &cache);
 	if (result)
-		goto out_module_put;
+		return result;
+	ocf_mngt_cache_put(cache);
 
-	if (!ocf_cache_is_standby(cache)) {
-		result = -OCF_ERR_CACHE_EXIST;
-		goto out_cache_put;
-	}
+	op = kzalloc(sizeof(*op), GFP_KERNEL);
+	if (!op)
+		return -ENOMEM;
 
-	cache_priv = ocf_cache_get_priv(cache);
-	if (!cache_priv->cache_exported_object_initialized) {
-		result = -KCAS_ERR_STANDBY_DETACHED;
-		goto out_cache_put;
+	if (cmd->eventfd >= 0) {
+		op->eventfd = eventfd_ctx_fdget(cmd->eventfd);
+		if (IS_ERR(op->eventfd)) {
+			result = PTR_ERR(op->eventfd);
+			kfree(op);
+			return result;
+		}
 	}
 
-	result = cache_mngt_destroy_cache_exported_object(cache);
-	if (result)
-		goto out_cache_put;
+	/* One reference is held by list, the other one by work */
+	kref_init(&op->ref);
+	kref_get(&op->ref);
+	init_completion(&op->cmpl);
+	INIT_WORK(&op->work, _cache_mngt_async_op_work);
+	op->cmd = *cmd;
+	op->start = jiffies;
+	_cache_mngt_async_op_get_dirty(cmd, &op->dirty_start);
+	op->dirty = op->dirty_start;
+
+	spin_lock(&cas_async_op_lock);
+	if (cas_async_op_count >= KCAS_ASYNC_OPS_MAX) {
+		list_for_each_entry(iter, &cas_async_op_list, list) {
+			if (iter->done) {
+				victim = iter;
+				break;
+			}
+		}
 
-	result = _cache_mngt_lock_sync(cache);
-	if (result)
-		goto out_cache_put;
+		if (!victim) {
+			spin_unlock(&cas_async_op_lock);
+			_cache_mngt_async_op_free(&op->ref);
+			return -KCAS_ERR_ASYNC_OPS_LIMIT;
+		}
 
-	ocf_mngt_cache_standby_detach(cache, _cache_mngt_generic_complete,
-			&context);
+		list_del_init(&victim->list);
+		cas_async_op_count--;
+	}
 
-	wait_for_completion(&context.cmpl);
-	ocf_mngt_cache_unlock(cache);
+	op->cmd.op_id = cas_async_op_next_id++;
+	list_add_tail(&op->list, &cas_async_op_list);
+	cas_async_op_count++;
+	queue_work(cas_async_op_wq, &op->work);
+	spin_unlock(&cas_async_op_lock);
 
-out_cache_put:
-	ocf_mngt_cache_put(cache);
-out_module_put:
-	module_put(THIS_MODULE);
-	return result;
+	if (victim)
+		_cache_mngt_async_op_put(victim);
+
+	cmd->op_id = op->cmd.op_id;
+
+	return 0;
 }
 
-int cache_mngt_create_cache_standby_activate_cfg(
-		struct ocf_mngt_cache_standby_activate_config *cfg,
-		struct kcas_standby_activate *cmd)
+int cache_mngt_async_op_status(struct kcas_async_status *cmd)
 {
+	struct cas_async_op *op = NULL, *iter;
+	bool release = false;
+	uint64_t dirty;
 	int result;
 
-	if (cmd->cache_id == OCF_CACHE_ID_INVALID)
-		return -OCF_ERR_INVAL;
+	spin_lock(&cas_async_op_lock);
+	list_for_each_entry(iter, &cas_async_op_list, list) {
+		if (iter->cmd.op_id == cmd->op_id) {
+			op = iter;
+			kref_get(&op->ref);
+			break;
+		}
+	}
+	spin_unlock(&cas_async_op_lock);
 
-	memset(cfg, 0, sizeof(*cfg));
+	if (!op)
+		return -KCAS_ERR_ASYNC_OP_NOT_EXIST;
 
-	result = cache_mngt_create_cache_device_cfg(&cfg->device,
-			cmd->cache_path);
-	if (result)
-		return result;
+	if (cmd->wait) {
+		result = wait_for_completion_interruptible(&op->cmpl);
+		if (result) {
+			_cache_mngt_async_op_put(op);
+			return -KCAS_ERR_WAITING_INTERRUPTED;
+		}
+	}
 
-	cfg->open_cores = true;
+	result = _cache_mngt_async_op_get_dirty(&op->cmd, &dirty);
+
+	spin_lock(&cas_async_op_lock);
+	if (!op->done && !result)
+		op->dirty = dirty;
+
+	cmd->type = op->cmd.type;
+	cmd->cache_id = op->cmd.cache_id;
+	cmd->core_id = op->cmd.core_id;
+	cmd->done = op->done;
+	cmd->result = abs(op->result);
+	cmd->elapsed_ms = jiffies_to_msecs((op->done ? op->end : jiffies) -
+			op->start);
+	cmd->dirty_start = op->dirty_start;
+	cmd->dirty = op->dirty;
+
+	if (op->done && cmd->release && !list_empty(&op->list)) {
+		list_del_init(&op->list);
+		cas_async_op_count--;
+		release = true;
+	}
+	spin_unlock(&cas_async_op_lock);
+
+	if (release)
+		_cache_mngt_async_op_put(op);
+	_cache_mngt_async_op_put(op);
 
 	return 0;
 }
 
-static void _cache_mngt_detach_cache_complete(ocf_cache_t cache, void *priv,
-		int error)
+int cache_mngt_init_async_ops(void)
 {
-	struct _cache_mngt_async_context *context = priv;
-	int result;
+	cas_async_op_wq = alloc_workqueue("cas_mngt_async", WQ_UNBOUND, 0);
+	if (!cas_async_op_wq)
+		return -ENOMEM;
 
-	result = _cache_mngt_async_callee_set_result(context, error);
+	return 0;
+}
 
-	if (result != -KCAS_ERR_WAITING_INTERRUPTED)
-		return;
+void cache_mngt_deinit_async_ops(void)
+{
+	struct cas_async_op *op, *tmp;
 
-	kfree(context);
-	ocf_mngt_cache_unlock(cache);
-	kfree(context);
+	/* Waits for operations still running */
+	destroy_workqueue(cas_async_op_wq);
+
+	list_for_each_entry_safe(op, tmp, &cas_async_op_list, list) {
+		list_del(&op->list);
+		_cache_mngt_async_op_put(op);
+	}
+	cas_async_op_count = 0;
 }
 
-int cache_mngt_attach_device(const char *cache_name, size_t name_len,
-		const char *device, struct ocf_mngt_cache_attach_config *attach_cfg)
+static int _cache_mngt_dump_inflight_all_core(ocf_core_t core, void *cntx)
+{
+	//uint16_t core_id = OCF_CORE_ID_INVALID;
+	//core_id_from_name(&core_id, ocf_core_get_name(core));
+
+	ocf_volume_t core_vol = ocf_core_get_volume(core);
+	ocf_volume_dump_inflight(core_vol);
+	return 0;
+}
+
+int cache_mngt_dump_inflight(uint32_t cache_id)
 {
-	struct _cache_mngt_attach_context *context;
 	ocf_cache_t cache;
-	int result = 0;
+	ocf_volume_t cache_vol;
+	char cache_name[OCF_CACHE_NAME_SIZE] = {};
+	int result;
 
-	result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name,
-			OCF_CACHE_NAME_SIZE, &cache);
+	cache_name_from_id(cache_name, cache_id);
+	result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name, OCF_CACHE_NAME_SIZE, &cache);
 	if (result) {
-		ocf_volume_destroy(attach_cfg->device.volume);
-		goto err_get;
+		return result;
+	}
+
+	if (ocf_cache_is_standby(cache)) {
+		ocf_mngt_cache_put(cache);
+		return -OCF_ERR_CACHE_STANDBY;
 	}
 
 	result = _cache_mngt_lock_sync(cache);
 	if (result) {
-		ocf_volume_destroy(attach_cfg->device.volume);
-		goto err_lock;
+		ocf_mngt_cache_put(cache);
+		return result;
 	}
 
-	result = cache_mngt_check_bdev(&attach_cfg->device,
-			attach_cfg->force, true, cache);
+	cache_vol = ocf_cache_get_volume(cache);
+	ocf_volume_dump_inflight(cache_vol);
+
+	result = ocf_core_visit(cache, _cache_mngt_dump_inflight_all_core, NULL, false);
 	if (result) {
-		ocf_volume_destroy(attach_cfg->device.volume);
-		goto err_ctx;
+		ocf_mngt_cache_unlock(cache);
+		ocf_mngt_cache_put(cache);
+		return result;
 	}
 
-	context = kzalloc(sizeof(*context), GFP_KERNEL);
-	if (!context) {
-		ocf_volume_destroy(attach_cfg->device.volume);
-		result = -ENOMEM;
-		goto err_ctx;
+	ocf_mngt_cache_unlock(cache);
+	ocf_mngt_cache_put(cache);
+	return result;
+}
+
+struct _cache_mngt_inflight_context {
+	struct kcas_dump_inflight *cmd;
+	struct kcas_inflight_entry *entries;
+	uint32_t capacity;
+	uint32_t count;
+	uint64_t now;
+	bool enabled;
+};
+
+static int _cache_mngt_get_inflight_core(ocf_core_t core, void *cntx)
+{
+	struct _cache_mngt_inflight_context *ctx = cntx;
+	struct bd_object *bvol = bd_object(ocf_core_get_volume(core));
+	struct kcas_inflight_entry *entry;
+	struct cas_bd_inflight *inflight;
+	struct blk_data *data;
+	uint64_t age_us;
+	unsigned long flags;
+	int cpu;
+
+	if (!bvol->inflight)
+		return 0;
+	ctx->enabled = true;
+
+	for_each_possible_cpu(cpu) {
+		inflight = per_cpu_ptr(bvol->inflight, cpu);
+		spin_lock_irqsave(&inflight->lock, flags);
+		list_for_each_entry(data, &inflight->list, inflight_node) {
+			age_us = ctx->now > data->lat_start ?
+				div_u64(ctx->now - data->lat_start,
+						NSEC_PER_USEC) : 0;
+			ctx->cmd->age_hist[min_t(uint32_t, fls64(age_us),
+					KCAS_INFLIGHT_AGE_BUCKETS - 1)]++;
+
+			if (ctx->count < ctx->capacity) {
+				entry = &ctx->entries[ctx->count];
+				entry->core_id = ocf_core_get_id(core);
+				entry->dir = bio_data_dir(data->bio);
+				entry->stage = READ_ONCE(data->inflight_stage);
+				entry->queue = data->inflight_queue;
+				entry->bytes = data->master_size;
+				entry->addr = (uint64_t)CAS_BIO_BISECTOR(
+						data->bio) << SECTOR_SHIFT;
+				entry->age_us = age_us;
+			}
+			ctx->count++;
+		}
+		spin_unlock_irqrestore(&inflight->lock, flags);
 	}
 
-	context->device_cfg = attach_cfg->device;
+	return 0;
+}
 
-	_cache_mngt_async_context_init(&context->async);
+/* Collect inflight requests of all cores, see inflight_tracking parameter */
+int cache_mngt_get_inflight(struct kcas_dump_inflight *cmd_info)
+{
+	struct _cache_mngt_inflight_context ctx = { .cmd = cmd_info };
+	ocf_cache_t cache;
+	int result;
 
-	ocf_mngt_cache_attach(cache, attach_cfg, _cache_mngt_attach_complete,
-			context);
-	result = wait_for_completion_interruptible(&context->async.cmpl);
+	memset(cmd_info->age_hist, 0, sizeof(cmd_info->age_hist));
 
-	result = _cache_mngt_async_caller_set_result(&context->async, result);
-	if (result == -KCAS_ERR_WAITING_INTERRUPTED)
-		goto err_get;
+	/* Buffer is bounded, so that dump under load cannot exhaust memory */
+	ctx.capacity = min_t(uint32_t, cmd_info->entries_count, 1 << 20);
+	if (ctx.capacity) {
+		ctx.entries = vzalloc(ctx.capacity * sizeof(*ctx.entries));
+		if (!ctx.entries)
+			return -ENOMEM;
+	}
 
-	volume_set_no_merges_flag_helper(cache);
+	result = mngt_get_cache_by_id(cas_ctx, cmd_info->cache_id, &cache);
+	if (result)
+		goto free;
 
-	kfree(context);
-err_ctx:
-	ocf_mngt_cache_unlock(cache);
-err_lock:
+	if (ocf_cache_is_standby(cache)) {
+		result = -OCF_ERR_CACHE_STANDBY;
+		goto put;
+	}
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		goto put;
+
+	ctx.now = ktime_get_ns();
+	result = ocf_core_visit(cache, _cache_mngt_get_inflight_core, &ctx,
+			true);
+
+	ocf_mngt_cache_read_unlock(cache);
+
+	if (result)
+		goto put;
+
+	cmd_info->enabled = ctx.enabled;
+	if (ctx.capacity && copy_to_user((void __user *)cmd_info->entries,
+			ctx.entries, min(ctx.count, ctx.capacity) *
+			sizeof(*ctx.entries))) {
+		result = -EFAULT;
+	} else {
+		cmd_info->entries_count = ctx.count;
+	}
+
+put:
 	ocf_mngt_cache_put(cache);
-err_get:
+free:
+	vfree(ctx.entries);
 	return result;
 }
 
-int cache_mngt_activate(struct ocf_mngt_cache_standby_activate_config *cfg,
-		struct kcas_standby_activate *cmd)
+static int _cache_mngt_stats_collect(ocf_cache_t cache,
+		struct kcas_get_stats *stats)
 {
-	struct _cache_mngt_attach_context *context;
+	ocf_core_t core = NULL;
+	int result;
+
+	if (stats->core_id == OCF_CORE_ID_INVALID &&
+			stats->part_id == OCF_IO_CLASS_INVALID) {
+		return ocf_stats_collect_cache(cache, &stats->usage, &stats->req,
+				&stats->blocks, &stats->errors);
+	}
+
+	if (stats->part_id == OCF_IO_CLASS_INVALID) {
+		result = get_core_by_id(cache, stats->core_id, &core);
+		if (result)
+			return result;
+
+		return ocf_stats_collect_core(core, &stats->usage, &stats->req,
+				&stats->blocks, &stats->errors);
+	}
+
+	if (stats->core_id == OCF_CORE_ID_INVALID) {
+		return ocf_stats_collect_part_cache(cache, stats->part_id,
+				&stats->usage, &stats->req, &stats->blocks);
+	}
+
+	result = get_core_by_id(cache, stats->core_id, &core);
+	if (result)
+		return result;
+
+	return ocf_stats_collect_part_core(core, stats->part_id,
+			&stats->usage, &stats->req, &stats->blocks);
+}
+
+/*
+ * Statistics are collected whenever management lock can be taken right
+ * away. Otherwise, e.g. with management operation waiting behind long
+ * flush, last snapshot is returned instead of waiting for the lock.
+ */
+int cache_mngt_get_stats(struct kcas_get_stats *stats)
+{
+	int result;
 	ocf_cache_t cache;
-	struct cache_priv *cache_priv;
-	char cache_name[OCF_CACHE_NAME_SIZE];
-	int result = 0, rollback_result = 0;
 
-	if (!try_module_get(THIS_MODULE))
-		return -KCAS_ERR_SYSTEM;
+	result = mngt_get_cache_by_id(cas_ctx, stats->cache_id, &cache);
+	if (result)
+		return result;
+
+	if (ocf_mngt_cache_read_trylock(cache)) {
+		if (_cache_mngt_stats_snapshot_read(cache, stats))
+			goto put;
+
+		result = _cache_mngt_read_lock_sync(cache);
+		if (result)
+			goto put;
+	}
+
+	result = _cache_mngt_stats_collect(cache, stats);
+	if (!result)
+		_cache_mngt_stats_snapshot_store(cache, stats);
 
-	cache_name_from_id(cache_name, cmd->cache_id);
+	ocf_mngt_cache_read_unlock(cache);
+put:
+	ocf_mngt_cache_put(cache);
+	return result;
+}
 
-	result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name,
-			OCF_CACHE_NAME_SIZE, &cache);
-	if (result)
-		goto out_module_put;
+struct _cache_mngt_stats_bulk_ctx {
+	struct kcas_get_stats *entries;
+	struct ocf_io_class_info *class_info;
+	uint32_t capacity;
+	uint32_t count;
+};
 
-	if (!ocf_cache_is_standby(cache)) {
-		result = -OCF_ERR_CACHE_EXIST;
-		goto out_cache_put;
+static int _cache_mngt_stats_bulk_add(ocf_cache_t cache,
+		struct _cache_mngt_stats_bulk_ctx *ctx,
+		uint16_t core_id, uint16_t part_id)
+{
+	struct kcas_get_stats *stats;
+	int result;
+
+	if (ctx->count >= ctx->capacity) {
+		/* Only count entries which did not fit */
+		ctx->count++;
+		return 0;
 	}
 
-	result = _cache_mngt_lock_sync(cache);
-	if (result)
-		goto out_cache_put;
+	stats = &ctx->entries[ctx->count];
+	memset(stats, 0, sizeof(*stats));
+	stats->cache_id = ocf_cache_get_id(cache);
+	stats->core_id = core_id;
+	stats->part_id = part_id;
 
-	/*
-	 * We ignore partitions detected on the cache device despite we
-	 * know at this point that activate is gonna fail. We want OCF
-	 * to compare data on drive and in DRAM to provide more specific
-	 * error code.
-	 */
-	result = cache_mngt_check_bdev(&cfg->device, true, false, NULL);
+	result = _cache_mngt_stats_collect(cache, stats);
 	if (result)
-		goto out_cache_unlock;
+		return result;
 
-	context = kzalloc(sizeof(*context), GFP_KERNEL);
-	if (!context) {
-		result = -ENOMEM;
-		goto out_cache_unlock;
-	}
+	_cache_mngt_stats_snapshot_store(cache, stats);
+	ctx->count++;
 
-	strncpy(context->cache_path, cmd->cache_path, MAX_STR_LEN-1);
-	context->device_cfg = cfg->device;
-	context->cache = cache;
+	return 0;
+}
 
-	cache_priv = ocf_cache_get_priv(cache);
-	cache_priv->attach_context = context;
-	/* All the required memory has been alocated and initialized on cache_init,
-	 * just set the flag to allow deinit*/
-	context->priv_inited = true;
+static int _cache_mngt_stats_bulk_object(ocf_cache_t cache,
+		struct _cache_mngt_stats_bulk_ctx *ctx, uint16_t core_id,
+		bool io_classes)
+{
+	uint16_t part_id;
+	int result;
 
-	context->rollback_thread = cas_lazy_thread_create(cache_start_rollback,
-			context, "cas_cache_rollback_complete");
-	if (IS_ERR(context->rollback_thread)) {
-		result = PTR_ERR(context->rollback_thread);
-		goto err_free_context;
+	result = _cache_mngt_stats_bulk_add(cache, ctx, core_id,
+			OCF_IO_CLASS_INVALID);
+	if (result || !io_classes)
+		return result;
+
+	for (part_id = 0; part_id < OCF_USER_IO_CLASS_MAX; part_id++) {
+		result = ocf_cache_io_class_get_info(cache, part_id,
+				ctx->class_info);
+		if (result == -OCF_ERR_IO_CLASS_NOT_EXIST)
+			continue;
+		if (result)
+			return result;
+
+		result = _cache_mngt_stats_bulk_add(cache, ctx, core_id,
+				part_id);
+		if (result)
+			return result;
 	}
-	_cache_mngt_async_context_init(&context->async);
 
-	ocf_mngt_cache_standby_activate(cache, cfg, _cache_mngt_start_complete,
-			context);
-	result = wait_for_completion_interruptible(&context->async.cmpl);
+	return 0;
+}
 
-	result = _cache_mngt_async_caller_set_result(&context->async, result);
-	if (result == -KCAS_ERR_WAITING_INTERRUPTED)
-		goto out_cache_put;
-	if (result)
-		goto activate_err;
+/*
+ * Collects statistics of cache and all its cores (or of single core) and
+ * optionally of all configured io classes, all under single management
+ * lock acquisition. Entries are copied out to user buffer only after the
+ * lock is released.
+ */
+/* Counters of features of cache, called under management lock */
+static void _cache_mngt_get_feature_counters(ocf_cache_t cache,
+		struct kcas_cache_counters *counters)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	uint64_t stored, packed, indexed, shared;
+	struct cas_dram_tier *tier;
+	struct cas_compress *comp;
+	ocf_volume_t volume;
+	uint32_t i;
 
-	result = _cache_start_finalize(cache, -1, true);
-	if (result)
-		goto finalize_err;
+	if (cache_priv->trim) {
+		counters->cache_trimmed =
+			cas_cache_trim_get_trimmed(cache_priv->trim);
+	}
 
-activate_err:
-	cas_lazy_thread_stop(context->rollback_thread);
+	tier = rcu_access_pointer(cache_priv->dram_tier);
+	if (tier) {
+		cas_dram_tier_get_stats(tier, &counters->dram_tier_used,
+				&counters->dram_tier_hits,
+				&counters->dram_tier_misses);
+		counters->dram_tier_used <<= PAGE_SHIFT;
+	}
 
-err_free_context:
-	kfree(context);
-	cache_priv->attach_context = NULL;
+	counters->slow_bypass_time_ms = div64_u64(
+			_cache_mngt_slow_bypass_ns(cache_priv), NSEC_PER_MSEC);
+	counters->slow_bypass_reads = atomic64_read(
+			&cache_priv->slow_bypass.reads);
 
-out_cache_unlock:
-	ocf_mngt_cache_unlock(cache);
-out_cache_put:
-	ocf_mngt_cache_put(cache);
-out_module_put:
-	module_put(THIS_MODULE);
-	return result;
+	counters->seq_absorb_time_ms = cache_priv->seq_absorb.total_ms;
+	if (cache_priv->seq_absorb.active) {
+		counters->seq_absorb_time_ms += jiffies_to_msecs(jiffies -
+				cache_priv->seq_absorb.since);
+	}
 
-finalize_err:
-	_cache_mngt_async_context_reinit(&context->async);
-	ocf_mngt_cache_stop(cache, _cache_mngt_cache_stop_rollback_complete,
-			context);
-	rollback_result = wait_for_completion_interruptible(&context->async.cmpl);
+	if (!ocf_cache_is_device_attached(cache))
+		return;
 
-	rollback_result = _cache_mngt_async_caller_set_result(&context->async,
-							rollback_result);
+	volume = ocf_cache_get_volume(cache);
+	counters->checksum_errors = block_dev_csum_get_errors(volume);
+	block_dev_meta_co_get_stats(volume, &counters->meta_coalesce_absorbed,
+			&counters->meta_coalesce_writes);
+	counters->meta_elided = block_dev_meta_elide_get_elided(volume);
 
-	if (rollback_result != -KCAS_ERR_WAITING_INTERRUPTED)
-		kfree(context);
+	comp = bd_object(volume)->comp;
+	if (!comp)
+		return;
 
-	module_put(THIS_MODULE);
-	return result;
+	for (i = 0; i <= CAS_COMPRESS_IO_CLASS_OTHER; i++) {
+		cas_compress_get_stats(comp, i, &stored, &packed);
+		counters->compress_stored += stored;
+		counters->compress_packed += packed;
+	}
+
+	/* Each indexed slot is written once for all blocks sharing it */
+	cas_compress_get_dedup_stats(comp, &indexed, &shared);
+	counters->dedup_indexed = indexed * CAS_COMPRESS_BLOCK_SIZE;
+	counters->dedup_saved = (shared - indexed) * CAS_COMPRESS_BLOCK_SIZE;
 }
 
-static bool _has_fs_meta_cb(ocf_cache_t cache, ocf_core_id_t core_id, uint64_t lba_beg, uint64_t lba_end, void *args)
+/* Called under management lock */
+static void _cache_mngt_get_counters(ocf_cache_t cache,
+		struct kcas_cache_counters *counters)
 {
 	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
-	struct fs_meta_map *map = &cache_priv->fs_meta_dict[core_id];
-	struct fs_meta_lba *lba_table = map->data;
-	uint32_t lba_count = map->length / sizeof(struct fs_meta_lba);
-	uint32_t i;
+	int i;
 
-	if (lba_table == NULL || lba_count == 0)
-		return false;
+	memset(counters, 0, sizeof(*counters));
+	if (!cache_priv)
+		return;
 
-	for (i = 0; i < lba_count; i++) {
-		if (lba_end <= (lba_table[i].lba_beg * (1ULL << 12)))
-			break;
-		if (lba_beg >= (lba_table[i].lba_end * (1ULL << 12)))
+	counters->defer_pool_exhausted = env_atomic64_read(
+			&cache_priv->defer_pool_exhausted);
+	counters->classifier_invocations = cas_cls_get_invocations(cache);
+	counters->flushes_elided = _cache_mngt_get_flushes_elided(cache);
+	counters->standby_writes = env_atomic64_read(
+			&cache_priv->standby_writes);
+	counters->activate_time_ms = cache_priv->activate_ms;
+	_cache_mngt_get_feature_counters(cache, counters);
+
+	for (i = 0; i < nr_cpu_ids; i++) {
+		if (!cache_priv_owns_queue(cache_priv, i))
 			continue;
-		return true;
+		cas_get_queue_thread_poll_stats(
+				cache_priv->queues[i].worker_queue,
+				&counters->queue_polls, &counters->queue_sleeps);
+		cas_get_queue_thread_poll_stats(
+				cache_priv->queues[i].porter_queue,
+				&counters->queue_polls, &counters->queue_sleeps);
+		if (cache_priv->queues[i].idle_queue) {
+			cas_get_queue_thread_poll_stats(
+					cache_priv->queues[i].idle_queue,
+					&counters->queue_polls,
+					&counters->queue_sleeps);
+		}
 	}
-	return false;
 }
 
-int cache_mngt_init_instance(struct ocf_mngt_cache_config *cfg,
-		struct ocf_mngt_cache_attach_config *attach_cfg,
-		struct kcas_start_cache *cmd)
+int cache_mngt_get_stats_bulk(struct kcas_get_stats_bulk *cmd_info)
 {
-	struct _cache_mngt_attach_context *context;
-	ocf_cache_t cache, tmp_cache = NULL;
-	char cache_name_meta[OCF_CACHE_NAME_SIZE];
+	struct _cache_mngt_stats_bulk_ctx ctx = {};
+	struct kcas_cgroup_stats *cgroup_entries = NULL;
+	uint32_t cgroup_count = 0, cgroup_count_out;
 	struct cache_priv *cache_priv;
-	int result = 0, rollback_result = 0;
-	ocf_cache_mode_t cache_mode_meta;
-	ocf_cache_line_size_t cache_line_size_meta;
-	uint16_t i;
+	struct ocf_cache_info info;
+	ocf_cache_t cache;
+	ocf_core_t core;
+	uint32_t objects;
+	uint16_t i, j;
+	int result;
 
-	switch (cmd->init_cache) {
-		case CACHE_INIT_STANDBY_NEW:
-		case CACHE_INIT_STANDBY_LOAD:
-			ocf_volume_destroy(attach_cfg->device.volume);
-			printk(KERN_ERR "Standby mode is not supported!\n");
-			return -ENOTSUP;
-		default:
-			break;
+	if (!cmd_info->entries)
+		return -EINVAL;
+
+	if (cmd_info->io_classes) {
+		ctx.class_info = vmalloc(sizeof(*ctx.class_info));
+		if (!ctx.class_info)
+			return -ENOMEM;
 	}
 
-	if (!try_module_get(THIS_MODULE)) {
-		ocf_volume_destroy(attach_cfg->device.volume);
-		return -KCAS_ERR_SYSTEM;
+	result = mngt_get_cache_by_id(cas_ctx, cmd_info->cache_id, &cache);
+	if (result)
+		goto free;
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		goto put;
+
+	/* Standby cache has counters, but no statistics to be collected */
+	if (ocf_cache_is_standby(cache)) {
+		if (cmd_info->core_id == OCF_CORE_ID_INVALID)
+			_cache_mngt_get_counters(cache, &cmd_info->counters);
+		else
+			result = -OCF_ERR_CACHE_STANDBY;
+		goto unlock;
 	}
 
-	result = cache_mngt_check_bdev(&attach_cfg->device, attach_cfg->force, false, NULL);
-	if (result) {
-		ocf_volume_destroy(attach_cfg->device.volume);
-		module_put(THIS_MODULE);
-		return result;
+	result = ocf_cache_get_info(cache, &info);
+	if (result)
+		goto unlock;
+
+	objects = cmd_info->core_id == OCF_CORE_ID_INVALID ?
+			info.core_count + 1 : 1;
+	if (cmd_info->io_classes)
+		objects *= OCF_USER_IO_CLASS_MAX + 1;
+
+	ctx.capacity = min(cmd_info->entries_count, objects);
+	if (ctx.capacity) {
+		ctx.entries = vmalloc(ctx.capacity * sizeof(*ctx.entries));
+		if (!ctx.entries) {
+			result = -ENOMEM;
+			goto unlock;
+		}
 	}
 
-	switch (cmd->init_cache) {
-	case CACHE_INIT_LOAD:
-	case CACHE_INIT_STANDBY_LOAD:
-		result = _cache_mngt_probe_metadata(cmd->cache_path_name,
-				cache_name_meta, &cache_mode_meta,
-				&cache_line_size_meta);
-		if (result) {
-			ocf_volume_destroy(attach_cfg->device.volume);
-			module_put(THIS_MODULE);
-			return result;
+	if (cmd_info->core_id != OCF_CORE_ID_INVALID) {
+		result = get_core_by_id(cache, cmd_info->core_id, &core);
+		if (!result) {
+			result = _cache_mngt_stats_bulk_object(cache, &ctx,
+					cmd_info->core_id,
+					cmd_info->io_classes);
 		}
+		goto unlock;
+	}
 
-		/* Need to return name from metadata now for caller to properly
-		 * communicate the error to user */
-		if (cache_id_from_name(&cmd->cache_id, cache_name_meta)) {
-			printk(KERN_ERR "Improper cache name format on %s.\n",
-					cmd->cache_path_name);
+	_cache_mngt_get_counters(cache, &cmd_info->counters);
 
-			ocf_volume_destroy(attach_cfg->device.volume);
-			module_put(THIS_MODULE);
-			return -OCF_ERR_START_CACHE_FAIL;
-		}
+	result = _cache_mngt_stats_bulk_object(cache, &ctx,
+			OCF_CORE_ID_INVALID, cmd_info->io_classes);
 
-		result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name_meta,
-				OCF_CACHE_NAME_SIZE, &tmp_cache);
+	for (i = 0, j = 0; !result && j < info.core_count &&
+			i < OCF_CORE_MAX; i++) {
+		if (get_core_by_id(cache, i, &core))
+			continue;
 
-		if (result != -OCF_ERR_CACHE_NOT_EXIST) {
-			printk(KERN_ERR "Can't load %s. Cache using that name "
-					"already exists.\n", cache_name_meta);
+		result = _cache_mngt_stats_bulk_object(cache, &ctx, i,
+				cmd_info->io_classes);
+		j++;
+	}
 
-			ocf_mngt_cache_put(tmp_cache);
-			ocf_volume_destroy(attach_cfg->device.volume);
-			module_put(THIS_MODULE);
-			return -OCF_ERR_CACHE_EXIST;
+unlock:
+	/* Statistics of cgroups are kept by cache, whichever core is asked */
+	cache_priv = ocf_cache_get_priv(cache);
+	cmd_info->cgroup_stats = cache_priv && cache_priv->cgroup_stats;
+	if (!result && cmd_info->cgroup_stats && cmd_info->cgroup_entries) {
+		cgroup_count = min_t(uint32_t, cmd_info->cgroup_entries_count,
+				KCAS_CGROUP_STATS_MAX + 1);
+		if (cgroup_count) {
+			cgroup_entries = vmalloc(cgroup_count *
+					sizeof(*cgroup_entries));
+			if (!cgroup_entries)
+				result = -ENOMEM;
 		}
+		if (!result) {
+			cas_cgroup_stats_read(cache_priv->cgroup_stats,
+					cgroup_entries, &cgroup_count);
+		}
+	}
+	ocf_mngt_cache_read_unlock(cache);
 
-		result = 0;
-		strscpy(cfg->name, cache_name_meta, OCF_CACHE_NAME_SIZE);
-		cfg->cache_mode = cache_mode_meta;
-		cfg->cache_line_size = cache_line_size_meta;
-	default:
-		break;
+	if (!result && ctx.capacity) {
+		if (copy_to_user((void __user *)cmd_info->entries, ctx.entries,
+				min(ctx.count, ctx.capacity) *
+				sizeof(*ctx.entries))) {
+			result = -EFAULT;
+		}
+	}
+	if (!result && cgroup_entries) {
+		cgroup_count_out = min(cgroup_count,
+				cmd_info->cgroup_entries_count);
+		if (copy_to_user((void __user *)cmd_info->cgroup_entries,
+				cgroup_entries, cgroup_count_out *
+				sizeof(*cgroup_entries))) {
+			result = -EFAULT;
+		}
+	}
+	if (!result) {
+		cmd_info->entries_count = ctx.count;
+		if (cmd_info->cgroup_entries)
+			cmd_info->cgroup_entries_count = cgroup_count;
 	}
 
-	context = kzalloc(sizeof(*context), GFP_KERNEL);
-	if (!context) {
-		ocf_volume_destroy(attach_cfg->device.volume);
-		module_put(THIS_MODULE);
-		return -ENOMEM;
+	vfree(cgroup_entries);
+	vfree(ctx.entries);
+put:
+	ocf_mngt_cache_put(cache);
+free:
+	vfree(ctx.class_info);
+	return result;
+}
+
+static void _cache_mngt_lat_hist_core(ocf_core_t core,
+		struct kcas_get_lat_hist *cmd_info)
+{
+	struct bd_object *bvol = bd_object(ocf_core_get_volume(core));
+	ocf_part_id_t part_id;
+	int dir, stage;
+
+	/* Stages are not split by io class */
+	if (bvol->stage_hist) {
+		cmd_info->stage_sample = stage_latency_sample;
+		for (dir = READ; dir <= WRITE; dir++) {
+			for (stage = 0; stage < KCAS_IO_STAGE_MAX; stage++) {
+				cas_lat_hist_sum(
+					&bvol->stage_hist->stage[dir][stage],
+					&cmd_info->stage[dir][stage]);
+			}
+		}
 	}
 
-	context->rollback_thread = cas_lazy_thread_create(cache_start_rollback,
-			context, "cas_cache_rollback_complete");
-	if (IS_ERR(context->rollback_thread)) {
-		result = PTR_ERR(context->rollback_thread);
-		kfree(context);
-		ocf_volume_destroy(attach_cfg->device.volume);
-		module_put(THIS_MODULE);
-		return result;
+	if (!bvol->lat_hist)
+		return;
+
+	cmd_info->enabled = true;
+
+	for (dir = READ; dir <= WRITE; dir++) {
+		cas_lat_hist_sum(&bvol->lat_hist->dev[dir],
+				&cmd_info->hist[KCAS_LAT_HIST_CORE_DEV_RD + dir]);
+
+		for (part_id = 0; part_id < OCF_USER_IO_CLASS_MAX; part_id++) {
+			if (cmd_info->part_id != OCF_IO_CLASS_INVALID &&
+					cmd_info->part_id != part_id) {
+				continue;
+			}
+
+			cas_lat_hist_sum(&bvol->lat_hist->exp_obj[part_id][dir],
+				&cmd_info->hist[KCAS_LAT_HIST_EXP_OBJ_RD + dir]);
+		}
 	}
+}
 
-	strncpy(context->cache_path, cmd->cache_path_name, MAX_STR_LEN-1);
-	context->device_cfg = attach_cfg->device;
-	_cache_mngt_async_context_init(&context->async);
+/*
+ * Cache device histograms are cache wide, as bios sent to cache device
+ * are not attributed to cores.
+ */
+int cache_mngt_get_lat_hist(struct kcas_get_lat_hist *cmd_info)
+{
+	struct bd_object *cache_bvol;
+	ocf_cache_t cache;
+	ocf_core_t core;
+	uint32_t core_count;
+	uint16_t i, j;
+	int dir, result;
 
-	/* Start cache. Returned cache instance will be locked as it was set
-	 * in configuration.
-	 */
-	result = ocf_mngt_cache_start(cas_ctx, &cache, cfg, NULL);
-	if (result) {
-		cas_lazy_thread_stop(context->rollback_thread);
-		kfree(context);
-		ocf_volume_destroy(attach_cfg->device.volume);
-		module_put(THIS_MODULE);
-		return result;
+	if (cmd_info->part_id != OCF_IO_CLASS_INVALID &&
+			cmd_info->part_id >= OCF_USER_IO_CLASS_MAX) {
+		return -OCF_ERR_INVAL;
 	}
-	context->cache = cache;
 
-	result = _cache_mngt_cache_priv_init(cache);
-	if (result)
-		goto err_deinit_config;
-	context->priv_inited = true;
+	memset(cmd_info->hist, 0, sizeof(cmd_info->hist));
+	memset(cmd_info->stage, 0, sizeof(cmd_info->stage));
+	cmd_info->enabled = false;
+	cmd_info->stage_sample = 0;
 
-	result = _cache_mngt_start_queues(cache);
+	result = mngt_get_cache_by_id(cas_ctx, cmd_info->cache_id, &cache);
 	if (result)
-		goto err_deinit_config;
+		return result;
 
-	cache_priv = ocf_cache_get_priv(cache);
-	cache_priv->attach_context = context;
-	ocf_cache_set_hook_has_fs_meta(cache, _has_fs_meta_cb, NULL);
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		goto put;
 
-	switch (cmd->init_cache) {
-	case CACHE_INIT_NEW:
-		ocf_mngt_cache_attach(cache, attach_cfg,
-				_cache_mngt_start_complete, context);
-		break;
-	case CACHE_INIT_LOAD:
-		for (i = 0; i < OCF_CORE_MAX; i ++) {
-			if (cmd->fs_meta_dict[i].length && cmd->fs_meta_dict[i].data) {
-				cache_priv->fs_meta_dict[i].data = vmalloc(cmd->fs_meta_dict[i].length);
-				memcpy(cache_priv->fs_meta_dict[i].data, cmd->fs_meta_dict[i].data, cmd->fs_meta_dict[i].length);
-				cache_priv->fs_meta_dict[i].length = cmd->fs_meta_dict[i].length;
+	if (ocf_cache_is_device_attached(cache)) {
+		cache_bvol = bd_object(ocf_cache_get_volume(cache));
+		if (cache_bvol->lat_hist) {
+			cmd_info->enabled = true;
+			for (dir = READ; dir <= WRITE; dir++) {
+				cas_lat_hist_sum(&cache_bvol->lat_hist->dev[dir],
+					&cmd_info->hist[
+						KCAS_LAT_HIST_CACHE_DEV_RD + dir]);
 			}
 		}
-		ocf_mngt_cache_load(cache, attach_cfg,
-				_cache_mngt_start_complete, context);
-		break;
-	case CACHE_INIT_STANDBY_NEW:
-		ocf_mngt_cache_standby_attach(cache, attach_cfg,
-				_cache_mngt_start_complete, context);
-		break;
-	case CACHE_INIT_STANDBY_LOAD:
-		ocf_mngt_cache_standby_load(cache, attach_cfg,
-				_cache_mngt_start_complete, context);
-		break;
-	default:
-		result = -OCF_ERR_INVAL;
-		goto err;
 	}
-	result = wait_for_completion_interruptible(&context->async.cmpl);
 
-	result = _cache_mngt_async_caller_set_result(&context->async, result);
-	if (result == -KCAS_ERR_WAITING_INTERRUPTED)
-		return result;
+	if (cmd_info->core_id != OCF_CORE_ID_INVALID) {
+		result = get_core_by_id(cache, cmd_info->core_id, &core);
+		if (!result && ocf_core_get_state(core) ==
+				ocf_core_state_active) {
+			_cache_mngt_lat_hist_core(core, cmd_info);
+		}
+		goto unlock;
+	}
 
-	if (result)
-		goto err;
+	core_count = ocf_cache_get_core_count(cache);
+	for (i = 0, j = 0; j < core_count && i < OCF_CORE_MAX; i++) {
+		if (get_core_by_id(cache, i, &core))
+			continue;
 
-	result = _cache_start_finalize(cache, cmd->init_cache, false);
-	if (result)
-		goto err;
+		if (ocf_core_get_state(core) == ocf_core_state_active)
+			_cache_mngt_lat_hist_core(core, cmd_info);
+		j++;
+	}
 
-	cas_lazy_thread_stop(context->rollback_thread);
+unlock:
+	ocf_mngt_cache_read_unlock(cache);
+put:
+	ocf_mngt_cache_put(cache);
+	return result;
+}
 
-	kfree(context);
-	cache_priv->attach_context = NULL;
+int cache_mngt_get_heatmap(struct kcas_get_heatmap *cmd_info)
+{
+	struct kcas_heatmap_bucket *bucket;
+	struct cas_bd_heatmap *cpu_map;
+	struct bd_object *bvol;
+	ocf_cache_t cache;
+	ocf_core_t core;
+	uint64_t core_reads;
+	int cpu, i, result;
 
-	ocf_mngt_cache_unlock(cache);
+	memset(cmd_info->buckets, 0, sizeof(cmd_info->buckets));
+	cmd_info->enabled = false;
+	cmd_info->bucket_sectors = 0;
 
-	return result;
+	result = mngt_get_cache_by_id(cas_ctx, cmd_info->cache_id, &cache);
+	if (result)
+		return result;
 
-err_deinit_config:
-	ocf_volume_destroy(attach_cfg->device.volume);
-err:
-	cmd->min_free_ram = context->min_free_ram;
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		goto put;
 
-	_cache_mngt_async_context_reinit(&context->async);
-	ocf_mngt_cache_stop(cache, _cache_mngt_cache_stop_rollback_complete,
-			context);
-	rollback_result = wait_for_completion_interruptible(&context->async.cmpl);
+	result = get_core_by_id(cache, cmd_info->core_id, &core);
+	if (result)
+		goto unlock;
 
-	rollback_result = _cache_mngt_async_caller_set_result(&context->async,
-			rollback_result);
+	bvol = bd_object(ocf_core_get_volume(core));
+	if (ocf_core_get_state(core) != ocf_core_state_active ||
+			!bvol->heatmap) {
+		goto unlock;
+	}
 
-	if (rollback_result != -KCAS_ERR_WAITING_INTERRUPTED)
-		kfree(context);
+	cmd_info->enabled = true;
+	cmd_info->bucket_sectors = 1ULL << bvol->heatmap_shift;
+
+	for (i = 0; i < KCAS_HEATMAP_BUCKETS; i++) {
+		bucket = &cmd_info->buckets[i];
+		core_reads = 0;
+		for_each_possible_cpu(cpu) {
+			cpu_map = per_cpu_ptr(bvol->heatmap, cpu);
+			bucket->reads += cpu_map->buckets[i].reads;
+			bucket->writes += cpu_map->buckets[i].writes;
+			core_reads += cpu_map->buckets[i].core_reads;
+		}
+		/* Core reads are split and may straddle buckets */
+		bucket->read_hits = bucket->reads > core_reads ?
+			bucket->reads - core_reads : 0;
+	}
 
+unlock:
+	ocf_mngt_cache_read_unlock(cache);
+put:
+	ocf_mngt_cache_put(cache);
 	return result;
 }
 
-/**
- * @brief routine implementing dynamic sequential cutoff parameter switching
- * @param[in] cache cache to which the change pertains
- * @param[in] core core to which the change pertains
- * or NULL for setting value for all cores attached to specified cache
- * @param[in] thresh new sequential cutoff threshold value
- * @return exit code of successful completion is 0;
- * nonzero exit code means failure
- */
-
-int cache_mngt_set_seq_cutoff_threshold(ocf_cache_t cache, ocf_core_t core,
-		uint32_t thresh)
+int cache_mngt_get_mrc(struct kcas_get_mrc *cmd_info)
 {
+	struct bd_object *bvol;
+	ocf_cache_t cache;
+	ocf_core_t core;
 	int result;
 
-	result = _cache_mngt_lock_sync(cache);
+	memset(cmd_info->hist, 0, sizeof(cmd_info->hist));
+	cmd_info->cold = 0;
+	cmd_info->sample_shift = 0;
+	cmd_info->enabled = false;
+
+	result = mngt_get_cache_by_id(cas_ctx, cmd_info->cache_id, &cache);
 	if (result)
 		return result;
 
-	if (core) {
-		result = ocf_mngt_core_set_seq_cutoff_threshold(core, thresh);
-	} else {
-		result = ocf_mngt_core_set_seq_cutoff_threshold_all(cache,
-				thresh);
-	}
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		goto put;
 
+	result = get_core_by_id(cache, cmd_info->core_id, &core);
 	if (result)
-		goto out;
+		goto unlock;
 
-	result = _cache_mngt_save_sync(cache);
+	bvol = bd_object(ocf_core_get_volume(core));
+	if (ocf_core_get_state(core) == ocf_core_state_active && bvol->mrc) {
+		cmd_info->enabled = true;
+		cas_mrc_get(bvol->mrc, cmd_info);
+	}
 
-out:
-	ocf_mngt_cache_unlock(cache);
+unlock:
+	ocf_mngt_cache_read_unlock(cache);
+put:
+	ocf_mngt_cache_put(cache);
 	return result;
 }
 
-/**
- * @brief routine implementing dynamic sequential cutoff parameter switching
- * @param[in] cache cache to which the change pertains
- * @param[in] core core to which the change pertains
- * or NULL for setting value for all cores attached to specified cache
- * @param[in] policy new sequential cutoff policy value
- * @return exit code of successful completion is 0;
- * nonzero exit code means failure
- */
-
-int cache_mngt_set_seq_cutoff_policy(ocf_cache_t cache, ocf_core_t core,
-		ocf_seq_cutoff_policy policy)
+int cache_mngt_get_hot_set(struct kcas_get_hot_set *cmd_info)
 {
+	struct kcas_hot_region *regions = NULL;
+	struct bd_object *bvol;
+	ocf_cache_t cache;
+	ocf_core_t core;
+	uint32_t count;
 	int result;
 
-	result = _cache_mngt_lock_sync(cache);
+	count = min_t(uint32_t, cmd_info->regions_count,
+			CAS_HOT_SET_REGIONS_MAX);
+	cmd_info->regions_count = 0;
+	cmd_info->enabled = false;
+
+	if (count) {
+		regions = vmalloc(count * sizeof(*regions));
+		if (!regions)
+			return -ENOMEM;
+	}
+
+	result = mngt_get_cache_by_id(cas_ctx, cmd_info->cache_id, &cache);
 	if (result)
-		return result;
+		goto free;
 
-	if (core)
-		result = ocf_mngt_core_set_seq_cutoff_policy(core, policy);
-	else
-		result = ocf_mngt_core_set_seq_cutoff_policy_all(cache, policy);
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		goto put;
 
+	result = get_core_by_id(cache, cmd_info->core_id, &core);
 	if (result)
-		goto out;
+		goto unlock;
 
-	result = _cache_mngt_save_sync(cache);
+	bvol = bd_object(ocf_core_get_volume(core));
+	if (ocf_core_get_state(core) != ocf_core_state_active ||
+			!bvol->hot_set) {
+		goto unlock;
+	}
 
-out:
-	ocf_mngt_cache_unlock(cache);
+	cmd_info->enabled = true;
+	if (regions) {
+		result = cas_hot_set_get(bvol->hot_set, regions, &count,
+				cmd_info->decay);
+	}
+
+unlock:
+	ocf_mngt_cache_read_unlock(cache);
+put:
+	ocf_mngt_cache_put(cache);
+
+	if (!result && cmd_info->enabled && regions) {
+		if (copy_to_user((void __user *)cmd_info->regions, regions,
+				count * sizeof(*regions))) {
+			result = -EFAULT;
+		} else {
+			cmd_info->regions_count = count;
+		}
+	}
+free:
+	vfree(regions);
 	return result;
 }
 
-/**
- * @brief routine implementing dynamic sequential cutoff parameter switching
- * @param[in] cache cache to which the change pertains
- * @param[in] core core to which the change pertains
- * or NULL for setting value for all cores attached to specified cache
- * @param[in] count new sequential cutoff promotion request count value
- * @return exit code of successful completion is 0;
- * nonzero exit code means failure
- */
-
-static int cache_mngt_set_seq_cutoff_promotion_count(ocf_cache_t cache,
-		ocf_core_t core, uint32_t count)
+int cache_mngt_get_trace(struct kcas_get_trace *cmd_info)
 {
+	struct kcas_trace_record *records = NULL;
+	struct bd_object *bvol;
+	ocf_cache_t cache;
+	ocf_core_t core;
+	uint32_t count;
 	int result;
 
-	result = _cache_mngt_lock_sync(cache);
-	if (result)
-		return result;
+	count = min_t(uint32_t, cmd_info->records_count,
+			KCAS_TRACE_RECORDS_MAX);
+	cmd_info->records_count = 0;
+	cmd_info->lost = 0;
+	cmd_info->enabled = false;
 
-	if (core) {
-		result = ocf_mngt_core_set_seq_cutoff_promotion_count(core,
-				count);
-	} else {
-		result = ocf_mngt_core_set_seq_cutoff_promotion_count_all(cache,
-				count);
+	if (count) {
+		records = vmalloc(count * sizeof(*records));
+		if (!records)
+			return -ENOMEM;
 	}
 
+	result = mngt_get_cache_by_id(cas_ctx, cmd_info->cache_id, &cache);
 	if (result)
-		goto out;
+		goto free;
 
-	result = _cache_mngt_save_sync(cache);
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		goto put;
 
-out:
-	ocf_mngt_cache_unlock(cache);
+	result = get_core_by_id(cache, cmd_info->core_id, &core);
+	if (result)
+		goto unlock;
+
+	bvol = bd_object(ocf_core_get_volume(core));
+	if (ocf_core_get_state(core) != ocf_core_state_active ||
+			!bvol->io_trace) {
+		goto unlock;
+	}
+
+	cmd_info->enabled = true;
+	if (records) {
+		cas_io_trace_get(bvol->io_trace, records, &count,
+				&cmd_info->lost);
+	}
+
+unlock:
+	ocf_mngt_cache_read_unlock(cache);
+put:
+	ocf_mngt_cache_put(cache);
+
+	if (!result && cmd_info->enabled && records) {
+		if (copy_to_user((void __user *)cmd_info->records, records,
+				count * sizeof(*records))) {
+			result = -EFAULT;
+		} else {
+			cmd_info->records_count = count;
+		}
+	}
+free:
+	vfree(records);
 	return result;
 }
 
-/**
- * @brief Get sequential cutoff threshold value
- * @param[in] core OCF core
- * @param[out] thresh sequential cutoff threshold value
- * @return exit code of successful completion is 0;
- * nonzero exit code means failure
- */
-
-int cache_mngt_get_seq_cutoff_threshold(ocf_core_t core, uint32_t *thresh)
+int cache_mngt_prefetch(struct kcas_prefetch *cmd_info)
 {
-	ocf_cache_t cache = ocf_core_get_cache(core);
+	struct kcas_prefetch_range *ranges = NULL;
+	ocf_cache_t cache;
+	ocf_core_t core;
 	int result;
 
+	if (cmd_info->ranges_count > KCAS_PREFETCH_RANGES_MAX ||
+			cmd_info->io_class >= OCF_USER_IO_CLASS_MAX)
+		return -EINVAL;
+
+	if (cmd_info->ranges && cmd_info->ranges_count) {
+		ranges = vmalloc(cmd_info->ranges_count * sizeof(*ranges));
+		if (!ranges)
+			return -ENOMEM;
+
+		if (copy_from_user(ranges,
+				(void __user *)cmd_info->ranges,
+				cmd_info->ranges_count * sizeof(*ranges))) {
+			result = -EFAULT;
+			goto free;
+		}
+	}
+
+	result = mngt_get_cache_by_id(cas_ctx, cmd_info->cache_id, &cache);
+	if (result)
+		goto free;
+
 	result = _cache_mngt_read_lock_sync(cache);
 	if (result)
-		return result;
+		goto put;
 
-	result = ocf_mngt_core_get_seq_cutoff_threshold(core, thresh);
+	if (ranges) {
+		result = get_core_by_id(cache, cmd_info->core_id, &core);
+		if (result)
+			goto unlock;
+
+		if (ocf_core_get_state(core) != ocf_core_state_active) {
+			result = -OCF_ERR_CORE_IN_INACTIVE_STATE;
+			goto unlock;
+		}
+
+		result = cas_prefetch_queue(cache, core, ranges,
+				cmd_info->ranges_count, cmd_info->io_class,
+				cmd_info->rate_limit);
+		if (result)
+			goto unlock;
+	}
 
+	cas_prefetch_get_progress(cache, cmd_info);
+
+unlock:
 	ocf_mngt_cache_read_unlock(cache);
+put:
+	ocf_mngt_cache_put(cache);
+free:
+	vfree(ranges);
 	return result;
 }
 
-/**
- * @brief Get sequential cutoff policy
- * @param[in] core OCF core
- * @param[out] thresh sequential cutoff policy
- * @return exit code of successful completion is 0;
- * nonzero exit code means failure
- */
-
-int cache_mngt_get_seq_cutoff_policy(ocf_core_t core,
-		ocf_seq_cutoff_policy *policy)
+int cache_mngt_bench(struct kcas_bench *cmd_info)
 {
-	ocf_cache_t cache = ocf_core_get_cache(core);
+	ocf_cache_t cache;
+	ocf_core_t core;
 	int result;
 
-	result = _cache_mngt_read_lock_sync(cache);
+	result = mngt_get_cache_by_id(cas_ctx, cmd_info->cache_id, &cache);
 	if (result)
 		return result;
 
-	result = ocf_mngt_core_get_seq_cutoff_policy(core, policy);
+	/* Core can't be removed while its exported object is benchmarked */
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		goto put;
+
+	result = get_core_by_id(cache, cmd_info->core_id, &core);
+	if (result)
+		goto unlock;
 
+	if (ocf_core_get_state(core) != ocf_core_state_active) {
+		result = -OCF_ERR_CORE_IN_INACTIVE_STATE;
+		goto unlock;
+	}
+
+	result = cas_bench_run(core, cmd_info);
+
+unlock:
 	ocf_mngt_cache_read_unlock(cache);
+put:
+	ocf_mngt_cache_put(cache);
 	return result;
 }
 
-/**
- * @brief Get sequential cutoff promotion request count value
- * @param[in] core OCF core
- * @param[out] count sequential cutoff promotion request count value
- * @return exit code of successful completion is 0;
- * nonzero exit code means failure
- */
+static void _cache_mngt_queue_stats_add(ocf_queue_t queue, uint32_t cpu,
+		uint32_t type, struct kcas_queue_stats_entry *entries,
+		uint32_t capacity, uint32_t *count)
+{
+	struct kcas_queue_stats_entry *stats;
 
-static int cache_mngt_get_seq_cutoff_promotion_count(ocf_core_t core,
-		uint32_t *count)
+	if (*count < capacity) {
+		stats = &entries[*count];
+		memset(stats, 0, sizeof(*stats));
+		stats->cpu = cpu;
+		stats->type = type;
+		cas_get_queue_thread_stats(queue, stats);
+	}
+
+	(*count)++;
+}
+
+int cache_mngt_get_queue_stats(struct kcas_get_queue_stats *cmd_info)
 {
-	ocf_cache_t cache = ocf_core_get_cache(core);
-	int result;
+	struct kcas_queue_stats_entry *entries = NULL;
+	struct cache_priv *cache_priv;
+	uint32_t capacity, count = 0;
+	ocf_cache_t cache;
+	int result, i;
+
+	if (!cmd_info->entries)
+		return -EINVAL;
+
+	/* Worker, porter and idle queue per CPU at most */
+	capacity = min_t(uint32_t, cmd_info->entries_count, 3 * nr_cpu_ids);
+	if (capacity) {
+		entries = vmalloc(capacity * sizeof(*entries));
+		if (!entries)
+			return -ENOMEM;
+	}
+
+	result = mngt_get_cache_by_id(cas_ctx, cmd_info->cache_id, &cache);
+	if (result)
+		goto free;
 
 	result = _cache_mngt_read_lock_sync(cache);
 	if (result)
-		return result;
+		goto put;
 
-	result = ocf_mngt_core_get_seq_cutoff_promotion_count(core, count);
+	cache_priv = ocf_cache_get_priv(cache);
+	for (i = 0; i < nr_cpu_ids; i++) {
+		if (!cache_priv_owns_queue(cache_priv, i))
+			continue;
+		_cache_mngt_queue_stats_add(cache_priv->queues[i].worker_queue,
+				i, KCAS_QUEUE_WORKER, entries, capacity,
+				&count);
+		_cache_mngt_queue_stats_add(cache_priv->queues[i].porter_queue,
+				i, KCAS_QUEUE_PORTER, entries, capacity,
+				&count);
+		if (cache_priv->queues[i].idle_queue) {
+			_cache_mngt_queue_stats_add(
+					cache_priv->queues[i].idle_queue,
+					i, KCAS_QUEUE_IDLE, entries, capacity,
+					&count);
+		}
+	}
 
 	ocf_mngt_cache_read_unlock(cache);
+
+	if (capacity && copy_to_user((void __user *)cmd_info->entries,
+			entries, min(count, capacity) * sizeof(*entries))) {
+		result = -EFAULT;
+	} else {
+		cmd_info->entries_count = count;
+	}
+
+put:
+	ocf_mngt_cache_put(cache);
+free:
+	vfree(entries);
 	return result;
 }
 
-static int _cache_flush_with_lock(ocf_cache_t cache)
+int cache_mngt_get_mem_footprint(struct kcas_get_mem_footprint *cmd_info)
 {
-	int result = 0;
+	struct ocf_cache_info info;
+	struct cache_priv *cache_priv;
+	struct cas_fs_meta *map;
+	ocf_cache_t cache;
+	int result, i;
 
-	result = ocf_mngt_cache_get(cache);
+	BUILD_BUG_ON(KCAS_BVEC_POOL_ORDERS != env_mpool_max);
+
+	result = mngt_get_cache_by_id(cas_ctx, cmd_info->cache_id, &cache);
 	if (result)
 		return result;
 
 	result = _cache_mngt_read_lock_sync(cache);
-	if (result) {
-		ocf_mngt_cache_put(cache);
-		return result;
+	if (result)
+		goto put;
+
+	cmd_info->metadata_bytes = 0;
+	if (ocf_cache_is_device_attached(cache) &&
+			!ocf_cache_get_info(cache, &info)) {
+		cmd_info->metadata_bytes = info.metadata_footprint;
 	}
 
-	result = _cache_mngt_cache_flush_sync(cache, true,
-			_cache_read_unlock_put_cmpl);
+	cache_priv = ocf_cache_get_priv(cache);
+	cmd_info->fs_meta_extents = 0;
+	cmd_info->fs_meta_bytes = 0;
+
+	rcu_read_lock();
+	for (i = 0; i < OCF_CORE_MAX; i++) {
+		map = rcu_dereference(cache_priv->fs_meta[i]);
+		if (!map)
+			continue;
+		cmd_info->fs_meta_extents += map->count;
+		cmd_info->fs_meta_bytes += map->size;
+	}
+	rcu_read_unlock();
+
+	cas_cls_get_footprint(cache, &cmd_info->cls_rules,
+			&cmd_info->cls_bytes);
+
+	ocf_mngt_cache_read_unlock(cache);
+
+	cmd_info->rpool_bytes = cas_rpool_get_footprint();
+	for (i = 0; i < KCAS_BVEC_POOL_ORDERS; i++) {
+		env_mpool_get_usage(cas_bvec_pool, i, &cmd_info->bvec_items[i],
+				&cmd_info->bvec_item_size[i]);
+	}
 
+put:
+	ocf_mngt_cache_put(cache);
 	return result;
 }
 
-/**
- * @brief routine implementing dynamic cache mode switching
- * @param cache_name name of cache to which operation applies
- * @param mode target mode (WRITE_THROUGH, WRITE_BACK, WRITE_AROUND etc.)
- * @param flush shall we flush dirty data during switch, or shall we flush
- *            all remaining dirty data before entering new mode?
- */
-int cache_mngt_set_cache_mode(const char *cache_name, size_t name_len,
-			ocf_cache_mode_t mode, uint8_t flush)
+int cache_mngt_get_info(struct kcas_cache_info *info)
 {
-	ocf_cache_mode_t old_mode;
-	ocf_cache_t cache;
+	uint32_t i, j;
 	int result;
+	ocf_cache_t cache;
+	ocf_core_t core;
+	const struct ocf_volume_uuid *uuid;
+	struct cache_priv *cache_priv;
 
-	result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name,
-					name_len, &cache);
+	result = mngt_get_cache_by_id(cas_ctx, info->cache_id, &cache);
 	if (result)
 		return result;
 
-	if (ocf_cache_is_standby(cache)) {
-		result = -OCF_ERR_CACHE_STANDBY;
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
 		goto put;
-	}
 
-	if (!ocf_cache_is_device_attached(cache)) {
-		result = -OCF_ERR_CACHE_DETACHED;
-		goto put;
-	}
+	cache_priv = ocf_cache_get_priv(cache);
 
-	old_mode = ocf_cache_get_mode(cache);
-	if (old_mode == mode) {
-		printk(KERN_INFO "%s is in requested cache mode already\n", cache_name);
-		result = 0;
-		goto put;
-	}
+	result = ocf_cache_get_info(cache, &info->info);
+	if (result)
+		goto unlock;
 
-	if (flush) {
-		result = _cache_flush_with_lock(cache);
-		if (result)
-			goto put;
-	}
+	if (rcu_access_pointer(cache_priv->tinylfu))
+		info->info.promotion_policy = KCAS_PROMOTION_TINYLFU;
 
-	result = _cache_mngt_lock_sync(cache);
-	if (result)
-		goto put;
+	info->mode_drain_from = READ_ONCE(cache_priv->mode_drain.from);
 
-	if (old_mode != ocf_cache_get_mode(cache)) {
-		printk(KERN_WARNING "%s cache mode changed during flush\n",
-				ocf_cache_get_name(cache));
-		goto unlock;
+	spin_lock(&cache_priv->purge.lock);
+	info->purge_total = cache_priv->purge.active ?
+			cache_priv->purge.total : 0;
+	info->purge_done = cache_priv->purge.done;
+	spin_unlock(&cache_priv->purge.lock);
+
+	info->cleaner.passes = READ_ONCE(cache_priv->cleaner.passes);
+	info->cleaner.lines_cleaned =
+			READ_ONCE(cache_priv->cleaner.lines_cleaned);
+	info->cleaner.bytes_cleaned = info->cleaner.lines_cleaned *
+			ocf_cache_get_line_size(cache);
+	info->cleaner.pass_ns = READ_ONCE(cache_priv->cleaner.pass_ns);
+	info->cleaner.sleep_ns = READ_ONCE(cache_priv->cleaner.sleep_ns);
+	info->cleaner.kicks = atomic64_read(&cache_priv->cleaner.kicks);
+	info->cleaner.rate = READ_ONCE(cache_priv->cleaner.rate);
+
+	if (info->info.attached && !info->info.standby_detached) {
+		uuid = ocf_cache_get_uuid(cache);
+		BUG_ON(!uuid);
+		strscpy(info->cache_path_name, uuid->data,
+				min(sizeof(info->cache_path_name), uuid->size));
+		info->atomic_write_unit = block_dev_get_atomic_write_unit(
+				ocf_cache_get_volume(cache));
+	} else {
+		memset(info->cache_path_name, 0, sizeof(info->cache_path_name));
+		info->atomic_write_unit = 0;
 	}
 
-	if (flush) {
-		result = _cache_mngt_cache_flush_uninterruptible(cache);
-		if (result)
-			goto unlock;
+	/* Collect cores IDs */
+	for (i = 0, j = 0; j < info->info.core_count &&
+			i < OCF_CORE_MAX; i++) {
+		if (get_core_by_id(cache, i, &core))
+			continue;
+
+		info->core_id[j] = i;
+		j++;
 	}
 
-	result = ocf_mngt_cache_set_mode(cache, mode);
+unlock:
+	ocf_mngt_cache_read_unlock(cache);
+put:
+	ocf_mngt_cache_put(cache);
+	return result;
+}
+
+int cache_mngt_get_io_class_info(struct kcas_io_class *part)
+{
+	int result;
+	uint32_t cache_id = part->cache_id;
+	uint32_t io_class_id = part->class_id;
+	ocf_cache_t cache;
+
+	result = mngt_get_cache_by_id(cas_ctx, cache_id, &cache);
 	if (result)
-		goto unlock;
+		return result;
 
-	result = _cache_mngt_save_sync(cache);
+	result = _cache_mngt_read_lock_sync(cache);
 	if (result) {
-		printk(KERN_ERR "%s: Failed to save new cache mode. "
-				"Restoring old one!\n", cache_name);
-		ocf_mngt_cache_set_mode(cache, old_mode);
+		ocf_mngt_cache_put(cache);
+		return result;
 	}
 
-unlock:
-	ocf_mngt_cache_unlock(cache);
-put:
+	result = ocf_cache_io_class_get_info(cache, io_class_id, &part->info);
+	if (result)
+		goto end;
+
+	part->seq_cutoff_threshold = READ_ONCE(ocf_cache_get_priv(cache)->
+			seq_cutoff_threshold[io_class_id]) / (KiB >> SECTOR_SHIFT);
+
+end:
+	ocf_mngt_cache_read_unlock(cache);
 	ocf_mngt_cache_put(cache);
 	return result;
 }
 
-int cache_mngt_detach_cache(const char *cache_name, size_t name_len)
+int cache_mngt_get_io_class_stats(struct kcas_io_class_stats *stats)
 {
 	ocf_cache_t cache;
-	int status = 0;
-	struct _cache_mngt_async_context *context;
+	int result;
 
-	context = kmalloc(sizeof(*context), GFP_KERNEL);
-	if (!context)
-		return -ENOMEM;
+	if (stats->class_id >= OCF_USER_IO_CLASS_MAX)
+		return -OCF_ERR_INVAL;
 
-	_cache_mngt_async_context_init(context);
+	result = mngt_get_cache_by_id(cas_ctx, stats->cache_id, &cache);
+	if (result)
+		return result;
 
-	status = ocf_mngt_cache_get_by_name(cas_ctx, cache_name,
-					name_len, &cache);
-	if (status)
-		goto err_get_cache;
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result) {
+		ocf_mngt_cache_put(cache);
+		return result;
+	}
 
-	if (ocf_cache_is_running(cache))
-		status = _cache_flush_with_lock(cache);
-	if (status)
-		goto err_flush;
+	result = cas_cls_get_stats(cache, stats);
 
-	status = _cache_mngt_lock_sync(cache);
-	if (status)
-		goto err_lock;
+	ocf_mngt_cache_read_unlock(cache);
+	ocf_mngt_cache_put(cache);
+	return result;
+}
+
+int cache_mngt_io_class_bench(struct kcas_io_class_bench *cmd_info)
+{
+	ocf_cache_t cache;
+	ocf_core_t core;
+	int result;
 
-	ocf_mngt_cache_detach(cache, _cache_mngt_detach_cache_complete, context);
+	result = mngt_get_cache_by_id(cas_ctx, cmd_info->cache_id, &cache);
+	if (result)
+		return result;
 
-	status = wait_for_completion_interruptible(&context->cmpl);
-	status = _cache_mngt_async_caller_set_result(context, status);
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		goto put;
 
-	if (status == -KCAS_ERR_WAITING_INTERRUPTED) {
-		printk(KERN_WARNING "Waiting for cache detach interrupted. "
-				"The operation will finish asynchronously.\n");
-		goto err_int;
+	result = get_core_by_id(cache, cmd_info->core_id, &core);
+	if (result)
+		goto unlock;
+
+	if (ocf_core_get_state(core) != ocf_core_state_active) {
+		result = -OCF_ERR_CORE_IN_INACTIVE_STATE;
+		goto unlock;
 	}
 
-	ocf_mngt_cache_unlock(cache);
-err_lock:
-err_flush:
+	result = cas_cls_bench(cache, core, cmd_info);
+
+unlock:
+	ocf_mngt_cache_read_unlock(cache);
+put:
 	ocf_mngt_cache_put(cache);
-err_get_cache:
-	kfree(context);
-err_int:
-	return status;
+	return result;
 }
 
-/**
- * @brief routine implements --stop-cache command.
- * @param[in] cache_name caching device name to be removed
- * @param[in] flush Boolean: shall we flush dirty data before removing cache.
- *		if yes, flushing may still be interrupted by user (in which case
- *		device won't be actually removed and error will be returned)
- */
-int cache_mngt_exit_instance(const char *cache_name, size_t name_len, int flush)
+int cache_mngt_get_core_info(struct kcas_core_info *info)
 {
 	ocf_cache_t cache;
-	struct cache_priv *cache_priv;
-	ocf_queue_t mngt_queue;
-	int status = 0, flush_status = 0;
-	struct _cache_mngt_stop_context *context;
-
-	status = ocf_mngt_cache_get_by_name(cas_ctx, cache_name,
-					name_len, &cache);
-	if (status)
-		return status;
+	ocf_core_t core;
+	const struct ocf_volume_uuid *uuid;
+	ocf_volume_t vol;
+	struct bd_object *bdvol;
+	int result;
 
-	/*
-	 * Flush cache. Flushing may take a long time, so we allow user
-	 * to interrupt this operation. Hence we do first flush before
-	 * disabling exported object to avoid restoring it in case
-	 * of interruption. That means some new dirty data could appear
-	 * in cache during flush operation which will not be flushed
-	 * this time, so we need to flush cache again after disabling
-	 * exported object. The second flush should be much faster.
-	*/
-	if (flush && ocf_cache_is_running(cache))
-		status = _cache_flush_with_lock(cache);
-	if (status)
-		goto put;
+	result = mngt_get_cache_by_id(cas_ctx, info->cache_id, &cache);
+	if (result)
+		return result;
 
-	status = _cache_mngt_lock_sync(cache);
-	if (status)
+	result = _cache_mngt_read_lock_sync(cache);
+	if(result)
 		goto put;
 
-	cache_priv = ocf_cache_get_priv(cache);
-	mngt_queue = cache_priv->mngt_queue;
-	context = cache_priv->stop_context;
-
-	context->finish_thread = cas_lazy_thread_create(exit_instance_finish,
-			context, "cas_%s_stop", cache_name);
-	if (IS_ERR(context->finish_thread)) {
-		status = PTR_ERR(context->finish_thread);
+	result = get_core_by_id(cache, info->core_id, &core);
+	if (result < 0) {
+		result = OCF_ERR_CORE_NOT_AVAIL;
 		goto unlock;
 	}
 
-	if (!ocf_cache_is_standby(cache)) {
-		status = kcas_cache_destroy_all_core_exported_objects(cache);
-		if (status != 0) {
-			printk(KERN_WARNING
-					"Failed to remove all cached devices\n");
-			goto stop_thread;
-		}
-	} else {
-		status = cache_mngt_destroy_cache_exported_object(cache);
-		if (status != 0) {
-			printk(KERN_WARNING
-					"Failed to remove cache exported object\n");
-			goto stop_thread;
-		}
-	}
-
-	/* Flush cache again. This time we don't allow interruption. */
-	if (flush && ocf_cache_is_running(cache))
-		flush_status = _cache_mngt_cache_flush_uninterruptible(cache);
-	context->flush_status = flush_status;
-
-	if (flush && !flush_status)
-		BUG_ON(ocf_mngt_cache_is_dirty(cache));
+	result = ocf_core_get_info(core, &info->info);
+	if (result)
+		goto unlock;
 
-	/* Stop cache device - ignore interrupts */
-	status = _cache_mngt_cache_stop_sync(cache);
-	if (status == -KCAS_ERR_WAITING_INTERRUPTED)
-		printk(KERN_WARNING
-				"Waiting for cache stop interrupted. "
-				"Stop will finish asynchronously.\n");
+	uuid = ocf_core_get_uuid(core);
 
-	if ((status == 0 || status == -KCAS_ERR_WAITING_INTERRUPTED) &&
-			flush_status) {
-		/* "removed dirty" error has a precedence over "interrupted" */
-		return KCAS_ERR_STOPPED_DIRTY;
+	if (uuid->data) {
+		strscpy(info->core_path_name, uuid->data,
+				min(sizeof(info->core_path_name), uuid->size));
 	}
 
-	return status;
+	info->state = ocf_core_get_state(core);
+
+	vol = ocf_core_get_volume(core);
+	bdvol = bd_object(vol);
+	info->exported_object_exists = bdvol->expobj_valid;
 
-stop_thread:
-	cas_lazy_thread_stop(context->finish_thread);
 unlock:
-	ocf_mngt_cache_unlock(cache);
+	ocf_mngt_cache_read_unlock(cache);
 put:
 	ocf_mngt_cache_put(cache);
-	return status;
+	return result;
 }
 
-struct cache_mngt_list_ctx {
-	struct kcas_cache_list *list;
-	int pos;
+struct _cache_mngt_inflight_limit_context {
+	enum cas_bd_io_class io_class;
+	uint32_t limit;
 };
 
-static int cache_mngt_list_caches_visitor(ocf_cache_t cache, void *cntx)
+static int _cache_mngt_set_core_inflight_limit(ocf_core_t core, void *cntx)
 {
-	struct cache_mngt_list_ctx *context = cntx;
-	struct kcas_cache_list *list = context->list;
-	uint32_t id;
+	struct _cache_mngt_inflight_limit_context *ctx = cntx;
 
-	BUG_ON(cache_id_from_name(&id, ocf_cache_get_name(cache)));
-
-	if (context->pos++ < list->id_position)
-		return 0;
-
-	if (list->in_out_num >= ARRAY_SIZE(list->cache_id_tab))
-		return 1;
-
-	list->cache_id_tab[list->in_out_num] = id;
-	list->in_out_num++;
+	block_dev_set_inflight_limit(ocf_core_get_volume(core), ctx->io_class,
+			ctx->limit);
 
 	return 0;
 }
 
-int cache_mngt_list_caches(struct kcas_cache_list *list)
+/**
+ * @brief Set max number of bios in flight to core device
+ * @param[in] cache cache to which the change pertains
+ * @param[in] core core to which the change pertains
+ * or NULL for setting value for all active cores of specified cache
+ * @param[in] io_class class of I/O limit applies to
+ * @param[in] limit max number of bios in flight, 0 - unlimited
+ * @return exit code of successful completion is 0;
+ * nonzero exit code means failure
+ */
+static int cache_mngt_set_inflight_limit(ocf_cache_t cache, ocf_core_t core,
+		enum cas_bd_io_class io_class, uint32_t limit)
 {
-	struct cache_mngt_list_ctx context = {
-		.list = list,
-		.pos = 0
+	struct _cache_mngt_inflight_limit_context ctx = {
+		.io_class = io_class,
+		.limit = limit,
 	};
+	int result;
 
-	list->in_out_num = 0;
-	return ocf_mngt_cache_visit(cas_ctx, cache_mngt_list_caches_visitor,
-			&context);
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	if (!core) {
+		result = ocf_core_visit(cache, _cache_mngt_set_core_inflight_limit,
+				&ctx, true);
+	} else if (ocf_core_get_state(core) != ocf_core_state_active) {
+		result = -OCF_ERR_CORE_IN_INACTIVE_STATE;
+	} else {
+		result = _cache_mngt_set_core_inflight_limit(core, &ctx);
+	}
+
+	ocf_mngt_cache_read_unlock(cache);
+	return result;
 }
 
-int cache_mngt_interrupt_flushing(const char *cache_name, size_t name_len)
+static int cache_mngt_get_inflight_limit(ocf_core_t core,
+		enum cas_bd_io_class io_class, uint32_t *limit)
 {
-	ocf_cache_t cache;
-	struct cache_priv *cache_priv;
+	ocf_cache_t cache = ocf_core_get_cache(core);
 	int result;
 
-	result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name,
-					name_len, &cache);
+	result = _cache_mngt_read_lock_sync(cache);
 	if (result)
 		return result;
 
-	cache_priv = ocf_cache_get_priv(cache);
+	if (ocf_core_get_state(core) == ocf_core_state_active) {
+		*limit = block_dev_get_inflight_limit(ocf_core_get_volume(core),
+				io_class);
+	} else {
+		result = -OCF_ERR_CORE_IN_INACTIVE_STATE;
+	}
 
-	if (atomic_read(&cache_priv->flush_interrupt_enabled))
-		ocf_mngt_cache_flush_interrupt(cache);
+	ocf_mngt_cache_read_unlock(cache);
+	return result;
+}
 
-	ocf_mngt_cache_put(cache);
+static int _cache_mngt_set_core_writeback_sweep(ocf_core_t core, void *cntx)
+{
+	block_dev_set_writeback_sweep(ocf_core_get_volume(core),
+			*(uint32_t *)cntx);
 
 	return 0;
-
 }
 
-static int _cache_mngt_dump_inflight_all_core(ocf_core_t core, void *cntx)
+/**
+ * @brief Set time cleaning writes to core device are gathered for, to be
+ * sent in ascending order of address
+ * @param[in] cache cache to which the change pertains
+ * @param[in] core core to which the change pertains
+ * or NULL for setting value for all active cores of specified cache
+ * @param[in] window_us gathering window in microseconds, 0 - writes are
+ * sent in order of cleaning policy
+ * @return exit code of successful completion is 0;
+ * nonzero exit code means failure
+ */
+static int cache_mngt_set_writeback_sweep(ocf_cache_t cache, ocf_core_t core,
+		uint32_t window_us)
 {
-	//uint16_t core_id = OCF_CORE_ID_INVALID;
-	//core_id_from_name(&core_id, ocf_core_get_name(core));
+	int result;
 
-	ocf_volume_t core_vol = ocf_core_get_volume(core);
-	ocf_volume_dump_inflight(core_vol);
-	return 0;
+	if (window_us > KCAS_WRITEBACK_SWEEP_WINDOW_MAX)
+		return -EINVAL;
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	if (!core) {
+		result = ocf_core_visit(cache,
+				_cache_mngt_set_core_writeback_sweep,
+				&window_us, true);
+	} else if (ocf_core_get_state(core) != ocf_core_state_active) {
+		result = -OCF_ERR_CORE_IN_INACTIVE_STATE;
+	} else {
+		result = _cache_mngt_set_core_writeback_sweep(core, &window_us);
+	}
+
+	ocf_mngt_cache_read_unlock(cache);
+	return result;
 }
 
-int cache_mngt_dump_inflight(uint32_t cache_id)
+static int cache_mngt_get_writeback_sweep(ocf_core_t core,
+		uint32_t *window_us)
 {
-	ocf_cache_t cache;
-	ocf_volume_t cache_vol;
-	char cache_name[OCF_CACHE_NAME_SIZE] = {};
+	ocf_cache_t cache = ocf_core_get_cache(core);
 	int result;
 
-	cache_name_from_id(cache_name, cache_id);
-	result = ocf_mngt_cache_get_by_name(cas_ctx, cache_name, OCF_CACHE_NAME_SIZE, &cache);
-	if (result) {
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
 		return result;
-	}
 
-	if (ocf_cache_is_standby(cache)) {
-		ocf_mngt_cache_put(cache);
-		return -OCF_ERR_CACHE_STANDBY;
+	if (ocf_core_get_state(core) == ocf_core_state_active) {
+		*window_us = block_dev_get_writeback_sweep(
+				ocf_core_get_volume(core));
+	} else {
+		result = -OCF_ERR_CORE_IN_INACTIVE_STATE;
 	}
 
-	result = _cache_mngt_lock_sync(cache);
-	if (result) {
-		ocf_mngt_cache_put(cache);
-		return result;
+	ocf_mngt_cache_read_unlock(cache);
+	return result;
+}
+
+struct _cache_mngt_read_ahead_context {
+	uint32_t io_class;
+	uint32_t lines;
+};
+
+static int _cache_mngt_set_core_read_ahead(ocf_core_t core, void *cntx)
+{
+	struct _cache_mngt_read_ahead_context *ctx = cntx;
+	struct bd_object *bvol = bd_object(ocf_core_get_volume(core));
+
+	if (bvol->read_ahead) {
+		cas_read_ahead_set_lines(bvol->read_ahead, ctx->io_class,
+				ctx->lines);
 	}
 
-	cache_vol = ocf_cache_get_volume(cache);
-	ocf_volume_dump_inflight(cache_vol);
+	return 0;
+}
+
+/**
+ * @brief Set read-ahead window of sequential streams of io class
+ * @param[in] cache cache to which the change pertains
+ * @param[in] core core to which the change pertains
+ * or NULL for setting value for all active cores of specified cache
+ * @param[in] io_class io class of streams
+ * @param[in] lines window in cache lines, 0 - read-ahead disabled
+ * @return exit code of successful completion is 0;
+ * nonzero exit code means failure
+ */
+static int cache_mngt_set_read_ahead(ocf_cache_t cache, ocf_core_t core,
+		uint32_t io_class, uint32_t lines)
+{
+	struct _cache_mngt_read_ahead_context ctx = {
+		.io_class = io_class,
+		.lines = lines,
+	};
+	int result;
+
+	if (io_class >= OCF_USER_IO_CLASS_MAX ||
+			lines > KCAS_READ_AHEAD_LINES_MAX)
+		return -EINVAL;
 
-	result = ocf_core_visit(cache, _cache_mngt_dump_inflight_all_core, NULL, false);
-	if (result) {
-		ocf_mngt_cache_unlock(cache);
-		ocf_mngt_cache_put(cache);
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
 		return result;
+
+	if (!core) {
+		result = ocf_core_visit(cache, _cache_mngt_set_core_read_ahead,
+				&ctx, true);
+	} else if (ocf_core_get_state(core) != ocf_core_state_active) {
+		result = -OCF_ERR_CORE_IN_INACTIVE_STATE;
+	} else {
+		result = _cache_mngt_set_core_read_ahead(core, &ctx);
 	}
 
-	ocf_mngt_cache_unlock(cache);
-	ocf_mngt_cache_put(cache);
+	ocf_mngt_cache_read_unlock(cache);
 	return result;
 }
 
-int cache_mngt_get_stats(struct kcas_get_stats *stats)
+static int cache_mngt_get_read_ahead(ocf_core_t core, uint32_t io_class,
+		uint32_t *lines)
 {
+	ocf_cache_t cache = ocf_core_get_cache(core);
+	struct bd_object *bvol = bd_object(ocf_core_get_volume(core));
 	int result;
-	ocf_cache_t cache;
-	ocf_core_t core = NULL;
 
-	result = mngt_get_cache_by_id(cas_ctx, stats->cache_id, &cache);
-	if (result)
-		return result;
+	if (io_class >= OCF_USER_IO_CLASS_MAX)
+		return -EINVAL;
 
 	result = _cache_mngt_read_lock_sync(cache);
 	if (result)
-		goto put;
+		return result;
 
-	if (stats->core_id == OCF_CORE_ID_INVALID &&
-			stats->part_id == OCF_IO_CLASS_INVALID) {
-		result = ocf_stats_collect_cache(cache, &stats->usage, &stats->req,
-				&stats->blocks, &stats->errors);
-		if (result)
-			goto unlock;
+	if (ocf_core_get_state(core) != ocf_core_state_active)
+		result = -OCF_ERR_CORE_IN_INACTIVE_STATE;
+	else if (bvol->read_ahead)
+		*lines = cas_read_ahead_get_lines(bvol->read_ahead, io_class);
+	else
+		*lines = 0;
 
-	} else if (stats->part_id == OCF_IO_CLASS_INVALID) {
-		result = get_core_by_id(cache, stats->core_id, &core);
-		if (result)
-			goto unlock;
+	ocf_mngt_cache_read_unlock(cache);
+	return result;
+}
 
-		result = ocf_stats_collect_core(core, &stats->usage, &stats->req,
-				&stats->blocks, &stats->errors);
-		if (result)
-			goto unlock;
+struct _cache_mngt_dirty_throttle_context {
+	enum kcas_core_param_id param_id;
+	uint32_t value;
+};
 
-	} else {
-		if (stats->core_id == OCF_CORE_ID_INVALID) {
-			result = ocf_stats_collect_part_cache(cache, stats->part_id,
-					&stats->usage, &stats->req, &stats->blocks);
-		} else {
-			result = get_core_by_id(cache, stats->core_id, &core);
-			if (result)
-				goto unlock;
+static int _cache_mngt_set_core_dirty_throttle(ocf_core_t core, void *cntx)
+{
+	struct _cache_mngt_dirty_throttle_context *ctx = cntx;
+	struct bd_object *bvol = bd_object(ocf_core_get_volume(core));
 
-			result = ocf_stats_collect_part_core(core, stats->part_id,
-					&stats->usage, &stats->req, &stats->blocks);
-		}
-	}
+	if (!bvol->dirty_throttle)
+		return 0;
 
-unlock:
-	ocf_mngt_cache_read_unlock(cache);
-put:
-	ocf_mngt_cache_put(cache);
-	return result;
+	if (ctx->param_id == core_param_dirty_throttle_limit)
+		cas_dirty_throttle_set_limit(bvol->dirty_throttle, ctx->value);
+	else
+		cas_dirty_throttle_set_max_pause(bvol->dirty_throttle,
+				ctx->value);
+
+	return 0;
 }
 
-int cache_mngt_get_info(struct kcas_cache_info *info)
+/**
+ * @brief Set throttling of writes by dirty data of core
+ * @param[in] cache cache to which the change pertains
+ * @param[in] core core to which the change pertains
+ * or NULL for setting value for all active cores of specified cache
+ * @param[in] param_id core_param_dirty_throttle_limit - limit of dirty data
+ * of core in percent of cache, 0 - throttling disabled, or
+ * core_param_dirty_throttle_max_pause - max pause of write in ms
+ * @param[in] value value of parameter
+ * @return exit code of successful completion is 0;
+ * nonzero exit code means failure
+ */
+static int cache_mngt_set_dirty_throttle(ocf_cache_t cache, ocf_core_t core,
+		enum kcas_core_param_id param_id, uint32_t value)
 {
-	uint32_t i, j;
+	struct _cache_mngt_dirty_throttle_context ctx = {
+		.param_id = param_id,
+		.value = value,
+	};
 	int result;
-	ocf_cache_t cache;
-	ocf_core_t core;
-	const struct ocf_volume_uuid *uuid;
 
-	result = mngt_get_cache_by_id(cas_ctx, info->cache_id, &cache);
-	if (result)
-		return result;
+	if (param_id == core_param_dirty_throttle_limit && value > 100)
+		return -EINVAL;
 
-	result = _cache_mngt_read_lock_sync(cache);
-	if (result)
-		goto put;
+	if (param_id == core_param_dirty_throttle_max_pause &&
+			(!value || value > KCAS_DIRTY_THROTTLE_MAX_PAUSE_MAX))
+		return -EINVAL;
 
-	result = ocf_cache_get_info(cache, &info->info);
+	result = _cache_mngt_read_lock_sync(cache);
 	if (result)
-		goto unlock;
+		return result;
 
-	if (info->info.attached && !info->info.standby_detached) {
-		uuid = ocf_cache_get_uuid(cache);
-		BUG_ON(!uuid);
-		strscpy(info->cache_path_name, uuid->data,
-				min(sizeof(info->cache_path_name), uuid->size));
+	if (!core) {
+		result = ocf_core_visit(cache,
+				_cache_mngt_set_core_dirty_throttle, &ctx, true);
+	} else if (ocf_core_get_state(core) != ocf_core_state_active) {
+		result = -OCF_ERR_CORE_IN_INACTIVE_STATE;
 	} else {
-		memset(info->cache_path_name, 0, sizeof(info->cache_path_name));
-	}
-
-	/* Collect cores IDs */
-	for (i = 0, j = 0; j < info->info.core_count &&
-			i < OCF_CORE_MAX; i++) {
-		if (get_core_by_id(cache, i, &core))
-			continue;
-
-		info->core_id[j] = i;
-		j++;
+		result = _cache_mngt_set_core_dirty_throttle(core, &ctx);
 	}
 
-unlock:
 	ocf_mngt_cache_read_unlock(cache);
-put:
-	ocf_mngt_cache_put(cache);
 	return result;
 }
 
-int cache_mngt_get_io_class_info(struct kcas_io_class *part)
+static int cache_mngt_get_dirty_throttle(ocf_core_t core,
+		enum kcas_core_param_id param_id, uint32_t *value)
 {
+	ocf_cache_t cache = ocf_core_get_cache(core);
+	struct bd_object *bvol = bd_object(ocf_core_get_volume(core));
 	int result;
-	uint32_t cache_id = part->cache_id;
-	uint32_t io_class_id = part->class_id;
-	ocf_cache_t cache;
-
-	result = mngt_get_cache_by_id(cas_ctx, cache_id, &cache);
-	if (result)
-		return result;
 
 	result = _cache_mngt_read_lock_sync(cache);
-	if (result) {
-		ocf_mngt_cache_put(cache);
+	if (result)
 		return result;
-	}
 
-	result = ocf_cache_io_class_get_info(cache, io_class_id, &part->info);
-	if (result)
-		goto end;
+	if (ocf_core_get_state(core) != ocf_core_state_active)
+		result = -OCF_ERR_CORE_IN_INACTIVE_STATE;
+	else if (!bvol->dirty_throttle)
+		*value = 0;
+	else if (param_id == core_param_dirty_throttle_limit)
+		*value = cas_dirty_throttle_get_limit(bvol->dirty_throttle);
+	else
+		*value = cas_dirty_throttle_get_max_pause(bvol->dirty_throttle);
 
-end:
 	ocf_mngt_cache_read_unlock(cache);
-	ocf_mngt_cache_put(cache);
 	return result;
 }
 
-int cache_mngt_get_core_info(struct kcas_core_info *info)
+struct _cache_mngt_qos_context {
+	uint32_t io_class;
+	int dir;
+	enum cas_qos_limit limit;
+	uint32_t rate;
+};
+
+static int _cache_mngt_set_core_qos(ocf_core_t core, void *cntx)
 {
-	ocf_cache_t cache;
-	ocf_core_t core;
-	const struct ocf_volume_uuid *uuid;
-	ocf_volume_t vol;
-	struct bd_object *bdvol;
+	struct _cache_mngt_qos_context *ctx = cntx;
+	struct bd_object *bvol = bd_object(ocf_core_get_volume(core));
+
+	if (!bvol->qos)
+		return 0;
+
+	return cas_qos_set_limit(bvol->qos, ctx->io_class, ctx->dir,
+			ctx->limit, ctx->rate);
+}
+
+static void _cache_mngt_qos_param(enum kcas_core_param_id param_id,
+		int *dir, enum cas_qos_limit *limit)
+{
+	*dir = (param_id == core_param_qos_read_iops ||
+			param_id == core_param_qos_read_bandwidth ||
+			param_id == core_param_get_qos_read_throttled) ?
+			READ : WRITE;
+	*limit = (param_id == core_param_qos_read_iops ||
+			param_id == core_param_qos_write_iops) ?
+			CAS_QOS_IOPS : CAS_QOS_BANDWIDTH;
+}
+
+/**
+ * @brief Set QoS limit of core or of its io class
+ * @param[in] cache cache to which the change pertains
+ * @param[in] core core to which the change pertains
+ * or NULL for setting value for all active cores of specified cache
+ * @param[in] param_id core_param_qos_* limit to be set
+ * @param[in] io_class io class to be limited, OCF_IO_CLASS_INVALID - whole core
+ * @param[in] rate requests or MiB per second, 0 - unlimited
+ * @return exit code of successful completion is 0;
+ * nonzero exit code means failure
+ */
+static int cache_mngt_set_qos(ocf_cache_t cache, ocf_core_t core,
+		enum kcas_core_param_id param_id, uint32_t io_class,
+		uint32_t rate)
+{
+	struct _cache_mngt_qos_context ctx = {
+		.io_class = io_class,
+		.rate = rate,
+	};
 	int result;
 
-	result = mngt_get_cache_by_id(cas_ctx, info->cache_id, &cache);
-	if (result)
-		return result;
+	_cache_mngt_qos_param(param_id, &ctx.dir, &ctx.limit);
 
-	result = _cache_mngt_read_lock_sync(cache);
-	if(result)
-		goto put;
+	if (io_class >= OCF_USER_IO_CLASS_MAX && io_class != OCF_IO_CLASS_INVALID)
+		return -EINVAL;
 
-	result = get_core_by_id(cache, info->core_id, &core);
-	if (result < 0) {
-		result = OCF_ERR_CORE_NOT_AVAIL;
-		goto unlock;
+	if (rate > (ctx.limit == CAS_QOS_IOPS ? KCAS_QOS_IOPS_MAX :
+			KCAS_QOS_BANDWIDTH_MAX)) {
+		return -EINVAL;
 	}
 
-	result = ocf_core_get_info(core, &info->info);
+	result = _cache_mngt_read_lock_sync(cache);
 	if (result)
-		goto unlock;
-
-	uuid = ocf_core_get_uuid(core);
+		return result;
 
-	if (uuid->data) {
-		strscpy(info->core_path_name, uuid->data,
-				min(sizeof(info->core_path_name), uuid->size));
+	if (!core) {
+		result = ocf_core_visit(cache, _cache_mngt_set_core_qos,
+				&ctx, true);
+	} else if (ocf_core_get_state(core) != ocf_core_state_active) {
+		result = -OCF_ERR_CORE_IN_INACTIVE_STATE;
+	} else {
+		result = _cache_mngt_set_core_qos(core, &ctx);
 	}
 
-	info->state = ocf_core_get_state(core);
+	ocf_mngt_cache_read_unlock(cache);
+	return result;
+}
 
-	vol = ocf_core_get_volume(core);
-	bdvol = bd_object(vol);
-	info->exported_object_exists = bdvol->expobj_valid;
+static int cache_mngt_get_qos(ocf_core_t core,
+		enum kcas_core_param_id param_id, uint32_t io_class,
+		uint32_t *value)
+{
+	ocf_cache_t cache = ocf_core_get_cache(core);
+	struct bd_object *bvol = bd_object(ocf_core_get_volume(core));
+	enum cas_qos_limit limit;
+	int result, dir;
+
+	_cache_mngt_qos_param(param_id, &dir, &limit);
+
+	result = _cache_mngt_read_lock_sync(cache);
+	if (result)
+		return result;
+
+	if (ocf_core_get_state(core) != ocf_core_state_active) {
+		result = -OCF_ERR_CORE_IN_INACTIVE_STATE;
+	} else if (!bvol->qos) {
+		*value = 0;
+	} else if (param_id == core_param_get_qos_read_throttled ||
+			param_id == core_param_get_qos_write_throttled) {
+		result = cas_qos_get_throttled(bvol->qos, io_class, dir, value);
+	} else {
+		result = cas_qos_get_limit(bvol->qos, io_class, dir, limit,
+				value);
+	}
 
-unlock:
 	ocf_mngt_cache_read_unlock(cache);
-put:
-	ocf_mngt_cache_put(cache);
 	return result;
 }
 
@@ -3792,6 +9280,34 @@ int cache_mngt_set_core_params(struct kcas_set_core_param *info)
 		result = cache_mngt_set_seq_cutoff_promotion_count(cache,
 				core, info->param_value);
 		break;
+	case core_param_inflight_limit_foreground:
+		result = cache_mngt_set_inflight_limit(cache, core,
+				CAS_BD_IO_FOREGROUND, info->param_value);
+		break;
+	case core_param_inflight_limit_background:
+		result = cache_mngt_set_inflight_limit(cache, core,
+				CAS_BD_IO_BACKGROUND, info->param_value);
+		break;
+	case core_param_read_ahead_lines:
+		result = cache_mngt_set_read_ahead(cache, core,
+				info->io_class_id, info->param_value);
+		break;
+	case core_param_dirty_throttle_limit:
+	case core_param_dirty_throttle_max_pause:
+		result = cache_mngt_set_dirty_throttle(cache, core,
+				info->param_id, info->param_value);
+		break;
+	case core_param_writeback_sweep_window:
+		result = cache_mngt_set_writeback_sweep(cache, core,
+				info->param_value);
+		break;
+	case core_param_qos_read_iops:
+	case core_param_qos_write_iops:
+	case core_param_qos_read_bandwidth:
+	case core_param_qos_write_bandwidth:
+		result = cache_mngt_set_qos(cache, core, info->param_id,
+				info->io_class_id, info->param_value);
+		break;
 	default:
 		result = -EINVAL;
 	}
@@ -3828,6 +9344,36 @@ int cache_mngt_get_core_params(struct kcas_get_core_param *info)
 		result = cache_mngt_get_seq_cutoff_promotion_count(core,
 				&info->param_value);
 		break;
+	case core_param_inflight_limit_foreground:
+		result = cache_mngt_get_inflight_limit(core,
+				CAS_BD_IO_FOREGROUND, &info->param_value);
+		break;
+	case core_param_inflight_limit_background:
+		result = cache_mngt_get_inflight_limit(core,
+				CAS_BD_IO_BACKGROUND, &info->param_value);
+		break;
+	case core_param_read_ahead_lines:
+		result = cache_mngt_get_read_ahead(core, info->io_class_id,
+				&info->param_value);
+		break;
+	case core_param_dirty_throttle_limit:
+	case core_param_dirty_throttle_max_pause:
+		result = cache_mngt_get_dirty_throttle(core, info->param_id,
+				&info->param_value);
+		break;
+	case core_param_writeback_sweep_window:
+		result = cache_mngt_get_writeback_sweep(core,
+				&info->param_value);
+		break;
+	case core_param_qos_read_iops:
+	case core_param_qos_write_iops:
+	case core_param_qos_read_bandwidth:
+	case core_param_qos_write_bandwidth:
+	case core_param_get_qos_read_throttled:
+	case core_param_get_qos_write_throttled:
+		result = cache_mngt_get_qos(core, info->param_id,
+				info->io_class_id, &info->param_value);
+		break;
 	default:
 		result = -EINVAL;
 	}
@@ -3920,6 +9466,57 @@ int cache_mngt_set_cache_params(struct kcas_set_cache_param *info)
 		result = cache_mngt_set_promotion_param(cache, ocf_promotion_nhit,
 				ocf_nhit_trigger_threshold, info->param_value);
 		break;
+	case cache_param_queue_poll_time:
+		result = cache_mngt_set_queue_poll_time(cache,
+				info->param_value);
+		break;
+	case cache_param_cleaner_workers:
+		result = cache_mngt_set_cleaner_workers(cache,
+				info->param_value);
+		break;
+	case cache_param_promotion_nhit_adaptive:
+		result = cache_mngt_set_nhit_adapt(cache, info->param_value);
+		break;
+	case cache_param_cleaner_rewrite_defer:
+		result = cache_mngt_set_cleaner_rewrite_defer(cache,
+				info->param_value);
+		break;
+	case cache_param_io_class_adaptive_prio:
+		result = cache_mngt_set_prio_adapt(cache, info->param_value);
+		break;
+	case cache_param_cache_trim_rate:
+		result = cache_mngt_set_trim_rate(cache, info->param_value);
+		break;
+	case cache_param_dram_tier_size:
+		result = cache_mngt_set_dram_tier_size(cache,
+				info->param_value);
+		break;
+	case cache_param_mirror_rebuild:
+		result = cache_mngt_set_mirror_rebuild(cache,
+				info->param_value);
+		break;
+	case cache_param_compress_enabled:
+		result = cache_mngt_set_compress(cache, info->io_class_id,
+				info->param_value);
+		break;
+	case cache_param_dedup_enabled:
+		result = cache_mngt_set_dedup(cache, info->param_value);
+		break;
+	case cache_param_checksum_enabled:
+		result = cache_mngt_set_checksum(cache, info->param_value);
+		break;
+	case cache_param_slow_bypass_threshold:
+		result = cache_mngt_set_slow_bypass(cache, info->param_value);
+		break;
+	case cache_param_seq_absorb_free:
+	case cache_param_seq_absorb_headroom:
+		result = cache_mngt_set_seq_absorb(cache, info->param_id,
+				info->param_value);
+		break;
+	case cache_param_meta_coalesce_window:
+		result = cache_mngt_set_meta_coalesce(cache,
+				info->param_value);
+		break;
 	default:
 		result = -EINVAL;
 	}
@@ -4020,6 +9617,63 @@ int cache_mngt_get_cache_params(struct kcas_get_cache_param *info)
 		result = cache_mngt_get_promotion_param(cache, ocf_promotion_nhit,
 				ocf_nhit_trigger_threshold, &info->param_value);
 		break;
+	case cache_param_queue_poll_time:
+		result = cache_mngt_get_queue_poll_time(cache,
+				&info->param_value);
+		break;
+	case cache_param_cleaner_workers:
+		result = cache_mngt_get_cleaner_workers(cache,
+				&info->param_value);
+		break;
+	case cache_param_promotion_nhit_adaptive:
+		result = cache_mngt_get_nhit_adapt(cache, &info->param_value);
+		break;
+	case cache_param_cleaner_rewrite_defer:
+		result = cache_mngt_get_cleaner_rewrite_defer(cache,
+				&info->param_value);
+		break;
+	case cache_param_io_class_adaptive_prio:
+		result = cache_mngt_get_prio_adapt(cache, &info->param_value);
+		break;
+	case cache_param_cache_trim_rate:
+		result = cache_mngt_get_trim(cache, &info->param_value);
+		break;
+	case cache_param_dram_tier_size:
+		result = cache_mngt_get_dram_tier(cache, &info->param_value);
+		break;
+	case cache_param_get_mirror_member0_state:
+	case cache_param_get_mirror_member1_state:
+	case cache_param_get_mirror_rebuild_progress:
+		result = cache_mngt_get_mirror(cache, info->param_id,
+				&info->param_value);
+		break;
+	case cache_param_compress_enabled:
+	case cache_param_get_compress_ratio:
+	case cache_param_get_compress_device_used:
+		result = cache_mngt_get_compress(cache, info->param_id,
+				info->io_class_id, &info->param_value);
+		break;
+	case cache_param_dedup_enabled:
+		result = cache_mngt_get_dedup(cache, &info->param_value);
+		break;
+	case cache_param_checksum_enabled:
+		result = cache_mngt_get_checksum(cache, &info->param_value);
+		break;
+	case cache_param_slow_bypass_threshold:
+	case cache_param_get_slow_bypass_active:
+		result = cache_mngt_get_slow_bypass(cache, info->param_id,
+				&info->param_value);
+		break;
+	case cache_param_seq_absorb_free:
+	case cache_param_seq_absorb_headroom:
+	case cache_param_get_seq_absorb_active:
+		result = cache_mngt_get_seq_absorb(cache, info->param_id,
+				&info->param_value);
+		break;
+	case cache_param_meta_coalesce_window:
+		result = cache_mngt_get_meta_coalesce(cache,
+				&info->param_value);
+		break;
 	default:
 		result = -EINVAL;
 	}
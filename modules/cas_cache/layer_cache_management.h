@@ -37,6 +37,8 @@ int cache_mngt_add_core_to_cache(const char *cache_name, size_t name_len,
 		struct ocf_mngt_core_config *cfg,
 		struct kcas_insert_core *cmd_info);
 
+int cache_mngt_add_cores_to_cache(struct kcas_insert_cores *cmd_info);
+
 int cache_mngt_remove_core_from_cache(struct kcas_remove_core *cmd);
 
 int cache_mngt_remove_inactive_core(struct kcas_remove_inactive *cmd);
@@ -59,6 +61,12 @@ int cache_mngt_create_cache_cfg(struct ocf_mngt_cache_config *cfg,
 		struct ocf_mngt_cache_attach_config *attach_cfg,
 		struct kcas_start_cache *cmd);
 
+/**
+ * @brief Release cache id assigned by cache_mngt_create_cache_cfg(), once
+ *	cache using it has been started or start has failed
+ */
+void cache_mngt_release_cache_id(uint32_t cache_id);
+
 int cache_mngt_attach_cache_cfg(char *cache_name, size_t name_len,
 		struct ocf_mngt_cache_config *cfg,
 		struct ocf_mngt_cache_attach_config *attach_cfg,
@@ -68,6 +76,8 @@ int cache_mngt_core_pool_get_paths(struct kcas_core_pool_path *cmd_info);
 
 int cache_mngt_core_pool_remove(struct kcas_core_pool_remove *cmd_info);
 
+void cache_mngt_core_pool_index_deinit(void);
+
 int cache_mngt_cache_check_device(struct kcas_cache_check_device *cmd_info);
 
 int cache_mngt_prepare_core_cfg(struct ocf_mngt_core_config *cfg,
@@ -92,27 +102,68 @@ int cache_mngt_set_cache_mode(const char *cache_name, size_t name_len,
 			ocf_cache_mode_t mode, uint8_t flush);
 
 int cache_mngt_purge_object(const char *cache_name, size_t cache_name_len,
-			const char *core_name, size_t core_name_len);
+			const char *core_name, size_t core_name_len,
+			bool background);
 
 int cache_mngt_flush_object(const char *cache_name, size_t cache_name_len,
-			const char *core_name, size_t core_name_len);
+			const char *core_name, size_t core_name_len,
+			uint32_t rate_limit);
 
-int cache_mngt_flush_device(const char *cache_name, size_t name_len);
+int cache_mngt_flush_device(const char *cache_name, size_t name_len,
+		uint32_t rate_limit);
 
-int cache_mngt_purge_device(const char *cache_name, size_t name_len);
+int cache_mngt_purge_device(const char *cache_name, size_t name_len,
+		bool background);
 
 int cache_mngt_list_caches(struct kcas_cache_list *list);
 
 int cache_mngt_interrupt_flushing(const char *cache_name, size_t name_len);
 
+int cache_mngt_async_op_start(struct kcas_async_op *cmd);
+
+int cache_mngt_async_op_status(struct kcas_async_status *cmd);
+
 int cache_mngt_dump_inflight(uint32_t cache_id);
 
+int cache_mngt_get_inflight(struct kcas_dump_inflight *cmd_info);
+
 int cache_mngt_get_stats(struct kcas_get_stats *stats);
 
+int cache_mngt_get_stats_bulk(struct kcas_get_stats_bulk *cmd_info);
+
+int cache_mngt_get_lat_hist(struct kcas_get_lat_hist *cmd_info);
+
+int cache_mngt_get_heatmap(struct kcas_get_heatmap *cmd_info);
+
+int cache_mngt_get_mrc(struct kcas_get_mrc *cmd_info);
+
+int cache_mngt_get_hot_set(struct kcas_get_hot_set *cmd_info);
+
+int cache_mngt_get_trace(struct kcas_get_trace *cmd_info);
+
+int cache_mngt_prefetch(struct kcas_prefetch *cmd_info);
+
+int cache_mngt_bench(struct kcas_bench *cmd_info);
+
+int cache_mngt_get_queue_stats(struct kcas_get_queue_stats *cmd_info);
+
+int cache_mngt_get_mem_footprint(struct kcas_get_mem_footprint *cmd_info);
+
 int cache_mngt_get_info(struct kcas_cache_info *info);
 
 int cache_mngt_get_io_class_info(struct kcas_io_class *part);
 
+int cache_mngt_get_io_class_stats(struct kcas_io_class_stats *stats);
+
+int cache_mngt_io_class_bench(struct kcas_io_class_bench *cmd_info);
+
+int cache_mngt_update_fs_meta(struct kcas_update_fs_meta *cmd);
+
+int cache_mngt_get_load_progress(struct kcas_load_progress *cmd);
+
+void cache_mngt_fs_meta_learn(ocf_cache_t cache, ocf_core_id_t core_id,
+		sector_t sector, uint32_t sectors);
+
 int cache_mngt_get_core_info(struct kcas_core_info *info);
 
 void cache_mngt_wait_for_rq_finish(ocf_cache_t cache);
@@ -134,4 +185,12 @@ int cache_mngt_create_cache_standby_activate_cfg(
 int cache_mngt_activate(struct ocf_mngt_cache_standby_activate_config *cfg,
 		struct kcas_standby_activate *cmd);
 
+int cache_mngt_init_cpu_hotplug(void);
+
+void cache_mngt_deinit_cpu_hotplug(void);
+
+int cache_mngt_init_async_ops(void);
+
+void cache_mngt_deinit_async_ops(void);
+
 #endif
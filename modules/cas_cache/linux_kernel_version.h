@@ -17,29 +17,46 @@
 #include <linux/vmalloc.h>
 #include <linux/uaccess.h>
 #include <linux/kthread.h>
+#include <linux/sched.h>
 #include <linux/spinlock.h>
 #include <linux/bio.h>
 #include <linux/fs.h>
 #include <linux/stat.h>
 #include <linux/blkdev.h>
+#include <linux/backing-dev.h>
 #include <linux/version.h>
 #include <linux/workqueue.h>
 #include <linux/cpumask.h>
+#include <linux/cpu.h>
 #include <linux/smp.h>
 #include <linux/ioctl.h>
 #include <linux/delay.h>
 #include <linux/sort.h>
+#include <linux/hash.h>
+#include <linux/cgroup.h>
+#include <linux/blk-cgroup.h>
+#include <linux/ioprio.h>
 #include <linux/swap.h>
 #include <linux/thread_info.h>
 #include <asm-generic/ioctl.h>
 #include <linux/bitops.h>
 #include <linux/crc16.h>
 #include <linux/crc32.h>
+#include <linux/crc32c.h>
 #include <linux/nmi.h>
 #include <linux/ratelimit.h>
 #include <linux/mm.h>
 #include <linux/blk-mq.h>
+#include <linux/dax.h>
+#include <linux/highmem.h>
+#include <linux/crypto.h>
+#include <linux/lz4.h>
+#include <linux/rhashtable.h>
+#include <linux/hashtable.h>
+#include <linux/jhash.h>
+#include <linux/xxhash.h>
 #include <linux/ktime.h>
+#include <linux/eventfd.h>
 #include "exp_obj.h"
 
 #include "generated_defines.h"
@@ -4,6 +4,11 @@
 */
 
 #include "cas_cache.h"
+#include "threads.h"
+#include "utils/utils_rpool.h"
+
+#define CREATE_TRACE_POINTS
+#include "cas_trace.h"
 
 /* Layer information. */
 MODULE_AUTHOR("Intel(R) Corporation");
@@ -31,13 +36,379 @@ u32 unaligned_io = 1;
 module_param(unaligned_io, uint, (S_IRUSR | S_IRGRP));
 MODULE_PARM_DESC(unaligned_io,
 		"Define how to handle I/O requests unaligned to 4 kiB, "
-		"0 - apply PT, 1 - handle by cache");
+		"0 - apply PT, 1 - handle by cache, tracking validity and "
+		"dirtiness of each 512 B sector of cache line, so that "
+		"unaligned write never reads core");
 
 u32 seq_cut_off_mb = 1;
 module_param(seq_cut_off_mb, uint, (S_IRUSR | S_IRGRP));
 MODULE_PARM_DESC(seq_cut_off_mb,
 		"Sequential cut off threshold in MiB. 0 - disable");
 
+u32 io_split_size_mb = 32;
+module_param(io_split_size_mb, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(io_split_size_mb,
+		"Max size in MiB of single I/O submitted to cache when exported "
+		"object bio is split (32)");
+
+u32 read_split_kb = 0;
+module_param(read_split_kb, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(read_split_kb,
+		"Max size in KiB of single read submitted to cache, rounded up "
+		"to cache line size, so that cached and missing parts of larger "
+		"reads are served by cache and core device in parallel, "
+		"0 - reads are split like writes (0)");
+
+u32 deferred_vfree = 0;
+module_param(deferred_vfree, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(deferred_vfree,
+		"Hand vmalloc'ed memory over to per CPU collector work instead "
+		"of freeing it in context of caller, 0 - disabled (0)");
+
+u32 zero_copy_bio = 1;
+module_param(zero_copy_bio, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(zero_copy_bio,
+		"Define how data of exported object bios is passed to cache, "
+		"0 - copy bio vectors, 1 - reference bio vectors when possible");
+
+u32 request_based_io = 0;
+module_param(request_based_io, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(request_based_io,
+		"Define how exported object receives I/O, "
+		"0 - bio based (submit_bio), 1 - request based (blk-mq queue_rq)");
+
+u32 poll_queues = 0;
+module_param(poll_queues, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(poll_queues,
+		"Number of exported object poll queues, used only when "
+		"request_based_io is enabled (0)");
+
+u32 numa_io_steering = CAS_IO_STEERING_NONE;
+module_param(numa_io_steering, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(numa_io_steering,
+		"Define which cache queue serves exported object I/O, "
+		"0 - queue of submitting CPU, 1 - queue on cache device NUMA node, "
+		"2 - queue on NUMA node LBA range of data I/O is sharded to");
+
+u32 numa_shard_size_mb = 64;
+module_param(numa_shard_size_mb, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(numa_shard_size_mb,
+		"LBA range of core served by single NUMA node with numa_io_steering "
+		"set to 2, power of two [MiB] (64)");
+
+u32 queue_topology = CAS_QUEUE_TOPOLOGY_CPU;
+module_param(queue_topology, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(queue_topology,
+		"Define how cache I/O queues are assigned to CPUs, "
+		"0 - queue per CPU, 1 - queue per last level cache, "
+		"2 - queue per NUMA node, 3 - queue_count queues (0)");
+
+u32 queue_count = 0;
+module_param(queue_count, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(queue_count,
+		"Number of cache I/O queues, used only when queue_topology "
+		"is 3, limited to number of online CPUs");
+
+u32 porter_select = CAS_PORTER_SELECT_SCAN;
+module_param(porter_select, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(porter_select,
+		"Define how porter queue for cleaning is selected, "
+		"0 - least loaded of all queues, 1 - less loaded of two sampled "
+		"queues, 2 - round-robin on cache device NUMA node (0)");
+
+u32 cleaner_dirty_watermark = 0;
+module_param(cleaner_dirty_watermark, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(cleaner_dirty_watermark,
+		"Percent of dirty cache lines cleaner wakeup interval shrinks "
+		"towards while core devices are idle, 0 - use interval returned "
+		"by cleaning policy (0)");
+
+u32 thread_sched_policy[CAS_THREAD_TYPE_MAX] = {
+	[CAS_THREAD_IDLE_IO] = CAS_THREAD_SCHED_IDLE,
+};
+module_param_array(thread_sched_policy, uint, NULL, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(thread_sched_policy,
+		"Scheduling policy of I/O, porter, management, cleaner and idle "
+		"I/O threads, comma separated, 0 - normal, 1 - low priority FIFO, "
+		"2 - idle (0,0,0,0,2)");
+
+int thread_nice[CAS_THREAD_TYPE_MAX];
+module_param_array(thread_nice, int, NULL, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(thread_nice,
+		"Nice value <-20-19> of I/O, porter, management, cleaner and idle "
+		"I/O threads with normal scheduling policy, comma separated "
+		"(0,0,0,0,0)");
+
+u32 idle_io_queues = 0;
+module_param(idle_io_queues, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(idle_io_queues,
+		"Serve I/O of idle I/O priority class from separate queues run "
+		"by idle I/O threads, 0 - disabled, 1 - enabled (0)");
+
+u32 queue_exec_mode = CAS_QUEUE_EXEC_THREAD;
+module_param(queue_exec_mode, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(queue_exec_mode,
+		"Define how cache I/O queues are run, 0 - dedicated threads, "
+		"1 - shared workqueue until sustained load moves queue to "
+		"own thread (0)");
+
+u32 queue_lazy_promote_rate = 1000;
+module_param(queue_lazy_promote_rate, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(queue_lazy_promote_rate,
+		"Number of queue runs per second above which queue run from "
+		"shared workqueue gets own thread, used only when "
+		"queue_exec_mode is 1 (1000)");
+
+u32 classifier_inode_cache = 0;
+module_param(classifier_inode_cache, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(classifier_inode_cache,
+		"Cache IO classification results of file inodes when IO class "
+		"rules depend only on file properties, 0 - disabled, "
+		"1 - enabled");
+
+u32 classifier_latency_sample = 0;
+module_param(classifier_latency_sample, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(classifier_latency_sample,
+		"Measure time of every N-th IO classification, 0 - disabled (0)");
+
+u32 classifier_bpf_hook = 0;
+module_param(classifier_bpf_hook, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(classifier_bpf_hook,
+		"Call cas_cls_bpf_classify() eBPF attach point before IO class "
+		"rules, 0 - disabled, 1 - enabled (0)");
+
+u32 cgroup_stats = 0;
+module_param(cgroup_stats, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(cgroup_stats,
+		"Count hits, misses and bytes of requests to exported objects "
+		"by cgroup of request, for caches started afterwards, "
+		"0 - disabled, 1 - enabled (0)");
+
+u32 fs_meta_learn = 0;
+module_param(fs_meta_learn, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(fs_meta_learn,
+		"Add extents of filesystem metadata I/O (REQ_META) seen on core "
+		"exported objects to metadata map of core, 0 - disabled, "
+		"1 - enabled (0)");
+
+u32 flush_unthrottled = 1;
+module_param(flush_unthrottled, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(flush_unthrottled,
+		"Don't hold back writes of requested cache flush by background "
+		"inflight limit of core devices, so all cores are written back "
+		"at full speed, 0 - disabled, 1 - enabled (1)");
+
+u32 discard_merge_window_us = 0;
+module_param(discard_merge_window_us, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(discard_merge_window_us,
+		"Time in microseconds for which discards sent to cache/core "
+		"device are gathered to merge adjacent ranges, 0 - disabled (0)");
+
+u32 discard_write_zeroes = 0;
+module_param(discard_write_zeroes, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(discard_write_zeroes,
+		"Use write zeroes for discards sent to device not supporting "
+		"discard, 0 - disabled, 1 - enabled");
+
+u32 nowait_submission = 0;
+module_param(nowait_submission, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(nowait_submission,
+		"Submit I/O to cache/core device without waiting for free tags, "
+		"0 - disabled, 1 - enabled");
+
+u32 batch_completions = 0;
+module_param(batch_completions, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(batch_completions,
+		"Complete cache/core device bios in batches outside of interrupt "
+		"handler, 0 - disabled, 1 - enabled");
+
+u32 data_page_order = 0;
+module_param(data_page_order, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(data_page_order,
+		"Max order of pages backing cache data buffers, buffers of "
+		"multiple pages are allocated in chunks of up to 2^order pages, "
+		"0 - single pages only (0)");
+
+u32 latency_histograms = 0;
+module_param(latency_histograms, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(latency_histograms,
+		"Collect per CPU latency histograms of requests to exported "
+		"objects and cache/core devices, applies to devices opened "
+		"afterwards, 0 - disabled, 1 - enabled (0)");
+
+u32 stage_latency_sample = 0;
+module_param(stage_latency_sample, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(stage_latency_sample,
+		"Measure time spent in each stage of every N-th request to "
+		"exported objects, applies to cores added afterwards, "
+		"0 - disabled (0)");
+
+u32 lba_heatmap = 0;
+module_param(lba_heatmap, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(lba_heatmap,
+		"Count reads, writes and read hits per LBA range of cores, "
+		"applies to cores added afterwards, 0 - disabled, "
+		"1 - enabled (0)");
+
+u32 inflight_tracking = 0;
+module_param(inflight_tracking, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(inflight_tracking,
+		"Keep list of inflight requests of cores for --dump-inflight, "
+		"applies to cores added afterwards, 0 - disabled, "
+		"1 - enabled (0)");
+
+u32 mrc_estimation = 0;
+module_param(mrc_estimation, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(mrc_estimation,
+		"Estimate miss ratio curve of cores from sampled reuse "
+		"distances, applies to cores added afterwards, 0 - disabled, "
+		"1 - enabled (0)");
+
+u32 hot_set_regions = 0;
+module_param(hot_set_regions, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(hot_set_regions,
+		"Number of most accessed 128 KiB regions tracked for each core "
+		"to be saved and prefetched after cache reload, applies to "
+		"cores added afterwards, 0 - disabled (0)");
+
+u32 io_trace_records = 0;
+module_param(io_trace_records, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(io_trace_records,
+		"Number of requests of each core kept for each CPU in trace "
+		"to be taken with casadm --capture-trace, applies to cores "
+		"added afterwards, 0 - disabled (0)");
+
+u32 mpool_magazine = 0;
+module_param(mpool_magazine, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(mpool_magazine,
+		"Cache recently freed BIO vector pool objects per CPU, "
+		"0 - disabled, 1 - enabled");
+
+u32 per_cache_bvec_pool = 0;
+module_param(per_cache_bvec_pool, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(per_cache_bvec_pool,
+		"Allocate data of exported object requests from pool of their "
+		"cache with its own reserves instead of pool shared by caches, "
+		"applies to caches started afterwards, 0 - disabled, "
+		"1 - enabled");
+
+u32 dax_cache_volume = 1;
+module_param(dax_cache_volume, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(dax_cache_volume,
+		"Access cache devices supporting DAX directly instead of "
+		"through block layer, applies to caches started afterwards, "
+		"0 - disabled, 1 - enabled");
+
+u32 compressed_cache_volume = 0;
+module_param(compressed_cache_volume, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(compressed_cache_volume,
+		"Compress data of cache devices with LZ4, exposing capacity of "
+		"given percent of device to cache, applies to caches started "
+		"afterwards in wt, wa or pt mode, which are never loaded, "
+		"0 - disabled, 100 to 1000 - capacity");
+
+u32 null_volume_zero_fill = 1;
+module_param(null_volume_zero_fill, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(null_volume_zero_fill,
+		"Fill data read from null volume with zeros, "
+		"0 - disabled, 1 - enabled");
+
+u32 metadata_huge_vmalloc = 1;
+module_param(metadata_huge_vmalloc, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(metadata_huge_vmalloc,
+		"Map vmalloc allocations of at least 2 MiB, e.g. metadata of "
+		"caches, with huge pages where kernel allows it, applies to "
+		"caches started afterwards, 0 - disabled, 1 - enabled");
+
+u32 metadata_write_elision = 0;
+module_param(metadata_write_elision, uint, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(metadata_write_elision,
+		"Leave out writes of metadata pages unchanged since read "
+		"from or written to cache device, e.g. when cache is stopped, "
+		"applies to caches started or loaded afterwards, "
+		"0 - disabled, 1 - enabled");
+
+static int reserve_footprint_get(char *buffer, const struct kernel_param *kp)
+{
+	return sprintf(buffer, "%llu\n", cas_rpool_get_footprint());
+}
+
+static const struct kernel_param_ops reserve_footprint_ops = {
+	.get = reserve_footprint_get,
+};
+
+module_param_cb(reserve_footprint, &reserve_footprint_ops, NULL,
+		(S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(reserve_footprint,
+		"Memory in bytes currently held in reserve pools, read only");
+
+static int metadata_huge_footprint_get(char *buffer,
+		const struct kernel_param *kp)
+{
+	return sprintf(buffer, "%llu\n", env_vmalloc_get_huge_footprint());
+}
+
+static const struct kernel_param_ops metadata_huge_footprint_ops = {
+	.get = metadata_huge_footprint_get,
+};
+
+module_param_cb(metadata_huge_footprint, &metadata_huge_footprint_ops, NULL,
+		(S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(metadata_huge_footprint,
+		"Memory in bytes currently allocated with huge page mappings "
+		"allowed, read only");
+
+static int vfree_backlog_get(char *buffer, const struct kernel_param *kp)
+{
+	return sprintf(buffer, "%u\n", cas_garbage_collector_get_backlog());
+}
+
+static const struct kernel_param_ops vfree_backlog_ops = {
+	.get = vfree_backlog_get,
+};
+
+module_param_cb(vfree_backlog, &vfree_backlog_ops, NULL, (S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(vfree_backlog,
+		"Number of vfree calls deferred by deferred_vfree not done "
+		"yet, read only");
+
+extern struct env_mpool *cas_bvec_pool;
+
+static int mpool_magazine_stats_get(char *buffer,
+		const struct kernel_param *kp)
+{
+	static const int segments[env_mpool_mag_max] = {
+		[env_mpool_mag_1] = 1,
+		[env_mpool_mag_2] = 2,
+		[env_mpool_mag_4] = 4,
+		[env_mpool_mag_16] = 16,
+	};
+	uint64_t hits, misses;
+	int i, len = 0;
+
+	for (i = 0; i < env_mpool_mag_max; i++) {
+		hits = misses = 0;
+		if (cas_bvec_pool) {
+			env_mpool_get_magazine_stats(cas_bvec_pool, i,
+					&hits, &misses);
+		}
+		len += sprintf(buffer + len, "%d %llu %llu\n", segments[i],
+				hits, misses);
+	}
+
+	return len;
+}
+
+static const struct kernel_param_ops mpool_magazine_stats_ops = {
+	.get = mpool_magazine_stats_get,
+};
+
+module_param_cb(mpool_magazine_stats, &mpool_magazine_stats_ops, NULL,
+		(S_IRUSR | S_IRGRP));
+MODULE_PARM_DESC(mpool_magazine_stats,
+		"BIO vector pool magazine hits and misses per number of "
+		"segments, one order per line, read only");
+
 /* globals */
 ocf_ctx_t cas_ctx;
 struct cas_module cas_module;
@@ -45,6 +416,7 @@ struct cas_module cas_module;
 static int __init cas_init_module(void)
 {
 	int result = 0;
+	int i;
 
 	if (!writeback_queue_unblock_size || !max_writeback_queue_size) {
 		printk(KERN_ERR OCF_PREFIX_SHORT
@@ -71,6 +443,222 @@ static int __init cas_init_module(void)
 		return -EINVAL;
 	}
 
+	if (!io_split_size_mb || io_split_size_mb > 1024) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for io_split_size_mb parameter\n");
+		return -EINVAL;
+	}
+
+	if (read_split_kb > 1024 * 1024) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for read_split_kb parameter\n");
+		return -EINVAL;
+	}
+
+	if (zero_copy_bio != 0 && zero_copy_bio != 1) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for zero_copy_bio parameter\n");
+		return -EINVAL;
+	}
+
+	if (deferred_vfree != 0 && deferred_vfree != 1) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for deferred_vfree parameter\n");
+		return -EINVAL;
+	}
+
+	if (request_based_io != 0 && request_based_io != 1) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for request_based_io parameter\n");
+		return -EINVAL;
+	}
+
+	if (numa_io_steering >= CAS_IO_STEERING_MAX) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for numa_io_steering parameter\n");
+		return -EINVAL;
+	}
+
+	if (!is_power_of_2(numa_shard_size_mb) || numa_shard_size_mb > 65536) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for numa_shard_size_mb parameter\n");
+		return -EINVAL;
+	}
+
+	if (discard_merge_window_us > 1000000) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for discard_merge_window_us parameter\n");
+		return -EINVAL;
+	}
+
+	if (discard_write_zeroes != 0 && discard_write_zeroes != 1) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for discard_write_zeroes parameter\n");
+		return -EINVAL;
+	}
+
+	if (nowait_submission != 0 && nowait_submission != 1) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for nowait_submission parameter\n");
+		return -EINVAL;
+	}
+
+	if (batch_completions != 0 && batch_completions != 1) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for batch_completions parameter\n");
+		return -EINVAL;
+	}
+
+	if (data_page_order > CAS_DATA_PAGE_ORDER_MAX) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for data_page_order parameter\n");
+		return -EINVAL;
+	}
+
+	if (queue_topology >= CAS_QUEUE_TOPOLOGY_MAX) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for queue_topology parameter\n");
+		return -EINVAL;
+	}
+
+	if (queue_topology == CAS_QUEUE_TOPOLOGY_FIXED && !queue_count) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for queue_count parameter\n");
+		return -EINVAL;
+	}
+
+	if (idle_io_queues > 1) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for idle_io_queues parameter\n");
+		return -EINVAL;
+	}
+
+	if (flush_unthrottled > 1) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for flush_unthrottled parameter\n");
+		return -EINVAL;
+	}
+
+	if (fs_meta_learn > 1) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for fs_meta_learn parameter\n");
+		return -EINVAL;
+	}
+
+	for (i = 0; i < CAS_THREAD_TYPE_MAX; i++) {
+		if (thread_sched_policy[i] >= CAS_THREAD_SCHED_MAX) {
+			printk(KERN_ERR OCF_PREFIX_SHORT
+					"Invalid value for thread_sched_policy parameter\n");
+			return -EINVAL;
+		}
+
+		if (thread_nice[i] < MIN_NICE || thread_nice[i] > MAX_NICE) {
+			printk(KERN_ERR OCF_PREFIX_SHORT
+					"Invalid value for thread_nice parameter\n");
+			return -EINVAL;
+		}
+	}
+
+	if (queue_exec_mode >= CAS_QUEUE_EXEC_MAX) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for queue_exec_mode parameter\n");
+		return -EINVAL;
+	}
+
+	if (!queue_lazy_promote_rate) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for queue_lazy_promote_rate parameter\n");
+		return -EINVAL;
+	}
+
+	if (classifier_inode_cache != 0 && classifier_inode_cache != 1) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for classifier_inode_cache parameter\n");
+		return -EINVAL;
+	}
+
+	if (classifier_bpf_hook > 1) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for classifier_bpf_hook parameter\n");
+		return -EINVAL;
+	}
+
+	if (cgroup_stats > 1) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for cgroup_stats parameter\n");
+		return -EINVAL;
+	}
+
+	if (cleaner_dirty_watermark > 100) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for cleaner_dirty_watermark parameter\n");
+		return -EINVAL;
+	}
+
+	if (porter_select >= CAS_PORTER_SELECT_MAX) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for porter_select parameter\n");
+		return -EINVAL;
+	}
+
+	if (hot_set_regions > CAS_HOT_SET_REGIONS_MAX) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for hot_set_regions parameter\n");
+		return -EINVAL;
+	}
+
+	if (io_trace_records > CAS_IO_TRACE_RECORDS_MAX) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for io_trace_records parameter\n");
+		return -EINVAL;
+	}
+
+	if (mpool_magazine != 0 && mpool_magazine != 1) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for mpool_magazine parameter\n");
+		return -EINVAL;
+	}
+
+	if (dax_cache_volume != 0 && dax_cache_volume != 1) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for dax_cache_volume parameter\n");
+		return -EINVAL;
+	}
+
+	if (compressed_cache_volume &&
+			(compressed_cache_volume < CAS_COMPRESS_RATIO_MIN ||
+			compressed_cache_volume > CAS_COMPRESS_RATIO_MAX)) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for compressed_cache_volume parameter\n");
+		return -EINVAL;
+	}
+
+	if (null_volume_zero_fill != 0 && null_volume_zero_fill != 1) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for null_volume_zero_fill parameter\n");
+		return -EINVAL;
+	}
+
+	if (per_cache_bvec_pool > 1) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for per_cache_bvec_pool parameter\n");
+		return -EINVAL;
+	}
+
+	if (metadata_huge_vmalloc > 1) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for metadata_huge_vmalloc parameter\n");
+		return -EINVAL;
+	}
+
+	if (metadata_write_elision > 1) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Invalid value for metadata_write_elision parameter\n");
+		return -EINVAL;
+	}
+
+	cas_cls_bpf_init();
+
 	result = cas_init_exp_objs();
 	if (result)
 		return result;
@@ -79,6 +667,10 @@ static int __init cas_init_module(void)
 	if (result)
 		goto error_init_disks;
 
+	result = cas_init_lazy_queues();
+	if (result)
+		goto error_init_lazy_queues;
+
 	result = cas_initialize_context();
 	if (result) {
 		printk(KERN_ERR OCF_PREFIX_SHORT
@@ -86,6 +678,14 @@ static int __init cas_init_module(void)
 		goto error_init_context;
 	}
 
+	result = cache_mngt_init_cpu_hotplug();
+	if (result)
+		goto error_init_cpuhp;
+
+	result = cache_mngt_init_async_ops();
+	if (result)
+		goto error_init_async;
+
 	result = cas_ctrl_device_init();
 	if (result) {
 		printk(KERN_ERR OCF_PREFIX_SHORT
@@ -99,8 +699,14 @@ static int __init cas_init_module(void)
 	return 0;
 
 error_init_device:
+	cache_mngt_deinit_async_ops();
+error_init_async:
+	cache_mngt_deinit_cpu_hotplug();
+error_init_cpuhp:
 	cas_cleanup_context();
 error_init_context:
+	cas_deinit_lazy_queues();
+error_init_lazy_queues:
 	cas_deinit_disks();
 error_init_disks:
 	cas_deinit_exp_objs();
@@ -113,7 +719,11 @@ module_init(cas_init_module);
 static void __exit cas_exit_module(void)
 {
 	cas_ctrl_device_deinit();
+	cache_mngt_deinit_async_ops();
+	cache_mngt_deinit_cpu_hotplug();
 	cas_cleanup_context();
+	cache_mngt_core_pool_index_deinit();
+	cas_deinit_lazy_queues();
 	cas_deinit_disks();
 	cas_deinit_exp_objs();
 }
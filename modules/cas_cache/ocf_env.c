@@ -7,6 +7,79 @@
 #include "utils/utils_rpool.h"
 #include <linux/kmemleak.h>
 
+/* *** VMALLOC *** */
+
+extern u32 metadata_huge_vmalloc;
+
+#ifdef CAS_VMALLOC_HUGE
+/* Huge allocations by page of address, so that their size is known on free */
+static DEFINE_XARRAY(env_vmalloc_huge_map);
+static atomic_t env_vmalloc_huge_count = ATOMIC_INIT(0);
+static atomic64_t env_vmalloc_huge_bytes = ATOMIC64_INIT(0);
+#endif
+
+/*
+ * Large vmalloc allocations are hit at random on each I/O (e.g. hash table
+ * and collision metadata of OCF), so mapping them with PMD sized pages where
+ * possible saves TLB misses on every lookup
+ */
+void *env_vmalloc_huge(size_t size, int flags)
+{
+#ifdef CAS_VMALLOC_HUGE
+	unsigned long pages = DIV_ROUND_UP(size, PAGE_SIZE);
+	void *ptr, *old;
+
+	if (!READ_ONCE(metadata_huge_vmalloc))
+		return cas_vmalloc(size, flags);
+
+	ptr = cas_vmalloc_huge(size, flags);
+	if (!ptr)
+		return NULL;
+
+	old = xa_store(&env_vmalloc_huge_map, (unsigned long)ptr >> PAGE_SHIFT,
+			xa_mk_value(pages), flags & ~(__GFP_HIGHMEM | __GFP_ZERO));
+	if (xa_is_err(old)) {
+		vfree(ptr);
+		return cas_vmalloc(size, flags);
+	}
+
+	atomic_inc(&env_vmalloc_huge_count);
+	atomic64_add((uint64_t)pages << PAGE_SHIFT, &env_vmalloc_huge_bytes);
+
+	return ptr;
+#else
+	return cas_vmalloc(size, flags);
+#endif
+}
+
+void env_vmalloc_untrack(const void *ptr)
+{
+#ifdef CAS_VMALLOC_HUGE
+	void *entry;
+
+	if (!ptr || !atomic_read(&env_vmalloc_huge_count))
+		return;
+
+	entry = xa_erase(&env_vmalloc_huge_map,
+			(unsigned long)ptr >> PAGE_SHIFT);
+	if (!entry)
+		return;
+
+	atomic_dec(&env_vmalloc_huge_count);
+	atomic64_sub(xa_to_value(entry) << PAGE_SHIFT,
+			&env_vmalloc_huge_bytes);
+#endif
+}
+
+uint64_t env_vmalloc_get_huge_footprint(void)
+{
+#ifdef CAS_VMALLOC_HUGE
+	return atomic64_read(&env_vmalloc_huge_bytes);
+#else
+	return 0;
+#endif
+}
+
 /* *** ALLOCATOR *** */
 
 #define CAS_ALLOC_ALLOCATOR_LIMIT 256
@@ -229,6 +302,16 @@ uint32_t env_allocator_item_count(env_allocator *allocator)
 	return atomic_read(&allocator->count);
 }
 
+void env_allocator_get_rpool_stats(env_allocator *allocator,
+		uint64_t *steals, uint64_t *fallbacks)
+{
+	*steals = 0;
+	*fallbacks = 0;
+
+	if (allocator->rpool)
+		cas_rpool_get_stats(allocator->rpool, steals, fallbacks);
+}
+
 static int env_sort_is_aligned(const void *base, int align)
 {
 	return IS_ENABLED(CONFIG_HAVE_EFFICIENT_UNALIGNED_ACCESS) ||
@@ -260,21 +343,39 @@ static void env_sort_generic_swap(void *a, void *b, int size)
 	} while (--size > 0);
 }
 
-void env_sort(void *base, size_t num, size_t size,
+/* Avoid indirect call for swap of whole words */
+static __always_inline void env_sort_do_swap(void *a, void *b, int size,
+	void (*swap_fn)(void *, void *, int size))
+{
+	if (swap_fn == env_sort_u64_swap)
+		env_sort_u64_swap(a, b, size);
+	else if (swap_fn == env_sort_u32_swap)
+		env_sort_u32_swap(a, b, size);
+	else
+		swap_fn(a, b, size);
+}
+
+/* Partitions of that many elements are finished with insertion sort */
+#define ENV_SORT_INSERTION_MAX 16
+
+static void env_sort_insertion(void *base, size_t num, size_t size,
 	int (*cmp_fn)(const void *, const void *),
 	void (*swap_fn)(void *, void *, int size))
 {
-	/* pre-scale counters for performance */
-	int64_t i = (num/2 - 1) * size, n = num * size, c, r;
+	void *end = base + num * size, *i, *j;
 
-	if (!swap_fn) {
-		if (size == 4 && env_sort_is_aligned(base, 4))
-			swap_fn = env_sort_u32_swap;
-		else if (size == 8 && env_sort_is_aligned(base, 8))
-			swap_fn = env_sort_u64_swap;
-		else
-			swap_fn = env_sort_generic_swap;
+	for (i = base + size; i < end; i += size) {
+		for (j = i; j > base && cmp_fn(j - size, j) > 0; j -= size)
+			env_sort_do_swap(j - size, j, size, swap_fn);
 	}
+}
+
+static void env_sort_heap(void *base, size_t num, size_t size,
+	int (*cmp_fn)(const void *, const void *),
+	void (*swap_fn)(void *, void *, int size))
+{
+	/* pre-scale counters for performance */
+	int64_t i = (num/2 - 1) * size, n = num * size, c, r;
 
 	/* heapify */
 	for ( ; i >= 0; i -= size) {
@@ -285,14 +386,14 @@ void env_sort(void *base, size_t num, size_t size,
 				c += size;
 			if (cmp_fn(base + r, base + c) >= 0)
 				break;
-			swap_fn(base + r, base + c, size);
+			env_sort_do_swap(base + r, base + c, size, swap_fn);
 		}
 		env_cond_resched();
 	}
 
 	/* sort */
 	for (i = n - size; i > 0; i -= size) {
-		swap_fn(base, base + i, size);
+		env_sort_do_swap(base, base + i, size, swap_fn);
 		for (r = 0; r * 2 + size < i; r = c) {
 			c = r * 2 + size;
 			if (c < i - size &&
@@ -300,8 +401,98 @@ void env_sort(void *base, size_t num, size_t size,
 				c += size;
 			if (cmp_fn(base + r, base + c) >= 0)
 				break;
-			swap_fn(base + r, base + c, size);
+			env_sort_do_swap(base + r, base + c, size, swap_fn);
+		}
+		env_cond_resched();
+	}
+}
+
+/*
+ * Quicksort with median of three pivot, recursing into smaller partition
+ * only, so that stack depth is logarithmic. Once @depth is exhausted by
+ * unbalanced partitions, the rest is sorted with heap sort, which keeps
+ * worst case at O(n log n).
+ */
+static void env_sort_intro(void *base, size_t num, size_t size,
+	int (*cmp_fn)(const void *, const void *),
+	void (*swap_fn)(void *, void *, int size), int depth)
+{
+	void *end, *lo, *hi, *mid;
+	size_t left, right;
+
+	while (num > ENV_SORT_INSERTION_MAX) {
+		if (depth-- == 0) {
+			env_sort_heap(base, num, size, cmp_fn, swap_fn);
+			return;
+		}
+
+		end = base + num * size;
+		mid = base + (num / 2) * size;
+		hi = end - size;
+
+		/* Order first, middle and last, then move median to front */
+		if (cmp_fn(mid, base) < 0)
+			env_sort_do_swap(mid, base, size, swap_fn);
+		if (cmp_fn(hi, mid) < 0) {
+			env_sort_do_swap(hi, mid, size, swap_fn);
+			if (cmp_fn(mid, base) < 0)
+				env_sort_do_swap(mid, base, size, swap_fn);
+		}
+		env_sort_do_swap(base, mid, size, swap_fn);
+
+		/*
+		 * Both scans stop on elements equal to pivot, which keeps
+		 * partitions balanced for arrays of many equal keys
+		 */
+		lo = base;
+		hi = end;
+		while (true) {
+			do {
+				lo += size;
+			} while (lo < end && cmp_fn(lo, base) < 0);
+			do {
+				hi -= size;
+			} while (cmp_fn(hi, base) > 0);
+			if (lo >= hi)
+				break;
+			env_sort_do_swap(lo, hi, size, swap_fn);
 		}
+		env_sort_do_swap(base, hi, size, swap_fn);
+
+		left = (hi - base) / size;
+		right = num - left - 1;
+		if (left < right) {
+			env_sort_intro(base, left, size, cmp_fn, swap_fn,
+					depth);
+			base = hi + size;
+			num = right;
+		} else {
+			env_sort_intro(hi + size, right, size, cmp_fn,
+					swap_fn, depth);
+			num = left;
+		}
+
 		env_cond_resched();
 	}
+
+	env_sort_insertion(base, num, size, cmp_fn, swap_fn);
+}
+
+void env_sort(void *base, size_t num, size_t size,
+	int (*cmp_fn)(const void *, const void *),
+	void (*swap_fn)(void *, void *, int size))
+{
+	if (num < 2)
+		return;
+
+	if (!swap_fn) {
+		if (size == 4 && env_sort_is_aligned(base, 4))
+			swap_fn = env_sort_u32_swap;
+		else if (size == 8 && env_sort_is_aligned(base, 8))
+			swap_fn = env_sort_u64_swap;
+		else
+			swap_fn = env_sort_generic_swap;
+	}
+
+	env_sort_intro(base, num, size, cmp_fn, swap_fn, 2 * ilog2(num));
 }
@@ -44,8 +44,21 @@ static inline void env_free(const void *ptr)
 	kfree(ptr);
 }
 
+/* Allocations that large, e.g. OCF metadata segments, may be huge mapped */
+#define ENV_VMALLOC_HUGE_MIN (2 * 1024 * 1024)
+
+void *env_vmalloc_huge(size_t size, int flags);
+
+void env_vmalloc_untrack(const void *ptr);
+
+/* Bytes currently allocated with huge mappings allowed */
+uint64_t env_vmalloc_get_huge_footprint(void);
+
 static inline void *env_vmalloc_flags(size_t size, int flags)
 {
+	if (size >= ENV_VMALLOC_HUGE_MIN)
+		return env_vmalloc_huge(size, flags | __GFP_HIGHMEM);
+
 	return cas_vmalloc(size, flags | __GFP_HIGHMEM);
 }
 
@@ -66,6 +79,7 @@ static inline void *env_vzalloc(size_t size)
 
 static inline void env_vfree(const void *ptr)
 {
+	env_vmalloc_untrack(ptr);
 	cas_vfree(ptr);
 }
 
@@ -96,6 +110,10 @@ void env_allocator_del(env_allocator *allocator, void *item);
 
 uint32_t env_allocator_item_count(env_allocator *allocator);
 
+/* Reserve pool gets stolen from sibling CPU and falling back to slab */
+void env_allocator_get_rpool_stats(env_allocator *allocator,
+		uint64_t *steals, uint64_t *fallbacks);
+
 /* *** MUTEX *** */
 
 typedef struct mutex env_mutex;
@@ -644,7 +662,8 @@ static inline void env_put_execution_context(unsigned ctx)
 
 static inline unsigned env_get_execution_context_count(void)
 {
-	return num_online_cpus();
+	/* Execution context is CPU id, which may exceed online CPU count */
+	return nr_cpu_ids;
 }
 
 #endif /* __OCF_ENV_H__ */
@@ -0,0 +1,332 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "cas_cache.h"
+#include "threads.h"
+
+/* Interval of bandwidth budget refill */
+#define CAS_PREFETCH_TICK (HZ / 10)
+
+/* Single read stays below sequential cutoff threshold */
+#define CAS_PREFETCH_IO_SECTORS KCAS_HOT_SET_REGION_SECTORS
+
+/* Reads in flight for whole cache */
+#define CAS_PREFETCH_INFLIGHT_MAX 16
+
+struct cas_prefetch_batch {
+	struct list_head list;
+	ocf_core_id_t core_id;
+	uint32_t io_class;
+	uint32_t count;
+	/* Next range to read and sectors of it already submitted */
+	uint32_t next;
+	uint64_t offset;
+	struct kcas_prefetch_range ranges[];
+};
+
+static uint64_t _cas_prefetch_batch_left(struct cas_prefetch_batch *batch)
+{
+	uint64_t left = 0;
+	uint32_t i;
+
+	for (i = batch->next; i < batch->count; i++)
+		left += batch->ranges[i].sectors;
+
+	return left - batch->offset;
+}
+
+static void _cas_prefetch_io_end(void *priv, uint32_t sectors, int error)
+{
+	struct cas_prefetch *prefetch = priv;
+	unsigned long flags;
+
+	spin_lock_irqsave(&prefetch->lock, flags);
+	if (error)
+		prefetch->failed_sectors += sectors;
+	else
+		prefetch->done_sectors += sectors;
+	prefetch->pending_sectors -= sectors;
+	/* Kicked before inflight drops so that stopping cancels the work */
+	if (!prefetch->stopped && !list_empty(&prefetch->batches))
+		mod_delayed_work(system_wq, &prefetch->work, 0);
+	spin_unlock_irqrestore(&prefetch->lock, flags);
+
+	atomic_dec(&prefetch->inflight);
+	wake_up(&prefetch->wait);
+}
+
+struct cas_prefetch_io {
+	cas_prefetch_end_t end;
+	void *priv;
+	ctx_data_t *data;
+	uint32_t sectors;
+};
+
+static void _cas_prefetch_complete(ocf_io_t io, void *priv1, void *priv2,
+		int error)
+{
+	struct cas_prefetch_io *pio = priv2;
+
+	cas_ctx_data_free(pio->data);
+	ocf_io_put(io);
+
+	pio->end(pio->priv, pio->sectors, error);
+
+	kfree(pio);
+}
+
+int cas_prefetch_read(ocf_core_t core, uint32_t io_class, uint64_t sector,
+		uint32_t sectors, cas_prefetch_end_t end, void *priv)
+{
+	ocf_cache_t cache = ocf_core_get_cache(core);
+	struct cas_prefetch_io *pio;
+	ocf_io_t io;
+	int result = -ENOMEM;
+
+	pio = kmalloc(sizeof(*pio), GFP_NOIO);
+	if (!pio)
+		return result;
+
+	pio->end = end;
+	pio->priv = priv;
+	pio->sectors = sectors;
+	pio->data = cas_ctx_data_alloc(DIV_ROUND_UP(sectors << SECTOR_SHIFT,
+			PAGE_SIZE));
+	if (!pio->data)
+		goto err_data;
+
+	io = ocf_volume_new_io(ocf_core_get_front_volume(core),
+			cache_get_fastest_porter_queue(cache),
+			sector << SECTOR_SHIFT, sectors << SECTOR_SHIFT,
+			OCF_READ, io_class, 0);
+	if (!io)
+		goto err_io;
+
+	result = ocf_io_set_data(io, pio->data, 0);
+	if (result < 0) {
+		result = -EINVAL;
+		goto err_set_data;
+	}
+
+	ocf_io_set_cmpl(io, NULL, pio, _cas_prefetch_complete);
+	ocf_volume_submit_io(io);
+
+	return 0;
+
+err_set_data:
+	ocf_io_put(io);
+err_io:
+	cas_ctx_data_free(pio->data);
+err_data:
+	kfree(pio);
+	return result;
+}
+
+static void _cas_prefetch_work(struct work_struct *work)
+{
+	struct cas_prefetch *prefetch = container_of(to_delayed_work(work),
+			struct cas_prefetch, work);
+	struct cache_priv *cache_priv = container_of(prefetch,
+			struct cache_priv, prefetch);
+	ocf_cache_t cache = cache_priv->cache;
+	struct cas_prefetch_batch *batch, *done;
+	struct kcas_prefetch_range *range;
+	ocf_core_id_t core_id;
+	ocf_core_t core;
+	uint64_t sector;
+	uint32_t sectors, io_class;
+	bool more;
+
+	/* Don't wait for management operation, possibly stopping cache */
+	if (ocf_mngt_cache_read_trylock(cache)) {
+		schedule_delayed_work(&prefetch->work, CAS_PREFETCH_TICK);
+		return;
+	}
+
+	spin_lock_irq(&prefetch->lock);
+	if (time_after_eq(jiffies, prefetch->refill + CAS_PREFETCH_TICK)) {
+		prefetch->budget = ((uint64_t)prefetch->rate_limit << 20) *
+				CAS_PREFETCH_TICK / HZ;
+		prefetch->refill = jiffies;
+	}
+	spin_unlock_irq(&prefetch->lock);
+
+	while (atomic_read(&prefetch->inflight) < CAS_PREFETCH_INFLIGHT_MAX) {
+		done = NULL;
+
+		spin_lock_irq(&prefetch->lock);
+		batch = list_first_entry_or_null(&prefetch->batches,
+				struct cas_prefetch_batch, list);
+		if (!batch || prefetch->stopped ||
+				(prefetch->rate_limit && !prefetch->budget)) {
+			spin_unlock_irq(&prefetch->lock);
+			break;
+		}
+
+		range = &batch->ranges[batch->next];
+		core_id = batch->core_id;
+		io_class = batch->io_class;
+		sector = range->sector + batch->offset;
+		sectors = min_t(uint64_t, range->sectors - batch->offset,
+				CAS_PREFETCH_IO_SECTORS);
+
+		batch->offset += sectors;
+		if (batch->offset == range->sectors) {
+			batch->next++;
+			batch->offset = 0;
+		}
+		if (batch->next == batch->count) {
+			list_del(&batch->list);
+			done = batch;
+		}
+
+		if (prefetch->rate_limit) {
+			prefetch->budget -= min_t(uint64_t, prefetch->budget,
+					sectors << SECTOR_SHIFT);
+		}
+
+		/* Counted before unlocking for stopping to wait for it */
+		atomic_inc(&prefetch->inflight);
+		spin_unlock_irq(&prefetch->lock);
+
+		vfree(done);
+
+		if (get_core_by_id(cache, core_id, &core) ||
+				ocf_core_get_state(core) !=
+				ocf_core_state_active ||
+				cas_prefetch_read(core, io_class, sector,
+						sectors, _cas_prefetch_io_end,
+						prefetch)) {
+			_cas_prefetch_io_end(prefetch, sectors, -EIO);
+		}
+	}
+
+	spin_lock_irq(&prefetch->lock);
+	more = !prefetch->stopped && !list_empty(&prefetch->batches);
+	spin_unlock_irq(&prefetch->lock);
+
+	/* Completions kick the work sooner when reads are in flight */
+	if (more)
+		schedule_delayed_work(&prefetch->work, CAS_PREFETCH_TICK);
+
+	ocf_mngt_cache_read_unlock(cache);
+}
+
+void cas_prefetch_init(struct cache_priv *cache_priv)
+{
+	struct cas_prefetch *prefetch = &cache_priv->prefetch;
+
+	spin_lock_init(&prefetch->lock);
+	INIT_LIST_HEAD(&prefetch->batches);
+	atomic_set(&prefetch->inflight, 0);
+	init_waitqueue_head(&prefetch->wait);
+	INIT_DELAYED_WORK(&prefetch->work, _cas_prefetch_work);
+}
+
+/* Drop batches matching @core_id, OCF_CORE_ID_INVALID dropping all */
+static void _cas_prefetch_drop(struct cas_prefetch *prefetch,
+		ocf_core_id_t core_id, bool stop)
+{
+	struct cas_prefetch_batch *batch, *tmp;
+	LIST_HEAD(dropped);
+
+	spin_lock_irq(&prefetch->lock);
+	if (stop)
+		prefetch->stopped = true;
+	list_for_each_entry_safe(batch, tmp, &prefetch->batches, list) {
+		if (core_id != OCF_CORE_ID_INVALID && batch->core_id != core_id)
+			continue;
+		prefetch->pending_sectors -= _cas_prefetch_batch_left(batch);
+		list_move(&batch->list, &dropped);
+	}
+	spin_unlock_irq(&prefetch->lock);
+
+	list_for_each_entry_safe(batch, tmp, &dropped, list)
+		vfree(batch);
+
+	/* Reads of other cores are awaited too, there are only few */
+	wait_event(prefetch->wait, !atomic_read(&prefetch->inflight));
+}
+
+void cas_prefetch_stop(struct cache_priv *cache_priv)
+{
+	struct cas_prefetch *prefetch = &cache_priv->prefetch;
+
+	_cas_prefetch_drop(prefetch, OCF_CORE_ID_INVALID, true);
+	cancel_delayed_work_sync(&prefetch->work);
+}
+
+void cas_prefetch_cancel(ocf_cache_t cache, ocf_core_id_t core_id)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+
+	_cas_prefetch_drop(&cache_priv->prefetch, core_id, false);
+}
+
+int cas_prefetch_queue(ocf_cache_t cache, ocf_core_t core,
+		const struct kcas_prefetch_range *ranges, uint32_t count,
+		uint32_t io_class, uint32_t rate_limit)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	struct cas_prefetch *prefetch = &cache_priv->prefetch;
+	struct cas_prefetch_batch *batch;
+	uint64_t core_sectors, sectors = 0;
+	uint32_t i, used = 0;
+
+	core_sectors = ocf_volume_get_length(ocf_core_get_volume(core)) >>
+			SECTOR_SHIFT;
+
+	batch = vmalloc(struct_size(batch, ranges, count));
+	if (!batch)
+		return -ENOMEM;
+
+	/* Ranges beyond end of core are trimmed */
+	for (i = 0; i < count; i++) {
+		if (ranges[i].sector >= core_sectors || !ranges[i].sectors)
+			continue;
+		batch->ranges[used].sector = ranges[i].sector;
+		batch->ranges[used].sectors = min(ranges[i].sectors,
+				core_sectors - ranges[i].sector);
+		sectors += batch->ranges[used].sectors;
+		used++;
+	}
+
+	batch->core_id = ocf_core_get_id(core);
+	batch->io_class = io_class;
+	batch->count = used;
+	batch->next = 0;
+	batch->offset = 0;
+
+	spin_lock_irq(&prefetch->lock);
+	if (prefetch->stopped) {
+		spin_unlock_irq(&prefetch->lock);
+		vfree(batch);
+		return -OCF_ERR_CACHE_NOT_EXIST;
+	}
+	prefetch->rate_limit = rate_limit;
+	if (used) {
+		list_add_tail(&batch->list, &prefetch->batches);
+		prefetch->pending_sectors += sectors;
+		batch = NULL;
+	}
+	mod_delayed_work(system_wq, &prefetch->work, 0);
+	spin_unlock_irq(&prefetch->lock);
+
+	vfree(batch);
+
+	return 0;
+}
+
+void cas_prefetch_get_progress(ocf_cache_t cache, struct kcas_prefetch *cmd)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	struct cas_prefetch *prefetch = &cache_priv->prefetch;
+
+	spin_lock_irq(&prefetch->lock);
+	cmd->pending_sectors = prefetch->pending_sectors;
+	cmd->done_sectors = prefetch->done_sectors;
+	cmd->failed_sectors = prefetch->failed_sectors;
+	spin_unlock_irq(&prefetch->lock);
+}
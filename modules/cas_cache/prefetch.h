@@ -0,0 +1,58 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __PREFETCH_H__
+#define __PREFETCH_H__
+
+struct cache_priv;
+
+/*
+ * Background reads of core ranges inserting them into cache, e.g. hot set
+ * saved before cache was stopped or extents of files about to be read. Ranges are queued in batches, one per
+ * request, and read in order on porter queues within bandwidth limit.
+ */
+struct cas_prefetch {
+	/* Protects all fields but inflight, wait and work */
+	spinlock_t lock;
+	bool stopped;
+	struct list_head batches;
+	/* Bandwidth limit in MiB/s, 0 for unlimited */
+	uint32_t rate_limit;
+	/* Bytes which may be read until next refill */
+	uint64_t budget;
+	unsigned long refill;
+	uint64_t pending_sectors;
+	uint64_t done_sectors;
+	uint64_t failed_sectors;
+	atomic_t inflight;
+	wait_queue_head_t wait;
+	struct delayed_work work;
+};
+
+void cas_prefetch_init(struct cache_priv *cache_priv);
+
+/* Drop queued ranges and wait for reads, called once cache is stopping */
+void cas_prefetch_stop(struct cache_priv *cache_priv);
+
+/* Queue ranges of core into io class, called under management read lock */
+int cas_prefetch_queue(ocf_cache_t cache, ocf_core_t core,
+		const struct kcas_prefetch_range *ranges, uint32_t count,
+		uint32_t io_class, uint32_t rate_limit);
+
+/* Drop ranges of removed core and wait for reads, under management lock */
+void cas_prefetch_cancel(ocf_cache_t cache, ocf_core_id_t core_id);
+
+void cas_prefetch_get_progress(ocf_cache_t cache, struct kcas_prefetch *cmd);
+
+typedef void (*cas_prefetch_end_t)(void *priv, uint32_t sectors, int error);
+
+/*
+ * Read range of core through cache on porter queue, @end is called once
+ * read completes unless submission fails. May sleep.
+ */
+int cas_prefetch_read(ocf_core_t core, uint32_t io_class, uint64_t sector,
+		uint32_t sectors, cas_prefetch_end_t end, void *priv);
+
+#endif /* __PREFETCH_H__ */
@@ -0,0 +1,205 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "cas_cache.h"
+
+/* Credit bucket accumulates while idle, in time of its rate */
+#define CAS_QOS_BURST_NS (100 * NSEC_PER_MSEC)
+
+/* Pauses shorter than that are not worth sleeping for */
+#define CAS_QOS_MIN_PAUSE_NS (50 * NSEC_PER_USEC)
+
+struct cas_qos_bucket {
+	uint32_t rate;
+		/*< Requests or MiB per second, 0 - unlimited */
+
+	uint64_t vtime;
+		/*< Time bucket is drained at with requests charged so far */
+};
+
+struct cas_qos_scope {
+	/* Protects buckets */
+	spinlock_t lock;
+	struct cas_qos_bucket buckets[2][CAS_QOS_LIMIT_MAX];
+	atomic64_t throttled_ns[2];
+};
+
+struct cas_qos {
+	atomic_t limits;
+		/*< Buckets with rate set */
+
+	atomic_t io_class_limits;
+		/*< Buckets of io classes with rate set */
+
+	struct cas_qos_scope core;
+	struct cas_qos_scope io_class[OCF_USER_IO_CLASS_MAX];
+};
+
+static void _cas_qos_scope_init(struct cas_qos_scope *scope)
+{
+	spin_lock_init(&scope->lock);
+	atomic64_set(&scope->throttled_ns[READ], 0);
+	atomic64_set(&scope->throttled_ns[WRITE], 0);
+}
+
+struct cas_qos *cas_qos_create(void)
+{
+	struct cas_qos *qos;
+	int i;
+
+	qos = kzalloc(sizeof(*qos), GFP_KERNEL);
+	if (!qos)
+		return NULL;
+
+	atomic_set(&qos->limits, 0);
+	atomic_set(&qos->io_class_limits, 0);
+	_cas_qos_scope_init(&qos->core);
+	for (i = 0; i < OCF_USER_IO_CLASS_MAX; i++)
+		_cas_qos_scope_init(&qos->io_class[i]);
+
+	return qos;
+}
+
+void cas_qos_destroy(struct cas_qos *qos)
+{
+	kfree(qos);
+}
+
+static uint64_t _cas_qos_cost(struct cas_qos_bucket *b,
+		enum cas_qos_limit limit, uint64_t bytes)
+{
+	if (limit == CAS_QOS_IOPS)
+		return div_u64(NSEC_PER_SEC, b->rate);
+
+	return div64_u64(bytes * NSEC_PER_SEC, (uint64_t)b->rate << 20);
+}
+
+/* Charge request to buckets of scope, returns time it has to wait for */
+static uint64_t _cas_qos_charge(struct cas_qos_scope *scope, int dir,
+		uint64_t bytes, uint64_t now)
+{
+	uint64_t start, wait = 0, idle = now > CAS_QOS_BURST_NS ?
+			now - CAS_QOS_BURST_NS : 0;
+	struct cas_qos_bucket *b;
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&scope->lock, flags);
+	for (i = 0; i < CAS_QOS_LIMIT_MAX; i++) {
+		b = &scope->buckets[dir][i];
+		if (!b->rate)
+			continue;
+
+		/* Credit of idle bucket is capped by burst */
+		start = max(b->vtime, idle);
+		b->vtime = start + _cas_qos_cost(b, i, bytes);
+		if (start > now)
+			wait = max(wait, start - now);
+	}
+	spin_unlock_irqrestore(&scope->lock, flags);
+
+	return wait;
+}
+
+void cas_qos_balance(struct cas_qos *qos, ocf_part_id_t io_class, int dir,
+		uint64_t bytes, bool may_sleep)
+{
+	struct cas_qos_scope *class_scope = NULL;
+	uint64_t now, wait;
+
+	if (!atomic_read(&qos->limits))
+		return;
+
+	if (atomic_read(&qos->io_class_limits) &&
+			io_class < OCF_USER_IO_CLASS_MAX) {
+		class_scope = &qos->io_class[io_class];
+	}
+
+	now = ktime_get_ns();
+	wait = _cas_qos_charge(&qos->core, dir, bytes, now);
+	if (class_scope)
+		wait = max(wait, _cas_qos_charge(class_scope, dir, bytes, now));
+
+	/* Requests which can't be paused are charged nevertheless */
+	if (!may_sleep || wait < CAS_QOS_MIN_PAUSE_NS)
+		return;
+
+	atomic64_add(wait, &qos->core.throttled_ns[dir]);
+	if (class_scope)
+		atomic64_add(wait, &class_scope->throttled_ns[dir]);
+
+	wait = div_u64(wait, NSEC_PER_USEC);
+	usleep_range(wait, wait + wait / 8);
+}
+
+static struct cas_qos_scope *_cas_qos_scope(struct cas_qos *qos,
+		uint32_t io_class)
+{
+	if (io_class == OCF_IO_CLASS_INVALID)
+		return &qos->core;
+
+	if (io_class >= OCF_USER_IO_CLASS_MAX)
+		return NULL;
+
+	return &qos->io_class[io_class];
+}
+
+int cas_qos_set_limit(struct cas_qos *qos, uint32_t io_class, int dir,
+		enum cas_qos_limit limit, uint32_t rate)
+{
+	struct cas_qos_scope *scope = _cas_qos_scope(qos, io_class);
+	struct cas_qos_bucket *b;
+	uint32_t old;
+
+	if (!scope)
+		return -EINVAL;
+
+	b = &scope->buckets[dir][limit];
+
+	spin_lock_irq(&scope->lock);
+	old = b->rate;
+	b->rate = rate;
+	/* New rate starts with empty bucket */
+	b->vtime = 0;
+	spin_unlock_irq(&scope->lock);
+
+	if (!old == !rate)
+		return 0;
+
+	atomic_add(rate ? 1 : -1, &qos->limits);
+	if (scope != &qos->core)
+		atomic_add(rate ? 1 : -1, &qos->io_class_limits);
+
+	return 0;
+}
+
+int cas_qos_get_limit(struct cas_qos *qos, uint32_t io_class, int dir,
+		enum cas_qos_limit limit, uint32_t *rate)
+{
+	struct cas_qos_scope *scope = _cas_qos_scope(qos, io_class);
+
+	if (!scope)
+		return -EINVAL;
+
+	spin_lock_irq(&scope->lock);
+	*rate = scope->buckets[dir][limit].rate;
+	spin_unlock_irq(&scope->lock);
+
+	return 0;
+}
+
+int cas_qos_get_throttled(struct cas_qos *qos, uint32_t io_class, int dir,
+		uint32_t *ms)
+{
+	struct cas_qos_scope *scope = _cas_qos_scope(qos, io_class);
+
+	if (!scope)
+		return -EINVAL;
+
+	*ms = min_t(uint64_t, div_u64(atomic64_read(&scope->throttled_ns[dir]),
+			NSEC_PER_MSEC), U32_MAX);
+
+	return 0;
+}
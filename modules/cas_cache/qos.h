@@ -0,0 +1,51 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __QOS_H__
+#define __QOS_H__
+
+struct cas_qos;
+
+enum cas_qos_limit {
+	CAS_QOS_IOPS,
+		/*< Requests per second */
+
+	CAS_QOS_BANDWIDTH,
+		/*< MiB per second */
+
+	CAS_QOS_LIMIT_MAX,
+};
+
+/*
+ * Token bucket limits of requests and bandwidth of core and of its io
+ * classes, separate for reads and writes. Requests of exported object are
+ * charged to buckets of core and of their io class before being submitted to
+ * OCF, and their submitter is paused until all of the buckets allow them.
+ * Buckets accumulate up to 100 ms of their rate while idle.
+ */
+struct cas_qos *cas_qos_create(void);
+
+void cas_qos_destroy(struct cas_qos *qos);
+
+/*
+ * Charge request and pause submitter as needed if @may_sleep is set, called
+ * before submission to OCF
+
+ */
+void cas_qos_balance(struct cas_qos *qos, ocf_part_id_t io_class, int dir,
+		uint64_t bytes, bool may_sleep);
+
+/* Limit of io class or of whole core if @io_class is OCF_IO_CLASS_INVALID */
+int cas_qos_set_limit(struct cas_qos *qos, uint32_t io_class, int dir,
+		enum cas_qos_limit limit, uint32_t rate);
+
+int cas_qos_get_limit(struct cas_qos *qos, uint32_t io_class, int dir,
+		enum cas_qos_limit limit, uint32_t *rate);
+
+/* Total time requests were paused for, in milliseconds */
+int cas_qos_get_throttled(struct cas_qos *qos, uint32_t io_class, int dir,
+		uint32_t *ms);
+
+#endif /* __QOS_H__ */
@@ -0,0 +1,256 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "cas_cache.h"
+
+/* Ascending streams tracked per core */
+#define CAS_READ_AHEAD_STREAMS 8
+
+/* Reads continuing stream before read-ahead of it starts */
+#define CAS_READ_AHEAD_TRIGGER 2
+
+/* Windows waiting for submission per core, more are dropped */
+#define CAS_READ_AHEAD_PENDING_MAX 8
+
+/* Read-ahead reads in flight per core */
+#define CAS_READ_AHEAD_INFLIGHT_MAX 4
+
+/* Largest single read-ahead read, 1 MiB */
+#define CAS_READ_AHEAD_IO_SECTORS 2048
+
+struct cas_read_ahead_stream {
+	/* Sector following last read of stream */
+	sector_t next;
+	/* End of range already read ahead */
+	sector_t ahead;
+	uint32_t reads;
+	/* Jiffies of last read, least recently read stream is replaced */
+	unsigned long stamp;
+};
+
+struct cas_read_ahead_window {
+	sector_t sector;
+	uint64_t sectors;
+	uint32_t io_class;
+};
+
+struct cas_read_ahead {
+	ocf_core_t core;
+	uint64_t core_sectors;
+	uint32_t line_sectors;
+	uint32_t lines[OCF_USER_IO_CLASS_MAX];
+
+	/* Protects streams, pending and stopped */
+	spinlock_t lock;
+	bool stopped;
+	struct cas_read_ahead_stream streams[CAS_READ_AHEAD_STREAMS];
+	struct cas_read_ahead_window pending[CAS_READ_AHEAD_PENDING_MAX];
+	uint32_t pending_count;
+
+	atomic_t inflight;
+	wait_queue_head_t wait;
+	struct work_struct work;
+};
+
+/* Skip read-ahead while half of foreground inflight limit of core is used */
+static bool _cas_read_ahead_core_busy(struct cas_read_ahead *ra)
+{
+	ocf_volume_t volume = ocf_core_get_volume(ra->core);
+	uint32_t limit = block_dev_get_inflight_limit(volume,
+			CAS_BD_IO_FOREGROUND);
+
+	return limit && block_dev_get_inflight(volume, CAS_BD_IO_FOREGROUND) >=
+			DIV_ROUND_UP(limit, 2);
+}
+
+static void _cas_read_ahead_end(void *priv, uint32_t sectors, int error)
+{
+	struct cas_read_ahead *ra = priv;
+	unsigned long flags;
+
+	spin_lock_irqsave(&ra->lock, flags);
+	/* Kicked before inflight drops so that destroying cancels the work */
+	if (!ra->stopped && ra->pending_count)
+		queue_work(system_wq, &ra->work);
+	spin_unlock_irqrestore(&ra->lock, flags);
+
+	atomic_dec(&ra->inflight);
+	wake_up(&ra->wait);
+}
+
+static void _cas_read_ahead_work(struct work_struct *work)
+{
+	struct cas_read_ahead *ra = container_of(work, struct cas_read_ahead,
+			work);
+	struct cas_read_ahead_window *window;
+	uint32_t sectors, io_class;
+	sector_t sector;
+
+	while (atomic_read(&ra->inflight) < CAS_READ_AHEAD_INFLIGHT_MAX) {
+		spin_lock_irq(&ra->lock);
+		if (ra->stopped || !ra->pending_count) {
+			spin_unlock_irq(&ra->lock);
+			break;
+		}
+
+		/* Read-ahead is only a hint, so it yields to loaded core */
+		if (_cas_read_ahead_core_busy(ra)) {
+			ra->pending_count = 0;
+			spin_unlock_irq(&ra->lock);
+			break;
+		}
+
+		/* Oldest window first, so that streams are read in order */
+		window = &ra->pending[0];
+		sector = window->sector;
+		sectors = min_t(uint64_t, window->sectors,
+				CAS_READ_AHEAD_IO_SECTORS);
+		io_class = window->io_class;
+
+		window->sector += sectors;
+		window->sectors -= sectors;
+		if (!window->sectors) {
+			ra->pending_count--;
+			memmove(&ra->pending[0], &ra->pending[1],
+					ra->pending_count * sizeof(*window));
+		}
+
+		/* Counted before unlocking for destroying to wait for it */
+		atomic_inc(&ra->inflight);
+		spin_unlock_irq(&ra->lock);
+
+		if (cas_prefetch_read(ra->core, io_class, sector, sectors,
+				_cas_read_ahead_end, ra)) {
+			_cas_read_ahead_end(ra, sectors, -ENOMEM);
+		}
+	}
+}
+
+struct cas_read_ahead *cas_read_ahead_create(ocf_core_t core)
+{
+	ocf_cache_t cache = ocf_core_get_cache(core);
+	struct cas_read_ahead *ra;
+
+	ra = kzalloc(sizeof(*ra), GFP_KERNEL);
+	if (!ra)
+		return NULL;
+
+	ra->core = core;
+	ra->core_sectors = ocf_volume_get_length(ocf_core_get_volume(core)) >>
+			SECTOR_SHIFT;
+	ra->line_sectors = ocf_cache_get_line_size(cache) >> SECTOR_SHIFT;
+	spin_lock_init(&ra->lock);
+	atomic_set(&ra->inflight, 0);
+	init_waitqueue_head(&ra->wait);
+	INIT_WORK(&ra->work, _cas_read_ahead_work);
+
+	return ra;
+}
+
+void cas_read_ahead_destroy(struct cas_read_ahead *ra)
+{
+	spin_lock_irq(&ra->lock);
+	ra->stopped = true;
+	ra->pending_count = 0;
+	spin_unlock_irq(&ra->lock);
+
+	cancel_work_sync(&ra->work);
+	wait_event(ra->wait, !atomic_read(&ra->inflight));
+
+	kfree(ra);
+}
+
+static struct cas_read_ahead_stream *_cas_read_ahead_find(
+		struct cas_read_ahead *ra, sector_t sector, bool *found)
+{
+	struct cas_read_ahead_stream *stream, *oldest = &ra->streams[0];
+	int i;
+
+	for (i = 0; i < CAS_READ_AHEAD_STREAMS; i++) {
+		stream = &ra->streams[i];
+		if (stream->reads && stream->next == sector) {
+			*found = true;
+			return stream;
+		}
+		/* Unused stream is taken before any of used ones */
+		if (oldest->reads && (!stream->reads ||
+				time_before(stream->stamp, oldest->stamp))) {
+			oldest = stream;
+		}
+	}
+
+	*found = false;
+	return oldest;
+}
+
+void cas_read_ahead_access(struct cas_read_ahead *ra, ocf_part_id_t io_class,
+		sector_t sector, uint32_t sectors)
+{
+	struct cas_read_ahead_stream *stream;
+	struct cas_read_ahead_window *window;
+	sector_t end = sector + sectors;
+	uint64_t window_sectors;
+	unsigned long flags;
+	bool found, kick = false;
+	uint32_t lines;
+
+	if (io_class >= OCF_USER_IO_CLASS_MAX)
+		return;
+
+	lines = READ_ONCE(ra->lines[io_class]);
+	if (!lines)
+		return;
+
+	window_sectors = (uint64_t)lines * ra->line_sectors;
+
+	spin_lock_irqsave(&ra->lock, flags);
+
+	stream = _cas_read_ahead_find(ra, sector, &found);
+	stream->stamp = jiffies;
+	stream->next = end;
+	if (!found) {
+		stream->ahead = end;
+		stream->reads = 1;
+		goto unlock;
+	}
+
+	stream->reads++;
+	if (stream->ahead < end)
+		stream->ahead = end;
+
+	/* Window is refilled once less than half of it is left ahead */
+	if (ra->stopped || stream->reads < CAS_READ_AHEAD_TRIGGER ||
+			stream->ahead - end >= window_sectors / 2 ||
+			stream->ahead >= ra->core_sectors ||
+			ra->pending_count == CAS_READ_AHEAD_PENDING_MAX) {
+		goto unlock;
+	}
+
+	window = &ra->pending[ra->pending_count++];
+	window->sector = stream->ahead;
+	window->sectors = min_t(uint64_t, end + window_sectors,
+			ra->core_sectors) - stream->ahead;
+	window->io_class = io_class;
+	stream->ahead += window->sectors;
+	kick = true;
+
+unlock:
+	spin_unlock_irqrestore(&ra->lock, flags);
+
+	if (kick)
+		queue_work(system_wq, &ra->work);
+}
+
+void cas_read_ahead_set_lines(struct cas_read_ahead *ra, uint32_t io_class,
+		uint32_t lines)
+{
+	WRITE_ONCE(ra->lines[io_class], lines);
+}
+
+uint32_t cas_read_ahead_get_lines(struct cas_read_ahead *ra,
+		uint32_t io_class)
+{
+	return READ_ONCE(ra->lines[io_class]);
+}
@@ -0,0 +1,33 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __READ_AHEAD_H__
+#define __READ_AHEAD_H__
+
+struct cas_read_ahead;
+
+/*
+ * Read-ahead of ascending read streams of core. Reads of exported object
+ * continuing one of few tracked streams extend the stream, and once stream
+ * is long enough next cache lines of it are read into cache in background
+ * on porter queues, keeping given window ahead of the stream.
+ */
+struct cas_read_ahead *cas_read_ahead_create(ocf_core_t core);
+
+/* Wait for reads in flight, called once exported object is destroyed */
+void cas_read_ahead_destroy(struct cas_read_ahead *ra);
+
+/* Account read of exported object, may be called in atomic context */
+void cas_read_ahead_access(struct cas_read_ahead *ra, ocf_part_id_t io_class,
+		sector_t sector, uint32_t sectors);
+
+/* Window of streams of io class in cache lines, 0 disables read-ahead */
+void cas_read_ahead_set_lines(struct cas_read_ahead *ra, uint32_t io_class,
+		uint32_t lines);
+
+uint32_t cas_read_ahead_get_lines(struct cas_read_ahead *ra,
+		uint32_t io_class);
+
+#endif /* __READ_AHEAD_H__ */
@@ -0,0 +1,83 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "cas_cache.h"
+
+/* Sequential streams tracked per core */
+#define CAS_SEQ_CUTOFF_STREAMS 16
+
+struct cas_seq_cutoff_stream {
+	/* Sector following last request of stream */
+	sector_t next;
+	/* Length of stream so far, 0 for unused stream */
+	uint64_t sectors;
+	ocf_part_id_t io_class;
+	int dir;
+	/* Jiffies of last request, least recently used stream is replaced */
+	unsigned long stamp;
+};
+
+struct cas_seq_cutoff {
+	spinlock_t lock;
+	struct cas_seq_cutoff_stream streams[CAS_SEQ_CUTOFF_STREAMS];
+};
+
+struct cas_seq_cutoff *cas_seq_cutoff_create(void)
+{
+	struct cas_seq_cutoff *sc;
+
+	sc = kzalloc(sizeof(*sc), GFP_KERNEL);
+	if (!sc)
+		return NULL;
+
+	spin_lock_init(&sc->lock);
+
+	return sc;
+}
+
+void cas_seq_cutoff_destroy(struct cas_seq_cutoff *sc)
+{
+	kfree(sc);
+}
+
+bool cas_seq_cutoff_check(struct cas_seq_cutoff *sc, ocf_part_id_t io_class,
+		int dir, sector_t sector, uint32_t sectors, uint64_t threshold)
+{
+	struct cas_seq_cutoff_stream *stream, *oldest = &sc->streams[0];
+	unsigned long flags;
+	bool cutoff;
+	int i;
+
+	spin_lock_irqsave(&sc->lock, flags);
+
+	for (i = 0; i < CAS_SEQ_CUTOFF_STREAMS; i++) {
+		stream = &sc->streams[i];
+		if (stream->sectors && stream->next == sector &&
+				stream->io_class == io_class &&
+				stream->dir == dir) {
+			stream->sectors += sectors;
+			goto found;
+		}
+		/* Unused stream is taken before any of used ones */
+		if (oldest->sectors && (!stream->sectors ||
+				time_before(stream->stamp, oldest->stamp))) {
+			oldest = stream;
+		}
+	}
+
+	stream = oldest;
+	stream->sectors = sectors;
+	stream->io_class = io_class;
+	stream->dir = dir;
+
+found:
+	stream->next = sector + sectors;
+	stream->stamp = jiffies;
+	cutoff = stream->sectors >= threshold;
+
+	spin_unlock_irqrestore(&sc->lock, flags);
+
+	return cutoff;
+}
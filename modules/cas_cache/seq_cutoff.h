@@ -0,0 +1,30 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __SEQ_CUTOFF_H__
+#define __SEQ_CUTOFF_H__
+
+struct cas_seq_cutoff;
+
+/*
+ * Sequential streams of core tracked for IO classes with sequential cutoff
+ * threshold overridden in IO class configuration. Requests of stream which
+ * exceeded threshold of its IO class are moved to KCAS_IO_CLASS_BYPASS,
+ * which is handled in pass-through. Sequential cutoff of core configured in
+ * OCF applies on top of that to all IO classes.
+ */
+struct cas_seq_cutoff *cas_seq_cutoff_create(void);
+
+void cas_seq_cutoff_destroy(struct cas_seq_cutoff *sc);
+
+/*
+ * Account request of exported object in stream of its IO class and direction,
+ * returns true if stream exceeded @threshold [sectors]. May be called in
+ * atomic context.
+ */
+bool cas_seq_cutoff_check(struct cas_seq_cutoff *sc, ocf_part_id_t io_class,
+		int dir, sector_t sector, uint32_t sectors, uint64_t threshold);
+
+#endif /* __SEQ_CUTOFF_H__ */
@@ -53,6 +53,7 @@ long cas_service_ioctl_ctrl(struct file *filp, unsigned int cmd,
 		struct kcas_start_cache *cmd_info;
 		struct ocf_mngt_cache_config cfg;
 		struct ocf_mngt_cache_attach_config attach_cfg;
+		bool assign_id;
 		void *data;
 
 		GET_CMD_INFO(cmd_info, arg);
@@ -63,11 +64,20 @@ long cas_service_ioctl_ctrl(struct file *filp, unsigned int cmd,
 			}
 		}
 
+		/* Id picked for the cache is reserved as long as it starts */
+		assign_id = cmd_info->cache_id == OCF_CACHE_ID_INVALID &&
+				cmd_info->init_cache == CACHE_INIT_NEW;
+
 		retval = cache_mngt_create_cache_cfg(&cfg, &attach_cfg, cmd_info);
-		if (retval)
+		if (retval) {
+			if (assign_id)
+				cache_mngt_release_cache_id(cmd_info->cache_id);
 			RETURN_CMD_RESULT(cmd_info, arg, retval);
+		}
 
 		retval = cache_mngt_init_instance(&cfg, &attach_cfg, cmd_info);
+		if (assign_id)
+			cache_mngt_release_cache_id(cmd_info->cache_id);
 
 		for (i = 0; i < OCF_CORE_MAX; i ++) {
 			if (cmd_info->fs_meta_dict[i].length && cmd_info->fs_meta_dict[i].data) {
@@ -175,6 +185,59 @@ long cas_service_ioctl_ctrl(struct file *filp, unsigned int cmd,
 		RETURN_CMD_RESULT(cmd_info, arg, retval);
 	}
 
+	case KCAS_IOCTL_INSERT_CORES: {
+		struct kcas_insert_cores *cmd_info;
+
+		GET_CMD_INFO(cmd_info, arg);
+
+		retval = cache_mngt_add_cores_to_cache(cmd_info);
+
+		RETURN_CMD_RESULT(cmd_info, arg, retval);
+	}
+
+	case KCAS_IOCTL_UPDATE_FS_META: {
+		struct kcas_update_fs_meta *cmd_info;
+		void *data = NULL;
+
+		uint32_t length;
+
+		GET_CMD_INFO(cmd_info, arg);
+		length = cmd_info->fs_meta_dict.length;
+		if (length > KCAS_UPDATE_FS_META_MAX_LENGTH)
+			RETURN_CMD_RESULT(cmd_info, arg, -EINVAL);
+
+		if (length && cmd_info->fs_meta_dict.data) {
+			data = vmalloc(length);
+			if (!data)
+				RETURN_CMD_RESULT(cmd_info, arg, -ENOMEM);
+
+			if (copy_from_user(data, (void __user *)
+					cmd_info->fs_meta_dict.data, length)) {
+				vfree(data);
+				RETURN_CMD_RESULT(cmd_info, arg, -EFAULT);
+			}
+			cmd_info->fs_meta_dict.data = data;
+		} else {
+			cmd_info->fs_meta_dict.length = 0;
+		}
+
+		retval = cache_mngt_update_fs_meta(cmd_info);
+
+		if (data)
+			vfree(data);
+		RETURN_CMD_RESULT(cmd_info, arg, retval);
+	}
+
+	case KCAS_IOCTL_LOAD_PROGRESS: {
+		struct kcas_load_progress *cmd_info;
+
+		GET_CMD_INFO(cmd_info, arg);
+
+		retval = cache_mngt_get_load_progress(cmd_info);
+
+		RETURN_CMD_RESULT(cmd_info, arg, retval);
+	}
+
 	case KCAS_IOCTL_REMOVE_CORE: {
 		struct kcas_remove_core *cmd_info;
 
@@ -224,7 +287,8 @@ long cas_service_ioctl_ctrl(struct file *filp, unsigned int cmd,
 
 		cache_name_from_id(cache_name, cmd_info->cache_id);
 
-		retval = cache_mngt_purge_device(cache_name, OCF_CACHE_NAME_SIZE);
+		retval = cache_mngt_purge_device(cache_name, OCF_CACHE_NAME_SIZE,
+				cmd_info->background);
 
 		RETURN_CMD_RESULT(cmd_info, arg, retval);
 	}
@@ -237,7 +301,8 @@ long cas_service_ioctl_ctrl(struct file *filp, unsigned int cmd,
 
 		cache_name_from_id(cache_name, cmd_info->cache_id);
 
-		retval = cache_mngt_flush_device(cache_name, OCF_CACHE_NAME_SIZE);
+		retval = cache_mngt_flush_device(cache_name, OCF_CACHE_NAME_SIZE,
+				cmd_info->rate_limit);
 
 		RETURN_CMD_RESULT(cmd_info, arg, retval);
 	}
@@ -268,7 +333,8 @@ long cas_service_ioctl_ctrl(struct file *filp, unsigned int cmd,
 		core_name_from_id(core_name, cmd_info->core_id);
 
 		retval = cache_mngt_purge_object(cache_name, OCF_CACHE_NAME_SIZE,
-						core_name, OCF_CORE_NAME_SIZE);
+						core_name, OCF_CORE_NAME_SIZE,
+						cmd_info->background);
 
 		RETURN_CMD_RESULT(cmd_info, arg, retval);
 	}
@@ -285,7 +351,8 @@ long cas_service_ioctl_ctrl(struct file *filp, unsigned int cmd,
 		core_name_from_id(core_name, cmd_info->core_id);
 
 		retval = cache_mngt_flush_object(cache_name, OCF_CACHE_NAME_SIZE,
-						core_name, OCF_CORE_NAME_SIZE);
+						core_name, OCF_CORE_NAME_SIZE,
+						cmd_info->rate_limit);
 
 		RETURN_CMD_RESULT(cmd_info, arg, retval);
 	}
@@ -295,7 +362,9 @@ long cas_service_ioctl_ctrl(struct file *filp, unsigned int cmd,
 
 		GET_CMD_INFO(cmd_info, arg);
 
-		retval = cache_mngt_dump_inflight(cmd_info->cache_id);
+		retval = cmd_info->entries ?
+			cache_mngt_get_inflight(cmd_info) :
+			cache_mngt_dump_inflight(cmd_info->cache_id);
 
 		RETURN_CMD_RESULT(cmd_info, arg, retval);
 	}
@@ -310,6 +379,126 @@ long cas_service_ioctl_ctrl(struct file *filp, unsigned int cmd,
 		RETURN_CMD_RESULT(cmd_info, arg, retval);
 	}
 
+	case KCAS_IOCTL_GET_STATS_BULK: {
+		struct kcas_get_stats_bulk *cmd_info;
+
+		GET_CMD_INFO(cmd_info, arg);
+
+		retval = cache_mngt_get_stats_bulk(cmd_info);
+
+		RETURN_CMD_RESULT(cmd_info, arg, retval);
+	}
+
+	case KCAS_IOCTL_GET_LAT_HIST: {
+		struct kcas_get_lat_hist *cmd_info;
+
+		GET_CMD_INFO(cmd_info, arg);
+
+		retval = cache_mngt_get_lat_hist(cmd_info);
+
+		RETURN_CMD_RESULT(cmd_info, arg, retval);
+	}
+
+	case KCAS_IOCTL_GET_QUEUE_STATS: {
+		struct kcas_get_queue_stats *cmd_info;
+
+		GET_CMD_INFO(cmd_info, arg);
+
+		retval = cache_mngt_get_queue_stats(cmd_info);
+
+		RETURN_CMD_RESULT(cmd_info, arg, retval);
+	}
+
+	case KCAS_IOCTL_GET_MEM_FOOTPRINT: {
+		struct kcas_get_mem_footprint *cmd_info;
+
+		GET_CMD_INFO(cmd_info, arg);
+
+		retval = cache_mngt_get_mem_footprint(cmd_info);
+
+		RETURN_CMD_RESULT(cmd_info, arg, retval);
+	}
+
+	case KCAS_IOCTL_GET_HEATMAP: {
+		struct kcas_get_heatmap *cmd_info;
+
+		GET_CMD_INFO(cmd_info, arg);
+
+		retval = cache_mngt_get_heatmap(cmd_info);
+
+		RETURN_CMD_RESULT(cmd_info, arg, retval);
+	}
+
+	case KCAS_IOCTL_GET_MRC: {
+		struct kcas_get_mrc *cmd_info;
+
+		GET_CMD_INFO(cmd_info, arg);
+
+		retval = cache_mngt_get_mrc(cmd_info);
+
+		RETURN_CMD_RESULT(cmd_info, arg, retval);
+	}
+
+	case KCAS_IOCTL_ASYNC_OP: {
+		struct kcas_async_op *cmd_info;
+
+		GET_CMD_INFO(cmd_info, arg);
+
+		retval = cache_mngt_async_op_start(cmd_info);
+
+		RETURN_CMD_RESULT(cmd_info, arg, retval);
+	}
+
+	case KCAS_IOCTL_ASYNC_STATUS: {
+		struct kcas_async_status *cmd_info;
+
+		GET_CMD_INFO(cmd_info, arg);
+
+		retval = cache_mngt_async_op_status(cmd_info);
+
+		RETURN_CMD_RESULT(cmd_info, arg, retval);
+	}
+
+	case KCAS_IOCTL_GET_HOT_SET: {
+		struct kcas_get_hot_set *cmd_info;
+
+		GET_CMD_INFO(cmd_info, arg);
+
+		retval = cache_mngt_get_hot_set(cmd_info);
+
+		RETURN_CMD_RESULT(cmd_info, arg, retval);
+	}
+
+	case KCAS_IOCTL_GET_TRACE: {
+		struct kcas_get_trace *cmd_info;
+
+		GET_CMD_INFO(cmd_info, arg);
+
+		retval = cache_mngt_get_trace(cmd_info);
+
+		RETURN_CMD_RESULT(cmd_info, arg, retval);
+	}
+
+	case KCAS_IOCTL_PREFETCH: {
+		struct kcas_prefetch *cmd_info;
+
+		GET_CMD_INFO(cmd_info, arg);
+
+		retval = cache_mngt_prefetch(cmd_info);
+
+		RETURN_CMD_RESULT(cmd_info, arg, retval);
+	}
+
+	case KCAS_IOCTL_BENCH: {
+		struct kcas_bench *cmd_info;
+
+		GET_CMD_INFO(cmd_info, arg);
+
+		retval = cache_mngt_bench(cmd_info);
+
+		RETURN_CMD_RESULT(cmd_info, arg, retval);
+	}
+
 	case KCAS_IOCTL_CACHE_INFO: {
 		struct kcas_cache_info *cmd_info;
 
@@ -341,6 +530,36 @@ long cas_service_ioctl_ctrl(struct file *filp, unsigned int cmd,
 
 	}
 
+	case KCAS_IOCTL_IO_CLASS_STATS: {
+		struct kcas_io_class_stats *cmd_info;
+
+		GET_CMD_INFO(cmd_info, arg);
+
+		retval = cache_mngt_get_io_class_stats(cmd_info);
+
+		RETURN_CMD_RESULT(cmd_info, arg, retval);
+	}
+
+	case KCAS_IOCTL_IO_CLASS_BENCH: {
+		struct kcas_io_class_bench *cmd_info;
+
+		GET_CMD_INFO(cmd_info, arg);
+
+		retval = cache_mngt_io_class_bench(cmd_info);
+
+		RETURN_CMD_RESULT(cmd_info, arg, retval);
+	}
+
+	case KCAS_IOCTL_ALLOC_BENCH: {
+		struct kcas_alloc_bench *cmd_info;
+
+		GET_CMD_INFO(cmd_info, arg);
+
+		retval = cas_alloc_bench_run(cmd_info);
+
+		RETURN_CMD_RESULT(cmd_info, arg, retval);
+	}
+
 	case KCAS_IOCTL_PARTITION_SET: {
 		struct kcas_io_classes *cmd_info;
 		char cache_name[OCF_CACHE_NAME_SIZE];
@@ -6,24 +6,153 @@
 
 #include "threads.h"
 #include "cas_cache.h"
+#include "cas_trace.h"
 
 #define MAX_THREAD_NAME_SIZE 48
 
+/* Queue thread states published to cas_kick_queue_thread() */
+#define CAS_THREAD_SLEEPING 0
+#define CAS_THREAD_RUNNING 1
+
 struct cas_thread_info {
 	char name[MAX_THREAD_NAME_SIZE];
 	void *sync_data;
 	atomic_t stop;
 	atomic_t kicked;
+	atomic_t state;
 	struct completion compl;
 	struct completion sync_compl;
 	wait_queue_head_t wq;
 	struct task_struct *thread;
+
+	/* Max time queue thread busy polls for new work, 0 - never polls */
+	atomic_t poll_us;
+	/* Moving average of idle time between queue runs */
+	u64 idle_ns;
+	/* Number of times new work was found while polling */
+	atomic64_t polled;
+	/* Number of times thread went to sleep waiting for work */
+	atomic64_t slept;
+	/* Number of times porter queue was picked by balancer */
+	atomic64_t selected;
+
+	/* Time of first kick not yet followed by queue run, 0 - none */
+	atomic64_t kick_ns;
+	/*
+	 * Queue metrics, updated only by context running the queue and read
+	 * without synchronization, see cas_get_queue_thread_stats()
+	 */
+	u64 runs;
+	u64 processed;
+	u32 max_batch;
+	u32 max_pending;
+	u64 dwells;
+	u64 dwell_ns;
+	u64 dwell_max_ns;
+	u64 busy_ns;
+	u64 idle_total_ns;
+	u64 last_run_end;
+
+	/* Queue is run from shared workqueue until promoted to own thread */
+	bool lazy;
+	/* Lazy queue is being stopped, it is no longer promoted */
+	bool draining;
+	struct work_struct work;
+	ocf_queue_t queue;
+	int cpu;
+	enum cas_thread_type type;
+	cpumask_var_t affinity;
+	bool affinity_set;
+	/* Load seen by lazy queue in current observation window */
+	unsigned long window_start;
+	uint32_t window_runs;
+	u64 window_busy_ns;
+	uint32_t busy_windows;
 };
 
+extern u32 queue_exec_mode;
+extern u32 queue_lazy_promote_rate;
+
+/* Shared per-CPU workqueue running lazy queues, NULL if not in use */
+static struct workqueue_struct *cas_queue_wq;
+
+/* Lazy queue load is checked every window, promoted after few busy ones */
+#define CAS_QUEUE_LAZY_WINDOW (HZ / 10)
+#define CAS_QUEUE_LAZY_BUSY_WINDOWS 3
+
+/*
+ * Spin on the queue for a while, expecting new work soon. Polling time is
+ * derived from recent arrival rate - if idle periods are longer than poll
+ * limit, thread goes to sleep right away not to burn CPU for nothing.
+ */
+static bool queue_thread_poll(ocf_queue_t q, struct cas_thread_info *info)
+{
+	u64 limit_ns = (u64)atomic_read(&info->poll_us) * NSEC_PER_USEC;
+	u64 start, now, budget;
+
+	if (!limit_ns || info->idle_ns > limit_ns)
+		return false;
+
+	/* Wait twice the average idle time to catch most arrivals */
+	budget = min(2 * info->idle_ns + NSEC_PER_USEC, limit_ns);
+	start = now = ktime_get_ns();
+
+	while (now - start < budget) {
+		if (ocf_queue_pending_io(q) || atomic_read(&info->stop))
+			return true;
+		if (need_resched())
+			break;
+		cpu_relax();
+		now = ktime_get_ns();
+	}
+
+	return false;
+}
+
+/*
+ * Run the queue and account its metrics. Batch size is approximated with
+ * change of pending requests count, so requests pushed while the queue is
+ * running make it look smaller.
+ */
+static u64 _cas_queue_run(ocf_queue_t q, struct cas_thread_info *info)
+{
+	u64 kick_ns = atomic64_xchg(&info->kick_ns, 0);
+	u32 before, after, batch;
+	u64 start, end, dwell;
+
+	start = ktime_get_ns();
+	if (kick_ns && start > kick_ns) {
+		dwell = start - kick_ns;
+		info->dwells++;
+		info->dwell_ns += dwell;
+		info->dwell_max_ns = max(info->dwell_max_ns, dwell);
+	}
+	if (info->last_run_end && start > info->last_run_end)
+		info->idle_total_ns += start - info->last_run_end;
+
+	before = ocf_queue_pending_io(q);
+	info->max_pending = max(info->max_pending, before);
+
+	ocf_queue_run(q);
+
+	after = ocf_queue_pending_io(q);
+	end = ktime_get_ns();
+
+	batch = before > after ? before - after : 0;
+	info->runs++;
+	info->processed += batch;
+	info->max_batch = max(info->max_batch, batch);
+	info->busy_ns += end - start;
+	info->last_run_end = end;
+
+	return end - start;
+}
+
 static int queue_thread_run(void *data)
 {
 	ocf_queue_t q = data;
 	struct cas_thread_info *info;
+	u64 idle_start;
 
 	BUG_ON(!q);
 
@@ -37,13 +166,37 @@ static int queue_thread_run(void *data)
 
 	/* Continue working until signaled to exit. */
 	do {
-		/* Wait until there are completed read misses from the HDDs,
-		 * or a stop.
-		 */
-		wait_event_interruptible(info->wq, ocf_queue_pending_io(q) ||
-				atomic_read(&info->stop));
+		idle_start = ktime_get_ns();
+
+		if (queue_thread_poll(q, info)) {
+			atomic64_inc(&info->polled);
+		} else {
+			/* Pairs with barrier in cas_kick_queue_thread() - either
+			 * we see new request here or kicker sees us sleeping.
+			 */
+			atomic_set(&info->state, CAS_THREAD_SLEEPING);
+			smp_mb__after_atomic();
+
+			if (!ocf_queue_pending_io(q)) {
+				atomic64_inc(&info->slept);
+				/* Wait until there are completed read misses
+				 * from the HDDs, or a stop.
+				 */
+				wait_event_interruptible(info->wq,
+						ocf_queue_pending_io(q) ||
+						atomic_read(&info->stop));
+			}
+
+			atomic_set(&info->state, CAS_THREAD_RUNNING);
+		}
+
+		/* Only track arrival rate if anyone is interested in it */
+		if (atomic_read(&info->poll_us)) {
+			info->idle_ns = (info->idle_ns * 7 +
+					(ktime_get_ns() - idle_start)) / 8;
+		}
 
-		ocf_queue_run(q);
+		_cas_queue_run(q, info);
 
 	} while (!atomic_read(&info->stop) || ocf_queue_pending_io(q));
 
@@ -57,23 +210,34 @@ static int queue_thread_run(void *data)
 	return 0;
 }
 
-ocf_queue_t cache_get_fastest_porter_queue(ocf_cache_t cache)
+extern u32 porter_select;
+
+/* Porter queues sampled before picking the least loaded one on a node */
+#define CAS_PORTER_NODE_TRIES 4
+
+static inline ocf_queue_t _cas_porter_queue_of(struct cache_priv *cache_priv,
+		uint32_t cpu)
+{
+	/* Every CPU maps to valid queue owner, see _cache_mngt_start_queues() */
+	return cache_priv->queues[cache_priv->queues[cpu].queue_idx].porter_queue;
+}
+
+/* Check pending I/O of each queue, O(CPUs) per selection */
+static ocf_queue_t _cas_porter_select_scan(struct cache_priv *cache_priv)
 {
-	uint32_t cpus_no = num_online_cpus();
-	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
 	ocf_queue_t queue;
 	ocf_queue_t min_queue;
 	uint32_t min_io, cmp_io;
 	int i;
 
-	ENV_BUG_ON(!cpus_no);
-	ENV_BUG_ON(!cache_priv);
-
-	queue = cache_priv->queues[0].porter_queue;
-	min_io = ocf_queue_pending_io(queue);
-	min_queue = queue;
+	/* Queue of first online CPU serves at least that CPU */
+	min_queue = _cas_porter_queue_of(cache_priv,
+			cpumask_first(cpu_online_mask));
+	min_io = ocf_queue_pending_io(min_queue);
 
-	for (i = 1; min_io && (i < cpus_no); i++) {
+	for (i = 0; min_io && (i < nr_cpu_ids); i++) {
+		if (!cache_priv_owns_queue(cache_priv, i))
+			continue;
 		queue = cache_priv->queues[i].porter_queue;
 		cmp_io = ocf_queue_pending_io(queue);
 		if (cmp_io < min_io) {
@@ -84,21 +248,210 @@ ocf_queue_t cache_get_fastest_porter_queue(ocf_cache_t cache)
 	return min_queue;
 }
 
+/* Sample two pseudo-random queues and pick less loaded one */
+static ocf_queue_t _cas_porter_select_two_choices(struct cache_priv *cache_priv)
+{
+	uint32_t seq = atomic_inc_return(&cache_priv->porter_cursor);
+	ocf_queue_t a, b;
+
+	a = _cas_porter_queue_of(cache_priv, hash_32(seq, 32) % nr_cpu_ids);
+	b = _cas_porter_queue_of(cache_priv, hash_32(~seq, 32) % nr_cpu_ids);
+
+	return ocf_queue_pending_io(b) < ocf_queue_pending_io(a) ? b : a;
+}
+
+/*
+ * Go round-robin over CPUs of cache device NUMA node, taking first idle
+ * queue or the least loaded one of few sampled.
+ */
+static ocf_queue_t _cas_porter_select_node(struct cache_priv *cache_priv)
+{
+	int node = cache_priv->home_node;
+	const struct cpumask *mask;
+	ocf_queue_t queue, min_queue = NULL;
+	uint32_t min_io = UINT_MAX, cmp_io;
+	uint32_t seq;
+	int i, cpu;
+
+	if (node == NUMA_NO_NODE)
+		node = numa_node_id();
+	mask = cpumask_of_node(node);
+
+	seq = atomic_add_return(CAS_PORTER_NODE_TRIES,
+			&cache_priv->porter_cursor);
+	cpu = cpumask_next((int)(seq % nr_cpu_ids) - 1, mask);
+
+	for (i = 0; i < CAS_PORTER_NODE_TRIES; i++) {
+		if (cpu >= nr_cpu_ids)
+			cpu = cpumask_first(mask);
+		if (cpu >= nr_cpu_ids)
+			break;
+		queue = _cas_porter_queue_of(cache_priv, cpu);
+		cmp_io = ocf_queue_pending_io(queue);
+		if (cmp_io < min_io) {
+			min_io = cmp_io;
+			min_queue = queue;
+		}
+		if (!min_io)
+			break;
+		cpu = cpumask_next(cpu, mask);
+	}
+
+	/* Node without CPUs */
+	return min_queue ?: _cas_porter_select_two_choices(cache_priv);
+}
+
+static ocf_queue_t (*const _cas_porter_select[CAS_PORTER_SELECT_MAX])(
+		struct cache_priv *cache_priv) = {
+	[CAS_PORTER_SELECT_SCAN] = _cas_porter_select_scan,
+	[CAS_PORTER_SELECT_TWO_CHOICES] = _cas_porter_select_two_choices,
+	[CAS_PORTER_SELECT_NODE] = _cas_porter_select_node,
+};
+
+ocf_queue_t cache_get_fastest_porter_queue(ocf_cache_t cache)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	struct cas_thread_info *info;
+	ocf_queue_t queue;
+
+	ENV_BUG_ON(!cache_priv);
+
+	queue = _cas_porter_select[porter_select](cache_priv);
+
+	info = ocf_queue_get_priv(queue);
+	if (info)
+		atomic64_inc(&info->selected);
+
+	return queue;
+}
+
 void cache_print_each_porter_queue_pending_io(ocf_cache_t cache)
 {
-	uint32_t cpus_no = num_online_cpus();
 	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
 	ocf_queue_t queue;
+	struct cas_thread_info *info;
 	uint32_t io;
 	int i;
 
 	ENV_BUG_ON(!cache_priv);
 
-	for (i = 0; i < cpus_no; i++) {
+	for (i = 0; i < nr_cpu_ids; i++) {
+		if (!cache_priv_owns_queue(cache_priv, i))
+			continue;
 		queue = cache_priv->queues[i].porter_queue;
 		io = ocf_queue_pending_io(queue);
 		printk(KERN_WARNING "Still pending %d IO requests at index %d in cache %s\n", io, i, ocf_cache_get_name(cache));
+		info = ocf_queue_get_priv(queue);
+		if (info) {
+			printk(KERN_DEBUG "Porter queue at index %d in cache %s "
+					"selected %llu times\n", i,
+					ocf_cache_get_name(cache),
+					(unsigned long long)atomic64_read(&info->selected));
+		}
+	}
+}
+
+extern u32 cleaner_dirty_watermark;
+
+/* Shortest adapted cleaning interval, keeps no-progress passes from spinning */
+#define CAS_CLEANER_MIN_INTERVAL_MS 1
+
+static int _cas_cleaner_core_busy(ocf_core_t core, void *cntx)
+{
+	bool *busy = cntx;
+
+	*busy = block_dev_get_inflight(ocf_core_get_volume(core),
+			CAS_BD_IO_FOREGROUND) > 0;
+
+	return *busy;
+}
+
+/*
+ * Shrink cleaning interval proportionally to dirty ratio as it approaches
+ * the watermark, but only while no foreground I/O is in flight to core
+ * devices. Above the watermark cleaning runs as often as possible on idle
+ * cores and four times more often than policy asks for on busy ones.
+ */
+static uint32_t _cas_cleaner_adapt_interval(ocf_cache_t cache, uint32_t ms)
+{
+	struct ocf_cache_info cache_info;
+	uint32_t dirty_pct;
+	bool busy = false;
+
+	if (!cleaner_dirty_watermark || ms == OCF_CLEANER_DISABLE || !ms)
+		return ms;
+
+	/* Management operation in progress, not a good time to hurry */
+	if (ocf_mngt_cache_read_trylock(cache))
+		return ms;
+
+	if (ocf_cache_get_info(cache, &cache_info) || !cache_info.size) {
+		ocf_mngt_cache_read_unlock(cache);
+		return ms;
+	}
+	ocf_core_visit(cache, _cas_cleaner_core_busy, &busy, true);
+
+	ocf_mngt_cache_read_unlock(cache);
+
+	dirty_pct = div_u64((uint64_t)cache_info.dirty * 100, cache_info.size);
+
+	if (dirty_pct >= cleaner_dirty_watermark)
+		ms = busy ? ms / 4 : 0;
+	else if (!busy)
+		ms = div_u64((uint64_t)ms * (cleaner_dirty_watermark - dirty_pct),
+				cleaner_dirty_watermark);
+
+	return max_t(uint32_t, ms, CAS_CLEANER_MIN_INTERVAL_MS);
+}
+
+/* Share of rewrites among writes [%] below which cleaning is not deferred */
+#define CAS_CLEANER_REWRITE_MIN 25
+
+/* Longest deferral of cleaning in intervals given by cleaning policy */
+#define CAS_CLEANER_REWRITE_DEFER_MAX 4
+
+/*
+ * Stretch cleaning interval while most writes rewrite recently written
+ * lines, as cleaning lines which are about to be rewritten is wasted. The
+ * interval grows with share of rewrites, but only below rewrite_defer dirty
+ * ratio, so that dirty data doesn't pile up.
+ */
+static uint32_t _cas_cleaner_defer_interval(ocf_cache_t cache, uint32_t ms)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	uint32_t threshold = READ_ONCE(cache_priv->cleaner.rewrite_defer);
+	uint64_t writes = 0, rewrites = 0;
+	struct ocf_cache_info cache_info;
+	struct cas_rewrite *rw;
+	uint32_t share;
+	int result;
+
+	/* Sampled each pass, so that share is the one of last interval */
+	rcu_read_lock();
+	rw = rcu_dereference(cache_priv->cleaner.rewrite);
+	if (rw)
+		cas_rewrite_sample(rw, &writes, &rewrites);
+	rcu_read_unlock();
+
+	if (!threshold || !writes || ms == OCF_CLEANER_DISABLE || !ms)
+		return ms;
+
+	share = div64_u64(rewrites * 100, writes);
+	if (share < CAS_CLEANER_REWRITE_MIN)
+		return ms;
+
+	if (ocf_mngt_cache_read_trylock(cache))
+		return ms;
+	result = ocf_cache_get_info(cache, &cache_info);
+	ocf_mngt_cache_read_unlock(cache);
+
+	if (result || !cache_info.size || div_u64((uint64_t)cache_info.dirty *
+				100, cache_info.size) >= threshold) {
+		return ms;
 	}
+
+	return ms + div_u64((uint64_t)ms * CAS_CLEANER_REWRITE_DEFER_MAX *
+			share, 100);
 }
 
 static void _cas_cleaner_complete(ocf_cleaner_t c, uint32_t interval)
@@ -110,12 +463,87 @@ static void _cas_cleaner_complete(ocf_cleaner_t c, uint32_t interval)
 	complete(&info->sync_compl);
 }
 
+/*
+ * Run cleaning pass on next dedicated cleaner queue, or the least loaded
+ * porter queue when cleaner has single worker. Cleaner takes reference of
+ * the queue before returning, so the queue may be released after unlock.
+ */
+static void _cas_cleaner_run(ocf_cleaner_t c, struct cache_priv *cache_priv)
+{
+	ocf_cache_t cache = ocf_cleaner_get_cache(c);
+	ocf_queue_t queue;
+
+	mutex_lock(&cache_priv->cleaner.lock);
+
+	if (cache_priv->cleaner.workers > 1) {
+		queue = cache_priv->cleaner.queues[cache_priv->cleaner.next];
+		cache_priv->cleaner.next = (cache_priv->cleaner.next + 1) %
+				cache_priv->cleaner.workers;
+	} else {
+		queue = cache_get_fastest_porter_queue(cache);
+	}
+
+	ocf_cleaner_run(c, queue);
+
+	mutex_unlock(&cache_priv->cleaner.lock);
+}
+
+/* Dirty lines count, false if it can't be read right now */
+static bool _cas_cleaner_get_dirty(ocf_cache_t cache, uint64_t *dirty)
+{
+	struct ocf_cache_info cache_info;
+	bool result;
+
+	if (ocf_mngt_cache_read_trylock(cache))
+		return false;
+
+	result = !ocf_cache_get_info(cache, &cache_info);
+	if (result)
+		*dirty = cache_info.dirty;
+
+	ocf_mngt_cache_read_unlock(cache);
+
+	return result;
+}
+
+/*
+ * Account cleaning pass. Cleaned lines are dirty lines count drop over
+ * the pass, so writes coming in meanwhile make it look smaller. Rate is
+ * moving average over pass and sleep preceding it.
+ */
+static void _cas_cleaner_account(struct cache_priv *cache_priv,
+		bool dirty_valid, uint64_t dirty_before, uint64_t dirty_after,
+		uint64_t pass_ns, uint64_t sleep_ns)
+{
+	uint64_t cleaned = 0, rate;
+
+	if (dirty_valid && dirty_before > dirty_after)
+		cleaned = dirty_before - dirty_after;
+
+	WRITE_ONCE(cache_priv->cleaner.passes, cache_priv->cleaner.passes + 1);
+	WRITE_ONCE(cache_priv->cleaner.lines_cleaned,
+			cache_priv->cleaner.lines_cleaned + cleaned);
+	WRITE_ONCE(cache_priv->cleaner.pass_ns,
+			cache_priv->cleaner.pass_ns + pass_ns);
+
+	if (!dirty_valid)
+		return;
+
+	rate = div64_u64(cleaned * NSEC_PER_SEC, max_t(uint64_t,
+			pass_ns + sleep_ns, 1));
+	WRITE_ONCE(cache_priv->cleaner.rate,
+			(cache_priv->cleaner.rate * 7 + rate) / 8);
+}
+
 static int cleaner_thread_run(void *data)
 {
 	ocf_cleaner_t c = data;
 	ocf_cache_t cache = ocf_cleaner_get_cache(c);
 	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
 	struct cas_thread_info *info;
+	uint64_t dirty_before, dirty_after;
+	uint64_t start, end, sleep_ns = 0;
+	bool dirty_valid;
 	uint32_t ms;
 
 	BUG_ON(!c);
@@ -138,13 +566,27 @@ static int cleaner_thread_run(void *data)
 
 		atomic_set(&info->kicked, 0);
 		init_completion(&info->sync_compl);
-		ocf_cleaner_run(c, cache_get_fastest_porter_queue(cache));
+		dirty_valid = _cas_cleaner_get_dirty(cache, &dirty_before);
+		start = ktime_get_ns();
+		trace_cas_cleaner_pass_start(ocf_cache_get_id(cache));
+		_cas_cleaner_run(c, cache_priv);
 		wait_for_completion(&info->sync_compl);
+		trace_cas_cleaner_pass_end(ocf_cache_get_id(cache), ms);
+		end = ktime_get_ns();
+
+		if (dirty_valid)
+			dirty_valid = _cas_cleaner_get_dirty(cache, &dirty_after);
+		_cas_cleaner_account(cache_priv, dirty_valid, dirty_before,
+				dirty_after, end - start, sleep_ns);
+
+		ms = _cas_cleaner_adapt_interval(cache, ms);
+		ms = _cas_cleaner_defer_interval(cache, ms);
 
 		/*
 		 * In case of nop cleaning policy we don't want to perform cleaning
 		 * until cleaner_kick() is called.
 		 */
+		start = ktime_get_ns();
 		if (ms == OCF_CLEANER_DISABLE) {
 			wait_event_interruptible(info->wq, atomic_read(&info->kicked) ||
 					atomic_read(&info->stop));
@@ -153,6 +595,9 @@ static int cleaner_thread_run(void *data)
 					atomic_read(&info->kicked) || atomic_read(&info->stop),
 					msecs_to_jiffies(ms));
 		}
+		sleep_ns = ktime_get_ns() - start;
+		WRITE_ONCE(cache_priv->cleaner.sleep_ns,
+				cache_priv->cleaner.sleep_ns + sleep_ns);
 	} while (true);
 
 	cache_print_each_porter_queue_pending_io(cache);
@@ -162,8 +607,34 @@ static int cleaner_thread_run(void *data)
 	return 0;
 }
 
+extern u32 thread_sched_policy[CAS_THREAD_TYPE_MAX];
+extern int thread_nice[CAS_THREAD_TYPE_MAX];
+
+static const int cas_thread_sched_policy[CAS_THREAD_SCHED_MAX] = {
+	[CAS_THREAD_SCHED_NORMAL] = SCHED_NORMAL,
+	[CAS_THREAD_SCHED_FIFO] = SCHED_FIFO,
+	[CAS_THREAD_SCHED_IDLE] = SCHED_IDLE,
+};
+
+static void _cas_set_thread_sched(struct task_struct *thread,
+		enum cas_thread_type type)
+{
+	int policy = cas_thread_sched_policy[thread_sched_policy[type]];
+	int result;
+
+	if (policy == SCHED_NORMAL && !thread_nice[type])
+		return;
+
+	result = cas_sched_set(thread, policy, thread_nice[type]);
+	if (result) {
+		printk(KERN_WARNING OCF_PREFIX_SHORT "Cannot set scheduling "
+				"policy of thread %s: %d\n", thread->comm, result);
+	}
+}
+
 static int _cas_create_thread(struct cas_thread_info **pinfo,
-		int (*threadfn)(void *), void *priv, const char *name, int cpu)
+		int (*threadfn)(void *), void *priv, const char *name, int cpu,
+		enum cas_thread_type type)
 {
 	struct cas_thread_info *info;
 	struct task_struct *thread;
@@ -190,6 +661,8 @@ static int _cas_create_thread(struct cas_thread_info **pinfo,
 	if (cpu != CAS_CPUS_ALL)
 		kthread_bind(thread, cpu);
 
+	_cas_set_thread_sched(thread, type);
+
 	if (pinfo)
 		*pinfo = info;
 
@@ -217,12 +690,123 @@ static void _cas_stop_thread(struct cas_thread_info *info)
 	kfree(info);
 }
 
-int cas_create_queue_thread(ocf_queue_t q, const char *name, int cpu)
+static void _cas_lazy_queue_promote(ocf_queue_t q,
+		struct cas_thread_info *info)
+{
+	struct task_struct *thread;
+
+	thread = kthread_create(queue_thread_run, q, "%s", info->name);
+	if (IS_ERR(thread)) {
+		/* Keep running from workqueue, retry after next busy windows */
+		info->busy_windows = 0;
+		return;
+	}
+
+	if (info->affinity_set)
+		set_cpus_allowed_ptr(thread, info->affinity);
+	else if (info->cpu != CAS_CPUS_ALL)
+		kthread_bind(thread, info->cpu);
+
+	_cas_set_thread_sched(thread, info->type);
+	info->thread = thread;
+
+	/* Kicks go to thread from now on, pairs with cas_kick_queue_thread() */
+	smp_store_release(&info->lazy, false);
+
+	_cas_start_thread(info);
+}
+
+static void _cas_lazy_queue_work(struct work_struct *work)
+{
+	struct cas_thread_info *info =
+			container_of(work, struct cas_thread_info, work);
+	uint32_t promote_runs;
+	unsigned long now;
+
+	/* Kicked just before promotion, let the thread pick it up */
+	if (!smp_load_acquire(&info->lazy)) {
+		wake_up(&info->wq);
+		return;
+	}
+
+	info->window_busy_ns += _cas_queue_run(info->queue, info);
+	info->window_runs++;
+
+	now = jiffies;
+	if (time_before(now, info->window_start + CAS_QUEUE_LAZY_WINDOW))
+		return;
+
+	/*
+	 * Window is busy if queue got kicked often enough or was running for
+	 * most of it. Window ending long after it should is an idle one.
+	 */
+	promote_runs = max_t(uint32_t, 1, queue_lazy_promote_rate *
+			CAS_QUEUE_LAZY_WINDOW / HZ);
+	if (time_before(now, info->window_start + 2 * CAS_QUEUE_LAZY_WINDOW) &&
+			(info->window_runs >= promote_runs ||
+			info->window_busy_ns >= jiffies_to_nsecs(
+					CAS_QUEUE_LAZY_WINDOW) / 2)) {
+		info->busy_windows++;
+	} else {
+		info->busy_windows = 0;
+	}
+
+	info->window_start = now;
+	info->window_runs = 0;
+	info->window_busy_ns = 0;
+
+	if (info->busy_windows >= CAS_QUEUE_LAZY_BUSY_WINDOWS &&
+			!READ_ONCE(info->draining)) {
+		_cas_lazy_queue_promote(info->queue, info);
+	}
+}
+
+static int _cas_create_lazy_queue(ocf_queue_t q, const char *name, int cpu,
+		enum cas_thread_type type)
+{
+	struct cas_thread_info *info;
+
+	info = kzalloc(sizeof(*info), GFP_KERNEL);
+	if (!info)
+		return -ENOMEM;
+
+	if (!zalloc_cpumask_var(&info->affinity, GFP_KERNEL)) {
+		kfree(info);
+		return -ENOMEM;
+	}
+
+	atomic_set(&info->stop, 0);
+	init_completion(&info->compl);
+	init_completion(&info->sync_compl);
+	init_waitqueue_head(&info->wq);
+	snprintf(info->name, sizeof(info->name), "%s", name);
+
+	info->lazy = true;
+	INIT_WORK(&info->work, _cas_lazy_queue_work);
+	info->queue = q;
+	info->cpu = cpu;
+	info->type = type;
+	info->window_start = jiffies;
+
+	ocf_queue_set_priv(q, info);
+
+	return 0;
+}
+
+int cas_create_queue_thread(ocf_queue_t q, const char *name, int cpu,
+		enum cas_thread_type type)
 {
 	struct cas_thread_info *info;
 	int result;
 
-	result = _cas_create_thread(&info, queue_thread_run, q, name, cpu);
+	/* Only I/O queues are numerous enough to be worth it */
+	if (cas_queue_wq && (type == CAS_THREAD_IO ||
+			type == CAS_THREAD_PORTER)) {
+		return _cas_create_lazy_queue(q, name, cpu, type);
+	}
+
+	result = _cas_create_thread(&info, queue_thread_run, q, name, cpu,
+			type);
 	if (!result) {
 		ocf_queue_set_priv(q, info);
 		_cas_start_thread(info);
@@ -234,23 +818,156 @@ int cas_create_queue_thread(ocf_queue_t q, const char *name, int cpu)
 void cas_kick_queue_thread(ocf_queue_t q)
 {
 	struct cas_thread_info *info = ocf_queue_get_priv(q);
+
+	/* Queue already stopped, nothing left to run it */
+	if (unlikely(!info))
+		return;
+
+	/* Start of dwell time, only first kick after queue run counts */
+	if (!atomic64_read(&info->kick_ns))
+		atomic64_cmpxchg(&info->kick_ns, 0, ktime_get_ns());
+
+	if (smp_load_acquire(&info->lazy)) {
+		queue_work(cas_queue_wq, &info->work);
+		return;
+	}
+
+	/* Running or polling thread will pick up the request anyway, so skip
+	 * wait queue lock and wakeup. Pairs with barrier in queue_thread_run().
+	 */
+	smp_mb();
+	if (atomic_read(&info->state) == CAS_THREAD_RUNNING)
+		return;
+
 	wake_up(&info->wq);
 }
 
 
+void cas_set_queue_thread_affinity(ocf_queue_t q, const struct cpumask *mask)
+{
+	struct cas_thread_info *info = ocf_queue_get_priv(q);
+
+	/* Lazy queue thread gets it when created */
+	if (info->queue) {
+		cpumask_copy(info->affinity, mask);
+		info->affinity_set = true;
+	}
+
+	if (info->thread)
+		set_cpus_allowed_ptr(info->thread, mask);
+}
+
+void cas_set_queue_thread_poll(ocf_queue_t q, uint32_t poll_us)
+{
+	struct cas_thread_info *info = ocf_queue_get_priv(q);
+
+	if (!info)
+		return;
+
+	info->idle_ns = 0;
+	atomic_set(&info->poll_us, poll_us);
+}
+
+void cas_get_queue_thread_poll_stats(ocf_queue_t q, uint64_t *polled,
+		uint64_t *slept)
+{
+	struct cas_thread_info *info = ocf_queue_get_priv(q);
+
+	if (!info)
+		return;
+
+	*polled += atomic64_read(&info->polled);
+	*slept += atomic64_read(&info->slept);
+}
+
+void cas_get_queue_thread_stats(ocf_queue_t q,
+		struct kcas_queue_stats_entry *stats)
+{
+	struct cas_thread_info *info = ocf_queue_get_priv(q);
+
+	stats->pending = ocf_queue_pending_io(q);
+
+	if (!info)
+		return;
+
+	stats->max_pending = READ_ONCE(info->max_pending);
+	stats->runs = READ_ONCE(info->runs);
+	stats->processed = READ_ONCE(info->processed);
+	stats->max_batch = READ_ONCE(info->max_batch);
+	stats->dwells = READ_ONCE(info->dwells);
+	stats->dwell_ns = READ_ONCE(info->dwell_ns);
+	stats->dwell_max_ns = READ_ONCE(info->dwell_max_ns);
+	stats->busy_ns = READ_ONCE(info->busy_ns);
+	stats->idle_ns = READ_ONCE(info->idle_total_ns);
+	stats->selected = atomic64_read(&info->selected);
+}
+
+/*
+ * Lazy queue is drained by its work, the same way the thread drains its
+ * queue before exiting, as completions still kick it. Work item never runs
+ * concurrently with itself, so the queue is never run from two contexts.
+ */
+static void _cas_lazy_queue_drain(ocf_queue_t q, struct cas_thread_info *info)
+{
+	/* Seen by every run of the work started after flush below */
+	WRITE_ONCE(info->draining, true);
+
+	/* Work which had promoted queue already is done with it */
+	flush_work(&info->work);
+	if (!info->lazy)
+		return;
+
+	while (ocf_queue_pending_io(q)) {
+		queue_work(cas_queue_wq, &info->work);
+		flush_work(&info->work);
+		cond_resched();
+	}
+}
+
 void cas_stop_queue_thread(ocf_queue_t q)
 {
 	struct cas_thread_info *info = ocf_queue_get_priv(q);
+
+	if (info->queue)
+		_cas_lazy_queue_drain(q, info);
+
+	/* Block new kicks, then wait for work queued by the last ones */
 	ocf_queue_set_priv(q, NULL);
+	if (info->queue) {
+		flush_work(&info->work);
+		free_cpumask_var(info->affinity);
+	}
+
 	_cas_stop_thread(info);
 }
 
+int cas_init_lazy_queues(void)
+{
+	if (queue_exec_mode != CAS_QUEUE_EXEC_LAZY)
+		return 0;
+
+	cas_queue_wq = alloc_workqueue("cas_queue",
+			WQ_HIGHPRI | WQ_MEM_RECLAIM, 0);
+	if (!cas_queue_wq)
+		return -ENOMEM;
+
+	return 0;
+}
+
+void cas_deinit_lazy_queues(void)
+{
+	if (cas_queue_wq)
+		destroy_workqueue(cas_queue_wq);
+	cas_queue_wq = NULL;
+}
+
 int cas_create_cleaner_thread(ocf_cleaner_t c, const char *name)
 {
 	struct cas_thread_info *info;
 	int result;
 
-	result = _cas_create_thread(&info, cleaner_thread_run, c, name, CAS_CPUS_ALL);
+	result = _cas_create_thread(&info, cleaner_thread_run, c, name,
+			CAS_CPUS_ALL, CAS_THREAD_CLEANER);
 	if (!result) {
 		ocf_cleaner_set_priv(c, info);
 		_cas_start_thread(info);
@@ -262,6 +979,10 @@ int cas_create_cleaner_thread(ocf_cleaner_t c, const char *name)
 void cas_kick_cleaner_thread(ocf_cleaner_t c)
 {
 	struct cas_thread_info *info = ocf_cleaner_get_priv(c);
+	struct cache_priv *cache_priv =
+			ocf_cache_get_priv(ocf_cleaner_get_cache(c));
+
+	atomic64_inc(&cache_priv->cleaner.kicks);
 	atomic_set(&info->kicked, 1);
 	wake_up(&info->wq);
 }
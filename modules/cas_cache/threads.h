@@ -13,9 +13,52 @@
 
 #define CAS_CPUS_ALL -1
 
-int cas_create_queue_thread(ocf_queue_t q, const char *name, int cpu);
+struct kcas_queue_stats_entry;
+
+/* Types of CAS threads, each with own scheduling settings */
+enum cas_thread_type {
+	CAS_THREAD_IO,
+	CAS_THREAD_PORTER,
+	CAS_THREAD_MNGT,
+	CAS_THREAD_CLEANER,
+	CAS_THREAD_IDLE_IO,
+
+	CAS_THREAD_TYPE_MAX
+};
+
+/* Scheduling policies of CAS threads, see thread_sched_policy parameter */
+enum {
+	CAS_THREAD_SCHED_NORMAL,
+	CAS_THREAD_SCHED_FIFO,
+	CAS_THREAD_SCHED_IDLE,
+
+	CAS_THREAD_SCHED_MAX
+};
+
+/* Execution modes of cache I/O queues, see queue_exec_mode parameter */
+enum {
+	CAS_QUEUE_EXEC_THREAD,
+	CAS_QUEUE_EXEC_LAZY,
+
+	CAS_QUEUE_EXEC_MAX
+};
+
+int cas_init_lazy_queues(void);
+void cas_deinit_lazy_queues(void);
+
+int cas_create_queue_thread(ocf_queue_t q, const char *name, int cpu,
+		enum cas_thread_type type);
 void cas_kick_queue_thread(ocf_queue_t q);
 void cas_stop_queue_thread(ocf_queue_t q);
+void cas_set_queue_thread_affinity(ocf_queue_t q, const struct cpumask *mask);
+void cas_set_queue_thread_poll(ocf_queue_t q, uint32_t poll_us);
+void cas_get_queue_thread_poll_stats(ocf_queue_t q, uint64_t *polled,
+		uint64_t *slept);
+void cas_get_queue_thread_stats(ocf_queue_t q,
+		struct kcas_queue_stats_entry *stats);
+
+/* Pick porter queue for background I/O, see porter_select parameter */
+ocf_queue_t cache_get_fastest_porter_queue(ocf_cache_t cache);
 
 int cas_create_cleaner_thread(ocf_cleaner_t c, const char *name);
 void cas_kick_cleaner_thread(ocf_cleaner_t c);
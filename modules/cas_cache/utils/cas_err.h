@@ -78,6 +78,10 @@ static struct cas_error_map_entry cas_error_map[] = {
 	{ KCAS_ERR_WAITING_INTERRUPTED,		EINTR	},
 	{ KCAS_ERR_CORE_IN_ACTIVE_STATE,	ENODEV	},
 	{ KCAS_ERR_INACTIVE_CORE_IS_DIRTY,	ENODEV	},
+	{ KCAS_ERR_ASYNC_OP_NOT_EXIST,		ENOENT	},
+	{ KCAS_ERR_ASYNC_OPS_LIMIT,		EBUSY	},
+	{ KCAS_ERR_IO_CLASS_RESERVED,		EINVAL	},
+	{ KCAS_ERR_COMPRESSED_LOAD,		ENOTSUP	},
 };
 
 /*******************************************/
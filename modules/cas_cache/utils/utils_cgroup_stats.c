@@ -0,0 +1,198 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "../cas_cache.h"
+#include "utils_cgroup_stats.h"
+
+struct cas_cgroup_counters {
+	uint64_t read_hits;
+	uint64_t read_misses;
+	uint64_t writes;
+	uint64_t read_bytes;
+	uint64_t write_bytes;
+};
+
+struct cas_cgroup_stats_entry {
+	struct rhash_head node;
+	uint64_t cgroup_id;
+	struct cas_cgroup_counters __percpu *counters;
+	struct list_head list;
+};
+
+static const struct rhashtable_params cas_cgroup_stats_params = {
+	.key_len = sizeof(uint64_t),
+	.key_offset = offsetof(struct cas_cgroup_stats_entry, cgroup_id),
+	.head_offset = offsetof(struct cas_cgroup_stats_entry, node),
+};
+
+struct cas_cgroup_stats {
+	struct rhashtable index;
+
+	spinlock_t lock;
+		/*< Serializes adding of entries */
+
+	struct list_head entries;
+	uint32_t count;
+
+	struct cas_cgroup_stats_entry other;
+		/*< Cgroups over KCAS_CGROUP_STATS_MAX or not added for lack of
+		 *  memory */
+};
+
+struct cas_cgroup_stats *cas_cgroup_stats_create(void)
+{
+	struct cas_cgroup_stats *cs;
+
+	cs = kzalloc(sizeof(*cs), GFP_KERNEL);
+	if (!cs)
+		return NULL;
+
+	cs->other.counters = alloc_percpu(struct cas_cgroup_counters);
+	if (!cs->other.counters)
+		goto free;
+
+	if (rhashtable_init(&cs->index, &cas_cgroup_stats_params))
+		goto free_counters;
+
+	spin_lock_init(&cs->lock);
+	INIT_LIST_HEAD(&cs->entries);
+	cs->other.cgroup_id = KCAS_CGROUP_ID_OTHER;
+
+	return cs;
+
+free_counters:
+	free_percpu(cs->other.counters);
+free:
+	kfree(cs);
+	return NULL;
+}
+
+void cas_cgroup_stats_destroy(struct cas_cgroup_stats *cs)
+{
+	struct cas_cgroup_stats_entry *e, *tmp;
+
+	rhashtable_destroy(&cs->index);
+	list_for_each_entry_safe(e, tmp, &cs->entries, list) {
+		free_percpu(e->counters);
+		kfree(e);
+	}
+	free_percpu(cs->other.counters);
+	kfree(cs);
+}
+
+static struct cas_cgroup_stats_entry *_cas_cgroup_stats_add(
+		struct cas_cgroup_stats *cs, uint64_t cgroup_id)
+{
+	struct cas_cgroup_stats_entry *e, *old;
+	unsigned long flags;
+
+	if (READ_ONCE(cs->count) >= KCAS_CGROUP_STATS_MAX)
+		return &cs->other;
+
+	e = kzalloc(sizeof(*e), GFP_ATOMIC | __GFP_NOWARN);
+	if (!e)
+		return &cs->other;
+
+	e->counters = alloc_percpu_gfp(struct cas_cgroup_counters,
+			GFP_ATOMIC | __GFP_NOWARN);
+	if (!e->counters) {
+		kfree(e);
+		return &cs->other;
+	}
+	e->cgroup_id = cgroup_id;
+
+	spin_lock_irqsave(&cs->lock, flags);
+	old = cs->count < KCAS_CGROUP_STATS_MAX ?
+			rhashtable_lookup_get_insert_fast(&cs->index, &e->node,
+				cas_cgroup_stats_params) :
+			ERR_PTR(-ENOSPC);
+	if (!old) {
+		list_add_tail_rcu(&e->list, &cs->entries);
+		WRITE_ONCE(cs->count, cs->count + 1);
+	}
+	spin_unlock_irqrestore(&cs->lock, flags);
+
+	if (!old)
+		return e;
+
+	/* Added meanwhile by other CPU or table full */
+	free_percpu(e->counters);
+	kfree(e);
+	return IS_ERR(old) ? &cs->other : old;
+}
+
+struct cas_cgroup_stats_entry *cas_cgroup_stats_get(
+		struct cas_cgroup_stats *cs, uint64_t cgroup_id)
+{
+	struct cas_cgroup_stats_entry *e;
+
+	e = rhashtable_lookup_fast(&cs->index, &cgroup_id,
+			cas_cgroup_stats_params);
+	if (likely(e))
+		return e;
+
+	return _cas_cgroup_stats_add(cs, cgroup_id);
+}
+
+void cas_cgroup_stats_account(struct cas_cgroup_stats_entry *e, int dir,
+		uint32_t bytes, bool miss)
+{
+	if (dir == WRITE) {
+		this_cpu_inc(e->counters->writes);
+		this_cpu_add(e->counters->write_bytes, bytes);
+		return;
+	}
+
+	if (miss)
+		this_cpu_inc(e->counters->read_misses);
+	else
+		this_cpu_inc(e->counters->read_hits);
+	this_cpu_add(e->counters->read_bytes, bytes);
+}
+
+static void _cas_cgroup_stats_sum(struct cas_cgroup_stats_entry *e,
+		struct kcas_cgroup_stats *out)
+{
+	struct cas_cgroup_counters *c;
+	int cpu;
+
+	memset(out, 0, sizeof(*out));
+	out->cgroup_id = e->cgroup_id;
+	for_each_possible_cpu(cpu) {
+		c = per_cpu_ptr(e->counters, cpu);
+		out->read_hits += c->read_hits;
+		out->read_misses += c->read_misses;
+		out->writes += c->writes;
+		out->read_bytes += c->read_bytes;
+		out->write_bytes += c->write_bytes;
+	}
+}
+
+void cas_cgroup_stats_read(struct cas_cgroup_stats *cs,
+		struct kcas_cgroup_stats *entries, uint32_t *count)
+{
+	struct cas_cgroup_stats_entry *e;
+	struct kcas_cgroup_stats other;
+	uint32_t i = 0;
+
+	/* Entries are only added, list is walked without taking the lock */
+	rcu_read_lock();
+	list_for_each_entry_rcu(e, &cs->entries, list) {
+		if (i < *count)
+			_cas_cgroup_stats_sum(e, &entries[i]);
+		i++;
+	}
+	rcu_read_unlock();
+
+	/* Untracked cgroups are reported only once there are some */
+	_cas_cgroup_stats_sum(&cs->other, &other);
+	if (other.read_hits || other.read_misses || other.writes) {
+		if (i < *count)
+			entries[i] = other;
+		i++;
+	}
+
+	*count = i;
+}
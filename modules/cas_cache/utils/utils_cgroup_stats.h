@@ -0,0 +1,34 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __CAS_CGROUP_STATS_H__
+#define __CAS_CGROUP_STATS_H__
+
+struct cas_cgroup_stats;
+struct cas_cgroup_stats_entry;
+
+struct cas_cgroup_stats *cas_cgroup_stats_create(void);
+
+void cas_cgroup_stats_destroy(struct cas_cgroup_stats *cs);
+
+/*
+ * Get entry of @cgroup_id, adding it if not tracked yet. Entries stay valid
+ * until statistics are destroyed. May be called in atomic context.
+ */
+struct cas_cgroup_stats_entry *cas_cgroup_stats_get(
+		struct cas_cgroup_stats *cs, uint64_t cgroup_id);
+
+/* Account completed request of @bytes, @miss if read was served from core */
+void cas_cgroup_stats_account(struct cas_cgroup_stats_entry *e, int dir,
+		uint32_t bytes, bool miss);
+
+/*
+ * Fill up to @count entries, @count is updated with number of entries
+ * available (may be greater than buffer size)
+ */
+void cas_cgroup_stats_read(struct cas_cgroup_stats *cs,
+		struct kcas_cgroup_stats *entries, uint32_t *count);
+
+#endif /* __CAS_CGROUP_STATS_H__ */
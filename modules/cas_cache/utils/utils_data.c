@@ -8,60 +8,78 @@
 #include "utils_data.h"
 
 /**
- * This function locates index of IO vec from given vecs array where byte at
- * offset is located. When found it returns its index and byte offset within
- * this vec.
- * @param vecs IO vector array to be searched
- * @param vec_num number of items in IO vector array
+ * This function locates index of IO vec from given cursor where byte at
+ * offset is located, starting from vec cursor points to. When found it moves
+ * cursor there and returns byte offset within this vec.
+ * @param cursor position in IO vector array to be searched from
  * @param offset byte offset to be found
  * @param offset_in_vec byte offset within found IO vec
- * @return vec index if it lies within specified buffer, otherwise -1
+ * @return 0 if it lies within specified buffer, otherwise -1
  */
-static int get_starting_vec(struct bio_vec *vecs, uint64_t vecs_num,
+static int cas_data_cursor_seek(struct cas_data_cursor *cursor,
 		uint64_t offset, uint64_t *offset_in_vec)
 {
-	int i;
+	uint64_t i = cursor->idx, start = cursor->start;
 
-	for (i = 0; i < vecs_num; i++) {
-		if (vecs[i].bv_len > offset) {
-			if (offset_in_vec != NULL)
-				*offset_in_vec = offset;
-			return i;
+	if (offset < start) {
+		i = 0;
+		start = 0;
+	}
+
+	for (; i < cursor->vec_num; i++) {
+		if (start + cursor->vec[i].bv_len > offset) {
+			cursor->idx = i;
+			cursor->start = start;
+			*offset_in_vec = offset - start;
+			return 0;
 		}
-		offset -= vecs[i].bv_len;
+		start += cursor->vec[i].bv_len;
 	}
 
 	return -1;
 }
 
-uint64_t cas_data_cpy(struct bio_vec *dst, uint64_t dst_num,
-		struct bio_vec *src, uint64_t src_num,
-		uint64_t to, uint64_t from, uint64_t bytes)
+static inline void cas_data_cpy_chunk(void *dst, const void *src,
+		uint64_t bytes, bool nt)
 {
+#ifdef CONFIG_ARCH_HAS_UACCESS_FLUSHCACHE
+	if (nt) {
+		memcpy_flushcache(dst, src, bytes);
+		return;
+	}
+#endif
+	memcpy(dst, src, bytes);
+}
+
+uint64_t cas_data_cursor_cpy(struct cas_data_cursor *dst_cur,
+		struct cas_data_cursor *src_cur, uint64_t to, uint64_t from,
+		uint64_t bytes, bool nt)
+{
+	struct bio_vec *dst = dst_cur->vec, *src = src_cur->vec;
+	uint64_t dst_num = dst_cur->vec_num, src_num = src_cur->vec_num;
 	uint64_t i, j, dst_len, src_len, to_copy;
 	uint64_t dst_off, src_off;
 	uint64_t written = 0;
-	int ret;
 	void *dst_p, *src_p;
 	struct bio_vec *curr_dst, *curr_src;
 
+	nt = nt && bytes >= CAS_DATA_CPY_NT_THRESHOLD;
+
 	/* Locate vec idx and offset in dst vec array */
-	ret = get_starting_vec(dst, dst_num, to, &to);
-	if (ret < 0) {
+	if (cas_data_cursor_seek(dst_cur, to, &to)) {
 		CAS_PRINT_RL(KERN_INFO "llu dst buffer too small "
 				"to_offset=%llu bytes=%llu", to, bytes);
 		return 0;
 	}
-	j = ret;
+	j = dst_cur->idx;
 
 	/* Locate vec idx and offset in src vec array */
-	ret = get_starting_vec(src, src_num, from, &from);
-	if (ret < 0) {
+	if (cas_data_cursor_seek(src_cur, from, &from)) {
 		CAS_PRINT_RL(KERN_INFO "llu src buffer too small "
 				"from_offset=%llu bytes=%llu", from, bytes);
 		return 0;
 	}
-	i = ret;
+	i = src_cur->idx;
 
 	curr_dst = &dst[j];
 	curr_src = &src[i];
@@ -82,7 +100,7 @@ uint64_t cas_data_cpy(struct bio_vec *dst, uint64_t dst_num,
 		if ((written + to_copy) > bytes)
 			to_copy = bytes - written;
 
-		memcpy(dst_p, src_p, to_copy);
+		cas_data_cpy_chunk(dst_p, src_p, to_copy, nt);
 		written += to_copy;
 
 		if (written == bytes)
@@ -97,7 +115,8 @@ uint64_t cas_data_cpy(struct bio_vec *dst, uint64_t dst_num,
 
 		/* Go to next src buffer */
 		if (src_len == 0) {
-			i++;
+			src_cur->start += curr_src->bv_len;
+			src_cur->idx = ++i;
 
 			/* Setup new len and offset. */
 			if (i < src_num) {
@@ -111,7 +130,8 @@ uint64_t cas_data_cpy(struct bio_vec *dst, uint64_t dst_num,
 
 		/* Go to next dst buffer */
 		if (dst_len == 0) {
-			j++;
+			dst_cur->start += curr_dst->bv_len;
+			dst_cur->idx = ++j;
 
 			if (j < dst_num) {
 				curr_dst = &dst[j];
@@ -123,6 +143,10 @@ uint64_t cas_data_cpy(struct bio_vec *dst, uint64_t dst_num,
 		}
 	}
 
+	/* Non-temporal stores are weakly ordered against later submission */
+	if (nt)
+		wmb();
+
 	if (written != bytes) {
 		CAS_PRINT_RL(KERN_INFO "Written bytes not equal requested bytes "
 			"(written=%llu; requested=%llu)", written, bytes);
@@ -130,3 +154,15 @@ uint64_t cas_data_cpy(struct bio_vec *dst, uint64_t dst_num,
 
 	return written;
 }
+
+uint64_t cas_data_cpy(struct bio_vec *dst, uint64_t dst_num,
+		struct bio_vec *src, uint64_t src_num,
+		uint64_t to, uint64_t from, uint64_t bytes)
+{
+	struct cas_data_cursor dst_cur, src_cur;
+
+	cas_data_cursor_init(&dst_cur, dst, dst_num);
+	cas_data_cursor_init(&src_cur, src, src_num);
+
+	return cas_data_cursor_cpy(&dst_cur, &src_cur, to, from, bytes, false);
+}
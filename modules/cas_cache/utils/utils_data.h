@@ -6,6 +6,22 @@
 #ifndef UTILS_DATA_H_
 #define UTILS_DATA_H_
 
+/*
+ * Position in IO vector kept across copies, so that copies at increasing
+ * offsets don't scan vector from its beginning each time
+ */
+struct cas_data_cursor {
+	struct bio_vec *vec;
+	uint64_t vec_num;
+	uint64_t idx;
+		/*< Vec last copy ended in */
+	uint64_t start;
+		/*< Byte offset of vec @idx in IO vector */
+};
+
+/* Copies that large are done with non-temporal stores, if available */
+#define CAS_DATA_CPY_NT_THRESHOLD (256 * 1024)
+
 /**
  * @brief Copy data from a data vector to another one
  *
@@ -28,4 +44,26 @@ uint64_t cas_data_cpy(struct bio_vec *dst, uint64_t dst_num,
 		struct bio_vec *src, uint64_t src_num,
 		uint64_t to, uint64_t from, uint64_t bytes);
 
+static inline void cas_data_cursor_init(struct cas_data_cursor *cursor,
+		struct bio_vec *vec, uint64_t vec_num)
+{
+	cursor->vec = vec;
+	cursor->vec_num = vec_num;
+	cursor->idx = 0;
+	cursor->start = 0;
+}
+
+/**
+ * @brief Copy data like cas_data_cpy, locating offsets from cursor positions
+ *
+ * Cursors are left at vecs copy ended in. Offsets may go backwards, in which
+ * case cursor is rewound to the beginning of its vector.
+ *
+ * @param nt destination is not to be read by CPU soon, so that it may be
+ *	written with non-temporal stores bypassing CPU cache
+ */
+uint64_t cas_data_cursor_cpy(struct cas_data_cursor *dst,
+		struct cas_data_cursor *src, uint64_t to, uint64_t from,
+		uint64_t bytes, bool nt);
+
 #endif /* UTILS_DATA_H_ */
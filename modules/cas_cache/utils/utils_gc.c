@@ -7,10 +7,15 @@
 #include "utils_gc.h"
 #include <linux/vmalloc.h>
 
-#if defined (CAS_GARBAGE_COLLECTOR)
+extern u32 deferred_vfree;
+
+/* Frees done by single run of collector before it yields CPU */
+#define CAS_VFREE_BATCH 64
 
 struct cas_vfree_item {
 	struct llist_head list;
+	struct llist_node *pending;
+		/*< Frees taken from list but not done yet, collector only */
 	struct work_struct ws;
 };
 
@@ -18,19 +23,37 @@ static DEFINE_PER_CPU(struct cas_vfree_item, cas_vfree_item);
 
 static atomic_t freed = ATOMIC_INIT(0);
 
+/* Frees are deferred from init of collector until its deinit */
+static bool cas_vfree_deferred;
+
+/*
+ * vfree() only unmaps area and leaves TLB flush to lazy purge of vmap areas,
+ * which flushes many of them at once. Bounding the run keeps stop of cache
+ * with large metadata from monopolizing CPU the frees were queued on.
+ */
 static void cas_garbage_collector(struct work_struct *w)
 {
-        struct cas_vfree_item *item = container_of(w, struct cas_vfree_item,
+	struct cas_vfree_item *item = container_of(w, struct cas_vfree_item,
 			ws);
-	struct llist_node *llnode = llist_del_all(&item->list);
+	struct llist_node *llnode = item->pending;
+	int i;
+
+	if (!llnode)
+		llnode = llist_del_all(&item->list);
 
-	while (llnode) {
-		void *item = llnode;
+	for (i = 0; llnode && i < CAS_VFREE_BATCH; i++) {
+		void *addr = llnode;
 
 		llnode = llnode->next;
+		vfree(addr);
 		atomic_dec(&freed);
-		vfree(item);
 	}
+
+	item->pending = llnode;
+
+	/* Next batch runs once other work of this CPU had its chance */
+	if (llnode || !llist_empty(&item->list))
+		schedule_work(&item->ws);
 }
 
 void cas_vfree(const void *addr)
@@ -40,6 +63,11 @@ void cas_vfree(const void *addr)
 	if (!addr)
 		return;
 
+	if (!READ_ONCE(cas_vfree_deferred)) {
+		vfree(addr);
+		return;
+	}
+
 	atomic_inc(&freed);
 
 	if (llist_add((struct llist_node *)addr, &item->list))
@@ -55,29 +83,35 @@ void cas_garbage_collector_init(void)
 
 		item = &per_cpu(cas_vfree_item, i);
 		init_llist_head(&item->list);
+		item->pending = NULL;
 		INIT_WORK(&item->ws, cas_garbage_collector);
 	}
+
+	WRITE_ONCE(cas_vfree_deferred, !!deferred_vfree);
 }
 
 void cas_garbage_collector_deinit(void)
 {
 	int i;
 
+	/* Whatever is freed from now on is freed right away */
+	WRITE_ONCE(cas_vfree_deferred, false);
+
 	for_each_possible_cpu(i) {
 		struct cas_vfree_item *item;
 
 		item = &per_cpu(cas_vfree_item, i);
-		while (work_pending(&item->ws))
-			schedule();
+
+		/* Collector requeues itself until its backlog is done */
+		while (flush_work(&item->ws))
+			;
 	}
 
 	WARN(atomic_read(&freed) != 0,
 			OCF_PREFIX_SHORT" Not all memory deallocated\n");
 }
-#else
-void cas_garbage_collector_init(void) {};
-
-void cas_garbage_collector_deinit(void) {};
 
-void cas_vfree(const void *addr) { vfree(addr); };
-#endif
+uint32_t cas_garbage_collector_get_backlog(void)
+{
+	return atomic_read(&freed);
+}
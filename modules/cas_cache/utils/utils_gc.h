@@ -13,4 +13,7 @@ void cas_garbage_collector_deinit(void);
 
 void cas_vfree(const void *addr);
 
+/* Frees queued but not done yet */
+uint32_t cas_garbage_collector_get_backlog(void);
+
 #endif /* UTILS_GC_H_ */
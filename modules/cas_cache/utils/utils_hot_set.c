@@ -0,0 +1,158 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <linux/hash.h>
+#include <linux/log2.h>
+#include <linux/sort.h>
+#include "../cas_cache.h"
+#include "utils_hot_set.h"
+
+/*
+ * Space-Saving algorithm restricted to sets of CAS_HOT_SET_WAYS slots:
+ * access to region not tracked in its set replaces the least accessed one,
+ * inheriting its count plus one. Updates are not serialized, racing
+ * accesses may lose increments or track one region in two slots, which
+ * only makes counts approximate. Duplicates are merged on read.
+ */
+#define CAS_HOT_SET_WAYS 8
+#define CAS_HOT_SET_REGION_SHIFT ilog2(KCAS_HOT_SET_REGION_SECTORS)
+
+struct cas_hot_set_slot {
+	/* Region number plus one, 0 for empty slot */
+	uint64_t tag;
+	uint32_t count;
+};
+
+struct cas_hot_set {
+	uint32_t sets_shift;
+	struct cas_hot_set_slot slots[];
+};
+
+struct cas_hot_set *cas_hot_set_create(uint32_t regions)
+{
+	struct cas_hot_set *hs;
+	uint32_t sets;
+
+	regions = clamp_t(uint32_t, regions, 2 * CAS_HOT_SET_WAYS,
+			CAS_HOT_SET_REGIONS_MAX);
+	/* At least two sets, so that hash is never shifted by 64 */
+	sets = roundup_pow_of_two(regions) / CAS_HOT_SET_WAYS;
+
+	hs = vzalloc(struct_size(hs, slots, sets * CAS_HOT_SET_WAYS));
+	if (!hs)
+		return NULL;
+
+	hs->sets_shift = ilog2(sets);
+
+	return hs;
+}
+
+void cas_hot_set_destroy(struct cas_hot_set *hs)
+{
+	vfree(hs);
+}
+
+static void cas_hot_set_access_region(struct cas_hot_set *hs, uint64_t region)
+{
+	struct cas_hot_set_slot *set, *min = NULL;
+	uint64_t tag = region + 1;
+	uint32_t count, min_count = U32_MAX;
+	int i;
+
+	set = &hs->slots[hash_64(region, hs->sets_shift) * CAS_HOT_SET_WAYS];
+
+	for (i = 0; i < CAS_HOT_SET_WAYS; i++) {
+		count = READ_ONCE(set[i].count);
+		if (READ_ONCE(set[i].tag) == tag) {
+			if (count < U32_MAX)
+				WRITE_ONCE(set[i].count, count + 1);
+			return;
+		}
+		if (count < min_count || !min) {
+			min_count = count;
+			min = &set[i];
+		}
+	}
+
+	WRITE_ONCE(min->tag, tag);
+	if (min_count < U32_MAX)
+		WRITE_ONCE(min->count, min_count + 1);
+}
+
+void cas_hot_set_access(struct cas_hot_set *hs, sector_t sector,
+		uint32_t sectors)
+{
+	uint64_t region = sector >> CAS_HOT_SET_REGION_SHIFT;
+	uint64_t last = (sector + max(sectors, 1U) - 1) >>
+			CAS_HOT_SET_REGION_SHIFT;
+
+	for (; region <= last; region++)
+		cas_hot_set_access_region(hs, region);
+}
+
+static int cas_hot_set_tag_cmp(const void *a, const void *b)
+{
+	const struct cas_hot_set_slot *l = a, *r = b;
+
+	return (l->tag > r->tag) - (l->tag < r->tag);
+}
+
+static int cas_hot_set_count_cmp(const void *a, const void *b)
+{
+	const struct cas_hot_set_slot *l = a, *r = b;
+
+	return (l->count < r->count) - (l->count > r->count);
+}
+
+int cas_hot_set_get(struct cas_hot_set *hs, struct kcas_hot_region *regions,
+		uint32_t *count, bool decay)
+{
+	uint32_t slots_no = CAS_HOT_SET_WAYS << hs->sets_shift;
+	struct cas_hot_set_slot *slots;
+	uint32_t i, used = 0, merged = 0, hits;
+	uint64_t tag;
+
+	slots = vmalloc(slots_no * sizeof(*slots));
+	if (!slots)
+		return -ENOMEM;
+
+	for (i = 0; i < slots_no; i++) {
+		tag = READ_ONCE(hs->slots[i].tag);
+		hits = READ_ONCE(hs->slots[i].count);
+		if (!tag)
+			continue;
+
+		slots[used].tag = tag;
+		slots[used].count = hits;
+		used++;
+
+		if (decay)
+			WRITE_ONCE(hs->slots[i].count, hits / 2);
+	}
+
+	/* Merge region tracked twice after racing replacements */
+	sort(slots, used, sizeof(*slots), cas_hot_set_tag_cmp, NULL);
+	for (i = 0; i < used; i++) {
+		if (merged && slots[merged - 1].tag == slots[i].tag) {
+			slots[merged - 1].count = max(slots[merged - 1].count,
+					slots[i].count);
+			continue;
+		}
+		slots[merged++] = slots[i];
+	}
+
+	sort(slots, merged, sizeof(*slots), cas_hot_set_count_cmp, NULL);
+
+	*count = min(*count, merged);
+	for (i = 0; i < *count; i++) {
+		regions[i].sector = (slots[i].tag - 1) <<
+				CAS_HOT_SET_REGION_SHIFT;
+		regions[i].count = slots[i].count;
+	}
+
+	vfree(slots);
+
+	return 0;
+}
@@ -0,0 +1,34 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __CAS_HOT_SET_H__
+#define __CAS_HOT_SET_H__
+
+struct cas_hot_set;
+
+/* Limit of hot_set_regions module parameter */
+#define CAS_HOT_SET_REGIONS_MAX (1 << 20)
+
+/*
+ * Create tracker of @regions most accessed regions of
+ * KCAS_HOT_SET_REGION_SECTORS sectors, rounded up to power of two
+ */
+struct cas_hot_set *cas_hot_set_create(uint32_t regions);
+
+void cas_hot_set_destroy(struct cas_hot_set *hs);
+
+/* Account access to @sectors sectors starting at @sector */
+void cas_hot_set_access(struct cas_hot_set *hs, sector_t sector,
+		uint32_t sectors);
+
+/*
+ * Get up to @count hottest regions sorted by access count, @count is
+ * updated with number of regions returned. With @decay access counts are
+ * halved afterwards.
+ */
+int cas_hot_set_get(struct cas_hot_set *hs, struct kcas_hot_region *regions,
+		uint32_t *count, bool decay);
+
+#endif /* __CAS_HOT_SET_H__ */
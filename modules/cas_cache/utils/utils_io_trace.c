@@ -0,0 +1,169 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <linux/log2.h>
+#include "../cas_cache.h"
+#include "utils_io_trace.h"
+
+/*
+ * Each CPU writes to its own ring with interrupts disabled, so that
+ * recording takes neither locks nor shared cache lines. Reader copies
+ * records and then checks how far writer got meanwhile, dropping records
+ * which might have been overwritten during the copy.
+ */
+struct cas_io_trace_ring {
+	uint64_t head;
+		/*< Records written, advanced by owning CPU only */
+
+	uint64_t tail;
+		/*< Records taken, advanced by reader only */
+
+	struct kcas_trace_record *records;
+};
+
+struct cas_io_trace {
+	uint32_t mask;
+
+	struct mutex lock;
+		/*< Serializes readers */
+
+	int next_cpu;
+		/*< Ring taken from first by next reader, so that records of
+		 *  all CPUs are taken even if reader buffer is short */
+
+	struct cas_io_trace_ring __percpu *rings;
+};
+
+struct cas_io_trace *cas_io_trace_create(uint32_t records)
+{
+	struct cas_io_trace_ring *ring;
+	struct cas_io_trace *trace;
+	int cpu;
+
+	records = roundup_pow_of_two(clamp_t(uint32_t, records, 1,
+				CAS_IO_TRACE_RECORDS_MAX));
+
+	trace = kzalloc(sizeof(*trace), GFP_KERNEL);
+	if (!trace)
+		return NULL;
+
+	trace->mask = records - 1;
+	trace->next_cpu = -1;
+	mutex_init(&trace->lock);
+
+	trace->rings = alloc_percpu(struct cas_io_trace_ring);
+	if (!trace->rings)
+		goto err;
+
+	for_each_possible_cpu(cpu) {
+		ring = per_cpu_ptr(trace->rings, cpu);
+		ring->records = vmalloc_node(records * sizeof(*ring->records),
+				cpu_to_node(cpu));
+		if (!ring->records)
+			goto err;
+	}
+
+	return trace;
+
+err:
+	cas_io_trace_destroy(trace);
+	return NULL;
+}
+
+void cas_io_trace_destroy(struct cas_io_trace *trace)
+{
+	int cpu;
+
+	if (trace->rings) {
+		for_each_possible_cpu(cpu)
+			vfree(per_cpu_ptr(trace->rings, cpu)->records);
+		free_percpu(trace->rings);
+	}
+
+	kfree(trace);
+}
+
+void cas_io_trace_record(struct cas_io_trace *trace, sector_t sector,
+		uint32_t sectors, int dir, uint32_t io_class)
+{
+	struct cas_io_trace_ring *ring;
+	struct kcas_trace_record *rec;
+	unsigned long flags;
+
+	local_irq_save(flags);
+	ring = this_cpu_ptr(trace->rings);
+	rec = &ring->records[ring->head & trace->mask];
+
+	rec->time_ns = ktime_get_ns();
+	rec->sector = sector;
+	rec->sectors = sectors;
+	rec->dir = dir == WRITE;
+	rec->io_class = io_class;
+	rec->reserved = 0;
+
+	smp_store_release(&ring->head, ring->head + 1);
+	local_irq_restore(flags);
+}
+
+static uint32_t cas_io_trace_get_ring(struct cas_io_trace *trace,
+		struct cas_io_trace_ring *ring,
+		struct kcas_trace_record *records, uint32_t count,
+		uint64_t *lost)
+{
+	uint64_t size = trace->mask + 1;
+	uint64_t head, start, end, safe, pos;
+	uint32_t i, copied = 0;
+
+	head = smp_load_acquire(&ring->head);
+	start = max(ring->tail, head > size ? head - size : 0);
+	end = min(head, start + count);
+
+	*lost += start - ring->tail;
+
+	for (pos = start; pos < end; pos++)
+		records[copied++] = ring->records[pos & trace->mask];
+
+	/* Writer may be in the middle of overwriting slot of record head */
+	smp_rmb();
+	head = READ_ONCE(ring->head);
+	safe = head >= size ? head - size + 1 : 0;
+
+	if (safe > start) {
+		i = min(safe, end) - start;
+		memmove(records, records + i, (copied - i) * sizeof(*records));
+		copied -= i;
+		*lost += i;
+	}
+
+	ring->tail = end;
+
+	return copied;
+}
+
+void cas_io_trace_get(struct cas_io_trace *trace,
+		struct kcas_trace_record *records, uint32_t *count,
+		uint64_t *lost)
+{
+	uint32_t copied = 0, i;
+	int cpu;
+
+	*lost = 0;
+
+	mutex_lock(&trace->lock);
+	cpu = trace->next_cpu;
+	for (i = 0; i < num_possible_cpus() && copied < *count; i++) {
+		cpu = cpumask_next(cpu, cpu_possible_mask);
+		if (cpu >= nr_cpu_ids)
+			cpu = cpumask_first(cpu_possible_mask);
+
+		copied += cas_io_trace_get_ring(trace,
+				per_cpu_ptr(trace->rings, cpu),
+				records + copied, *count - copied, lost);
+	}
+	trace->next_cpu = cpu;
+	mutex_unlock(&trace->lock);
+
+	*count = copied;
+}
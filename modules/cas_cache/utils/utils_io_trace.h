@@ -0,0 +1,36 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __CAS_IO_TRACE_H__
+#define __CAS_IO_TRACE_H__
+
+struct cas_io_trace;
+
+/* Limit of io_trace_records module parameter */
+#define CAS_IO_TRACE_RECORDS_MAX (1 << 20)
+
+/*
+ * Create trace of requests of core kept in ring of @records records,
+ * rounded up to power of two, for each CPU. Once ring is full, oldest
+ * records not taken yet are overwritten.
+ */
+struct cas_io_trace *cas_io_trace_create(uint32_t records);
+
+void cas_io_trace_destroy(struct cas_io_trace *trace);
+
+/* Record request, may be called in atomic context */
+void cas_io_trace_record(struct cas_io_trace *trace, sector_t sector,
+		uint32_t sectors, int dir, uint32_t io_class);
+
+/*
+ * Take up to @count records not taken yet, @count is updated with number of
+ * records returned and @lost with number of records overwritten before
+ * being taken
+ */
+void cas_io_trace_get(struct cas_io_trace *trace,
+		struct kcas_trace_record *records, uint32_t *count,
+		uint64_t *lost);
+
+#endif /* __CAS_IO_TRACE_H__ */
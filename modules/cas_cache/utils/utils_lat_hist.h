@@ -0,0 +1,62 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __CAS_LAT_HIST_H__
+#define __CAS_LAT_HIST_H__
+
+/*
+ * Log-linear latency histogram, see KCAS_LAT_HIST_* for bucket layout.
+ * Histograms are kept per CPU and summed up only on readout, so recording
+ * is single non-atomic increment.
+ */
+
+static inline uint32_t cas_lat_hist_bucket(uint64_t ns)
+{
+	uint32_t msb, group;
+
+	if (ns < (1ULL << KCAS_LAT_HIST_MIN_SHIFT)) {
+		return ns >> (KCAS_LAT_HIST_MIN_SHIFT -
+				KCAS_LAT_HIST_SUB_BITS);
+	}
+
+	msb = fls64(ns) - 1;
+	group = msb - KCAS_LAT_HIST_MIN_SHIFT + 1;
+	if (group >= KCAS_LAT_HIST_GROUPS)
+		return KCAS_LAT_HIST_BUCKETS - 1;
+
+	return (group << KCAS_LAT_HIST_SUB_BITS) +
+		((ns >> (msb - KCAS_LAT_HIST_SUB_BITS)) &
+		 ((1 << KCAS_LAT_HIST_SUB_BITS) - 1));
+}
+
+static inline void cas_lat_hist_add(struct kcas_lat_hist __percpu *hist,
+		uint64_t ns)
+{
+	this_cpu_inc(hist->buckets[cas_lat_hist_bucket(ns)]);
+}
+
+static inline void cas_lat_hist_record(struct kcas_lat_hist __percpu *hist,
+		uint64_t start_ns)
+{
+	uint64_t now = ktime_get_ns();
+
+	cas_lat_hist_add(hist, now > start_ns ? now - start_ns : 0);
+}
+
+/* Add up all per CPU copies of histogram to given one */
+static inline void cas_lat_hist_sum(struct kcas_lat_hist __percpu *hist,
+		struct kcas_lat_hist *sum)
+{
+	struct kcas_lat_hist *cpu_hist;
+	int cpu, i;
+
+	for_each_possible_cpu(cpu) {
+		cpu_hist = per_cpu_ptr(hist, cpu);
+		for (i = 0; i < KCAS_LAT_HIST_BUCKETS; i++)
+			sum->buckets[i] += cpu_hist->buckets[i];
+	}
+}
+
+#endif /* __CAS_LAT_HIST_H__ */
@@ -6,6 +6,42 @@
 #include "utils_mpool.h"
 #include "ocf_env.h"
 
+/* Number of objects cached per CPU for each magazine order */
+#define ENV_MPOOL_MAG_SIZE 32
+
+/* Number of objects moved between magazine and allocator at once */
+#define ENV_MPOOL_MAG_BATCH (ENV_MPOOL_MAG_SIZE / 2)
+
+struct env_mpool_magazine {
+	void *objs[ENV_MPOOL_MAG_SIZE];
+		/*!< Recently freed objects, top of the stack at count - 1 */
+
+	uint32_t count;
+		/*!< Number of cached objects */
+
+	unsigned long hits;
+		/*!< Allocations served from magazine */
+
+	unsigned long misses;
+		/*!< Allocations which had to refill magazine */
+};
+
+struct env_mpool_magazines {
+	struct env_mpool_magazine mag[env_mpool_mag_max];
+};
+
+/* Magazine index of each allocation order, -1 if order is not cached */
+static const int env_mpool_mag_idx[env_mpool_max] = {
+	[env_mpool_1] = env_mpool_mag_1,
+	[env_mpool_2] = env_mpool_mag_2,
+	[env_mpool_4] = env_mpool_mag_4,
+	[env_mpool_8] = -1,
+	[env_mpool_16] = env_mpool_mag_16,
+	[env_mpool_32] = -1,
+	[env_mpool_64] = -1,
+	[env_mpool_128] = -1,
+};
+
 struct env_mpool {
 	env_allocator *allocator[env_mpool_max];
 		/*!< OS handle to memory pool */
@@ -24,6 +60,9 @@ struct env_mpool {
 
 	int flags;
 		/*!< Allocation flags */
+
+	struct env_mpool_magazines __percpu *mags;
+		/*!< Per CPU caches of recently freed objects, NULL if disabled */
 };
 
 struct env_mpool *env_mpool_create(uint32_t hdr_size, uint32_t elem_size,
@@ -69,11 +108,89 @@ err:
 	return NULL;
 }
 
+static void env_mpool_magazines_drain(struct env_mpool *mpool)
+{
+	struct env_mpool_magazine *mag;
+	int cpu, order;
+
+	for_each_possible_cpu(cpu) {
+		for (order = 0; order < env_mpool_max; order++) {
+			if (env_mpool_mag_idx[order] < 0 ||
+					!mpool->allocator[order]) {
+				continue;
+			}
+
+			mag = &per_cpu_ptr(mpool->mags, cpu)->mag[
+					env_mpool_mag_idx[order]];
+			while (mag->count) {
+				env_allocator_del(mpool->allocator[order],
+						mag->objs[--mag->count]);
+			}
+		}
+	}
+}
+
+int env_mpool_enable_magazines(struct env_mpool *mpool)
+{
+	mpool->mags = alloc_percpu(struct env_mpool_magazines);
+
+	return mpool->mags ? 0 : -ENOMEM;
+}
+
+void env_mpool_get_magazine_stats(struct env_mpool *mpool, int mag_idx,
+		uint64_t *hits, uint64_t *misses)
+{
+	struct env_mpool_magazine *mag;
+	int cpu;
+
+	*hits = 0;
+	*misses = 0;
+
+	if (!mpool->mags)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		mag = &per_cpu_ptr(mpool->mags, cpu)->mag[mag_idx];
+		*hits += READ_ONCE(mag->hits);
+		*misses += READ_ONCE(mag->misses);
+	}
+}
+
+void env_mpool_get_usage(struct env_mpool *mpool, int order,
+		uint32_t *items, uint32_t *item_size)
+{
+	*items = 0;
+	*item_size = 0;
+
+	if (!mpool->allocator[order])
+		return;
+
+	*items = env_allocator_item_count(mpool->allocator[order]);
+	*item_size = mpool->hdr_size + (mpool->elem_size * (1 << order));
+}
+
+void env_mpool_get_rpool_stats(struct env_mpool *mpool, int order,
+		uint64_t *steals, uint64_t *fallbacks)
+{
+	*steals = 0;
+	*fallbacks = 0;
+
+	if (mpool->allocator[order]) {
+		env_allocator_get_rpool_stats(mpool->allocator[order],
+				steals, fallbacks);
+	}
+}
+
 void env_mpool_destroy(struct env_mpool *mallocator)
 {
 	if (mallocator) {
 		uint32_t i;
 
+		if (mallocator->mags) {
+			env_mpool_magazines_drain(mallocator);
+			free_percpu(mallocator->mags);
+		}
+
 		for (i = 0; i < env_mpool_max; i++)
 			if (mallocator->allocator[i])
 				env_allocator_destroy(mallocator->allocator[i]);
@@ -82,13 +199,12 @@ void env_mpool_destroy(struct env_mpool *mallocator)
 	}
 }
 
-static env_allocator *env_mpool_get_allocator(
-	struct env_mpool *mallocator, uint32_t count)
+static int env_mpool_get_order(struct env_mpool *mallocator, uint32_t count)
 {
 	unsigned int idx;
 
 	if (unlikely(count == 0))
-		return mallocator->allocator[env_mpool_1];
+		return env_mpool_1;
 
 	idx = 31 - __builtin_clz(count);
 
@@ -96,9 +212,92 @@ static env_allocator *env_mpool_get_allocator(
 		idx++;
 
 	if (idx >= env_mpool_max || idx > mallocator->mpool_max)
+		return -1;
+
+	return idx;
+}
+
+/*
+ * Take object from magazine of current CPU. When magazine is empty refill
+ * it with a batch of objects from the allocator.
+ */
+static void *env_mpool_mag_new(struct env_mpool *mpool, int order)
+{
+	env_allocator *allocator = mpool->allocator[order];
+	void *batch[ENV_MPOOL_MAG_BATCH];
+	struct env_mpool_magazine *mag;
+	unsigned long flags;
+	void *items = NULL;
+	int i, count;
+
+	local_irq_save(flags);
+	mag = &this_cpu_ptr(mpool->mags)->mag[env_mpool_mag_idx[order]];
+	if (mag->count) {
+		items = mag->objs[--mag->count];
+		mag->hits++;
+	} else {
+		mag->misses++;
+	}
+	local_irq_restore(flags);
+
+	if (items) {
+		memset(items, 0, mpool->hdr_size +
+				(mpool->elem_size << order));
+		return items;
+	}
+
+	items = env_allocator_new(allocator);
+	if (!items)
 		return NULL;
 
-	return mallocator->allocator[idx];
+	for (count = 0; count < ENV_MPOOL_MAG_BATCH; count++) {
+		batch[count] = env_allocator_new(allocator);
+		if (!batch[count])
+			break;
+	}
+
+	/* We might have migrated meanwhile, refill whichever CPU we are on */
+	local_irq_save(flags);
+	mag = &this_cpu_ptr(mpool->mags)->mag[env_mpool_mag_idx[order]];
+	while (count && mag->count < ENV_MPOOL_MAG_SIZE)
+		mag->objs[mag->count++] = batch[--count];
+	local_irq_restore(flags);
+
+	for (i = 0; i < count; i++)
+		env_allocator_del(allocator, batch[i]);
+
+	return items;
+}
+
+/*
+ * Put object to magazine of current CPU. When magazine is full drain
+ * a batch of objects back to the allocator.
+ */
+static void env_mpool_mag_del(struct env_mpool *mpool, int order,
+		void *items)
+{
+	env_allocator *allocator = mpool->allocator[order];
+	void *batch[ENV_MPOOL_MAG_BATCH];
+	struct env_mpool_magazine *mag;
+	unsigned long flags;
+	int i, count = 0;
+
+	local_irq_save(flags);
+	mag = &this_cpu_ptr(mpool->mags)->mag[env_mpool_mag_idx[order]];
+	if (mag->count == ENV_MPOOL_MAG_SIZE) {
+		for (count = 0; count < ENV_MPOOL_MAG_BATCH; count++)
+			batch[count] = mag->objs[--mag->count];
+	}
+	mag->objs[mag->count++] = items;
+	local_irq_restore(flags);
+
+	for (i = 0; i < count; i++)
+		env_allocator_del(allocator, batch[i]);
+}
+
+static inline bool env_mpool_mag_cached(struct env_mpool *mpool, int order)
+{
+	return mpool->mags && order >= 0 && env_mpool_mag_idx[order] >= 0;
 }
 
 void *env_mpool_new_f(struct env_mpool *mpool, uint32_t count, int flags)
@@ -106,10 +305,13 @@ void *env_mpool_new_f(struct env_mpool *mpool, uint32_t count, int flags)
 	void *items = NULL;
 	env_allocator *allocator;
 	size_t size = mpool->hdr_size + (mpool->elem_size * count);
+	int order = env_mpool_get_order(mpool, count);
 
-	allocator = env_mpool_get_allocator(mpool, count);
+	allocator = order < 0 ? NULL : mpool->allocator[order];
 
-	if (allocator) {
+	if (allocator && env_mpool_mag_cached(mpool, order)) {
+		items = env_mpool_mag_new(mpool, order);
+	} else if (allocator) {
 		items = env_allocator_new(allocator);
 	} else if(mpool->fallback) {
 		items = cas_vmalloc(size,
@@ -133,10 +335,13 @@ bool env_mpool_del(struct env_mpool *mpool,
 		void *items, uint32_t count)
 {
 	env_allocator *allocator;
+	int order = env_mpool_get_order(mpool, count);
 
-	allocator = env_mpool_get_allocator(mpool, count);
+	allocator = order < 0 ? NULL : mpool->allocator[order];
 
-	if (allocator)
+	if (allocator && env_mpool_mag_cached(mpool, order))
+		env_mpool_mag_del(mpool, order, items);
+	else if (allocator)
 		env_allocator_del(allocator, items);
 	else if (mpool->fallback)
 		cas_vfree(items);
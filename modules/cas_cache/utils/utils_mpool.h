@@ -23,6 +23,16 @@ enum {
 	env_mpool_max
 };
 
+/* Allocation orders cached in per CPU magazines */
+enum {
+	env_mpool_mag_1,
+	env_mpool_mag_2,
+	env_mpool_mag_4,
+	env_mpool_mag_16,
+
+	env_mpool_mag_max
+};
+
 struct env_mpool;
 
 /**
@@ -53,6 +63,53 @@ struct env_mpool *env_mpool_create(uint32_t hdr_size, uint32_t elem_size,
  */
 void env_mpool_destroy(struct env_mpool *mpool);
 
+/**
+ * @brief Enable per CPU magazines of recently freed objects
+ *
+ * @note Objects of orders cached in magazines (1, 2, 4 and 16 elements) are
+ * allocated and freed without touching allocator locks as long as magazine
+ * of current CPU has objects/room left
+ *
+ * @param mpool memory pool
+ *
+ * @return 0 on success, -ENOMEM otherwise
+ */
+int env_mpool_enable_magazines(struct env_mpool *mpool);
+
+/**
+ * @brief Get magazine statistics summed over all CPUs
+ *
+ * @param mpool memory pool
+ * @param mag_idx Magazine index (env_mpool_mag_*)
+ * @param hits Number of allocations served from magazine
+ * @param misses Number of allocations which had to refill magazine
+ */
+void env_mpool_get_magazine_stats(struct env_mpool *mpool, int mag_idx,
+		uint64_t *hits, uint64_t *misses);
+
+/**
+ * @brief Get number of objects of given allocation order currently
+ * allocated, including ones cached in magazines
+ *
+ * @param mpool memory pool
+ * @param order Allocation order (env_mpool_*)
+ * @param items Number of allocated objects
+ * @param item_size Size of single object, 0 if order is not used
+ */
+void env_mpool_get_usage(struct env_mpool *mpool, int order,
+		uint32_t *items, uint32_t *item_size);
+
+/**
+ * @brief Get reserve pool statistics of allocator of given allocation order
+ *
+ * @param mpool memory pool
+ * @param order Allocation order (env_mpool_*)
+ * @param steals Number of allocations served by sibling CPU reserve pool
+ * @param fallbacks Number of allocations which found reserve pool empty
+ */
+void env_mpool_get_rpool_stats(struct env_mpool *mpool, int order,
+		uint64_t *steals, uint64_t *fallbacks);
+
 /**
  * @brief Allocate new items of memory pool
  *
@@ -0,0 +1,188 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <linux/hash.h>
+#include <linux/log2.h>
+#include "../cas_cache.h"
+#include "utils_mrc.h"
+
+/*
+ * SHARDS-like estimation: only lines whose hash falls below threshold of
+ * 1 / 2^shift are tracked and their reuse distances, counted in distinct
+ * sampled lines, are scaled up by 2^shift. Sampled accesses are stamped
+ * with consecutive times and the last CAS_MRC_SLOTS stamps are kept in a
+ * ring indexed by time. Fenwick tree over the ring counts slots still
+ * holding last access of their line, which makes reuse distance a range
+ * sum. Line whose slot is reused before next access counts as cold miss.
+ */
+#define CAS_MRC_SLOTS_SHIFT 14
+#define CAS_MRC_SLOTS (1 << CAS_MRC_SLOTS_SHIFT)
+#define CAS_MRC_HASH_BITS (CAS_MRC_SLOTS_SHIFT - 1)
+
+struct cas_mrc_slot {
+	uint64_t line;
+	struct hlist_node node;
+	bool valid;
+};
+
+struct cas_mrc {
+	/* Protects everything but shift */
+	spinlock_t lock;
+
+	uint32_t shift;
+	uint64_t now;
+	uint32_t valid_no;
+
+	uint64_t cold;
+	uint64_t hist[KCAS_MRC_BUCKETS];
+
+	/* Fenwick tree of valid slots, 1-based */
+	uint16_t fenwick[CAS_MRC_SLOTS + 1];
+	struct cas_mrc_slot slots[CAS_MRC_SLOTS];
+	struct hlist_head hash[1 << CAS_MRC_HASH_BITS];
+};
+
+static inline uint32_t cas_mrc_bucket(uint64_t distance)
+{
+	uint32_t msb;
+
+	if (distance < (1 << KCAS_MRC_SUB_BITS))
+		return distance;
+
+	msb = fls64(distance) - 1;
+	return ((msb - KCAS_MRC_SUB_BITS + 1) << KCAS_MRC_SUB_BITS) +
+		((distance >> (msb - KCAS_MRC_SUB_BITS)) &
+		 ((1 << KCAS_MRC_SUB_BITS) - 1));
+}
+
+static void cas_mrc_fenwick_add(struct cas_mrc *mrc, uint32_t slot, int delta)
+{
+	uint32_t i;
+
+	for (i = slot + 1; i <= CAS_MRC_SLOTS; i += i & -i)
+		mrc->fenwick[i] += delta;
+}
+
+/* Number of valid slots from 0 to @slot inclusive */
+static uint32_t cas_mrc_fenwick_sum(struct cas_mrc *mrc, uint32_t slot)
+{
+	uint32_t i, sum = 0;
+
+	for (i = slot + 1; i > 0; i -= i & -i)
+		sum += mrc->fenwick[i];
+
+	return sum;
+}
+
+static void cas_mrc_slot_release(struct cas_mrc *mrc, uint32_t slot)
+{
+	hlist_del(&mrc->slots[slot].node);
+	mrc->slots[slot].valid = false;
+	cas_mrc_fenwick_add(mrc, slot, -1);
+	mrc->valid_no--;
+}
+
+static struct cas_mrc_slot *cas_mrc_lookup(struct cas_mrc *mrc, uint64_t line)
+{
+	struct cas_mrc_slot *slot;
+
+	hlist_for_each_entry(slot, &mrc->hash[hash_64(line, CAS_MRC_HASH_BITS)],
+			node) {
+		if (slot->line == line)
+			return slot;
+	}
+
+	return NULL;
+}
+
+static void cas_mrc_sample(struct cas_mrc *mrc, uint64_t line)
+{
+	uint32_t cur = mrc->now & (CAS_MRC_SLOTS - 1);
+	struct cas_mrc_slot *prev;
+	uint64_t distance;
+	uint32_t old;
+
+	/* Ring wrapped, oldest stamp is forgotten */
+	if (mrc->slots[cur].valid)
+		cas_mrc_slot_release(mrc, cur);
+
+	prev = cas_mrc_lookup(mrc, line);
+	if (prev) {
+		old = prev - mrc->slots;
+		/* Valid slots stamped after previous access of the line */
+		if (old < cur) {
+			distance = cas_mrc_fenwick_sum(mrc, cur) -
+				cas_mrc_fenwick_sum(mrc, old);
+		} else {
+			distance = mrc->valid_no -
+				cas_mrc_fenwick_sum(mrc, old) +
+				cas_mrc_fenwick_sum(mrc, cur);
+		}
+		cas_mrc_slot_release(mrc, old);
+		mrc->hist[min_t(uint32_t, cas_mrc_bucket(distance << mrc->shift),
+				KCAS_MRC_BUCKETS - 1)]++;
+	} else {
+		mrc->cold++;
+	}
+
+	mrc->slots[cur].line = line;
+	mrc->slots[cur].valid = true;
+	hlist_add_head(&mrc->slots[cur].node,
+			&mrc->hash[hash_64(line, CAS_MRC_HASH_BITS)]);
+	cas_mrc_fenwick_add(mrc, cur, 1);
+	mrc->valid_no++;
+	mrc->now++;
+}
+
+void cas_mrc_access(struct cas_mrc *mrc, uint64_t first, uint64_t last)
+{
+	unsigned long flags;
+	uint64_t line;
+
+	/* Unsampled lines cost just a hash, whose top bits pick samples */
+	for (line = first; line <= last; line++) {
+		if (mrc->shift && hash_64(line, mrc->shift))
+			continue;
+
+		spin_lock_irqsave(&mrc->lock, flags);
+		cas_mrc_sample(mrc, line);
+		spin_unlock_irqrestore(&mrc->lock, flags);
+	}
+}
+
+void cas_mrc_get(struct cas_mrc *mrc, struct kcas_get_mrc *cmd)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&mrc->lock, flags);
+	cmd->cold = mrc->cold;
+	memcpy(cmd->hist, mrc->hist, sizeof(cmd->hist));
+	spin_unlock_irqrestore(&mrc->lock, flags);
+
+	cmd->sample_shift = mrc->shift;
+}
+
+struct cas_mrc *cas_mrc_create(uint64_t lines)
+{
+	struct cas_mrc *mrc;
+
+	mrc = vzalloc(sizeof(*mrc));
+	if (!mrc)
+		return NULL;
+
+	spin_lock_init(&mrc->lock);
+
+	/* Tracked lines cover the whole device at most */
+	if (lines > CAS_MRC_SLOTS)
+		mrc->shift = ilog2(roundup_pow_of_two(lines)) -
+			CAS_MRC_SLOTS_SHIFT;
+
+	return mrc;
+}
+
+void cas_mrc_destroy(struct cas_mrc *mrc)
+{
+	vfree(mrc);
+}
@@ -0,0 +1,26 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __CAS_MRC_H__
+#define __CAS_MRC_H__
+
+struct cas_mrc;
+
+/*
+ * Create online estimator of LRU miss ratio curve of device of @lines
+ * cache lines. Sampling rate is chosen so that reuse distances up to whole
+ * device size fit in fixed number of tracked lines.
+ */
+struct cas_mrc *cas_mrc_create(uint64_t lines);
+
+void cas_mrc_destroy(struct cas_mrc *mrc);
+
+/* Account access to cache lines from @first to @last inclusive */
+void cas_mrc_access(struct cas_mrc *mrc, uint64_t first, uint64_t last);
+
+/* Get histogram of scaled reuse distances collected so far */
+void cas_mrc_get(struct cas_mrc *mrc, struct kcas_get_mrc *cmd);
+
+#endif /* __CAS_MRC_H__ */
@@ -0,0 +1,102 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <linux/hash.h>
+#include <linux/log2.h>
+#include "../cas_cache.h"
+#include "utils_rewrite.h"
+
+/*
+ * Slot holds second of last write of lines hashed to it, modulo
+ * CAS_REWRITE_EPOCHS plus one, 0 for never written. Write is a rewrite if
+ * its slot was written within last CAS_REWRITE_WINDOW seconds. Collisions
+ * and slots not written for whole epoch cycle make it approximate only.
+ */
+#define CAS_REWRITE_SLOTS_SHIFT 18
+#define CAS_REWRITE_EPOCHS 255
+#define CAS_REWRITE_WINDOW 30
+
+/* Lines of single write accounted, the rest of large write is skipped */
+#define CAS_REWRITE_LINES_MAX 32
+
+struct cas_rewrite_stats {
+	uint64_t writes;
+	uint64_t rewrites;
+};
+
+struct cas_rewrite {
+	uint32_t line_shift;
+	struct cas_rewrite_stats __percpu *stats;
+	/* Totals at previous sample, used by sampling caller only */
+	struct cas_rewrite_stats sampled;
+	uint8_t slots[1 << CAS_REWRITE_SLOTS_SHIFT];
+};
+
+struct cas_rewrite *cas_rewrite_create(uint32_t line_sectors)
+{
+	struct cas_rewrite *rw;
+
+	rw = vzalloc(sizeof(*rw));
+	if (!rw)
+		return NULL;
+
+	rw->stats = alloc_percpu(struct cas_rewrite_stats);
+	if (!rw->stats) {
+		vfree(rw);
+		return NULL;
+	}
+
+	rw->line_shift = ilog2(line_sectors);
+
+	return rw;
+}
+
+void cas_rewrite_destroy(struct cas_rewrite *rw)
+{
+	free_percpu(rw->stats);
+	vfree(rw);
+}
+
+void cas_rewrite_access(struct cas_rewrite *rw, uintptr_t core_key,
+		sector_t sector, uint32_t sectors)
+{
+	uint64_t line = sector >> rw->line_shift;
+	uint64_t last = (sector + sectors - 1) >> rw->line_shift;
+	uint8_t now = (jiffies / HZ) % CAS_REWRITE_EPOCHS + 1;
+	uint64_t core_hash = hash_64(core_key, 64);
+	uint32_t lines = 0, rewrites = 0;
+	uint8_t *slot, then;
+
+	for (; line <= last && lines < CAS_REWRITE_LINES_MAX; line++, lines++) {
+		slot = &rw->slots[hash_64(line ^ core_hash,
+				CAS_REWRITE_SLOTS_SHIFT)];
+		then = READ_ONCE(*slot);
+		if (then && (now + CAS_REWRITE_EPOCHS - then) %
+				CAS_REWRITE_EPOCHS < CAS_REWRITE_WINDOW) {
+			rewrites++;
+		}
+		if (then != now)
+			WRITE_ONCE(*slot, now);
+	}
+
+	this_cpu_add(rw->stats->writes, lines);
+	this_cpu_add(rw->stats->rewrites, rewrites);
+}
+
+void cas_rewrite_sample(struct cas_rewrite *rw, uint64_t *writes,
+		uint64_t *rewrites)
+{
+	struct cas_rewrite_stats total = {};
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		total.writes += per_cpu_ptr(rw->stats, cpu)->writes;
+		total.rewrites += per_cpu_ptr(rw->stats, cpu)->rewrites;
+	}
+
+	*writes = total.writes - rw->sampled.writes;
+	*rewrites = total.rewrites - rw->sampled.rewrites;
+	rw->sampled = total;
+}
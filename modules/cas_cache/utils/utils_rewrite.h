@@ -0,0 +1,28 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __CAS_REWRITE_H__
+#define __CAS_REWRITE_H__
+
+struct cas_rewrite;
+
+/*
+ * Recency of writes to cache lines. Each write of cache line is checked
+ * against time of last write hashed to the same slot of small table, which
+ * tells apart rewrites of recently written lines from other writes.
+ */
+struct cas_rewrite *cas_rewrite_create(uint32_t line_sectors);
+
+void cas_rewrite_destroy(struct cas_rewrite *rw);
+
+/* Account write to core identified by @core_key, may be called in atomic context */
+void cas_rewrite_access(struct cas_rewrite *rw, uintptr_t core_key,
+		sector_t sector, uint32_t sectors);
+
+/* Writes and rewrites accounted since previous call */
+void cas_rewrite_sample(struct cas_rewrite *rw, uint64_t *writes,
+		uint64_t *rewrites);
+
+#endif /* __CAS_REWRITE_H__ */
@@ -27,25 +27,46 @@
 #define CAS_DEBUG_PARAM(format, ...)
 #endif
 
-/* This is currently 24B padded/force aligned to 32B.
- * With a 64B cacheline this means two structs on different cores may
- * invalidate each other. This shouldn't happen between different physical
- * CPUs and cause false sharing though, since with an even number of cores
- * per CPU same cacheline shouldn't be polluted from the other physical CPU.
+/* Maximum number of entries moved from a sibling CPU in a single steal */
+#define CAS_RPOOL_STEAL_BATCH 16
+
+/* Under memory pressure per-CPU pools are trimmed down to this level */
+#define CAS_RPOOL_LOW_WATERMARK(limit) ((limit) / 4)
+
+/* Each per-CPU pool occupies a full cacheline, so pools of neighbouring
+ * cores never invalidate each other on get/put.
  * */
 struct _cas_reserve_pool_per_cpu {
 	spinlock_t lock;
 	struct list_head list;
 	atomic_t count;
-} __attribute__((__aligned__(32)));
+} __attribute__((__aligned__(64)));
 
 struct cas_reserve_pool {
 	uint32_t limit;
 	uint32_t entry_size;
 	char *name;
+	int cpu_no;
 	struct _cas_reserve_pool_per_cpu *rpools;
+	atomic64_t steals;
+	atomic64_t fallbacks;
+
+	cas_rpool_new rpool_new;
+	cas_rpool_del rpool_del;
+	void *allocator_ctx;
+
+	/* Number of entries released by the shrinker and not yet refilled */
+	atomic_t trimmed;
+	struct work_struct refill_work;
+
+	/* Entry on the list of all reserve pools visible to the shrinker */
+	struct list_head node;
 };
 
+static LIST_HEAD(cas_rpool_list);
+static DEFINE_SPINLOCK(cas_rpool_list_lock);
+static struct shrinker *cas_rpool_shrinker;
+
 struct _cas_rpool_pre_alloc_info {
 	struct work_struct ws;
 	struct completion cmpl;
@@ -97,10 +118,50 @@ static void _cas_rpool_pre_alloc_do(struct work_struct *ws)
 	complete(&info->cmpl);
 }
 
+/*
+ * Allocate again entries released by the shrinker, once a CPU runs out of
+ * them. Runs on the CPU which missed.
+ */
+static void _cas_rpool_refill_do(struct work_struct *ws)
+{
+	struct cas_reserve_pool *rpool_master =
+			container_of(ws, struct cas_reserve_pool, refill_work);
+	struct _cas_reserve_pool_per_cpu *current_rpool;
+	struct list_head *item;
+	unsigned long flags;
+	void *entry;
+	int i, cpu;
+
+	cpu = smp_processor_id();
+	if (cpu >= rpool_master->cpu_no)
+		return;
+
+	current_rpool = &rpool_master->rpools[cpu];
+
+	for (i = 0; i < CAS_RPOOL_STEAL_BATCH; i++) {
+		if (atomic_read(&current_rpool->count) >= rpool_master->limit)
+			break;
+		if (!atomic_add_unless(&rpool_master->trimmed, -1, 0))
+			break;
+
+		entry = rpool_master->rpool_new(rpool_master->allocator_ctx, cpu);
+		if (!entry) {
+			atomic_inc(&rpool_master->trimmed);
+			break;
+		}
+
+		item = RPOOL_ENTRY_TO_ITEM(rpool_master, entry);
+		spin_lock_irqsave(&current_rpool->lock, flags);
+		list_add_tail(item, &current_rpool->list);
+		atomic_inc(&current_rpool->count);
+		spin_unlock_irqrestore(&current_rpool->lock, flags);
+	}
+}
+
 void cas_rpool_destroy(struct cas_reserve_pool *rpool_master,
 		cas_rpool_del rpool_del, void *allocator_ctx)
 {
-	int i, cpu_no = num_online_cpus();
+	int i, cpu_no;
 	struct _cas_reserve_pool_per_cpu *current_rpool = NULL;
 	struct list_head *item = NULL, *next = NULL;
 	void *entry;
@@ -115,6 +176,19 @@ void cas_rpool_destroy(struct cas_reserve_pool *rpool_master,
 		return;
 	}
 
+	cpu_no = rpool_master->cpu_no;
+
+	spin_lock(&cas_rpool_list_lock);
+	if (!list_empty(&rpool_master->node))
+		list_del_init(&rpool_master->node);
+	spin_unlock(&cas_rpool_list_lock);
+
+	cancel_work_sync(&rpool_master->refill_work);
+
+	CAS_DEBUG_PARAM("Reserve pool [%s] steals %lld, fallbacks %lld",
+			rpool_master->name, atomic64_read(&rpool_master->steals),
+			atomic64_read(&rpool_master->fallbacks));
+
 	for (i = 0; i < cpu_no; i++) {
 		current_rpool = &rpool_master->rpools[i];
 
@@ -146,7 +220,8 @@ struct cas_reserve_pool *cas_rpool_create(uint32_t limit, char *name,
 		uint32_t entry_size, cas_rpool_new rpool_new,
 		cas_rpool_del rpool_del, void *allocator_ctx)
 {
-	int i, cpu_no = num_online_cpus();
+	/* Pools are indexed by CPU id, which may exceed online CPU count */
+	int i, cpu_no = nr_cpu_ids;
 	struct cas_reserve_pool *rpool_master = NULL;
 	struct _cas_reserve_pool_per_cpu *current_rpool = NULL;
 	struct _cas_rpool_pre_alloc_info info;
@@ -159,6 +234,9 @@ struct cas_reserve_pool *cas_rpool_create(uint32_t limit, char *name,
 	if (!rpool_master)
 		goto error;
 
+	INIT_LIST_HEAD(&rpool_master->node);
+	INIT_WORK(&rpool_master->refill_work, _cas_rpool_refill_do);
+
 	rpool_master->rpools = kzalloc(sizeof(*rpool_master->rpools) * cpu_no,
 			GFP_KERNEL);
 	if (!rpool_master->rpools)
@@ -167,6 +245,10 @@ struct cas_reserve_pool *cas_rpool_create(uint32_t limit, char *name,
 	rpool_master->limit = limit;
 	rpool_master->name = name;
 	rpool_master->entry_size = entry_size;
+	rpool_master->cpu_no = cpu_no;
+	rpool_master->rpool_new = rpool_new;
+	rpool_master->rpool_del = rpool_del;
+	rpool_master->allocator_ctx = allocator_ctx;
 
 	info.rpool_master = rpool_master;
 	info.rpool_new = rpool_new;
@@ -176,7 +258,10 @@ struct cas_reserve_pool *cas_rpool_create(uint32_t limit, char *name,
 		current_rpool = &rpool_master->rpools[i];
 		spin_lock_init(&current_rpool->lock);
 		INIT_LIST_HEAD(&current_rpool->list);
+	}
 
+	/* Pools of offline CPUs fill up from frees and steals once online */
+	for_each_online_cpu(i) {
 		init_completion(&info.cmpl);
 		INIT_WORK_ONSTACK(&info.ws, _cas_rpool_pre_alloc_do);
 		schedule_work_on(i, &info.ws);
@@ -190,6 +275,10 @@ struct cas_reserve_pool *cas_rpool_create(uint32_t limit, char *name,
 				rpool_master->name, i);
 	}
 
+	spin_lock(&cas_rpool_list_lock);
+	list_add_tail(&rpool_master->node, &cas_rpool_list);
+	spin_unlock(&cas_rpool_list_lock);
+
 	return rpool_master;
 error:
 
@@ -199,6 +288,61 @@ error:
 
 #define LIST_FIRST_ITEM(head) head.next
 
+/*
+ * Move a batch of entries from another CPU on the same NUMA node to the
+ * pool of the given CPU. One entry of the batch is returned to the caller,
+ * the rest lands on the local list. Victim and local locks are never held
+ * at the same time.
+ */
+static struct list_head *_cas_rpool_steal(struct cas_reserve_pool *rpool_master,
+		int cpu)
+{
+	struct _cas_reserve_pool_per_cpu *victim, *current_rpool;
+	struct list_head *item = NULL;
+	unsigned long flags;
+	LIST_HEAD(batch);
+	int sibling, i, count = 0;
+
+	for_each_cpu(sibling, cpumask_of_node(cpu_to_node(cpu))) {
+		if (sibling == cpu || sibling >= rpool_master->cpu_no)
+			continue;
+
+		victim = &rpool_master->rpools[sibling];
+		if (!atomic_read(&victim->count))
+			continue;
+
+		spin_lock_irqsave(&victim->lock, flags);
+		/* Leave the victim at least half of what it has */
+		count = min_t(int, DIV_ROUND_UP(atomic_read(&victim->count), 2),
+				CAS_RPOOL_STEAL_BATCH);
+		for (i = 0; i < count; i++)
+			list_move_tail(LIST_FIRST_ITEM(victim->list), &batch);
+		atomic_sub(count, &victim->count);
+		spin_unlock_irqrestore(&victim->lock, flags);
+
+		if (count)
+			break;
+	}
+
+	if (list_empty(&batch))
+		return NULL;
+
+	item = LIST_FIRST_ITEM(batch);
+	list_del(item);
+
+	if (--count) {
+		current_rpool = &rpool_master->rpools[cpu];
+		spin_lock_irqsave(&current_rpool->lock, flags);
+		list_splice_tail(&batch, &current_rpool->list);
+		atomic_add(count, &current_rpool->count);
+		spin_unlock_irqrestore(&current_rpool->lock, flags);
+	}
+
+	atomic64_inc(&rpool_master->steals);
+
+	return item;
+}
+
 void *cas_rpool_try_get(struct cas_reserve_pool *rpool_master, int *cpu)
 {
 	unsigned long flags;
@@ -222,6 +366,19 @@ void *cas_rpool_try_get(struct cas_reserve_pool *rpool_master, int *cpu)
 
 	spin_unlock_irqrestore(&current_rpool->lock, flags);
 
+	if (!item) {
+		item = _cas_rpool_steal(rpool_master, *cpu);
+		if (item)
+			entry = RPOOL_ITEM_TO_ENTRY(rpool_master, item);
+		else
+			atomic64_inc(&rpool_master->fallbacks);
+	}
+
+	if (!entry && atomic_read(&rpool_master->trimmed)) {
+		/* Lazily refill entries released earlier by the shrinker */
+		queue_work_on(*cpu, system_wq, &rpool_master->refill_work);
+	}
+
 	if (entry) {
 		/* The actual allocation - kmemleak should start tracking page */
 		kmemleak_alloc(entry, rpool_master->entry_size, 1, GFP_NOIO);
@@ -235,6 +392,28 @@ void *cas_rpool_try_get(struct cas_reserve_pool *rpool_master, int *cpu)
 	return entry;
 }
 
+/*
+ * Find a CPU on the same node as the given one which still has room in its
+ * pool, so entries freed on a busy CPU keep replenishing the node.
+ */
+static int _cas_rpool_refill_cpu(struct cas_reserve_pool *rpool_master,
+		int cpu)
+{
+	int sibling;
+
+	for_each_cpu(sibling, cpumask_of_node(cpu_to_node(cpu))) {
+		if (sibling == cpu || sibling >= rpool_master->cpu_no)
+			continue;
+
+		if (atomic_read(&rpool_master->rpools[sibling].count) <
+				rpool_master->limit) {
+			return sibling;
+		}
+	}
+
+	return -1;
+}
+
 int cas_rpool_try_put(struct cas_reserve_pool *rpool_master, void *entry, int cpu)
 {
 	int ret = 0;
@@ -246,6 +425,15 @@ int cas_rpool_try_put(struct cas_reserve_pool *rpool_master, void *entry, int cp
 
 	current_rpool = &rpool_master->rpools[cpu];
 
+	if (atomic_read(&current_rpool->count) >= rpool_master->limit) {
+		int sibling = _cas_rpool_refill_cpu(rpool_master, cpu);
+
+		if (sibling >= 0) {
+			cpu = sibling;
+			current_rpool = &rpool_master->rpools[cpu];
+		}
+	}
+
 	spin_lock_irqsave(&current_rpool->lock, flags);
 
 	if (atomic_read(&current_rpool->count) >= rpool_master->limit) {
@@ -268,3 +456,115 @@ error:
 	spin_unlock_irqrestore(&current_rpool->lock, flags);
 	return ret;
 }
+
+void cas_rpool_get_stats(struct cas_reserve_pool *rpool_master,
+		uint64_t *steals, uint64_t *fallbacks)
+{
+	*steals = atomic64_read(&rpool_master->steals);
+	*fallbacks = atomic64_read(&rpool_master->fallbacks);
+}
+
+static unsigned long _cas_rpool_shrink_cpu(struct cas_reserve_pool *rpool_master,
+		struct _cas_reserve_pool_per_cpu *current_rpool,
+		unsigned long nr_to_scan)
+{
+	int low = CAS_RPOOL_LOW_WATERMARK(rpool_master->limit);
+	unsigned long flags, freed = 0;
+	struct list_head *item, *next;
+	LIST_HEAD(trim);
+
+	spin_lock_irqsave(&current_rpool->lock, flags);
+	while (freed < nr_to_scan && atomic_read(&current_rpool->count) > low) {
+		/* Oldest entries sit at the head of the list */
+		list_move_tail(LIST_FIRST_ITEM(current_rpool->list), &trim);
+		atomic_dec(&current_rpool->count);
+		freed++;
+	}
+	spin_unlock_irqrestore(&current_rpool->lock, flags);
+
+	list_for_each_safe(item, next, &trim) {
+		list_del(item);
+		rpool_master->rpool_del(rpool_master->allocator_ctx,
+				RPOOL_ITEM_TO_ENTRY(rpool_master, item));
+	}
+
+	atomic_add(freed, &rpool_master->trimmed);
+
+	return freed;
+}
+
+static unsigned long _cas_rpool_shrink_count(struct shrinker *shrinker,
+		struct shrink_control *sc)
+{
+	struct cas_reserve_pool *rpool_master;
+	unsigned long count = 0;
+	int i, low;
+
+	spin_lock(&cas_rpool_list_lock);
+	list_for_each_entry(rpool_master, &cas_rpool_list, node) {
+		low = CAS_RPOOL_LOW_WATERMARK(rpool_master->limit);
+		for (i = 0; i < rpool_master->cpu_no; i++) {
+			count += max(atomic_read(&rpool_master->rpools[i].count)
+					- low, 0);
+		}
+	}
+	spin_unlock(&cas_rpool_list_lock);
+
+	return count;
+}
+
+static unsigned long _cas_rpool_shrink_scan(struct shrinker *shrinker,
+		struct shrink_control *sc)
+{
+	struct cas_reserve_pool *rpool_master;
+	unsigned long freed = 0;
+	int i;
+
+	spin_lock(&cas_rpool_list_lock);
+	list_for_each_entry(rpool_master, &cas_rpool_list, node) {
+		for (i = 0; i < rpool_master->cpu_no; i++) {
+			if (freed >= sc->nr_to_scan)
+				goto out;
+			freed += _cas_rpool_shrink_cpu(rpool_master,
+					&rpool_master->rpools[i],
+					sc->nr_to_scan - freed);
+		}
+	}
+out:
+	spin_unlock(&cas_rpool_list_lock);
+
+	return freed ?: SHRINK_STOP;
+}
+
+int cas_rpool_shrinker_init(void)
+{
+	cas_rpool_shrinker = cas_shrinker_create("cas_rpool",
+			_cas_rpool_shrink_count, _cas_rpool_shrink_scan);
+
+	return cas_rpool_shrinker ? 0 : -ENOMEM;
+}
+
+void cas_rpool_shrinker_deinit(void)
+{
+	if (cas_rpool_shrinker)
+		cas_shrinker_destroy(cas_rpool_shrinker);
+	cas_rpool_shrinker = NULL;
+}
+
+uint64_t cas_rpool_get_footprint(void)
+{
+	struct cas_reserve_pool *rpool_master;
+	uint64_t bytes = 0;
+	int i;
+
+	spin_lock(&cas_rpool_list_lock);
+	list_for_each_entry(rpool_master, &cas_rpool_list, node) {
+		for (i = 0; i < rpool_master->cpu_no; i++) {
+			bytes += (uint64_t)rpool_master->entry_size *
+				atomic_read(&rpool_master->rpools[i].count);
+		}
+	}
+	spin_unlock(&cas_rpool_list_lock);
+
+	return bytes;
+}
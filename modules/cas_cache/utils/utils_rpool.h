@@ -24,5 +24,24 @@ void *cas_rpool_try_get(struct cas_reserve_pool *rpool, int *cpu);
 
 int cas_rpool_try_put(struct cas_reserve_pool *rpool, void *item, int cpu);
 
+/*
+ * Number of gets served by stealing from a sibling CPU on the same node
+ * and number of gets that found no entry and fell back to the allocator.
+ */
+void cas_rpool_get_stats(struct cas_reserve_pool *rpool,
+		uint64_t *steals, uint64_t *fallbacks);
+
+/*
+ * Shrinker trimming idle entries of all reserve pools down to a low
+ * watermark under memory pressure. Trimmed entries are allocated again
+ * on demand.
+ */
+int cas_rpool_shrinker_init(void);
+
+void cas_rpool_shrinker_deinit(void);
+
+/* Memory currently held in all reserve pools, in bytes */
+uint64_t cas_rpool_get_footprint(void);
+
 #endif /* __CAS_RPOOL_H__ */
 
@@ -0,0 +1,180 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <linux/hash.h>
+#include <linux/log2.h>
+#include "../cas_cache.h"
+#include "utils_tinylfu.h"
+
+/*
+ * TinyLFU admission: access frequencies of core lines are estimated with
+ * count-min sketch of CAS_TINYLFU_DEPTH rows of small saturating counters,
+ * all halved once CAS_TINYLFU_SAMPLE_FACTOR accesses per counter of row were
+ * counted, so that estimates reflect recent accesses only.
+ *
+ * Line is admitted if its estimate beats the one of eviction candidate.
+ * OCF does not expose its eviction candidate, so it is approximated by the
+ * oldest of ring of recently inserted lines, i.e. lines admitted on first or
+ * second access. Candidates accessed since insertion would have been moved
+ * away from the end of LRU list, so such ones are skipped. Updates are not
+ * serialized, racing accesses may lose increments, which only makes
+ * estimates approximate.
+ */
+#define CAS_TINYLFU_DEPTH 4
+#define CAS_TINYLFU_COUNTER_MAX 15
+#define CAS_TINYLFU_SAMPLE_FACTOR 10
+
+/* 4 MiB to 16 MiB of counters, whatever cache size is */
+#define CAS_TINYLFU_WIDTH_MIN (1 << 20)
+#define CAS_TINYLFU_WIDTH_MAX (1 << 22)
+
+/* Recently inserted lines, the oldest few are eviction candidates */
+#define CAS_TINYLFU_RING 1024
+#define CAS_TINYLFU_CANDIDATES 4
+
+struct cas_tinylfu {
+	uint32_t width_shift;
+	uint32_t line_shift;
+	uint64_t sample_size;
+	atomic64_t samples;
+	struct work_struct aging_work;
+
+	/* Keys plus one, 0 for empty slot */
+	uint64_t ring[CAS_TINYLFU_RING];
+	atomic_t ring_head;
+
+	uint8_t counters[];
+};
+
+static void _cas_tinylfu_aging(struct work_struct *work)
+{
+	struct cas_tinylfu *tlfu = container_of(work, struct cas_tinylfu,
+			aging_work);
+	size_t i, count = (size_t)CAS_TINYLFU_DEPTH << tlfu->width_shift;
+
+	for (i = 0; i < count; i++) {
+		WRITE_ONCE(tlfu->counters[i], READ_ONCE(tlfu->counters[i]) >> 1);
+		if (!(i % (1 << 16)))
+			cond_resched();
+	}
+}
+
+struct cas_tinylfu *cas_tinylfu_create(uint64_t lines, uint32_t line_sectors)
+{
+	struct cas_tinylfu *tlfu;
+	uint64_t width;
+
+	width = clamp_t(uint64_t, roundup_pow_of_two(max_t(uint64_t, lines, 1)),
+			CAS_TINYLFU_WIDTH_MIN, CAS_TINYLFU_WIDTH_MAX);
+
+	tlfu = vzalloc(struct_size(tlfu, counters, CAS_TINYLFU_DEPTH * width));
+	if (!tlfu)
+		return NULL;
+
+	tlfu->width_shift = ilog2(width);
+	tlfu->line_shift = ilog2(line_sectors);
+	tlfu->sample_size = CAS_TINYLFU_SAMPLE_FACTOR * width;
+	atomic64_set(&tlfu->samples, 0);
+	atomic_set(&tlfu->ring_head, 0);
+	INIT_WORK(&tlfu->aging_work, _cas_tinylfu_aging);
+
+	return tlfu;
+}
+
+void cas_tinylfu_destroy(struct cas_tinylfu *tlfu)
+{
+	cancel_work_sync(&tlfu->aging_work);
+	vfree(tlfu);
+}
+
+/* Counter of key in given row, rows are picked by double hashing */
+static inline uint8_t *_cas_tinylfu_counter(struct cas_tinylfu *tlfu,
+		uint64_t key, int row)
+{
+	uint32_t h1 = hash_64(key, 32);
+	uint32_t h2 = hash_64(key ^ GOLDEN_RATIO_64, 32) | 1;
+	uint32_t mask = (1U << tlfu->width_shift) - 1;
+
+	return &tlfu->counters[((size_t)row << tlfu->width_shift) +
+			((h1 + row * h2) & mask)];
+}
+
+static uint8_t _cas_tinylfu_estimate(struct cas_tinylfu *tlfu, uint64_t key)
+{
+	uint8_t value, estimate = CAS_TINYLFU_COUNTER_MAX;
+	int row;
+
+	for (row = 0; row < CAS_TINYLFU_DEPTH; row++) {
+		value = READ_ONCE(*_cas_tinylfu_counter(tlfu, key, row));
+		if (value < estimate)
+			estimate = value;
+	}
+
+	return estimate;
+}
+
+/* Conservative update, only counters equal to estimate are incremented */
+static uint8_t _cas_tinylfu_increment(struct cas_tinylfu *tlfu, uint64_t key)
+{
+	uint8_t *counter, estimate = _cas_tinylfu_estimate(tlfu, key);
+	int row;
+
+	if (atomic64_inc_return(&tlfu->samples) >= tlfu->sample_size) {
+		atomic64_set(&tlfu->samples, 0);
+		queue_work(system_wq, &tlfu->aging_work);
+	}
+
+	if (estimate == CAS_TINYLFU_COUNTER_MAX)
+		return estimate;
+
+	for (row = 0; row < CAS_TINYLFU_DEPTH; row++) {
+		counter = _cas_tinylfu_counter(tlfu, key, row);
+		if (READ_ONCE(*counter) == estimate)
+			WRITE_ONCE(*counter, estimate + 1);
+	}
+
+	return estimate;
+}
+
+bool cas_tinylfu_admit(struct cas_tinylfu *tlfu, uintptr_t core_key,
+		sector_t sector)
+{
+	uint64_t key = ((sector >> tlfu->line_shift) << 16) ^
+			hash_64(core_key, 64);
+	uint8_t previous, estimate, candidate = 0;
+	uint32_t head;
+	uint64_t slot;
+	int i;
+
+	previous = _cas_tinylfu_increment(tlfu, key);
+	estimate = min_t(uint8_t, previous + 1, CAS_TINYLFU_COUNTER_MAX);
+
+	head = atomic_read(&tlfu->ring_head);
+	for (i = 0; i < CAS_TINYLFU_CANDIDATES; i++) {
+		slot = READ_ONCE(tlfu->ring[(head + i) % CAS_TINYLFU_RING]);
+		/* Cache is still filling up, nothing to evict */
+		if (!slot) {
+			candidate = 0;
+			break;
+		}
+		candidate = _cas_tinylfu_estimate(tlfu, slot - 1);
+		if (candidate <= 1)
+			break;
+	}
+
+	/* All candidates reused since insertion, whole cache is hot */
+	if (i == CAS_TINYLFU_CANDIDATES)
+		candidate = 0;
+
+	if (estimate <= candidate)
+		return false;
+
+	if (previous <= 1) {
+		head = atomic_inc_return(&tlfu->ring_head) - 1;
+		WRITE_ONCE(tlfu->ring[head % CAS_TINYLFU_RING], key + 1);
+	}
+
+	return true;
+}
@@ -0,0 +1,26 @@
+/*
+* Copyright(c) 2024 Huawei Technologies
+* SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#ifndef __CAS_TINYLFU_H__
+#define __CAS_TINYLFU_H__
+
+struct cas_tinylfu;
+
+/*
+ * Create frequency sketch sized for cache of @lines cache lines of
+ * @line_sectors sectors
+ */
+struct cas_tinylfu *cas_tinylfu_create(uint64_t lines, uint32_t line_sectors);
+
+void cas_tinylfu_destroy(struct cas_tinylfu *tlfu);
+
+/*
+ * Account request to core identified by @core_key and tell whether its first
+ * cache line should be admitted into cache. May be called in atomic context.
+ */
+bool cas_tinylfu_admit(struct cas_tinylfu *tlfu, uintptr_t core_key,
+		sector_t sector);
+
+#endif /* __CAS_TINYLFU_H__ */
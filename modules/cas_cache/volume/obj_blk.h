@@ -11,12 +11,408 @@
 #include "vol_block_dev_top.h"
 
 struct cas_disk;
+struct cas_reserve_pool;
+
+/* Per CPU latency histograms of cache/core object, indexed by direction */
+struct cas_bd_lat_hist {
+	struct kcas_lat_hist exp_obj[OCF_USER_IO_CLASS_MAX][2];
+		/*< Requests to exported object per I/O class */
+
+	struct kcas_lat_hist dev[2];
+		/*< Bios sent to bottom device */
+};
+
+/* Per CPU stage latency histograms of core, indexed by direction */
+struct cas_bd_stage_hist {
+	uint32_t seq;
+		/*< Requests seen on CPU, picks sampled ones */
+
+	struct kcas_lat_hist stage[2][KCAS_IO_STAGE_MAX];
+};
+
+/* Per CPU access counters of LBA ranges of core */
+struct cas_bd_heatmap {
+	struct {
+		uint64_t reads;
+		uint64_t writes;
+		uint64_t core_reads;
+			/*< Reads sent to core device */
+	} buckets[KCAS_HEATMAP_BUCKETS];
+};
+
+/* Per CPU list of inflight requests to exported object */
+struct cas_bd_inflight {
+	spinlock_t lock;
+	struct list_head list;
+};
+
+/* Write pointer state of zone of host-managed zoned device */
+struct cas_bd_zone {
+	uint64_t wp;
+		/*< Address next write is sent to device at, U64_MAX for
+		 *  conventional zone */
+
+	uint64_t accepted;
+		/*< End of furthest write accepted by exported object */
+
+	bool busy;
+		/*< Write is in flight, writes to zone are sent one at a time */
+
+	bool resync;
+		/*< Write failed, write pointer has to be read from device */
+
+	atomic_t bios;
+		/*< Bios of write in flight, plus one while it is being sent */
+
+	struct list_head held;
+		/*< Writes waiting for write pointer, sorted by address */
+
+	struct list_head pending_node;
+		/*< Entry on list of zones with held writes */
+
+	unsigned long stamp;
+		/*< Jiffies of last move of write pointer */
+};
+
+/* Metadata page buffered by coalescing of metadata writes */
+struct cas_bd_meta_page {
+	struct page *page;
+		/*< Newest content not yet written back, NULL if none */
+
+	struct page *wb;
+		/*< Content being written back, NULL if none */
+};
+
+/* Coalescing of cache metadata writes */
+struct cas_bd_meta_co {
+	struct bd_object *bdobj;
+
+	spinlock_t lock;
+		/*< Protects buffered pages and held I/O */
+
+	uint64_t end;
+		/*< Writes below this offset, i.e. of cache metadata, are
+		 *  coalesced */
+
+	uint32_t window_us;
+		/*< Time pages are buffered for before being written back */
+
+	struct xarray pages;
+		/*< Buffered pages indexed by page of volume */
+
+	uint32_t count;
+		/*< Number of pages with content not yet written back */
+
+	bool writeback;
+		/*< Pages are being written back */
+
+	struct list_head held;
+		/*< I/O waiting for writeback, in order of arrival */
+
+	int error;
+		/*< First writeback error not yet returned by flush */
+
+	struct delayed_work work;
+		/*< Work writing buffered pages back */
+
+	atomic64_t absorbed;
+		/*< Writes completed once buffered */
+
+	atomic64_t writes;
+		/*< Writes sent by writeback */
+};
 
 struct bd_object {
 	struct cas_disk *dsk;
 
 	struct block_device *btm_bd;
 
+	uint32_t members_count;
+		/*< Number of devices data is striped over, 1 for block device */
+
+	struct cas_disk *member_dsk[CAS_BD_MEMBERS_MAX];
+		/*< Disks of members, the first one being dsk */
+
+	struct block_device *member_bd[CAS_BD_MEMBERS_MAX];
+		/*< Block devices of members, the first one being btm_bd */
+
+	bool mirrored;
+		/*< Members keep copies of the same data instead of stripes */
+
+	int member_state[CAS_BD_MEMBERS_MAX];
+		/*< State of members of mirrored volume, enum kcas_mirror_member_state */
+
+	atomic_t member_reads[CAS_BD_MEMBERS_MAX];
+		/*< Reads in flight per member of mirrored volume */
+
+	atomic_t mirror_writes[2];
+		/*< Writes to mirrored volume in flight per epoch */
+
+	int mirror_epoch;
+		/*< Flipped by rebuild to wait for writes sent so far */
+
+	wait_queue_head_t mirror_wait;
+
+	spinlock_t mirror_lock;
+		/*< Protects member states, rebuild fence and writes held by it */
+
+	bool rebuild_fencing;
+
+	uint64_t rebuild_fence_start;
+
+	uint64_t rebuild_fence_end;
+		/*< Range being copied, writes to it are held until copied */
+
+	struct list_head rebuild_held;
+
+	uint64_t rebuild_pos;
+
+	uint64_t rebuild_length;
+		/*< Progress of running rebuild in bytes */
+
+	uint32_t rebuild_member;
+
+	bool rebuild_running;
+
+	bool rebuild_stop;
+
+	struct work_struct rebuild_work;
+
+	uint64_t mirror_seq;
+
+	uint64_t mirror_seq_done;
+		/*< Sequence number of current member states and of the last ones
+		 *  written to labels of members */
+
+	struct llist_head mirror_label_held;
+		/*< Completed writes waiting for member states to be written */
+
+	struct work_struct mirror_label_work;
+
+	struct list_head mirror_retry;
+		/*< Failed reads waiting to be sent to the other member */
+
+	struct work_struct mirror_retry_work;
+
+	struct dax_device *dax_dev;
+		/*< DAX device data is accessed through, NULL if accessed by bios */
+
+	uint64_t dax_offset;
+		/*< Offset of block device within DAX device */
+
+	bool null_dev;
+		/*< I/O is completed without reaching block device */
+
+	struct page **ram_pages;
+		/*< Pages data of RAM-backed volume is kept in, allocated when
+		 *  volume is opened, NULL for other volume types */
+
+	uint64_t ram_pages_count;
+
+	struct cas_compress *comp;
+		/*< Map of compressed volume, NULL for other volume types */
+
+	struct cas_bd_zone *zones;
+		/*< Zones of host-managed zoned device, NULL if not zoned */
+
+	uint32_t zone_shift;
+		/*< Log2 of zone size in bytes */
+
+	uint32_t nr_zones;
+
+	spinlock_t zone_lock;
+		/*< Protects write pointers of zones and writes held by them */
+
+	struct list_head zone_pending;
+		/*< Zones with held writes */
+
+	struct delayed_work zone_work;
+		/*< Work sending held writes once they reach write pointer */
+
+	wait_queue_head_t zone_wait;
+
+	struct bio_set *btm_bio_set;
+		/*< Bio set for bios submitted to bottom device */
+
+	atomic64_t write_gen;
+		/*< Incremented on completion of each write sent to bottom device */
+
+	atomic64_t flushed_gen;
+		/*< Write generation covered by last completed flush */
+
+	atomic64_t flushes_elided;
+		/*< Flushes completed without sending them to bottom device */
+
+	uint32_t inflight_limit[CAS_BD_IO_CLASS_MAX];
+		/*< Max number of bios in flight per I/O class, 0 - unlimited */
+
+	atomic_t inflight[CAS_BD_IO_CLASS_MAX];
+		/*< Number of bios in flight per I/O class */
+
+	spinlock_t inflight_lock;
+		/*< Lock protecting lists of I/O waiting for inflight budget */
+
+	struct list_head inflight_waiting[CAS_BD_IO_CLASS_MAX];
+		/*< I/O waiting for inflight budget per I/O class */
+
+	struct work_struct inflight_work;
+		/*< Work submitting I/O which got inflight budget */
+
+	bool inflight_unthrottled;
+		/*< Background I/O is not held back, set for cache flush */
+
+	uint64_t rate_limit;
+		/*< Max bytes per second of background I/O, 0 - unlimited */
+
+	int64_t rate_budget;
+		/*< Bytes of background I/O which may be sent now, protected
+		 *  by inflight_lock */
+
+	unsigned long rate_stamp;
+		/*< Jiffies of last rate budget refill */
+
+	struct delayed_work rate_work;
+		/*< Work resuming background I/O once rate budget refills */
+
+	uint32_t sweep_window_us;
+		/*< Time background writes are gathered for before being sent
+		 *  in ascending order of address, 0 - sent as they come */
+
+	struct rb_root sweep_pending;
+		/*< Gathered background writes sorted by address, protected by
+		 *  inflight_lock */
+
+	uint32_t sweep_count;
+		/*< Number of gathered background writes */
+
+	bool sweep_ready;
+		/*< Gathered writes are being sent */
+
+	uint64_t sweep_pos;
+		/*< Address following last write sent in current sweep */
+
+	struct delayed_work sweep_work;
+		/*< Work ending gathering window */
+
+	unsigned long __rcu *trim_written;
+		/*< Chunks of cache data area written since last reset of
+		 *  background trim, NULL if trim is not enabled */
+
+	uint64_t trim_base;
+		/*< Address of the first chunk, i.e. end of cache metadata */
+
+	uint64_t trim_chunks;
+		/*< Number of chunks */
+
+	spinlock_t trim_lock;
+		/*< Lock protecting trim fence and writes held by it */
+
+	bool trim_fencing;
+		/*< Chunks are being discarded */
+
+	uint64_t trim_fence_start, trim_fence_end;
+		/*< Range of chunks being discarded */
+
+	struct list_head trim_held;
+		/*< Writes to chunks being discarded */
+
+	uint32_t __rcu *csum;
+		/*< Checksums of blocks of volume, 0 if not known, NULL if
+		 *  checksums are not enabled */
+
+	uint64_t csum_blocks;
+		/*< Number of blocks checksummed */
+
+	atomic64_t csum_errors;
+		/*< Blocks read with data not matching their checksums */
+
+	struct cas_bd_lat_hist __percpu *lat_hist;
+		/*< Latency histograms, NULL if not collected */
+
+	struct cas_bd_stage_hist __percpu *stage_hist;
+		/*< Stage latency histograms of exported object requests,
+		 *  NULL if not collected */
+
+	bool read_lat_track;
+		/*< Average latency of data reads is tracked */
+
+	uint32_t atomic_write_min;
+	uint32_t atomic_write_max;
+		/*< Atomic write unit limits of device [bytes], 0 if device
+		 *  does not guarantee untorn writes */
+
+	uint64_t atomic_meta_end;
+		/*< Writes below this offset, i.e. of cache metadata, fitting
+		 *  atomic write unit are sent as atomic */
+
+	uint64_t read_lat;
+		/*< Moving average of data read latency [ns], 0 if not known */
+
+	struct cas_bd_meta_co __rcu *meta_co;
+		/*< Coalescing of metadata writes, NULL if not enabled */
+
+	struct xarray meta_hash;
+		/*< Chunks of hashes of pages as last read from or written to
+		 *  device, 0 if not known */
+
+	uint64_t meta_hash_end;
+		/*< End of range whose page hashes are kept, 0 if none */
+
+	atomic64_t meta_elided;
+		/*< Writes of unchanged metadata pages left out */
+
+	struct cas_bd_heatmap __percpu *heatmap;
+		/*< LBA access counters of core, NULL if not collected */
+
+	uint32_t heatmap_shift;
+		/*< Log2 of heatmap bucket size in sectors */
+
+	struct cas_mrc *mrc;
+		/*< Miss ratio curve estimator of core, NULL if not collected */
+
+	struct cas_bd_inflight __percpu *inflight;
+		/*< Inflight requests of core, NULL if not tracked */
+
+	uint32_t mrc_line_shift;
+		/*< Log2 of cache line size in sectors */
+
+	struct cas_hot_set *hot_set;
+		/*< Most accessed regions of core, NULL if not tracked */
+
+	struct cas_io_trace *io_trace;
+		/*< Trace of requests of core, NULL if not captured */
+
+	struct cas_read_ahead *read_ahead;
+		/*< Read-ahead of sequential streams of core, exists along with
+		 *  exported object */
+
+	struct cas_seq_cutoff *seq_cutoff;
+		/*< Streams of io classes with sequential cutoff override */
+
+	struct cas_dirty_throttle *dirty_throttle;
+		/*< Throttling of writes of core by its dirty data */
+
+	struct cas_qos *qos;
+		/*< Requests and bandwidth limits of core and its io classes */
+
+	spinlock_t discard_lock;
+		/*< Lock protecting list of gathered discards */
+
+	struct list_head discard_pending;
+		/*< Discards waiting for merge, sorted by start sector */
+
+	struct delayed_work discard_work;
+		/*< Work submitting gathered discards */
+
+	spinlock_t nowait_retry_lock;
+		/*< Lock protecting list of bios to be resubmitted */
+
+	struct bio_list nowait_retry_bios;
+		/*< Non-blocking bios rejected by bottom device */
+
+	struct work_struct nowait_retry_work;
+		/*< Work resubmitting rejected bios in blocking mode */
+
 	uint32_t expobj_valid : 1;
 		/*!< Bit indicates that exported object was created */
 
@@ -26,11 +422,54 @@ struct bd_object {
 	uint32_t opened_by_bdev : 1;
 		/*!< Opened by supplying bdev manually */
 
+	uint32_t meta_elide : 1;
+		/*!< Set before open of cache device to leave out writes of
+		 *   unchanged metadata pages */
+
 	struct workqueue_struct *expobj_wq;
 		/*< Workqueue for I/O handled by top vol */
 
+	struct cas_reserve_pool *expobj_defer_pool;
+		/*< Per-CPU pool of contexts for bios deferred to expobj_wq */
+
+	spinlock_t expobj_defer_lock;
+		/*< Lock protecting lists of bios deferred on pool exhaustion */
+
+	struct bio_list expobj_defer_bios;
+		/*< Bios to be handled from the beginning */
+
+	struct bio_list expobj_defer_noflush_bios;
+		/*< Bios to be handled after flush has been completed */
+
+	struct work_struct expobj_defer_work;
+		/*< Work handling bios deferred on pool exhaustion */
+
+	spinlock_t expobj_flush_lock;
+		/*< Lock protecting flush coalescing state */
+
+	bool expobj_flush_in_progress;
+		/*< Flush of cache/core front volume is in progress */
+
+	struct bio_list expobj_flush_bios;
+		/*< Flush bios served by flush in progress */
+
+	struct bio_list expobj_flush_pending_bios;
+		/*< Flush bios waiting for next flush */
+
 	ocf_volume_t front_volume;
 		/*< Cache/core front volume */
+
+	uint32_t expobj_split_sectors;
+		/*< Max size of single I/O submitted to OCF for large bios */
+
+	uint32_t expobj_split_align_sectors;
+		/*< Alignment of split boundaries for large bios */
+
+	uint32_t expobj_read_split_sectors;
+		/*< Max size of single read submitted to OCF */
+
+	uint32_t expobj_read_split_align_sectors;
+		/*< Alignment of split boundaries for reads */
 };
 
 static inline struct bd_object *bd_object(ocf_volume_t vol)
@@ -38,4 +477,11 @@ static inline struct bd_object *bd_object(ocf_volume_t vol)
 	return ocf_volume_get_priv(vol);
 }
 
+static inline uint32_t cas_bd_heatmap_bucket(struct bd_object *bdobj,
+		sector_t sector)
+{
+	return min_t(sector_t, sector >> bdobj->heatmap_shift,
+			KCAS_HEATMAP_BUCKETS - 1);
+}
+
 #endif /* __OBJ_BLK_H__ */
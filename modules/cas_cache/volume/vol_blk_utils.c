@@ -6,6 +6,13 @@
 
 #include "vol_blk_utils.h"
 
+/* Vector item may span multiple pages when backed by compound page */
+static inline void cas_io_iter_check(struct bio_vec_iter *iter)
+{
+	BUG_ON(iter->offset + iter->len >
+			iter->ivec->bv_offset + iter->ivec->bv_len);
+}
+
 static void cas_io_iter_advanced(struct bio_vec_iter *iter, uint32_t bytes)
 {
 	BUG_ON(bytes > iter->len);
@@ -40,12 +47,12 @@ uint32_t cas_io_iter_cpy(struct bio_vec_iter *dst, struct bio_vec_iter *src,
 	if (dst->idx >= dst->vec_size)
 		return 0;
 
-	BUG_ON(dst->offset + dst->len > PAGE_SIZE);
+	cas_io_iter_check(dst);
 
 	if (src->idx >= src->vec_size)
 		return 0;
 
-	BUG_ON(src->offset + src->len > PAGE_SIZE);
+	cas_io_iter_check(src);
 
 	while (bytes) {
 		to_copy = min(dst->len, src->len);
@@ -80,7 +87,7 @@ uint32_t cas_io_iter_cpy_from_data(struct bio_vec_iter *dst,
 	if (dst->idx >= dst->vec_size)
 		return 0;
 
-	BUG_ON(dst->offset + dst->len > PAGE_SIZE);
+	cas_io_iter_check(dst);
 
 	while (bytes) {
 		to_copy = min(dst->len, bytes);
@@ -114,7 +121,7 @@ uint32_t cas_io_iter_cpy_to_data(void *dst, struct bio_vec_iter *src,
 	if (src->idx >= src->vec_size)
 		return 0;
 
-	BUG_ON(src->offset + src->len > PAGE_SIZE);
+	cas_io_iter_check(src);
 
 	while (bytes) {
 		to_copy = min(bytes, src->len);
@@ -144,7 +151,7 @@ uint32_t cas_io_iter_move(struct bio_vec_iter *iter, uint32_t bytes)
 	if (iter->idx >= iter->vec_size)
 		return 0;
 
-	BUG_ON(iter->offset + iter->len > PAGE_SIZE);
+	cas_io_iter_check(iter);
 
 	while (bytes) {
 		to_move = min(iter->len, bytes);
@@ -170,7 +177,7 @@ uint32_t cas_io_iter_zero(struct bio_vec_iter *dst, uint32_t bytes)
 	if (dst->idx >= dst->vec_size)
 		return 0;
 
-	BUG_ON(dst->offset + dst->len > PAGE_SIZE);
+	cas_io_iter_check(dst);
 
 	while (bytes) {
 		to_fill = min(dst->len, (typeof(dst->len))PAGE_SIZE);
@@ -242,7 +249,101 @@ static int _cas_blk_identify_type(const char *path, uint8_t *type)
 	return 0;
 }
 
+/* Each member of volume consisting of multiple devices is block device */
+static int _cas_blk_identify_members(const char *path, const char *separator,
+		uint32_t max_count)
+{
+	char *paths, *cursor, *member;
+	uint32_t count = 0;
+	uint8_t type;
+	int result = 0;
+
+	paths = kstrdup(path, GFP_KERNEL);
+	if (!paths)
+		return -OCF_ERR_NO_MEM;
+
+	cursor = paths;
+	while ((member = strsep(&cursor, separator))) {
+		if (++count > max_count) {
+			result = -OCF_ERR_INVAL_VOLUME_TYPE;
+			break;
+		}
+
+		result = _cas_blk_identify_type(member, &type);
+		if (result)
+			break;
+	}
+	kfree(paths);
+
+	return result;
+}
+
+uint8_t cas_blk_path_prefix_type(const char *path)
+{
+	if (!strncmp(path, CAS_BD_NULL_PREFIX, strlen(CAS_BD_NULL_PREFIX)))
+		return NULL_DEVICE_VOLUME;
+	if (!strncmp(path, CAS_BD_RAM_PREFIX, strlen(CAS_BD_RAM_PREFIX)))
+		return RAM_DEVICE_VOLUME;
+	return 0;
+}
+
+const char *cas_blk_device_path(const char *path)
+{
+	switch (cas_blk_path_prefix_type(path)) {
+	case NULL_DEVICE_VOLUME:
+		return path + strlen(CAS_BD_NULL_PREFIX);
+	case RAM_DEVICE_VOLUME:
+		return path + strlen(CAS_BD_RAM_PREFIX);
+	default:
+		return path;
+	}
+}
+
 int cas_blk_identify_type(const char *path, uint8_t *type)
 {
+	int result;
+
+	/* Prefixed path names single block device, never members */
+	if (cas_blk_path_prefix_type(path)) {
+		result = _cas_blk_identify_type(cas_blk_device_path(path),
+				type);
+		if (!result)
+			*type = cas_blk_path_prefix_type(path);
+		return result;
+	}
+
+	if (strstr(path, CAS_BD_MEMBERS_SEPARATOR)) {
+		result = _cas_blk_identify_members(path,
+				CAS_BD_MEMBERS_SEPARATOR, CAS_BD_MEMBERS_MAX);
+		if (!result)
+			*type = STRIPED_DEVICE_VOLUME;
+		return result;
+	}
+
+	if (strstr(path, CAS_BD_MIRROR_SEPARATOR)) {
+		result = _cas_blk_identify_members(path,
+				CAS_BD_MIRROR_SEPARATOR, CAS_BD_MIRROR_MEMBERS);
+		if (!result)
+			*type = MIRRORED_DEVICE_VOLUME;
+		return result;
+	}
+
 	return _cas_blk_identify_type(path, type);
 }
+
+bool cas_blk_dax_supported(const char *path)
+{
+	cas_bdev_handle_t bdev_handle;
+	bool supported;
+
+	bdev_handle = cas_bdev_open_by_path(path, CAS_BLK_MODE_READ, NULL);
+	if (IS_ERR(bdev_handle))
+		return false;
+
+	supported = block_dev_dax_supported(
+			cas_bdev_get_from_handle(bdev_handle));
+
+	cas_bdev_release(bdev_handle, CAS_BLK_MODE_READ, NULL);
+
+	return supported;
+}
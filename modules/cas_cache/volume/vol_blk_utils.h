@@ -16,6 +16,22 @@ void cas_blk_close_volume(ocf_volume_t vol);
 
 int cas_blk_identify_type(const char *path, uint8_t *type);
 
+/* Block device at path may be used as DAX cache volume */
+bool cas_blk_dax_supported(const char *path);
+
+/* Path lists members of striped or mirrored volume */
+static inline bool cas_blk_is_multi_device_path(const char *path)
+{
+	return strstr(path, CAS_BD_MEMBERS_SEPARATOR) ||
+			strstr(path, CAS_BD_MIRROR_SEPARATOR);
+}
+
+/* Volume type selected by prefix of path, 0 if path has no prefix */
+uint8_t cas_blk_path_prefix_type(const char *path);
+
+/* Path of block device underlying volume, i.e. without prefix */
+const char *cas_blk_device_path(const char *path);
+
 static inline void cas_io_iter_init(struct bio_vec_iter *iter,
 		struct bio_vec *vec, uint32_t vec_size)
 {
@@ -5,10 +5,20 @@
 */
 
 #include <linux/blkdev.h>
+#include <linux/irq_work.h>
 #include "cas_cache.h"
+#include "cas_trace.h"
 
 #define CAS_DEBUG_IO 0
 
+extern u32 discard_merge_window_us;
+extern u32 discard_write_zeroes;
+extern u32 nowait_submission;
+extern u32 batch_completions;
+extern u32 latency_histograms;
+extern u32 null_volume_zero_fill;
+extern u32 compressed_cache_volume;
+
 #if CAS_DEBUG_IO == 1
 #define CAS_DEBUG_TRACE() printk(KERN_DEBUG \
 		"[IO] %s:%d\n", __func__, __LINE__)
@@ -24,18 +34,238 @@
 #define CAS_DEBUG_PARAM(format, ...)
 #endif
 
+/* Minimal number of bios reserved in bottom device bio set */
+#define CAS_BD_BIO_POOL_MIN 4
+
+/* Rate budget may accumulate up to 1/CAS_BD_RATE_BURST_DIV s of bandwidth */
+#define CAS_BD_RATE_BURST_DIV 10
+
+/* Share of background bandwidth used while foreground I/O is in flight */
+#define CAS_BD_RATE_FOREGROUND_DIV 4
+
+/* Gathered background writes sent without waiting for end of window */
+#define CAS_BD_SWEEP_PENDING_MAX 4096
+
+/*
+ * Completion state of bio submitted to bottom device, placed in front
+ * padding of bio allocated from bd_object bio set.
+ */
+struct cas_bd_bio {
+	struct bd_object *bdobj;
+	ocf_forward_token_t token;
+	uint64_t flush_gen;
+	int io_class;
+	int error;
+	uint64_t lat_start;
+	int member; /* Member of mirrored volume, -1 if mapped by address */
+	int mirror_epoch; /* Epoch write is counted in, -1 if not counted */
+	int zone; /* Zone of zoned device write is sent to, -1 if not tracked */
+	uint64_t mirror_addr; /* Range of read of mirrored volume, retried */
+	uint64_t mirror_offset; /* on the other member if it fails */
+	uint64_t mirror_bytes;
+	struct block_device *nowait_bd; /* Target and range of nowait bio, */
+	struct bvec_iter nowait_iter; /* restored before it is resubmitted */
+	uint64_t csum_addr; /* Volume address of checksummed bio, or U64_MAX */
+	uint64_t meta_addr; /* Volume address of hashed bio, or U64_MAX */
+	struct llist_node cmpl_node;
+	struct bio bio; /* Must be last */
+};
+
+static inline struct cas_bd_bio *cas_bd_bio(struct bio *bio)
+{
+	return container_of(bio, struct cas_bd_bio, bio);
+}
+
+static inline void cas_bd_submit_bio(struct bd_object *bdobj, int rw,
+		struct bio *bio)
+{
+	trace_cas_bd_submit(bdobj->btm_bd->bd_dev, bio);
+	cas_submit_bio(rw, bio);
+}
+
+static int block_dev_init_bio_set(struct bd_object *bdobj)
+{
+	struct request_queue *q = bdobj->btm_bd->bd_disk->queue;
+	uint32_t max_io_pages, pool_size;
+
+	/* Reserve enough bios to keep single I/O of max size in flight */
+	max_io_pages = (queue_max_sectors(q) << SECTOR_SHIFT) >> PAGE_SHIFT;
+	pool_size = max(DIV_ROUND_UP(max_io_pages, CAS_BIO_MAX_VECS),
+			(uint32_t)CAS_BD_BIO_POOL_MIN);
+
+	bdobj->btm_bio_set = cas_bioset_create(pool_size,
+			offsetof(struct cas_bd_bio, bio));
+	if (!bdobj->btm_bio_set)
+		return -OCF_ERR_NO_MEM;
+
+	return 0;
+}
+
+static void block_dev_discard_work(struct work_struct *work);
+static void block_dev_nowait_retry_work(struct work_struct *work);
+static void block_dev_inflight_work(struct work_struct *work);
+static void block_dev_rate_work(struct work_struct *work);
+static void block_dev_sweep_work(struct work_struct *work);
+static void block_dev_rebuild_work(struct work_struct *work);
+static void block_dev_mirror_label_work(struct work_struct *work);
+static void block_dev_mirror_retry_work(struct work_struct *work);
+static int block_dev_mirror_label_load(struct bd_object *bdobj);
+static int block_dev_mirror_read_member(struct bd_object *bdobj);
+static void _block_dev_forward_member_io(struct bd_object *bdobj,
+		int member, int mirror_epoch, ocf_forward_token_t token,
+		int dir, uint64_t addr, uint64_t bytes, uint64_t offset,
+		int io_class);
+static void block_dev_close_object(ocf_volume_t vol);
+static void _block_dev_forward_flush(struct bd_object *bdobj,
+		ocf_forward_token_t token);
+static void block_dev_zone_work(struct work_struct *work);
+static int block_dev_compress_label(struct bd_object *bdobj, uint32_t ratio);
+static void block_dev_zone_put(struct bd_object *bdobj, uint32_t idx,
+		int error);
+static void block_dev_zone_resync(struct bd_object *bdobj, uint32_t idx);
+static bool block_dev_meta_co_hold(struct bd_object *bdobj,
+		ocf_forward_token_t token, int dir, uint64_t addr,
+		uint64_t bytes, uint64_t offset);
+static bool block_dev_meta_co_hold_flush(struct bd_object *bdobj,
+		ocf_forward_token_t token);
+
+static int block_dev_init_object(struct bd_object *bdobj)
+{
+	int result, i;
+
+	spin_lock_init(&bdobj->discard_lock);
+	INIT_LIST_HEAD(&bdobj->discard_pending);
+	INIT_DELAYED_WORK(&bdobj->discard_work, block_dev_discard_work);
+
+	spin_lock_init(&bdobj->nowait_retry_lock);
+	bio_list_init(&bdobj->nowait_retry_bios);
+	INIT_WORK(&bdobj->nowait_retry_work, block_dev_nowait_retry_work);
+
+	spin_lock_init(&bdobj->inflight_lock);
+	for (i = 0; i < CAS_BD_IO_CLASS_MAX; i++) {
+		bdobj->inflight_limit[i] = 0;
+		atomic_set(&bdobj->inflight[i], 0);
+		INIT_LIST_HEAD(&bdobj->inflight_waiting[i]);
+	}
+	INIT_WORK(&bdobj->inflight_work, block_dev_inflight_work);
+
+	bdobj->rate_limit = 0;
+	bdobj->rate_budget = 0;
+	bdobj->rate_stamp = jiffies;
+	INIT_DELAYED_WORK(&bdobj->rate_work, block_dev_rate_work);
+
+	bdobj->sweep_window_us = 0;
+	bdobj->sweep_pending = RB_ROOT;
+	bdobj->sweep_count = 0;
+	bdobj->sweep_ready = false;
+	bdobj->sweep_pos = 0;
+	INIT_DELAYED_WORK(&bdobj->sweep_work, block_dev_sweep_work);
+
+	for (i = 0; i < CAS_BD_MEMBERS_MAX; i++)
+		atomic_set(&bdobj->member_reads[i], 0);
+	atomic_set(&bdobj->mirror_writes[0], 0);
+	atomic_set(&bdobj->mirror_writes[1], 0);
+	bdobj->mirror_epoch = 0;
+	init_waitqueue_head(&bdobj->mirror_wait);
+	spin_lock_init(&bdobj->mirror_lock);
+	bdobj->rebuild_fencing = false;
+	INIT_LIST_HEAD(&bdobj->rebuild_held);
+	bdobj->rebuild_pos = 0;
+	bdobj->rebuild_length = 0;
+	bdobj->rebuild_running = false;
+	bdobj->rebuild_stop = false;
+	INIT_WORK(&bdobj->rebuild_work, block_dev_rebuild_work);
+	bdobj->mirror_seq = 0;
+	bdobj->mirror_seq_done = 0;
+	init_llist_head(&bdobj->mirror_label_held);
+	INIT_WORK(&bdobj->mirror_label_work, block_dev_mirror_label_work);
+	INIT_LIST_HEAD(&bdobj->mirror_retry);
+	INIT_WORK(&bdobj->mirror_retry_work, block_dev_mirror_retry_work);
+
+	bdobj->zones = NULL;
+	spin_lock_init(&bdobj->zone_lock);
+	INIT_LIST_HEAD(&bdobj->zone_pending);
+	INIT_DELAYED_WORK(&bdobj->zone_work, block_dev_zone_work);
+	init_waitqueue_head(&bdobj->zone_wait);
+
+	RCU_INIT_POINTER(bdobj->csum, NULL);
+	atomic64_set(&bdobj->csum_errors, 0);
+
+	RCU_INIT_POINTER(bdobj->trim_written, NULL);
+	spin_lock_init(&bdobj->trim_lock);
+	bdobj->trim_fencing = false;
+	INIT_LIST_HEAD(&bdobj->trim_held);
+
+	/* Nothing is known about device cache state, so first flush is sent */
+	atomic64_set(&bdobj->write_gen, 1);
+	atomic64_set(&bdobj->flushed_gen, 0);
+	atomic64_set(&bdobj->flushes_elided, 0);
+
+	/* Set up by open of particular volume type once object is initialized */
+	bdobj->dax_dev = NULL;
+	bdobj->null_dev = false;
+	bdobj->ram_pages = NULL;
+	bdobj->comp = NULL;
+
+	/* Allocated with exported object, as only cores have heatmaps */
+	bdobj->heatmap = NULL;
+	bdobj->stage_hist = NULL;
+	bdobj->mrc = NULL;
+	bdobj->hot_set = NULL;
+	bdobj->io_trace = NULL;
+	bdobj->read_ahead = NULL;
+	bdobj->seq_cutoff = NULL;
+	bdobj->dirty_throttle = NULL;
+	bdobj->qos = NULL;
+	bdobj->inflight = NULL;
+
+	bdobj->read_lat_track = false;
+	bdobj->read_lat = 0;
+
+	RCU_INIT_POINTER(bdobj->meta_co, NULL);
+	/* Tracked in whole until cache tells where metadata ends */
+	xa_init_flags(&bdobj->meta_hash, XA_FLAGS_LOCK_IRQ);
+	bdobj->meta_hash_end = bdobj->meta_elide ? U64_MAX : 0;
+	atomic64_set(&bdobj->meta_elided, 0);
+
+	/* Set by block device volumes, other types may split writes */
+	bdobj->atomic_write_min = 0;
+	bdobj->atomic_write_max = 0;
+	bdobj->atomic_meta_end = 0;
+
+	bdobj->lat_hist = NULL;
+	if (latency_histograms) {
+		bdobj->lat_hist = alloc_percpu(struct cas_bd_lat_hist);
+		if (!bdobj->lat_hist)
+			return -OCF_ERR_NO_MEM;
+	}
+
+	result = block_dev_init_bio_set(bdobj);
+	if (result) {
+		free_percpu(bdobj->lat_hist);
+		bdobj->lat_hist = NULL;
+	}
+
+	return result;
+}
+
 static int block_dev_open_object(ocf_volume_t vol, void *volume_params)
 {
 	struct bd_object *bdobj = bd_object(vol);
 	const struct ocf_volume_uuid *uuid = ocf_volume_get_uuid(vol);
 	struct cas_disk *dsk;
+	int result;
 
 	if (bdobj->opened_by_bdev) {
-		/* Bdev has been set manually, so there is nothing to do. */
-		return 0;
+		/* Bdev has been set manually, so there is nothing to open. */
+		bdobj->members_count = 1;
+		bdobj->member_dsk[0] = NULL;
+		bdobj->member_bd[0] = bdobj->btm_bd;
+		bdobj->mirrored = false;
+		return block_dev_init_object(bdobj);
 	}
 
-	dsk = cas_disk_open(uuid->data);
+	dsk = cas_disk_open(cas_blk_device_path(uuid->data));
 	if (IS_ERR_OR_NULL(dsk)) {
 		int error = PTR_ERR(dsk) ?: -EINVAL;
 
@@ -47,342 +277,5122 @@ static int block_dev_open_object(ocf_volume_t vol, void *volume_params)
 
 	bdobj->dsk = dsk;
 	bdobj->btm_bd = cas_disk_get_blkdev(dsk);
+	bdobj->members_count = 1;
+	bdobj->member_dsk[0] = dsk;
+	bdobj->member_bd[0] = bdobj->btm_bd;
+	bdobj->mirrored = false;
 
-	return 0;
+	result = block_dev_init_object(bdobj);
+	if (result)
+		cas_disk_close(dsk);
+
+	return result;
 }
 
-static void block_dev_close_object(ocf_volume_t vol)
+/*
+ * Cache device backed by persistent memory is accessed by CPU loads and
+ * stores through its DAX device, while flush and discard still go to block
+ * device of the same namespace.
+ */
+static int block_dev_open_dax_object(ocf_volume_t vol, void *volume_params)
 {
 	struct bd_object *bdobj = bd_object(vol);
+	int result;
 
-	if (bdobj->opened_by_bdev)
-		return;
+	result = block_dev_open_object(vol, volume_params);
+	if (result)
+		return result;
+
+	bdobj->dax_dev = cas_dax_get_by_bdev(bdobj->btm_bd,
+			&bdobj->dax_offset);
+	if (!bdobj->dax_dev) {
+		block_dev_close_object(vol);
+		return -OCF_ERR_INVAL_VOLUME_TYPE;
+	}
 
-	cas_disk_close(bdobj->dsk);
+	return 0;
 }
 
-static unsigned int block_dev_get_max_io_size(ocf_volume_t vol)
+/*
+ * Path of volume consisting of multiple devices is list of paths of members
+ * separated by @separator. The first member stands for the whole volume
+ * wherever properties of single device are needed.
+ */
+static int block_dev_open_members(ocf_volume_t vol, const char *separator,
+		uint32_t min_count, uint32_t max_count)
 {
 	struct bd_object *bdobj = bd_object(vol);
-	struct block_device *bd = bdobj->btm_bd;
+	const struct ocf_volume_uuid *uuid = ocf_volume_get_uuid(vol);
+	char *paths, *cursor, *path;
+	struct cas_disk *dsk;
+	uint32_t count = 0;
+	int result = 0;
 
-	return queue_max_sectors(bd->bd_disk->queue) << SECTOR_SHIFT;
-}
+	paths = kstrndup(uuid->data, uuid->size, GFP_KERNEL);
+	if (!paths)
+		return -OCF_ERR_NO_MEM;
 
-static uint64_t block_dev_get_byte_length(ocf_volume_t vol)
-{
-	struct bd_object *bdobj = bd_object(vol);
-	struct block_device *bd = bdobj->btm_bd;
-	uint64_t sector_length;
+	cursor = paths;
+	while ((path = strsep(&cursor, separator))) {
+		if (count == max_count) {
+			result = -OCF_ERR_INVAL;
+			break;
+		}
 
-	sector_length = (cas_bdev_whole(bd) == bd) ?
-			get_capacity(bd->bd_disk) :
-			cas_bdev_nr_sectors(bd);
+		dsk = cas_disk_open(path);
+		if (IS_ERR_OR_NULL(dsk)) {
+			result = PTR_ERR(dsk) ?: -EINVAL;
+			if (result == -EBUSY)
+				result = -OCF_ERR_NOT_OPEN_EXC;
+			break;
+		}
 
-	return sector_length << SECTOR_SHIFT;
-}
+		bdobj->member_dsk[count] = dsk;
+		bdobj->member_bd[count] = cas_disk_get_blkdev(dsk);
+		count++;
+	}
+	kfree(paths);
 
-/*
- *
- */
-static inline struct bio *cas_bd_io_alloc_bio(struct block_device *bdev, 
-					      struct bio_vec_iter *iter)
-{
-	struct bio *bio
-		= cas_bio_alloc(bdev, GFP_NOIO, cas_io_iter_size_left(iter));
+	if (!result && count < min_count)
+		result = -OCF_ERR_INVAL;
 
-	if (bio)
-		return bio;
+	if (!result) {
+		bdobj->members_count = count;
+		bdobj->dsk = bdobj->member_dsk[0];
+		bdobj->btm_bd = bdobj->member_bd[0];
+		result = block_dev_init_object(bdobj);
+	}
 
-	if (cas_io_iter_size_left(iter) < MAX_LINES_PER_IO) {
-		/* BIO vector was small, so it was memory
-		 * common problem - NO RAM!!!
-		 */
-		return NULL;
+	if (result) {
+		while (count--)
+			cas_disk_close(bdobj->member_dsk[count]);
 	}
 
-	/* Retry with smaller */
-	return cas_bio_alloc(bdev, GFP_NOIO, MAX_LINES_PER_IO);
+	return result;
 }
 
-/*
- * Returns only flags that are relevant to request's direction.
- */
-static inline uint64_t filter_req_flags(int dir, uint64_t flags)
+static int block_dev_open_striped_object(ocf_volume_t vol, void *volume_params)
 {
-	/* Remove REQ_RAHEAD flag from write request to cache which are a
-	   result of a missed read-head request. This flag caused the nvme
-	   driver to send write command with access frequency value that is
-	   reserved */
-	if (dir == WRITE)
-		flags &= ~REQ_RAHEAD;
+	bd_object(vol)->mirrored = false;
 
-	return flags;
+	return block_dev_open_members(vol, CAS_BD_MEMBERS_SEPARATOR, 2,
+			CAS_BD_MEMBERS_MAX);
 }
 
-/*
- *
- */
-CAS_DECLARE_BLOCK_CALLBACK(cas_bd_forward_end, struct bio *bio,
-		unsigned int bytes_done, int error)
+/* States of members are restored from labels of members */
+static int block_dev_open_mirrored_object(ocf_volume_t vol, void *volume_params)
 {
-	ocf_forward_token_t token;
-	int err;
-
-	CAS_BLOCK_CALLBACK_INIT(bio);
-	token = (ocf_forward_token_t)bio->bi_private;
-	err = CAS_BLOCK_CALLBACK_ERROR(bio, error);
+	struct bd_object *bdobj = bd_object(vol);
+	int result, i;
 
-	CAS_DEBUG_TRACE();
+	bdobj->mirrored = true;
+	for (i = 0; i < CAS_BD_MIRROR_MEMBERS; i++)
+		bdobj->member_state[i] = KCAS_MIRROR_MEMBER_ACTIVE;
 
-	if (err == -EOPNOTSUPP && (CAS_BIO_OP_FLAGS(bio) & CAS_BIO_DISCARD))
-		err = 0;
+	result = block_dev_open_members(vol, CAS_BD_MIRROR_SEPARATOR,
+			CAS_BD_MIRROR_MEMBERS, CAS_BD_MIRROR_MEMBERS);
+	if (result)
+		return result;
 
-	ocf_forward_end(token, err);
+	result = block_dev_mirror_label_load(bdobj);
+	if (result)
+		block_dev_close_object(vol);
 
-	bio_put(bio);
-	CAS_BLOCK_CALLBACK_RETURN();
+	return result;
 }
 
-
-static void block_dev_forward_io(ocf_volume_t volume,
-		ocf_forward_token_t token, int dir, uint64_t addr,
-		uint64_t bytes, uint64_t offset)
+static void block_dev_close_object(ocf_volume_t vol)
 {
-	struct bd_object *bdobj = bd_object(volume);
-	struct blk_data *data = ocf_forward_get_data(token);
-	uint64_t flags = ocf_forward_get_flags(token);
-	int bio_dir = (dir == OCF_READ) ? READ : WRITE;
-	struct bio_vec_iter iter;
-	struct blk_plug plug;
-	int error = 0;
+	struct bd_object *bdobj = bd_object(vol);
+	unsigned long chunk_idx;
+	uint64_t *chunk;
+	uint64_t idx;
+	int i;
 
-	CAS_DEBUG_PARAM("Address = %llu, bytes = %u\n", addr, bytes);
+	WRITE_ONCE(bdobj->rebuild_stop, true);
+	flush_work(&bdobj->rebuild_work);
+	flush_work(&bdobj->mirror_label_work);
+	flush_work(&bdobj->mirror_retry_work);
 
-	cas_io_iter_init(&iter, data->vec, data->size);
-	if (offset != cas_io_iter_move(&iter, offset)) {
-		ocf_forward_end(token, -OCF_ERR_INVAL);
-		return;
-	}
+	/* Buffered metadata is written back before volume goes away */
+	block_dev_meta_co_stop(vol);
 
-	blk_start_plug(&plug);
-	while (cas_io_iter_is_next(&iter) && bytes) {
-		/* Still IO vectors to be sent */
+	/* Submit discards still waiting for merge window */
+	flush_delayed_work(&bdobj->discard_work);
+	flush_work(&bdobj->nowait_retry_work);
+	cancel_delayed_work_sync(&bdobj->rate_work);
+	cancel_delayed_work_sync(&bdobj->sweep_work);
+	flush_work(&bdobj->inflight_work);
 
-		/* Allocate BIO */
-		struct bio *bio = cas_bd_io_alloc_bio(bdobj->btm_bd, &iter);
+	cas_bioset_destroy(bdobj->btm_bio_set);
+	bdobj->btm_bio_set = NULL;
 
-		if (!bio) {
-			error = -ENOMEM;
-			break;
-		}
+	free_percpu(bdobj->lat_hist);
+	bdobj->lat_hist = NULL;
 
-		/* Setup BIO */
-		CAS_BIO_SET_DEV(bio, bdobj->btm_bd);
-		CAS_BIO_BISECTOR(bio) = addr / SECTOR_SIZE;
-		bio->bi_next = NULL;
-		bio->bi_private = (void *)token;
-		CAS_BIO_OP_FLAGS(bio) |= filter_req_flags(bio_dir, flags);
-		bio->bi_end_io = CAS_REFER_BLOCK_CALLBACK(cas_bd_forward_end);
+	free_percpu(bdobj->heatmap);
+	bdobj->heatmap = NULL;
 
-		/* Add pages */
-		while (cas_io_iter_is_next(&iter) && bytes) {
-			struct page *page = cas_io_iter_current_page(&iter);
-			uint32_t offset = cas_io_iter_current_offset(&iter);
-			uint32_t length = cas_io_iter_current_length(&iter);
-			int added;
+	free_percpu(bdobj->stage_hist);
+	bdobj->stage_hist = NULL;
 
-			if (length > bytes)
-				length = bytes;
+	if (bdobj->mrc)
+		cas_mrc_destroy(bdobj->mrc);
+	bdobj->mrc = NULL;
 
-			added = bio_add_page(bio, page, length, offset);
-			BUG_ON(added < 0);
+	if (bdobj->hot_set)
+		cas_hot_set_destroy(bdobj->hot_set);
+	bdobj->hot_set = NULL;
 
-			if (added == 0) {
-				/* No more space in BIO, stop adding pages */
-				break;
-			}
+	if (bdobj->io_trace)
+		cas_io_trace_destroy(bdobj->io_trace);
+	bdobj->io_trace = NULL;
 
-			/* Update address, bytes sent */
-			bytes -= added;
-			addr += added;
+	if (bdobj->seq_cutoff)
+		cas_seq_cutoff_destroy(bdobj->seq_cutoff);
+	bdobj->seq_cutoff = NULL;
 
-			/* Update BIO vector iterator */
-			if (added != cas_io_iter_move(&iter, added)) {
-				error = -ENOBUFS;
-				break;
-			}
-		}
+	if (bdobj->dirty_throttle)
+		cas_dirty_throttle_destroy(bdobj->dirty_throttle);
+	bdobj->dirty_throttle = NULL;
 
-		if (error == 0) {
-			/* Increase IO reference for sending this IO */
+	if (bdobj->qos)
+		cas_qos_destroy(bdobj->qos);
+	bdobj->qos = NULL;
 
-			ocf_forward_get(token);
-			/* Send BIO */
-			CAS_DEBUG_MSG("Submit IO");
-			cas_submit_bio(bio_dir, bio);
-			bio = NULL;
-		} else {
-			if (bio) {
-				bio_put(bio);
-				bio = NULL;
-			}
+	/* Left only if creating exported object failed */
+	if (bdobj->read_ahead)
+		cas_read_ahead_destroy(bdobj->read_ahead);
+	bdobj->read_ahead = NULL;
 
-			/* ERROR, stop processed */
-			break;
+	free_percpu(bdobj->inflight);
+	bdobj->inflight = NULL;
+
+	if (bdobj->dax_dev)
+		cas_dax_put(bdobj->dax_dev);
+	bdobj->dax_dev = NULL;
+
+	cancel_delayed_work_sync(&bdobj->zone_work);
+	vfree(bdobj->zones);
+	bdobj->zones = NULL;
+
+	if (bdobj->ram_pages) {
+		for (idx = 0; idx < bdobj->ram_pages_count; idx++) {
+			if (bdobj->ram_pages[idx])
+				__free_page(bdobj->ram_pages[idx]);
 		}
+		vfree(bdobj->ram_pages);
 	}
-	blk_finish_plug(&plug);
+	bdobj->ram_pages = NULL;
 
-	if (bytes && error == 0) {
-		/* Not all bytes sent, mark error */
-		error = -ENOBUFS;
-	}
+	if (bdobj->comp)
+		cas_compress_destroy(bdobj->comp);
+	bdobj->comp = NULL;
 
-	/* Prevent races of completing IO when
-	 * there are still child IOs not being send.
-	 */
-	ocf_forward_end(token, error);
+	/* No I/O is in flight anymore */
+	vfree(rcu_access_pointer(bdobj->csum));
+	RCU_INIT_POINTER(bdobj->csum, NULL);
+
+	xa_for_each(&bdobj->meta_hash, chunk_idx, chunk)
+		free_page((unsigned long)chunk);
+	xa_destroy(&bdobj->meta_hash);
+
+	if (bdobj->opened_by_bdev)
+		return;
+
+	for (i = 0; i < bdobj->members_count; i++)
+		cas_disk_close(bdobj->member_dsk[i]);
 }
 
-static void block_dev_forward_flush(ocf_volume_t volume,
-		ocf_forward_token_t token)
+static unsigned int block_dev_get_max_io_size(ocf_volume_t vol)
 {
-	struct bd_object *bdobj = bd_object(volume);
-	struct request_queue *q = bdev_get_queue(bdobj->btm_bd);
-	struct bio *bio;
+	struct bd_object *bdobj = bd_object(vol);
+	unsigned int max_io_size = UINT_MAX;
+	struct block_device *bd;
+	int i;
 
-	if (!q) {
-		/* No queue, error */
-		ocf_forward_end(token, -OCF_ERR_INVAL);
-		return;
+	for (i = 0; i < bdobj->members_count; i++) {
+		bd = bdobj->member_bd[i];
+		max_io_size = min(max_io_size,
+				queue_max_sectors(bd->bd_disk->queue) <<
+				SECTOR_SHIFT);
 	}
 
-	if (!CAS_CHECK_QUEUE_FLUSH(q)) {
-		/* This block device does not support flush, call back */
-		ocf_forward_end(token, 0);
-		return;
-	}
+	return max_io_size;
+}
 
-	bio = cas_bio_alloc(bdobj->btm_bd, GFP_NOIO, 0);
-	if (!bio) {
-		CAS_PRINT_RL(KERN_ERR "Couldn't allocate memory for BIO\n");
-		ocf_forward_end(token, -OCF_ERR_NO_MEM);
-		return;
-	}
+static uint64_t block_dev_bdev_length(struct block_device *bd)
+{
+	uint64_t sector_length;
 
-	CAS_BIO_SET_DEV(bio, bdobj->btm_bd);
-	bio->bi_private = (void *)token;
-	bio->bi_end_io = CAS_REFER_BLOCK_CALLBACK(cas_bd_forward_end);
+	sector_length = (cas_bdev_whole(bd) == bd) ?
+			get_capacity(bd->bd_disk) :
+			cas_bdev_nr_sectors(bd);
 
-	cas_submit_bio(CAS_SET_FLUSH(WRITE), bio);
+	return sector_length << SECTOR_SHIFT;
+}
 
+static uint64_t block_dev_get_byte_length(ocf_volume_t vol)
+{
+	return block_dev_bdev_length(bd_object(vol)->btm_bd);
 }
 
-static void block_dev_forward_discard(ocf_volume_t volume,
-		ocf_forward_token_t token, uint64_t addr, uint64_t bytes)
+static inline uint64_t block_dev_zone_start(struct bd_object *bdobj,
+		uint32_t idx)
 {
-	struct bd_object *bdobj = bd_object(volume);
-	struct request_queue *q = bdev_get_queue(bdobj->btm_bd);
-	struct bio *bio;
-	int error = 0;
+	return (uint64_t)idx << bdobj->zone_shift;
+}
 
-	unsigned int max_discard_sectors, granularity, bio_sects;
-	int alignment;
-	sector_t sects, start, end, tmp;
+#ifdef CAS_ZONED
+static int block_dev_zone_report_cb(struct blk_zone *blk_zone,
+		unsigned int idx, void *data)
+{
+	struct bd_object *bdobj = data;
+	uint64_t start = blk_zone->start << SECTOR_SHIFT;
+	struct cas_bd_zone *zone;
+	unsigned long flags;
+	uint64_t wp;
 
-	if (!q) {
-		/* No queue, error */
-		ocf_forward_end(token, -OCF_ERR_INVAL);
-		return;
-	}
+	idx = start >> bdobj->zone_shift;
+	if (idx >= bdobj->nr_zones)
+		return -EINVAL;
 
-	if (!cas_has_discard_support(bdobj->btm_bd)) {
-		/* Discard is not supported by bottom device, send completion
-		 * to caller
-		 */
-		ocf_forward_end(token, 0);
-		return;
-	}
+	if (blk_zone->type == BLK_ZONE_TYPE_CONVENTIONAL)
+		wp = U64_MAX;
+	else if (blk_zone->cond == BLK_ZONE_COND_FULL)
+		wp = start + (blk_zone->len << SECTOR_SHIFT);
+	else
+		wp = blk_zone->wp << SECTOR_SHIFT;
 
-	granularity = max(q->limits.discard_granularity >> SECTOR_SHIFT, 1U);
-	alignment = (bdev_discard_alignment(bdobj->btm_bd) >> SECTOR_SHIFT)
-			% granularity;
-	max_discard_sectors =
-		min(q->limits.max_discard_sectors, UINT_MAX >> SECTOR_SHIFT);
-	max_discard_sectors -= max_discard_sectors % granularity;
-	if (unlikely(!max_discard_sectors)) {
-		ocf_forward_end(token, -OCF_ERR_INVAL);
-		return;
-	}
+	zone = &bdobj->zones[idx];
+	spin_lock_irqsave(&bdobj->zone_lock, flags);
+	zone->wp = wp;
+	if (wp != U64_MAX)
+		zone->accepted = max(zone->accepted, wp);
+	zone->resync = false;
+	spin_unlock_irqrestore(&bdobj->zone_lock, flags);
 
-	sects = bytes >> SECTOR_SHIFT;
-	start = addr >> SECTOR_SHIFT;
+	return 0;
+}
 
-	while (sects) {
-		bio = cas_bio_alloc(bdobj->btm_bd, GFP_NOIO, 1);
+/* Called in process context while zone is busy */
+static void block_dev_zone_resync(struct bd_object *bdobj, uint32_t idx)
+{
+	int result;
+
+	result = cas_blkdev_report_zones(bdobj->btm_bd,
+			block_dev_zone_start(bdobj, idx) >> SECTOR_SHIFT, 1,
+			block_dev_zone_report_cb, bdobj);
+	if (result < 0) {
+		CAS_PRINT_RL(KERN_ERR "Cannot read write pointer of zone %u "
+				"of zoned device\n", idx);
+	}
+	WRITE_ONCE(bdobj->zones[idx].resync, false);
+}
+
+static int block_dev_zone_init(struct bd_object *bdobj)
+{
+	struct block_device *bd = bdobj->btm_bd;
+	sector_t zone_sectors = bdev_zone_sectors(bd);
+	uint64_t length = block_dev_bdev_length(bd);
+	struct cas_bd_zone *zones;
+	uint32_t i;
+	int result;
+
+	if (!zone_sectors || !is_power_of_2(zone_sectors))
+		return -OCF_ERR_INVAL_VOLUME_TYPE;
+
+	bdobj->zone_shift = ilog2(zone_sectors) + SECTOR_SHIFT;
+	bdobj->nr_zones = DIV_ROUND_UP_ULL(length, 1ULL << bdobj->zone_shift);
+
+	zones = vzalloc(array_size(bdobj->nr_zones, sizeof(*zones)));
+	if (!zones)
+		return -OCF_ERR_NO_MEM;
+
+	for (i = 0; i < bdobj->nr_zones; i++) {
+		atomic_set(&zones[i].bios, 0);
+		INIT_LIST_HEAD(&zones[i].held);
+		INIT_LIST_HEAD(&zones[i].pending_node);
+	}
+	bdobj->zones = zones;
+
+	result = cas_blkdev_report_zones(bd, 0, bdobj->nr_zones,
+			block_dev_zone_report_cb, bdobj);
+	if (result < 0) {
+		bdobj->zones = NULL;
+		vfree(zones);
+		return result;
+	}
+
+	return 0;
+}
+#else
+static void block_dev_zone_resync(struct bd_object *bdobj, uint32_t idx)
+{
+	WRITE_ONCE(bdobj->zones[idx].resync, false);
+}
+
+static int block_dev_zone_init(struct bd_object *bdobj)
+{
+	return 0;
+}
+#endif
+
+/*
+ * Writes to host-managed zoned device are sequenced per zone, so that the
+ * device can be core of cache absorbing writes in any order
+ */
+static int block_dev_open_blk_object(ocf_volume_t vol, void *volume_params)
+{
+	struct bd_object *bdobj = bd_object(vol);
+	struct request_queue *q;
+	int result;
+
+	result = block_dev_open_object(vol, volume_params);
+	if (result)
+		return result;
+
+	q = bdev_get_queue(bdobj->btm_bd);
+	bdobj->atomic_write_min = CAS_ATOMIC_WRITE_UNIT_MIN(q);
+	bdobj->atomic_write_max = CAS_ATOMIC_WRITE_UNIT_MAX(q);
+
+	if (bdobj->opened_by_bdev || !cas_bdev_is_host_managed(bdobj->btm_bd))
+		return 0;
+
+	result = block_dev_zone_init(bdobj);
+	if (result)
+		block_dev_close_object(vol);
+
+	return result;
+}
+
+/*
+ * Null and RAM-backed volumes keep block device only for its identity, size
+ * and queue limits. Data never reaches it, so that cost of CAS itself can be
+ * measured without device latency.
+ */
+static int block_dev_open_null_object(ocf_volume_t vol, void *volume_params)
+{
+	int result;
+
+	result = block_dev_open_object(vol, volume_params);
+	if (!result)
+		bd_object(vol)->null_dev = true;
+
+	return result;
+}
+
+static int block_dev_open_ram_object(ocf_volume_t vol, void *volume_params)
+{
+	struct bd_object *bdobj = bd_object(vol);
+	uint64_t idx;
+	int result;
+
+	result = block_dev_open_object(vol, volume_params);
+	if (result)
+		return result;
+
+	bdobj->ram_pages_count = DIV_ROUND_UP(
+			block_dev_bdev_length(bdobj->btm_bd), PAGE_SIZE);
+	bdobj->ram_pages = vzalloc(array_size(bdobj->ram_pages_count,
+			sizeof(*bdobj->ram_pages)));
+	if (!bdobj->ram_pages) {
+		block_dev_close_object(vol);
+		return -OCF_ERR_NO_MEM;
+	}
+
+	/* I/O is served in atomic context, so all pages are allocated here */
+	for (idx = 0; idx < bdobj->ram_pages_count; idx++) {
+		bdobj->ram_pages[idx] = alloc_page(GFP_KERNEL | __GFP_NOWARN |
+				__GFP_ZERO);
+		if (!bdobj->ram_pages[idx]) {
+			printk(KERN_ERR OCF_PREFIX_SHORT "Cannot allocate "
+					"memory of RAM-backed volume\n");
+			block_dev_close_object(vol);
+			return -OCF_ERR_NO_MEM;
+		}
+		cond_resched();
+	}
+
+	return 0;
+}
+
+static int block_dev_open_compressed_object(ocf_volume_t vol,
+		void *volume_params)
+{
+	struct bd_object *bdobj = bd_object(vol);
+	int result;
+
+	result = block_dev_open_object(vol, volume_params);
+	if (result)
+		return result;
+
+	bdobj->comp = cas_compress_create(
+			block_dev_bdev_length(bdobj->btm_bd) >> SECTOR_SHIFT,
+			compressed_cache_volume);
+	if (!bdobj->comp) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Cannot set up compression of cache device\n");
+		block_dev_close_object(vol);
+		return -OCF_ERR_NO_MEM;
+	}
+
+	/* Overwrites whatever metadata the device was last a cache with */
+	result = block_dev_compress_label(bdobj, compressed_cache_volume);
+	if (result) {
+		printk(KERN_ERR OCF_PREFIX_SHORT
+				"Cannot label compressed cache device\n");
+		block_dev_close_object(vol);
+		return -OCF_ERR_IO;
+	}
+
+	return 0;
+}
+
+/* Whole stripe units of the smallest member on each member */
+static uint64_t block_dev_get_striped_byte_length(ocf_volume_t vol)
+{
+	struct bd_object *bdobj = bd_object(vol);
+	uint64_t length = U64_MAX;
+	int i;
+
+	for (i = 0; i < bdobj->members_count; i++)
+		length = min(length, block_dev_bdev_length(bdobj->member_bd[i]));
+
+	length = round_down(length, 1ULL << CAS_BD_STRIPE_SHIFT);
+
+	return length * bdobj->members_count;
+}
+
+/* Label of members of mirrored volume, right behind data of volume */
+#define CAS_BD_MIRROR_LABEL_SIZE PAGE_SIZE
+#define CAS_BD_MIRROR_LABEL_MAGIC "CASMIRR"
+
+struct cas_bd_mirror_label {
+	char magic[8];
+	__le64 seq;
+	__le32 state[CAS_BD_MIRROR_MEMBERS];
+};
+
+/* The smallest member holds whole copy of volume and label */
+static uint64_t block_dev_mirror_length(struct bd_object *bdobj)
+{
+	uint64_t length = U64_MAX;
+	int i;
+
+	for (i = 0; i < bdobj->members_count; i++)
+		length = min(length, block_dev_bdev_length(bdobj->member_bd[i]));
+
+	length = round_down(length, CAS_BD_MIRROR_LABEL_SIZE);
+
+	return length > CAS_BD_MIRROR_LABEL_SIZE ?
+			length - CAS_BD_MIRROR_LABEL_SIZE : 0;
+}
+
+static uint64_t block_dev_get_mirrored_byte_length(ocf_volume_t vol)
+{
+	return block_dev_mirror_length(bd_object(vol));
+}
+
+static uint64_t block_dev_get_compressed_byte_length(ocf_volume_t vol)
+{
+	return cas_compress_get_blocks(bd_object(vol)->comp) *
+			CAS_COMPRESS_BLOCK_SIZE;
+}
+
+/*
+ * Map address of volume to member and address on it. Returns number of bytes
+ * from @addr to the end of its stripe unit.
+ */
+static uint64_t block_dev_stripe_map(struct bd_object *bdobj, uint64_t addr,
+		struct block_device **bd, uint64_t *member_addr)
+{
+	uint64_t unit_size = 1ULL << CAS_BD_STRIPE_SHIFT;
+	uint64_t offset = addr & (unit_size - 1);
+	uint64_t row;
+	uint32_t member;
+
+	if (bdobj->members_count == 1) {
+		*bd = bdobj->btm_bd;
+		*member_addr = addr;
+		return U64_MAX;
+	}
+
+	row = div_u64_rem(addr >> CAS_BD_STRIPE_SHIFT, bdobj->members_count,
+			&member);
+
+	*bd = bdobj->member_bd[member];
+	*member_addr = (row << CAS_BD_STRIPE_SHIFT) + offset;
+
+	return unit_size - offset;
+}
+
+/*
+ * Returns only flags that are relevant to request's direction.
+ */
+static inline uint64_t filter_req_flags(int dir, uint64_t flags)
+{
+	/* Remove REQ_RAHEAD flag from write request to cache which are a
+	   result of a missed read-head request. This flag caused the nvme
+	   driver to send write command with access frequency value that is
+	   reserved */
+	if (dir == WRITE) {
+		flags &= ~REQ_RAHEAD;
+		/* Only reads are reaped by polling, see cas_bd_poll_bio() */
+		flags &= ~CAS_REQ_POLLED;
+	}
+
+	return flags;
+}
+
+/*
+ *
+ */
+/*
+ * I/O waiting for inflight budget of its class.
+ */
+struct cas_bd_waiting_io {
+	struct list_head list;
+	struct rb_node node; /* Gathered background write */
+	ocf_forward_token_t token;
+	int dir;
+	uint64_t addr;
+	uint64_t bytes;
+	uint64_t offset;
+	int io_class; /* Write held by rebuild fence */
+};
+
+/*
+ * Writes issued by cache itself carry no flags of user bio, which allows to
+ * tell cleaning and other internal writes from I/O serving user requests.
+ * Returns CAS_BD_IO_CLASS_MAX when I/O is not subject to inflight limits.
+ */
+static int block_dev_io_class(struct bd_object *bdobj, int dir,
+		uint64_t flags)
+{
+	if (!READ_ONCE(bdobj->inflight_limit[CAS_BD_IO_FOREGROUND]) &&
+			!READ_ONCE(bdobj->inflight_limit[CAS_BD_IO_BACKGROUND]) &&
+			!READ_ONCE(bdobj->rate_limit) &&
+			!READ_ONCE(bdobj->sweep_window_us)) {
+		return CAS_BD_IO_CLASS_MAX;
+	}
+
+	if (dir == OCF_WRITE && !flags)
+		return CAS_BD_IO_BACKGROUND;
+
+	return CAS_BD_IO_FOREGROUND;
+}
+
+/*
+ * Background writes (i.e. cleaning) gathered in sweep window are sent in
+ * ascending order of address, wrapping around to the lowest one, so that
+ * core device sees sequential sweeps instead of random writes in order of
+ * cleaning policy, and neighbouring writes get merged in plug. Called with
+ * inflight_lock held.
+ */
+static void block_dev_sweep_add(struct bd_object *bdobj,
+		struct cas_bd_waiting_io *wio)
+{
+	struct rb_node **link = &bdobj->sweep_pending.rb_node;
+	struct rb_node *parent = NULL;
+
+	while (*link) {
+		parent = *link;
+		if (wio->addr < rb_entry(parent, struct cas_bd_waiting_io,
+					node)->addr) {
+			link = &parent->rb_left;
+		} else {
+			link = &parent->rb_right;
+		}
+	}
+
+	rb_link_node(&wio->node, parent, link);
+	rb_insert_color(&wio->node, &bdobj->sweep_pending);
+	bdobj->sweep_count++;
+}
+
+static struct cas_bd_waiting_io *block_dev_sweep_next(struct bd_object *bdobj)
+{
+	struct rb_node *node = bdobj->sweep_pending.rb_node, *next = NULL;
+	struct cas_bd_waiting_io *wio;
+
+	while (node) {
+		wio = rb_entry(node, struct cas_bd_waiting_io, node);
+		if (wio->addr >= bdobj->sweep_pos) {
+			next = node;
+			node = node->rb_left;
+		} else {
+			node = node->rb_right;
+		}
+	}
+
+	if (!next)
+		next = rb_first(&bdobj->sweep_pending);
+
+	wio = rb_entry(next, struct cas_bd_waiting_io, node);
+	rb_erase(next, &bdobj->sweep_pending);
+	bdobj->sweep_pos = wio->addr + wio->bytes;
+
+	/* Next writes start new window */
+	if (!--bdobj->sweep_count)
+		bdobj->sweep_ready = false;
+
+	return wio;
+}
+
+/* Called with inflight_lock held */
+static bool block_dev_inflight_waiting(struct bd_object *bdobj, int io_class)
+{
+	if (!list_empty(&bdobj->inflight_waiting[io_class]))
+		return true;
+
+	return io_class == CAS_BD_IO_BACKGROUND && bdobj->sweep_ready &&
+			bdobj->sweep_count;
+}
+
+static bool block_dev_inflight_below_limit(struct bd_object *bdobj,
+		int io_class)
+{
+	uint32_t limit = READ_ONCE(bdobj->inflight_limit[io_class]);
+
+	return !limit || atomic_read(&bdobj->inflight[io_class]) < limit;
+}
+
+/*
+ * Refill rate budget of background I/O for time elapsed since last refill.
+ * While foreground I/O is in flight only a fraction of the bandwidth is
+ * granted, so that rate limited writeback yields to user requests.
+ * Called with inflight_lock held.
+ */
+static void block_dev_rate_refill(struct bd_object *bdobj)
+{
+	uint64_t limit = READ_ONCE(bdobj->rate_limit);
+	unsigned long now = jiffies;
+	unsigned long elapsed = min(now - bdobj->rate_stamp,
+			(unsigned long)HZ);
+	uint64_t rate = limit;
+	int64_t budget;
+
+	bdobj->rate_stamp = now;
+
+	if (!limit)
+		return;
+
+	if (atomic_read(&bdobj->inflight[CAS_BD_IO_FOREGROUND]))
+		rate /= CAS_BD_RATE_FOREGROUND_DIV;
+
+	budget = bdobj->rate_budget + div_u64(rate * elapsed, HZ);
+	bdobj->rate_budget = min_t(int64_t, budget,
+			div_u64(limit, CAS_BD_RATE_BURST_DIV));
+}
+
+/*
+ * Charge background I/O to rate budget. Budget may go below zero, so I/O
+ * larger than the budget is not stalled forever. Called with inflight_lock
+ * held.
+ */
+static void block_dev_rate_charge(struct bd_object *bdobj, int io_class,
+		uint64_t bytes)
+{
+	if (io_class == CAS_BD_IO_BACKGROUND && READ_ONCE(bdobj->rate_limit))
+		bdobj->rate_budget -= bytes;
+}
+
+/*
+ * Resume waiting background I/O once rate budget is positive again.
+ * Called with inflight_lock held.
+ */
+static void block_dev_rate_schedule(struct bd_object *bdobj)
+{
+	uint64_t limit = READ_ONCE(bdobj->rate_limit);
+	unsigned long delay;
+
+	if (!limit || bdobj->rate_budget > 0)
+		return;
+
+	if (!block_dev_inflight_waiting(bdobj, CAS_BD_IO_BACKGROUND))
+		return;
+
+	delay = div64_u64((uint64_t)(1 - bdobj->rate_budget) * HZ, limit);
+	queue_delayed_work(system_unbound_wq, &bdobj->rate_work,
+			max(delay, 1UL));
+}
+
+/*
+ * Check whether I/O of given class may be sent now. Background I/O is held
+ * back whenever foreground I/O is waiting or foreground budget is used up,
+ * as this means the device is saturated. Nothing holds it back while cache
+ * is flushed on request, unless the flush is rate limited.
+ */
+static bool block_dev_inflight_may_submit(struct bd_object *bdobj,
+		int io_class)
+{
+	if (io_class == CAS_BD_IO_BACKGROUND) {
+		if (READ_ONCE(bdobj->rate_limit) && bdobj->rate_budget <= 0)
+			return false;
+		if (READ_ONCE(bdobj->inflight_unthrottled))
+			return true;
+		if (!list_empty(&bdobj->inflight_waiting[CAS_BD_IO_FOREGROUND]))
+			return false;
+		if (!block_dev_inflight_below_limit(bdobj, CAS_BD_IO_FOREGROUND))
+			return false;
+	}
+
+	return block_dev_inflight_below_limit(bdobj, io_class);
+}
+
+/*
+ * Returns true if I/O has been queued to wait for inflight budget.
+ */
+static bool block_dev_inflight_wait(struct bd_object *bdobj, int io_class,
+		ocf_forward_token_t token, int dir, uint64_t addr,
+		uint64_t bytes, uint64_t offset)
+{
+	struct cas_bd_waiting_io *wio;
+	uint32_t window = READ_ONCE(bdobj->sweep_window_us);
+	bool sweep = window && io_class == CAS_BD_IO_BACKGROUND &&
+			dir == OCF_WRITE;
+	unsigned long flags;
+
+	if (io_class == CAS_BD_IO_CLASS_MAX)
+		return false;
+
+	/* Rate budget is accounted under the lock only */
+	if (!sweep && (io_class != CAS_BD_IO_BACKGROUND ||
+				!READ_ONCE(bdobj->rate_limit)) &&
+			list_empty(&bdobj->inflight_waiting[io_class]) &&
+			block_dev_inflight_may_submit(bdobj, io_class)) {
+		return false;
+	}
+
+	wio = kmalloc(sizeof(*wio), GFP_NOWAIT);
+	if (!wio)
+		return false;
+
+	wio->token = token;
+	wio->dir = dir;
+	wio->addr = addr;
+	wio->bytes = bytes;
+	wio->offset = offset;
+
+	spin_lock_irqsave(&bdobj->inflight_lock, flags);
+	if (sweep) {
+		block_dev_sweep_add(bdobj, wio);
+		if (bdobj->sweep_count >= CAS_BD_SWEEP_PENDING_MAX)
+			bdobj->sweep_ready = true;
+		if (bdobj->sweep_count == 1 && !bdobj->sweep_ready) {
+			queue_delayed_work(system_unbound_wq,
+					&bdobj->sweep_work,
+					max(usecs_to_jiffies(window), 1UL));
+		}
+		spin_unlock_irqrestore(&bdobj->inflight_lock, flags);
+
+		/* Writes coming during sweep join it right away */
+		if (bdobj->sweep_ready)
+			queue_work(system_unbound_wq, &bdobj->inflight_work);
+		return true;
+	}
+
+	block_dev_rate_refill(bdobj);
+	/* Budget might have been released in the meantime */
+	if (list_empty(&bdobj->inflight_waiting[io_class]) &&
+			block_dev_inflight_may_submit(bdobj, io_class)) {
+		block_dev_rate_charge(bdobj, io_class, bytes);
+		spin_unlock_irqrestore(&bdobj->inflight_lock, flags);
+		kfree(wio);
+		return false;
+	}
+	list_add_tail(&wio->list, &bdobj->inflight_waiting[io_class]);
+	block_dev_rate_schedule(bdobj);
+	spin_unlock_irqrestore(&bdobj->inflight_lock, flags);
+
+	return true;
+}
+
+static void block_dev_inflight_put(struct bd_object *bdobj, int io_class)
+{
+	unsigned long flags;
+	bool waiting;
+	int i;
+
+	if (io_class == CAS_BD_IO_CLASS_MAX)
+		return;
+
+	atomic_dec(&bdobj->inflight[io_class]);
+
+	spin_lock_irqsave(&bdobj->inflight_lock, flags);
+	for (i = 0, waiting = false; i < CAS_BD_IO_CLASS_MAX; i++)
+		waiting |= block_dev_inflight_waiting(bdobj, i);
+	spin_unlock_irqrestore(&bdobj->inflight_lock, flags);
+
+	if (waiting)
+		queue_work(system_unbound_wq, &bdobj->inflight_work);
+}
+
+static void block_dev_nowait_retry_work(struct work_struct *work)
+{
+	struct bd_object *bdobj = container_of(work, struct bd_object,
+			nowait_retry_work);
+	struct bio_list bios;
+	struct blk_plug plug;
+	struct bio *bio;
+
+	spin_lock_irq(&bdobj->nowait_retry_lock);
+	bios = bdobj->nowait_retry_bios;
+	bio_list_init(&bdobj->nowait_retry_bios);
+	spin_unlock_irq(&bdobj->nowait_retry_lock);
+
+	blk_start_plug(&plug);
+	while ((bio = bio_list_pop(&bios))) {
+		/* Operation is already set in bio */
+		cas_bd_submit_bio(bdobj, 0, bio);
+	}
+	blk_finish_plug(&plug);
+}
+
+/*
+ * Bio rejected due to lack of free tags fails before being dispatched, but
+ * block layer may have advanced its iterator or remapped it to whole disk
+ * already, so target and range it was submitted with are restored before
+ * it is resubmitted. Resubmission may block, so it is done from work to
+ * keep OCF queue serving other requests.
+ */
+static bool block_dev_nowait_retry(struct bio *bio)
+{
+	struct bd_object *bdobj = cas_bd_bio(bio)->bdobj;
+	unsigned long flags;
+
+	if (!(CAS_BIO_OP_FLAGS(bio) & CAS_REQ_NOWAIT) || !CAS_BIO_WOULDBLOCK(bio))
+		return false;
+
+	CAS_BIO_OP_FLAGS(bio) &= ~CAS_REQ_NOWAIT;
+	CAS_BIO_OP_STATUS(bio) = CAS_BLK_STS_OK;
+	CAS_BIO_SET_DEV(bio, cas_bd_bio(bio)->nowait_bd);
+	bio->bi_iter = cas_bd_bio(bio)->nowait_iter;
+
+	spin_lock_irqsave(&bdobj->nowait_retry_lock, flags);
+	bio_list_add(&bdobj->nowait_retry_bios, bio);
+	spin_unlock_irqrestore(&bdobj->nowait_retry_lock, flags);
+
+	queue_work(system_unbound_wq, &bdobj->nowait_retry_work);
+
+	return true;
+}
+
+/*
+ * Per-CPU list of completed bios whose forward tokens are ended in batch
+ * once interrupt handler completing them returns.
+ */
+struct cas_bd_cmpl_batch {
+	struct llist_head list;
+	struct irq_work work;
+};
+
+static DEFINE_PER_CPU(struct cas_bd_cmpl_batch, cas_bd_cmpl_batch);
+
+static inline void cas_bd_bio_end(struct cas_bd_bio *bd_bio)
+{
+	ocf_forward_end(bd_bio->token, bd_bio->error);
+
+	/* Signal completion to cas_bd_poll_bio() */
+	WRITE_ONCE(bd_bio->token, NULL);
+
+	bio_put(&bd_bio->bio);
+}
+
+static void cas_bd_cmpl_batch_run(struct irq_work *work)
+{
+	struct cas_bd_cmpl_batch *batch = container_of(work,
+			struct cas_bd_cmpl_batch, work);
+	struct llist_node *llnode = llist_del_all(&batch->list);
+	struct cas_bd_bio *bd_bio, *tmp;
+
+	/* End tokens in the order bios have completed */
+	llnode = llist_reverse_order(llnode);
+	llist_for_each_entry_safe(bd_bio, tmp, llnode, cmpl_node)
+		cas_bd_bio_end(bd_bio);
+}
+
+static void cas_bd_cmpl_batch_init(void)
+{
+	int i;
+
+	for_each_possible_cpu(i) {
+		struct cas_bd_cmpl_batch *batch;
+
+		batch = &per_cpu(cas_bd_cmpl_batch, i);
+		init_llist_head(&batch->list);
+		init_irq_work(&batch->work, cas_bd_cmpl_batch_run);
+	}
+}
+
+static void cas_bd_cmpl_batch_deinit(void)
+{
+	int i;
+
+	for_each_possible_cpu(i)
+		irq_work_sync(&per_cpu(cas_bd_cmpl_batch, i).work);
+}
+
+/*
+ * Batch only bios completed in interrupt context on architectures raising
+ * irq_work right after the interrupt, otherwise it would wait for a tick.
+ * Polled bios are already reaped in batches by the submitter.
+ */
+static inline bool cas_bd_bio_batch_end(struct cas_bd_bio *bd_bio)
+{
+	struct cas_bd_cmpl_batch *batch;
+
+	if (!batch_completions || !in_interrupt())
+		return false;
+	if (CAS_BIO_OP_FLAGS(&bd_bio->bio) & CAS_REQ_POLLED)
+		return false;
+	if (!CAS_IRQ_WORK_HAS_INTERRUPT())
+		return false;
+
+	batch = this_cpu_ptr(&cas_bd_cmpl_batch);
+	if (llist_add(&bd_bio->cmpl_node, &batch->list))
+		irq_work_queue(&batch->work);
+
+	return true;
+}
+
+static void block_dev_mirror_write_exit(struct bd_object *bdobj, int epoch)
+{
+	if (atomic_dec_and_test(&bdobj->mirror_writes[epoch]) &&
+			wq_has_sleeper(&bdobj->mirror_wait)) {
+		wake_up(&bdobj->mirror_wait);
+	}
+}
+
+/*
+ * Called under mirror lock after states of members changed. Writes which
+ * complete from now on are held until new states are written to labels,
+ * so that member missing them is never trusted after restart.
+ */
+static void block_dev_mirror_state_changed(struct bd_object *bdobj)
+{
+	bdobj->mirror_seq++;
+	queue_work(system_unbound_wq, &bdobj->mirror_label_work);
+}
+
+/*
+ * Fail member of mirrored volume if the other member is active, so that it
+ * keeps serving I/O alone. Returns false if no active member would be left.
+ */
+static bool block_dev_mirror_fail(struct bd_object *bdobj, int member)
+{
+	unsigned long flags;
+	bool others = false;
+	int i;
+
+	spin_lock_irqsave(&bdobj->mirror_lock, flags);
+	for (i = 0; i < bdobj->members_count; i++) {
+		if (i != member && bdobj->member_state[i] ==
+				KCAS_MIRROR_MEMBER_ACTIVE) {
+			others = true;
+		}
+	}
+	if (others && bdobj->member_state[member] != KCAS_MIRROR_MEMBER_FAILED) {
+		WRITE_ONCE(bdobj->member_state[member],
+				KCAS_MIRROR_MEMBER_FAILED);
+		block_dev_mirror_state_changed(bdobj);
+		printk(KERN_ERR OCF_PREFIX_SHORT "Member %d of mirrored cache "
+				"device failed\n", member);
+	}
+	spin_unlock_irqrestore(&bdobj->mirror_lock, flags);
+
+	return others;
+}
+
+/*
+ * Write failed on one member still succeeds on the other one. Failed read
+ * is retried on the other member once this one is failed.
+ */
+static int block_dev_mirror_end(struct cas_bd_bio *bd_bio, int dir, int err)
+{
+	struct bd_object *bdobj = bd_bio->bdobj;
+	int member = bd_bio->member;
+
+	if (bd_bio->mirror_epoch >= 0)
+		block_dev_mirror_write_exit(bdobj, bd_bio->mirror_epoch);
+	else if (dir == READ)
+		atomic_dec(&bdobj->member_reads[member]);
+
+	if (!err)
+		return 0;
+
+	if (block_dev_mirror_fail(bdobj, member) && dir == WRITE)
+		return 0;
+
+	return err;
+}
+
+/*
+ * Take over completion of bio of mirrored volume, either of failed read to
+ * be retried on the other member or of write to be held until states of
+ * members are written. Returns false if bio is to be completed as usual.
+ */
+static bool block_dev_mirror_defer(struct cas_bd_bio *bd_bio)
+{
+	struct bd_object *bdobj = bd_bio->bdobj;
+	struct cas_bd_waiting_io *wio;
+	unsigned long flags;
+	bool held = false;
+
+	if (bd_bio->mirror_epoch < 0) {
+		/* Member the read failed on is not read again */
+		if (!bd_bio->error || READ_ONCE(bdobj->member_state[
+				bd_bio->member]) != KCAS_MIRROR_MEMBER_FAILED) {
+			return false;
+		}
+
+		wio = kmalloc(sizeof(*wio), GFP_ATOMIC);
+		if (!wio)
+			return false;
+
+		/* Reference of token moves to read retried */
+		wio->token = bd_bio->token;
+		wio->dir = OCF_READ;
+		wio->addr = bd_bio->mirror_addr;
+		wio->bytes = bd_bio->mirror_bytes;
+		wio->offset = bd_bio->mirror_offset;
+		wio->io_class = bd_bio->io_class;
+
+		spin_lock_irqsave(&bdobj->mirror_lock, flags);
+		list_add_tail(&wio->list, &bdobj->mirror_retry);
+		spin_unlock_irqrestore(&bdobj->mirror_lock, flags);
+		queue_work(system_unbound_wq, &bdobj->mirror_retry_work);
+
+		WRITE_ONCE(bd_bio->token, NULL);
+		bio_put(&bd_bio->bio);
+		return true;
+	}
+
+	if (READ_ONCE(bdobj->mirror_seq) == READ_ONCE(bdobj->mirror_seq_done))
+		return false;
+
+	spin_lock_irqsave(&bdobj->mirror_lock, flags);
+	if (bdobj->mirror_seq != bdobj->mirror_seq_done) {
+		llist_add(&bd_bio->cmpl_node, &bdobj->mirror_label_held);
+		held = true;
+	}
+	spin_unlock_irqrestore(&bdobj->mirror_lock, flags);
+
+	return held;
+}
+
+static void block_dev_mirror_retry_work(struct work_struct *work)
+{
+	struct bd_object *bdobj = container_of(work, struct bd_object,
+			mirror_retry_work);
+	struct cas_bd_waiting_io *wio, *tmp;
+	LIST_HEAD(retry);
+	int member;
+
+	spin_lock_irq(&bdobj->mirror_lock);
+	list_splice_init(&bdobj->mirror_retry, &retry);
+	spin_unlock_irq(&bdobj->mirror_lock);
+
+	list_for_each_entry_safe(wio, tmp, &retry, list) {
+		list_del(&wio->list);
+		member = block_dev_mirror_read_member(bdobj);
+		if (member >= 0) {
+			_block_dev_forward_member_io(bdobj, member, -1,
+					wio->token, OCF_READ, wio->addr,
+					wio->bytes, wio->offset, wio->io_class);
+		} else {
+			ocf_forward_end(wio->token, -OCF_ERR_IO);
+		}
+		kfree(wio);
+	}
+}
+
+static inline void block_dev_csum_block(struct bd_object *bdobj,
+		uint32_t *csum, uint64_t block, uint32_t crc, int dir, int *err)
+{
+	uint32_t expected;
+
+	if (block >= bdobj->csum_blocks)
+		return;
+
+	if (dir == WRITE) {
+		WRITE_ONCE(csum[block], crc);
+		return;
+	}
+
+	expected = READ_ONCE(csum[block]);
+	if (!crc || !expected || crc == expected)
+		return;
+
+	atomic64_inc(&bdobj->csum_errors);
+	CAS_PRINT_RL(KERN_ERR OCF_PREFIX_SHORT "Checksum mismatch of block "
+			"%llu of cache device\n", block);
+	*err = -EIO;
+}
+
+/*
+ * Checksum whole blocks covered by bio, in place of its bio vectors.
+ * Checksums of blocks written are updated and blocks read are verified
+ * against them, so that read of corrupted data fails, e.g. to be retried
+ * from core by OCF. Blocks partially written or failed to be written are
+ * no longer known.
+ */
+static int block_dev_csum_bio(struct bd_object *bdobj, struct bio *bio,
+		uint64_t addr, int err)
+{
+	uint32_t crc = 0, chunk, in_block, offset, length, i;
+	int dir = bio_data_dir(bio);
+	struct bio_vec *bvec;
+	uint32_t *csum;
+	bool whole = false;
+	struct page *page;
+	void *buf;
+
+	if (err && dir == READ)
+		return err;
+
+	rcu_read_lock();
+	csum = rcu_dereference(bdobj->csum);
+	if (!csum)
+		goto out;
+
+	for (i = 0; i < bio->bi_vcnt; i++) {
+		bvec = &bio->bi_io_vec[i];
+		offset = bvec->bv_offset;
+		length = bvec->bv_len;
+
+		while (length) {
+			in_block = addr % CAS_BD_CSUM_BLOCK_SIZE;
+			if (!in_block) {
+				whole = !err;
+				crc = ~0U;
+			}
+
+			/* Multipage vectors are mapped page by page */
+			page = nth_page(bvec->bv_page, offset >> PAGE_SHIFT);
+			chunk = min3(length, CAS_BD_CSUM_BLOCK_SIZE - in_block,
+					(uint32_t)(PAGE_SIZE -
+						offset_in_page(offset)));
+
+			if (whole) {
+				buf = kmap_atomic(page);
+				crc = crc32c(crc, buf + offset_in_page(offset),
+						chunk);
+				kunmap_atomic(buf);
+			}
+
+			addr += chunk;
+			offset += chunk;
+			length -= chunk;
+
+			if (addr % CAS_BD_CSUM_BLOCK_SIZE)
+				continue;
+
+			block_dev_csum_block(bdobj, csum,
+					addr / CAS_BD_CSUM_BLOCK_SIZE - 1,
+					whole ? (crc ?: 1) : 0, dir, &err);
+			whole = false;
+		}
+	}
+
+	/* Tail of block is left out of bio */
+	if (addr % CAS_BD_CSUM_BLOCK_SIZE) {
+		block_dev_csum_block(bdobj, csum,
+				addr / CAS_BD_CSUM_BLOCK_SIZE, 0, dir, &err);
+	}
+
+out:
+	rcu_read_unlock();
+	return err;
+}
+
+/* Page hashes held by single chunk of metadata hash table */
+#define CAS_BD_META_HASH_CHUNK (PAGE_SIZE / sizeof(uint64_t))
+
+/*
+ * Slot of hash of page @idx, NULL if its chunk is not there and cannot be
+ * allocated. Called under RCU read lock, chunks are freed after grace period.
+ */
+static uint64_t *block_dev_meta_hash_slot(struct bd_object *bdobj,
+		uint64_t idx, bool alloc)
+{
+	unsigned long chunk_idx = idx / CAS_BD_META_HASH_CHUNK;
+	uint64_t *chunk, *new;
+	unsigned long flags;
+
+	chunk = xa_load(&bdobj->meta_hash, chunk_idx);
+	if (!chunk && alloc) {
+		new = (uint64_t *)get_zeroed_page(GFP_ATOMIC | __GFP_NOWARN);
+		if (!new)
+			return NULL;
+
+		xa_lock_irqsave(&bdobj->meta_hash, flags);
+		chunk = __xa_cmpxchg(&bdobj->meta_hash, chunk_idx, NULL, new,
+				GFP_ATOMIC | __GFP_NOWARN);
+		xa_unlock_irqrestore(&bdobj->meta_hash, flags);
+
+		if (xa_is_err(chunk)) {
+			free_page((unsigned long)new);
+			return NULL;
+		}
+
+		/* Lost race with other bio allocating the same chunk */
+		if (chunk)
+			free_page((unsigned long)new);
+		else
+			chunk = new;
+	}
+
+	return chunk ? &chunk[idx % CAS_BD_META_HASH_CHUNK] : NULL;
+}
+
+/*
+ * Learn hashes of whole pages covered by bio from its bio vectors, the same
+ * way checksums are. Pages partially transferred or failed to be written are
+ * no longer known.
+ */
+static void block_dev_meta_hash_bio(struct bd_object *bdobj, struct bio *bio,
+		uint64_t addr, int err)
+{
+	uint64_t end = READ_ONCE(bdobj->meta_hash_end);
+	uint32_t chunk, offset, length, i;
+	struct xxh64_state state;
+	struct bio_vec *bvec;
+	bool whole = false;
+	struct page *page;
+	uint64_t *slot;
+	void *buf;
+
+	if (err && bio_data_dir(bio) == READ)
+		return;
+
+	rcu_read_lock();
+	for (i = 0; i < bio->bi_vcnt && addr < end; i++) {
+		bvec = &bio->bi_io_vec[i];
+		offset = bvec->bv_offset;
+		length = bvec->bv_len;
+
+		while (length && addr < end) {
+			if (PAGE_ALIGNED(addr)) {
+				whole = !err;
+				xxh64_reset(&state, 0);
+			}
+
+			/* Multipage vectors are mapped page by page */
+			page = nth_page(bvec->bv_page, offset >> PAGE_SHIFT);
+			chunk = min3(length, (uint32_t)(PAGE_SIZE -
+						offset_in_page(addr)),
+					(uint32_t)(PAGE_SIZE -
+						offset_in_page(offset)));
+
+			if (whole) {
+				buf = kmap_atomic(page);
+				xxh64_update(&state, buf +
+						offset_in_page(offset), chunk);
+				kunmap_atomic(buf);
+			}
+
+			addr += chunk;
+			offset += chunk;
+			length -= chunk;
+
+			if (!PAGE_ALIGNED(addr))
+				continue;
+
+			slot = block_dev_meta_hash_slot(bdobj,
+					(addr >> PAGE_SHIFT) - 1, whole);
+			if (slot) {
+				WRITE_ONCE(*slot, whole ?
+						(xxh64_digest(&state) ?: 1) : 0);
+			}
+			whole = false;
+		}
+	}
+
+	/* Tail of page is left out of bio */
+	if (!PAGE_ALIGNED(addr) && addr < end) {
+		slot = block_dev_meta_hash_slot(bdobj, addr >> PAGE_SHIFT,
+				false);
+		if (slot)
+			WRITE_ONCE(*slot, 0);
+	}
+	rcu_read_unlock();
+}
+
+/* Forget hashes of pages overlapping range, e.g. discarded */
+static void block_dev_meta_hash_forget(struct bd_object *bdobj,
+		uint64_t addr, uint64_t bytes)
+{
+	uint64_t end = min(addr + bytes, READ_ONCE(bdobj->meta_hash_end));
+	unsigned long first, last, chunk_idx, idx;
+	uint64_t *chunk;
+
+	if (addr >= end)
+		return;
+
+	first = addr >> PAGE_SHIFT;
+	last = (end - 1) >> PAGE_SHIFT;
+
+	rcu_read_lock();
+	xa_for_each_range(&bdobj->meta_hash, chunk_idx, chunk,
+			first / CAS_BD_META_HASH_CHUNK,
+			last / CAS_BD_META_HASH_CHUNK) {
+		idx = max(first, chunk_idx * CAS_BD_META_HASH_CHUNK);
+		for (; idx <= last && idx / CAS_BD_META_HASH_CHUNK == chunk_idx;
+				idx++) {
+			WRITE_ONCE(chunk[idx % CAS_BD_META_HASH_CHUNK], 0);
+		}
+	}
+	rcu_read_unlock();
+}
+
+/*
+ * Bio is sent as atomic write if it falls into metadata area and the device
+ * guarantees it to be untorn, which requires naturally aligned power of two
+ * size within atomic write unit limits
+ */
+static bool block_dev_atomic_write(struct bd_object *bdobj, struct bio *bio)
+{
+	uint64_t addr = (uint64_t)CAS_BIO_BISECTOR(bio) << SECTOR_SHIFT;
+	uint32_t size = CAS_BIO_BISIZE(bio);
+
+	return addr < READ_ONCE(bdobj->atomic_meta_end) &&
+			is_power_of_2(size) &&
+			size >= bdobj->atomic_write_min &&
+			size <= bdobj->atomic_write_max &&
+			IS_ALIGNED(addr, size);
+}
+
+/*
+ * Moving average with weight of 1/8 of latest read. Completions on different
+ * CPUs may race and lose an update, which only delays the average a bit.
+ */
+static void block_dev_read_lat_update(struct bd_object *bdobj,
+		uint64_t start_ns)
+{
+	uint64_t now = ktime_get_ns();
+	uint64_t lat = now > start_ns ? now - start_ns : 0;
+	uint64_t avg = READ_ONCE(bdobj->read_lat);
+
+	if (avg)
+		lat = avg - (avg >> 3) + (lat >> 3);
+
+	WRITE_ONCE(bdobj->read_lat, lat ?: 1);
+}
+
+/*
+ * Last bio of sampled exported object request completed by device starts
+ * completion stage of the request, first one submitted starts device stage
+ */
+static inline void block_dev_stage_mark(ocf_forward_token_t token,
+		enum kcas_io_stage stage)
+{
+	struct blk_data *data = token ? ocf_forward_get_data(token) : NULL;
+
+	if (likely(!data || !data->stage_hist))
+		return;
+
+	if (stage == KCAS_IO_STAGE_COMPLETE ||
+			!READ_ONCE(data->stage_ns[stage])) {
+		WRITE_ONCE(data->stage_ns[stage], ktime_get_ns());
+	}
+}
+
+CAS_DECLARE_BLOCK_CALLBACK(cas_bd_forward_end, struct bio *bio,
+		unsigned int bytes_done, int error)
+{
+	struct cas_bd_bio *bd_bio = cas_bd_bio(bio);
+	int err;
+
+	CAS_BLOCK_CALLBACK_INIT(bio);
+	if (block_dev_nowait_retry(bio)) {
+		CAS_BLOCK_CALLBACK_RETURN();
+	}
+
+	err = CAS_BLOCK_CALLBACK_ERROR(bio, error);
+
+	CAS_DEBUG_TRACE();
+
+	if (err == -EOPNOTSUPP && (CAS_BIO_OP_FLAGS(bio) & CAS_BIO_DISCARD))
+		err = 0;
+
+	if (bio_data_dir(bio) == WRITE)
+		atomic64_inc(&bd_bio->bdobj->write_gen);
+
+	if (bd_bio->csum_addr != U64_MAX) {
+		err = block_dev_csum_bio(bd_bio->bdobj, bio,
+				bd_bio->csum_addr, err);
+	}
+
+	if (bd_bio->meta_addr != U64_MAX) {
+		block_dev_meta_hash_bio(bd_bio->bdobj, bio,
+				bd_bio->meta_addr, err);
+	}
+
+	if (bd_bio->member >= 0)
+		err = block_dev_mirror_end(bd_bio, bio_data_dir(bio), err);
+
+	if (bd_bio->zone >= 0)
+		block_dev_zone_put(bd_bio->bdobj, bd_bio->zone, err);
+
+	block_dev_inflight_put(bd_bio->bdobj, bd_bio->io_class);
+
+	trace_cas_bd_complete(bd_bio->bdobj->btm_bd->bd_dev, bio, err);
+
+	if (bd_bio->lat_start && bd_bio->bdobj->lat_hist) {
+		cas_lat_hist_record(
+			&bd_bio->bdobj->lat_hist->dev[bio_data_dir(bio)],
+			bd_bio->lat_start);
+	}
+
+	if (bd_bio->lat_start && bio_data_dir(bio) == READ && !err)
+		block_dev_read_lat_update(bd_bio->bdobj, bd_bio->lat_start);
+
+	block_dev_stage_mark(bd_bio->token, KCAS_IO_STAGE_COMPLETE);
+
+	bd_bio->error = err;
+	if (bd_bio->member >= 0 && block_dev_mirror_defer(bd_bio)) {
+		CAS_BLOCK_CALLBACK_RETURN();
+	}
+
+	if (!cas_bd_bio_batch_end(bd_bio))
+		cas_bd_bio_end(bd_bio);
+
+	CAS_BLOCK_CALLBACK_RETURN();
+}
+
+/*
+ * Allocate bio from bottom volume bio set. Allocation is mempool backed,
+ * so with GFP_NOIO it waits for bios in flight instead of failing.
+ */
+static inline struct bio *cas_bd_alloc_bio(struct bd_object *bdobj,
+		unsigned short num_vecs, ocf_forward_token_t token)
+{
+	struct bio *bio = cas_bio_alloc_bioset(bdobj->btm_bd, GFP_NOIO,
+			num_vecs, bdobj->btm_bio_set);
+
+	if (!bio)
+		return NULL;
+
+	cas_bd_bio(bio)->bdobj = bdobj;
+	cas_bd_bio(bio)->token = token;
+	cas_bd_bio(bio)->io_class = CAS_BD_IO_CLASS_MAX;
+	cas_bd_bio(bio)->lat_start = 0;
+	cas_bd_bio(bio)->member = -1;
+	cas_bd_bio(bio)->mirror_epoch = -1;
+	cas_bd_bio(bio)->zone = -1;
+	cas_bd_bio(bio)->csum_addr = U64_MAX;
+	cas_bd_bio(bio)->meta_addr = U64_MAX;
+	bio->bi_private = NULL;
+	bio->bi_end_io = CAS_REFER_BLOCK_CALLBACK(cas_bd_forward_end);
+
+	return bio;
+}
+
+/* Time polled read is busy polled for before queue thread yields CPU */
+#define CAS_BD_POLL_SPIN_NS (50 * NSEC_PER_USEC)
+
+/*
+ * Reap polled read inline instead of waiting for completion from queue
+ * kthread. If device has no poll queues, block layer clears polled flag
+ * on submission, and bio which didn't land on poll queue has no cookie,
+ * so either of them completes by interrupt without being waited for.
+ * Request on poll queue completes only once polled, so after spinning
+ * for CAS_BD_POLL_SPIN_NS it is still polled, but yielding CPU in between.
+ */
+static void cas_bd_poll_bio(struct bio *bio)
+{
+#ifdef CAS_BLK_MQ_POLL
+	uint64_t deadline = ktime_get_ns() + CAS_BD_POLL_SPIN_NS;
+
+	while (READ_ONCE(cas_bd_bio(bio)->token)) {
+		if (!(CAS_BIO_OP_FLAGS(bio) & CAS_REQ_POLLED))
+			break;
+		if (bio_poll(bio, NULL, 0))
+			continue;
+		if (READ_ONCE(bio->bi_cookie) == BLK_QC_T_NONE)
+			break;
+
+		if (ktime_get_ns() < deadline)
+			cpu_relax();
+		else
+			cond_resched();
+	}
+#endif
+	bio_put(bio);
+}
+
+
+/*
+ * Forward I/O to @member, or to members holding stripe units of the range
+ * if @member is -1. Writes to mirrored volume are counted in @mirror_epoch.
+ */
+static void _block_dev_forward_member_io(struct bd_object *bdobj,
+		int member, int mirror_epoch, ocf_forward_token_t token,
+		int dir, uint64_t addr, uint64_t bytes, uint64_t offset,
+		int io_class)
+{
+	struct blk_data *data = ocf_forward_get_data(token);
+	uint64_t flags = ocf_forward_get_flags(token);
+	int bio_dir = (dir == OCF_READ) ? READ : WRITE;
+	bool polled = !!(filter_req_flags(bio_dir, flags) & CAS_REQ_POLLED);
+	uint64_t nowait = 0;
+	struct bio_vec_iter iter;
+	struct blk_plug plug;
+	int error = 0, zone = -1;
+	uint64_t first = addr;
+
+	CAS_DEBUG_PARAM("Address = %llu, bytes = %u\n", addr, bytes);
+
+	/* Zone is busy until all bios of write to it complete */
+	if (bdobj->zones && dir == OCF_WRITE &&
+			bdobj->zones[addr >> bdobj->zone_shift].wp != U64_MAX) {
+		zone = addr >> bdobj->zone_shift;
+		atomic_inc(&bdobj->zones[zone].bios);
+	}
+
+	cas_io_iter_init(&iter, data->vec, data->size);
+	if (offset != cas_io_iter_move(&iter, offset)) {
+		if (zone >= 0)
+			block_dev_zone_put(bdobj, zone, -OCF_ERR_INVAL);
+		ocf_forward_end(token, -OCF_ERR_INVAL);
+		return;
+	}
+
+	/* Forwarded data of exported object request is the request's own */
+	if (data->inflight)
+		WRITE_ONCE(data->inflight_stage, KCAS_INFLIGHT_STAGE_DEVICE);
+
+	if (data->cgroup_entry && dir == OCF_READ && data->cgroup_core == bdobj)
+		WRITE_ONCE(data->core_read, true);
+
+	if (bdobj->heatmap && dir == OCF_READ) {
+		this_cpu_inc(bdobj->heatmap->buckets[cas_bd_heatmap_bucket(
+				bdobj, addr >> SECTOR_SHIFT)].core_reads);
+	}
+
+	/*
+	 * Do not block OCF queue when bottom device runs out of tags. Bios
+	 * resubmitted later would break order of writes to zone.
+	 */
+	if (nowait_submission && !polled && zone < 0 &&
+			CAS_BDEV_NOWAIT(bdobj->btm_bd)) {
+		nowait = CAS_REQ_NOWAIT;
+	}
+
+	/* Polled bios are reaped right after submission, so cannot be plugged */
+	if (!polled)
+		blk_start_plug(&plug);
+	while (cas_io_iter_is_next(&iter) && bytes) {
+		/* Still IO vectors to be sent */
+		struct block_device *bd;
+		uint64_t member_addr, chunk;
+		struct bio *bio;
+
+		if (member >= 0) {
+			bd = bdobj->member_bd[member];
+			member_addr = addr;
+			chunk = bytes;
+		} else {
+			/* Single bio never crosses stripe unit */
+			chunk = min(bytes, block_dev_stripe_map(bdobj, addr,
+					&bd, &member_addr));
+		}
+
+		/* Allocate BIO */
+		bio = cas_bd_alloc_bio(bdobj, cas_io_iter_size_left(&iter),
+				token);
+
+		if (!bio) {
+			error = -ENOMEM;
+			break;
+		}
+
+		/* Only data bios are accounted in latency histograms */
+		if (bdobj->lat_hist || READ_ONCE(bdobj->read_lat_track))
+			cas_bd_bio(bio)->lat_start = ktime_get_ns();
+
+		if (rcu_access_pointer(bdobj->csum))
+			cas_bd_bio(bio)->csum_addr = addr;
+
+		if (addr < READ_ONCE(bdobj->meta_hash_end))
+			cas_bd_bio(bio)->meta_addr = addr;
+
+		if (io_class != CAS_BD_IO_CLASS_MAX) {
+			cas_bd_bio(bio)->io_class = io_class;
+			atomic_inc(&bdobj->inflight[io_class]);
+		}
+
+		/* Setup BIO */
+		CAS_BIO_SET_DEV(bio, bd);
+		CAS_BIO_BISECTOR(bio) = member_addr / SECTOR_SIZE;
+		bio->bi_next = NULL;
+		CAS_BIO_OP_FLAGS(bio) |= filter_req_flags(bio_dir, flags) | nowait;
+
+		/* Add pages */
+		while (cas_io_iter_is_next(&iter) && chunk) {
+			struct page *page = cas_io_iter_current_page(&iter);
+			uint32_t offset = cas_io_iter_current_offset(&iter);
+			uint32_t length = cas_io_iter_current_length(&iter);
+			int added;
+
+			if (length > chunk)
+				length = chunk;
+
+			added = bio_add_page(bio, page, length, offset);
+			BUG_ON(added < 0);
+
+			if (added == 0) {
+				/* No more space in BIO, stop adding pages */
+				break;
+			}
+
+			/* Update address, bytes sent */
+			bytes -= added;
+			chunk -= added;
+			addr += added;
+
+			/* Update BIO vector iterator */
+			if (added != cas_io_iter_move(&iter, added)) {
+				error = -ENOBUFS;
+				break;
+			}
+		}
+
+		if (error == 0) {
+			if (dir == OCF_WRITE && block_dev_atomic_write(bdobj,
+						bio)) {
+				CAS_BIO_OP_FLAGS(bio) |= CAS_REQ_ATOMIC;
+			}
+
+			/* Increase IO reference for sending this IO */
+
+			ocf_forward_get(token);
+			if (zone >= 0) {
+				cas_bd_bio(bio)->zone = zone;
+				atomic_inc(&bdobj->zones[zone].bios);
+			}
+			if (bdobj->mirrored) {
+				cas_bd_bio(bio)->member = member;
+				cas_bd_bio(bio)->mirror_addr = member_addr;
+				cas_bd_bio(bio)->mirror_offset = offset +
+						(member_addr - first);
+				cas_bd_bio(bio)->mirror_bytes = addr -
+						member_addr;
+				cas_bd_bio(bio)->mirror_epoch = mirror_epoch;
+				if (mirror_epoch >= 0) {
+					atomic_inc(&bdobj->mirror_writes[
+							mirror_epoch]);
+				} else {
+					atomic_inc(&bdobj->member_reads[member]);
+				}
+			}
+			if (nowait) {
+				cas_bd_bio(bio)->nowait_bd = bd;
+				cas_bd_bio(bio)->nowait_iter = bio->bi_iter;
+			}
+			/* Send BIO */
+			CAS_DEBUG_MSG("Submit IO");
+			if (polled) {
+				bio_get(bio);
+				cas_bd_submit_bio(bdobj, bio_dir, bio);
+				cas_bd_poll_bio(bio);
+			} else {
+				cas_bd_submit_bio(bdobj, bio_dir, bio);
+			}
+			bio = NULL;
+		} else {
+			if (bio) {
+				bio_put(bio);
+				bio = NULL;
+			}
+
+			/* ERROR, stop processed */
+			break;
+		}
+	}
+	if (!polled)
+		blk_finish_plug(&plug);
+
+	if (bytes && error == 0) {
+		/* Not all bytes sent, mark error */
+		error = -ENOBUFS;
+	}
+
+	if (zone >= 0)
+		block_dev_zone_put(bdobj, zone, error);
+
+	/* Prevent races of completing IO when
+	 * there are still child IOs not being send.
+	 */
+	ocf_forward_end(token, error);
+}
+
+/* Active member of mirrored volume with the fewest reads in flight */
+static int block_dev_mirror_read_member(struct bd_object *bdobj)
+{
+	int i, member = -1, reads, min_reads = INT_MAX;
+
+	for (i = 0; i < bdobj->members_count; i++) {
+		if (READ_ONCE(bdobj->member_state[i]) !=
+				KCAS_MIRROR_MEMBER_ACTIVE) {
+			continue;
+		}
+
+		reads = atomic_read(&bdobj->member_reads[i]);
+		if (reads < min_reads) {
+			min_reads = reads;
+			member = i;
+		}
+	}
+
+	return member;
+}
+
+/*
+ * Count write in current epoch. Rebuild flips epoch after fencing range it
+ * copies, so either write sees the fence or rebuild waits for it.
+ */
+static int block_dev_mirror_write_enter(struct bd_object *bdobj)
+{
+	int epoch;
+
+	while (true) {
+		epoch = READ_ONCE(bdobj->mirror_epoch);
+		atomic_inc(&bdobj->mirror_writes[epoch]);
+		smp_mb__after_atomic();
+		if (READ_ONCE(bdobj->mirror_epoch) == epoch)
+			return epoch;
+
+		block_dev_mirror_write_exit(bdobj, epoch);
+	}
+}
+
+/* Returns true if write has been held until range being rebuilt is copied */
+static bool block_dev_rebuild_hold(struct bd_object *bdobj,
+		ocf_forward_token_t token, int dir, uint64_t addr,
+		uint64_t bytes, uint64_t offset, int io_class)
+{
+	struct cas_bd_waiting_io *wio;
+	unsigned long flags;
+	bool held = false;
+
+	if (!READ_ONCE(bdobj->rebuild_fencing))
+		return false;
+
+	spin_lock_irqsave(&bdobj->mirror_lock, flags);
+	if (bdobj->rebuild_fencing && addr < bdobj->rebuild_fence_end &&
+			addr + bytes > bdobj->rebuild_fence_start) {
+		wio = kmalloc(sizeof(*wio), GFP_ATOMIC);
+		if (wio) {
+			wio->token = token;
+			wio->dir = dir;
+			wio->addr = addr;
+			wio->bytes = bytes;
+			wio->offset = offset;
+			wio->io_class = io_class;
+			list_add_tail(&wio->list, &bdobj->rebuild_held);
+		} else {
+			/* Cannot be sent before range is copied */
+			ocf_forward_end(token, -OCF_ERR_NO_MEM);
+		}
+		held = true;
+	}
+	spin_unlock_irqrestore(&bdobj->mirror_lock, flags);
+
+	return held;
+}
+
+/*
+ * Reads go to the less busy active member, writes to all members but failed
+ * ones, each of them completing its own reference of forward token.
+ */
+static void block_dev_mirror_forward_io(struct bd_object *bdobj,
+		ocf_forward_token_t token, int dir, uint64_t addr,
+		uint64_t bytes, uint64_t offset, int io_class)
+{
+	int members[CAS_BD_MIRROR_MEMBERS];
+	int count = 0, epoch, i;
+
+	if (dir == OCF_READ) {
+		i = block_dev_mirror_read_member(bdobj);
+		if (i < 0) {
+			ocf_forward_end(token, -OCF_ERR_IO);
+			return;
+		}
+
+		_block_dev_forward_member_io(bdobj, i, -1, token, dir, addr,
+				bytes, offset, io_class);
+		return;
+	}
+
+	epoch = block_dev_mirror_write_enter(bdobj);
+
+	if (block_dev_rebuild_hold(bdobj, token, dir, addr, bytes, offset,
+				io_class)) {
+		block_dev_mirror_write_exit(bdobj, epoch);
+		return;
+	}
+
+	/* State is read after entering epoch to be seen by rebuild */
+	for (i = 0; i < bdobj->members_count; i++) {
+		if (READ_ONCE(bdobj->member_state[i]) !=
+				KCAS_MIRROR_MEMBER_FAILED) {
+			members[count++] = i;
+		}
+	}
+
+	if (!count) {
+		block_dev_mirror_write_exit(bdobj, epoch);
+		ocf_forward_end(token, -OCF_ERR_IO);
+		return;
+	}
+
+	for (i = 1; i < count; i++)
+		ocf_forward_get(token);
+
+	for (i = 0; i < count; i++) {
+		_block_dev_forward_member_io(bdobj, members[i], epoch, token,
+				dir, addr, bytes, offset, io_class);
+	}
+
+	block_dev_mirror_write_exit(bdobj, epoch);
+}
+
+/*
+ * Copy data of I/O directly from/to persistent memory mapped by DAX device,
+ * bypassing block layer. Writes bypass CPU cache, so flush sent down to pmem
+ * driver afterwards is enough to make them durable. FUA writes are completed
+ * by such flush too, as store fence alone doesn't drain write pending queues
+ * of platforms without ADR.
+ */
+static void block_dev_dax_forward_io(struct bd_object *bdobj,
+		ocf_forward_token_t token, int dir, uint64_t addr,
+		uint64_t bytes, uint64_t offset)
+{
+	struct blk_data *data = ocf_forward_get_data(token);
+	struct bio_vec_iter iter;
+	uint64_t pos = bdobj->dax_offset + addr;
+	int error = 0, id;
+
+	cas_io_iter_init(&iter, data->vec, data->size);
+	if (offset != cas_io_iter_move(&iter, offset)) {
+		ocf_forward_end(token, -OCF_ERR_INVAL);
+		return;
+	}
+
+	if (data->inflight)
+		WRITE_ONCE(data->inflight_stage, KCAS_INFLIGHT_STAGE_DEVICE);
+
+	id = dax_read_lock();
+	while (cas_io_iter_is_next(&iter) && bytes) {
+		struct page *page = cas_io_iter_current_page(&iter);
+		uint32_t page_off = cas_io_iter_current_offset(&iter);
+		uint32_t length = min_t(uint64_t, bytes,
+				cas_io_iter_current_length(&iter));
+		uint32_t dax_off = offset_in_page(pos);
+		void *kaddr, *buf;
+		long avail;
+
+		avail = cas_dax_direct_access(bdobj->dax_dev,
+				pos >> PAGE_SHIFT,
+				DIV_ROUND_UP(dax_off + length, PAGE_SIZE), &kaddr);
+		if (avail <= 0) {
+			error = avail ?: -EIO;
+			break;
+		}
+
+		/* Mapping may end before the whole segment */
+		length = min_t(uint64_t, length,
+				(uint64_t)avail * PAGE_SIZE - dax_off);
+
+		buf = kmap_atomic(page);
+		if (dir == OCF_WRITE) {
+			memcpy_flushcache(kaddr + dax_off, buf + page_off,
+					length);
+		} else if (cas_copy_mc_to_kernel(buf + page_off,
+				kaddr + dax_off, length)) {
+			/* Poisoned media is reported as failed read */
+			error = -EIO;
+		}
+		kunmap_atomic(buf);
+
+		if (error)
+			break;
+
+		pos += length;
+		bytes -= length;
+		cas_io_iter_move(&iter, length);
+	}
+	dax_read_unlock(id);
+
+	if (bytes && error == 0)
+		error = -ENOBUFS;
+
+	if (dir == OCF_WRITE)
+		atomic64_inc(&bdobj->write_gen);
+
+	/*
+	 * Flush of pmem block device fences non-temporal stores and flushes
+	 * them through nvdimm_flush(), so FUA write ends with its completion
+	 */
+	if (dir == OCF_WRITE && !error &&
+			(ocf_forward_get_flags(token) & REQ_FUA)) {
+		wmb();
+		_block_dev_forward_flush(bdobj, token);
+		return;
+	}
+
+	ocf_forward_end(token, error);
+}
+
+/*
+ * Complete I/O of null volume right away, or copy its data from/to pages of
+ * RAM-backed volume. Reads of null volume return zeros, unless zero fill is
+ * disabled.
+ */
+static void block_dev_bench_forward_io(struct bd_object *bdobj,
+		ocf_forward_token_t token, int dir, uint64_t addr,
+		uint64_t bytes, uint64_t offset)
+{
+	struct blk_data *data = ocf_forward_get_data(token);
+	struct bio_vec_iter iter;
+	int error = 0;
+
+	if (bdobj->null_dev && (dir == OCF_WRITE || !null_volume_zero_fill)) {
+		ocf_forward_end(token, 0);
+		return;
+	}
+
+	cas_io_iter_init(&iter, data->vec, data->size);
+	if (offset != cas_io_iter_move(&iter, offset)) {
+		ocf_forward_end(token, -OCF_ERR_INVAL);
+		return;
+	}
+
+	while (cas_io_iter_is_next(&iter) && bytes) {
+		uint32_t ram_off = offset_in_page(addr);
+		uint32_t length = min_t(uint64_t, bytes,
+				cas_io_iter_current_length(&iter));
+		struct page *ram_page;
+		void *buf, *ram_buf;
+
+		length = min_t(uint32_t, length, PAGE_SIZE - ram_off);
+
+		ram_page = bdobj->null_dev ? NULL :
+				bdobj->ram_pages[addr >> PAGE_SHIFT];
+
+		buf = kmap_atomic(cas_io_iter_current_page(&iter));
+		buf += cas_io_iter_current_offset(&iter);
+		if (!ram_page) {
+			memset(buf, 0, length);
+		} else {
+			ram_buf = kmap_atomic(ram_page);
+			if (dir == OCF_WRITE)
+				memcpy(ram_buf + ram_off, buf, length);
+			else
+				memcpy(buf, ram_buf + ram_off, length);
+			kunmap_atomic(ram_buf);
+		}
+		kunmap_atomic(buf - cas_io_iter_current_offset(&iter));
+
+		addr += length;
+		bytes -= length;
+		cas_io_iter_move(&iter, length);
+	}
+
+	if (bytes && error == 0)
+		error = -ENOBUFS;
+
+	ocf_forward_end(token, error);
+}
+
+/* Blocks of compressed volume I/O read and written at once */
+#define CAS_BD_COMPRESS_BATCH 16
+
+static struct workqueue_struct *cas_bd_compress_wq;
+
+/*
+ * I/O of compressed volume. Blocks are packed and unpacked by worker, as
+ * slots have to be read before blocks partially overwritten are packed
+ * again, and blocks are written to new slots before old ones are freed.
+ * Writes to the same block never overlap, as OCF locks cache lines.
+ */
+struct cas_bd_compress_io {
+	struct work_struct work;
+	struct bd_object *bdobj;
+	ocf_forward_token_t token;
+	int dir; /* OCF_READ, OCF_WRITE, or -1 for discard */
+	uint64_t addr;
+	uint64_t bytes;
+	uint64_t offset;
+
+	atomic_t remaining;
+	struct completion cmpl;
+	int error;
+
+	void *raw[CAS_BD_COMPRESS_BATCH];
+	void *packed[CAS_BD_COMPRESS_BATCH];
+	struct cas_compress_slot slot[CAS_BD_COMPRESS_BATCH];
+
+	void *verify;
+		/*< Unpacked shared slot compared with block written */
+};
+
+CAS_DECLARE_BLOCK_CALLBACK(cas_bd_compress_end, struct bio *bio,
+		unsigned int bytes_done, int error)
+{
+	struct cas_bd_compress_io *cio;
+	int err;
+
+	CAS_BLOCK_CALLBACK_INIT(bio);
+	cio = bio->bi_private;
+	err = CAS_BLOCK_CALLBACK_ERROR(bio, error);
+	if (err)
+		cmpxchg(&cio->error, 0, err);
+
+	bio_put(bio);
+
+	if (atomic_dec_and_test(&cio->remaining))
+		complete(&cio->cmpl);
+	CAS_BLOCK_CALLBACK_RETURN();
+}
+
+static void block_dev_compress_start(struct cas_bd_compress_io *cio)
+{
+	atomic_set(&cio->remaining, 1);
+	reinit_completion(&cio->cmpl);
+	cio->error = 0;
+}
+
+static void block_dev_compress_submit(struct cas_bd_compress_io *cio,
+		int rw, uint64_t flags, sector_t sector, void *buf,
+		uint32_t length)
+{
+	struct bd_object *bdobj = cio->bdobj;
+	uint32_t bytes = round_up(length, SECTOR_SIZE);
+	struct bio *bio;
+
+	bio = cas_bio_alloc_bioset(bdobj->btm_bd, GFP_NOIO, 1,
+			bdobj->btm_bio_set);
+	if (!bio) {
+		cmpxchg(&cio->error, 0, -ENOMEM);
+		return;
+	}
+
+	CAS_BIO_SET_DEV(bio, bdobj->btm_bd);
+	CAS_BIO_BISECTOR(bio) = sector;
+	CAS_BIO_OP_FLAGS(bio) |= flags;
+	if (bio_add_page(bio, virt_to_page(buf), bytes,
+			offset_in_page(buf)) != bytes) {
+		cmpxchg(&cio->error, 0, -ENOBUFS);
+		bio_put(bio);
+		return;
+	}
+
+	bio->bi_private = cio;
+	bio->bi_end_io = CAS_REFER_BLOCK_CALLBACK(cas_bd_compress_end);
+
+	atomic_inc(&cio->remaining);
+	cas_submit_bio(rw, bio);
+}
+
+static int block_dev_compress_wait(struct cas_bd_compress_io *cio)
+{
+	if (atomic_dec_and_test(&cio->remaining))
+		complete(&cio->cmpl);
+	wait_for_completion(&cio->cmpl);
+
+	return cio->error;
+}
+
+/* Label at start of raw device of compressed volume */
+struct cas_bd_compress_label {
+	char magic[8];
+	__le32 version;
+	__le32 ratio;
+};
+
+static int block_dev_compress_label(struct bd_object *bdobj, uint32_t ratio)
+{
+	struct cas_bd_compress_label *label;
+	struct cas_bd_compress_io *cio;
+	int error;
+
+	cio = kzalloc(sizeof(*cio), GFP_KERNEL);
+	if (!cio)
+		return -ENOMEM;
+
+	label = kzalloc(CAS_COMPRESS_BLOCK_SIZE, GFP_KERNEL);
+	if (!label) {
+		kfree(cio);
+		return -ENOMEM;
+	}
+
+	BUILD_BUG_ON(sizeof(CAS_COMPRESS_LABEL_MAGIC) > sizeof(label->magic));
+	memcpy(label->magic, CAS_COMPRESS_LABEL_MAGIC,
+			sizeof(CAS_COMPRESS_LABEL_MAGIC));
+	label->version = cpu_to_le32(CAS_COMPRESS_LABEL_VERSION);
+	label->ratio = cpu_to_le32(ratio);
+
+	cio->bdobj = bdobj;
+	init_completion(&cio->cmpl);
+	block_dev_compress_start(cio);
+	block_dev_compress_submit(cio, WRITE, REQ_FUA | REQ_SYNC, 0, label,
+			CAS_COMPRESS_LABEL_SECTORS << SECTOR_SHIFT);
+	error = block_dev_compress_wait(cio);
+
+	kfree(label);
+	kfree(cio);
+
+	return error;
+}
+
+/* Bytes of block covered by I/O */
+static void block_dev_compress_range(struct cas_bd_compress_io *cio,
+		uint64_t block, uint32_t *from, uint32_t *to)
+{
+	uint64_t start = block * CAS_COMPRESS_BLOCK_SIZE;
+
+	*from = max(cio->addr, start) - start;
+	*to = min(cio->addr + cio->bytes, start + CAS_COMPRESS_BLOCK_SIZE) -
+			start;
+}
+
+/*
+ * Unpack blocks of batch into raw buffers, all of them for reads and only
+ * those partially overwritten for writes. Blocks not in map are zeros.
+ */
+static int block_dev_compress_load(struct cas_bd_compress_io *cio,
+		uint64_t block, uint32_t count)
+{
+	struct cas_compress *comp = cio->bdobj->comp;
+	bool load[CAS_BD_COMPRESS_BATCH];
+	uint32_t i, from, to;
+	int error;
+
+	block_dev_compress_start(cio);
+	for (i = 0; i < count; i++) {
+		block_dev_compress_range(cio, block + i, &from, &to);
+		load[i] = cio->dir == OCF_READ || from ||
+				to < CAS_COMPRESS_BLOCK_SIZE;
+		cio->slot[i].length = 0;
+
+		if (!load[i] || !cas_compress_lookup(comp, block + i,
+				&cio->slot[i].sector, &cio->slot[i].length)) {
+			continue;
+		}
+
+		block_dev_compress_submit(cio, READ, 0, cio->slot[i].sector,
+				cio->slot[i].length == CAS_COMPRESS_BLOCK_SIZE ?
+				cio->raw[i] : cio->packed[i],
+				cio->slot[i].length);
+	}
+
+	error = block_dev_compress_wait(cio);
+	if (error)
+		return error;
+
+	for (i = 0; i < count; i++) {
+		if (!load[i] || cio->slot[i].length == CAS_COMPRESS_BLOCK_SIZE)
+			continue;
+
+		if (!cio->slot[i].length) {
+			memset(cio->raw[i], 0, CAS_COMPRESS_BLOCK_SIZE);
+		} else if (cas_compress_unpack(comp, cio->packed[i],
+				cio->slot[i].length, cio->raw[i])) {
+			CAS_PRINT_RL(KERN_ERR OCF_PREFIX_SHORT "Corrupted "
+					"block %llu of compressed cache "
+					"device\n", block + i);
+			return -EIO;
+		}
+	}
+
+	return 0;
+}
+
+static int block_dev_compress_read(struct cas_bd_compress_io *cio,
+		struct bio_vec_iter *iter, uint64_t block, uint32_t count)
+{
+	uint32_t i, from, to;
+	int error;
+
+	error = block_dev_compress_load(cio, block, count);
+	if (error)
+		return error;
+
+	for (i = 0; i < count; i++) {
+		block_dev_compress_range(cio, block + i, &from, &to);
+		if (cas_io_iter_cpy_from_data(iter, cio->raw[i] + from,
+				to - from) != to - from) {
+			return -ENOBUFS;
+		}
+	}
+
+	return 0;
+}
+
+/* Shared slot of block of the same fingerprint has to hold the same data */
+static bool block_dev_compress_same(struct cas_bd_compress_io *cio,
+		uint32_t i)
+{
+	if (cio->slot[i].length == CAS_COMPRESS_BLOCK_SIZE) {
+		return !memcmp(cio->packed[i], cio->raw[i],
+				CAS_COMPRESS_BLOCK_SIZE);
+	}
+
+	return !cas_compress_unpack(cio->bdobj->comp, cio->packed[i],
+			cio->slot[i].length, cio->verify) &&
+			!memcmp(cio->verify, cio->raw[i],
+				CAS_COMPRESS_BLOCK_SIZE);
+}
+
+/*
+ * Find slots indexed for blocks of batch identical to the ones written,
+ * which are then not written again. Blocks not found are indexed once
+ * written.
+ */
+static int block_dev_compress_dedup(struct cas_bd_compress_io *cio,
+		uint32_t count)
+{
+	struct cas_compress *comp = cio->bdobj->comp;
+	uint32_t i;
+	int error;
+
+	block_dev_compress_start(cio);
+	for (i = 0; i < count; i++) {
+		cio->slot[i].hash = cas_compress_fingerprint(cio->raw[i]);
+		if (!cas_compress_dedup_get(comp, &cio->slot[i]))
+			continue;
+
+		block_dev_compress_submit(cio, READ, 0, cio->slot[i].sector,
+				cio->packed[i], cio->slot[i].length);
+	}
+
+	error = block_dev_compress_wait(cio);
+
+	for (i = 0; i < count; i++) {
+		if (cio->slot[i].shared && (error ||
+				!block_dev_compress_same(cio, i))) {
+			cas_compress_dedup_put(comp, &cio->slot[i]);
+		}
+	}
+
+	return error;
+}
+
+static int block_dev_compress_write(struct cas_bd_compress_io *cio,
+		struct bio_vec_iter *iter, uint64_t block, uint32_t count,
+		uint32_t io_class, bool dedup)
+{
+	struct cas_compress *comp = cio->bdobj->comp;
+	uint64_t flags = ocf_forward_get_flags(cio->token) &
+			(REQ_FUA | REQ_SYNC);
+	uint32_t i, from, to;
+	int error;
+
+	error = block_dev_compress_load(cio, block, count);
+	if (error)
+		return error;
+
+	for (i = 0; i < count; i++) {
+		block_dev_compress_range(cio, block + i, &from, &to);
+		if (cas_io_iter_cpy_to_data(cio->raw[i] + from, iter,
+				to - from) != to - from) {
+			return -ENOBUFS;
+		}
+
+		cio->slot[i].hash = 0;
+		cio->slot[i].shared = false;
+	}
+
+	if (dedup) {
+		error = block_dev_compress_dedup(cio, count);
+		if (error)
+			return error;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (cio->slot[i].shared)
+			continue;
+
+		cio->slot[i].length = cas_compress_pack(comp, cio->raw[i],
+				cio->packed[i], io_class);
+	}
+
+	error = cas_compress_alloc(comp, cio->slot, count);
+	if (error) {
+		CAS_PRINT_RL(KERN_WARNING OCF_PREFIX_SHORT "Compressed cache "
+				"device is full, data compresses worse than "
+				"its volume assumes\n");
+
+		/* Slots not shared were not allocated at this point */
+		for (i = 0; i < count; i++) {
+			if (cio->slot[i].shared)
+				cas_compress_dedup_put(comp, &cio->slot[i]);
+		}
+
+		return error;
+	}
+
+	block_dev_compress_start(cio);
+	for (i = 0; i < count; i++) {
+		if (cio->slot[i].shared)
+			continue;
+
+		block_dev_compress_submit(cio, WRITE, flags,
+				cio->slot[i].sector,
+				cio->slot[i].length == CAS_COMPRESS_BLOCK_SIZE ?
+				cio->raw[i] : cio->packed[i],
+				cio->slot[i].length);
+	}
+
+	error = block_dev_compress_wait(cio);
+	if (error) {
+		cas_compress_free(comp, cio->slot, count);
+		return error;
+	}
+
+	cas_compress_commit(comp, block, cio->slot, count, io_class);
+
+	return 0;
+}
+
+static void block_dev_compress_free_buffers(struct cas_bd_compress_io *cio)
+{
+	uint32_t i;
+
+	for (i = 0; i < CAS_BD_COMPRESS_BATCH; i++) {
+		kfree(cio->raw[i]);
+		kfree(cio->packed[i]);
+	}
+
+	kfree(cio->verify);
+}
+
+static int block_dev_compress_alloc_buffers(struct cas_bd_compress_io *cio,
+		uint64_t blocks, bool dedup)
+{
+	uint32_t i, count = min_t(uint64_t, blocks, CAS_BD_COMPRESS_BATCH);
+
+	for (i = 0; i < count; i++) {
+		cio->raw[i] = kmalloc(CAS_COMPRESS_BLOCK_SIZE, GFP_NOIO);
+		cio->packed[i] = kmalloc(CAS_COMPRESS_BLOCK_SIZE, GFP_NOIO);
+		if (!cio->raw[i] || !cio->packed[i])
+			return -ENOMEM;
+	}
+
+	if (dedup) {
+		cio->verify = kmalloc(CAS_COMPRESS_BLOCK_SIZE, GFP_NOIO);
+		if (!cio->verify)
+			return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void block_dev_compress_work(struct work_struct *work)
+{
+	struct cas_bd_compress_io *cio = container_of(work,
+			struct cas_bd_compress_io, work);
+	struct bd_object *bdobj = cio->bdobj;
+	struct blk_data *data;
+	struct bio_vec_iter iter;
+	uint64_t block, end;
+	uint32_t count, io_class;
+	bool dedup;
+	int error = 0;
+
+	block = cio->addr / CAS_COMPRESS_BLOCK_SIZE;
+	end = DIV_ROUND_UP(cio->addr + cio->bytes, CAS_COMPRESS_BLOCK_SIZE);
+
+	/* Blocks partially discarded keep their data */
+	if (cio->dir < 0) {
+		block = DIV_ROUND_UP(cio->addr, CAS_COMPRESS_BLOCK_SIZE);
+		end = (cio->addr + cio->bytes) / CAS_COMPRESS_BLOCK_SIZE;
+		if (block < end)
+			cas_compress_discard(bdobj->comp, block, end - block);
+		goto out;
+	}
+
+	data = ocf_forward_get_data(cio->token);
+	io_class = data->io_class < OCF_USER_IO_CLASS_MAX ? data->io_class :
+			CAS_COMPRESS_IO_CLASS_OTHER;
+
+	cas_io_iter_init(&iter, data->vec, data->size);
+	if (cio->offset != cas_io_iter_move(&iter, cio->offset)) {
+		error = -OCF_ERR_INVAL;
+		goto out;
+	}
+
+	if (data->inflight)
+		WRITE_ONCE(data->inflight_stage, KCAS_INFLIGHT_STAGE_DEVICE);
+
+	init_completion(&cio->cmpl);
+	/* Only blocks cache lines are filled clean with are deduplicated */
+	dedup = cio->dir == OCF_WRITE && data->dedup &&
+			cas_compress_get_dedup(bdobj->comp);
+
+	error = block_dev_compress_alloc_buffers(cio, end - block, dedup);
+
+	while (!error && block < end) {
+		count = min_t(uint64_t, end - block, CAS_BD_COMPRESS_BATCH);
+
+		if (cio->dir == OCF_READ) {
+			error = block_dev_compress_read(cio, &iter, block,
+					count);
+		} else {
+			error = block_dev_compress_write(cio, &iter, block,
+					count, io_class, dedup);
+		}
+
+		block += count;
+	}
+
+	block_dev_compress_free_buffers(cio);
+
+	if (cio->dir == OCF_WRITE)
+		atomic64_inc(&bdobj->write_gen);
+
+out:
+	ocf_forward_end(cio->token, error);
+	kfree(cio);
+}
+
+/* May be called in atomic context, so actual I/O is left to worker */
+static void block_dev_compress_queue(struct bd_object *bdobj,
+		ocf_forward_token_t token, int dir, uint64_t addr,
+		uint64_t bytes, uint64_t offset)
+{
+	struct cas_bd_compress_io *cio;
+
+	cio = kzalloc(sizeof(*cio), GFP_ATOMIC);
+	if (!cio) {
+		ocf_forward_end(token, -OCF_ERR_NO_MEM);
+		return;
+	}
+
+	INIT_WORK(&cio->work, block_dev_compress_work);
+	cio->bdobj = bdobj;
+	cio->token = token;
+	cio->dir = dir;
+	cio->addr = addr;
+	cio->bytes = bytes;
+	cio->offset = offset;
+
+	queue_work(cas_bd_compress_wq, &cio->work);
+}
+
+static void _block_dev_forward_io(struct bd_object *bdobj,
+		ocf_forward_token_t token, int dir, uint64_t addr,
+		uint64_t bytes, uint64_t offset, int io_class)
+{
+	block_dev_stage_mark(token, KCAS_IO_STAGE_DEVICE);
+
+	if (bdobj->comp) {
+		block_dev_compress_queue(bdobj, token, dir, addr, bytes,
+				offset);
+		return;
+	}
+
+	if (bdobj->null_dev || bdobj->ram_pages) {
+		block_dev_bench_forward_io(bdobj, token, dir, addr, bytes,
+				offset);
+		return;
+	}
+
+	if (bdobj->dax_dev) {
+		block_dev_dax_forward_io(bdobj, token, dir, addr, bytes,
+				offset);
+		return;
+	}
+
+	if (bdobj->mirrored) {
+		block_dev_mirror_forward_io(bdobj, token, dir, addr, bytes,
+				offset, io_class);
+		return;
+	}
+
+	_block_dev_forward_member_io(bdobj, -1, -1, token, dir, addr, bytes,
+			offset, io_class);
+}
+
+static void block_dev_inflight_work(struct work_struct *work)
+{
+	struct bd_object *bdobj = container_of(work, struct bd_object,
+			inflight_work);
+	struct cas_bd_waiting_io *wio;
+	struct blk_plug plug;
+	bool plugged = false;
+	int io_class;
+
+	while (true) {
+		wio = NULL;
+
+		spin_lock_irq(&bdobj->inflight_lock);
+		block_dev_rate_refill(bdobj);
+		/* Foreground I/O goes first */
+		for (io_class = 0; io_class < CAS_BD_IO_CLASS_MAX; io_class++) {
+			if (!block_dev_inflight_waiting(bdobj, io_class))
+				continue;
+			if (!block_dev_inflight_may_submit(bdobj, io_class))
+				continue;
+
+			if (list_empty(&bdobj->inflight_waiting[io_class])) {
+				wio = block_dev_sweep_next(bdobj);
+			} else {
+				wio = list_first_entry(
+						&bdobj->inflight_waiting[io_class],
+						struct cas_bd_waiting_io, list);
+				list_del(&wio->list);
+			}
+			block_dev_rate_charge(bdobj, io_class, wio->bytes);
+			break;
+		}
+		if (!wio)
+			block_dev_rate_schedule(bdobj);
+		spin_unlock_irq(&bdobj->inflight_lock);
+
+		if (!wio)
+			break;
+
+		/*
+		 * Consecutive background writes share plug, so neighbours
+		 * of sweep get merged. Foreground I/O may be polled, which
+		 * cannot be plugged.
+		 */
+		if (io_class == CAS_BD_IO_BACKGROUND && !plugged) {
+			blk_start_plug(&plug);
+			plugged = true;
+		} else if (io_class != CAS_BD_IO_BACKGROUND && plugged) {
+			blk_finish_plug(&plug);
+			plugged = false;
+		}
+
+		_block_dev_forward_io(bdobj, wio->token, wio->dir, wio->addr,
+				wio->bytes, wio->offset, io_class);
+		kfree(wio);
+	}
+
+	if (plugged)
+		blk_finish_plug(&plug);
+}
+
+static void block_dev_sweep_work(struct work_struct *work)
+{
+	struct bd_object *bdobj = container_of(to_delayed_work(work),
+			struct bd_object, sweep_work);
+
+	spin_lock_irq(&bdobj->inflight_lock);
+	if (bdobj->sweep_count)
+		bdobj->sweep_ready = true;
+	spin_unlock_irq(&bdobj->inflight_lock);
+
+	queue_work(system_unbound_wq, &bdobj->inflight_work);
+}
+
+static void block_dev_rate_work(struct work_struct *work)
+{
+	struct bd_object *bdobj = container_of(to_delayed_work(work),
+			struct bd_object, rate_work);
+
+	queue_work(system_unbound_wq, &bdobj->inflight_work);
+}
+
+/*
+ * Mark chunks written for background trim and hold writes to chunks being
+ * discarded, so that discard never lands after data written meanwhile.
+ * Marking is ordered before checking fence, and fencing before checking
+ * marks, so either write is held or chunk is left out of fence. Returns true
+ * if write has been held.
+ */
+static bool block_dev_trim_hold(struct bd_object *bdobj,
+		ocf_forward_token_t token, int dir, uint64_t addr,
+		uint64_t bytes, uint64_t offset)
+{
+	struct cas_bd_waiting_io *wio;
+	uint64_t first, last, chunk;
+	unsigned long *written;
+	unsigned long flags;
+	bool held = false;
+
+	if (dir != OCF_WRITE)
+		return false;
+
+	rcu_read_lock();
+	written = rcu_dereference(bdobj->trim_written);
+	if (!written || addr + bytes <= bdobj->trim_base)
+		goto out;
+
+	first = (max(addr, bdobj->trim_base) - bdobj->trim_base) >>
+			CAS_BD_TRIM_CHUNK_SHIFT;
+	last = min((addr + bytes - 1 - bdobj->trim_base) >>
+			CAS_BD_TRIM_CHUNK_SHIFT, bdobj->trim_chunks - 1);
+	for (chunk = first; chunk <= last; chunk++)
+		set_bit(chunk, written);
+	smp_mb__after_atomic();
+
+	if (!READ_ONCE(bdobj->trim_fencing))
+		goto out;
+
+	spin_lock_irqsave(&bdobj->trim_lock, flags);
+	if (bdobj->trim_fencing && first < bdobj->trim_fence_end &&
+			last >= bdobj->trim_fence_start) {
+		wio = kmalloc(sizeof(*wio), GFP_ATOMIC);
+		if (wio) {
+			wio->token = token;
+			wio->dir = dir;
+			wio->addr = addr;
+			wio->bytes = bytes;
+			wio->offset = offset;
+			list_add_tail(&wio->list, &bdobj->trim_held);
+		} else {
+			/* Cannot be sent before discard completes */
+			ocf_forward_end(token, -OCF_ERR_NO_MEM);
+		}
+		held = true;
+	}
+	spin_unlock_irqrestore(&bdobj->trim_lock, flags);
+
+out:
+	rcu_read_unlock();
+	return held;
+}
+
+static void _block_dev_forward_io_classify(struct bd_object *bdobj,
+		ocf_forward_token_t token, int dir, uint64_t addr,
+		uint64_t bytes, uint64_t offset)
+{
+	int io_class = block_dev_io_class(bdobj, dir,
+			ocf_forward_get_flags(token));
+
+	if (block_dev_inflight_wait(bdobj, io_class, token, dir, addr,
+				bytes, offset)) {
+		return;
+	}
+
+	_block_dev_forward_io(bdobj, token, dir, addr, bytes, offset,
+			io_class);
+}
+
+/* Held writes behind gap in zone longer than that fail */
+#define CAS_BD_ZONE_GAP_TIMEOUT (5 * HZ)
+
+/* Called under zone lock, lists zone for work to look at */
+static void block_dev_zone_pend(struct bd_object *bdobj,
+		struct cas_bd_zone *zone)
+{
+	if (list_empty(&zone->pending_node))
+		list_add_tail(&zone->pending_node, &bdobj->zone_pending);
+}
+
+static void block_dev_zone_put(struct bd_object *bdobj, uint32_t idx,
+		int error)
+{
+	struct cas_bd_zone *zone = &bdobj->zones[idx];
+	unsigned long flags;
+	bool kick;
+
+	/* Device may have written only part of failed write */
+	if (error)
+		WRITE_ONCE(zone->resync, true);
+
+	if (!atomic_dec_and_test(&zone->bios))
+		return;
+
+	spin_lock_irqsave(&bdobj->zone_lock, flags);
+	zone->busy = false;
+	zone->stamp = jiffies;
+	kick = !list_empty(&zone->held) || zone->resync;
+	if (kick)
+		block_dev_zone_pend(bdobj, zone);
+	spin_unlock_irqrestore(&bdobj->zone_lock, flags);
+
+	wake_up(&bdobj->zone_wait);
+
+	if (kick)
+		mod_delayed_work(system_unbound_wq, &bdobj->zone_work, 0);
+}
+
+/* Called under zone lock for write starting at write pointer */
+static void block_dev_zone_advance(struct cas_bd_zone *zone, uint64_t bytes)
+{
+	zone->busy = true;
+	zone->wp += bytes;
+	zone->stamp = jiffies;
+}
+
+static void block_dev_zone_write(struct bd_object *bdobj,
+		ocf_forward_token_t token, uint64_t addr, uint64_t bytes,
+		uint64_t offset)
+{
+	uint32_t idx = addr >> bdobj->zone_shift;
+	struct cas_bd_zone *zone = &bdobj->zones[idx];
+	struct cas_bd_waiting_io *wio, *pos;
+	unsigned long flags;
+	bool kick, gap;
+
+	spin_lock_irqsave(&bdobj->zone_lock, flags);
+
+	if (zone->wp == U64_MAX) {
+		/* Conventional zone takes writes in any order */
+		spin_unlock_irqrestore(&bdobj->zone_lock, flags);
+		_block_dev_forward_io_classify(bdobj, token, OCF_WRITE, addr,
+				bytes, offset);
+		return;
+	}
+
+	if (addr < zone->wp && !zone->resync) {
+		spin_unlock_irqrestore(&bdobj->zone_lock, flags);
+		CAS_PRINT_RL(KERN_ERR "Write behind write pointer of zone %u "
+				"of zoned device\n", idx);
+		ocf_forward_end(token, -EIO);
+		return;
+	}
+
+	if (addr == zone->wp && !zone->busy && !zone->resync &&
+			list_empty(&zone->held)) {
+		block_dev_zone_advance(zone, bytes);
+		spin_unlock_irqrestore(&bdobj->zone_lock, flags);
+		_block_dev_forward_io_classify(bdobj, token, OCF_WRITE, addr,
+				bytes, offset);
+		return;
+	}
+
+	wio = kmalloc(sizeof(*wio), GFP_ATOMIC);
+	if (!wio) {
+		spin_unlock_irqrestore(&bdobj->zone_lock, flags);
+		ocf_forward_end(token, -OCF_ERR_NO_MEM);
+		return;
+	}
+
+	wio->token = token;
+	wio->dir = OCF_WRITE;
+	wio->addr = addr;
+	wio->bytes = bytes;
+	wio->offset = offset;
+
+	/* Writes mostly come in ascending order, so search from the end */
+	list_for_each_entry_reverse(pos, &zone->held, list) {
+		if (pos->addr <= addr)
+			break;
+	}
+	list_add(&wio->list, &pos->list);
+
+	if (list_empty(&zone->pending_node))
+		zone->stamp = jiffies;
+	block_dev_zone_pend(bdobj, zone);
+
+	/*
+	 * Write waiting only for write in flight is sent on its completion,
+	 * the one waiting for resync of write pointer is looked at right away
+	 */
+	kick = !zone->busy && addr <= zone->wp;
+	gap = addr > zone->wp;
+	spin_unlock_irqrestore(&bdobj->zone_lock, flags);
+
+	if (kick) {
+		mod_delayed_work(system_unbound_wq, &bdobj->zone_work, 0);
+	} else if (gap) {
+		queue_delayed_work(system_unbound_wq, &bdobj->zone_work,
+				CAS_BD_ZONE_GAP_TIMEOUT);
+	}
+}
+
+/*
+ * Writes to sequential zones of host-managed zoned device are sent one at a
+ * time at write pointer of zone, in order of address regardless of order OCF
+ * issues them in, e.g. when cleaning dirty lines of core. Writes beyond
+ * write pointer wait for the gap before them to be filled, and once it is
+ * not for CAS_BD_ZONE_GAP_TIMEOUT, they fail, so that cleaned lines stay
+ * dirty and are written again later. Gap is never filled with zeros, as
+ * data of it may still be dirty in cache. Writes behind write pointer
+ * cannot be done without resetting zone and fail.
+ */
+static bool block_dev_zone_hold(struct bd_object *bdobj,
+		ocf_forward_token_t token, int dir, uint64_t addr,
+		uint64_t bytes, uint64_t offset)
+{
+	uint64_t zone_size, part;
+
+	if (!bdobj->zones || dir != OCF_WRITE)
+		return false;
+
+	/* Each part of write crossing zones is sequenced in its zone */
+	zone_size = 1ULL << bdobj->zone_shift;
+	while (bytes) {
+		part = min(bytes, round_down(addr, zone_size) + zone_size -
+				addr);
+
+		ocf_forward_get(token);
+		block_dev_zone_write(bdobj, token, addr, part, offset);
+
+		addr += part;
+		offset += part;
+		bytes -= part;
+	}
+
+	ocf_forward_end(token, 0);
+
+	return true;
+}
+
+/*
+ * Send held writes which reached write pointer of their zone, fail those
+ * left behind it and those behind gaps held for too long
+ */
+static bool block_dev_zone_process(struct bd_object *bdobj, uint32_t idx,
+		struct list_head *failed, struct list_head *expired)
+{
+	struct cas_bd_zone *zone = &bdobj->zones[idx];
+	struct cas_bd_waiting_io *wio;
+	bool waiting = false;
+
+	spin_lock_irq(&bdobj->zone_lock);
+	while (!zone->busy) {
+		if (zone->resync) {
+			zone->busy = true;
+			spin_unlock_irq(&bdobj->zone_lock);
+
+			block_dev_zone_resync(bdobj, idx);
+
+			spin_lock_irq(&bdobj->zone_lock);
+			zone->busy = false;
+			continue;
+		}
+
+		wio = list_first_entry_or_null(&zone->held,
+				struct cas_bd_waiting_io, list);
+		if (!wio)
+			break;
+
+		if (wio->addr < zone->wp) {
+			list_move_tail(&wio->list, failed);
+			continue;
+		}
+
+		if (wio->addr == zone->wp) {
+			list_del(&wio->list);
+			block_dev_zone_advance(zone, wio->bytes);
+			spin_unlock_irq(&bdobj->zone_lock);
+
+			_block_dev_forward_io_classify(bdobj, wio->token,
+					wio->dir, wio->addr, wio->bytes,
+					wio->offset);
+			kfree(wio);
+
+			spin_lock_irq(&bdobj->zone_lock);
+			continue;
+		}
+
+		if (time_before(jiffies, zone->stamp +
+				CAS_BD_ZONE_GAP_TIMEOUT)) {
+			block_dev_zone_pend(bdobj, zone);
+			waiting = true;
+			break;
+		}
+
+		/* All remaining writes are beyond the gap */
+		list_splice_tail_init(&zone->held, expired);
+		zone->stamp = jiffies;
+	}
+	spin_unlock_irq(&bdobj->zone_lock);
+
+	wake_up(&bdobj->zone_wait);
+
+	return waiting;
+}
+
+static void block_dev_zone_work(struct work_struct *work)
+{
+	struct bd_object *bdobj = container_of(to_delayed_work(work),
+			struct bd_object, zone_work);
+	struct cas_bd_waiting_io *wio, *tmp;
+	struct cas_bd_zone *zone;
+	bool waiting = false;
+	LIST_HEAD(pending);
+	LIST_HEAD(failed);
+	LIST_HEAD(expired);
+
+	spin_lock_irq(&bdobj->zone_lock);
+	list_splice_init(&bdobj->zone_pending, &pending);
+	spin_unlock_irq(&bdobj->zone_lock);
+
+	while (true) {
+		spin_lock_irq(&bdobj->zone_lock);
+		zone = list_first_entry_or_null(&pending, struct cas_bd_zone,
+				pending_node);
+		if (zone)
+			list_del_init(&zone->pending_node);
+		spin_unlock_irq(&bdobj->zone_lock);
+
+		if (!zone)
+			break;
+
+		if (block_dev_zone_process(bdobj, zone - bdobj->zones,
+				&failed, &expired)) {
+			waiting = true;
+		}
+	}
+
+	list_for_each_entry_safe(wio, tmp, &failed, list) {
+		list_del(&wio->list);
+		CAS_PRINT_RL(KERN_ERR "Write behind write pointer of zoned "
+				"device\n");
+		ocf_forward_end(wio->token, -EIO);
+		kfree(wio);
+	}
+
+	list_for_each_entry_safe(wio, tmp, &expired, list) {
+		list_del(&wio->list);
+		CAS_PRINT_RL(KERN_WARNING "Write beyond gap not filled in "
+				"time in zone of zoned device\n");
+		ocf_forward_end(wio->token, -EIO);
+		kfree(wio);
+	}
+
+	if (waiting) {
+		queue_delayed_work(system_unbound_wq, &bdobj->zone_work,
+				CAS_BD_ZONE_GAP_TIMEOUT);
+	}
+}
+
+/* Hash of next page of data, 0 if data runs out before its end */
+static uint64_t block_dev_meta_hash_iter(struct bio_vec_iter *iter)
+{
+	uint32_t left = PAGE_SIZE, chunk;
+	struct xxh64_state state;
+
+	xxh64_reset(&state, 0);
+	while (left && cas_io_iter_is_next(iter)) {
+		chunk = min(left, cas_io_iter_current_length(iter));
+		xxh64_update(&state,
+				page_address(cas_io_iter_current_page(iter)) +
+				cas_io_iter_current_offset(iter), chunk);
+		cas_io_iter_move(iter, chunk);
+		left -= chunk;
+	}
+
+	return left ? 0 : (xxh64_digest(&state) ?: 1);
+}
+
+/* Forward @pages changed pages of write starting at page @first of it */
+static void block_dev_meta_elide_run(struct bd_object *bdobj,
+		ocf_forward_token_t token, uint64_t addr, uint64_t offset,
+		uint64_t first, uint64_t pages)
+{
+	uint64_t skip = first << PAGE_SHIFT, bytes = pages << PAGE_SHIFT;
+
+	/* Each run holds reference of its own until completed */
+	ocf_forward_get(token);
+
+	if (block_dev_meta_co_hold(bdobj, token, OCF_WRITE, addr + skip,
+				bytes, offset + skip)) {
+		return;
+	}
+
+	_block_dev_forward_io_classify(bdobj, token, OCF_WRITE, addr + skip,
+			bytes, offset + skip);
+}
+
+/*
+ * Leave out pages of metadata write unchanged since last read from or
+ * written to device, so that e.g. cache stop writes only what changed since
+ * load. Runs of changed pages are sent as writes of their own. Pages being
+ * written are not known until their bios complete. Writes which have to be
+ * sent as they are, i.e. to zones, atomic, FUA or with preflush, are not
+ * elided. Returns true if any page has been left out.
+ */
+static bool block_dev_meta_elide(struct bd_object *bdobj,
+		ocf_forward_token_t token, int dir, uint64_t addr,
+		uint64_t bytes, uint64_t offset)
+{
+	uint64_t flags = ocf_forward_get_flags(token);
+	uint64_t pages, i, run = 0, elided = 0, hash, *slot;
+	struct blk_data *data;
+	struct bio_vec_iter iter;
+	bool same;
+
+	if (dir != OCF_WRITE || addr + bytes > READ_ONCE(bdobj->meta_hash_end))
+		return false;
+
+	if (!PAGE_ALIGNED(addr) || !PAGE_ALIGNED(bytes) ||
+			(flags & REQ_FUA) || CAS_IS_SET_FLUSH(flags)) {
+		return false;
+	}
+
+	/* Only bios sent to block device as they are teach page hashes */
+	if (bdobj->comp || bdobj->dax_dev || bdobj->null_dev ||
+			bdobj->ram_pages || bdobj->zones ||
+			bdobj->atomic_meta_end) {
+		return false;
+	}
+
+	data = ocf_forward_get_data(token);
+	cas_io_iter_init(&iter, data->vec, data->size);
+	if (offset != cas_io_iter_move(&iter, offset))
+		return false;
+
+	pages = bytes >> PAGE_SHIFT;
+	for (i = 0; i < pages; i++) {
+		hash = block_dev_meta_hash_iter(&iter);
+
+		rcu_read_lock();
+		slot = block_dev_meta_hash_slot(bdobj,
+				(addr >> PAGE_SHIFT) + i, false);
+		same = slot && hash && READ_ONCE(*slot) == hash;
+		if (slot && !same)
+			WRITE_ONCE(*slot, 0);
+		rcu_read_unlock();
+
+		if (!same) {
+			run++;
+			continue;
+		}
+
+		/* Forwarding may sleep, so it is done outside RCU section */
+		if (run) {
+			block_dev_meta_elide_run(bdobj, token, addr, offset,
+					i - run, run);
+		}
+		run = 0;
+		elided++;
+	}
+
+	if (!elided)
+		return false;
+
+	if (run) {
+		block_dev_meta_elide_run(bdobj, token, addr, offset,
+				pages - run, run);
+	}
+
+	atomic64_add(elided, &bdobj->meta_elided);
+	ocf_forward_end(token, 0);
+
+	return true;
+}
+
+static void block_dev_forward_io(ocf_volume_t volume,
+		ocf_forward_token_t token, int dir, uint64_t addr,
+		uint64_t bytes, uint64_t offset)
+{
+	struct bd_object *bdobj = bd_object(volume);
+
+	if (block_dev_zone_hold(bdobj, token, dir, addr, bytes, offset))
+		return;
+
+	if (block_dev_trim_hold(bdobj, token, dir, addr, bytes, offset))
+		return;
+
+	if (block_dev_meta_elide(bdobj, token, dir, addr, bytes, offset))
+		return;
+
+	if (block_dev_meta_co_hold(bdobj, token, dir, addr, bytes, offset))
+		return;
+
+	_block_dev_forward_io_classify(bdobj, token, dir, addr, bytes, offset);
+}
+
+CAS_DECLARE_BLOCK_CALLBACK(cas_bd_flush_end, struct bio *bio,
+		unsigned int bytes_done, int error)
+{
+	struct cas_bd_bio *bd_bio = cas_bd_bio(bio);
+	atomic64_t *flushed_gen = &bd_bio->bdobj->flushed_gen;
+	uint64_t gen, prev;
+	int err;
+
+	CAS_BLOCK_CALLBACK_INIT(bio);
+	err = CAS_BLOCK_CALLBACK_ERROR(bio, error);
+
+	/* Flushes may complete out of order, keep the newest generation */
+	gen = atomic64_read(flushed_gen);
+	while (!err && gen < bd_bio->flush_gen) {
+		prev = atomic64_cmpxchg(flushed_gen, gen, bd_bio->flush_gen);
+		if (prev == gen)
+			break;
+		gen = prev;
+	}
+
+	if (bd_bio->member >= 0)
+		err = block_dev_mirror_end(bd_bio, WRITE, err);
+
+	ocf_forward_end(bd_bio->token, err);
+
+	bio_put(bio);
+	CAS_BLOCK_CALLBACK_RETURN();
+}
+
+static void _block_dev_forward_flush(struct bd_object *bdobj,
+		ocf_forward_token_t token)
+{
+	struct request_queue *q = bdev_get_queue(bdobj->btm_bd);
+	uint64_t write_gen;
+	struct bio *bio;
+	int i;
+
+	if (!q) {
+		/* No queue, error */
+		ocf_forward_end(token, -OCF_ERR_INVAL);
+		return;
+	}
+
+	if (!CAS_CHECK_QUEUE_FLUSH(q)) {
+		/* This block device does not support flush, call back */
+		ocf_forward_end(token, 0);
+		return;
+	}
+
+	/*
+	 * Writes completed after this point bump generation, so they are
+	 * never covered by flush elided or sent below.
+	 */
+	write_gen = atomic64_read(&bdobj->write_gen);
+	if (write_gen == atomic64_read(&bdobj->flushed_gen)) {
+		/* Nothing written since last completed flush */
+		atomic64_inc(&bdobj->flushes_elided);
+		ocf_forward_end(token, 0);
+		return;
+	}
+
+	/*
+	 * Each member of striped volume is flushed separately. Completion of
+	 * one of them doesn't make the volume flushed, so such flushes are
+	 * never elided.
+	 */
+	if (bdobj->members_count > 1)
+		write_gen = 0;
+
+	for (i = 1; i < bdobj->members_count; i++)
+		ocf_forward_get(token);
+
+	for (i = 0; i < bdobj->members_count; i++) {
+		/* Failed member of mirrored volume is left out of sync anyway */
+		if (bdobj->mirrored && READ_ONCE(bdobj->member_state[i]) ==
+				KCAS_MIRROR_MEMBER_FAILED) {
+			ocf_forward_end(token, 0);
+			continue;
+		}
+
+		bio = cas_bd_alloc_bio(bdobj, 0, token);
+		if (!bio) {
+			CAS_PRINT_RL(KERN_ERR "Couldn't allocate memory for BIO\n");
+			ocf_forward_end(token, -OCF_ERR_NO_MEM);
+			continue;
+		}
+
+		if (bdobj->mirrored)
+			cas_bd_bio(bio)->member = i;
+		CAS_BIO_SET_DEV(bio, bdobj->member_bd[i]);
+		cas_bd_bio(bio)->flush_gen = write_gen;
+		bio->bi_end_io = CAS_REFER_BLOCK_CALLBACK(cas_bd_flush_end);
+
+		cas_bd_submit_bio(bdobj, CAS_SET_FLUSH(WRITE), bio);
+	}
+}
+
+static void block_dev_forward_flush(ocf_volume_t volume,
+		ocf_forward_token_t token)
+{
+	struct bd_object *bdobj = bd_object(volume);
+
+	if (block_dev_meta_co_hold_flush(bdobj, token))
+		return;
+
+	_block_dev_forward_flush(bdobj, token);
+}
+
+/* Pages buffered by metadata coalescing before writeback is started */
+#define CAS_BD_META_CO_PAGES_MAX 1024
+
+/* Larger metadata writes are sequential enough to be sent as they are */
+#define CAS_BD_META_CO_IO_MAX (16 * PAGE_SIZE)
+
+/* Pages written back by single bio */
+#define CAS_BD_META_CO_RUN_MAX 256
+
+/* Direction of flush held by metadata coalescing */
+#define CAS_BD_META_CO_FLUSH -1
+
+/*
+ * Copy page aligned metadata write into buffered pages. Called under
+ * coalescing lock, returns false if write cannot be buffered. Pages copied
+ * before failure hold the same data the write is sent with later on.
+ */
+static bool block_dev_meta_co_put(struct cas_bd_meta_co *mc,
+		ocf_forward_token_t token, uint64_t addr, uint64_t bytes,
+		uint64_t offset)
+{
+	struct blk_data *data = ocf_forward_get_data(token);
+	struct cas_bd_meta_page *mp;
+	struct bio_vec_iter iter;
+	struct page *page;
+	uint64_t idx;
+
+	if (!PAGE_ALIGNED(addr) || !PAGE_ALIGNED(bytes) ||
+			bytes > CAS_BD_META_CO_IO_MAX ||
+			addr + bytes > mc->end) {
+		return false;
+	}
+
+	cas_io_iter_init(&iter, data->vec, data->size);
+	if (offset != cas_io_iter_move(&iter, offset))
+		return false;
+
+	for (idx = addr >> PAGE_SHIFT; idx < (addr + bytes) >> PAGE_SHIFT;
+			idx++) {
+		mp = xa_load(&mc->pages, idx);
+		page = mp ? mp->page : NULL;
+		if (!page) {
+			if (mc->count >= CAS_BD_META_CO_PAGES_MAX)
+				return false;
+
+			page = alloc_page(GFP_ATOMIC | __GFP_NOWARN);
+			if (!page)
+				return false;
+		}
+
+		if (!mp) {
+			mp = kmalloc(sizeof(*mp), GFP_ATOMIC | __GFP_NOWARN);
+			if (mp)
+				mp->wb = NULL;
+			if (!mp || xa_is_err(xa_store(&mc->pages, idx, mp,
+						GFP_ATOMIC | __GFP_NOWARN))) {
+				kfree(mp);
+				__free_page(page);
+				return false;
+			}
+		}
+
+		if (!mp->page) {
+			mp->page = page;
+			if (!mc->count++) {
+				queue_delayed_work(system_unbound_wq, &mc->work,
+					usecs_to_jiffies(
+						READ_ONCE(mc->window_us)));
+			}
+		}
+
+		cas_io_iter_cpy_to_data(page_address(page), &iter, PAGE_SIZE);
+	}
+
+	if (mc->count >= CAS_BD_META_CO_PAGES_MAX)
+		mod_delayed_work(system_unbound_wq, &mc->work, 0);
+
+	return true;
+}
+
+/* Range overlaps pages buffered or being written back */
+static bool block_dev_meta_co_busy(struct cas_bd_meta_co *mc, uint64_t addr,
+		uint64_t bytes)
+{
+	unsigned long first = addr >> PAGE_SHIFT;
+	unsigned long last = (min(addr + bytes, mc->end) - 1) >> PAGE_SHIFT;
+
+	return xa_find(&mc->pages, &first, last, XA_PRESENT);
+}
+
+/*
+ * Queue I/O to be sent once buffered pages are written back. Called under
+ * coalescing lock, returns false if there is no memory to do so.
+ */
+static bool block_dev_meta_co_queue(struct cas_bd_meta_co *mc,
+		ocf_forward_token_t token, int dir, uint64_t addr,
+		uint64_t bytes, uint64_t offset)
+{
+	struct cas_bd_waiting_io *wio;
+
+	wio = kmalloc(sizeof(*wio), GFP_ATOMIC);
+	if (!wio)
+		return false;
+
+	wio->token = token;
+	wio->dir = dir;
+	wio->addr = addr;
+	wio->bytes = bytes;
+	wio->offset = offset;
+	list_add_tail(&wio->list, &mc->held);
+
+	mod_delayed_work(system_unbound_wq, &mc->work, 0);
+
+	return true;
+}
+
+/*
+ * Complete metadata writes once buffered, so that updates of the same pages
+ * arriving within window are written back once and neighbouring pages
+ * together. Reads and writes which cannot be buffered wait for writeback of
+ * pages they overlap, FUA writes for writeback of all of them. Once any I/O
+ * waits, metadata I/O following it waits as well to keep their order.
+ * Returns true if I/O has been absorbed or held.
+ */
+static bool block_dev_meta_co_hold(struct bd_object *bdobj,
+		ocf_forward_token_t token, int dir, uint64_t addr,
+		uint64_t bytes, uint64_t offset)
+{
+	uint64_t flags = ocf_forward_get_flags(token);
+	bool ordered = dir == OCF_WRITE && ((flags & REQ_FUA) ||
+			CAS_IS_SET_FLUSH(flags));
+	struct cas_bd_meta_co *mc;
+	bool held = false, absorbed = false, queued = true;
+	unsigned long irq_flags;
+
+	rcu_read_lock();
+	mc = rcu_dereference(bdobj->meta_co);
+	if (!mc || (addr >= mc->end && !ordered))
+		goto out;
+
+	spin_lock_irqsave(&mc->lock, irq_flags);
+	if (ordered) {
+		held = mc->count || mc->writeback || !list_empty(&mc->held);
+	} else if (list_empty(&mc->held) && dir == OCF_WRITE &&
+			block_dev_meta_co_put(mc, token, addr, bytes, offset)) {
+		absorbed = true;
+	} else {
+		held = !list_empty(&mc->held) ||
+				block_dev_meta_co_busy(mc, addr, bytes);
+	}
+	if (held) {
+		queued = block_dev_meta_co_queue(mc, token, dir, addr, bytes,
+				offset);
+	}
+	spin_unlock_irqrestore(&mc->lock, irq_flags);
+
+	if (absorbed) {
+		atomic64_inc(&mc->absorbed);
+		ocf_forward_end(token, 0);
+	} else if (!queued) {
+		/* Cannot be sent before pages it overlaps are written back */
+		ocf_forward_end(token, -OCF_ERR_NO_MEM);
+	}
+
+out:
+	rcu_read_unlock();
+	return held || absorbed;
+}
+
+/*
+ * Hold flush until buffered pages are written back. Writeback error not yet
+ * returned is returned by the flush instead of sending it.
+ */
+static bool block_dev_meta_co_hold_flush(struct bd_object *bdobj,
+		ocf_forward_token_t token)
+{
+	struct cas_bd_meta_co *mc;
+	bool held = false, queued = true;
+	unsigned long irq_flags;
+	int error = 0;
+
+	rcu_read_lock();
+	mc = rcu_dereference(bdobj->meta_co);
+	if (!mc)
+		goto out;
+
+	spin_lock_irqsave(&mc->lock, irq_flags);
+	if (mc->count || mc->writeback || !list_empty(&mc->held)) {
+		held = true;
+		queued = block_dev_meta_co_queue(mc, token,
+				CAS_BD_META_CO_FLUSH, 0, 0, 0);
+	} else if (mc->error) {
+		held = true;
+		error = mc->error;
+		mc->error = 0;
+	}
+	spin_unlock_irqrestore(&mc->lock, irq_flags);
+
+	if (!queued)
+		ocf_forward_end(token, -OCF_ERR_NO_MEM);
+	else if (error)
+		ocf_forward_end(token, error);
+
+out:
+	rcu_read_unlock();
+	return held;
+}
+
+struct cas_bd_meta_co_io {
+	atomic_t remaining;
+	struct completion cmpl;
+	int error;
+};
+
+CAS_DECLARE_BLOCK_CALLBACK(cas_bd_meta_co_end, struct bio *bio,
+		unsigned int bytes_done, int error)
+{
+	struct cas_bd_meta_co_io *mio;
+	int err;
+
+	CAS_BLOCK_CALLBACK_INIT(bio);
+	mio = bio->bi_private;
+	err = CAS_BLOCK_CALLBACK_ERROR(bio, error);
+	if (err)
+		cmpxchg(&mio->error, 0, err);
+
+	bio_put(bio);
+
+	if (atomic_dec_and_test(&mio->remaining))
+		complete(&mio->cmpl);
+	CAS_BLOCK_CALLBACK_RETURN();
+}
+
+static void block_dev_meta_co_submit(struct cas_bd_meta_co *mc,
+		struct cas_bd_meta_co_io *mio, struct bio *bio)
+{
+	atomic_inc(&mio->remaining);
+	atomic64_inc(&mc->writes);
+	cas_bd_submit_bio(mc->bdobj, WRITE, bio);
+}
+
+/* Write pages taken for writeback, contiguous ones by single bio */
+static int block_dev_meta_co_write(struct bd_object *bdobj,
+		struct cas_bd_meta_co *mc)
+{
+	struct cas_bd_meta_co_io mio;
+	struct cas_bd_meta_page *mp;
+	struct bio *bio = NULL;
+	unsigned long idx, next = 0;
+	uint32_t pages = 0;
+
+	atomic_set(&mio.remaining, 1);
+	init_completion(&mio.cmpl);
+	mio.error = 0;
+
+	xa_for_each(&mc->pages, idx, mp) {
+		if (!mp->wb)
+			continue;
+
+		if (bio && (idx != next || pages == CAS_BD_META_CO_RUN_MAX)) {
+			block_dev_meta_co_submit(mc, &mio, bio);
+			bio = NULL;
+		}
+
+		if (!bio) {
+			bio = cas_bio_alloc_bioset(bdobj->btm_bd, GFP_NOIO,
+					CAS_BD_META_CO_RUN_MAX,
+					bdobj->btm_bio_set);
+			if (!bio) {
+				mio.error = -ENOMEM;
+				break;
+			}
+
+			CAS_BIO_SET_DEV(bio, bdobj->btm_bd);
+			CAS_BIO_BISECTOR(bio) = (sector_t)idx <<
+					(PAGE_SHIFT - SECTOR_SHIFT);
+			bio->bi_private = &mio;
+			bio->bi_end_io = CAS_REFER_BLOCK_CALLBACK(
+					cas_bd_meta_co_end);
+			pages = 0;
+		}
+
+		if (bio_add_page(bio, mp->wb, PAGE_SIZE, 0) != PAGE_SIZE) {
+			mio.error = -ENOBUFS;
+			break;
+		}
+
+		pages++;
+		next = idx + 1;
+	}
+
+	if (bio && pages && !mio.error)
+		block_dev_meta_co_submit(mc, &mio, bio);
+	else if (bio)
+		bio_put(bio);
+
+	if (atomic_dec_and_test(&mio.remaining))
+		complete(&mio.cmpl);
+	wait_for_completion(&mio.cmpl);
+
+	/* Written pages have to be covered by flush reaching device */
+	atomic64_inc(&bdobj->write_gen);
+
+	return mio.error;
+}
+
+/*
+ * Write back pages buffered so far, and then the rest of them as long as
+ * any I/O waits, and send held I/O once no page is left
+ */
+static void block_dev_meta_co_drain(struct bd_object *bdobj,
+		struct cas_bd_meta_co *mc)
+{
+	struct cas_bd_waiting_io *wio, *tmp;
+	struct cas_bd_meta_page *mp;
+	unsigned long idx;
+	bool first = true;
+	LIST_HEAD(held);
+	int error;
+
+	while (true) {
+		spin_lock_irq(&mc->lock);
+		if (!mc->count || (!first && list_empty(&mc->held))) {
+			if (!mc->count)
+				list_splice_init(&mc->held, &held);
+			spin_unlock_irq(&mc->lock);
+			break;
+		}
+
+		xa_for_each(&mc->pages, idx, mp) {
+			if (mp->page) {
+				mp->wb = mp->page;
+				mp->page = NULL;
+			}
+		}
+		mc->count = 0;
+		mc->writeback = true;
+		spin_unlock_irq(&mc->lock);
+
+		error = block_dev_meta_co_write(bdobj, mc);
+		if (error) {
+			CAS_PRINT_RL(KERN_ERR "Metadata writeback failed, "
+					"error %d\n", error);
+		}
+
+		spin_lock_irq(&mc->lock);
+		xa_for_each(&mc->pages, idx, mp) {
+			if (!mp->wb)
+				continue;
+
+			__free_page(mp->wb);
+			mp->wb = NULL;
+			if (!mp->page) {
+				xa_erase(&mc->pages, idx);
+				kfree(mp);
+			}
+		}
+		mc->writeback = false;
+		if (error && !mc->error)
+			mc->error = error;
+		spin_unlock_irq(&mc->lock);
+
+		first = false;
+	}
+
+	list_for_each_entry_safe(wio, tmp, &held, list) {
+		list_del(&wio->list);
+		if (wio->dir != CAS_BD_META_CO_FLUSH) {
+			_block_dev_forward_io_classify(bdobj, wio->token,
+					wio->dir, wio->addr, wio->bytes,
+					wio->offset);
+			kfree(wio);
+			continue;
+		}
+
+		spin_lock_irq(&mc->lock);
+		error = mc->error;
+		mc->error = 0;
+		spin_unlock_irq(&mc->lock);
+
+		if (error)
+			ocf_forward_end(wio->token, error);
+		else
+			_block_dev_forward_flush(bdobj, wio->token);
+		kfree(wio);
+	}
+}
+
+static void block_dev_meta_co_work(struct work_struct *work)
+{
+	struct cas_bd_meta_co *mc = container_of(to_delayed_work(work),
+			struct cas_bd_meta_co, work);
+
+	block_dev_meta_co_drain(mc->bdobj, mc);
+}
+
+/*
+ * Returns operation used to discard data on bottom device or 0 when data
+ * cannot be discarded.
+ */
+static int block_dev_discard_op(struct bd_object *bdobj)
+{
+	if (cas_has_discard_support(bdobj->btm_bd))
+		return CAS_BIO_DISCARD;
+
+	if (discard_write_zeroes &&
+			CAS_BDEV_WRITE_ZEROES_SECTORS(bdobj->btm_bd)) {
+		return CAS_BIO_WRITE_ZEROES;
+	}
+
+	return 0;
+}
+
+/*
+ * Group of gathered discards with merged range. Leader of the group keeps
+ * list of other members and counts bios in flight.
+ */
+struct cas_bd_discard {
+	struct list_head list;
+	ocf_forward_token_t token;
+	sector_t start;
+	sector_t end;
+	struct list_head members;
+	atomic_t remaining;
+	int error;
+};
+
+static void block_dev_discard_put(struct cas_bd_discard *group)
+{
+	struct cas_bd_discard *member, *tmp;
+
+	if (!atomic_dec_and_test(&group->remaining))
+		return;
+
+	list_for_each_entry_safe(member, tmp, &group->members, list) {
+		list_del(&member->list);
+		ocf_forward_end(member->token, group->error);
+		kfree(member);
+	}
+
+	ocf_forward_end(group->token, group->error);
+	kfree(group);
+}
+
+CAS_DECLARE_BLOCK_CALLBACK(cas_bd_discard_end, struct bio *bio,
+		unsigned int bytes_done, int error)
+{
+	struct cas_bd_discard *group;
+	int err;
+
+	CAS_BLOCK_CALLBACK_INIT(bio);
+	group = bio->bi_private;
+	err = CAS_BLOCK_CALLBACK_ERROR(bio, error);
+
+	if (err && err != -EOPNOTSUPP)
+		group->error = err;
+
+	atomic64_inc(&cas_bd_bio(bio)->bdobj->write_gen);
+
+	bio_put(bio);
+	block_dev_discard_put(group);
+	CAS_BLOCK_CALLBACK_RETURN();
+}
+
+/*
+ * Submit discard of given range split according to device limits. Bios
+ * complete either forward token or group of gathered discards.
+ */
+static int _block_dev_submit_discard(struct bd_object *bdobj,
+		struct block_device *bd, int op, sector_t start, sector_t sects,
+		ocf_forward_token_t token, struct cas_bd_discard *group)
+{
+	struct request_queue *q = bdev_get_queue(bd);
+	struct blk_plug plug;
+	struct bio *bio;
+	int error = 0;
+
+	unsigned int max_discard_sectors, granularity, bio_sects;
+	int alignment;
+	sector_t end, tmp;
+
+	if (op == CAS_BIO_DISCARD) {
+		granularity = max(q->limits.discard_granularity >> SECTOR_SHIFT,
+				1U);
+		alignment = (bdev_discard_alignment(bd) >>
+				SECTOR_SHIFT) % granularity;
+		max_discard_sectors = min(q->limits.max_discard_sectors,
+				UINT_MAX >> SECTOR_SHIFT);
+	} else {
+		granularity = max(bdev_logical_block_size(bd) >>
+				SECTOR_SHIFT, 1U);
+		alignment = 0;
+		max_discard_sectors = min(
+				CAS_BDEV_WRITE_ZEROES_SECTORS(bd),
+				UINT_MAX >> SECTOR_SHIFT);
+	}
+	max_discard_sectors -= max_discard_sectors % granularity;
+	if (unlikely(!max_discard_sectors))
+		return -OCF_ERR_INVAL;
+
+	blk_start_plug(&plug);
+	while (sects) {
+		bio = cas_bd_alloc_bio(bdobj, 1, token);
 		if (!bio) {
 			CAS_PRINT_RL(CAS_KERN_ERR "Couldn't allocate memory for BIO\n");
 			error = -OCF_ERR_NO_MEM;
 			break;
 		}
 
-		bio_sects = min_t(sector_t, sects, max_discard_sectors);
-		end = start + bio_sects;
-		tmp = end;
-		if (bio_sects < sects &&
-		    sector_div(tmp, granularity) != alignment) {
-			end = end - alignment;
-			sector_div(end, granularity);
-			end = end * granularity + alignment;
-			bio_sects = end - start;
+		bio_sects = min_t(sector_t, sects, max_discard_sectors);
+		end = start + bio_sects;
+		tmp = end;
+		if (bio_sects < sects &&
+		    sector_div(tmp, granularity) != alignment) {
+			end = end - alignment;
+			sector_div(end, granularity);
+			end = end * granularity + alignment;
+			bio_sects = end - start;
+		}
+
+		CAS_BIO_SET_DEV(bio, bd);
+		CAS_BIO_BISECTOR(bio) = start;
+		CAS_BIO_BISIZE(bio) = bio_sects << SECTOR_SHIFT;
+		bio->bi_next = NULL;
+
+		if (group) {
+			bio->bi_private = group;
+			bio->bi_end_io = CAS_REFER_BLOCK_CALLBACK(
+					cas_bd_discard_end);
+			atomic_inc(&group->remaining);
+		} else {
+			ocf_forward_get(token);
+		}
+		cas_bd_submit_bio(bdobj, op, bio);
+
+		sects -= bio_sects;
+		start = end;
+
+		cond_resched();
+	}
+	blk_finish_plug(&plug);
+
+	return error;
+}
+
+/*
+ * Submit discard of range of volume. Range of striped volume is contiguous
+ * on each member, between the first and the last of its units the range
+ * covers. Mirrored volume discards the whole range on each member.
+ */
+static int block_dev_submit_discard(struct bd_object *bdobj, int op,
+		sector_t start, sector_t sects, ocf_forward_token_t token,
+		struct cas_bd_discard *group)
+{
+	uint32_t count = bdobj->members_count;
+	uint64_t unit_sects = 1ULL << (CAS_BD_STRIPE_SHIFT - SECTOR_SHIFT);
+	uint64_t end = start + sects;
+	uint64_t first_unit, last_unit, first, last, member_start, member_end;
+	uint32_t first_member, last_member, i;
+	int error;
+
+	if (count == 1) {
+		return _block_dev_submit_discard(bdobj, bdobj->btm_bd, op,
+				start, sects, token, group);
+	}
+
+	if (bdobj->mirrored) {
+		for (i = 0; i < count; i++) {
+			if (READ_ONCE(bdobj->member_state[i]) ==
+					KCAS_MIRROR_MEMBER_FAILED) {
+				continue;
+			}
+
+			error = _block_dev_submit_discard(bdobj,
+					bdobj->member_bd[i], op, start, sects,
+					token, group);
+			if (error)
+				return error;
+		}
+
+		return 0;
+	}
+
+	if (!sects)
+		return 0;
+
+	first_unit = div_u64(start, unit_sects);
+	last_unit = div_u64(end - 1, unit_sects);
+	div_u64_rem(first_unit, count, &first_member);
+	div_u64_rem(last_unit, count, &last_member);
+
+	for (i = 0; i < count; i++) {
+		/* First and last unit of range placed on member */
+		first = first_unit + (i + count - first_member) % count;
+		if (first > last_unit)
+			continue;
+		last = last_unit - (last_member + count - i) % count;
+
+		member_start = div_u64(first, count) * unit_sects;
+		if (first == first_unit)
+			member_start += start - first_unit * unit_sects;
+
+		member_end = div_u64(last, count) * unit_sects;
+		if (last == last_unit)
+			member_end += end - last_unit * unit_sects;
+		else
+			member_end += unit_sects;
+
+		error = _block_dev_submit_discard(bdobj, bdobj->member_bd[i],
+				op, member_start, member_end - member_start,
+				token, group);
+		if (error)
+			return error;
+	}
+
+	return 0;
+}
+
+static void block_dev_submit_discard_group(struct bd_object *bdobj,
+		struct cas_bd_discard *group)
+{
+	int op = block_dev_discard_op(bdobj);
+	int error = 0;
+
+	atomic_set(&group->remaining, 1);
+	group->error = 0;
+
+	if (op) {
+		error = block_dev_submit_discard(bdobj, op, group->start,
+				group->end - group->start, NULL, group);
+	}
+	if (error)
+		group->error = error;
+
+	block_dev_discard_put(group);
+}
+
+static void block_dev_discard_work(struct work_struct *work)
+{
+	struct bd_object *bdobj = container_of(to_delayed_work(work),
+			struct bd_object, discard_work);
+	struct cas_bd_discard *discard, *tmp, *group = NULL;
+	LIST_HEAD(pending);
+
+	spin_lock_irq(&bdobj->discard_lock);
+	list_splice_init(&bdobj->discard_pending, &pending);
+	spin_unlock_irq(&bdobj->discard_lock);
+
+	/* Merge adjacent and overlapping ranges, list is sorted by start */
+	list_for_each_entry_safe(discard, tmp, &pending, list) {
+		list_del(&discard->list);
+
+		if (group && discard->start <= group->end) {
+			group->end = max(group->end, discard->end);
+			list_add_tail(&discard->list, &group->members);
+			continue;
+		}
+
+		if (group)
+			block_dev_submit_discard_group(bdobj, group);
+
+		group = discard;
+		INIT_LIST_HEAD(&group->members);
+	}
+
+	if (group)
+		block_dev_submit_discard_group(bdobj, group);
+}
+
+/*
+ * Gather discard to be merged with other discards sent within
+ * discard_merge_window_us. Returns false if discard could not be gathered.
+ */
+static bool block_dev_gather_discard(struct bd_object *bdobj,
+		ocf_forward_token_t token, sector_t start, sector_t sects)
+{
+	struct cas_bd_discard *discard, *pos;
+	unsigned long flags;
+	bool first;
+
+	discard = kmalloc(sizeof(*discard), GFP_NOIO);
+	if (!discard)
+		return false;
+
+	discard->token = token;
+	discard->start = start;
+	discard->end = start + sects;
+
+	spin_lock_irqsave(&bdobj->discard_lock, flags);
+	first = list_empty(&bdobj->discard_pending);
+
+	/* Discards usually come in ascending order, so search from tail */
+	list_for_each_entry_reverse(pos, &bdobj->discard_pending, list) {
+		if (pos->start <= discard->start)
+			break;
+	}
+	list_add(&discard->list, &pos->list);
+	spin_unlock_irqrestore(&bdobj->discard_lock, flags);
+
+	if (first) {
+		schedule_delayed_work(&bdobj->discard_work,
+				usecs_to_jiffies(discard_merge_window_us));
+	}
+
+	return true;
+}
+
+static void block_dev_forward_discard(ocf_volume_t volume,
+		ocf_forward_token_t token, uint64_t addr, uint64_t bytes)
+{
+	struct bd_object *bdobj = bd_object(volume);
+	struct request_queue *q = bdev_get_queue(bdobj->btm_bd);
+	sector_t sects, start;
+	int op, error;
+
+	block_dev_meta_hash_forget(bdobj, addr, bytes);
+
+	if (!q) {
+		/* No queue, error */
+		ocf_forward_end(token, -OCF_ERR_INVAL);
+		return;
+	}
+
+	op = block_dev_discard_op(bdobj);
+	if (!op) {
+		/* Discard is not supported by bottom device, send completion
+		 * to caller
+		 */
+		ocf_forward_end(token, 0);
+		return;
+	}
+
+	sects = bytes >> SECTOR_SHIFT;
+	start = addr >> SECTOR_SHIFT;
+
+	if (discard_merge_window_us &&
+			block_dev_gather_discard(bdobj, token, start, sects)) {
+		return;
+	}
+
+	error = block_dev_submit_discard(bdobj, op, start, sects, token, NULL);
+
+	ocf_forward_end(token, error);
+}
+
+const struct ocf_volume_properties cas_object_blk_properties = {
+	.name = "Block_Device",
+	.volume_priv_size = sizeof(struct bd_object),
+	.caps = {
+		.atomic_writes = 0, /* Atomic writes not supported */
+	},
+	.ops = {
+		.forward_io = block_dev_forward_io,
+		.forward_flush = block_dev_forward_flush,
+		.forward_discard = block_dev_forward_discard,
+		.open = block_dev_open_blk_object,
+		.close = block_dev_close_object,
+		.get_max_io_size = block_dev_get_max_io_size,
+		.get_length = block_dev_get_byte_length,
+	},
+	.deinit = NULL,
+};
+
+const struct ocf_volume_properties cas_object_striped_properties = {
+	.name = "Striped_Block_Device",
+	.volume_priv_size = sizeof(struct bd_object),
+	.caps = {
+		.atomic_writes = 0, /* Atomic writes not supported */
+	},
+	.ops = {
+		.forward_io = block_dev_forward_io,
+		.forward_flush = block_dev_forward_flush,
+		.forward_discard = block_dev_forward_discard,
+		.open = block_dev_open_striped_object,
+		.close = block_dev_close_object,
+		.get_max_io_size = block_dev_get_max_io_size,
+		.get_length = block_dev_get_striped_byte_length,
+	},
+	.deinit = NULL,
+};
+
+const struct ocf_volume_properties cas_object_mirrored_properties = {
+	.name = "Mirrored_Block_Device",
+	.volume_priv_size = sizeof(struct bd_object),
+	.caps = {
+		.atomic_writes = 0, /* Atomic writes not supported */
+	},
+	.ops = {
+		.forward_io = block_dev_forward_io,
+		.forward_flush = block_dev_forward_flush,
+		.forward_discard = block_dev_forward_discard,
+		.open = block_dev_open_mirrored_object,
+		.close = block_dev_close_object,
+		.get_max_io_size = block_dev_get_max_io_size,
+		.get_length = block_dev_get_mirrored_byte_length,
+	},
+	.deinit = NULL,
+};
+
+const struct ocf_volume_properties cas_object_dax_properties = {
+	.name = "Dax_Device",
+	.volume_priv_size = sizeof(struct bd_object),
+	.caps = {
+		.atomic_writes = 0, /* Atomic writes not supported */
+	},
+	.ops = {
+		.forward_io = block_dev_forward_io,
+		.forward_flush = block_dev_forward_flush,
+		.forward_discard = block_dev_forward_discard,
+		.open = block_dev_open_dax_object,
+		.close = block_dev_close_object,
+		.get_max_io_size = block_dev_get_max_io_size,
+		.get_length = block_dev_get_byte_length,
+	},
+	.deinit = NULL,
+};
+
+/* Nothing is cached below null and RAM-backed volumes */
+static void block_dev_bench_forward_flush(ocf_volume_t volume,
+		ocf_forward_token_t token)
+{
+	ocf_forward_end(token, 0);
+}
+
+/* Discarded range of RAM-backed volume reads as zeros afterwards */
+static void block_dev_bench_forward_discard(ocf_volume_t volume,
+		ocf_forward_token_t token, uint64_t addr, uint64_t bytes)
+{
+	struct bd_object *bdobj = bd_object(volume);
+	uint32_t ram_off, length;
+	void *ram_buf;
+
+	while (bdobj->ram_pages && bytes) {
+		ram_off = offset_in_page(addr);
+		length = min_t(uint64_t, bytes, PAGE_SIZE - ram_off);
+
+		ram_buf = kmap_atomic(bdobj->ram_pages[addr >> PAGE_SHIFT]);
+		memset(ram_buf + ram_off, 0, length);
+		kunmap_atomic(ram_buf);
+
+		addr += length;
+		bytes -= length;
+	}
+
+	ocf_forward_end(token, 0);
+}
+
+const struct ocf_volume_properties cas_object_null_properties = {
+	.name = "Null_Device",
+	.volume_priv_size = sizeof(struct bd_object),
+	.caps = {
+		.atomic_writes = 0, /* Atomic writes not supported */
+	},
+	.ops = {
+		.forward_io = block_dev_forward_io,
+		.forward_flush = block_dev_bench_forward_flush,
+		.forward_discard = block_dev_bench_forward_discard,
+		.open = block_dev_open_null_object,
+		.close = block_dev_close_object,
+		.get_max_io_size = block_dev_get_max_io_size,
+		.get_length = block_dev_get_byte_length,
+	},
+	.deinit = NULL,
+};
+
+const struct ocf_volume_properties cas_object_ram_properties = {
+	.name = "Ram_Device",
+	.volume_priv_size = sizeof(struct bd_object),
+	.caps = {
+		.atomic_writes = 0, /* Atomic writes not supported */
+	},
+	.ops = {
+		.forward_io = block_dev_forward_io,
+		.forward_flush = block_dev_bench_forward_flush,
+		.forward_discard = block_dev_bench_forward_discard,
+		.open = block_dev_open_ram_object,
+		.close = block_dev_close_object,
+		.get_max_io_size = block_dev_get_max_io_size,
+		.get_length = block_dev_get_byte_length,
+	},
+	.deinit = NULL,
+};
+
+/* Slots of discarded blocks are freed, device itself is not discarded */
+static void block_dev_compress_forward_discard(ocf_volume_t volume,
+		ocf_forward_token_t token, uint64_t addr, uint64_t bytes)
+{
+	block_dev_compress_queue(bd_object(volume), token, -1, addr, bytes, 0);
+}
+
+const struct ocf_volume_properties cas_object_compressed_properties = {
+	.name = "Compressed_Device",
+	.volume_priv_size = sizeof(struct bd_object),
+	.caps = {
+		.atomic_writes = 0, /* Atomic writes not supported */
+	},
+	.ops = {
+		.forward_io = block_dev_forward_io,
+		.forward_flush = block_dev_forward_flush,
+		.forward_discard = block_dev_compress_forward_discard,
+		.open = block_dev_open_compressed_object,
+		.close = block_dev_close_object,
+		.get_max_io_size = block_dev_get_max_io_size,
+		.get_length = block_dev_get_compressed_byte_length,
+	},
+	.deinit = NULL,
+};
+
+bool block_dev_dax_supported(struct block_device *bd)
+{
+	struct dax_device *dax_dev;
+	u64 offset;
+
+	dax_dev = cas_dax_get_by_bdev(bd, &offset);
+	if (!dax_dev)
+		return false;
+
+	cas_dax_put(dax_dev);
+
+	return true;
+}
+
+uint64_t block_dev_get_flushes_elided(ocf_volume_t vol)
+{
+	return atomic64_read(&bd_object(vol)->flushes_elided);
+}
+
+void block_dev_set_inflight_limit(ocf_volume_t vol,
+		enum cas_bd_io_class io_class, uint32_t limit)
+{
+	struct bd_object *bdobj = bd_object(vol);
+
+	WRITE_ONCE(bdobj->inflight_limit[io_class], limit);
+
+	/* Let waiting I/O proceed if limit has been raised */
+	queue_work(system_unbound_wq, &bdobj->inflight_work);
+}
+
+void block_dev_set_inflight_unthrottled(ocf_volume_t vol, bool unthrottled)
+{
+	struct bd_object *bdobj = bd_object(vol);
+
+	WRITE_ONCE(bdobj->inflight_unthrottled, unthrottled);
+
+	if (unthrottled)
+		queue_work(system_unbound_wq, &bdobj->inflight_work);
+}
+
+void block_dev_set_background_rate(ocf_volume_t vol, uint64_t rate_limit)
+{
+	struct bd_object *bdobj = bd_object(vol);
+	unsigned long flags;
+
+	spin_lock_irqsave(&bdobj->inflight_lock, flags);
+	WRITE_ONCE(bdobj->rate_limit, rate_limit);
+	bdobj->rate_budget = div_u64(rate_limit, CAS_BD_RATE_BURST_DIV);
+	bdobj->rate_stamp = jiffies;
+	spin_unlock_irqrestore(&bdobj->inflight_lock, flags);
+
+	/* Let I/O waiting for rate budget proceed */
+	queue_work(system_unbound_wq, &bdobj->inflight_work);
+}
+
+void block_dev_set_writeback_sweep(ocf_volume_t vol, uint32_t window_us)
+{
+	struct bd_object *bdobj = bd_object(vol);
+
+	WRITE_ONCE(bdobj->sweep_window_us, window_us);
+
+	/* Writes gathered so far are not left waiting for the old window */
+	if (!window_us)
+		mod_delayed_work(system_unbound_wq, &bdobj->sweep_work, 0);
+}
+
+uint32_t block_dev_get_writeback_sweep(ocf_volume_t vol)
+{
+	return READ_ONCE(bd_object(vol)->sweep_window_us);
+}
+
+int block_dev_trim_start(ocf_volume_t vol, uint64_t base, uint64_t chunks)
+{
+	struct bd_object *bdobj = bd_object(vol);
+	unsigned long *written;
+
+	if (!chunks)
+		return -OCF_ERR_INVAL;
+
+	written = vzalloc(BITS_TO_LONGS(chunks) * sizeof(unsigned long));
+	if (!written)
+		return -OCF_ERR_NO_MEM;
+
+	bdobj->trim_base = base;
+	bdobj->trim_chunks = chunks;
+	/* Area is unknown until reset, i.e. everything counts as written */
+	bitmap_fill(written, chunks);
+	rcu_assign_pointer(bdobj->trim_written, written);
+
+	return 0;
+}
+
+int block_dev_csum_start(ocf_volume_t vol)
+{
+	struct bd_object *bdobj = bd_object(vol);
+	uint32_t *csum;
+
+	/*
+	 * Only I/O sent to block device as is is checksummed, which metadata
+	 * written back by coalescing is not
+	 */
+	if (bdobj->comp || bdobj->dax_dev || bdobj->null_dev ||
+			bdobj->ram_pages || rcu_access_pointer(bdobj->meta_co)) {
+		return -OCF_ERR_INVAL;
+	}
+
+	if (rcu_access_pointer(bdobj->csum))
+		return 0;
+
+	bdobj->csum_blocks = DIV_ROUND_UP(ocf_volume_get_length(vol),
+			CAS_BD_CSUM_BLOCK_SIZE);
+	csum = vzalloc(array_size(bdobj->csum_blocks, sizeof(*csum)));
+	if (!csum)
+		return -OCF_ERR_NO_MEM;
+
+	/* Blocks written before are not known, so they are not verified */
+	rcu_assign_pointer(bdobj->csum, csum);
+
+	return 0;
+}
+
+void block_dev_csum_stop(ocf_volume_t vol)
+{
+	struct bd_object *bdobj = bd_object(vol);
+	uint32_t *csum = rcu_access_pointer(bdobj->csum);
+
+	if (!csum)
+		return;
+
+	RCU_INIT_POINTER(bdobj->csum, NULL);
+	synchronize_rcu();
+	vfree(csum);
+}
+
+bool block_dev_csum_enabled(ocf_volume_t vol)
+{
+	return rcu_access_pointer(bd_object(vol)->csum);
+}
+
+uint64_t block_dev_csum_get_errors(ocf_volume_t vol)
+{
+	return atomic64_read(&bd_object(vol)->csum_errors);
+}
+
+void block_dev_set_atomic_meta(ocf_volume_t vol, uint64_t end)
+{
+	struct bd_object *bdobj = bd_object(vol);
+
+	WRITE_ONCE(bdobj->atomic_meta_end, bdobj->atomic_write_max ? end : 0);
+}
+
+uint32_t block_dev_get_atomic_write_unit(ocf_volume_t vol)
+{
+	return bd_object(vol)->atomic_write_max;
+}
+
+int block_dev_meta_co_start(ocf_volume_t vol, uint64_t end,
+		uint32_t window_us)
+{
+	struct bd_object *bdobj = bd_object(vol);
+	struct cas_bd_meta_co *mc = rcu_access_pointer(bdobj->meta_co);
+
+	if (mc) {
+		WRITE_ONCE(mc->window_us, window_us);
+		return 0;
+	}
+
+	/*
+	 * Pages are written back to block device directly, and would be
+	 * neither checksummed nor atomic
+	 */
+	if (bdobj->members_count > 1 || bdobj->comp || bdobj->dax_dev ||
+			bdobj->null_dev || bdobj->ram_pages || bdobj->zones ||
+			rcu_access_pointer(bdobj->csum) ||
+			bdobj->atomic_meta_end) {
+		return -OCF_ERR_NOT_SUPP;
+	}
+
+	if (!end || !window_us)
+		return -OCF_ERR_INVAL;
+
+	mc = kzalloc(sizeof(*mc), GFP_KERNEL);
+	if (!mc)
+		return -OCF_ERR_NO_MEM;
+
+	mc->bdobj = bdobj;
+	spin_lock_init(&mc->lock);
+	mc->end = end;
+	mc->window_us = window_us;
+	xa_init(&mc->pages);
+	INIT_LIST_HEAD(&mc->held);
+	INIT_DELAYED_WORK(&mc->work, block_dev_meta_co_work);
+	atomic64_set(&mc->absorbed, 0);
+	atomic64_set(&mc->writes, 0);
+
+	rcu_assign_pointer(bdobj->meta_co, mc);
+
+	return 0;
+}
+
+void block_dev_meta_co_stop(ocf_volume_t vol)
+{
+	struct bd_object *bdobj = bd_object(vol);
+	struct cas_bd_meta_co *mc = rcu_access_pointer(bdobj->meta_co);
+
+	if (!mc)
+		return;
+
+	RCU_INIT_POINTER(bdobj->meta_co, NULL);
+	synchronize_rcu();
+
+	/* Nothing is buffered anymore, so all of it is written back at once */
+	cancel_delayed_work_sync(&mc->work);
+	block_dev_meta_co_drain(bdobj, mc);
+
+	xa_destroy(&mc->pages);
+	kfree(mc);
+}
+
+uint32_t block_dev_meta_co_get_window(ocf_volume_t vol)
+{
+	struct cas_bd_meta_co *mc;
+	uint32_t window_us = 0;
+
+	rcu_read_lock();
+	mc = rcu_dereference(bd_object(vol)->meta_co);
+	if (mc)
+		window_us = READ_ONCE(mc->window_us);
+	rcu_read_unlock();
+
+	return window_us;
+}
+
+void block_dev_meta_co_get_stats(ocf_volume_t vol, uint64_t *absorbed,
+		uint64_t *writes)
+{
+	struct cas_bd_meta_co *mc;
+
+	*absorbed = *writes = 0;
+
+	rcu_read_lock();
+	mc = rcu_dereference(bd_object(vol)->meta_co);
+	if (mc) {
+		*absorbed = atomic64_read(&mc->absorbed);
+		*writes = atomic64_read(&mc->writes);
+	}
+	rcu_read_unlock();
+}
+
+void block_dev_meta_elide_set_end(ocf_volume_t vol, uint64_t end)
+{
+	struct bd_object *bdobj = bd_object(vol);
+	unsigned long chunk_idx, first;
+	uint64_t *chunk;
+
+	if (end >= READ_ONCE(bdobj->meta_hash_end))
+		return;
+
+	WRITE_ONCE(bdobj->meta_hash_end, end);
+
+	/* Bios which have seen previous end are done with their chunks */
+	synchronize_rcu();
+
+	first = DIV_ROUND_UP(end >> PAGE_SHIFT, CAS_BD_META_HASH_CHUNK);
+	xa_for_each_start(&bdobj->meta_hash, chunk_idx, chunk, first) {
+		xa_erase_irq(&bdobj->meta_hash, chunk_idx);
+		free_page((unsigned long)chunk);
+	}
+}
+
+uint64_t block_dev_meta_elide_get_elided(ocf_volume_t vol)
+{
+	return atomic64_read(&bd_object(vol)->meta_elided);
+}
+
+void block_dev_trim_stop(ocf_volume_t vol)
+{
+	struct bd_object *bdobj = bd_object(vol);
+	unsigned long *written = rcu_access_pointer(bdobj->trim_written);
+
+	if (!written)
+		return;
+
+	RCU_INIT_POINTER(bdobj->trim_written, NULL);
+	synchronize_rcu();
+	vfree(written);
+}
+
+void block_dev_trim_reset(ocf_volume_t vol)
+{
+	struct bd_object *bdobj = bd_object(vol);
+	unsigned long *written = rcu_access_pointer(bdobj->trim_written);
+
+	/* Write racing with reset counts as done before it */
+	if (written)
+		bitmap_zero(written, bdobj->trim_chunks);
+}
+
+void block_dev_trim_release(ocf_volume_t vol)
+{
+	struct bd_object *bdobj = bd_object(vol);
+	struct cas_bd_waiting_io *wio, *tmp;
+	LIST_HEAD(held);
+
+	spin_lock_irq(&bdobj->trim_lock);
+	WRITE_ONCE(bdobj->trim_fencing, false);
+	list_splice_init(&bdobj->trim_held, &held);
+	spin_unlock_irq(&bdobj->trim_lock);
+
+	list_for_each_entry_safe(wio, tmp, &held, list) {
+		list_del(&wio->list);
+		_block_dev_forward_io_classify(bdobj, wio->token, wio->dir,
+				wio->addr, wio->bytes, wio->offset);
+		kfree(wio);
+	}
+}
+
+uint64_t block_dev_trim_fence(ocf_volume_t vol, uint64_t *first,
+		uint64_t max)
+{
+	struct bd_object *bdobj = bd_object(vol);
+	unsigned long *written = rcu_access_pointer(bdobj->trim_written);
+	uint64_t start, end, chunk;
+
+	if (!written)
+		return 0;
+
+	while (true) {
+		if (*first >= bdobj->trim_chunks)
+			return 0;
+
+		start = find_next_zero_bit(written, bdobj->trim_chunks, *first);
+		if (start >= bdobj->trim_chunks)
+			return 0;
+
+		end = min(start + max, bdobj->trim_chunks);
+
+		spin_lock_irq(&bdobj->trim_lock);
+		bdobj->trim_fence_start = start;
+		bdobj->trim_fence_end = end;
+		WRITE_ONCE(bdobj->trim_fencing, true);
+		spin_unlock_irq(&bdobj->trim_lock);
+		smp_mb();
+
+		/* Fence ends at the first chunk written meanwhile */
+		chunk = find_next_bit(written, end, start);
+		if (chunk > start)
+			break;
+
+		block_dev_trim_release(vol);
+		*first = start + 1;
+	}
+
+	if (chunk < end) {
+		spin_lock_irq(&bdobj->trim_lock);
+		bdobj->trim_fence_end = chunk;
+		spin_unlock_irq(&bdobj->trim_lock);
+		end = chunk;
+	}
+
+	*first = start;
+	return end - start;
+}
+
+/* Range copied at once by rebuild of mirrored volume */
+#define CAS_BD_REBUILD_CHUNK_SHIFT 20
+
+struct cas_bd_rebuild_io {
+	struct completion cmpl;
+	int error;
+};
+
+CAS_DECLARE_BLOCK_CALLBACK(cas_bd_rebuild_end, struct bio *bio,
+		unsigned int bytes_done, int error)
+{
+	struct cas_bd_rebuild_io *rio;
+
+	CAS_BLOCK_CALLBACK_INIT(bio);
+	rio = bio->bi_private;
+	rio->error = CAS_BLOCK_CALLBACK_ERROR(bio, error);
+	complete(&rio->cmpl);
+	CAS_BLOCK_CALLBACK_RETURN();
+}
+
+static int block_dev_rebuild_io(struct bd_object *bdobj, int member, int rw,
+		uint64_t addr, struct page **pages, uint64_t bytes)
+{
+	struct block_device *bd = bdobj->member_bd[member];
+	struct cas_bd_rebuild_io rio;
+	uint32_t i, length;
+	struct bio *bio;
+
+	bio = cas_bio_alloc_bioset(bd, GFP_NOIO,
+			DIV_ROUND_UP(bytes, PAGE_SIZE), bdobj->btm_bio_set);
+	if (!bio)
+		return -ENOMEM;
+
+	CAS_BIO_SET_DEV(bio, bd);
+	CAS_BIO_BISECTOR(bio) = addr >> SECTOR_SHIFT;
+	for (i = 0; bytes; i++) {
+		length = min_t(uint64_t, bytes, PAGE_SIZE);
+		if (bio_add_page(bio, pages[i], length, 0) != length) {
+			bio_put(bio);
+			return -ENOBUFS;
+		}
+		bytes -= length;
+	}
+
+	init_completion(&rio.cmpl);
+	rio.error = 0;
+	bio->bi_private = &rio;
+	bio->bi_end_io = CAS_REFER_BLOCK_CALLBACK(cas_bd_rebuild_end);
+
+	cas_submit_bio(rw, bio);
+	wait_for_completion(&rio.cmpl);
+	bio_put(bio);
+
+	return rio.error;
+}
+
+static void block_dev_mirror_label_fill(struct page *page, uint64_t seq,
+		const int *state)
+{
+	struct cas_bd_mirror_label *label = page_address(page);
+	int i;
+
+	memset(label, 0, CAS_BD_MIRROR_LABEL_SIZE);
+	memcpy(label->magic, CAS_BD_MIRROR_LABEL_MAGIC,
+			sizeof(CAS_BD_MIRROR_LABEL_MAGIC));
+	label->seq = cpu_to_le64(seq);
+	for (i = 0; i < CAS_BD_MIRROR_MEMBERS; i++)
+		label->state[i] = cpu_to_le32(state[i]);
+}
+
+/*
+ * Write current states of members to labels of members not failed, then
+ * complete writes held until they are. Flush sent before label makes data
+ * copied by rebuild durable before member is labeled active. Member whose
+ * label cannot be written fails, which changes states once again.
+ */
+static void block_dev_mirror_label_update(struct bd_object *bdobj)
+{
+	uint64_t addr = block_dev_mirror_length(bdobj);
+	int state[CAS_BD_MIRROR_MEMBERS];
+	struct cas_bd_bio *bd_bio, *tmp;
+	struct llist_node *llnode;
+	int error = 0, written, i;
+	struct page *page;
+	uint64_t seq;
+
+	page = alloc_page(GFP_NOIO);
+
+	spin_lock_irq(&bdobj->mirror_lock);
+	while (bdobj->mirror_seq != bdobj->mirror_seq_done) {
+		if (!page) {
+			error = -OCF_ERR_NO_MEM;
+			bdobj->mirror_seq_done = bdobj->mirror_seq;
+			break;
+		}
+
+		seq = bdobj->mirror_seq;
+		for (i = 0; i < CAS_BD_MIRROR_MEMBERS; i++)
+			state[i] = bdobj->member_state[i];
+		spin_unlock_irq(&bdobj->mirror_lock);
+
+		block_dev_mirror_label_fill(page, seq, state);
+
+		written = 0;
+		for (i = 0; i < bdobj->members_count; i++) {
+			if (state[i] == KCAS_MIRROR_MEMBER_FAILED)
+				continue;
+
+			if (!block_dev_rebuild_io(bdobj, i,
+					CAS_SET_FLUSH(WRITE) | REQ_FUA, addr,
+					&page, CAS_BD_MIRROR_LABEL_SIZE)) {
+				written++;
+			} else {
+				block_dev_mirror_fail(bdobj, i);
+			}
 		}
 
-		CAS_BIO_SET_DEV(bio, bdobj->btm_bd);
-		CAS_BIO_BISECTOR(bio) = start;
-		CAS_BIO_BISIZE(bio) = bio_sects << SECTOR_SHIFT;
-		bio->bi_next = NULL;
-		bio->bi_private = (void *)token;
-		bio->bi_end_io = CAS_REFER_BLOCK_CALLBACK(cas_bd_forward_end);
+		spin_lock_irq(&bdobj->mirror_lock);
+		if (!written) {
+			error = -OCF_ERR_IO;
+			bdobj->mirror_seq_done = bdobj->mirror_seq;
+			break;
+		}
+		bdobj->mirror_seq_done = seq;
+	}
+	llnode = llist_del_all(&bdobj->mirror_label_held);
+	spin_unlock_irq(&bdobj->mirror_lock);
 
-		ocf_forward_get(token);
-		cas_submit_bio(CAS_BIO_DISCARD, bio);
+	if (page)
+		__free_page(page);
 
-		sects -= bio_sects;
-		start = end;
+	if (error) {
+		printk(KERN_ERR OCF_PREFIX_SHORT "Cannot write state of "
+				"members of mirrored cache device\n");
+	}
+
+	llist_for_each_entry_safe(bd_bio, tmp, llnode, cmpl_node) {
+		if (error)
+			bd_bio->error = error;
+		cas_bd_bio_end(bd_bio);
+	}
+}
+
+static void block_dev_mirror_label_work(struct work_struct *work)
+{
+	struct bd_object *bdobj = container_of(work, struct bd_object,
+			mirror_label_work);
+
+	block_dev_mirror_label_update(bdobj);
+}
+
+/*
+ * Restore states of members from labels written the last. Member missing
+ * them, or labeled other than active, is failed until rebuilt. Members
+ * never labeled are new, so they are in sync.
+ */
+static int block_dev_mirror_label_load(struct bd_object *bdobj)
+{
+	uint64_t addr = block_dev_mirror_length(bdobj);
+	uint64_t seq[CAS_BD_MIRROR_MEMBERS] = {}, last = 0;
+	int state[CAS_BD_MIRROR_MEMBERS] = {};
+	struct cas_bd_mirror_label *label;
+	bool valid[CAS_BD_MIRROR_MEMBERS];
+	int i, j, best = -1;
+	struct page *page;
+
+	if (!addr)
+		return -OCF_ERR_INVAL;
+
+	page = alloc_page(GFP_KERNEL);
+	if (!page)
+		return -OCF_ERR_NO_MEM;
+	label = page_address(page);
+
+	for (i = 0; i < bdobj->members_count; i++) {
+		valid[i] = !block_dev_rebuild_io(bdobj, i, READ, addr, &page,
+				CAS_BD_MIRROR_LABEL_SIZE) &&
+				!memcmp(label->magic, CAS_BD_MIRROR_LABEL_MAGIC,
+				sizeof(CAS_BD_MIRROR_LABEL_MAGIC));
+		if (!valid[i])
+			continue;
+
+		seq[i] = le64_to_cpu(label->seq);
+		if (best >= 0 && seq[i] <= last)
+			continue;
+
+		best = i;
+		last = seq[i];
+		for (j = 0; j < CAS_BD_MIRROR_MEMBERS; j++)
+			state[j] = le32_to_cpu(label->state[j]);
+	}
+
+	__free_page(page);
+
+	for (i = 0; best >= 0 && i < bdobj->members_count; i++) {
+		/* Member which wrote the last label was not failed then */
+		if (i == best || (valid[i] && seq[i] == last &&
+				state[i] == KCAS_MIRROR_MEMBER_ACTIVE)) {
+			continue;
+		}
+
+		bdobj->member_state[i] = KCAS_MIRROR_MEMBER_FAILED;
+		printk(KERN_WARNING OCF_PREFIX_SHORT "Member %d of mirrored "
+				"cache device is out of sync, rebuild it\n", i);
+	}
+
+	bdobj->mirror_seq_done = last;
+	bdobj->mirror_seq = last + 1;
+	block_dev_mirror_label_update(bdobj);
+
+	return 0;
+}
+
+/*
+ * Hold writes to range about to be copied and wait for writes sent before,
+ * so that no write lands on either member between reading and writing copy
+ */
+static void block_dev_rebuild_fence(struct bd_object *bdobj, uint64_t start,
+		uint64_t end)
+{
+	int epoch;
+
+	spin_lock_irq(&bdobj->mirror_lock);
+	bdobj->rebuild_fence_start = start;
+	bdobj->rebuild_fence_end = end;
+	WRITE_ONCE(bdobj->rebuild_fencing, true);
+	spin_unlock_irq(&bdobj->mirror_lock);
+	smp_mb();
+
+	epoch = bdobj->mirror_epoch;
+	WRITE_ONCE(bdobj->mirror_epoch, !epoch);
+	smp_mb();
+
+	wait_event(bdobj->mirror_wait,
+			!atomic_read(&bdobj->mirror_writes[epoch]));
+}
+
+static void block_dev_rebuild_release(struct bd_object *bdobj, uint64_t pos)
+{
+	struct cas_bd_waiting_io *wio, *tmp;
+	LIST_HEAD(held);
+
+	spin_lock_irq(&bdobj->mirror_lock);
+	WRITE_ONCE(bdobj->rebuild_fencing, false);
+	WRITE_ONCE(bdobj->rebuild_pos, pos);
+	list_splice_init(&bdobj->rebuild_held, &held);
+	spin_unlock_irq(&bdobj->mirror_lock);
+
+	list_for_each_entry_safe(wio, tmp, &held, list) {
+		list_del(&wio->list);
+		_block_dev_forward_io(bdobj, wio->token, wio->dir, wio->addr,
+				wio->bytes, wio->offset, wio->io_class);
+		kfree(wio);
+	}
+}
+
+static void block_dev_rebuild_work(struct work_struct *work)
+{
+	struct bd_object *bdobj = container_of(work, struct bd_object,
+			rebuild_work);
+	uint32_t count = 1 << (CAS_BD_REBUILD_CHUNK_SHIFT - PAGE_SHIFT);
+	uint32_t target = bdobj->rebuild_member, source = !target;
+	uint64_t pos = 0, end;
+	struct page **pages;
+	int result = 0;
+	uint32_t i;
+
+	pages = kcalloc(count, sizeof(*pages), GFP_KERNEL);
+	if (!pages)
+		result = -ENOMEM;
+
+	for (i = 0; pages && i < count; i++) {
+		pages[i] = alloc_page(GFP_KERNEL);
+		if (!pages[i])
+			result = -ENOMEM;
+	}
+
+	while (!result && pos < bdobj->rebuild_length) {
+		if (READ_ONCE(bdobj->rebuild_stop) ||
+				READ_ONCE(bdobj->member_state[target]) !=
+				KCAS_MIRROR_MEMBER_REBUILDING ||
+				READ_ONCE(bdobj->member_state[source]) !=
+				KCAS_MIRROR_MEMBER_ACTIVE) {
+			result = -EINTR;
+			break;
+		}
+
+		end = min(pos + (1ULL << CAS_BD_REBUILD_CHUNK_SHIFT),
+				bdobj->rebuild_length);
+
+		block_dev_rebuild_fence(bdobj, pos, end);
+		result = block_dev_rebuild_io(bdobj, source, READ, pos, pages,
+				end - pos);
+		if (!result) {
+			result = block_dev_rebuild_io(bdobj, target, WRITE, pos,
+					pages, end - pos);
+		}
+		block_dev_rebuild_release(bdobj, result ? pos : end);
 
+		pos = end;
 		cond_resched();
 	}
 
-	ocf_forward_end(token, error);
+	for (i = 0; pages && i < count; i++) {
+		if (pages[i])
+			__free_page(pages[i]);
+	}
+	kfree(pages);
+
+	spin_lock_irq(&bdobj->mirror_lock);
+	if (bdobj->member_state[target] == KCAS_MIRROR_MEMBER_REBUILDING) {
+		WRITE_ONCE(bdobj->member_state[target], result ?
+				KCAS_MIRROR_MEMBER_FAILED :
+				KCAS_MIRROR_MEMBER_ACTIVE);
+		block_dev_mirror_state_changed(bdobj);
+	}
+	WRITE_ONCE(bdobj->rebuild_running, false);
+	spin_unlock_irq(&bdobj->mirror_lock);
+
+	if (result) {
+		printk(KERN_ERR OCF_PREFIX_SHORT "Rebuild of member %u of "
+				"mirrored cache device failed\n", target);
+	} else {
+		printk(KERN_INFO OCF_PREFIX_SHORT "Rebuild of member %u of "
+				"mirrored cache device completed\n", target);
+	}
 }
 
-const struct ocf_volume_properties cas_object_blk_properties = {
-	.name = "Block_Device",
-	.volume_priv_size = sizeof(struct bd_object),
-	.caps = {
-		.atomic_writes = 0, /* Atomic writes not supported */
-	},
-	.ops = {
-		.forward_io = block_dev_forward_io,
-		.forward_flush = block_dev_forward_flush,
-		.forward_discard = block_dev_forward_discard,
-		.open = block_dev_open_object,
-		.close = block_dev_close_object,
-		.get_max_io_size = block_dev_get_max_io_size,
-		.get_length = block_dev_get_byte_length,
-	},
-	.deinit = NULL,
+int block_dev_mirror_rebuild(ocf_volume_t vol, uint32_t member)
+{
+	struct bd_object *bdobj = bd_object(vol);
+	int result = -OCF_ERR_INVAL;
+	int i;
+
+	if (!bdobj->mirrored || member >= bdobj->members_count)
+		return -OCF_ERR_INVAL;
+
+	spin_lock_irq(&bdobj->mirror_lock);
+	if (bdobj->rebuild_running)
+		goto out;
+
+	/* Copy is taken from the other member, which has to be in sync */
+	for (i = 0; i < bdobj->members_count; i++) {
+		if (i != member && bdobj->member_state[i] ==
+				KCAS_MIRROR_MEMBER_ACTIVE) {
+			result = 0;
+		}
+	}
+	if (result)
+		goto out;
+
+	WRITE_ONCE(bdobj->member_state[member], KCAS_MIRROR_MEMBER_REBUILDING);
+	block_dev_mirror_state_changed(bdobj);
+	bdobj->rebuild_member = member;
+	bdobj->rebuild_pos = 0;
+	bdobj->rebuild_length = block_dev_get_mirrored_byte_length(vol);
+	bdobj->rebuild_stop = false;
+	bdobj->rebuild_running = true;
+	queue_work(system_unbound_wq, &bdobj->rebuild_work);
+
+out:
+	spin_unlock_irq(&bdobj->mirror_lock);
+	return result;
+}
+
+int block_dev_mirror_get_state(ocf_volume_t vol, uint32_t member,
+		uint32_t *state)
+{
+	struct bd_object *bdobj = bd_object(vol);
+
+	if (!bdobj->mirrored || member >= bdobj->members_count)
+		return -OCF_ERR_INVAL;
+
+	*state = READ_ONCE(bdobj->member_state[member]);
+
+	return 0;
+}
+
+uint32_t block_dev_mirror_get_rebuild_progress(ocf_volume_t vol)
+{
+	struct bd_object *bdobj = bd_object(vol);
+	uint64_t pos, length;
+
+	spin_lock_irq(&bdobj->mirror_lock);
+	pos = bdobj->rebuild_pos;
+	length = bdobj->rebuild_length;
+	if (!bdobj->rebuild_running || !length)
+		pos = length = 1;
+	spin_unlock_irq(&bdobj->mirror_lock);
+
+	return div64_u64(pos * 100, length);
+}
+
+uint32_t block_dev_get_inflight_limit(ocf_volume_t vol,
+		enum cas_bd_io_class io_class)
+{
+	return READ_ONCE(bd_object(vol)->inflight_limit[io_class]);
+}
+
+uint32_t block_dev_get_zone_sectors(ocf_volume_t vol)
+{
+	struct bd_object *bdobj = bd_object(vol);
+
+	return bdobj->zones ? 1U << (bdobj->zone_shift - SECTOR_SHIFT) : 0;
+}
+
+int block_dev_zone_accept(ocf_volume_t vol, uint64_t addr, uint64_t bytes)
+{
+	struct bd_object *bdobj = bd_object(vol);
+	uint64_t zone_size = 1ULL << bdobj->zone_shift;
+	struct cas_bd_zone *zone;
+	unsigned long flags;
+	uint64_t part;
+	int result = 0;
+
+	spin_lock_irqsave(&bdobj->zone_lock, flags);
+	while (bytes) {
+		part = min(bytes, round_down(addr, zone_size) + zone_size -
+				addr);
+		zone = &bdobj->zones[addr >> bdobj->zone_shift];
+		if (zone->wp != U64_MAX) {
+			if (addr < zone->wp) {
+				result = -EIO;
+				break;
+			}
+			zone->accepted = max(zone->accepted, addr + part);
+		}
+
+		addr += part;
+		bytes -= part;
+	}
+	spin_unlock_irqrestore(&bdobj->zone_lock, flags);
+
+	return result;
+}
+
+int block_dev_zone_append(ocf_volume_t vol, uint64_t *addr, uint64_t bytes)
+{
+	struct bd_object *bdobj = bd_object(vol);
+	uint32_t idx = *addr >> bdobj->zone_shift;
+	uint64_t zone_end = block_dev_zone_start(bdobj, idx + 1);
+	struct cas_bd_zone *zone = &bdobj->zones[idx];
+	unsigned long flags;
+	int result = 0;
+
+	spin_lock_irqsave(&bdobj->zone_lock, flags);
+	if (zone->wp == U64_MAX) {
+		result = -EINVAL;
+	} else if (zone->accepted + bytes > zone_end) {
+		result = -EIO;
+	} else {
+		*addr = zone->accepted;
+		zone->accepted += bytes;
+	}
+	spin_unlock_irqrestore(&bdobj->zone_lock, flags);
+
+	return result;
+}
+
+#ifdef CAS_ZONED
+struct block_dev_zone_report_ctx {
+	struct bd_object *bdobj;
+	int (*cb)(struct blk_zone *zone, unsigned int idx, void *data);
+	void *data;
 };
 
+/* Data accepted by cache but not written back yet counts as written */
+static int block_dev_zone_report_accepted_cb(struct blk_zone *blk_zone,
+		unsigned int idx, void *data)
+{
+	struct block_dev_zone_report_ctx *ctx = data;
+	struct bd_object *bdobj = ctx->bdobj;
+	uint64_t start = blk_zone->start << SECTOR_SHIFT;
+	struct cas_bd_zone *zone;
+	sector_t accepted;
+
+	if ((start >> bdobj->zone_shift) >= bdobj->nr_zones)
+		return -EINVAL;
+
+	zone = &bdobj->zones[start >> bdobj->zone_shift];
+	if (blk_zone->type != BLK_ZONE_TYPE_CONVENTIONAL &&
+			blk_zone->cond != BLK_ZONE_COND_FULL) {
+		accepted = READ_ONCE(zone->accepted) >> SECTOR_SHIFT;
+		if (accepted > blk_zone->wp) {
+			blk_zone->wp = accepted;
+			if (blk_zone->cond == BLK_ZONE_COND_EMPTY)
+				blk_zone->cond = BLK_ZONE_COND_IMP_OPEN;
+		}
+		if (blk_zone->wp >= blk_zone->start + blk_zone->len)
+			blk_zone->cond = BLK_ZONE_COND_FULL;
+	}
+
+	return ctx->cb(blk_zone, idx, ctx->data);
+}
+
+int block_dev_zone_report(ocf_volume_t vol, sector_t sector,
+		unsigned int nr_zones,
+		int (*cb)(struct blk_zone *zone, unsigned int idx, void *data),
+		void *data)
+{
+	struct block_dev_zone_report_ctx ctx = {
+		.bdobj = bd_object(vol),
+		.cb = cb,
+		.data = data,
+	};
+
+	return cas_blkdev_report_zones(ctx.bdobj->btm_bd, sector, nr_zones,
+			block_dev_zone_report_accepted_cb, &ctx);
+}
+
+int block_dev_zone_reset(ocf_volume_t vol, uint64_t addr, uint64_t bytes)
+{
+	struct bd_object *bdobj = bd_object(vol);
+	struct cas_bd_waiting_io *wio, *tmp;
+	uint32_t idx, last;
+	struct cas_bd_zone *zone;
+	int result = 0;
+	LIST_HEAD(dropped);
+
+	idx = addr >> bdobj->zone_shift;
+	last = min_t(uint64_t, (addr + bytes - 1) >> bdobj->zone_shift,
+			bdobj->nr_zones - 1);
+	for (; idx <= last && !result; idx++) {
+		zone = &bdobj->zones[idx];
+		if (zone->wp == U64_MAX)
+			continue;
+
+		/* Writes sent before reset are overwritten by it anyway */
+		spin_lock_irq(&bdobj->zone_lock);
+		list_splice_init(&zone->held, &dropped);
+		spin_unlock_irq(&bdobj->zone_lock);
+
+		wait_event(bdobj->zone_wait, !READ_ONCE(zone->busy));
+
+		result = cas_blkdev_zone_reset(bdobj->btm_bd,
+				block_dev_zone_start(bdobj, idx) >> SECTOR_SHIFT,
+				1U << (bdobj->zone_shift - SECTOR_SHIFT));
+
+		spin_lock_irq(&bdobj->zone_lock);
+		if (result) {
+			zone->resync = true;
+		} else {
+			zone->wp = block_dev_zone_start(bdobj, idx);
+			zone->accepted = zone->wp;
+		}
+		spin_unlock_irq(&bdobj->zone_lock);
+	}
+
+	list_for_each_entry_safe(wio, tmp, &dropped, list) {
+		list_del(&wio->list);
+		ocf_forward_end(wio->token, 0);
+		kfree(wio);
+	}
+
+	return result;
+}
+#endif
+
+uint32_t block_dev_get_inflight(ocf_volume_t vol,
+		enum cas_bd_io_class io_class)
+{
+	return atomic_read(&bd_object(vol)->inflight[io_class]);
+}
+
 int block_dev_init(void)
 {
 	int ret;
 
+	cas_bd_cmpl_batch_init();
+
+	/* Compressed volume I/O is on the way of cache device writeback */
+	cas_bd_compress_wq = alloc_workqueue("cas_compress",
+			WQ_UNBOUND | WQ_MEM_RECLAIM, 0);
+	if (!cas_bd_compress_wq) {
+		cas_bd_cmpl_batch_deinit();
+		return -ENOMEM;
+	}
+
 	ret = ocf_ctx_register_volume_type(cas_ctx, BLOCK_DEVICE_VOLUME,
 			&cas_object_blk_properties);
 	if (ret < 0)
 		return ret;
 
+	ret = ocf_ctx_register_volume_type(cas_ctx, STRIPED_DEVICE_VOLUME,
+			&cas_object_striped_properties);
+	if (ret < 0)
+		return ret;
+
+	ret = ocf_ctx_register_volume_type(cas_ctx, MIRRORED_DEVICE_VOLUME,
+			&cas_object_mirrored_properties);
+	if (ret < 0)
+		return ret;
+
+	ret = ocf_ctx_register_volume_type(cas_ctx, DAX_DEVICE_VOLUME,
+			&cas_object_dax_properties);
+	if (ret < 0)
+		return ret;
+
+	ret = ocf_ctx_register_volume_type(cas_ctx, NULL_DEVICE_VOLUME,
+			&cas_object_null_properties);
+	if (ret < 0)
+		return ret;
+
+	ret = ocf_ctx_register_volume_type(cas_ctx, RAM_DEVICE_VOLUME,
+			&cas_object_ram_properties);
+	if (ret < 0)
+		return ret;
+
+	ret = ocf_ctx_register_volume_type(cas_ctx, COMPRESSED_DEVICE_VOLUME,
+			&cas_object_compressed_properties);
+	if (ret < 0)
+		return ret;
+
 	return 0;
 }
+
+void block_dev_deinit(void)
+{
+	destroy_workqueue(cas_bd_compress_wq);
+	cas_bd_cmpl_batch_deinit();
+}
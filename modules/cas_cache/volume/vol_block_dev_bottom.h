@@ -6,6 +6,199 @@
 
 #ifndef __VOL_BLOCK_DEV_BOTTOM_H__
 #define __VOL_BLOCK_DEV_BOTTOM_H__
+
+/* Classes of I/O sent to bottom device with separate inflight limits */
+enum cas_bd_io_class {
+	CAS_BD_IO_FOREGROUND,
+		/*!< I/O serving user requests, e.g. cache misses */
+
+	CAS_BD_IO_BACKGROUND,
+		/*!< I/O issued by cache itself, e.g. cleaning */
+
+	CAS_BD_IO_CLASS_MAX,
+};
+
+/* Max number of devices striped volume consists of */
+#define CAS_BD_MEMBERS_MAX 8
+
+/* Separates paths of members in path of striped volume */
+#define CAS_BD_MEMBERS_SEPARATOR ","
+
+/*
+ * Size of stripe unit, i.e. of range placed on one member before moving to
+ * the next one. Not smaller than the largest cache line, so that no cache
+ * line is split between members.
+ */
+#define CAS_BD_STRIPE_SHIFT 16
+
+/* Separates paths of members in path of mirrored volume */
+#define CAS_BD_MIRROR_SEPARATOR "+"
+
+/* Number of members of mirrored volume */
+#define CAS_BD_MIRROR_MEMBERS 2
+
+/*
+ * Prefixes of path of single block device selecting null or RAM-backed volume
+ * on top of it, e.g. "null:/dev/sdb". Data written to such volume is lost.
+ */
+#define CAS_BD_NULL_PREFIX "null:"
+#define CAS_BD_RAM_PREFIX "ram:"
+
 int block_dev_init(void);
 
+void block_dev_deinit(void);
+
+uint64_t block_dev_get_flushes_elided(ocf_volume_t vol);
+
+/* Block device may be accessed directly through its DAX device */
+bool block_dev_dax_supported(struct block_device *bd);
+
+void block_dev_set_inflight_limit(ocf_volume_t vol,
+		enum cas_bd_io_class io_class, uint32_t limit);
+
+/*
+ * Let background I/O through regardless of inflight limits and pending
+ * foreground I/O
+ */
+void block_dev_set_inflight_unthrottled(ocf_volume_t vol, bool unthrottled);
+
+/*
+ * Limit background I/O to given number of bytes per second, 0 - unlimited.
+ * Takes precedence over unthrottling.
+ */
+void block_dev_set_background_rate(ocf_volume_t vol, uint64_t rate_limit);
+
+/*
+ * Gather background writes for given time and send them in ascending order
+ * of address, 0 - sent as they come
+ */
+void block_dev_set_writeback_sweep(ocf_volume_t vol, uint32_t window_us);
+
+uint32_t block_dev_get_writeback_sweep(ocf_volume_t vol);
+
+/* Size of chunks of cache data area tracked by background trim */
+#define CAS_BD_TRIM_CHUNK_SHIFT 20
+
+/*
+ * Track writes to chunks of cache device data area starting at @base, so
+ * that chunks not written since last reset of tracking can be discarded
+ */
+int block_dev_trim_start(ocf_volume_t vol, uint64_t base, uint64_t chunks);
+
+void block_dev_trim_stop(ocf_volume_t vol);
+
+/* Forget writes so far, called once no cache line is valid */
+void block_dev_trim_reset(ocf_volume_t vol);
+
+/*
+ * Fence range of at most @max chunks not written since reset, starting at
+ * the first such chunk from *@first on. Writes to fenced chunks are held
+ * until release. Returns number of chunks fenced, 0 if none is left.
+ */
+uint64_t block_dev_trim_fence(ocf_volume_t vol, uint64_t *first,
+		uint64_t max);
+
+/* Drop fence once discard of fenced range completed, called in process context */
+void block_dev_trim_release(ocf_volume_t vol);
+
+/* Unit of data checksummed */
+#define CAS_BD_CSUM_BLOCK_SIZE 4096
+
+/*
+ * Checksum blocks of volume written from now on and verify blocks read
+ * against them. Checksums are kept in memory only.
+ */
+int block_dev_csum_start(ocf_volume_t vol);
+
+void block_dev_csum_stop(ocf_volume_t vol);
+
+bool block_dev_csum_enabled(ocf_volume_t vol);
+
+uint64_t block_dev_csum_get_errors(ocf_volume_t vol);
+
+/*
+ * Send writes to volume below @end fitting its atomic write unit as atomic
+ * writes, 0 - none are. Has no effect unless volume is single block device
+ * with untorn write support.
+ */
+void block_dev_set_atomic_meta(ocf_volume_t vol, uint64_t end);
+
+/* Max atomic write unit of volume [bytes], 0 if not supported */
+uint32_t block_dev_get_atomic_write_unit(ocf_volume_t vol);
+
+/*
+ * Complete page aligned writes to volume below @end, i.e. of cache metadata,
+ * once buffered and write buffered pages back after @window_us, contiguous
+ * ones together. Flushes and FUA writes wait for writeback. If coalescing is
+ * enabled already, only window is changed. Fails unless volume is single
+ * block device with neither checksums nor atomic metadata writes.
+ */
+int block_dev_meta_co_start(ocf_volume_t vol, uint64_t end,
+		uint32_t window_us);
+
+/* Write buffered pages back and stop coalescing */
+void block_dev_meta_co_stop(ocf_volume_t vol);
+
+/* Coalescing window [us], 0 if metadata writes are not coalesced */
+uint32_t block_dev_meta_co_get_window(ocf_volume_t vol);
+
+void block_dev_meta_co_get_stats(ocf_volume_t vol, uint64_t *absorbed,
+		uint64_t *writes);
+
+/*
+ * Leave out writes of pages which are the same as last read from or written
+ * to volume. Enabled for volume of cache device marked before open, which
+ * learns hashes of all pages read until metadata @end is set, i.e. when
+ * cache is loaded. Hashes beyond @end are dropped.
+ */
+void block_dev_meta_elide_set_end(ocf_volume_t vol, uint64_t end);
+
+/* Number of pages whose writes have been left out */
+uint64_t block_dev_meta_elide_get_elided(ocf_volume_t vol);
+
+/*
+ * Resynchronize member of mirrored volume from the other one in background.
+ * Member is written but not read until whole volume is copied onto it.
+ */
+int block_dev_mirror_rebuild(ocf_volume_t vol, uint32_t member);
+
+/* State of member of mirrored volume, enum kcas_mirror_member_state */
+int block_dev_mirror_get_state(ocf_volume_t vol, uint32_t member,
+		uint32_t *state);
+
+/* Percent of volume copied by running rebuild, 100 if none is running */
+uint32_t block_dev_mirror_get_rebuild_progress(ocf_volume_t vol);
+
+struct blk_zone;
+
+/* Zone size of host-managed zoned device, 0 if device is not zoned */
+uint32_t block_dev_get_zone_sectors(ocf_volume_t vol);
+
+/*
+ * Account write to zoned device accepted by exported object in write
+ * pointer of its zone. Fails if zone was written back beyond address.
+ */
+int block_dev_zone_accept(ocf_volume_t vol, uint64_t addr, uint64_t bytes);
+
+/* Place zone append of zone containing *@addr at its write pointer */
+int block_dev_zone_append(ocf_volume_t vol, uint64_t *addr, uint64_t bytes);
+
+/* Report zones of zoned device, with data not written back yet included */
+int block_dev_zone_report(ocf_volume_t vol, sector_t sector,
+		unsigned int nr_zones,
+		int (*cb)(struct blk_zone *zone, unsigned int idx, void *data),
+		void *data);
+
+/*
+ * Reset zones of zoned device in range once writes in flight to them have
+ * completed, called in process context after range is dropped from cache
+ */
+int block_dev_zone_reset(ocf_volume_t vol, uint64_t addr, uint64_t bytes);
+
+uint32_t block_dev_get_inflight_limit(ocf_volume_t vol,
+		enum cas_bd_io_class io_class);
+
+uint32_t block_dev_get_inflight(ocf_volume_t vol,
+		enum cas_bd_io_class io_class);
+
 #endif /* __VOL_BLOCK_DEV_BOTTOM_H__ */
@@ -6,6 +6,21 @@
 
 #include "cas_cache.h"
 #include "utils/cas_err.h"
+#include "utils/utils_rpool.h"
+#include "cas_trace.h"
+
+extern u32 zero_copy_bio;
+extern u32 io_split_size_mb;
+extern u32 read_split_kb;
+extern u32 request_based_io;
+extern u32 poll_queues;
+extern u32 fs_meta_learn;
+extern u32 lba_heatmap;
+extern u32 mrc_estimation;
+extern u32 hot_set_regions;
+extern u32 io_trace_records;
+extern u32 inflight_tracking;
+extern u32 stage_latency_sample;
 
 static void blkdev_set_bio_data(struct blk_data *data, struct bio *bio)
 {
@@ -31,6 +46,110 @@ static void blkdev_set_bio_data(struct blk_data *data, struct bio *bio)
 #endif
 }
 
+/*
+ * Check whether bio vector can be passed to OCF without copying it. This is
+ * possible only if bio iterator starts at segment boundary and ends exactly
+ * at the end of some segment, and every segment lies within single page
+ * (which is what bio_vec_iter helpers assume).
+ */
+static struct bio_vec *blkdev_get_bio_vec_ref(struct bio *bio,
+		uint32_t *size)
+{
+#if LINUX_VERSION_CODE < KERNEL_VERSION(3, 14, 0)
+	return NULL;
+#else
+	struct bvec_iter iter = bio->bi_iter;
+	struct bio_vec *vec;
+	uint32_t bytes = 0, i = 0;
+
+	if (iter.bi_bvec_done)
+		return NULL;
+
+	vec = &bio->bi_io_vec[iter.bi_idx];
+
+	while (bytes < iter.bi_size) {
+		if (iter.bi_idx + i >= bio->bi_vcnt)
+			return NULL;
+		if (vec[i].bv_offset + vec[i].bv_len > PAGE_SIZE)
+			return NULL;
+		bytes += vec[i].bv_len;
+		i++;
+	}
+
+	if (bytes != iter.bi_size)
+		return NULL;
+
+	*size = i;
+	return vec;
+#endif
+}
+
+/* Pool of cache exported object belongs to, NULL for pool shared by caches */
+static inline struct env_mpool *blkdev_bvec_pool(struct bd_object *bvol)
+{
+	ocf_cache_t cache = ocf_volume_get_cache(bvol->front_volume);
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+
+	return cache_priv->bvec_pool;
+}
+
+static struct blk_data *blkdev_alloc_bio_data(struct bd_object *bvol,
+		struct bio *bio)
+{
+	struct env_mpool *pool = blkdev_bvec_pool(bvol);
+	struct blk_data *data;
+	struct bio_vec *vec;
+	uint32_t size;
+
+	if (zero_copy_bio) {
+		vec = blkdev_get_bio_vec_ref(bio, &size);
+		if (vec)
+			return cas_alloc_blk_data_ref(pool, vec, size, GFP_NOIO);
+	}
+
+	data = cas_alloc_blk_data(pool, bio_segments(bio), GFP_NOIO);
+	if (data)
+		blkdev_set_bio_data(data, bio);
+
+	return data;
+}
+
+static struct blk_data *blkdev_alloc_rq_data(struct bd_object *bvol,
+		struct request *rq)
+{
+	struct req_iterator iter;
+	struct blk_data *data;
+	uint32_t size = 0, i = 0;
+#if LINUX_VERSION_CODE < KERNEL_VERSION(3, 14, 0)
+	struct bio_vec *bvec;
+#else
+	struct bio_vec bvec;
+#endif
+
+	/* Single bio request can be served by bio helpers (zero copy) */
+	if (rq->bio == rq->biotail)
+		return blkdev_alloc_bio_data(bvol, rq->bio);
+
+	rq_for_each_segment(bvec, rq, iter)
+		size++;
+
+	data = cas_alloc_blk_data(blkdev_bvec_pool(bvol), size, GFP_NOIO);
+	if (!data)
+		return NULL;
+
+	rq_for_each_segment(bvec, rq, iter) {
+		BUG_ON(i >= data->size);
+#if LINUX_VERSION_CODE < KERNEL_VERSION(3, 14, 0)
+		data->vec[i] = *bvec;
+#else
+		data->vec[i] = bvec;
+#endif
+		i++;
+	}
+
+	return data;
+}
+
 static void blkdev_set_exported_object_flush_fua(ocf_core_t core)
 {
 	ocf_cache_t cache = ocf_core_get_cache(core);
@@ -76,6 +195,188 @@ static void blkdev_set_discard_properties(ocf_cache_t cache,
 	}
 }
 
+/*
+ * Set up how large bios are split before being submitted to OCF. Splits
+ * are aligned to cache line size or, if it is a multiple of cache line
+ * size, to optimal I/O size of the backend, so that split boundaries don't
+ * leave partially covered cache lines.
+ *
+ * OCF handles read of partially cached range as a miss of whole range,
+ * reading it all from core. With read_split_kb reads are split into pieces
+ * of whole cache lines instead, which OCF handles independently, so pieces
+ * fully cached are read from cache device while the rest is read from core
+ * at the same time.
+ */
+static void blkdev_set_split_geometry(struct bd_object *bvol,
+		uint32_t line_size, uint32_t io_opt)
+{
+	uint32_t align = line_size;
+	uint32_t max_size = io_split_size_mb * MiB;
+	uint32_t read_size, line_sectors = line_size >> SECTOR_SHIFT;
+
+	if (io_opt > line_size && io_opt % line_size == 0)
+		align = io_opt;
+
+	if (max_size < align)
+		max_size = align;
+
+	max_size -= max_size % align;
+
+	bvol->expobj_split_sectors = max_size >> SECTOR_SHIFT;
+	bvol->expobj_split_align_sectors = align >> SECTOR_SHIFT;
+
+	read_size = roundup(read_split_kb * KiB, line_size);
+	if (read_size && read_size < max_size) {
+		bvol->expobj_read_split_sectors = read_size >> SECTOR_SHIFT;
+		bvol->expobj_read_split_align_sectors = line_sectors;
+	} else {
+		bvol->expobj_read_split_sectors = bvol->expobj_split_sectors;
+		bvol->expobj_read_split_align_sectors =
+			bvol->expobj_split_align_sectors;
+	}
+}
+
+/*
+ * Get queue depth and number of hw queues of blk-mq block device. Bio based
+ * devices have no such properties, so false is returned for them.
+ */
+static bool blkdev_get_queue_params(struct block_device *bd,
+		unsigned int *queue_depth, unsigned int *nr_hw_queues)
+{
+	struct request_queue *q = cas_bdev_whole(bd)->bd_disk->queue;
+
+	if (!q->mq_ops)
+		return false;
+
+	*queue_depth = q->nr_requests;
+	*nr_hw_queues = q->nr_hw_queues;
+
+	return true;
+}
+
+/*
+ * Exported object has at most one default and one poll hw queue per cache
+ * I/O queue, as each hw queue is served by matching OCF worker queue.
+ */
+static void blkdev_apply_queue_params(unsigned int *queue_depth,
+		unsigned int *nr_hw_queues, unsigned int *nr_poll_queues,
+		unsigned int override_depth, unsigned int override_hw_queues)
+{
+	if (override_depth)
+		*queue_depth = override_depth;
+	if (override_hw_queues)
+		*nr_hw_queues = override_hw_queues;
+
+	*queue_depth = clamp_t(unsigned int, *queue_depth, 1,
+			BLK_MQ_MAX_DEPTH);
+	*nr_hw_queues = clamp_t(unsigned int, *nr_hw_queues, 1,
+			num_online_cpus());
+
+	*nr_poll_queues = min_t(unsigned int, poll_queues, num_online_cpus());
+	*nr_hw_queues += *nr_poll_queues;
+}
+
+/*
+ * Queue depth of core exported object is inherited from core device, as it
+ * is the one to absorb misses and cleaning. Number of hw queues follows
+ * the more parallel one of core and cache devices.
+ */
+static void blkdev_core_set_queue_params(struct cas_disk *dsk,
+		unsigned int *queue_depth, unsigned int *nr_hw_queues,
+		unsigned int *nr_poll_queues, void *private)
+{
+	ocf_core_t core = private;
+	ocf_cache_t cache = ocf_core_get_cache(core);
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	ocf_core_id_t core_id = ocf_core_get_id(core);
+	unsigned int core_hw_queues = 0, cache_hw_queues = 0, cache_depth;
+	struct bd_object *cache_bvol;
+
+	blkdev_get_queue_params(cas_disk_get_blkdev(dsk), queue_depth,
+			&core_hw_queues);
+
+	if (ocf_cache_is_device_attached(cache)) {
+		cache_bvol = bd_object(ocf_cache_get_volume(cache));
+		blkdev_get_queue_params(cas_disk_get_blkdev(cache_bvol->dsk),
+				&cache_depth, &cache_hw_queues);
+	}
+
+	if (core_hw_queues || cache_hw_queues)
+		*nr_hw_queues = max(core_hw_queues, cache_hw_queues);
+
+	blkdev_apply_queue_params(queue_depth, nr_hw_queues, nr_poll_queues,
+			cache_priv->exp_obj_queue_cfg[core_id].queue_depth,
+			cache_priv->exp_obj_queue_cfg[core_id].hw_queues);
+}
+
+/*
+ * Advertise I/O sizes which suit the cache. Anything below cache line size
+ * costs cache line sized metadata updates, so it is the minimal I/O size.
+ * Optimal I/O size is the one of the core, unless overridden, rounded up to
+ * whole cache lines.
+ */
+static void blkdev_core_set_io_hints(ocf_core_t core,
+		struct request_queue *exp_q, struct request_queue *core_q)
+{
+	ocf_cache_t cache = ocf_core_get_cache(core);
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	uint32_t line_size = ocf_cache_get_line_size(cache);
+	uint32_t io_opt_kb;
+	uint32_t io_opt;
+
+	io_opt_kb = cache_priv->exp_obj_queue_cfg[ocf_core_get_id(core)]
+			.io_opt_kb;
+	io_opt = io_opt_kb ? io_opt_kb * KiB : core_q->limits.io_opt;
+
+	exp_q->limits.io_min = max(exp_q->limits.io_min, line_size);
+	exp_q->limits.io_opt = max(round_up(io_opt, line_size), line_size);
+}
+
+/*
+ * Page cache read-ahead of exported object. Unless overridden it follows
+ * the kernel rule of twice the optimal I/O size, at least the default
+ * window, in whole cache lines. It is kept within sequential cutoff
+ * threshold of the core, so that single read-ahead of a random file access
+ * doesn't look like a sequential stream and bypass the cache.
+ */
+static uint32_t blkdev_core_get_read_ahead(ocf_core_t core,
+		struct request_queue *exp_q)
+{
+	ocf_cache_t cache = ocf_core_get_cache(core);
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	uint32_t line_size = ocf_cache_get_line_size(cache);
+	ocf_seq_cutoff_policy policy = ocf_seq_cutoff_policy_never;
+	uint32_t read_ahead_kb, read_ahead, threshold = 0;
+
+	read_ahead_kb = cache_priv->exp_obj_queue_cfg[ocf_core_get_id(core)]
+			.read_ahead_kb;
+	if (read_ahead_kb)
+		return read_ahead_kb * KiB;
+
+	read_ahead = max_t(uint32_t, 2 * exp_q->limits.io_opt,
+			VM_READAHEAD_PAGES << PAGE_SHIFT);
+	read_ahead = round_up(read_ahead, line_size);
+
+	ocf_mngt_core_get_seq_cutoff_policy(core, &policy);
+	ocf_mngt_core_get_seq_cutoff_threshold(core, &threshold);
+	if (policy != ocf_seq_cutoff_policy_never && threshold >= line_size)
+		read_ahead = min(read_ahead, rounddown(threshold, line_size));
+
+	return read_ahead;
+}
+
+static void blkdev_core_set_read_ahead(struct cas_disk *dsk, void *private)
+{
+	ocf_core_t core = private;
+	uint32_t read_ahead;
+
+	read_ahead = blkdev_core_get_read_ahead(core,
+			cas_exp_obj_get_queue(dsk));
+
+	CAS_SET_READ_AHEAD(cas_exp_obj_get_gendisk(dsk),
+			read_ahead >> PAGE_SHIFT);
+}
+
 /**
  * Map geometry of underlying (core) object geometry (sectors etc.)
  * to geometry of exported object.
@@ -131,46 +432,317 @@ static int blkdev_core_set_geometry(struct cas_disk *dsk, void *private)
 
 	exp_q->queue_flags |= (1 << QUEUE_FLAG_NONROT);
 
-	return 0;
+	blkdev_core_set_io_hints(core, exp_q, core_q);
+
+	blkdev_set_split_geometry(bd_object(core_vol),
+			ocf_cache_get_line_size(cache), exp_q->limits.io_opt);
+
+	return blkdev_core_set_zoned(dsk, core);
 }
 
+/* Number of preallocated defer contexts per CPU for each exported object */
+#define CAS_DEFER_BIO_POOL_LIMIT 128
+
 struct defer_bio_context {
 	struct work_struct io_work;
 	void (*cb)(struct bd_object *bvol, struct bio *bio);
 	struct bd_object *bvol;
 	struct bio *bio;
+	int cpu;
 };
 
+static void blkdev_handle_bio(struct bd_object *bvol, struct bio *bio);
+static void blkdev_handle_bio_noflush(struct bd_object *bvol, struct bio *bio);
+
+static void *blkdev_defer_pool_alloc(void *allocator_ctx, int cpu)
+{
+	return kmalloc(sizeof(struct defer_bio_context), GFP_KERNEL);
+}
+
+static void blkdev_defer_pool_free(void *allocator_ctx, void *item)
+{
+	kfree(item);
+}
+
 static void blkdev_defer_bio_work(struct work_struct *work)
 {
 	struct defer_bio_context *context;
+	struct bd_object *bvol;
 
 	context = container_of(work, struct defer_bio_context, io_work);
-	context->cb(context->bvol, context->bio);
-	kfree(context);
+	bvol = context->bvol;
+
+	context->cb(bvol, context->bio);
+
+	if (cas_rpool_try_put(bvol->expobj_defer_pool, context, context->cpu))
+		kfree(context);
+}
+
+/*
+ * Bios for which no context could be taken from the pool are linked into
+ * per-object lists and handled by single work embedded in bd_object, so
+ * deferring never needs to allocate memory.
+ */
+static void blkdev_defer_overflow_work(struct work_struct *work)
+{
+	struct bd_object *bvol;
+	struct bio_list bios, noflush_bios;
+	struct bio *bio;
+	unsigned long flags;
+
+	bvol = container_of(work, struct bd_object, expobj_defer_work);
+
+	spin_lock_irqsave(&bvol->expobj_defer_lock, flags);
+	bios = bvol->expobj_defer_bios;
+	noflush_bios = bvol->expobj_defer_noflush_bios;
+	bio_list_init(&bvol->expobj_defer_bios);
+	bio_list_init(&bvol->expobj_defer_noflush_bios);
+	spin_unlock_irqrestore(&bvol->expobj_defer_lock, flags);
+
+	while ((bio = bio_list_pop(&noflush_bios)))
+		blkdev_handle_bio_noflush(bvol, bio);
+
+	while ((bio = bio_list_pop(&bios)))
+		blkdev_handle_bio(bvol, bio);
+}
+
+static void blkdev_defer_bio_overflow(struct bd_object *bvol, struct bio *bio,
+		void (*cb)(struct bd_object *bvol, struct bio *bio))
+{
+	ocf_cache_t cache = ocf_volume_get_cache(bvol->front_volume);
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	unsigned long flags;
+
+	env_atomic64_inc(&cache_priv->defer_pool_exhausted);
+
+	spin_lock_irqsave(&bvol->expobj_defer_lock, flags);
+	if (cb == blkdev_handle_bio_noflush)
+		bio_list_add(&bvol->expobj_defer_noflush_bios, bio);
+	else
+		bio_list_add(&bvol->expobj_defer_bios, bio);
+	spin_unlock_irqrestore(&bvol->expobj_defer_lock, flags);
+
+	queue_work(bvol->expobj_wq, &bvol->expobj_defer_work);
 }
 
 static void blkdev_defer_bio(struct bd_object *bvol, struct bio *bio,
 		void (*cb)(struct bd_object *bvol, struct bio *bio))
 {
 	struct defer_bio_context *context;
+	int cpu;
 
 	BUG_ON(!bvol->expobj_wq);
 
-	context = kmalloc(sizeof(*context), GFP_ATOMIC);
+	trace_cas_bio_defer(bvol->btm_bd->bd_dev, bio);
+
+	context = cas_rpool_try_get(bvol->expobj_defer_pool, &cpu);
 	if (!context) {
-		CAS_BIO_ENDIO(bio, CAS_BIO_BISIZE(bio),
-			CAS_ERRNO_TO_BLK_STS(-ENOMEM));
+		blkdev_defer_bio_overflow(bvol, bio, cb);
 		return;
 	}
 
 	context->cb = cb;
 	context->bio = bio;
 	context->bvol = bvol;
+	context->cpu = cpu;
 	INIT_WORK(&context->io_work, blkdev_defer_bio_work);
 	queue_work(bvol->expobj_wq, &context->io_work);
 }
 
+static int blkdev_defer_init(struct bd_object *bvol, const char *name)
+{
+	bvol->expobj_defer_pool = cas_rpool_create(CAS_DEFER_BIO_POOL_LIMIT,
+			"cas_defer_bio", sizeof(struct defer_bio_context),
+			blkdev_defer_pool_alloc, blkdev_defer_pool_free, NULL);
+	if (!bvol->expobj_defer_pool)
+		return -ENOMEM;
+
+	bvol->expobj_wq = cas_module.exp_obj_wq;
+
+	spin_lock_init(&bvol->expobj_defer_lock);
+	bio_list_init(&bvol->expobj_defer_bios);
+	bio_list_init(&bvol->expobj_defer_noflush_bios);
+	INIT_WORK(&bvol->expobj_defer_work, blkdev_defer_overflow_work);
+
+	return 0;
+}
+
+static void blkdev_defer_deinit(struct bd_object *bvol)
+{
+	/*
+	 * No more bios are deferred, flushing shared workqueue waits for
+	 * those deferred before to be handled
+	 */
+	flush_workqueue(bvol->expobj_wq);
+	bvol->expobj_wq = NULL;
+	cas_rpool_destroy(bvol->expobj_defer_pool, blkdev_defer_pool_free,
+			NULL);
+	bvol->expobj_defer_pool = NULL;
+}
+
+static void blkdev_inflight_add(struct bd_object *bvol, struct blk_data *data)
+{
+	struct cas_bd_inflight *inflight = raw_cpu_ptr(bvol->inflight);
+	unsigned long flags;
+
+	data->inflight_queue = raw_smp_processor_id();
+	data->inflight_stage = KCAS_INFLIGHT_STAGE_OCF;
+	data->inflight = inflight;
+
+	spin_lock_irqsave(&inflight->lock, flags);
+	list_add_tail(&data->inflight_node, &inflight->list);
+	spin_unlock_irqrestore(&inflight->lock, flags);
+}
+
+static void blkdev_inflight_del(struct blk_data *data)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&data->inflight->lock, flags);
+	list_del(&data->inflight_node);
+	spin_unlock_irqrestore(&data->inflight->lock, flags);
+}
+
+static struct cas_dram_tier *blkdev_dram_tier(struct bd_object *bvol)
+{
+	ocf_cache_t cache = ocf_volume_get_cache(bvol->front_volume);
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+
+	return rcu_dereference(cache_priv->dram_tier);
+}
+
+/*
+ * Serve read from DRAM tier of cache if all of it is there, otherwise make
+ * it filled into tier on completion. Called before submission.
+ */
+static bool blkdev_dram_tier_read(struct bd_object *bvol,
+		struct blk_data *data, sector_t sector, uint32_t sectors)
+{
+	struct cas_dram_tier *tier;
+	bool hit = false;
+
+	rcu_read_lock();
+	tier = blkdev_dram_tier(bvol);
+	if (tier) {
+		hit = cas_dram_tier_read(tier, (uintptr_t)bvol, sector, sectors,
+				data->vec, data->size, &data->dram_seq);
+		if (!hit && data->dram_seq)
+			data->dram_bvol = bvol;
+	}
+	rcu_read_unlock();
+
+	return hit;
+}
+
+/*
+ * Writes invalidate DRAM tier both before submission and once completed, so
+ * that neither pages already there nor reads racing with the write leave
+ * stale data in it. Write is tracked even if there is no tier yet, as one
+ * may be configured while it is in flight.
+ */
+static void blkdev_dram_tier_write(struct bd_object *bvol,
+		struct blk_data *data, sector_t sector, uint64_t sectors)
+{
+	struct cas_dram_tier *tier;
+
+	rcu_read_lock();
+	tier = blkdev_dram_tier(bvol);
+	if (tier)
+		cas_dram_tier_invalidate(tier, (uintptr_t)bvol, sector, sectors);
+	rcu_read_unlock();
+
+	if (data)
+		data->dram_bvol = bvol;
+}
+
+static void blkdev_dram_tier_complete(struct blk_data *data, sector_t sector,
+		uint32_t sectors, int dir, int error)
+{
+	struct bd_object *bvol = data->dram_bvol;
+	struct cas_dram_tier *tier;
+
+	if (!bvol)
+		return;
+
+	/* Tier might have been dropped while request was in flight */
+	rcu_read_lock();
+	tier = blkdev_dram_tier(bvol);
+	if (tier && dir == WRITE) {
+		cas_dram_tier_invalidate(tier, (uintptr_t)bvol, sector,
+				sectors);
+	} else if (tier && !error) {
+		cas_dram_tier_fill(tier, (uintptr_t)bvol, sector, sectors,
+				data->vec, data->size, data->dram_seq);
+	}
+	rcu_read_unlock();
+}
+
+/*
+ * Set up accounting of exported object request in statistics of its cgroup.
+ * Called before submission.
+ */
+static void blkdev_cgroup_stats_start(struct bd_object *bvol,
+		ocf_cache_t cache, struct blk_data *data, struct bio *bio)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+
+	data->cgroup_entry = NULL;
+	if (!cache_priv->cgroup_stats)
+		return;
+
+	data->cgroup_entry = cas_cgroup_stats_get(cache_priv->cgroup_stats,
+			cas_bio_cgroup_id(bio));
+	data->cgroup_core = bvol;
+	data->core_read = false;
+}
+
+static void blkdev_cgroup_stats_end(struct blk_data *data, int dir,
+		uint32_t bytes, int error)
+{
+	if (data->cgroup_entry && !error) {
+		cas_cgroup_stats_account(data->cgroup_entry, dir, bytes,
+				READ_ONCE(data->core_read));
+	}
+}
+
+/* Account sampled request in histograms of stages it went through */
+static void blkdev_stage_record(struct blk_data *master)
+{
+	uint64_t start, end, now = ktime_get_ns();
+	int stage;
+
+	for (stage = 0; stage < KCAS_IO_STAGE_MAX; stage++) {
+		start = READ_ONCE(master->stage_ns[stage]);
+		end = stage + 1 < KCAS_IO_STAGE_MAX ?
+			READ_ONCE(master->stage_ns[stage + 1]) : now;
+		if (!start || !end)
+			continue;
+
+		cas_lat_hist_add(&master->stage_hist[stage],
+				end > start ? end - start : 0);
+	}
+}
+
+/*
+ * Accounting of completed exported object request, counterpart of
+ * blkdev_start_data() shared by bio and request based exported objects
+ */
+static void blkdev_end_data(struct blk_data *data, sector_t sector,
+		uint32_t sectors, int dir, int error)
+{
+	blkdev_dram_tier_complete(data, sector, sectors, dir, error);
+	blkdev_cgroup_stats_end(data, dir, sectors << SECTOR_SHIFT, error);
+
+	if (data->lat_hist)
+		cas_lat_hist_record(data->lat_hist, data->lat_start);
+
+	if (data->stage_hist)
+		blkdev_stage_record(data);
+
+	if (data->inflight)
+		blkdev_inflight_del(data);
+}
+
 static void blkdev_complete_data_master(struct blk_data *master, int error)
 {
 	int result;
@@ -180,7 +752,12 @@ static void blkdev_complete_data_master(struct blk_data *master, int error)
 	if (atomic_dec_return(&master->master_remaining))
 		return;
 
-	cas_generic_end_io_acct(master->bio, master->start_time);
+	if (master->io_acct)
+		cas_generic_end_io_acct(master->bio, master->start_time);
+
+	blkdev_end_data(master, CAS_BIO_BISECTOR(master->bio),
+			master->master_size >> SECTOR_SHIFT,
+			bio_data_dir(master->bio), master->error);
 
 	result = map_cas_err_to_generic(master->error);
 	CAS_BIO_ENDIO(master->bio, master->master_size,
@@ -189,229 +766,1005 @@ static void blkdev_complete_data_master(struct blk_data *master, int error)
 	cas_free_blk_data(master);
 }
 
-static void blkdev_complete_data(ocf_io_t io, void *priv1, void *priv2,
-		int error)
-{
-	struct bio *bio = priv1;
-	struct blk_data *master = priv2;
-	struct blk_data *data = ocf_io_get_data(io);
+static void blkdev_complete_data(ocf_io_t io, void *priv1, void *priv2,
+		int error)
+{
+	struct blk_data *master = priv1;
+
+	trace_cas_ocf_complete(io, error);
+	ocf_io_put(io);
+
+	blkdev_complete_data_master(master, error);
+}
+
+/*
+ * Single data vector is allocated for the whole bio and each split only
+ * refers to its part of it by offset, so splitting costs no allocations
+ * besides OCF I/O itself.
+ */
+static int blkdev_handle_data_single(struct bd_object *bvol,
+		struct blk_data *master, sector_t sector, uint32_t sectors,
+		uint32_t offset, ocf_part_id_t part_id)
+{
+	ocf_cache_t cache = ocf_volume_get_cache(bvol->front_volume);
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	struct bio *bio = master->bio;
+	ocf_queue_t queue = cache_priv_get_bio_queue(cache_priv,
+			smp_processor_id(), bio, sector);
+	uint64_t flags = CAS_BIO_OP_FLAGS(bio);
+	ocf_io_t io;
+	int ret;
+
+	io = ocf_volume_new_io(bvol->front_volume, queue,
+			sector << SECTOR_SHIFT, sectors << SECTOR_SHIFT,
+			(bio_data_dir(bio) == READ) ? OCF_READ : OCF_WRITE,
+			part_id, CAS_CLEAR_FLUSH(flags));
+
+	if (!io) {
+		printk(KERN_CRIT "Out of memory. Ending IO processing.\n");
+		return -ENOMEM;
+	}
+
+	ret = ocf_io_set_data(io, master, offset);
+	if (ret < 0) {
+		ocf_io_put(io);
+		return -EINVAL;
+	}
+
+	atomic_inc(&master->master_remaining);
+
+	ocf_io_set_cmpl(io, master, NULL, blkdev_complete_data);
+
+	trace_cas_ocf_submit(bvol->btm_bd->bd_dev, io, bio,
+			sector << SECTOR_SHIFT, sectors << SECTOR_SHIFT);
+	ocf_volume_submit_io(io);
+
+	return 0;
+}
+
+/* Cache device reads over core reads latency below which bypass ends [%] */
+#define CAS_SLOW_BYPASS_EXIT(threshold) ((threshold) - (threshold) / 8)
+
+/* One of that many bypassed reads goes to cache anyway to keep its latency
+ * average current */
+#define CAS_SLOW_BYPASS_PROBE 16
+
+/*
+ * Compare read latencies of cache device and core and tell whether read
+ * should bypass cache. Pass-through still serves dirty lines from cache, so
+ * bypassed reads are clean reads and misses, which are not promoted.
+ */
+static bool blkdev_slow_cache(struct bd_object *bvol, ocf_cache_t cache)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	uint32_t threshold = READ_ONCE(cache_priv->slow_bypass.threshold);
+	struct bd_object *cache_bvol;
+	uint64_t cache_lat, core_lat;
+	bool active;
+
+	if (!threshold || !ocf_cache_is_device_attached(cache))
+		return false;
+
+	/* Devices start tracking latency with first read checked */
+	cache_bvol = bd_object(ocf_cache_get_volume(cache));
+	if (unlikely(!READ_ONCE(cache_bvol->read_lat_track)))
+		WRITE_ONCE(cache_bvol->read_lat_track, true);
+	if (unlikely(!READ_ONCE(bvol->read_lat_track)))
+		WRITE_ONCE(bvol->read_lat_track, true);
+
+	cache_lat = READ_ONCE(cache_bvol->read_lat);
+	core_lat = READ_ONCE(bvol->read_lat);
+	if (!cache_lat || !core_lat)
+		return false;
+
+	active = atomic_read(&cache_priv->slow_bypass.active);
+	if (active)
+		threshold = CAS_SLOW_BYPASS_EXIT(threshold);
+
+	if (cache_lat * 100 > core_lat * threshold) {
+		if (!active && !atomic_cmpxchg(&cache_priv->slow_bypass.active,
+					0, 1)) {
+			WRITE_ONCE(cache_priv->slow_bypass.since,
+					ktime_get_ns());
+		}
+	} else {
+		if (active && atomic_cmpxchg(&cache_priv->slow_bypass.active,
+					1, 0)) {
+			atomic64_add(ktime_get_ns() - READ_ONCE(
+					cache_priv->slow_bypass.since),
+					&cache_priv->slow_bypass.total_ns);
+		}
+		return false;
+	}
+
+	if (!(atomic_inc_return(&cache_priv->slow_bypass.probe) %
+				CAS_SLOW_BYPASS_PROBE)) {
+		return false;
+	}
+
+	atomic64_inc(&cache_priv->slow_bypass.reads);
+	return true;
+}
+
+/*
+ * Move requests kept out of cache by CAS to bypass io class, i.e. streams
+ * exceeding sequential cutoff override of io class, requests not admitted
+ * by tinylfu promotion policy and reads while cache device is slow
+ */
+static ocf_part_id_t blkdev_bypass(struct bd_object *bvol,
+		ocf_cache_t cache, ocf_part_id_t part_id, int dir,
+		sector_t sector, uint32_t sectors)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	struct cas_tinylfu *tlfu;
+	uint64_t threshold;
+	bool admit = true;
+
+	if (part_id >= OCF_USER_IO_CLASS_MAX)
+		return part_id;
+
+	threshold = READ_ONCE(cache_priv->seq_cutoff_threshold[part_id]);
+	if (threshold && bvol->seq_cutoff &&
+			cas_seq_cutoff_check(bvol->seq_cutoff, part_id, dir,
+				sector, sectors, threshold)) {
+		return KCAS_IO_CLASS_BYPASS;
+	}
+
+	if (dir == READ && blkdev_slow_cache(bvol, cache))
+		return KCAS_IO_CLASS_BYPASS;
+
+	rcu_read_lock();
+	tlfu = rcu_dereference(cache_priv->tinylfu);
+	if (tlfu)
+		admit = cas_tinylfu_admit(tlfu, (uintptr_t)bvol, sector);
+	rcu_read_unlock();
+
+	return admit ? part_id : KCAS_IO_CLASS_BYPASS;
+}
+
+/* Feed recency of writes deferring cleaning of rewritten lines */
+static void blkdev_account_write(struct bd_object *bvol, ocf_cache_t cache,
+		sector_t sector, uint32_t sectors)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	struct cas_rewrite *rw;
+
+	rcu_read_lock();
+	rw = rcu_dereference(cache_priv->cleaner.rewrite);
+	if (rw)
+		cas_rewrite_access(rw, (uintptr_t)bvol, sector, sectors);
+	rcu_read_unlock();
+}
+
+/* Tell whether request starting now is sampled for stage latency */
+static uint64_t blkdev_stage_sample(struct bd_object *bvol)
+{
+	if (bvol->stage_hist && !(this_cpu_inc_return(bvol->stage_hist->seq) %
+				stage_latency_sample)) {
+		return ktime_get_ns();
+	}
+
+	return 0;
+}
+
+/*
+ * Per-request setup shared by bio and request based exported objects:
+ * classification, QoS, bypass and all accounting fed before submission.
+ * Request is described by its first bio, which is all the classifier and
+ * cgroup lookup look at. Returns I/O class to submit request with.
+ */
+static ocf_part_id_t blkdev_start_data(struct bd_object *bvol,
+		ocf_cache_t cache, struct blk_data *data, struct bio *bio,
+		sector_t sector, uint32_t sectors, uint64_t start_ns,
+		bool may_block)
+{
+	const int dir = bio_data_dir(bio);
+	ocf_part_id_t part_id;
+
+	if (start_ns) {
+		data->stage_hist = bvol->stage_hist->stage[dir];
+		memset(data->stage_ns, 0, sizeof(data->stage_ns));
+		data->stage_ns[KCAS_IO_STAGE_CLASSIFY] = start_ns;
+	}
+
+	part_id = cas_cls_classify(cache, bio);
+	if (data->stage_hist)
+		data->stage_ns[KCAS_IO_STAGE_SUBMIT] = ktime_get_ns();
+
+	if (bvol->qos) {
+		cas_qos_balance(bvol->qos, part_id, dir,
+				sectors << SECTOR_SHIFT, may_block);
+	}
+
+	part_id = blkdev_bypass(bvol, cache, part_id, dir, sector, sectors);
+	trace_cas_classify(bvol->btm_bd->bd_dev, bio, part_id);
+	data->io_class = part_id;
+	data->dedup = dir == READ;
+	blkdev_cgroup_stats_start(bvol, cache, data, bio);
+
+	if (dir == WRITE) {
+		blkdev_account_write(bvol, cache, sector, sectors);
+		blkdev_dram_tier_write(bvol, data, sector, sectors);
+	}
+
+	if (bvol->heatmap) {
+		uint32_t bucket = cas_bd_heatmap_bucket(bvol, sector);
+
+		if (dir == READ)
+			this_cpu_inc(bvol->heatmap->buckets[bucket].reads);
+		else
+			this_cpu_inc(bvol->heatmap->buckets[bucket].writes);
+	}
+
+	if (bvol->mrc) {
+		cas_mrc_access(bvol->mrc, sector >> bvol->mrc_line_shift,
+				(sector + sectors - 1) >> bvol->mrc_line_shift);
+	}
+
+	if (bvol->hot_set)
+		cas_hot_set_access(bvol->hot_set, sector, sectors);
+
+	if (bvol->io_trace) {
+		cas_io_trace_record(bvol->io_trace, sector, sectors, dir,
+				part_id);
+	}
+
+	if (bvol->read_ahead && dir == READ) {
+		cas_read_ahead_access(bvol->read_ahead, part_id, sector,
+				sectors);
+	}
+
+	data->lat_hist = NULL;
+	if (bvol->lat_hist && part_id < OCF_USER_IO_CLASS_MAX)
+		data->lat_hist = &bvol->lat_hist->exp_obj[part_id][dir];
+	if (data->lat_hist || bvol->inflight)
+		data->lat_start = ktime_get_ns();
+	if (bvol->inflight)
+		blkdev_inflight_add(bvol, data);
+
+	return part_id;
+}
+
+static void blkdev_handle_data(struct bd_object *bvol, struct bio *bio)
+{
+	ocf_cache_t cache = ocf_volume_get_cache(bvol->front_volume);
+	const bool is_read = bio_data_dir(bio) == READ;
+	const uint32_t max_io_sectors = is_read ?
+		bvol->expobj_read_split_sectors : bvol->expobj_split_sectors;
+	const uint32_t align_sectors = is_read ?
+		bvol->expobj_read_split_align_sectors :
+		bvol->expobj_split_align_sectors;
+	sector_t sector = CAS_BIO_BISECTOR(bio);
+	uint32_t sectors, to_submit, offset = 0;
+	struct blk_data *data;
+	ocf_part_id_t part_id;
+	uint64_t start_ns;
+	int error = 0;
+
+	if (unlikely(CAS_BIO_BISIZE(bio) == 0)) {
+		CAS_PRINT_RL(KERN_ERR
+			"Not able to handle empty BIO, flags = "
+			CAS_BIO_OP_FLAGS_FORMAT "\n",  CAS_BIO_OP_FLAGS(bio));
+		CAS_BIO_ENDIO(bio, CAS_BIO_BISIZE(bio),
+				CAS_ERRNO_TO_BLK_STS(-EINVAL));
+		return;
+	}
+
+	start_ns = blkdev_stage_sample(bvol);
+
+	data = blkdev_alloc_bio_data(bvol, bio);
+	if (!data) {
+		CAS_PRINT_RL(KERN_CRIT "BIO data vector allocation error\n");
+		CAS_BIO_ENDIO(bio, CAS_BIO_BISIZE(bio),
+				CAS_ERRNO_TO_BLK_STS(-ENOMEM));
+		return;
+	}
+
+	atomic_set(&data->master_remaining, 1);
+	data->bio = bio;
+	data->master_size = CAS_BIO_BISIZE(bio);
+
+	/*
+	 * Accounting touches stats shared by all CPUs, so it is skipped with
+	 * iostats of exported object turned off in sysfs
+	 */
+	data->io_acct = blk_queue_io_stat(cas_exp_obj_get_queue(bvol->dsk));
+	if (data->io_acct)
+		data->start_time = cas_generic_start_io_acct(bio);
+
+	/*
+	 * All splits of given bio belong to the same I/O class. Non-blocking
+	 * bios are charged by QoS, but never paused.
+	 */
+	part_id = blkdev_start_data(bvol, cache, data, bio, sector,
+			bio_sectors(bio), start_ns, !in_interrupt() &&
+			!(CAS_BIO_OP_FLAGS(bio) & CAS_REQ_NOWAIT));
+
+	if (bio_data_dir(bio) == READ && blkdev_dram_tier_read(bvol, data,
+			sector, bio_sectors(bio))) {
+		blkdev_complete_data_master(data, 0);
+		return;
+	}
+
+	if (data->stage_hist)
+		data->stage_ns[KCAS_IO_STAGE_OCF] = ktime_get_ns();
+
+	for (sectors = bio_sectors(bio); sectors > 0; sectors -= to_submit) {
+		if (sectors <= max_io_sectors)
+			to_submit = sectors;
+		else
+			to_submit = max_io_sectors - sector % align_sectors;
+
+		error = blkdev_handle_data_single(bvol, data, sector,
+				to_submit, offset, part_id);
+		if (error)
+			break;
+
+		sector += to_submit;
+		offset += to_submit << SECTOR_SHIFT;
+	}
+
+	blkdev_complete_data_master(data, error);
+}
+
+static void blkdev_complete_discard(ocf_io_t io, void *priv1, void *priv2,
+		int error)
+{
+	struct bio *bio = priv1;
+	int result = map_cas_err_to_generic(error);
+
+	CAS_BIO_ENDIO(bio, CAS_BIO_BISIZE(bio), CAS_ERRNO_TO_BLK_STS(result));
+	ocf_io_put(io);
+}
+
+/* Discards of at least twice that are split into parts handled in parallel */
+#define CAS_DISCARD_SPLIT_BYTES (64ULL << 20)
+
+/* Max number of parts, larger parts are used for discards beyond that */
+#define CAS_DISCARD_SPLIT_PARTS 64
+
+struct blkdev_discard_master {
+	atomic_t remaining;
+	int error;
+	void (*end)(void *priv, int error);
+	void *priv;
+};
+
+static void blkdev_discard_master_put(struct blkdev_discard_master *master)
+{
+	if (!atomic_dec_and_test(&master->remaining))
+		return;
+
+	master->end(master->priv, master->error);
+	kfree(master);
+}
+
+static void blkdev_complete_discard_part(ocf_io_t io, void *priv1,
+		void *priv2, int error)
+{
+	struct blkdev_discard_master *master = priv1;
+
+	if (error)
+		cmpxchg(&master->error, 0, error);
+
+	ocf_io_put(io);
+	blkdev_discard_master_put(master);
+}
+
+/*
+ * OCF handles single discard by walking its range one chunk after another,
+ * invalidating mapped lines and discarding core in turns, which takes long
+ * for large discards like fstrim or deleting VM images. Such discard is
+ * split into parts aligned to multiple of cache line size and the parts are
+ * submitted to different queues at once, so that invalidation and core
+ * discards of all parts proceed in parallel. Returns false if discard is to
+ * be submitted as a whole.
+ */
+static bool blkdev_submit_discard_split(struct bd_object *bvol,
+		uint64_t addr, uint64_t bytes,
+		void (*end)(void *priv, int error), void *priv)
+{
+	ocf_cache_t cache = ocf_volume_get_cache(bvol->front_volume);
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	struct blkdev_discard_master *master;
+	uint64_t part, next, end_addr = addr + bytes;
+	unsigned int idx = smp_processor_id();
+	ocf_io_t io;
+
+	if (bytes < 2 * CAS_DISCARD_SPLIT_BYTES)
+		return false;
+
+	master = kmalloc(sizeof(*master), GFP_NOIO);
+	if (!master)
+		return false;
+
+	atomic_set(&master->remaining, 1);
+	master->error = 0;
+	master->end = end;
+	master->priv = priv;
+
+	part = max_t(uint64_t, CAS_DISCARD_SPLIT_BYTES,
+			div64_u64(bytes, CAS_DISCARD_SPLIT_PARTS));
+	part = roundup(part, (uint64_t)ocf_cache_get_line_size(cache));
+
+	while (addr < end_addr) {
+		/* Boundaries are aligned, so no cache line is split by them */
+		next = min((div64_u64(addr, part) + 1) * part, end_addr);
+
+		io = ocf_volume_new_io(bvol->front_volume,
+				cache_priv_get_io_queue(cache_priv, idx++),
+				addr, next - addr, OCF_WRITE, 0, 0);
+		if (!io) {
+			CAS_PRINT_RL(KERN_CRIT
+				"Out of memory. Ending IO processing.\n");
+			cmpxchg(&master->error, 0, -OCF_ERR_NO_MEM);
+			break;
+		}
+
+		atomic_inc(&master->remaining);
+		ocf_io_set_cmpl(io, master, NULL, blkdev_complete_discard_part);
+		ocf_volume_submit_discard(io);
+
+		addr = next;
+	}
+
+	blkdev_discard_master_put(master);
+	return true;
+}
+
+static void blkdev_end_discard_bio(void *priv, int error)
+{
+	struct bio *bio = priv;
+	int result = map_cas_err_to_generic(error);
+
+	CAS_BIO_ENDIO(bio, CAS_BIO_BISIZE(bio), CAS_ERRNO_TO_BLK_STS(result));
+}
+
+static void blkdev_handle_discard(struct bd_object *bvol, struct bio *bio)
+{
+	ocf_cache_t cache = ocf_volume_get_cache(bvol->front_volume);
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	ocf_queue_t queue = cache_priv_get_io_queue(cache_priv,
+			smp_processor_id());
+	ocf_io_t io;
+
+	/* Discarded data is undefined, so it is invalidated only once */
+	blkdev_dram_tier_write(bvol, NULL, CAS_BIO_BISECTOR(bio),
+			bio_sectors(bio));
+
+	if (blkdev_submit_discard_split(bvol,
+			CAS_BIO_BISECTOR(bio) << SECTOR_SHIFT,
+			CAS_BIO_BISIZE(bio), blkdev_end_discard_bio, bio)) {
+		return;
+	}
+
+	io = ocf_volume_new_io(bvol->front_volume, queue,
+			CAS_BIO_BISECTOR(bio) << SECTOR_SHIFT,
+			CAS_BIO_BISIZE(bio), OCF_WRITE, 0, 0);
+	if (!io) {
+		CAS_PRINT_RL(KERN_CRIT
+			"Out of memory. Ending IO processing.\n");
+		CAS_BIO_ENDIO(bio, CAS_BIO_BISIZE(bio), CAS_ERRNO_TO_BLK_STS(-ENOMEM));
+		return;
+	}
+
+	ocf_io_set_cmpl(io, bio, NULL, blkdev_complete_discard);
+
+	ocf_volume_submit_discard(io);
+}
+
+static void blkdev_handle_bio_noflush(struct bd_object *bvol, struct bio *bio)
+{
+	if (CAS_IS_DISCARD(bio))
+		blkdev_handle_discard(bvol, bio);
+	else
+		blkdev_handle_data(bvol, bio);
+}
+
+/*
+ * Flushes sent to exported object are coalesced. While flush is in
+ * progress, newly arrived flush bios are gathered on pending list and are
+ * all served by single flush started once the current one completes.
+ */
+static void blkdev_flush_end_bios(struct bd_object *bvol,
+		struct bio_list *bios, int error)
+{
+	int result = map_cas_err_to_generic(error);
+	struct bio *bio;
+
+	while ((bio = bio_list_pop(bios))) {
+		if (CAS_BIO_BISIZE(bio) == 0 || error) {
+			CAS_BIO_ENDIO(bio, CAS_BIO_BISIZE(bio),
+					CAS_ERRNO_TO_BLK_STS(result));
+			continue;
+		}
+
+		/*
+		 * Flush completes on OCF queue thread or in interrupt, and
+		 * data phase may sleep throttled by QoS, so it is always
+		 * submitted from defer workqueue not to stall the queue
+		 */
+		blkdev_defer_bio(bvol, bio, blkdev_handle_bio_noflush);
+	}
+}
+
+static void blkdev_complete_flush(ocf_io_t io, void *priv1, void *priv2,
+		int error);
+
+static int blkdev_submit_flush(struct bd_object *bvol)
+{
+	ocf_cache_t cache = ocf_volume_get_cache(bvol->front_volume);
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	ocf_queue_t queue = cache_priv_get_io_queue(cache_priv,
+			smp_processor_id());
+	ocf_io_t io;
+
+	io = ocf_volume_new_io(bvol->front_volume, queue, 0, 0, OCF_WRITE, 0,
+			CAS_SET_FLUSH(0));
+	if (!io) {
+		CAS_PRINT_RL(KERN_CRIT
+			"Out of memory. Ending IO processing.\n");
+		return -ENOMEM;
+	}
+
+	ocf_io_set_cmpl(io, bvol, NULL, blkdev_complete_flush);
+
+	ocf_volume_submit_flush(io);
+
+	return 0;
+}
+
+static void blkdev_flush_finish(struct bd_object *bvol, int error)
+{
+	struct bio_list bios;
+	unsigned long flags;
+	bool next;
+
+	do {
+		spin_lock_irqsave(&bvol->expobj_flush_lock, flags);
+		bios = bvol->expobj_flush_bios;
+		bvol->expobj_flush_bios = bvol->expobj_flush_pending_bios;
+		bio_list_init(&bvol->expobj_flush_pending_bios);
+		next = !bio_list_empty(&bvol->expobj_flush_bios);
+		if (!next)
+			bvol->expobj_flush_in_progress = false;
+		spin_unlock_irqrestore(&bvol->expobj_flush_lock, flags);
+
+		blkdev_flush_end_bios(bvol, &bios, error);
+
+		if (!next)
+			return;
+
+		error = blkdev_submit_flush(bvol);
+	} while (error);
+}
+
+static void blkdev_complete_flush(ocf_io_t io, void *priv1, void *priv2,
+		int error)
+{
+	struct bd_object *bvol = priv1;
+
+	ocf_io_put(io);
+
+	blkdev_flush_finish(bvol, error);
+}
+
+static void blkdev_handle_flush(struct bd_object *bvol, struct bio *bio)
+{
+	unsigned long flags;
+	int error;
+
+	spin_lock_irqsave(&bvol->expobj_flush_lock, flags);
+	if (bvol->expobj_flush_in_progress) {
+		bio_list_add(&bvol->expobj_flush_pending_bios, bio);
+		spin_unlock_irqrestore(&bvol->expobj_flush_lock, flags);
+		return;
+	}
+	bvol->expobj_flush_in_progress = true;
+	bio_list_add(&bvol->expobj_flush_bios, bio);
+	spin_unlock_irqrestore(&bvol->expobj_flush_lock, flags);
+
+	error = blkdev_submit_flush(bvol);
+	if (error)
+		blkdev_flush_finish(bvol, error);
+}
+
+static void blkdev_handle_bio(struct bd_object *bvol, struct bio *bio)
+{
+	trace_cas_bio_queue(bvol->btm_bd->bd_dev, bio);
+
+	if (CAS_IS_SET_FLUSH(CAS_BIO_OP_FLAGS(bio)))
+		blkdev_handle_flush(bvol, bio);
+	else
+		blkdev_handle_bio_noflush(bvol, bio);
+}
+
+static void blkdev_submit_bio(struct bd_object *bvol, struct bio *bio)
+{
+	if (in_interrupt())
+		blkdev_defer_bio(bvol, bio, blkdev_handle_bio);
+	else
+		blkdev_handle_bio(bvol, bio);
+}
+
+/*
+ * Request based exported object. Each blk-mq request is served by single
+ * OCF I/O submitted to the worker queue matching request's hw queue.
+ */
+struct blkdev_rq_ctx {
+	struct blk_data *data;
+};
+
+static void blkdev_complete_rq(ocf_io_t io, void *priv1, void *priv2,
+		int error)
+{
+	struct request *rq = priv1;
+	struct blkdev_rq_ctx *ctx = blk_mq_rq_to_pdu(rq);
+	int result = map_cas_err_to_generic(error);
+
+	trace_cas_ocf_complete(io, error);
+	ocf_io_put(io);
+	if (ctx->data) {
+		blkdev_end_data(ctx->data, blk_rq_pos(rq), blk_rq_sectors(rq),
+				rq_data_dir(rq), error);
+		cas_free_blk_data(ctx->data);
+	}
+
+	cas_exp_obj_end_request(rq, result);
+}
+
+static int blkdev_handle_rq_flush(struct bd_object *bvol,
+		struct request *rq, ocf_queue_t queue)
+{
+	ocf_io_t io;
+
+	io = ocf_volume_new_io(bvol->front_volume, queue, 0, 0, OCF_WRITE, 0,
+			CAS_SET_FLUSH(0));
+	if (!io) {
+		CAS_PRINT_RL(KERN_CRIT
+			"Out of memory. Ending IO processing.\n");
+		return -ENOMEM;
+	}
+
+	ocf_io_set_cmpl(io, rq, NULL, blkdev_complete_rq);
+
+	ocf_volume_submit_flush(io);
+
+	return 0;
+}
+
+static void blkdev_end_discard_rq(void *priv, int error)
+{
+	cas_exp_obj_end_request(priv, map_cas_err_to_generic(error));
+}
+
+static int blkdev_handle_rq_discard(struct bd_object *bvol,
+		struct request *rq, ocf_queue_t queue)
+{
+	ocf_io_t io;
+
+	blkdev_dram_tier_write(bvol, NULL, blk_rq_pos(rq), blk_rq_sectors(rq));
+
+	if (blkdev_submit_discard_split(bvol, blk_rq_pos(rq) << SECTOR_SHIFT,
+			blk_rq_bytes(rq), blkdev_end_discard_rq, rq)) {
+		return 0;
+	}
+
+	io = ocf_volume_new_io(bvol->front_volume, queue,
+			blk_rq_pos(rq) << SECTOR_SHIFT, blk_rq_bytes(rq),
+			OCF_WRITE, 0, 0);
+	if (!io) {
+		CAS_PRINT_RL(KERN_CRIT
+			"Out of memory. Ending IO processing.\n");
+		return -ENOMEM;
+	}
+
+	ocf_io_set_cmpl(io, rq, NULL, blkdev_complete_rq);
 
-	ocf_io_put(io);
-	if (data != master)
-		cas_free_blk_data(data);
-	if (bio != master->bio)
-		bio_put(bio);
+	ocf_volume_submit_discard(io);
 
-	blkdev_complete_data_master(master, error);
+	return 0;
 }
 
-struct blkdev_data_master_ctx {
-	struct blk_data *data;
-	struct bio *bio;
-	uint32_t master_size;
-	unsigned long long start_time;
-};
-
-static int blkdev_handle_data_single(struct bd_object *bvol, struct bio *bio,
-		struct blkdev_data_master_ctx *master_ctx)
+static int blkdev_handle_rq_data(struct bd_object *bvol,
+		struct request *rq, ocf_queue_t queue)
 {
 	ocf_cache_t cache = ocf_volume_get_cache(bvol->front_volume);
-	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
-	ocf_queue_t queue = cache_priv->queues[smp_processor_id()].worker_queue;
+	struct blkdev_rq_ctx *ctx = blk_mq_rq_to_pdu(rq);
+	uint64_t flags = CAS_BIO_OP_FLAGS(rq->bio);
+	ocf_part_id_t part_id;
+	uint64_t start_ns;
 	ocf_io_t io;
-	struct blk_data *data;
-	uint64_t flags = CAS_BIO_OP_FLAGS(bio);
 	int ret;
 
-	data = cas_alloc_blk_data(bio_segments(bio), GFP_NOIO);
-	if (!data) {
+	start_ns = blkdev_stage_sample(bvol);
+
+	ctx->data = blkdev_alloc_rq_data(bvol, rq);
+	if (!ctx->data) {
 		CAS_PRINT_RL(KERN_CRIT "BIO data vector allocation error\n");
 		return -ENOMEM;
 	}
 
-	blkdev_set_bio_data(data, bio);
+	/*
+	 * Block layer accounts requests in iostats itself. Hw queues of
+	 * exported object are blocking, so queue_rq may sleep in QoS.
+	 */
+	part_id = blkdev_start_data(bvol, cache, ctx->data, rq->bio,
+			blk_rq_pos(rq), blk_rq_sectors(rq), start_ns,
+			!(flags & CAS_REQ_NOWAIT));
+
+	if (rq_data_dir(rq) == READ && blkdev_dram_tier_read(bvol, ctx->data,
+			blk_rq_pos(rq), blk_rq_sectors(rq))) {
+		blkdev_end_data(ctx->data, blk_rq_pos(rq), blk_rq_sectors(rq),
+				READ, 0);
+		cas_free_blk_data(ctx->data);
+		ctx->data = NULL;
+		cas_exp_obj_end_request(rq, 0);
+		return 0;
+	}
+
+	if (ctx->data->stage_hist)
+		ctx->data->stage_ns[KCAS_IO_STAGE_OCF] = ktime_get_ns();
 
 	io = ocf_volume_new_io(bvol->front_volume, queue,
-			CAS_BIO_BISECTOR(bio) << SECTOR_SHIFT,
-			CAS_BIO_BISIZE(bio), (bio_data_dir(bio) == READ) ?
-					OCF_READ : OCF_WRITE,
-			cas_cls_classify(cache, bio), CAS_CLEAR_FLUSH(flags));
-
+			blk_rq_pos(rq) << SECTOR_SHIFT, blk_rq_bytes(rq),
+			(rq_data_dir(rq) == READ) ? OCF_READ : OCF_WRITE,
+			part_id, CAS_CLEAR_FLUSH(flags));
 	if (!io) {
 		printk(KERN_CRIT "Out of memory. Ending IO processing.\n");
-		cas_free_blk_data(data);
-		return -ENOMEM;
+		ret = -ENOMEM;
+		goto err_io;
 	}
 
-	ret = ocf_io_set_data(io, data, 0);
+	ret = ocf_io_set_data(io, ctx->data, 0);
 	if (ret < 0) {
-		ocf_io_put(io);
-		cas_free_blk_data(data);
-		return -EINVAL;
-	}
-
-	if (!master_ctx->data) {
-		atomic_set(&data->master_remaining, 1);
-		data->bio = master_ctx->bio;
-		data->master_size = master_ctx->master_size;
-		data->start_time = master_ctx->start_time;
-		master_ctx->data = data;
+		ret = -EINVAL;
+		goto err_set_data;
 	}
 
-	atomic_inc(&master_ctx->data->master_remaining);
-
-	ocf_io_set_cmpl(io, bio, master_ctx->data, blkdev_complete_data);
+	ocf_io_set_cmpl(io, rq, NULL, blkdev_complete_rq);
 
+	trace_cas_ocf_submit(bvol->btm_bd->bd_dev, io, rq->bio,
+			blk_rq_pos(rq) << SECTOR_SHIFT, blk_rq_bytes(rq));
 	ocf_volume_submit_io(io);
 
 	return 0;
+
+err_set_data:
+	ocf_io_put(io);
+err_io:
+	blkdev_end_data(ctx->data, blk_rq_pos(rq), blk_rq_sectors(rq),
+			rq_data_dir(rq), ret);
+	cas_free_blk_data(ctx->data);
+	ctx->data = NULL;
+	return ret;
 }
 
-static void blkdev_handle_data(struct bd_object *bvol, struct bio *bio)
+static int blkdev_handle_rq(struct bd_object *bvol, struct request *rq,
+		unsigned int hw_queue)
 {
-	const uint32_t max_io_sectors = (32*MiB) >> SECTOR_SHIFT;
-	const uint32_t align_sectors = (128*KiB) >> SECTOR_SHIFT;
-	struct bio *split = NULL;
-	uint32_t sectors, to_submit;
-	int error;
-	struct blkdev_data_master_ctx master_ctx = {
-		.bio = bio,
-		.master_size = CAS_BIO_BISIZE(bio),
-	};
+	ocf_cache_t cache = ocf_volume_get_cache(bvol->front_volume);
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+	struct blkdev_rq_ctx *ctx = blk_mq_rq_to_pdu(rq);
+	/* Default and poll hw queues are both mapped onto cache I/O queues */
+	ocf_queue_t queue = cache_priv_get_io_queue(cache_priv, hw_queue);
 
-	if (unlikely(CAS_BIO_BISIZE(bio) == 0)) {
-		CAS_PRINT_RL(KERN_ERR
-			"Not able to handle empty BIO, flags = "
-			CAS_BIO_OP_FLAGS_FORMAT "\n",  CAS_BIO_OP_FLAGS(bio));
-		CAS_BIO_ENDIO(bio, CAS_BIO_BISIZE(bio),
-				CAS_ERRNO_TO_BLK_STS(-EINVAL));
-		return;
-	}
+	ctx->data = NULL;
 
-	master_ctx.start_time = cas_generic_start_io_acct(bio);
-	for (sectors = bio_sectors(bio); sectors > 0;) {
-		if (sectors <= max_io_sectors) {
-			split = bio;
-			sectors = 0;
-		} else {
-			to_submit = max_io_sectors -
-					CAS_BIO_BISECTOR(bio) % align_sectors;
-			split = cas_bio_split(bio, to_submit);
-			sectors -= to_submit;
-		}
+	if (CAS_IS_RQ_FLUSH(rq))
+		return blkdev_handle_rq_flush(bvol, rq, queue);
 
-		error = blkdev_handle_data_single(bvol, split, &master_ctx);
-		if (error)
-			goto err;
+	if (unlikely(blk_rq_bytes(rq) == 0)) {
+		CAS_PRINT_RL(KERN_ERR "Not able to handle empty request\n");
+		return -EINVAL;
 	}
 
-	blkdev_complete_data_master(master_ctx.data, 0);
+	if (CAS_IS_RQ_DISCARD(rq))
+		return blkdev_handle_rq_discard(bvol, rq, queue);
 
-	return;
+	return blkdev_handle_rq_data(bvol, rq, cache_priv_get_data_queue(
+				cache_priv, hw_queue, blk_rq_pos(rq)));
+}
 
-err:
-	if (split != bio)
-		bio_put(split);
-	if (master_ctx.data)
-		blkdev_complete_data_master(master_ctx.data, error);
-	else
-		CAS_BIO_ENDIO(bio, CAS_BIO_BISIZE(bio), CAS_ERRNO_TO_BLK_STS(error));
+/* Feed filesystem metadata I/O to metadata map of core */
+static inline void blkdev_core_learn_fs_meta(ocf_core_t core, uint64_t flags,
+		sector_t sector, uint32_t sectors)
+{
+	if (likely(!fs_meta_learn) || !(flags & REQ_META) || !sectors)
+		return;
+
+	cache_mngt_fs_meta_learn(ocf_core_get_cache(core),
+			ocf_core_get_id(core), sector, sectors);
 }
 
-static void blkdev_complete_discard(ocf_io_t io, void *priv1, void *priv2,
-		int error)
+#if defined(CAS_ZONED) && defined(CAS_ZONED_DISK)
+/*
+ * Exported object of host-managed zoned core is zoned as well. Write
+ * pointers it reports include data still in cache, zone append is placed at
+ * such write pointer and zone reset drops zone from cache before resetting
+ * zone of core. Zones of core are never opened, closed or finished
+ * explicitly, as data reaches core only on writeback.
+ */
+struct blkdev_zone_reset_ctx {
+	struct work_struct work;
+	ocf_core_t core;
+	struct bio *bio;
+	uint64_t addr;
+	uint64_t bytes;
+	int error;
+};
+
+static void blkdev_zone_reset_work(struct work_struct *work)
 {
-	struct bio *bio = priv1;
-	int result = map_cas_err_to_generic(error);
+	struct blkdev_zone_reset_ctx *ctx = container_of(work,
+			struct blkdev_zone_reset_ctx, work);
+	int result = map_cas_err_to_generic(ctx->error);
 
-	CAS_BIO_ENDIO(bio, CAS_BIO_BISIZE(bio), CAS_ERRNO_TO_BLK_STS(result));
+	if (!result) {
+		result = block_dev_zone_reset(ocf_core_get_volume(ctx->core),
+				ctx->addr, ctx->bytes);
+	}
+
+	CAS_BIO_ENDIO(ctx->bio, CAS_BIO_BISIZE(ctx->bio),
+			CAS_ERRNO_TO_BLK_STS(result));
+	kfree(ctx);
+}
+
+/* Range is dropped from cache, zones are reset in process context */
+static void blkdev_zone_reset_discarded(void *priv, int error)
+{
+	struct blkdev_zone_reset_ctx *ctx = priv;
+
+	ctx->error = error;
+	queue_work(system_unbound_wq, &ctx->work);
+}
+
+static void blkdev_complete_zone_reset_discard(ocf_io_t io, void *priv1,
+		void *priv2, int error)
+{
 	ocf_io_put(io);
+	blkdev_zone_reset_discarded(priv1, error);
 }
 
-static void blkdev_handle_discard(struct bd_object *bvol, struct bio *bio)
+static void blkdev_handle_zone_reset(ocf_core_t core, struct bio *bio)
 {
+	ocf_volume_t core_vol = ocf_core_get_volume(core);
+	struct bd_object *bvol = bd_object(core_vol);
 	ocf_cache_t cache = ocf_volume_get_cache(bvol->front_volume);
 	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
-	ocf_queue_t queue = cache_priv->queues[smp_processor_id()].worker_queue;
+	uint64_t zone_bytes = (uint64_t)block_dev_get_zone_sectors(core_vol) <<
+			SECTOR_SHIFT;
+	struct blkdev_zone_reset_ctx *ctx;
 	ocf_io_t io;
 
-	io = ocf_volume_new_io(bvol->front_volume, queue,
-			CAS_BIO_BISECTOR(bio) << SECTOR_SHIFT,
-			CAS_BIO_BISIZE(bio), OCF_WRITE, 0, 0);
-	if (!io) {
-		CAS_PRINT_RL(KERN_CRIT
-			"Out of memory. Ending IO processing.\n");
-		CAS_BIO_ENDIO(bio, CAS_BIO_BISIZE(bio), CAS_ERRNO_TO_BLK_STS(-ENOMEM));
+	ctx = kmalloc(sizeof(*ctx), GFP_NOIO);
+	if (!ctx) {
+		CAS_BIO_ENDIO(bio, CAS_BIO_BISIZE(bio),
+				CAS_ERRNO_TO_BLK_STS(-ENOMEM));
 		return;
 	}
 
-	ocf_io_set_cmpl(io, bio, NULL, blkdev_complete_discard);
+	INIT_WORK(&ctx->work, blkdev_zone_reset_work);
+	ctx->core = core;
+	ctx->bio = bio;
+	ctx->error = 0;
+	if (bio_op(bio) == REQ_OP_ZONE_RESET_ALL) {
+		ctx->addr = 0;
+		ctx->bytes = ocf_volume_get_length(core_vol);
+	} else {
+		ctx->addr = round_down(CAS_BIO_BISECTOR(bio) << SECTOR_SHIFT,
+				zone_bytes);
+		ctx->bytes = zone_bytes;
+	}
+
+	blkdev_dram_tier_write(bvol, NULL, ctx->addr >> SECTOR_SHIFT,
+			ctx->bytes >> SECTOR_SHIFT);
+
+	if (blkdev_submit_discard_split(bvol, ctx->addr, ctx->bytes,
+			blkdev_zone_reset_discarded, ctx)) {
+		return;
+	}
 
+	io = ocf_volume_new_io(bvol->front_volume,
+			cache_priv_get_io_queue(cache_priv, smp_processor_id()),
+			ctx->addr, ctx->bytes, OCF_WRITE, 0, 0);
+	if (!io) {
+		blkdev_zone_reset_discarded(ctx, -OCF_ERR_NO_MEM);
+		return;
+	}
+
+	ocf_io_set_cmpl(io, ctx, NULL, blkdev_complete_zone_reset_discard);
 	ocf_volume_submit_discard(io);
 }
 
-static void blkdev_handle_bio_noflush(struct bd_object *bvol, struct bio *bio)
+/* Returns true if bio is ended or is being handled already */
+static bool blkdev_core_zone_bio(ocf_core_t core, struct bio *bio)
 {
-	if (CAS_IS_DISCARD(bio))
-		blkdev_handle_discard(bvol, bio);
-	else
-		blkdev_handle_data(bvol, bio);
-}
+	ocf_volume_t core_vol = ocf_core_get_volume(core);
+	uint64_t addr = CAS_BIO_BISECTOR(bio) << SECTOR_SHIFT;
+	int result;
 
-static void blkdev_complete_flush(ocf_io_t io, void *priv1, void *priv2,
-		int error)
-{
-	struct bio *bio = priv1;
-	struct bd_object *bvol = priv2;
-	int result = map_cas_err_to_generic(error);
+	switch (bio_op(bio)) {
+	case REQ_OP_ZONE_RESET:
+	case REQ_OP_ZONE_RESET_ALL:
+		blkdev_handle_zone_reset(core, bio);
+		return true;
+	case REQ_OP_ZONE_OPEN:
+	case REQ_OP_ZONE_CLOSE:
+		result = 0;
+		break;
+	case REQ_OP_ZONE_FINISH:
+		result = -EOPNOTSUPP;
+		break;
+	case REQ_OP_ZONE_APPEND:
+		/* Handled as write at write pointer, reporting its sector */
+		result = block_dev_zone_append(core_vol, &addr,
+				CAS_BIO_BISIZE(bio));
+		if (result)
+			break;
+		CAS_BIO_BISECTOR(bio) = addr >> SECTOR_SHIFT;
+		return false;
+	default:
+		if (bio_data_dir(bio) != WRITE || !bio_sectors(bio) ||
+				CAS_IS_DISCARD(bio)) {
+			return false;
+		}
+		result = block_dev_zone_accept(core_vol, addr,
+				CAS_BIO_BISIZE(bio));
+		if (!result)
+			return false;
+		break;
+	}
 
-	ocf_io_put(io);
+	CAS_BIO_ENDIO(bio, CAS_BIO_BISIZE(bio), CAS_ERRNO_TO_BLK_STS(result));
+	return true;
+}
 
-	if (CAS_BIO_BISIZE(bio) == 0 || error) {
-		CAS_BIO_ENDIO(bio, CAS_BIO_BISIZE(bio),
-				CAS_ERRNO_TO_BLK_STS(result));
-		return;
-	}
+static int blkdev_core_report_zones(struct cas_disk *dsk, sector_t sector,
+		unsigned int nr_zones,
+		int (*cb)(struct blk_zone *zone, unsigned int idx, void *data),
+		void *data, void *private)
+{
+	ocf_core_t core = private;
 
-	blkdev_defer_bio(bvol, bio, blkdev_handle_bio_noflush);
+	return block_dev_zone_report(ocf_core_get_volume(core), sector,
+			nr_zones, cb, data);
 }
 
-static void blkdev_handle_flush(struct bd_object *bvol, struct bio *bio)
+/*
+ * Exported object of zoned core is bio based, see blkdev_core_zone_bio().
+ * Requests of blk-mq exported object would reach the core with no zone
+ * handling and no write pointer ordering, so zoned core is refused there.
+ */
+static int blkdev_core_set_zoned(struct cas_disk *dsk, ocf_core_t core)
 {
-	ocf_cache_t cache = ocf_volume_get_cache(bvol->front_volume);
-	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
-	ocf_queue_t queue = cache_priv->queues[smp_processor_id()].worker_queue;
-	ocf_io_t io;
+	ocf_volume_t core_vol = ocf_core_get_volume(core);
+	uint32_t zone_sectors = block_dev_get_zone_sectors(core_vol);
 
-	io = ocf_volume_new_io(bvol->front_volume, queue, 0, 0, OCF_WRITE, 0,
-			CAS_SET_FLUSH(0));
-	if (!io) {
-		CAS_PRINT_RL(KERN_CRIT
-			"Out of memory. Ending IO processing.\n");
-		CAS_BIO_ENDIO(bio, CAS_BIO_BISIZE(bio), CAS_ERRNO_TO_BLK_STS(-ENOMEM));
-		return;
-	}
+	if (!zone_sectors)
+		return 0;
 
-	ocf_io_set_cmpl(io, bio, bvol, blkdev_complete_flush);
+	if (request_based_io) {
+		printk(KERN_ERR OCF_PREFIX_SHORT "Zoned core %s can't be "
+				"exported with request_based_io enabled\n",
+				ocf_core_get_name(core));
+		return -OCF_ERR_NOT_SUPP;
+	}
 
-	ocf_volume_submit_flush(io);
+	return cas_disk_set_zoned(cas_exp_obj_get_gendisk(dsk), zone_sectors,
+			min(zone_sectors, bd_object(core_vol)->expobj_split_sectors));
 }
-
-static void blkdev_handle_bio(struct bd_object *bvol, struct bio *bio)
+#else
+static bool blkdev_core_zone_bio(ocf_core_t core, struct bio *bio)
 {
-	if (CAS_IS_SET_FLUSH(CAS_BIO_OP_FLAGS(bio)))
-		blkdev_handle_flush(bvol, bio);
-	else
-		blkdev_handle_bio_noflush(bvol, bio);
+	return false;
 }
 
-static void blkdev_submit_bio(struct bd_object *bvol, struct bio *bio)
+static int blkdev_core_set_zoned(struct cas_disk *dsk, ocf_core_t core)
 {
-	if (in_interrupt())
-		blkdev_defer_bio(bvol, bio, blkdev_handle_bio);
-	else
-		blkdev_handle_bio(bvol, bio);
+	return 0;
 }
+#endif
 
 static void blkdev_core_submit_bio(struct cas_disk *dsk,
 		struct bio *bio, void *private)
@@ -423,12 +1776,65 @@ static void blkdev_core_submit_bio(struct cas_disk *dsk,
 
 	bvol = bd_object(ocf_core_get_volume(core));
 
+	if (bvol->zones && blkdev_core_zone_bio(core, bio))
+		return;
+
+	if (!CAS_IS_DISCARD(bio)) {
+		blkdev_core_learn_fs_meta(core, CAS_BIO_OP_FLAGS(bio),
+				CAS_BIO_BISECTOR(bio), bio_sectors(bio));
+	}
+
+	/* Writer is paused in its own context, never on behalf of others */
+	if (bvol->dirty_throttle && bio_data_dir(bio) == WRITE &&
+			bio_sectors(bio) && !CAS_IS_DISCARD(bio) &&
+			!(CAS_BIO_OP_FLAGS(bio) & CAS_REQ_NOWAIT) && !in_interrupt()) {
+		cas_dirty_throttle_balance(bvol->dirty_throttle);
+	}
+
 	blkdev_submit_bio(bvol, bio);
 }
 
+static int blkdev_core_queue_rq(struct cas_disk *dsk, struct request *rq,
+		unsigned int hw_queue, void *private)
+{
+	ocf_core_t core = private;
+	struct bd_object *bvol;
+
+	BUG_ON(!core);
+
+	bvol = bd_object(ocf_core_get_volume(core));
+
+	if (rq->bio && !CAS_IS_DISCARD(rq->bio)) {
+		blkdev_core_learn_fs_meta(core, CAS_BIO_OP_FLAGS(rq->bio),
+				blk_rq_pos(rq), blk_rq_sectors(rq));
+	}
+
+	/* Hw queues of exported object are blocking, so queue_rq may sleep */
+	if (bvol->dirty_throttle && rq_data_dir(rq) == WRITE &&
+			blk_rq_sectors(rq) && !CAS_IS_RQ_DISCARD(rq) &&
+			!(CAS_BIO_OP_FLAGS(rq->bio) & CAS_REQ_NOWAIT)) {
+		cas_dirty_throttle_balance(bvol->dirty_throttle);
+	}
+
+	return blkdev_handle_rq(bvol, rq, hw_queue);
+}
+
 static struct cas_exp_obj_ops kcas_core_exp_obj_ops = {
 	.set_geometry = blkdev_core_set_geometry,
+	.set_read_ahead = blkdev_core_set_read_ahead,
+	.set_queue_params = blkdev_core_set_queue_params,
 	.submit_bio = blkdev_core_submit_bio,
+#if defined(CAS_ZONED) && defined(CAS_ZONED_DISK)
+	.report_zones = blkdev_core_report_zones,
+#endif
+};
+
+static struct cas_exp_obj_ops kcas_core_exp_obj_rq_ops = {
+	.set_geometry = blkdev_core_set_geometry,
+	.set_read_ahead = blkdev_core_set_read_ahead,
+	.set_queue_params = blkdev_core_set_queue_params,
+	.queue_rq = blkdev_core_queue_rq,
+	.cmd_size = sizeof(struct blkdev_rq_ctx),
 };
 
 static int blkdev_cache_set_geometry(struct cas_disk *dsk, void *private)
@@ -470,6 +1876,24 @@ static int blkdev_cache_set_geometry(struct cas_disk *dsk, void *private)
 	return 0;
 }
 
+static void blkdev_cache_set_queue_params(struct cas_disk *dsk,
+		unsigned int *queue_depth, unsigned int *nr_hw_queues,
+		unsigned int *nr_poll_queues, void *private)
+{
+	blkdev_get_queue_params(cas_disk_get_blkdev(dsk), queue_depth,
+			nr_hw_queues);
+
+	blkdev_apply_queue_params(queue_depth, nr_hw_queues, nr_poll_queues,
+			0, 0);
+}
+
+static inline void blkdev_count_standby_write(ocf_cache_t cache)
+{
+	struct cache_priv *cache_priv = ocf_cache_get_priv(cache);
+
+	env_atomic64_inc(&cache_priv->standby_writes);
+}
+
 static void blkdev_cache_submit_bio(struct cas_disk *dsk,
 		struct bio *bio, void *private)
 {
@@ -480,14 +1904,39 @@ static void blkdev_cache_submit_bio(struct cas_disk *dsk,
 
 	bvol = bd_object(ocf_cache_get_volume(cache));
 
+	if (bio_data_dir(bio) == WRITE && bio_sectors(bio))
+		blkdev_count_standby_write(cache);
+
 	blkdev_submit_bio(bvol, bio);
 }
 
+static int blkdev_cache_queue_rq(struct cas_disk *dsk, struct request *rq,
+		unsigned int hw_queue, void *private)
+{
+	ocf_cache_t cache = private;
+
+	BUG_ON(!cache);
+
+	if (rq_data_dir(rq) == WRITE && blk_rq_sectors(rq))
+		blkdev_count_standby_write(cache);
+
+	return blkdev_handle_rq(bd_object(ocf_cache_get_volume(cache)), rq,
+			hw_queue);
+}
+
 static struct cas_exp_obj_ops kcas_cache_exp_obj_ops = {
 	.set_geometry = blkdev_cache_set_geometry,
+	.set_queue_params = blkdev_cache_set_queue_params,
 	.submit_bio = blkdev_cache_submit_bio,
 };
 
+static struct cas_exp_obj_ops kcas_cache_exp_obj_rq_ops = {
+	.set_geometry = blkdev_cache_set_geometry,
+	.set_queue_params = blkdev_cache_set_queue_params,
+	.queue_rq = blkdev_cache_queue_rq,
+	.cmd_size = sizeof(struct blkdev_rq_ctx),
+};
+
 /****************************************
  * Exported object management functions *
  ****************************************/
@@ -509,18 +1958,22 @@ static int kcas_volume_create_exported_object(ocf_volume_t volume,
 	struct bd_object *bvol = bd_object(volume);
 	int result;
 
-	bvol->expobj_wq = alloc_workqueue("expobj_wq_%s",
-			WQ_MEM_RECLAIM | WQ_HIGHPRI, 0,
-			name);
-	if (!bvol->expobj_wq) {
-		result = -ENOMEM;
+	result = blkdev_defer_init(bvol, name);
+	if (result)
 		goto end;
-	}
+
+	/* Default split geometry, may be adjusted by set_geometry callback */
+	blkdev_set_split_geometry(bvol, 128 * KiB, 0);
+
+	spin_lock_init(&bvol->expobj_flush_lock);
+	bvol->expobj_flush_in_progress = false;
+	bio_list_init(&bvol->expobj_flush_bios);
+	bio_list_init(&bvol->expobj_flush_pending_bios);
 
 	result = cas_exp_obj_create(bvol->dsk, name,
 			THIS_MODULE, ops, priv);
 	if (result) {
-		destroy_workqueue(bvol->expobj_wq);
+		blkdev_defer_deinit(bvol);
 		goto end;
 	}
 
@@ -558,7 +2011,7 @@ static int kcas_volume_destroy_exported_object(ocf_volume_t volume)
 		goto err;
 
 	bvol->expobj_valid = false;
-	destroy_workqueue(bvol->expobj_wq);
+	blkdev_defer_deinit(bvol);
 
 	cas_exp_obj_unlock(bvol->dsk);
 	cas_exp_obj_cleanup(bvol->dsk);
@@ -580,6 +2033,8 @@ int kcas_core_create_exported_object(ocf_core_t core)
 	ocf_volume_t volume = ocf_core_get_volume(core);
 	struct bd_object *bvol = bd_object(volume);
 	char dev_name[DISK_NAME_LEN];
+	uint64_t sectors;
+	int cpu;
 
 	snprintf(dev_name, DISK_NAME_LEN, "cas%s-%s",
 			get_cache_id_string(cache),
@@ -587,15 +2042,110 @@ int kcas_core_create_exported_object(ocf_core_t core)
 
 	bvol->front_volume = ocf_core_get_front_volume(core);
 
+	/* Kept until volume is closed, so recreating object keeps counts */
+	if (lba_heatmap && !bvol->heatmap) {
+		sectors = ocf_volume_get_length(volume) >> SECTOR_SHIFT;
+		bvol->heatmap_shift = sectors > KCAS_HEATMAP_BUCKETS ?
+			fls64((sectors - 1) / KCAS_HEATMAP_BUCKETS) : 0;
+		bvol->heatmap = alloc_percpu(struct cas_bd_heatmap);
+		if (!bvol->heatmap)
+			return -OCF_ERR_NO_MEM;
+	}
+
+	if (stage_latency_sample && !bvol->stage_hist) {
+		bvol->stage_hist = alloc_percpu(struct cas_bd_stage_hist);
+		if (!bvol->stage_hist)
+			return -OCF_ERR_NO_MEM;
+	}
+
+	if (inflight_tracking && !bvol->inflight) {
+		bvol->inflight = alloc_percpu(struct cas_bd_inflight);
+		if (!bvol->inflight)
+			return -OCF_ERR_NO_MEM;
+		for_each_possible_cpu(cpu) {
+			spin_lock_init(&per_cpu_ptr(bvol->inflight, cpu)->lock);
+			INIT_LIST_HEAD(&per_cpu_ptr(bvol->inflight, cpu)->list);
+		}
+	}
+
+	if (mrc_estimation && !bvol->mrc) {
+		bvol->mrc_line_shift = ilog2(ocf_cache_get_line_size(cache) >>
+				SECTOR_SHIFT);
+		bvol->mrc = cas_mrc_create((ocf_volume_get_length(volume) >>
+				SECTOR_SHIFT) >> bvol->mrc_line_shift);
+		if (!bvol->mrc)
+			return -OCF_ERR_NO_MEM;
+	}
+
+	if (hot_set_regions && !bvol->hot_set) {
+		bvol->hot_set = cas_hot_set_create(hot_set_regions);
+		if (!bvol->hot_set)
+			return -OCF_ERR_NO_MEM;
+	}
+
+	if (io_trace_records && !bvol->io_trace) {
+		bvol->io_trace = cas_io_trace_create(io_trace_records);
+		if (!bvol->io_trace)
+			return -OCF_ERR_NO_MEM;
+	}
+
+	if (!bvol->read_ahead) {
+		bvol->read_ahead = cas_read_ahead_create(core);
+		if (!bvol->read_ahead)
+			return -OCF_ERR_NO_MEM;
+	}
+
+	if (!bvol->seq_cutoff) {
+		bvol->seq_cutoff = cas_seq_cutoff_create();
+		if (!bvol->seq_cutoff)
+			return -OCF_ERR_NO_MEM;
+	}
+
+	if (!bvol->dirty_throttle) {
+		bvol->dirty_throttle = cas_dirty_throttle_create(core);
+		if (!bvol->dirty_throttle)
+			return -OCF_ERR_NO_MEM;
+	}
+
+	if (!bvol->qos) {
+		bvol->qos = cas_qos_create();
+		if (!bvol->qos)
+			return -OCF_ERR_NO_MEM;
+	}
+
 	return kcas_volume_create_exported_object(volume, dev_name, core,
-			&kcas_core_exp_obj_ops);
+			request_based_io ? &kcas_core_exp_obj_rq_ops :
+					&kcas_core_exp_obj_ops);
 }
 
 int kcas_core_destroy_exported_object(ocf_core_t core)
 {
 	ocf_volume_t volume = ocf_core_get_volume(core);
+	struct bd_object *bvol = bd_object(volume);
+	int result;
 
-	return kcas_volume_destroy_exported_object(volume);
+	result = kcas_volume_destroy_exported_object(volume);
+
+	/* No more reads start read-ahead once exported object is gone */
+	if (!result && bvol->read_ahead) {
+		cas_read_ahead_destroy(bvol->read_ahead);
+		bvol->read_ahead = NULL;
+	}
+
+	/* Volume object may be reused by core added later */
+	if (!result) {
+		struct cache_priv *cache_priv = ocf_cache_get_priv(
+				ocf_core_get_cache(core));
+		struct cas_dram_tier *tier;
+
+		rcu_read_lock();
+		tier = rcu_dereference(cache_priv->dram_tier);
+		if (tier)
+			cas_dram_tier_invalidate_core(tier, (uintptr_t)bvol);
+		rcu_read_unlock();
+	}
+
+	return result;
 }
 
 int kcas_cache_create_exported_object(ocf_cache_t cache)
@@ -610,7 +2160,8 @@ int kcas_cache_create_exported_object(ocf_cache_t cache)
 	bvol->front_volume = ocf_cache_get_front_volume(cache);
 
 	return kcas_volume_create_exported_object(volume, dev_name, cache,
-			&kcas_cache_exp_obj_ops);
+			request_based_io ? &kcas_cache_exp_obj_rq_ops :
+					&kcas_cache_exp_obj_ops);
 }
 
 int kcas_cache_destroy_exported_object(ocf_cache_t cache)
@@ -674,7 +2225,7 @@ static int kcas_core_stop_exported_object(ocf_core_t core, void *cntx)
 		ret = cas_exp_obj_destroy(bvol->dsk);
 		if (!ret) {
 			bvol->expobj_valid = false;
-			destroy_workqueue(bvol->expobj_wq);
+			blkdev_defer_deinit(bvol);
 		}
 	}
 
@@ -714,3 +2265,34 @@ int kcas_cache_destroy_all_core_exported_objects(ocf_cache_t cache)
 
 	return 0;
 }
+
+struct block_device *kcas_core_get_exported_bdev(ocf_core_t core)
+{
+#ifdef CAS_DISK_PART0
+	struct bd_object *bvol = bd_object(ocf_core_get_volume(core));
+
+	if (!bvol->expobj_valid)
+		return NULL;
+
+	return CAS_DISK_PART0(cas_exp_obj_get_gendisk(bvol->dsk));
+#else
+	return NULL;
+#endif
+}
+
+void kcas_core_update_read_ahead(ocf_core_t core)
+{
+	struct bd_object *bvol = bd_object(ocf_core_get_volume(core));
+
+	if (!bvol->expobj_valid)
+		return;
+
+	blkdev_core_set_read_ahead(bvol->dsk, core);
+}
+
+void kcas_core_submit_bio(ocf_core_t core, struct bio *bio)
+{
+	struct bd_object *bvol = bd_object(ocf_core_get_volume(core));
+
+	blkdev_core_submit_bio(bvol->dsk, bio, core);
+}
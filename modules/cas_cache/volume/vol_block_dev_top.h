@@ -14,6 +14,15 @@ int kcas_core_destroy_exported_object(ocf_core_t core);
 
 int kcas_cache_destroy_all_core_exported_objects(ocf_cache_t cache);
 
+/* Block device of exported object of core, NULL if there is none */
+struct block_device *kcas_core_get_exported_bdev(ocf_core_t core);
+
+/* Recompute read-ahead of exported object of core, if there is one */
+void kcas_core_update_read_ahead(ocf_core_t core);
+
+/* Submit bio to exported object of core as if it came from block layer */
+void kcas_core_submit_bio(ocf_core_t core, struct bio *bio);
+
 int kcas_cache_create_exported_object(ocf_cache_t cache);
 int kcas_cache_destroy_exported_object(ocf_cache_t cache);
 
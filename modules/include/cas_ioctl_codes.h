@@ -35,6 +35,10 @@
 #define CACHE_INIT_STANDBY_NEW 2 /**< initialize failover standby cache */
 #define CACHE_INIT_STANDBY_LOAD 3 /**< load failover standby cache */
 
+#define CACHE_MODE_FLUSH_NO 0 /**< switch mode, leave dirty data on cache */
+#define CACHE_MODE_FLUSH_YES 1 /**< flush dirty data, then switch mode */
+#define CACHE_MODE_FLUSH_BACKGROUND 2 /**< switch mode, drain dirty data in background */
+
 struct fs_meta_lba {
 	unsigned long lba_beg;
 	unsigned long lba_end;
@@ -100,7 +104,7 @@ struct kcas_set_cache_state {
 
 	ocf_cache_mode_t caching_mode;
 
-	uint8_t flush_data; /**< should data be flushed? */
+	uint8_t flush_data; /**< one of CACHE_MODE_FLUSH_* */
 
 	int ext_err_code;
 };
@@ -112,6 +116,30 @@ struct kcas_insert_core {
 	bool try_add; /**< add core to pool if cache isn't present */
 	bool update_path; /**< provide alternative path for core device */
 	struct fs_meta_map fs_meta_dict;
+	uint32_t queue_depth; /**< exported object queue depth, 0 - inherit */
+	uint32_t hw_queues; /**< exported object hw queues, 0 - inherit */
+	/** exported object page cache read-ahead in KiB, 0 - derive */
+	uint32_t read_ahead_kb;
+	/** exported object optimal I/O size in KiB, 0 - derive */
+	uint32_t io_opt_kb;
+
+	int ext_err_code;
+};
+
+/* Max read-ahead and optimal I/O size of exported object in KiB (1 GiB) */
+#define KCAS_EXP_OBJ_IO_HINT_KB_MAX 1048576
+
+/**
+ * Add multiple cores to running cache in single call. Each entry is handled
+ * as KCAS_IOCTL_INSERT_CORE would, except that adding core to core pool,
+ * updating core path and filesystem metadata are not supported. Entry's core
+ * id and error code are updated, call fails with error of first entry which
+ * failed, leaving others added.
+ */
+struct kcas_insert_cores {
+	uint32_t cache_id; /**< id of an running cache */
+	uint32_t cores_count; /**< number of entries, up to OCF_CORE_MAX */
+	struct kcas_insert_core *cores; /**< cores to be added */
 
 	int ext_err_code;
 };
@@ -142,6 +170,8 @@ struct kcas_reset_stats {
 
 struct kcas_flush_cache {
 	uint32_t cache_id; /**< id of an running cache */
+	uint32_t rate_limit; /**< writeback MiB/s per core device, 0 - unlimited */
+	bool background; /**< purge: return once purge is started */
 
 	int ext_err_code;
 };
@@ -155,13 +185,54 @@ struct kcas_interrupt_flushing {
 struct kcas_flush_core {
 	uint32_t cache_id; /**< id of an running cache */
 	uint16_t core_id; /**< id core object to be removed */
+	uint32_t rate_limit; /**< writeback MiB/s to core device, 0 - unlimited */
+	bool background; /**< purge: return once purge is started */
 
 	int ext_err_code;
 };
 
+enum kcas_inflight_stage {
+	/** waiting in OCF engine (queue, cache line lock, metadata) */
+	KCAS_INFLIGHT_STAGE_OCF,
+
+	/** sent at least in part to cache or core device */
+	KCAS_INFLIGHT_STAGE_DEVICE,
+};
+
+struct kcas_inflight_entry {
+	uint16_t core_id;
+	uint8_t dir; /**< 0 - read, 1 - write */
+	uint8_t stage; /**< enum kcas_inflight_stage */
+	uint32_t queue; /**< CPU of I/O queue request was submitted to */
+	uint32_t bytes;
+	uint64_t addr; /**< offset on exported object in bytes */
+	uint64_t age_us;
+};
+
+/** Bucket 0 counts ages below 1us, bucket n ages in [2^(n-1), 2^n) us */
+#define KCAS_INFLIGHT_AGE_BUCKETS 32
+
 struct kcas_dump_inflight {
 	uint32_t cache_id; /**< id of an running cache */
 
+	/**
+	 * buffer to be filled with requests to exported objects, if NULL
+	 * inflight requests are dumped to kernel log instead
+	 */
+	struct kcas_inflight_entry *entries;
+
+	/**
+	 * on input number of entries which fit in the buffer, on output
+	 * number of inflight requests (may be greater than buffer size)
+	 */
+	uint32_t entries_count;
+
+	/** requests are tracked (inflight_tracking module param) */
+	bool enabled;
+
+	/** ages of all inflight requests */
+	uint64_t age_hist[KCAS_INFLIGHT_AGE_BUCKETS];
+
 	int ext_err_code;
 };
 
@@ -187,6 +258,668 @@ struct kcas_get_stats {
 	int ext_err_code;
 };
 
+/** Cgroups tracked separately by cache, the rest is summed in one entry */
+#define KCAS_CGROUP_STATS_MAX 4096
+
+/** Id of entry summing cgroups not tracked separately */
+#define KCAS_CGROUP_ID_OTHER (~0ULL)
+
+/** Statistics of requests to exported objects of cache from single cgroup */
+struct kcas_cgroup_stats {
+	/** cgroup id, 0 for requests not associated with any cgroup */
+	uint64_t cgroup_id;
+
+	/** reads served without reading core device */
+	uint64_t read_hits;
+
+	/** reads served at least partially from core device */
+	uint64_t read_misses;
+
+	uint64_t writes;
+
+	uint64_t read_bytes;
+
+	uint64_t write_bytes;
+};
+
+/** Counters of cache retrieved along with its statistics */
+struct kcas_cache_counters {
+	/** bios deferred without preallocated context */
+	uint64_t defer_pool_exhausted;
+
+	/** requests classified by io classifier */
+	uint64_t classifier_invocations;
+
+	/** flushes completed without flushing cache and core devices */
+	uint64_t flushes_elided;
+
+	/** work found by queue threads while polling */
+	uint64_t queue_polls;
+
+	/** sleeps of queue threads waiting for work */
+	uint64_t queue_sleeps;
+
+	/** writes replicated to cache while in standby */
+	uint64_t standby_writes;
+
+	/** duration of last activation of standby cache [ms] */
+	uint64_t activate_time_ms;
+
+	/** cache data area discarded by background trim [MiB] */
+	uint64_t cache_trimmed;
+
+	/** data held by in-memory tier [B] */
+	uint64_t dram_tier_used;
+
+	/** reads served from in-memory tier */
+	uint64_t dram_tier_hits;
+
+	/** reads eligible for in-memory tier not found in it */
+	uint64_t dram_tier_misses;
+
+	/** data stored in compressed cache volume [B] */
+	uint64_t compress_stored;
+
+	/** space that data takes on compressed cache volume [B] */
+	uint64_t compress_packed;
+
+	/** data indexed for deduplication [B] */
+	uint64_t dedup_indexed;
+
+	/** space saved by deduplication [B] */
+	uint64_t dedup_saved;
+
+	/** blocks of cache device read with mismatching checksum */
+	uint64_t checksum_errors;
+
+	/** time spent bypassing slow cache device [ms] */
+	uint64_t slow_bypass_time_ms;
+
+	/** reads bypassing slow cache device */
+	uint64_t slow_bypass_reads;
+
+	/** metadata writes absorbed by coalescing */
+	uint64_t meta_coalesce_absorbed;
+
+	/** metadata writes issued by writeback of coalesced pages */
+	uint64_t meta_coalesce_writes;
+
+	/** writes of unchanged metadata pages left out */
+	uint64_t meta_elided;
+
+	/** time spent absorbing sequential writes [ms] */
+	uint64_t seq_absorb_time_ms;
+};
+
+struct kcas_get_stats_bulk {
+	/** id of a cache */
+	uint32_t cache_id;
+
+	/**
+	 * id of a core, OCF_CORE_ID_INVALID to retrieve statistics of cache
+	 * and all its cores
+	 */
+	uint16_t core_id;
+
+	/** retrieve also statistics of all configured ioclasses */
+	bool io_classes;
+
+	/**
+	 * on input number of entries which fit in the buffer, on output
+	 * number of entries available (may be greater than buffer size)
+	 */
+	uint32_t entries_count;
+
+	/** buffer to be filled with statistics entries */
+	struct kcas_get_stats *entries;
+
+	/**
+	 * buffer to be filled with statistics of cgroups using the cache,
+	 * NULL if not needed
+	 */
+	struct kcas_cgroup_stats *cgroup_entries;
+
+	/**
+	 * on input number of cgroup entries which fit in the buffer, on
+	 * output number of cgroups tracked (may be greater than buffer size)
+	 */
+	uint32_t cgroup_entries_count;
+
+	/** cgroups are tracked (cgroup_stats module param) */
+	bool cgroup_stats;
+
+	/** counters of cache, filled if core_id is OCF_CORE_ID_INVALID */
+	struct kcas_cache_counters counters;
+
+	int ext_err_code;
+};
+
+/**
+ * Latency histogram buckets are log-linear: latencies below
+ * 2^KCAS_LAT_HIST_MIN_SHIFT ns are split into 2^KCAS_LAT_HIST_SUB_BITS
+ * equal buckets and so is each following power of two range. Last bucket
+ * collects all latencies which don't fit in preceding ones.
+ */
+#define KCAS_LAT_HIST_SUB_BITS 2
+#define KCAS_LAT_HIST_MIN_SHIFT 10
+#define KCAS_LAT_HIST_GROUPS 24
+#define KCAS_LAT_HIST_BUCKETS (KCAS_LAT_HIST_GROUPS << KCAS_LAT_HIST_SUB_BITS)
+
+struct kcas_lat_hist {
+	/** number of requests completed within latency range of bucket */
+	uint64_t buckets[KCAS_LAT_HIST_BUCKETS];
+};
+
+enum kcas_lat_hist_type {
+	/** requests to exported object */
+	KCAS_LAT_HIST_EXP_OBJ_RD,
+	KCAS_LAT_HIST_EXP_OBJ_WR,
+	/** requests to cache device - hits, inserts and writeback */
+	KCAS_LAT_HIST_CACHE_DEV_RD,
+	KCAS_LAT_HIST_CACHE_DEV_WR,
+	/** requests to core device - misses, pass-through and cleaning */
+	KCAS_LAT_HIST_CORE_DEV_RD,
+	KCAS_LAT_HIST_CORE_DEV_WR,
+	KCAS_LAT_HIST_MAX,
+};
+
+/**
+ * Stages of requests to exported object, each one lasting until the next
+ * one starts. Requests skipping a stage (e.g. served without reaching
+ * bottom device) are not accounted in it and in the stage before.
+ */
+enum kcas_io_stage {
+	/** data allocation and IO classification */
+	KCAS_IO_STAGE_CLASSIFY,
+	/** bypass decisions, accounting and submission to OCF */
+	KCAS_IO_STAGE_SUBMIT,
+	/** OCF queueing and cache line lock waits until first bio is sent
+	 * to cache or core device */
+	KCAS_IO_STAGE_OCF,
+	/** from first bio sent to last bio completed by cache/core device */
+	KCAS_IO_STAGE_DEVICE,
+	/** OCF completion and deferral until request completes */
+	KCAS_IO_STAGE_COMPLETE,
+	KCAS_IO_STAGE_MAX,
+};
+
+struct kcas_get_lat_hist {
+	/** id of a cache */
+	uint32_t cache_id;
+
+	/** id of a core, OCF_CORE_ID_INVALID for sum of all cores */
+	uint16_t core_id;
+
+	/**
+	 * id of an ioclass, OCF_IO_CLASS_INVALID for all ioclasses;
+	 * applies to exported object histograms only
+	 */
+	uint16_t part_id;
+
+	/** histograms are collected (latency_histograms module param) */
+	bool enabled;
+
+	/** histograms of particular request types */
+	struct kcas_lat_hist hist[KCAS_LAT_HIST_MAX];
+
+	/**
+	 * one in that many requests to exported object is accounted in
+	 * histograms of its stages, 0 - not collected
+	 * (stage_latency_sample module param)
+	 */
+	uint32_t stage_sample;
+
+	/** histograms of stages of sampled requests indexed by direction */
+	struct kcas_lat_hist stage[2][KCAS_IO_STAGE_MAX];
+
+	int ext_err_code;
+};
+
+enum kcas_queue_type {
+	KCAS_QUEUE_WORKER,
+	KCAS_QUEUE_PORTER,
+	KCAS_QUEUE_IDLE,
+};
+
+struct kcas_queue_stats_entry {
+	/** CPU the queue belongs to */
+	uint32_t cpu;
+
+	/** type of the queue, one of kcas_queue_type */
+	uint32_t type;
+
+	/** number of requests pending in the queue right now */
+	uint32_t pending;
+
+	/** max number of pending requests seen when queue was run */
+	uint32_t max_pending;
+
+	/** number of queue runs */
+	uint64_t runs;
+
+	/** number of requests processed by queue runs (approximate) */
+	uint64_t processed;
+
+	/** max number of requests processed by single queue run */
+	uint32_t max_batch;
+
+	/** number of queue runs triggered by kick, total and max time in ns
+	 *  from the kick to the run */
+	uint64_t dwells;
+	uint64_t dwell_ns;
+	uint64_t dwell_max_ns;
+
+	/** total time in ns spent running and waiting between runs */
+	uint64_t busy_ns;
+	uint64_t idle_ns;
+
+	/** number of times porter queue was picked by balancer */
+	uint64_t selected;
+};
+
+struct kcas_get_queue_stats {
+	/** id of a cache */
+	uint32_t cache_id;
+
+	/**
+	 * on input number of entries which fit in the buffer, on output
+	 * number of queues (may be greater than buffer size)
+	 */
+	uint32_t entries_count;
+
+	/** buffer to be filled with per queue statistics */
+	struct kcas_queue_stats_entry *entries;
+
+	int ext_err_code;
+};
+
+/** Number of LBA ranges of core heatmap, see KCAS_IOCTL_GET_HEATMAP */
+#define KCAS_HEATMAP_BUCKETS 256
+
+struct kcas_heatmap_bucket {
+	/** requests to exported object starting in the range */
+	uint64_t reads;
+	uint64_t writes;
+
+	/**
+	 * reads served without reading core device (approximated as reads
+	 * to exported object less reads sent to core device in the range)
+	 */
+	uint64_t read_hits;
+};
+
+struct kcas_get_heatmap {
+	/** id of a cache */
+	uint32_t cache_id;
+
+	/** id of a core */
+	uint16_t core_id;
+
+	/** heatmap is collected (lba_heatmap module param) */
+	bool enabled;
+
+	/** size of LBA range of each bucket in 512B sectors */
+	uint64_t bucket_sectors;
+
+	struct kcas_heatmap_bucket buckets[KCAS_HEATMAP_BUCKETS];
+
+	int ext_err_code;
+};
+
+/**
+ * Reuse distance histogram layout: distances below 2^KCAS_MRC_SUB_BITS
+ * have own buckets, each further power of two range is split into
+ * 2^KCAS_MRC_SUB_BITS equal buckets.
+ */
+#define KCAS_MRC_SUB_BITS 2
+#define KCAS_MRC_BUCKETS ((64 - KCAS_MRC_SUB_BITS + 1) << KCAS_MRC_SUB_BITS)
+
+struct kcas_get_mrc {
+	/** id of a cache */
+	uint32_t cache_id;
+
+	/** id of a core */
+	uint16_t core_id;
+
+	/** miss ratio curve is estimated (mrc_estimation module param) */
+	bool enabled;
+
+	/** one of 2^sample_shift cache lines of core is sampled */
+	uint32_t sample_shift;
+
+	/** sampled accesses to lines not accessed before (cold misses) */
+	uint64_t cold;
+
+	/**
+	 * sampled accesses by number of distinct cache lines accessed since
+	 * previous access to the same line, scaled by sampling rate
+	 */
+	uint64_t hist[KCAS_MRC_BUCKETS];
+
+	int ext_err_code;
+};
+
+/** Size of region of core tracked in hot set, 128 KiB */
+#define KCAS_HOT_SET_REGION_SECTORS 256
+
+struct kcas_hot_region {
+	/** first sector of region */
+	uint64_t sector;
+
+	/** approximate number of accesses to region */
+	uint32_t count;
+};
+
+/**
+ * Most accessed regions of core, hottest first
+ */
+struct kcas_get_hot_set {
+	/** id of a cache */
+	uint32_t cache_id;
+
+	/** id of a core */
+	uint16_t core_id;
+
+	/** halve access counts once they are read, aging old accesses */
+	bool decay;
+
+	/** hot set is tracked (hot_set_regions module param) */
+	bool enabled;
+
+	/** user buffer for regions */
+	struct kcas_hot_region *regions;
+
+	/** capacity of regions on input, number of regions on output */
+	uint32_t regions_count;
+
+	int ext_err_code;
+};
+
+/** Request of core captured in trace (io_trace_records module param) */
+struct kcas_trace_record {
+	/** time of arrival at exported object in nanoseconds, monotonic */
+	uint64_t time_ns;
+
+	/** first sector and length of request in sectors */
+	uint64_t sector;
+	uint32_t sectors;
+
+	/** 0 - read, 1 - write */
+	uint8_t dir;
+
+	/** io class request was assigned to */
+	uint8_t io_class;
+
+	uint16_t reserved;
+};
+
+/** Max number of records returned at once */
+#define KCAS_TRACE_RECORDS_MAX (1 << 16)
+
+/**
+ * Take records of requests of core captured since last call. Records of
+ * different CPUs are not ordered by time.
+ */
+struct kcas_get_trace {
+	/** id of a cache */
+	uint32_t cache_id;
+
+	/** id of a core */
+	uint16_t core_id;
+
+	/** trace is captured (io_trace_records module param) */
+	bool enabled;
+
+	/** user buffer for records */
+	struct kcas_trace_record *records;
+
+	/** capacity of records on input, number of records on output */
+	uint32_t records_count;
+
+	/** records overwritten before being taken, since last call */
+	uint64_t lost;
+
+	int ext_err_code;
+};
+
+/** Max number of ranges queued by single prefetch request */
+#define KCAS_PREFETCH_RANGES_MAX (1 << 20)
+
+struct kcas_prefetch_range {
+	/** first sector of range of core */
+	uint64_t sector;
+
+	/** length of range in sectors */
+	uint64_t sectors;
+};
+
+/**
+ * Read ranges of core in background, so that they are inserted into cache.
+ * Ranges are read in given order after ranges queued earlier.
+ */
+struct kcas_prefetch {
+	/** id of a cache */
+	uint32_t cache_id;
+
+	/** id of a core */
+	uint16_t core_id;
+
+	/** user buffer with ranges, NULL to only query progress */
+	struct kcas_prefetch_range *ranges;
+
+	/** number of ranges */
+	uint32_t ranges_count;
+
+	/** io class which prefetched ranges are inserted into */
+	uint32_t io_class;
+
+	/**
+	 * prefetch bandwidth limit of cache in MiB/s, 0 for unlimited,
+	 * replaces limit of ranges queued earlier
+	 */
+	uint32_t rate_limit;
+
+	/** sectors of all cores of cache queued, read and failed to read */
+	uint64_t pending_sectors;
+	uint64_t done_sectors;
+	uint64_t failed_sectors;
+
+	int ext_err_code;
+};
+
+/** Limits of in-kernel benchmark run */
+#define KCAS_BENCH_THREADS_MAX 256
+#define KCAS_BENCH_QUEUE_DEPTH_MAX 256
+#define KCAS_BENCH_IO_SIZE_MAX (1024 * 1024)
+#define KCAS_BENCH_DURATION_MAX 600
+
+enum kcas_bench_hist_type {
+	/** CPU time of submitting bio to exported object */
+	KCAS_BENCH_HIST_SUBMIT,
+	/** reads and writes from submission to completion */
+	KCAS_BENCH_HIST_RD,
+	KCAS_BENCH_HIST_WR,
+	KCAS_BENCH_HIST_MAX,
+};
+
+/**
+ * Generate I/O to exported object of core from kernel threads, bypassing
+ * syscalls and block layer, to measure overhead of cache itself. Writes
+ * overwrite data of core with garbage.
+ */
+struct kcas_bench {
+	/** id of a cache */
+	uint32_t cache_id;
+
+	/** id of a core */
+	uint16_t core_id;
+
+	/** number of threads, each on its own CPU */
+	uint32_t threads;
+
+	/** bios in flight per thread */
+	uint32_t queue_depth;
+
+	/** size of each bio in bytes, multiple of 512 */
+	uint32_t io_size;
+
+	/** percent of bios being reads */
+	uint32_t read_percent;
+
+	/** sectors of core accessed from its start, 0 for whole core */
+	uint64_t range;
+
+	/**
+	 * percent of bios going to first hot_percent of range, so that
+	 * hit ratio is controlled once hot part is in cache
+	 */
+	uint32_t hot_io_percent;
+	uint32_t hot_percent;
+
+	/** duration of run in seconds */
+	uint32_t duration;
+
+	/** completed bios, bytes transferred and failed bios */
+	uint64_t reads;
+	uint64_t writes;
+	uint64_t bytes;
+	uint64_t errors;
+
+	/** wall time of run in nanoseconds */
+	uint64_t elapsed_ns;
+
+	struct kcas_lat_hist hist[KCAS_BENCH_HIST_MAX];
+
+	int ext_err_code;
+};
+
+/** Limits of allocator benchmark run */
+#define KCAS_ALLOC_BENCH_DEPTH_MAX 4096
+#define KCAS_ALLOC_BENCH_MAX_ORDER 7
+
+enum kcas_alloc_bench_pool {
+	/** memory pool laid out as BIO vector pool, magazines disabled */
+	KCAS_ALLOC_BENCH_MPOOL,
+	/** same with per CPU magazines enabled */
+	KCAS_ALLOC_BENCH_MPOOL_MAG,
+	/** allocator of single object size with reserve pool */
+	KCAS_ALLOC_BENCH_ALLOCATOR,
+	KCAS_ALLOC_BENCH_POOL_MAX,
+};
+
+/**
+ * Allocate and free objects of private pool from kernel threads on all
+ * CPUs at once, to measure allocators of I/O path under contention.
+ */
+struct kcas_alloc_bench {
+	/** pool exercised, see enum kcas_alloc_bench_pool */
+	uint8_t pool;
+
+	/** number of threads, each on its own CPU */
+	uint32_t threads;
+
+	/** objects held by each thread, replaced in random order */
+	uint32_t depth;
+
+	/** percent of objects freed by thread of next CPU */
+	uint32_t remote_percent;
+
+	/**
+	 * largest memory pool allocation of 2^max_order elements, each order
+	 * drawn half as often as previous one
+	 */
+	uint32_t max_order;
+
+	/** duration of run in seconds */
+	uint32_t duration;
+
+	/** objects allocated, failed allocations and objects freed remotely */
+	uint64_t allocs;
+	uint64_t failures;
+	uint64_t remote_frees;
+
+	/** wall time of run in nanoseconds */
+	uint64_t elapsed_ns;
+
+	/**
+	 * reserve pool allocations served by sibling CPU and allocations
+	 * falling back to slab
+	 */
+	uint64_t steals;
+	uint64_t fallbacks;
+
+	/** allocations served by magazines and ones refilling them */
+	uint64_t mag_hits;
+	uint64_t mag_misses;
+
+	/** hardware cache misses of threads, ~0 if not available */
+	uint64_t cache_misses;
+
+	int ext_err_code;
+};
+
+/** Number of BIO vector pool allocation orders (1 to 128 pages) */
+#define KCAS_BVEC_POOL_ORDERS 8
+
+/**
+ * Memory used by cache. Pools shared by all caches are reported as a whole
+ * for each of them.
+ */
+struct kcas_get_mem_footprint {
+	/** id of a cache */
+	uint16_t cache_id;
+
+	/** OCF metadata held in DRAM in bytes, 0 if cache is not attached */
+	uint64_t metadata_bytes;
+
+	/** extents and size in bytes of filesystem metadata maps of cores */
+	uint64_t fs_meta_extents;
+	uint64_t fs_meta_bytes;
+
+	/**
+	 * number of classification rules and approximate size in bytes of
+	 * classifier including its lookup caches
+	 */
+	uint32_t cls_rules;
+	uint64_t cls_bytes;
+
+	/** memory held in reserve pools of all allocators (shared) */
+	uint64_t rpool_bytes;
+
+	/**
+	 * BIO vector pool (shared) objects allocated per order and size
+	 * of single object, order n holds 2^n pages
+	 */
+	uint32_t bvec_items[KCAS_BVEC_POOL_ORDERS];
+	uint32_t bvec_item_size[KCAS_BVEC_POOL_ORDERS];
+
+	int ext_err_code;
+};
+
+struct kcas_cleaner_stats {
+	/** number of cleaning passes */
+	uint64_t passes;
+
+	/**
+	 * cache lines cleaned, approximated with drop of dirty lines
+	 * count over each pass
+	 */
+	uint64_t lines_cleaned;
+
+	/** bytes written back to core devices, lines_cleaned in bytes */
+	uint64_t bytes_cleaned;
+
+	/** total time in ns spent in cleaning passes and sleeping */
+	uint64_t pass_ns;
+	uint64_t sleep_ns;
+
+	/** number of times cleaner was kicked */
+	uint64_t kicks;
+
+	/** recent cleaning rate in cache lines per second */
+	uint64_t rate;
+};
+
 struct kcas_cache_info {
 	/** id of a cache */
 	uint32_t cache_id;
@@ -201,6 +934,27 @@ struct kcas_cache_info {
 
 	struct ocf_cache_info info;
 
+	/**
+	 * Lazy write cache mode left with CACHE_MODE_FLUSH_BACKGROUND whose
+	 * dirty data is still being drained, ocf_cache_mode_none otherwise
+	 */
+	ocf_cache_mode_t mode_drain_from;
+
+	/** Chunks of purge in progress, 0 if there is none */
+	uint32_t purge_total;
+
+	/** Chunks already purged */
+	uint32_t purge_done;
+
+	/** Cleaner activity since cache was started or loaded */
+	struct kcas_cleaner_stats cleaner;
+
+	/**
+	 * Max atomic write unit of cache device metadata is written with
+	 * [bytes], 0 if device does not support untorn writes
+	 */
+	uint32_t atomic_write_unit;
+
 	int ext_err_code;
 };
 
@@ -260,6 +1014,9 @@ struct kcas_io_class {
 	/** IO class info */
 	struct ocf_io_class_info info;
 
+	/** Sequential cutoff threshold override of IO class [KiB], 0 if none */
+	uint32_t seq_cutoff_threshold;
+
 	int ext_err_code;
 };
 
@@ -272,6 +1029,12 @@ struct kcas_io_classes {
 
 	int ext_err_code;
 
+	/**
+	 * Sequential cutoff threshold overrides of IO classes [KiB], 0 for
+	 * IO classes following sequential cutoff of core only
+	 */
+	uint32_t seq_cutoff_threshold[OCF_USER_IO_CLASS_MAX];
+
 	/** IO class info */
 	struct ocf_io_class_info info[];
 };
@@ -279,6 +1042,106 @@ struct kcas_io_classes {
 #define KCAS_IO_CLASSES_SIZE (sizeof(struct kcas_io_classes) \
 		+ OCF_USER_IO_CLASS_MAX * sizeof(struct ocf_io_class_info))
 
+/**
+ * IO class which requests kept out of cache by CAS are moved to, i.e.
+ * sequential streams exceeding sequential cutoff threshold override of their
+ * IO class and requests not admitted by tinylfu promotion policy. It is
+ * configured as pass-through whenever any of them is in use, so it can't be
+ * used otherwise.
+ */
+#define KCAS_IO_CLASS_BYPASS OCF_IO_CLASS_ID_MAX
+
+/** Name of IO class of requests kept out of cache by CAS */
+#define KCAS_IO_CLASS_BYPASS_NAME "bypass"
+
+/** Max number of conditions of IO class rule reported in statistics */
+#define KCAS_IO_CLASS_CONDITIONS_MAX 32
+
+/** Number of power of two buckets of classification time histogram */
+#define KCAS_IO_CLASS_LATENCY_BUCKETS 32
+
+/**
+ * IO class classification statistics. Counters reset whenever rule of
+ * IO class is reloaded.
+ */
+struct kcas_io_class_stats {
+	/** Cache ID */
+	uint32_t cache_id;
+
+	/** IO class id for which statistics will be retrieved */
+	uint32_t class_id;
+
+	/** Rule of IO class is configured */
+	bool has_rule;
+
+	/** Number of times rule was evaluated */
+	uint64_t evaluations;
+
+	/** Number of times rule matched */
+	uint64_t matches;
+
+	/** Number of conditions of rule */
+	uint32_t conditions_no;
+
+	/** Number of evaluations of each condition, in rule order */
+	uint64_t condition_evaluations[KCAS_IO_CLASS_CONDITIONS_MAX];
+
+	/** Number of classifications of cache, regardless of IO class */
+	uint64_t classifications;
+
+	/** Sampled classification time, bucket N counts samples taking
+	 * [2^N, 2^(N+1)) ns. All zero unless sampling is enabled with
+	 * classifier_latency_sample module parameter */
+	uint64_t latency_hist[KCAS_IO_CLASS_LATENCY_BUCKETS];
+
+	int ext_err_code;
+};
+
+/** Limits of synthetic requests of classifier benchmark */
+#define KCAS_IO_CLASS_BENCH_REQUESTS_MAX (64 * 1024)
+#define KCAS_IO_CLASS_BENCH_PAGES_MAX 256
+
+/**
+ * Classify synthetic requests to exported object of core with rules
+ * currently loaded, without submitting them. Counters of IO class
+ * statistics include these classifications.
+ */
+struct kcas_io_class_bench {
+	/** Cache ID */
+	uint32_t cache_id;
+
+	/** id of a core which requests target */
+	uint16_t core_id;
+
+	/**
+	 * file whose pages already in page cache are carried by requests,
+	 * so that file rules are evaluated, empty for pages of no file
+	 */
+	char path[MAX_STR_LEN];
+
+	/** number of distinct requests, each classified in every round */
+	uint32_t requests;
+	uint32_t rounds;
+
+	/** requests are sized randomly from 1 to max_pages pages */
+	uint32_t max_pages;
+
+	/** percent of requests being reads */
+	uint32_t read_percent;
+
+	/** number of requests carrying pages of file */
+	uint32_t file_requests;
+
+	/** classifications done and time they took in nanoseconds */
+	uint64_t classifications;
+	uint64_t elapsed_ns;
+
+	/** classifications resulting in each IO class */
+	uint64_t io_class_hits[OCF_USER_IO_CLASS_MAX];
+
+	int ext_err_code;
+};
+
 /**
  * structure in which result of KCAS_IOCTL_LIST_CACHE is supplied from kernel module.
  */
@@ -293,6 +1156,113 @@ struct kcas_cache_list {
 	int ext_err_code;
 };
 
+/** Max size in bytes of extents passed by single update of metadata map */
+#define KCAS_UPDATE_FS_META_MAX_LENGTH (64 << 20)
+
+/**
+ * Filesystem metadata extents to add to or remove from metadata map of core
+ */
+struct kcas_update_fs_meta {
+	uint32_t cache_id; /**< id of an running cache */
+	uint16_t core_id; /**< id of core object */
+	bool remove; /**< remove extents instead of adding them */
+	struct fs_meta_map fs_meta_dict; /**< extents, struct fs_meta_lba */
+
+	int ext_err_code;
+};
+
+/**
+ * Progress of loading metadata of cache started with load
+ */
+struct kcas_load_progress {
+	uint32_t cache_id; /**< id of cache being loaded */
+	uint64_t metadata_size; /**< estimated size of metadata read on load */
+	uint64_t elapsed_ms; /**< time since load was started */
+
+	int ext_err_code;
+};
+
+enum kcas_async_op_type {
+	KCAS_ASYNC_OP_FLUSH_CACHE,
+	KCAS_ASYNC_OP_FLUSH_CORE,
+	KCAS_ASYNC_OP_PURGE_CACHE,
+	KCAS_ASYNC_OP_PURGE_CORE,
+	KCAS_ASYNC_OP_STOP_CACHE,
+	KCAS_ASYNC_OP_TYPE_MAX,
+};
+
+/** Number of async operations kept until their status is released */
+#define KCAS_ASYNC_OPS_MAX 256
+
+/**
+ * Management operation run in background. Ioctl returns as soon as
+ * operation is queued, its result is polled with KCAS_IOCTL_ASYNC_STATUS.
+ */
+struct kcas_async_op {
+	/** operation to run, enum kcas_async_op_type */
+	uint32_t type;
+
+	/** id of a cache */
+	uint32_t cache_id;
+
+	/** id of a core, used by core operations only */
+	uint16_t core_id;
+
+	/** flush dirty data before stopping cache */
+	bool flush_data;
+
+	/** flush rate limit, same as for synchronous flush */
+	uint32_t rate_limit;
+
+	/**
+	 * eventfd signalled when operation completes, -1 if caller only
+	 * polls operation status
+	 */
+	int eventfd;
+
+	/** id assigned to operation */
+	uint64_t op_id;
+
+	int ext_err_code;
+};
+
+struct kcas_async_status {
+	/** id of an operation returned by KCAS_IOCTL_ASYNC_OP */
+	uint64_t op_id;
+
+	/** sleep until operation completes */
+	bool wait;
+
+	/** forget operation once it is reported as completed */
+	bool release;
+
+	/** operation type and target, as passed on submission */
+	uint32_t type;
+	uint32_t cache_id;
+	uint16_t core_id;
+
+	/** operation completed */
+	bool done;
+
+	/**
+	 * result of completed operation, error code as reported in
+	 * ext_err_code by synchronous ioctl
+	 */
+	int result;
+
+	/** time since operation was queued until now or its completion */
+	uint64_t elapsed_ms;
+
+	/**
+	 * dirty cache lines of target when operation started and now,
+	 * lets caller estimate progress of flush
+	 */
+	uint64_t dirty_start;
+	uint64_t dirty;
+
+	int ext_err_code;
+};
+
 struct kcas_core_pool_remove {
 	char core_path_name[MAX_STR_LEN]; /**< path to a core object */
 
@@ -317,15 +1287,46 @@ enum kcas_core_param_id {
 	core_param_seq_cutoff_threshold,
 	core_param_seq_cutoff_policy,
 	core_param_seq_cutoff_promotion_count,
+	core_param_inflight_limit_foreground,
+	core_param_inflight_limit_background,
+	core_param_read_ahead_lines,
+	core_param_dirty_throttle_limit,
+	core_param_dirty_throttle_max_pause,
+	core_param_writeback_sweep_window,
+	core_param_qos_read_iops,
+	core_param_qos_write_iops,
+	core_param_qos_read_bandwidth,
+	core_param_qos_write_bandwidth,
+	core_param_get_qos_read_throttled,
+	core_param_get_qos_write_throttled,
 	core_param_id_max,
 };
 
+/* Max read-ahead window of sequential stream in cache lines */
+#define KCAS_READ_AHEAD_LINES_MAX 1024
+
+/* Max pause of single write throttled by dirty data of core in ms */
+#define KCAS_DIRTY_THROTTLE_MAX_PAUSE_MAX 1000
+
+/* Max time cleaning writes to core are gathered for sorting in us */
+#define KCAS_WRITEBACK_SWEEP_WINDOW_MAX 1000000
+
+/* Max QoS limits of core or io class, in requests and MiB per second */
+#define KCAS_QOS_IOPS_MAX 10000000
+#define KCAS_QOS_BANDWIDTH_MAX 1000000
+
 struct kcas_set_core_param {
 	uint32_t cache_id;
 	uint16_t core_id;
 	enum kcas_core_param_id param_id;
 	uint32_t param_value;
 
+	/**
+	 * io class of per io class params (core_param_read_ahead_lines,
+	 * core_param_qos_*, which apply to whole core for OCF_IO_CLASS_INVALID)
+	 */
+	uint32_t io_class_id;
+
 	int ext_err_code;
 };
 
@@ -335,9 +1336,55 @@ struct kcas_get_core_param {
 	enum kcas_core_param_id param_id;
 	uint32_t param_value;
 
+	/**
+	 * io class of per io class params (core_param_read_ahead_lines,
+	 * core_param_qos_*, which apply to whole core for OCF_IO_CLASS_INVALID)
+	 */
+	uint32_t io_class_id;
+
 	int ext_err_code;
 };
 
+/* Max time in microseconds queue thread busy polls for new work */
+#define CAS_QUEUE_POLL_TIME_MAX 1000
+
+/* Max rate of background discard of unused cache data area in MiB/s */
+#define KCAS_CACHE_TRIM_RATE_MAX 100000
+
+/* Max read latency of cache device relative to core starting bypass in % */
+#define KCAS_SLOW_BYPASS_THRESHOLD_MAX 10000
+
+/* Max time in microseconds metadata writes of cache are coalesced for */
+#define KCAS_META_COALESCE_WINDOW_MAX 100000
+
+/* Default clean space of cache needed to absorb sequential writes in % */
+#define KCAS_SEQ_ABSORB_HEADROOM_DEFAULT 20
+
+/* Max size of in-memory tier in front of cache in MiB */
+#define KCAS_DRAM_TIER_SIZE_MAX 65536
+
+/* State of member of mirrored cache device */
+enum kcas_mirror_member_state {
+	/** in sync, serves reads and writes */
+	KCAS_MIRROR_MEMBER_ACTIVE,
+
+	/** failed, neither read nor written until rebuilt */
+	KCAS_MIRROR_MEMBER_FAILED,
+
+	/** being resynchronized, written but not read */
+	KCAS_MIRROR_MEMBER_REBUILDING,
+};
+
+/* Max number of dedicated queues cleaning passes are spread over */
+#define CAS_CLEANER_WORKERS_MAX 16
+#define CAS_CLEANER_WORKERS_DEFAULT 1
+
+/**
+ * Value of cache_param_promotion_policy_type for frequency based admission
+ * done by CAS in front of OCF, which itself uses ocf_promotion_always then
+ */
+#define KCAS_PROMOTION_TINYLFU ocf_promotion_max
+
 enum kcas_cache_param_id {
 	cache_param_get_dirty_meta_chunk,
 	cache_param_get_dirty_data_chunk,
@@ -356,6 +1403,28 @@ enum kcas_cache_param_id {
 	cache_param_promotion_policy_type,
 	cache_param_promotion_nhit_insertion_threshold,
 	cache_param_promotion_nhit_trigger_threshold,
+	cache_param_queue_poll_time,
+	cache_param_cleaner_workers,
+	cache_param_promotion_nhit_adaptive,
+	cache_param_cleaner_rewrite_defer,
+	cache_param_io_class_adaptive_prio,
+	cache_param_cache_trim_rate,
+	cache_param_dram_tier_size,
+	cache_param_mirror_rebuild,
+	cache_param_get_mirror_member0_state,
+	cache_param_get_mirror_member1_state,
+	cache_param_get_mirror_rebuild_progress,
+	cache_param_compress_enabled,
+	cache_param_get_compress_ratio,
+	cache_param_get_compress_device_used,
+	cache_param_dedup_enabled,
+	cache_param_checksum_enabled,
+	cache_param_slow_bypass_threshold,
+	cache_param_get_slow_bypass_active,
+	cache_param_meta_coalesce_window,
+	cache_param_seq_absorb_free,
+	cache_param_seq_absorb_headroom,
+	cache_param_get_seq_absorb_active,
 	cache_param_id_max,
 };
 
@@ -364,6 +1433,12 @@ struct kcas_set_cache_param {
 	enum kcas_cache_param_id param_id;
 	uint32_t param_value;
 
+	/**
+	 * io class of per io class params (cache_param_compress_*, which
+	 * apply to whole cache for OCF_IO_CLASS_INVALID)
+	 */
+	uint32_t io_class_id;
+
 	int ext_err_code;
 };
 
@@ -372,6 +1447,12 @@ struct kcas_get_cache_param {
 	enum kcas_cache_param_id param_id;
 	uint32_t param_value;
 
+	/**
+	 * io class of per io class params (cache_param_compress_*, which
+	 * apply to whole cache for OCF_IO_CLASS_INVALID)
+	 */
+	uint32_t io_class_id;
+
 	int ext_err_code;
 };
 
@@ -434,6 +1515,24 @@ struct kcas_standby_activate
  *    41    *    KCAS_IOCTL_START_CACHE                     *    OK            *
  *    42    *    KCAS_IOCTL_DETACH_CACHE                    *    OK            *
  *    43    *    KCAS_IOCTL_ATTACH_CACHE                    *    OK            *
+ *    44    *    KCAS_IOCTL_IO_CLASS_STATS                  *    OK            *
+ *    45    *    KCAS_IOCTL_UPDATE_FS_META                  *    OK            *
+ *    46    *    KCAS_IOCTL_LOAD_PROGRESS                   *    OK            *
+ *    47    *    KCAS_IOCTL_GET_STATS_BULK                  *    OK            *
+ *    48    *    KCAS_IOCTL_GET_LAT_HIST                    *    OK            *
+ *    49    *    KCAS_IOCTL_GET_QUEUE_STATS                 *    OK            *
+ *    50    *    KCAS_IOCTL_GET_MEM_FOOTPRINT               *    OK            *
+ *    51    *    KCAS_IOCTL_GET_HEATMAP                     *    OK            *
+ *    52    *    KCAS_IOCTL_GET_MRC                         *    OK            *
+ *    53    *    KCAS_IOCTL_ASYNC_OP                        *    OK            *
+ *    54    *    KCAS_IOCTL_ASYNC_STATUS                    *    OK            *
+ *    55    *    KCAS_IOCTL_GET_HOT_SET                     *    OK            *
+ *    56    *    KCAS_IOCTL_PREFETCH                        *    OK            *
+ *    57    *    KCAS_IOCTL_BENCH                           *    OK            *
+ *    58    *    KCAS_IOCTL_IO_CLASS_BENCH                  *    OK            *
+ *    59    *    KCAS_IOCTL_ALLOC_BENCH                     *    OK            *
+ *    60    *    KCAS_IOCTL_GET_TRACE                       *    OK            *
+ *    61    *    KCAS_IOCTL_INSERT_CORES                    *    OK            *
  *******************************************************************************
  */
 
@@ -540,6 +1639,60 @@ struct kcas_standby_activate
 /** Attach cache device */
 #define KCAS_IOCTL_ATTACH_CACHE _IOWR(KCAS_IOCTL_MAGIC, 43, struct kcas_start_cache)
 
+/** Retrieve classification statistics of IO class */
+#define KCAS_IOCTL_IO_CLASS_STATS _IOWR(KCAS_IOCTL_MAGIC, 44, struct kcas_io_class_stats)
+
+/** Add or remove filesystem metadata extents of core object */
+#define KCAS_IOCTL_UPDATE_FS_META _IOWR(KCAS_IOCTL_MAGIC, 45, struct kcas_update_fs_meta)
+
+/** Retrieve progress of loading cache metadata */
+#define KCAS_IOCTL_LOAD_PROGRESS _IOWR(KCAS_IOCTL_MAGIC, 46, struct kcas_load_progress)
+
+/** Get stats of cache, its cores and ioclasses in single call */
+#define KCAS_IOCTL_GET_STATS_BULK _IOWR(KCAS_IOCTL_MAGIC, 47, struct kcas_get_stats_bulk)
+
+/** Get request latency histograms of cache/core */
+#define KCAS_IOCTL_GET_LAT_HIST _IOWR(KCAS_IOCTL_MAGIC, 48, struct kcas_get_lat_hist)
+
+/** Get statistics of cache I/O queues */
+#define KCAS_IOCTL_GET_QUEUE_STATS _IOWR(KCAS_IOCTL_MAGIC, 49, struct kcas_get_queue_stats)
+
+/** Get breakdown of memory used by cache */
+#define KCAS_IOCTL_GET_MEM_FOOTPRINT _IOWR(KCAS_IOCTL_MAGIC, 50, struct kcas_get_mem_footprint)
+
+/** Get LBA access heatmap of core */
+#define KCAS_IOCTL_GET_HEATMAP _IOWR(KCAS_IOCTL_MAGIC, 51, struct kcas_get_heatmap)
+
+/** Get reuse distance histogram estimating miss ratio curve of core */
+#define KCAS_IOCTL_GET_MRC _IOWR(KCAS_IOCTL_MAGIC, 52, struct kcas_get_mrc)
+
+/** Queue management operation to be run in background */
+#define KCAS_IOCTL_ASYNC_OP _IOWR(KCAS_IOCTL_MAGIC, 53, struct kcas_async_op)
+
+/** Get status of management operation run in background */
+#define KCAS_IOCTL_ASYNC_STATUS _IOWR(KCAS_IOCTL_MAGIC, 54, struct kcas_async_status)
+
+/** Get most accessed regions of core */
+#define KCAS_IOCTL_GET_HOT_SET _IOWR(KCAS_IOCTL_MAGIC, 55, struct kcas_get_hot_set)
+
+/** Read ranges of core into cache in background */
+#define KCAS_IOCTL_PREFETCH _IOWR(KCAS_IOCTL_MAGIC, 56, struct kcas_prefetch)
+
+/** Run in-kernel benchmark of exported object of core */
+#define KCAS_IOCTL_BENCH _IOWR(KCAS_IOCTL_MAGIC, 57, struct kcas_bench)
+
+/** Measure classification time of synthetic requests */
+#define KCAS_IOCTL_IO_CLASS_BENCH _IOWR(KCAS_IOCTL_MAGIC, 58, struct kcas_io_class_bench)
+
+/** Run benchmark of memory allocators of I/O path */
+#define KCAS_IOCTL_ALLOC_BENCH _IOWR(KCAS_IOCTL_MAGIC, 59, struct kcas_alloc_bench)
+
+/** Take requests of core captured in trace */
+#define KCAS_IOCTL_GET_TRACE _IOWR(KCAS_IOCTL_MAGIC, 60, struct kcas_get_trace)
+
+/** Add multiple core objects to an running cache instance */
+#define KCAS_IOCTL_INSERT_CORES _IOWR(KCAS_IOCTL_MAGIC, 61, struct kcas_insert_cores)
+
 /**
  * Extended kernel CAS error codes
  */
@@ -620,7 +1773,22 @@ enum kcas_error {
 	/** Inactive core has dirty data assigned */
 	KCAS_ERR_INACTIVE_CORE_IS_DIRTY,
 
-	KCAS_ERR_MAX = KCAS_ERR_INACTIVE_CORE_IS_DIRTY,
+	/** Purge of cache is already in progress */
+	KCAS_ERR_PURGE_IN_PROGRESS,
+
+	/** No async operation with given id */
+	KCAS_ERR_ASYNC_OP_NOT_EXIST,
+
+	/** Too many async operations not released by their callers */
+	KCAS_ERR_ASYNC_OPS_LIMIT,
+
+	/** IO class is reserved for requests bypassing cache */
+	KCAS_ERR_IO_CLASS_RESERVED,
+
+	/** Cache cannot be loaded from compressed cache device */
+	KCAS_ERR_COMPRESSED_LOAD,
+
+	KCAS_ERR_MAX = KCAS_ERR_COMPRESSED_LOAD,
 };
 
 #endif
@@ -294,6 +294,202 @@ def get_param_promotion_nhit(
     return output
 
 
+def set_param_mirror(cache_id: int, rebuild_member: int, shortcut: bool = False) -> Output:
+    output = TestRun.executor.run(
+        set_param_mirror_cmd(
+            cache_id=str(cache_id), rebuild_member=str(rebuild_member), shortcut=shortcut
+        )
+    )
+    if output.exit_code != 0:
+        raise CmdException("Error while starting rebuild of mirror member.", output)
+    return output
+
+
+def get_param_mirror(
+    cache_id: int, output_format: OutputFormat = None, shortcut: bool = False
+) -> Output:
+    _output_format = output_format.name if output_format else None
+    output = TestRun.executor.run(
+        get_param_mirror_cmd(
+            cache_id=str(cache_id), output_format=_output_format, shortcut=shortcut
+        )
+    )
+    if output.exit_code != 0:
+        raise CmdException("Getting mirror params failed.", output)
+    return output
+
+
+def set_param_dirty_throttle(
+    cache_id: int,
+    core_id: int = None,
+    limit: int = None,
+    max_pause: int = None,
+    shortcut: bool = False,
+) -> Output:
+    _core_id = str(core_id) if core_id is not None else None
+    _limit = str(limit) if limit is not None else None
+    _max_pause = str(max_pause) if max_pause is not None else None
+    output = TestRun.executor.run(
+        set_param_dirty_throttle_cmd(
+            cache_id=str(cache_id),
+            core_id=_core_id,
+            limit=_limit,
+            max_pause=_max_pause,
+            shortcut=shortcut,
+        )
+    )
+    if output.exit_code != 0:
+        raise CmdException("Error while setting dirty throttle params.", output)
+    return output
+
+
+def get_param_dirty_throttle(
+    cache_id: int, core_id: int, output_format: OutputFormat = None, shortcut: bool = False
+) -> Output:
+    _output_format = output_format.name if output_format else None
+    output = TestRun.executor.run(
+        get_param_dirty_throttle_cmd(
+            cache_id=str(cache_id),
+            core_id=str(core_id),
+            output_format=_output_format,
+            shortcut=shortcut,
+        )
+    )
+    if output.exit_code != 0:
+        raise CmdException("Getting dirty throttle params failed.", output)
+    return output
+
+
+def set_param_qos(
+    cache_id: int,
+    core_id: int = None,
+    io_class_id: int = None,
+    read_iops: int = None,
+    write_iops: int = None,
+    read_bandwidth: int = None,
+    write_bandwidth: int = None,
+    shortcut: bool = False,
+) -> Output:
+    def _str(value):
+        return str(value) if value is not None else None
+
+    output = TestRun.executor.run(
+        set_param_qos_cmd(
+            cache_id=str(cache_id),
+            core_id=_str(core_id),
+            io_class_id=_str(io_class_id),
+            read_iops=_str(read_iops),
+            write_iops=_str(write_iops),
+            read_bandwidth=_str(read_bandwidth),
+            write_bandwidth=_str(write_bandwidth),
+            shortcut=shortcut,
+        )
+    )
+    if output.exit_code != 0:
+        raise CmdException("Error while setting QoS limits.", output)
+    return output
+
+
+def get_param_qos(
+    cache_id: int,
+    core_id: int,
+    io_class_id: int = None,
+    output_format: OutputFormat = None,
+    shortcut: bool = False,
+) -> Output:
+    _output_format = output_format.name if output_format else None
+    _io_class_id = str(io_class_id) if io_class_id is not None else None
+    output = TestRun.executor.run(
+        get_param_qos_cmd(
+            cache_id=str(cache_id),
+            core_id=str(core_id),
+            io_class_id=_io_class_id,
+            output_format=_output_format,
+            shortcut=shortcut,
+        )
+    )
+    if output.exit_code != 0:
+        raise CmdException("Getting QoS limits failed.", output)
+    return output
+
+
+def set_param_dram_tier(cache_id: int, size: Size, shortcut: bool = False) -> Output:
+    output = TestRun.executor.run(
+        set_param_dram_tier_cmd(
+            cache_id=str(cache_id),
+            size=str(int(size.get_value(Unit.MebiByte))),
+            shortcut=shortcut,
+        )
+    )
+    if output.exit_code != 0:
+        raise CmdException("Error while setting in-memory tier size.", output)
+    return output
+
+
+def get_param_dram_tier(
+    cache_id: int, output_format: OutputFormat = None, shortcut: bool = False
+) -> Output:
+    _output_format = output_format.name if output_format else None
+    output = TestRun.executor.run(
+        get_param_dram_tier_cmd(
+            cache_id=str(cache_id), output_format=_output_format, shortcut=shortcut
+        )
+    )
+    if output.exit_code != 0:
+        raise CmdException("Getting in-memory tier params failed.", output)
+    return output
+
+
+def set_param_dedup(cache_id: int, enabled: bool, shortcut: bool = False) -> Output:
+    output = TestRun.executor.run(
+        set_param_dedup_cmd(
+            cache_id=str(cache_id), enabled="on" if enabled else "off", shortcut=shortcut
+        )
+    )
+    if output.exit_code != 0:
+        raise CmdException("Error while setting deduplication.", output)
+    return output
+
+
+def get_param_dedup(
+    cache_id: int, output_format: OutputFormat = None, shortcut: bool = False
+) -> Output:
+    _output_format = output_format.name if output_format else None
+    output = TestRun.executor.run(
+        get_param_dedup_cmd(
+            cache_id=str(cache_id), output_format=_output_format, shortcut=shortcut
+        )
+    )
+    if output.exit_code != 0:
+        raise CmdException("Getting deduplication params failed.", output)
+    return output
+
+
+def set_param_checksum(cache_id: int, enabled: bool, shortcut: bool = False) -> Output:
+    output = TestRun.executor.run(
+        set_param_checksum_cmd(
+            cache_id=str(cache_id), enabled="on" if enabled else "off", shortcut=shortcut
+        )
+    )
+    if output.exit_code != 0:
+        raise CmdException("Error while setting checksums.", output)
+    return output
+
+
+def get_param_checksum(
+    cache_id: int, output_format: OutputFormat = None, shortcut: bool = False
+) -> Output:
+    _output_format = output_format.name if output_format else None
+    output = TestRun.executor.run(
+        get_param_checksum_cmd(
+            cache_id=str(cache_id), output_format=_output_format, shortcut=shortcut
+        )
+    )
+    if output.exit_code != 0:
+        raise CmdException("Getting checksums params failed.", output)
+    return output
+
+
 def set_cache_mode(
     cache_mode: CacheMode, cache_id: int, flush: bool = None, shortcut: bool = False
 ) -> Output:
@@ -328,6 +524,19 @@ def add_core(cache: Cache, core_dev: Device, core_id: int = None, shortcut: bool
     return Core(core_dev.path, cache.cache_id)
 
 
+def add_cores(cache: Cache, core_devs: list, shortcut: bool = False) -> list:
+    output = TestRun.executor.run(
+        add_core_cmd(
+            cache_id=str(cache.cache_id),
+            core_dev=",".join(core_dev.path for core_dev in core_devs),
+            shortcut=shortcut,
+        )
+    )
+    if output.exit_code != 0:
+        raise CmdException("Failed to add cores.", output)
+    return [Core(core_dev.path, cache.cache_id) for core_dev in core_devs]
+
+
 def remove_core(cache_id: int, core_id: int, force: bool = False, shortcut: bool = False) -> Output:
     output = TestRun.executor.run(
         remove_core_cmd(
@@ -442,6 +651,15 @@ def load_io_classes(cache_id: int, file: str, shortcut: bool = False) -> Output:
     return output
 
 
+def compile_io_classes(file: str, image: str, shortcut: bool = False) -> Output:
+    output = TestRun.executor.run(
+        compile_io_classes_cmd(file=file, image=image, shortcut=shortcut)
+    )
+    if output.exit_code != 0:
+        raise CmdException("Compile IO class command failed.", output)
+    return output
+
+
 def list_io_classes(cache_id: int, output_format: OutputFormat, shortcut: bool = False) -> Output:
     _output_format = output_format.name if output_format else None
     output = TestRun.executor.run(
@@ -452,6 +670,25 @@ def list_io_classes(cache_id: int, output_format: OutputFormat, shortcut: bool =
     return output
 
 
+def print_io_class_stats(
+    cache_id: int, output_format: OutputFormat, shortcut: bool = False
+) -> Output:
+    _output_format = output_format.name if output_format else None
+    output = TestRun.executor.run(
+        io_class_stats_cmd(cache_id=str(cache_id), output_format=_output_format, shortcut=shortcut)
+    )
+    if output.exit_code != 0:
+        raise CmdException("IO class statistics command failed.", output)
+    return output
+
+
+def export_metrics(file: str = None, shortcut: bool = False) -> Output:
+    output = TestRun.executor.run(export_metrics_cmd(file=file, shortcut=shortcut))
+    if output.exit_code != 0:
+        raise CmdException("Exporting metrics failed.", output)
+    return output
+
+
 def print_version(output_format: OutputFormat = None, shortcut: bool = False) -> Output:
     _output_format = output_format.name if output_format else None
     output = TestRun.executor.run(version_cmd(output_format=_output_format, shortcut=shortcut))
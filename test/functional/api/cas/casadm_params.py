@@ -31,6 +31,7 @@ class StatsFilter(Enum):
     req = "request"
     blk = "block"
     err = "error"
+    internal = "internal"
 
     def __str__(self):
         return self.value
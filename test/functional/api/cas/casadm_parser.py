@@ -188,6 +188,100 @@ def get_seq_cut_off_parameters(cache_id: int, core_id: int):
     return seq_cut_off_params
 
 
+def get_dirty_throttle_parameters(cache_id: int, core_id: int) -> tuple:
+    """Returns dirty data limit in percent and max write pause in ms of core."""
+    casadm_output = casadm.get_param_dirty_throttle(
+        cache_id, core_id, casadm.OutputFormat.csv
+    ).stdout.splitlines()
+    limit = max_pause = None
+    for line in casadm_output:
+        if "Dirty data limit" in line:
+            limit = int(line.split(",")[1])
+        if "Max write pause" in line:
+            max_pause = int(line.split(",")[1])
+    return limit, max_pause
+
+
+def get_qos_parameters(cache_id: int, core_id: int, io_class_id: int = None) -> dict:
+    """
+    Returns dictionary of QoS limits and throttled time of core, or of its IO class,
+    with parameter names as keys.
+    """
+    casadm_output = casadm.get_param_qos(
+        cache_id, core_id, io_class_id, casadm.OutputFormat.csv
+    ).stdout.splitlines()
+    params = {}
+    for line in casadm_output:
+        name, _, value = line.partition(",")
+        value = value.split(" ")[0]
+        if value.isdigit():
+            params[name] = int(value)
+    return params
+
+
+def get_dram_tier_size(cache_id: int) -> Size:
+    casadm_output = casadm.get_param_dram_tier(cache_id, casadm.OutputFormat.csv)
+    for line in casadm_output.stdout.splitlines():
+        if line.startswith("Size [MiB]"):
+            return Size(int(line.split(",")[1].split(" ")[0]), Unit.MebiByte)
+    raise CmdException("There is no in-memory tier size in casadm output.", casadm_output)
+
+
+def get_dedup_enabled(cache_id: int) -> bool:
+    casadm_output = casadm.get_param_dedup(cache_id, casadm.OutputFormat.csv)
+    for line in casadm_output.stdout.splitlines():
+        if line.startswith("Deduplication,"):
+            return line.split(",")[1].strip() == "on"
+    raise CmdException("There is no deduplication state in casadm output.", casadm_output)
+
+
+def get_checksum_enabled(cache_id: int) -> bool:
+    casadm_output = casadm.get_param_checksum(cache_id, casadm.OutputFormat.csv)
+    for line in casadm_output.stdout.splitlines():
+        if line.startswith("Checksums,"):
+            return line.split(",")[1].strip() == "on"
+    raise CmdException("There is no checksums state in casadm output.", casadm_output)
+
+
+def get_mirror_member_states(cache_id: int) -> list:
+    casadm_output = casadm.get_param_mirror(
+        cache_id, casadm.OutputFormat.csv
+    ).stdout.splitlines()
+    states = {}
+    for line in casadm_output:
+        name, _, value = line.partition(",")
+        if name.startswith("Member ") and name.endswith(" state"):
+            states[int(name.split()[1])] = value.split(",")[0]
+    return [states[member] for member in sorted(states)]
+
+
+def get_io_class_rule_stats(cache_id: int) -> dict:
+    """
+    Returns dictionary of pairs of evaluations and matches of classification rules
+    with ids of their IO classes as keys.
+    """
+    casadm_output = casadm.print_io_class_stats(cache_id, OutputFormat.csv).stdout.splitlines()
+    stats = {}
+    for row in list(csv.reader(casadm_output))[1:]:
+        # Classification time histogram follows rules in separate table
+        if not row or not row[0].isdigit():
+            break
+        stats[int(row[0])] = (int(row[2]), int(row[3]))
+    return stats
+
+
+def get_internal_stats(cache_id: int) -> dict:
+    """
+    Returns dictionary of internal counters of cache with their titles, without
+    unit, as keys.
+    """
+    casadm_output = casadm.print_statistics(
+        cache_id, filter=[StatsFilter.internal], output_format=OutputFormat.csv
+    ).stdout.splitlines()
+    keys, values = csv.reader(casadm_output)
+    return {key.rsplit(" [", 1)[0]: int(value) for key, value in zip(keys, values)}
+
+
 def get_casadm_version():
     casadm_output = casadm.print_version(OutputFormat.csv).stdout.split("\n")
     version_str = casadm_output[1].split(",")[-1]
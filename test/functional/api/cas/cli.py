@@ -235,6 +235,145 @@ def get_param_cleaning_acp_cmd(
     return casadm_bin + command
 
 
+def set_param_mirror_cmd(cache_id: str, rebuild_member: str, shortcut: bool = False) -> str:
+    name = "mirror"
+    command = _set_param_cmd(name=name, cache_id=cache_id, shortcut=shortcut)
+    command += (" -r " if shortcut else " --rebuild-member ") + rebuild_member
+    return casadm_bin + command
+
+
+def get_param_mirror_cmd(cache_id: str, output_format: str = None, shortcut: bool = False) -> str:
+    name = "mirror"
+    command = _get_param_cmd(
+        name=name, cache_id=cache_id, output_format=output_format, shortcut=shortcut
+    )
+    return casadm_bin + command
+
+
+def set_param_dirty_throttle_cmd(
+    cache_id: str,
+    core_id: str = None,
+    limit: str = None,
+    max_pause: str = None,
+    shortcut: bool = False,
+) -> str:
+    name = "dirty-throttle"
+    command = _set_param_cmd(name=name, cache_id=cache_id, shortcut=shortcut)
+    if core_id:
+        command += (" -j " if shortcut else " --core-id ") + core_id
+    if limit:
+        command += (" -l " if shortcut else " --limit ") + limit
+    if max_pause:
+        command += (" -p " if shortcut else " --max-pause ") + max_pause
+    return casadm_bin + command
+
+
+def get_param_dirty_throttle_cmd(
+    cache_id: str, core_id: str, output_format: str = None, shortcut: bool = False
+) -> str:
+    name = "dirty-throttle"
+    command = _get_param_cmd(
+        name=name, cache_id=cache_id, output_format=output_format, shortcut=shortcut
+    )
+    command += (" -j " if shortcut else " --core-id ") + core_id
+    return casadm_bin + command
+
+
+def set_param_qos_cmd(
+    cache_id: str,
+    core_id: str = None,
+    io_class_id: str = None,
+    read_iops: str = None,
+    write_iops: str = None,
+    read_bandwidth: str = None,
+    write_bandwidth: str = None,
+    shortcut: bool = False,
+) -> str:
+    name = "qos"
+    command = _set_param_cmd(name=name, cache_id=cache_id, shortcut=shortcut)
+    if core_id:
+        command += (" -j " if shortcut else " --core-id ") + core_id
+    if io_class_id:
+        command += (" -d " if shortcut else " --io-class-id ") + io_class_id
+    if read_iops:
+        command += (" -r " if shortcut else " --read-iops ") + read_iops
+    if write_iops:
+        command += (" -w " if shortcut else " --write-iops ") + write_iops
+    if read_bandwidth:
+        command += (" -R " if shortcut else " --read-bandwidth ") + read_bandwidth
+    if write_bandwidth:
+        command += (" -W " if shortcut else " --write-bandwidth ") + write_bandwidth
+    return casadm_bin + command
+
+
+def get_param_qos_cmd(
+    cache_id: str,
+    core_id: str,
+    io_class_id: str = None,
+    output_format: str = None,
+    shortcut: bool = False,
+) -> str:
+    name = "qos"
+    command = _get_param_cmd(
+        name=name, cache_id=cache_id, output_format=output_format, shortcut=shortcut
+    )
+    command += (" -j " if shortcut else " --core-id ") + core_id
+    if io_class_id:
+        command += (" -d " if shortcut else " --io-class-id ") + io_class_id
+    return casadm_bin + command
+
+
+def set_param_dram_tier_cmd(cache_id: str, size: str, shortcut: bool = False) -> str:
+    name = "dram-tier"
+    command = _set_param_cmd(name=name, cache_id=cache_id, shortcut=shortcut)
+    command += (" -s " if shortcut else " --size ") + size
+    return casadm_bin + command
+
+
+def get_param_dram_tier_cmd(
+    cache_id: str, output_format: str = None, shortcut: bool = False
+) -> str:
+    name = "dram-tier"
+    command = _get_param_cmd(
+        name=name, cache_id=cache_id, output_format=output_format, shortcut=shortcut
+    )
+    return casadm_bin + command
+
+
+def set_param_dedup_cmd(cache_id: str, enabled: str, shortcut: bool = False) -> str:
+    name = "dedup"
+    command = _set_param_cmd(name=name, cache_id=cache_id, shortcut=shortcut)
+    command += (" -e " if shortcut else " --enabled ") + enabled
+    return casadm_bin + command
+
+
+def get_param_dedup_cmd(
+    cache_id: str, output_format: str = None, shortcut: bool = False
+) -> str:
+    name = "dedup"
+    command = _get_param_cmd(
+        name=name, cache_id=cache_id, output_format=output_format, shortcut=shortcut
+    )
+    return casadm_bin + command
+
+
+def set_param_checksum_cmd(cache_id: str, enabled: str, shortcut: bool = False) -> str:
+    name = "checksum"
+    command = _set_param_cmd(name=name, cache_id=cache_id, shortcut=shortcut)
+    command += (" -e " if shortcut else " --enabled ") + enabled
+    return casadm_bin + command
+
+
+def get_param_checksum_cmd(
+    cache_id: str, output_format: str = None, shortcut: bool = False
+) -> str:
+    name = "checksum"
+    command = _get_param_cmd(
+        name=name, cache_id=cache_id, output_format=output_format, shortcut=shortcut
+    )
+    return casadm_bin + command
+
+
 def set_cache_mode_cmd(
     cache_mode: str, cache_id: str, flush_cache: str = None, shortcut: bool = False
 ) -> str:
@@ -345,6 +484,13 @@ def load_io_classes_cmd(cache_id: str, file: str, shortcut: bool = False) -> str
     return casadm_bin + command
 
 
+def compile_io_classes_cmd(file: str, image: str, shortcut: bool = False) -> str:
+    command = " -C -K" if shortcut else " --io-class --compile"
+    command += (" -f " if shortcut else " --file ") + file
+    command += (" -I " if shortcut else " --image ") + image
+    return casadm_bin + command
+
+
 def list_io_classes_cmd(cache_id: str, output_format: str, shortcut: bool = False) -> str:
     command = " -C -L" if shortcut else " --io-class --list"
     command += (" -i " if shortcut else " --cache-id ") + cache_id
@@ -352,6 +498,20 @@ def list_io_classes_cmd(cache_id: str, output_format: str, shortcut: bool = Fals
     return casadm_bin + command
 
 
+def io_class_stats_cmd(cache_id: str, output_format: str, shortcut: bool = False) -> str:
+    command = " -C -S" if shortcut else " --io-class --stats"
+    command += (" -i " if shortcut else " --cache-id ") + cache_id
+    command += (" -o " if shortcut else " --output-format ") + output_format
+    return casadm_bin + command
+
+
+def export_metrics_cmd(file: str = None, shortcut: bool = False) -> str:
+    command = " --export-metrics"
+    if file:
+        command += (" -f " if shortcut else " --file ") + file
+    return casadm_bin + command
+
+
 def version_cmd(output_format: str = None, shortcut: bool = False) -> str:
     command = " -V" if shortcut else " --version"
     if output_format:
@@ -42,7 +42,8 @@ start_cache_help = [
     r"-i  --cache-id \<ID\>                 Identifier of cache instance \<1-16384\> "
     r"\(if not provided, the first available number will be used\)",
     r"-l  --load                          Load cache metadata from caching device "
-    r"\(DANGEROUS - see manual or Admin Guide for details\)",
+    r"\(DANGEROUS - see manual or Admin Guide for details\)\. "
+    r"Not valid for compressed cache device",
     r"-f  --force                         Force the creation of cache instance",
     r"-c  --cache-mode \<NAME\>             Set cache mode from available: \{wt|wb|wa|pt|wo\} "
     r"Write-Through, Write-Back, Write-Around, Pass-Through, Write-Only; "
@@ -204,6 +204,55 @@ def test_cli_add_remove_custom_id(shortcut):
         cli_messages.check_stdout_msg(output, cli_messages.no_caches_running)
 
 
+@pytest.mark.require_disk("cache", DiskTypeSet([DiskType.nand, DiskType.optane]))
+@pytest.mark.require_disk("core", DiskTypeLowerThan("cache"))
+@pytest.mark.parametrize("shortcut", [True, False])
+def test_cli_add_multiple_cores(shortcut):
+    """
+        title: Test for adding multiple cores in single command - short and long command
+        description: |
+          Start a new cache and add several cores to it with single command, passing
+          comma separated list of core devices, and then remove these cores from the cache.
+        pass_criteria:
+          - All cores are added to the cache with default IDs
+          - The cores are successfully removed from the cache
+    """
+    cores_count = 4
+
+    with TestRun.step("Prepare the devices."):
+        cache_disk = TestRun.disks['cache']
+        cache_disk.create_partitions([Size(50, Unit.MebiByte)])
+        cache_device = cache_disk.partitions[0]
+        core_disk = TestRun.disks['core']
+        core_disk.create_partitions([Size(100, Unit.MebiByte)] * cores_count)
+        core_devices = core_disk.partitions
+
+    with TestRun.step("Start the cache and add the cores."):
+        cache = casadm.start_cache(cache_device, shortcut=shortcut, force=True)
+        cores = casadm.add_cores(cache, core_devices, shortcut=shortcut)
+
+    with TestRun.step("Check if the cores are added to the cache."):
+        caches = casadm_parser.get_caches()
+        core_paths = sorted(core.path for core in caches[0].get_core_devices())
+        if core_paths != sorted(core.path for core in cores):
+            TestRun.fail(f"Cores present in the cache: {core_paths}, "
+                         f"should be: {[core.path for core in cores]}.")
+
+    with TestRun.step("Remove the cores from the cache."):
+        for core in cores:
+            casadm.remove_core(cache.cache_id, core.core_id, shortcut=shortcut)
+
+    with TestRun.step("Check if the cores are successfully removed from still running cache."):
+        caches = casadm_parser.get_caches()
+        if len(caches) != 1:
+            TestRun.fail("One cache should be still present after removing the cores.")
+        if len(caches[0].get_core_devices()) != 0:
+            TestRun.fail("No core device should be present after removing the cores.")
+
+    with TestRun.step("Stop the cache."):
+        casadm.stop_cache(cache_id=cache.cache_id, shortcut=shortcut)
+
+
 @pytest.mark.require_disk("cache", DiskTypeSet([DiskType.optane, DiskType.nand]))
 @pytest.mark.parametrize("shortcut", [True, False])
 def test_cli_load_and_force(shortcut):
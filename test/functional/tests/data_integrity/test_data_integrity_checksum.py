@@ -0,0 +1,107 @@
+#
+# Copyright(c) 2024 Huawei Technologies
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+import pytest
+
+from api.cas import casadm
+from api.cas.cache_config import CacheMode, SeqCutOffPolicy
+from api.cas.casadm_parser import get_checksum_enabled, get_internal_stats
+from core.test_run import TestRun
+from storage_devices.disk import DiskType, DiskTypeSet, DiskTypeLowerThan
+from test_tools.dd import Dd
+from test_tools.fio.fio import Fio
+from test_tools.fio.fio_param import ReadWrite, IoEngine, VerifyMethod
+from test_utils.os_utils import Udev
+from test_utils.size import Size, Unit
+
+cache_size = Size(512, Unit.MebiByte)
+core_size = Size(1, Unit.GibiByte)
+# Cache lines fill whole data area at the end of cache device, metadata is at its start
+corrupted_offset = Size(384, Unit.MebiByte)
+corrupted_size = Size(64, Unit.MebiByte)
+
+
+@pytest.mark.require_disk("cache", DiskTypeSet([DiskType.optane, DiskType.nand]))
+@pytest.mark.require_disk("core", DiskTypeLowerThan("cache"))
+def test_data_integrity_checksum():
+    """
+    title: Detection of corrupted cache device data by checksums.
+    description: |
+        Enable checksums of cache in Write-Through mode, fill the cache with data,
+        overwrite part of cache device data area behind the cache, and check that
+        corrupted blocks are detected and that data read from exported object is
+        correct, as it is read from core instead.
+    pass_criteria:
+      - Checksums are reported as enabled
+      - No checksum mismatches are reported before cache device is corrupted
+      - Data read from exported object after cache device is corrupted is correct
+      - Checksum mismatches are reported after cache device is corrupted
+    """
+    with TestRun.step("Prepare cache and core devices."):
+        cache_device = TestRun.disks["cache"]
+        core_device = TestRun.disks["core"]
+
+        cache_device.create_partitions([cache_size])
+        core_device.create_partitions([core_size])
+
+        cache_device = cache_device.partitions[0]
+        core_device = core_device.partitions[0]
+
+    with TestRun.step("Disable udev."):
+        Udev.disable()
+
+    with TestRun.step("Start cache in Write-Through mode and add core."):
+        cache = casadm.start_cache(cache_device, cache_mode=CacheMode.WT, force=True)
+        cache.set_seq_cutoff_policy(SeqCutOffPolicy.never)
+        core = cache.add_core(core_device)
+
+    with TestRun.step("Enable checksums and check that they are reported as enabled."):
+        casadm.set_param_checksum(cache.cache_id, True)
+        if not get_checksum_enabled(cache.cache_id):
+            TestRun.fail("Checksums are reported as disabled.")
+
+    fio = (
+        Fio()
+        .create_command()
+        .io_engine(IoEngine.libaio)
+        .size(core_size)
+        .block_size(Size(64, Unit.KibiByte))
+        .target(core)
+        .read_write(ReadWrite.write)
+        .verify_pattern()
+        .verify(VerifyMethod.pattern)
+        .direct()
+    )
+
+    with TestRun.step("Fill the cache with data written to exported object."):
+        fio.run()
+
+    with TestRun.step("Verify data read from exported object and check mismatches."):
+        fio.read_write(ReadWrite.read).verify_only().run()
+        mismatches = get_internal_stats(cache.cache_id)["Checksum mismatches"]
+        if mismatches != 0:
+            TestRun.fail(f"{mismatches} checksum mismatches reported before cache device "
+                         f"was corrupted.")
+
+    with TestRun.step("Corrupt data area of cache device."):
+        Dd().input("/dev/urandom").output(cache_device.path) \
+            .block_size(Size(1, Unit.MebiByte)) \
+            .seek(int(corrupted_offset.get_value(Unit.MebiByte))) \
+            .count(int(corrupted_size.get_value(Unit.MebiByte))).oflag("direct").run()
+
+    with TestRun.step("Verify data read from exported object."):
+        fio.run()
+
+    with TestRun.step("Check that checksum mismatches are reported."):
+        mismatches = get_internal_stats(cache.cache_id)["Checksum mismatches"]
+        if mismatches == 0:
+            TestRun.LOGGER.error("No checksum mismatches reported after cache device "
+                                 "was corrupted.")
+        else:
+            TestRun.LOGGER.info(f"{mismatches} checksum mismatches reported.")
+
+    with TestRun.step("Stop cache and verify core device contents."):
+        cache.stop(no_data_flush=True)
+        fio.target(core_device).run()
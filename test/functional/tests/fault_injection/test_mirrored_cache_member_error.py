@@ -0,0 +1,146 @@
+#
+# Copyright(c) 2024 Huawei Technologies
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+from datetime import timedelta
+
+import pytest
+
+from api.cas import casadm
+from api.cas.cache import Cache
+from api.cas.cache_config import CacheMode, CleaningPolicy, SeqCutOffPolicy
+from api.cas.casadm_parser import get_mirror_member_states
+from api.cas.cli import start_cmd
+from core.test_run import TestRun
+from storage_devices.disk import DiskTypeSet, DiskType, DiskTypeLowerThan
+from test_tools.device_mapper import ErrorDevice, DmTable
+from test_tools.fio.fio import Fio
+from test_tools.fio.fio_param import ReadWrite, IoEngine, VerifyMethod
+from test_utils.os_utils import Udev, wait
+from test_utils.output import CmdException
+from test_utils.size import Size, Unit
+
+cache_id = 1
+member_size = Size(1, Unit.GibiByte)
+io_size = Size(256, Unit.MebiByte)
+rebuild_timeout = timedelta(minutes=10)
+
+
+@pytest.mark.require_disk("cache", DiskTypeSet([DiskType.optane, DiskType.nand]))
+@pytest.mark.require_disk("core", DiskTypeLowerThan("cache"))
+def test_mirrored_cache_member_error():
+    """
+    title: Mirrored cache device with failed member.
+    description: |
+        Fail one member of mirrored cache device while I/O is running, check that the
+        cache keeps serving I/O from the other one, that the failed member is not trusted
+        after the cache is loaded, and that it serves data again once rebuilt.
+    pass_criteria:
+      - No I/O error is reported when one member fails
+      - Member failing I/O is reported as failed, also after load of the cache
+      - Rebuilt member becomes active again
+      - Data read after the other member fails is correct
+    """
+    with TestRun.step("Prepare cache member error devices and core device."):
+        cache_disk = TestRun.disks["cache"]
+        cache_disk.create_partitions([member_size] * 2)
+        members = [
+            ErrorDevice(
+                f"mirror{i}",
+                part,
+                DmTable.error_table(offset=0, size=part.size).fill_gaps(part),
+            )
+            for i, part in enumerate(cache_disk.partitions)
+        ]
+        for member in members:
+            member.suspend_errors()
+
+        core_disk = TestRun.disks["core"]
+        core_disk.create_partitions([io_size * 2])
+        core_device = core_disk.partitions[0]
+        mirror_path = "+".join(member.path for member in members)
+
+    with TestRun.step("Disable udev."):
+        Udev.disable()
+
+    with TestRun.step("Start cache on mirrored cache device in Write-Back mode."):
+        start_mirrored_cache(mirror_path)
+        cache = Cache(members[0], cache_id=cache_id)
+        cache.set_cleaning_policy(CleaningPolicy.nop)
+        cache.set_seq_cutoff_policy(SeqCutOffPolicy.never)
+        core = cache.add_core(core_device)
+        check_member_states(["Active", "Active"])
+
+    fio = (
+        Fio()
+        .create_command()
+        .io_engine(IoEngine.libaio)
+        .size(io_size)
+        .block_size(Size(4, Unit.KibiByte))
+        .target(core)
+        .read_write(ReadWrite.randwrite)
+        .verify_pattern()
+        .verify(VerifyMethod.pattern)
+        .direct()
+    )
+
+    with TestRun.step("Write data to exported object."):
+        fio.run()
+
+    with TestRun.step("Fail member 1 and run I/O on exported object."):
+        members[1].resume_errors()
+        fio.read_write(ReadWrite.randrw).run()
+
+    with TestRun.step("Check that member 1 is failed."):
+        check_member_states(["Active", "Failed"])
+
+    with TestRun.step("Stop cache, restore member 1 device and load cache."):
+        cache.stop()
+        members[1].suspend_errors()
+        start_mirrored_cache(mirror_path, load=True)
+
+    with TestRun.step("Check that member 1 is still failed after load."):
+        check_member_states(["Active", "Failed"])
+
+    with TestRun.step("Rebuild member 1 and wait for it to become active."):
+        casadm.set_param_mirror(cache_id, rebuild_member=1)
+        if not wait(
+            lambda: get_mirror_member_states(cache_id) == ["Active", "Active"],
+            rebuild_timeout,
+            timedelta(seconds=5),
+        ):
+            TestRun.fail(f"Member 1 not rebuilt, member states: "
+                         f"{get_mirror_member_states(cache_id)}.")
+
+    with TestRun.step("Fail member 0 and verify data read from exported object."):
+        members[0].resume_errors()
+        fio.read_write(ReadWrite.randread).verify_only().run()
+
+    with TestRun.step("Check that member 0 is failed and member 1 is active."):
+        check_member_states(["Failed", "Active"])
+
+    with TestRun.step("Stop cache and verify core device contents."):
+        cache.stop()
+        members[0].suspend_errors()
+        fio.target(core_device).run()
+
+
+def start_mirrored_cache(mirror_path: str, load: bool = False):
+    output = TestRun.executor.run(
+        start_cmd(
+            cache_dev=mirror_path,
+            cache_mode=None if load else CacheMode.WB.name.lower(),
+            cache_id=None if load else str(cache_id),
+            force=not load,
+            load=load,
+        )
+    )
+    if output.exit_code != 0:
+        raise CmdException("Failed to start cache on mirrored cache device.", output)
+
+
+def check_member_states(expected: list):
+    states = get_mirror_member_states(cache_id)
+    if states != expected:
+        TestRun.fail(f"Member states are {states}, should be {expected}.")
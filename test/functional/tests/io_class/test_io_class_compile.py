@@ -0,0 +1,75 @@
+#
+# Copyright(c) 2024 Huawei Technologies
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+import pytest
+
+from api.cas import casadm, ioclass_config
+from api.cas.ioclass_config import IoClass
+from core.test_run_utils import TestRun
+from storage_devices.disk import DiskTypeSet, DiskType, DiskTypeLowerThan
+from test_tools import fs_utils
+from test_utils.size import Size, Unit
+from tests.io_class.io_class_common import compare_io_classes_list
+
+image_path = "/tmp/opencas_ioclass.img"
+
+
+@pytest.mark.require_disk("cache", DiskTypeSet([DiskType.optane, DiskType.nand]))
+@pytest.mark.require_disk("core", DiskTypeLowerThan("cache"))
+@pytest.mark.parametrize("shortcut", [True, False])
+def test_io_class_compile(shortcut):
+    """
+    title: Load IO class configuration compiled into binary image.
+    description: |
+        Check that IO class configuration compiled with --compile and loaded from
+        the image is the same as configuration loaded from CSV file it was compiled from.
+    pass_criteria:
+        - Configuration file is compiled successfully
+        - IO class configuration loaded from image is the same as in CSV file
+        - IO class configuration loaded from CSV file and from image is the same
+    """
+    with TestRun.step("Prepare devices."):
+        cache_device = TestRun.disks["cache"]
+        core_device = TestRun.disks["core"]
+
+        cache_device.create_partitions([Size(150, Unit.MebiByte)])
+        core_device.create_partitions([Size(300, Unit.MebiByte)])
+
+        cache_device = cache_device.partitions[0]
+        core_device = core_device.partitions[0]
+
+    with TestRun.step("Start cache and add core device."):
+        cache = casadm.start_cache(cache_device, force=True)
+        cache.add_core(core_device)
+
+    with TestRun.step(
+        "Create configuration file for 33 IO classes with random names, "
+        "allocation and priority values."
+    ):
+        generated_io_classes = IoClass.generate_random_ioclass_list(
+            ioclass_config.MAX_IO_CLASS_ID + 1
+        )
+        IoClass.save_list_to_config_file(generated_io_classes, add_default_rule=False)
+
+    with TestRun.step("Compile configuration file into image."):
+        casadm.compile_io_classes(
+            ioclass_config.default_config_file_path, image_path, shortcut=shortcut
+        )
+
+    with TestRun.step("Load image and check IO class configuration - shall be the same as CSV."):
+        casadm.load_io_classes(cache.cache_id, image_path, shortcut=shortcut)
+        from_image = cache.list_io_classes()
+        compare_io_classes_list(generated_io_classes, from_image)
+
+    with TestRun.step("Load CSV file and check IO class configuration - shall be the same."):
+        casadm.load_io_classes(
+            cache.cache_id, ioclass_config.default_config_file_path, shortcut=shortcut
+        )
+        from_csv = cache.list_io_classes()
+        compare_io_classes_list(from_image, from_csv)
+
+    with TestRun.step("Stop cache and remove image."):
+        cache.stop()
+        fs_utils.remove(image_path, force=True)
@@ -0,0 +1,128 @@
+#
+# Copyright(c) 2024 Huawei Technologies
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+from datetime import datetime, timedelta
+
+import pytest
+
+from api.cas import casadm, ioclass_config
+from api.cas.cache_config import CacheMode, CleaningPolicy, SeqCutOffPolicy
+from api.cas.casadm_parser import get_qos_parameters
+from core.test_run import TestRun
+from storage_devices.disk import DiskType, DiskTypeSet, DiskTypeLowerThan
+from test_tools.dd import Dd
+from test_utils.os_utils import Udev
+from test_utils.size import Size, Unit
+
+iops_limit = 200
+dd_bs = Size(4, Unit.KibiByte)
+dd_count = 600
+io_class_id = 1
+# Buckets start with up to 100 ms of credit
+min_io_time = timedelta(seconds=(dd_count - iops_limit / 10) / iops_limit)
+
+
+@pytest.mark.require_disk("cache", DiskTypeSet([DiskType.optane, DiskType.nand]))
+@pytest.mark.require_disk("core", DiskTypeLowerThan("cache"))
+def test_qos_iops_limits():
+    """
+    title: IOPS limits of core and of IO class.
+    description: |
+        Set write IOPS limit of core and read IOPS limit of IO class of the core,
+        run I/O it applies to and I/O it doesn't apply to, and check that only I/O
+        under limit is delayed to its rate and that time it was throttled for is
+        reported by get-param for the core and for the IO class respectively.
+    pass_criteria:
+      - Limits are reported as set
+      - Writes to core with write IOPS limit are delayed to the limit
+      - Reads of IO class with read IOPS limit are delayed to the limit
+      - Throttled time is reported only where limit applied
+    """
+    with TestRun.step("Prepare cache and core devices."):
+        cache_device = TestRun.disks["cache"]
+        core_device = TestRun.disks["core"]
+
+        cache_device.create_partitions([Size(500, Unit.MebiByte)])
+        core_device.create_partitions([Size(1, Unit.GibiByte)])
+
+        cache_device = cache_device.partitions[0]
+        core_device = core_device.partitions[0]
+
+    with TestRun.step("Disable udev."):
+        Udev.disable()
+
+    with TestRun.step("Start cache in Write-Back mode and add core."):
+        cache = casadm.start_cache(cache_device, cache_mode=CacheMode.WB, force=True)
+        cache.set_cleaning_policy(CleaningPolicy.nop)
+        cache.set_seq_cutoff_policy(SeqCutOffPolicy.never)
+        core = cache.add_core(core_device)
+
+    with TestRun.step("Load IO class of small requests."):
+        ioclass_config.create_ioclass_config(add_default_rule=True)
+        ioclass_config.add_ioclass(
+            ioclass_id=io_class_id,
+            eviction_priority=22,
+            allocation="1.00",
+            rule=f"request_size:le:{int(dd_bs.get_value(Unit.Byte))}&done",
+        )
+        casadm.load_io_classes(cache.cache_id, ioclass_config.default_config_file_path)
+
+    with TestRun.step("Set write IOPS limit of core and check reported limits."):
+        casadm.set_param_qos(cache.cache_id, core.core_id, write_iops=iops_limit)
+        check_param(cache, core, None, "Write IOPS limit", iops_limit)
+        check_param(cache, core, None, "Read IOPS limit", 0)
+
+    with TestRun.step("Write to exported object and check that writes are delayed."):
+        io_time = timed_io(core, write=True)
+        if io_time < min_io_time:
+            TestRun.LOGGER.error(f"Writes took {io_time}, should take at least "
+                                 f"{min_io_time} with {iops_limit} IOPS limit.")
+        params = get_qos_parameters(cache.cache_id, core.core_id)
+        if params["Writes throttled time [ms]"] == 0:
+            TestRun.LOGGER.error("No throttled time of writes reported for core.")
+
+    with TestRun.step("Remove limit of core and set read IOPS limit of IO class."):
+        casadm.set_param_qos(cache.cache_id, core.core_id, write_iops=0)
+        casadm.set_param_qos(cache.cache_id, core.core_id, io_class_id=io_class_id,
+                             read_iops=iops_limit)
+        check_param(cache, core, None, "Write IOPS limit", 0)
+        check_param(cache, core, io_class_id, "Read IOPS limit", iops_limit)
+
+    with TestRun.step("Write to exported object and check that writes are not delayed."):
+        io_time = timed_io(core, write=True)
+        if io_time >= min_io_time:
+            TestRun.LOGGER.error(f"Writes took {io_time} with limit removed.")
+
+    with TestRun.step("Read from exported object and check that reads are delayed."):
+        io_time = timed_io(core, write=False)
+        if io_time < min_io_time:
+            TestRun.LOGGER.error(f"Reads took {io_time}, should take at least "
+                                 f"{min_io_time} with {iops_limit} IOPS limit of IO class.")
+        params = get_qos_parameters(cache.cache_id, core.core_id, io_class_id)
+        if params["Reads throttled time [ms]"] == 0:
+            TestRun.LOGGER.error("No throttled time of reads reported for IO class.")
+        if params["Writes throttled time [ms]"] != 0:
+            TestRun.LOGGER.error("Throttled time of writes reported for IO class "
+                                 "with no write limit.")
+
+    with TestRun.step("Stop cache."):
+        cache.stop(no_data_flush=True)
+
+
+def check_param(cache, core, io_class_id, name: str, expected: int):
+    value = get_qos_parameters(cache.cache_id, core.core_id, io_class_id)[name]
+    if value != expected:
+        TestRun.LOGGER.error(f"{name} is {value}, should be {expected}.")
+
+
+def timed_io(core, write: bool):
+    dd = Dd().block_size(dd_bs).count(dd_count)
+    if write:
+        dd.input("/dev/zero").output(core.path).oflag("direct")
+    else:
+        dd.input(core.path).output("/dev/null").iflag("direct")
+    start = datetime.now()
+    dd.run()
+    return datetime.now() - start
@@ -0,0 +1,117 @@
+#
+# Copyright(c) 2024 Huawei Technologies
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+import pytest
+
+from api.cas import casadm, ioclass_config
+from api.cas.cache_config import CacheMode, CleaningPolicy, SeqCutOffPolicy
+from api.cas.casadm_parser import get_io_class_rule_stats
+from core.test_run import TestRun
+from storage_devices.disk import DiskType, DiskTypeSet, DiskTypeLowerThan
+from test_tools.dd import Dd
+from test_utils.os_utils import Udev
+from test_utils.size import Size, Unit
+
+small_io_class_id = 1
+large_io_class_id = 2
+small_bs = Size(4, Unit.KibiByte)
+large_bs = Size(64, Unit.KibiByte)
+dd_count = 256
+
+
+@pytest.mark.require_disk("cache", DiskTypeSet([DiskType.optane, DiskType.nand]))
+@pytest.mark.require_disk("core", DiskTypeLowerThan("cache"))
+def test_io_class_reload_keeps_unchanged_rules():
+    """
+    title: Reload of IO class configuration with one rule changed.
+    description: |
+        Load IO class configuration, run I/O matched by its rules and load it again
+        with rule of one IO class changed. Check that rule which did not change keeps
+        its classification statistics and rule which changed starts anew and
+        classifies requests according to its new conditions.
+    pass_criteria:
+      - Rules of both IO classes match requests of their size
+      - Statistics of unchanged rule are kept after reload
+      - Statistics of changed rule are reset after reload
+      - Changed rule matches requests according to its new conditions
+    """
+    with TestRun.step("Prepare cache and core devices."):
+        cache_device = TestRun.disks["cache"]
+        core_device = TestRun.disks["core"]
+
+        cache_device.create_partitions([Size(500, Unit.MebiByte)])
+        core_device.create_partitions([Size(1, Unit.GibiByte)])
+
+        cache_device = cache_device.partitions[0]
+        core_device = core_device.partitions[0]
+
+    with TestRun.step("Disable udev."):
+        Udev.disable()
+
+    with TestRun.step("Start cache in Write-Back mode and add core."):
+        cache = casadm.start_cache(cache_device, cache_mode=CacheMode.WB, force=True)
+        cache.set_cleaning_policy(CleaningPolicy.nop)
+        cache.set_seq_cutoff_policy(SeqCutOffPolicy.never)
+        core = cache.add_core(core_device)
+
+    with TestRun.step("Load IO classes for small and large requests."):
+        load_io_classes(cache, small_bs)
+
+    with TestRun.step("Run I/O with small and large requests."):
+        run_io(core)
+
+    with TestRun.step("Check that both rules matched requests."):
+        before = get_io_class_rule_stats(cache.cache_id)
+        for io_class_id in [small_io_class_id, large_io_class_id]:
+            matches = before[io_class_id][1]
+            if matches < dd_count:
+                TestRun.fail(f"Rule of IO class {io_class_id} matched {matches} requests, "
+                             f"should match at least {dd_count}.")
+
+    with TestRun.step("Load IO classes again with rule of large requests changed."):
+        load_io_classes(cache, small_bs * 2)
+
+    with TestRun.step("Check that only statistics of unchanged rule are kept."):
+        after = get_io_class_rule_stats(cache.cache_id)
+        if after[small_io_class_id] < before[small_io_class_id]:
+            TestRun.LOGGER.error(f"Statistics of unchanged rule are "
+                                 f"{after[small_io_class_id]}, should be at least "
+                                 f"{before[small_io_class_id]}.")
+        if after[large_io_class_id][1] >= dd_count:
+            TestRun.LOGGER.error(f"Changed rule matched {after[large_io_class_id][1]} "
+                                 f"requests right after reload, should start anew.")
+
+    with TestRun.step("Run I/O and check that changed rule matches large requests."):
+        run_io(core)
+        matches = get_io_class_rule_stats(cache.cache_id)[large_io_class_id][1]
+        if matches - after[large_io_class_id][1] < dd_count:
+            TestRun.LOGGER.error(f"Changed rule matched {matches} requests, should match "
+                                 f"at least {dd_count} after reload.")
+
+    with TestRun.step("Stop cache."):
+        cache.stop(no_data_flush=True)
+
+
+def load_io_classes(cache, large_threshold: Size):
+    ioclass_config.create_ioclass_config(add_default_rule=True)
+    ioclass_config.add_ioclass(
+        ioclass_id=small_io_class_id,
+        eviction_priority=22,
+        allocation="1.00",
+        rule=f"request_size:le:{int(small_bs.get_value(Unit.Byte))}&done",
+    )
+    ioclass_config.add_ioclass(
+        ioclass_id=large_io_class_id,
+        eviction_priority=22,
+        allocation="1.00",
+        rule=f"request_size:gt:{int(large_threshold.get_value(Unit.Byte))}&done",
+    )
+    casadm.load_io_classes(cache.cache_id, ioclass_config.default_config_file_path)
+
+
+def run_io(core):
+    for bs in [small_bs, large_bs]:
+        Dd().input("/dev/zero").output(core.path).block_size(bs) \
+            .count(dd_count).oflag("direct").run()
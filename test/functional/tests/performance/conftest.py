@@ -39,9 +39,19 @@ def perf_collector(request):
     with open(perf_log_path, "w") as dump_file:
         json.dump(container.to_serializable_dict(), dump_file, indent=4)
 
+    # One line per test, so that results of runs of different builds can be compared
+    results_path = request.config.getoption("--perf-results")
+    if results_path:
+        results = {"test_id": request.node.name, **container.to_serializable_dict()}
+        with open(results_path, "a") as results_file:
+            results_file.write(json.dumps(results) + "\n")
+
 
 def pytest_addoption(parser):
     parser.addoption("--build-type", choices=BuildTypes, default="other")
+    parser.addoption(
+        "--perf-results", default=None, help="JSON lines file which results are appended to"
+    )
 
 
 def pytest_configure(config):
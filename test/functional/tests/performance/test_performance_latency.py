@@ -0,0 +1,214 @@
+#
+# Copyright(c) 2024 Huawei Technologies
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+import pytest
+
+from datetime import timedelta
+from api.cas import casadm
+from api.cas.cache_config import (
+    CacheMode,
+    CacheLineSize,
+    SeqCutOffPolicy,
+    CleaningPolicy,
+)
+from core.test_run import TestRun
+from storage_devices.disk import DiskTypeSet, DiskTypeLowerThan, DiskType
+from test_tools.fio.fio import Fio
+from test_tools.fio.fio_param import IoEngine, ReadWrite, CpusAllowedPolicy
+from test_utils.os_utils import Udev, set_wbt_lat, get_dut_cpu_physical_cores
+from test_utils.output import CmdException
+from test_utils.size import Size, Unit
+from utils.performance import WorkloadParameter
+
+testing_range = Size(3, Unit.GiB)
+run_time = timedelta(seconds=60)
+
+# Tail latency of hits allowed on top of cache device one
+p99_ratio_threshold = 1.5
+p99_9_ratio_threshold = 2.0
+latency_overhead_threshold_us = 20
+
+
+@pytest.mark.os_dependent
+@pytest.mark.performance()
+@pytest.mark.require_disk("cache", DiskTypeSet([DiskType.optane, DiskType.nand]))
+@pytest.mark.require_disk("core", DiskTypeLowerThan("cache"))
+@pytest.mark.parametrize("queue_depth", [1, 16])
+def test_4k_hit_latency_percentiles_wt(queue_depth, perf_collector):
+    """
+    title: Test tail latency of CAS in 100% Cache Hit scenario
+    description: |
+      Measure p99 and p99.9 completion latency of 4KiB random read hits on cached volume and
+      compare them with the ones of cache device itself.
+    pass_criteria:
+      - p99 and p99.9 latency of hits within threshold of cache device ones
+    """
+    fio_cfg = (
+        Fio()
+        .create_command()
+        .io_engine(IoEngine.libaio)
+        .block_size(Size(4, Unit.KiB))
+        .read_write(ReadWrite.randread)
+        .io_depth(queue_depth)
+        .num_jobs(1)
+        .direct()
+        .size(testing_range)
+        .time_based()
+        .run_time(run_time)
+    )
+
+    with TestRun.step("Prepare cache and core devices"):
+        cache_device, core_device = prepare_devices()
+
+    with TestRun.step("Measure latency of cache device"):
+        disk_results = fio_cfg.target(cache_device).run()[0]
+
+    with TestRun.step("Configure cache and add core"):
+        cache, core = start_cache_wt(cache_device, core_device)
+
+    with TestRun.step("Prefill cache"):
+        prefill_cache(core)
+
+    with TestRun.step("Measure latency of hits on the exported object"):
+        cas_results = fio_cfg.target(core).run()[0]
+
+    perf_collector.insert_workload_param(1, WorkloadParameter.NUM_JOBS)
+    perf_collector.insert_workload_param(queue_depth, WorkloadParameter.QUEUE_DEPTH)
+    perf_collector.insert_cache_metrics_from_fio_job(disk_results)
+    perf_collector.insert_exp_obj_metrics_from_fio_job(cas_results)
+    perf_collector.insert_config_from_cache(cache)
+
+    with TestRun.step("Compare tail latency"):
+        for percentile, ratio in [(99.0, p99_ratio_threshold), (99.9, p99_9_ratio_threshold)]:
+            disk_latency = read_clat_percentile_us(disk_results, percentile)
+            cas_latency = read_clat_percentile_us(cas_results, percentile)
+            threshold = disk_latency * ratio + latency_overhead_threshold_us
+
+            TestRun.LOGGER.info(
+                f"p{percentile:g} read latency (us): disk {disk_latency}, CAS {cas_latency}"
+            )
+            if cas_latency > threshold:
+                TestRun.LOGGER.error(
+                    f"p{percentile:g} latency of hits {cas_latency} us exceeds threshold "
+                    f"{threshold} us"
+                )
+
+
+@pytest.mark.os_dependent
+@pytest.mark.performance()
+@pytest.mark.require_disk("cache", DiskTypeSet([DiskType.optane, DiskType.nand]))
+@pytest.mark.require_disk("core", DiskTypeLowerThan("cache"))
+@pytest.mark.parametrize("num_cpus", [1, 2, 4, 8, 16, 32, 64, 128])
+def test_4k_hit_iops_scaling_wt(num_cpus, perf_collector):
+    """
+    title: Test scaling of CAS IOPS with number of CPUs in 100% Cache Hit scenario
+    description: |
+      Run 4KiB random read hits on cached volume with one job per physical CPU core, for
+      growing number of cores. Results of all parameters form scaling curve.
+    pass_criteria:
+      - always passes
+    """
+    cores = get_dut_cpu_physical_cores()
+    if num_cpus > len(cores):
+        pytest.skip(f"Only {len(cores)} physical CPU cores available")
+
+    size_per_job = (testing_range / num_cpus).align_down(Unit.Blocks512.value)
+    fio_cfg = (
+        Fio()
+        .create_command()
+        .io_engine(IoEngine.libaio)
+        .block_size(Size(4, Unit.KiB))
+        .read_write(ReadWrite.randread)
+        .io_depth(32)
+        .cpus_allowed(cores[:num_cpus])
+        .cpus_allowed_policy(CpusAllowedPolicy.split)
+        .direct()
+        .time_based()
+        .run_time(run_time)
+    )
+    # spread jobs
+    for i in range(num_cpus):
+        fio_cfg.add_job(f"job_{i+1}").offset(size_per_job * i).size(size_per_job)
+
+    with TestRun.step("Prepare cache and core devices"):
+        cache_device, core_device = prepare_devices()
+
+    with TestRun.step("Configure cache and add core"):
+        cache, core = start_cache_wt(cache_device, core_device)
+
+    with TestRun.step("Prefill cache"):
+        prefill_cache(core)
+
+    with TestRun.step("Run workload on the exported object"):
+        cas_results = fio_cfg.target(core).run()[0]
+        TestRun.LOGGER.info(
+            f"{num_cpus} CPUs: {cas_results.read_iops()} IOPS, "
+            f"{cas_results.read_iops() / num_cpus} IOPS per CPU"
+        )
+
+    perf_collector.insert_workload_param(num_cpus, WorkloadParameter.NUM_JOBS)
+    perf_collector.insert_workload_param(num_cpus, WorkloadParameter.NUM_CPUS)
+    perf_collector.insert_workload_param(32, WorkloadParameter.QUEUE_DEPTH)
+    perf_collector.insert_exp_obj_metrics_from_fio_job(cas_results)
+    perf_collector.insert_config_from_cache(cache)
+
+
+def read_clat_percentile_us(fio_result, percentile):
+    # fio reports percentiles keyed with six decimal places, e.g. "99.900000"
+    return vars(fio_result.job.read.clat_ns.percentile)[f"{percentile:f}"] / 1000
+
+
+def prepare_devices():
+    cache_device = TestRun.disks["cache"]
+    cache_device.create_partitions([testing_range + Size(1, Unit.GiB)])
+
+    core_device = TestRun.disks["core"]
+    core_device.create_partitions([testing_range])
+
+    return cache_device.partitions[0], core_device.partitions[0]
+
+
+def start_cache_wt(cache_device, core_device):
+    cache = casadm.start_cache(
+        cache_device,
+        cache_mode=CacheMode.WT,
+        cache_line_size=CacheLineSize.LINE_4KiB,
+        force=True,
+    )
+    cache.set_seq_cutoff_policy(SeqCutOffPolicy.never)
+    cache.set_cleaning_policy(CleaningPolicy.nop)
+    core = cache.add_core(core_device)
+    Udev.disable()
+
+    return cache, core
+
+
+def prefill_cache(core):
+    (
+        Fio()
+        .create_command()
+        .io_engine(IoEngine.libaio)
+        .block_size(Size(4, Unit.KiB))
+        .read_write(ReadWrite.write)
+        .target(core)
+        .size(core.size)
+        .direct()
+        .run()
+    )
+
+
+@pytest.fixture(scope="session", autouse=True)
+def disable_wbt_throttling():
+    cache_device = TestRun.disks["cache"]
+    core_device = TestRun.disks["core"]
+
+    try:
+        set_wbt_lat(cache_device, 0)
+    except CmdException:
+        TestRun.LOGGER.warning("Couldn't disable write-back throttling for cache device")
+    try:
+        set_wbt_lat(core_device, 0)
+    except CmdException:
+        TestRun.LOGGER.warning("Couldn't disable write-back throttling for core device")
@@ -0,0 +1,265 @@
+#
+# Copyright(c) 2024 Huawei Technologies
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+import time
+import pytest
+
+from datetime import datetime, timedelta
+from api.cas import casadm
+from api.cas.cache_config import (
+    CacheMode,
+    CacheLineSize,
+    SeqCutOffPolicy,
+    CleaningPolicy,
+    FlushParametersAlru,
+    FlushParametersAcp,
+)
+from core.test_run import TestRun
+from storage_devices.disk import DiskTypeSet, DiskTypeLowerThan, DiskType
+from test_tools.fio.fio import Fio
+from test_tools.fio.fio_param import IoEngine, ReadWrite, CpusAllowedPolicy
+from test_utils.os_utils import Udev, set_wbt_lat, get_dut_cpu_physical_cores
+from test_utils.output import CmdException
+from test_utils.size import Size, Unit
+from test_utils.time import Time
+from utils.performance import MgmtMetric, WorkloadParameter
+
+dirty_data_size = Size(8, Unit.GiB)
+cleaning_timeout = timedelta(hours=1)
+
+
+@pytest.mark.os_dependent
+@pytest.mark.performance()
+@pytest.mark.require_disk("cache", DiskTypeSet([DiskType.optane, DiskType.nand]))
+@pytest.mark.require_disk("core", DiskTypeLowerThan("cache"))
+@pytest.mark.parametrize("block_size", [Size(4, Unit.KiB), Size(64, Unit.KiB)])
+def test_writeback_throughput(block_size, perf_collector):
+    """
+    title: Test throughput of writes in write-back mode
+    description: |
+      Measure throughput of random writes inserted into cache in Write-Back mode, with
+      cleaning disabled, so that all of them stay dirty.
+    pass_criteria:
+      - all written data is dirty
+    """
+    with TestRun.step("Prepare cache and core devices"):
+        cache, core = prepare_wb_cache(CleaningPolicy.nop)
+
+    with TestRun.step("Run random writes on the exported object"):
+        cas_results = (
+            Fio()
+            .create_command()
+            .io_engine(IoEngine.libaio)
+            .block_size(block_size)
+            .read_write(ReadWrite.randwrite)
+            .io_depth(16)
+            .num_jobs(len(get_dut_cpu_physical_cores()))
+            .cpus_allowed(get_dut_cpu_physical_cores())
+            .cpus_allowed_policy(CpusAllowedPolicy.split)
+            .direct()
+            .target(core)
+            .size(dirty_data_size)
+            .run()[0]
+        )
+
+    with TestRun.step("Check that written data is dirty"):
+        if cache.get_dirty_blocks() == Size.zero():
+            TestRun.LOGGER.error("No dirty data after writes in Write-Back mode")
+
+    perf_collector.insert_workload_param(block_size.get_value(), WorkloadParameter.BLOCK_SIZE)
+    perf_collector.insert_workload_param(16, WorkloadParameter.QUEUE_DEPTH)
+    perf_collector.insert_exp_obj_metrics_from_fio_job(cas_results)
+    perf_collector.insert_mgmt_metric(
+        cas_results.job.write.bw / Unit.KibiByte.get_value(), MgmtMetric.WRITEBACK_BW
+    )
+    perf_collector.insert_config_from_cache(cache)
+
+
+@pytest.mark.os_dependent
+@pytest.mark.performance()
+@pytest.mark.require_disk("cache", DiskTypeSet([DiskType.optane, DiskType.nand]))
+@pytest.mark.require_disk("core", DiskTypeLowerThan("cache"))
+def test_flush_rate(perf_collector):
+    """
+    title: Test rate of flushing dirty data of cache
+    description: |
+      Fill cache with dirty data and measure time of flushing it to core device.
+    pass_criteria:
+      - no dirty data remains after flush
+    """
+    with TestRun.step("Prepare cache and core devices"):
+        cache, core = prepare_wb_cache(CleaningPolicy.nop)
+
+    with TestRun.step("Fill cache with dirty data"):
+        dirty = make_dirty(cache, core)
+
+    with TestRun.step("Flush cache and measure its time"):
+        start_time = datetime.now()
+        cache.flush_cache()
+        elapsed = datetime.now() - start_time
+
+    with TestRun.step("Check that no dirty data remains"):
+        if cache.get_dirty_blocks() != Size.zero():
+            TestRun.LOGGER.error("Dirty data remained after flush")
+
+    rate = dirty.get_value(Unit.MebiByte) / elapsed.total_seconds()
+    TestRun.LOGGER.info(f"Flushed {dirty} in {elapsed}, {rate:.1f} MiB/s")
+
+    perf_collector.insert_mgmt_metric(rate, MgmtMetric.FLUSH_RATE)
+    perf_collector.insert_config_from_cache(cache)
+
+
+@pytest.mark.os_dependent
+@pytest.mark.performance()
+@pytest.mark.require_disk("cache", DiskTypeSet([DiskType.optane, DiskType.nand]))
+@pytest.mark.require_disk("core", DiskTypeLowerThan("cache"))
+@pytest.mark.parametrize("cleaning_policy", [CleaningPolicy.alru, CleaningPolicy.acp])
+def test_cleaner_drain_rate(cleaning_policy, perf_collector):
+    """
+    title: Test rate of cleaning dirty data of idle cache
+    description: |
+      Fill cache with dirty data with cleaning disabled, then enable cleaning policy configured
+      to clean as soon as possible and measure time until no dirty data remains.
+    pass_criteria:
+      - cleaner drains all dirty data within timeout
+    """
+    with TestRun.step("Prepare cache and core devices"):
+        cache, core = prepare_wb_cache(CleaningPolicy.nop)
+
+    with TestRun.step("Fill cache with dirty data"):
+        dirty = make_dirty(cache, core)
+
+    with TestRun.step(f"Enable {cleaning_policy} cleaning policy and wait for it to drain cache"):
+        start_time = datetime.now()
+        cache.set_cleaning_policy(cleaning_policy)
+        if cleaning_policy == CleaningPolicy.alru:
+            cache.set_params_alru(
+                FlushParametersAlru(
+                    activity_threshold=Time(milliseconds=0),
+                    wake_up_time=Time(seconds=0),
+                    staleness_time=Time(seconds=1),
+                    flush_max_buffers=10000,
+                )
+            )
+        else:
+            cache.set_params_acp(
+                FlushParametersAcp(wake_up_time=Time(milliseconds=0), flush_max_buffers=10000)
+            )
+
+        while cache.get_dirty_blocks() != Size.zero():
+            if datetime.now() - start_time > cleaning_timeout:
+                TestRun.fail(f"Cleaner didn't drain cache within {cleaning_timeout}")
+            time.sleep(1)
+        elapsed = datetime.now() - start_time
+
+    rate = dirty.get_value(Unit.MebiByte) / elapsed.total_seconds()
+    TestRun.LOGGER.info(f"Cleaned {dirty} in {elapsed}, {rate:.1f} MiB/s")
+
+    perf_collector.insert_mgmt_metric(rate, MgmtMetric.CLEANER_RATE)
+    perf_collector.insert_config_from_cache(cache)
+
+
+@pytest.mark.os_dependent
+@pytest.mark.performance()
+@pytest.mark.require_disk("cache", DiskTypeSet([DiskType.optane, DiskType.nand]))
+@pytest.mark.require_disk("core", DiskTypeLowerThan("cache"))
+@pytest.mark.parametrize("cache_size", [Size(4, Unit.GiB), Size(32, Unit.GiB), Size(256, Unit.GiB)])
+def test_cache_load_time(cache_size, perf_collector):
+    """
+    title: Test time of loading cache
+    description: |
+      Fill cache of given size with dirty data, stop it without flushing and measure time of
+      loading it back.
+    pass_criteria:
+      - loaded cache keeps all dirty data
+    """
+    cache_device = TestRun.disks["cache"]
+    core_device = TestRun.disks["core"]
+    if cache_device.size < cache_size or core_device.size < cache_size:
+        pytest.skip(f"Not enough space on devices for {cache_size} cache")
+
+    with TestRun.step("Prepare cache and core devices"):
+        cache, core = prepare_wb_cache(CleaningPolicy.nop, cache_size)
+        cache_device = cache.cache_device
+
+    with TestRun.step("Fill cache with dirty data"):
+        dirty = make_dirty(cache, core, cache_size)
+        perf_collector.insert_config_from_cache(cache)
+
+    with TestRun.step("Stop cache without flushing dirty data"):
+        cache.stop(no_data_flush=True)
+
+    with TestRun.step("Load cache and measure its time"):
+        start_time = datetime.now()
+        cache = casadm.load_cache(cache_device)
+        elapsed = datetime.now() - start_time
+        TestRun.LOGGER.info(f"Cache of {cache_size} loaded in {elapsed}")
+
+    with TestRun.step("Check that dirty data is preserved"):
+        if cache.get_dirty_blocks() != dirty:
+            TestRun.LOGGER.error(
+                f"Dirty data after load {cache.get_dirty_blocks()}, expected {dirty}"
+            )
+
+    perf_collector.insert_workload_param(
+        cache_size.get_value(), WorkloadParameter.CACHE_SIZE
+    )
+    perf_collector.insert_mgmt_metric(elapsed.total_seconds(), MgmtMetric.LOAD_TIME)
+
+
+def prepare_wb_cache(cleaning_policy, size=dirty_data_size):
+    cache_device = TestRun.disks["cache"]
+    cache_device.create_partitions([size + Size(1, Unit.GiB)])
+
+    core_device = TestRun.disks["core"]
+    core_device.create_partitions([size])
+
+    cache = casadm.start_cache(
+        cache_device.partitions[0],
+        cache_mode=CacheMode.WB,
+        cache_line_size=CacheLineSize.LINE_4KiB,
+        force=True,
+    )
+    cache.set_seq_cutoff_policy(SeqCutOffPolicy.never)
+    cache.set_cleaning_policy(cleaning_policy)
+    core = cache.add_core(core_device.partitions[0])
+    Udev.disable()
+
+    return cache, core
+
+
+def make_dirty(cache, core, size=dirty_data_size):
+    (
+        Fio()
+        .create_command()
+        .io_engine(IoEngine.libaio)
+        .block_size(Size(1, Unit.MiB))
+        .read_write(ReadWrite.write)
+        .io_depth(16)
+        .target(core)
+        .size(size)
+        .direct()
+        .run()
+    )
+
+    dirty = cache.get_dirty_blocks()
+    TestRun.LOGGER.info(f"Dirty data: {dirty}")
+
+    return dirty
+
+
+@pytest.fixture(scope="session", autouse=True)
+def disable_wbt_throttling():
+    cache_device = TestRun.disks["cache"]
+    core_device = TestRun.disks["core"]
+
+    try:
+        set_wbt_lat(cache_device, 0)
+    except CmdException:
+        TestRun.LOGGER.warning("Couldn't disable write-back throttling for cache device")
+    try:
+        set_wbt_lat(core_device, 0)
+    except CmdException:
+        TestRun.LOGGER.warning("Couldn't disable write-back throttling for core device")
@@ -0,0 +1,99 @@
+#
+# Copyright(c) 2024 Huawei Technologies
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+from datetime import datetime, timedelta
+
+import pytest
+
+from api.cas import casadm
+from api.cas.cache_config import CacheMode, CleaningPolicy, SeqCutOffPolicy
+from api.cas.casadm_parser import get_dirty_throttle_parameters
+from core.test_run import TestRun
+from storage_devices.disk import DiskType, DiskTypeSet, DiskTypeLowerThan
+from test_tools.dd import Dd
+from test_utils.os_utils import Udev
+from test_utils.size import Size, Unit
+
+dirty_limit = 20
+max_pause = 50
+dd_bs = Size(1, Unit.MebiByte)
+freerun_count = 64
+throttled_count = 256
+min_throttled_time = timedelta(seconds=3)
+
+
+@pytest.mark.require_disk("cache", DiskTypeSet([DiskType.optane, DiskType.nand]))
+@pytest.mark.require_disk("core", DiskTypeLowerThan("cache"))
+def test_dirty_throttle():
+    """
+    title: Throttling of writes by dirty data of core.
+    description: |
+        Set dirty data limit of core in Write-Back mode with cleaning disabled and
+        check that it is reported by get-param, that writes are not delayed until
+        dirty data of core reaches half of the limit, that they are delayed once
+        it approaches the limit, and that they are not delayed once the limit is
+        disabled again.
+    pass_criteria:
+      - Dirty data limit and max pause are reported as set
+      - Writes exceeding dirty data limit take at least time of their pauses
+      - Writes are not delayed with dirty data limit disabled
+    """
+    with TestRun.step("Prepare cache and core devices."):
+        cache_device = TestRun.disks["cache"]
+        core_device = TestRun.disks["core"]
+
+        cache_device.create_partitions([Size(1, Unit.GibiByte)])
+        core_device.create_partitions([Size(2, Unit.GibiByte)])
+
+        cache_device = cache_device.partitions[0]
+        core_device = core_device.partitions[0]
+
+    with TestRun.step("Disable udev."):
+        Udev.disable()
+
+    with TestRun.step("Start cache in Write-Back mode with NOP cleaning policy and add core."):
+        cache = casadm.start_cache(cache_device, cache_mode=CacheMode.WB, force=True)
+        cache.set_cleaning_policy(CleaningPolicy.nop)
+        cache.set_seq_cutoff_policy(SeqCutOffPolicy.never)
+        core = cache.add_core(core_device)
+
+    with TestRun.step("Set dirty data limit of core and check reported parameters."):
+        casadm.set_param_dirty_throttle(cache.cache_id, core.core_id, limit=dirty_limit,
+                                        max_pause=max_pause)
+        params = get_dirty_throttle_parameters(cache.cache_id, core.core_id)
+        if params != (dirty_limit, max_pause):
+            TestRun.fail(f"Dirty throttle parameters are {params}, "
+                         f"should be {(dirty_limit, max_pause)}.")
+
+    with TestRun.step("Write data below half of dirty data limit."):
+        freerun_time = timed_write(core, 0, freerun_count)
+
+    with TestRun.step("Write data exceeding dirty data limit and check it is delayed."):
+        throttled_time = timed_write(core, freerun_count, throttled_count)
+        dirty = core.get_statistics().usage_stats.dirty
+        TestRun.LOGGER.info(f"Writes took {freerun_time} below half of limit and "
+                            f"{throttled_time} above it, dirty data of core is {dirty}.")
+        if throttled_time < min_throttled_time:
+            TestRun.LOGGER.error(f"Writes exceeding dirty data limit took {throttled_time}, "
+                                 f"should take at least {min_throttled_time}.")
+
+    with TestRun.step("Disable dirty data limit and check that writes are not delayed."):
+        casadm.set_param_dirty_throttle(cache.cache_id, core.core_id, limit=0)
+        # Dirty data is over the limit, so writes would be paused if it was set
+        unthrottled_time = timed_write(core, freerun_count + throttled_count,
+                                       throttled_count)
+        if unthrottled_time * 2 > throttled_time:
+            TestRun.LOGGER.error(f"Writes with dirty data limit disabled took "
+                                 f"{unthrottled_time}, throttled ones {throttled_time}.")
+
+    with TestRun.step("Stop cache."):
+        cache.stop(no_data_flush=True)
+
+
+def timed_write(core, seek: int, count: int):
+    start = datetime.now()
+    Dd().input("/dev/zero").output(core.path).block_size(dd_bs) \
+        .seek(seek).count(count).oflag("direct").run()
+    return datetime.now() - start
@@ -0,0 +1,115 @@
+#
+# Copyright(c) 2024 Huawei Technologies
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+import pytest
+
+from api.cas import casadm
+from api.cas.cache_config import CacheMode
+from api.cas.casadm_parser import get_dram_tier_size, get_internal_stats
+from core.test_run import TestRun
+from storage_devices.disk import DiskType, DiskTypeSet, DiskTypeLowerThan
+from test_tools import fs_utils
+from test_tools.dd import Dd
+from test_utils.os_utils import Udev
+from test_utils.size import Size, Unit
+
+tier_size = Size(64, Unit.MebiByte)
+data_count = 16
+dd_bs = Size(4, Unit.KibiByte)
+test_file_path = "/tmp/opencas_dram_tier_data"
+
+
+@pytest.mark.require_disk("cache", DiskTypeSet([DiskType.optane, DiskType.nand]))
+@pytest.mark.require_disk("core", DiskTypeLowerThan("cache"))
+def test_dram_tier():
+    """
+    title: In-memory tier in front of cache.
+    description: |
+        Set size of in-memory tier of cache, read the same data repeatedly with page
+        aligned requests and check that reads are served from the tier, that data read
+        is correct also after it is overwritten and that the tier is released once its
+        size is set to 0.
+    pass_criteria:
+      - Size of in-memory tier is reported as set
+      - Repeated reads hit in-memory tier
+      - Data read is correct before and after it is overwritten
+      - In-memory tier uses no memory and reports no hits once disabled
+    """
+    with TestRun.step("Prepare cache and core devices."):
+        cache_device = TestRun.disks["cache"]
+        core_device = TestRun.disks["core"]
+
+        cache_device.create_partitions([Size(500, Unit.MebiByte)])
+        core_device.create_partitions([Size(1, Unit.GibiByte)])
+
+        cache_device = cache_device.partitions[0]
+        core_device = core_device.partitions[0]
+
+    with TestRun.step("Disable udev."):
+        Udev.disable()
+
+    with TestRun.step("Start cache in Write-Through mode and add core."):
+        cache = casadm.start_cache(cache_device, cache_mode=CacheMode.WT, force=True)
+        core = cache.add_core(core_device)
+
+    with TestRun.step("Set size of in-memory tier and check reported size."):
+        casadm.set_param_dram_tier(cache.cache_id, tier_size)
+        size = get_dram_tier_size(cache.cache_id)
+        if size != tier_size:
+            TestRun.fail(f"In-memory tier size is {size}, should be {tier_size}.")
+
+    with TestRun.step("Write data to exported object."):
+        expected_md5 = write_data(core)
+
+    with TestRun.step("Read data three times and check that it is correct."):
+        for _ in range(3):
+            check_md5(core, expected_md5)
+
+    with TestRun.step("Check that reads hit in-memory tier."):
+        stats = get_internal_stats(cache.cache_id)
+        TestRun.LOGGER.info(f"In-memory tier used {stats['In-memory tier used']} MiB, "
+                            f"read hits {stats['In-memory tier read hits']}, "
+                            f"read misses {stats['In-memory tier read misses']}.")
+        if stats["In-memory tier read hits"] == 0:
+            TestRun.LOGGER.error("No reads hit in-memory tier.")
+        if stats["In-memory tier used"] == 0:
+            TestRun.LOGGER.error("In-memory tier holds no data after repeated reads.")
+
+    with TestRun.step("Overwrite data and check that data read is correct."):
+        expected_md5 = write_data(core)
+        check_md5(core, expected_md5)
+
+    with TestRun.step("Disable in-memory tier and check its statistics."):
+        casadm.set_param_dram_tier(cache.cache_id, Size.zero())
+        stats = get_internal_stats(cache.cache_id)
+        if stats["In-memory tier used"] != 0 or stats["In-memory tier read hits"] != 0:
+            TestRun.LOGGER.error(f"Disabled in-memory tier uses "
+                                 f"{stats['In-memory tier used']} MiB and reports "
+                                 f"{stats['In-memory tier read hits']} read hits.")
+
+    with TestRun.step("Stop cache and remove file."):
+        cache.stop()
+        fs_utils.remove(test_file_path, force=True)
+
+
+def write_data(core):
+    Dd().input("/dev/urandom").output(test_file_path) \
+        .block_size(Size(1, Unit.MebiByte)).count(data_count).run()
+    Dd().input(test_file_path).output(core.path) \
+        .block_size(Size(1, Unit.MebiByte)).count(data_count).oflag("direct").run()
+    return TestRun.executor.run_expect_success(
+        f"md5sum {test_file_path}"
+    ).stdout.split()[0]
+
+
+def check_md5(core, expected: str):
+    count = int(Size(data_count, Unit.MebiByte).get_value(Unit.Byte)
+                / dd_bs.get_value(Unit.Byte))
+    actual = TestRun.executor.run_expect_success(
+        f"dd if={core.path} bs={int(dd_bs.get_value(Unit.Byte))} count={count} "
+        f"iflag=direct | md5sum"
+    ).stdout.split()[0]
+    if actual != expected:
+        TestRun.LOGGER.error(f"Md5 sum of data read is {actual}, should be {expected}.")
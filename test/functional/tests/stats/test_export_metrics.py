@@ -0,0 +1,156 @@
+#
+# Copyright(c) 2024 Huawei Technologies
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+import re
+
+import pytest
+
+from api.cas import casadm
+from api.cas.cache_config import CacheMode, CleaningPolicy
+from core.test_run import TestRun
+from storage_devices.disk import DiskType, DiskTypeSet, DiskTypeLowerThan
+from test_tools import fs_utils
+from test_tools.dd import Dd
+from test_utils.os_utils import Udev
+from test_utils.size import Size, Unit
+
+metrics_path = "/tmp/opencas_metrics.prom"
+dd_block_size = Size(1, Unit.Blocks4096)
+dd_count = 2560
+cores_no = 2
+
+sample_regex = re.compile(r"^(\w+)\{([^}]*)\} (\d+)$")
+
+
+@pytest.mark.require_disk("cache", DiskTypeSet([DiskType.optane, DiskType.nand]))
+@pytest.mark.require_disk("core", DiskTypeLowerThan("cache"))
+@pytest.mark.parametrize("to_file", [True, False])
+def test_export_metrics_consistency(to_file):
+    """
+    title: Consistency of exported metrics with statistics.
+    description: |
+        Run workload on cores of the cache and check that requests, bytes and usage
+        exported by --export-metrics match statistics printed by 'casadm -P' for the
+        cache and for each of its cores.
+    pass_criteria:
+      - Metrics are exported successfully
+      - Exported metrics match statistics of the cache and the cores
+    """
+    with TestRun.step("Prepare cache and core devices."):
+        cache_device = TestRun.disks["cache"]
+        core_device = TestRun.disks["core"]
+
+        cache_device.create_partitions([Size(500, Unit.MebiByte)])
+        core_device.create_partitions([Size(1, Unit.GibiByte)] * cores_no)
+
+        cache_device = cache_device.partitions[0]
+
+    with TestRun.step("Disable udev."):
+        Udev.disable()
+
+    with TestRun.step("Start cache in Write-Back mode and set NOP cleaning policy."):
+        cache = casadm.start_cache(cache_device, cache_mode=CacheMode.WB, force=True)
+        cache.set_cleaning_policy(CleaningPolicy.nop)
+
+    with TestRun.step("Add core devices and reset statistics."):
+        cores = [cache.add_core(part) for part in core_device.partitions]
+        cache.reset_counters()
+
+    with TestRun.step("Write to and read from exported objects."):
+        for i, core in enumerate(cores):
+            # Cores get different amount of data not to make their metrics alike
+            count = dd_count * (i + 1)
+            Dd().input("/dev/zero").output(core.path).block_size(dd_block_size) \
+                .count(count).oflag("direct").run()
+            Dd().input(core.path).output("/dev/null").block_size(dd_block_size) \
+                .count(count * 2).iflag("direct").run()
+
+    with TestRun.step("Export metrics."):
+        if to_file:
+            casadm.export_metrics(file=metrics_path)
+            metrics = parse_metrics(fs_utils.read_file(metrics_path))
+        else:
+            metrics = parse_metrics(casadm.export_metrics().stdout)
+
+    with TestRun.step("Compare metrics of the cache with its statistics."):
+        labels = {"cache": str(cache.cache_id)}
+        compare_metrics(metrics, "opencas_cache", labels, cache.get_statistics())
+
+    with TestRun.step("Compare metrics of the cores with their statistics."):
+        for core in cores:
+            labels = {"cache": str(cache.cache_id), "core": str(core.core_id)}
+            compare_metrics(metrics, "opencas_core", labels, core.get_statistics())
+
+    with TestRun.step("Stop cache and remove metrics file."):
+        cache.stop(no_data_flush=True)
+        if to_file:
+            fs_utils.remove(metrics_path, force=True)
+
+
+def parse_metrics(text: str):
+    """
+    Returns dictionary of samples of exported metrics with pairs of metric name
+    and frozen set of its labels as keys and values of samples as values.
+    """
+    metrics = {}
+    for line in text.splitlines():
+        match = sample_regex.match(line)
+        if not match:
+            continue
+        name, labels, value = match.groups()
+        labels = frozenset(tuple(label.split("=", 1)) for label in labels.split(","))
+        metrics[(name, labels)] = int(value)
+    return metrics
+
+
+def get_metric(metrics, name: str, labels: dict):
+    key = (name, frozenset((k, f'"{v}"') for k, v in labels.items()))
+    if key not in metrics:
+        TestRun.fail(f"Metric {name} with labels {labels} not exported.")
+    return metrics[key]
+
+
+def compare_metric(metrics, name: str, labels: dict, expected):
+    if isinstance(expected, Size):
+        expected = int(expected.get_value(Unit.Byte))
+    actual = get_metric(metrics, name, labels)
+    if actual != expected:
+        TestRun.LOGGER.error(f"Metric {name} with labels {labels} is {actual}, "
+                             f"should be {expected}.")
+
+
+def compare_metrics(metrics, prefix: str, labels: dict, stats):
+    requests = stats.request_stats
+    for req_type, expected in {
+        "rd_hits": requests.read.hits,
+        "rd_partial_misses": requests.read.part_misses,
+        "rd_full_misses": requests.read.full_misses,
+        "rd_pt": requests.pass_through_reads,
+        "wr_hits": requests.write.hits,
+        "wr_partial_misses": requests.write.part_misses,
+        "wr_full_misses": requests.write.full_misses,
+        "wr_pt": requests.pass_through_writes,
+    }.items():
+        compare_metric(metrics, f"{prefix}_requests_total", {**labels, "type": req_type},
+                       expected)
+
+    blocks = stats.block_stats
+    for device, chunk in {
+        "exported": blocks.exp_obj,
+        "cache": blocks.cache,
+        "core": blocks.core,
+    }.items():
+        compare_metric(metrics, f"{prefix}_bytes_total",
+                       {**labels, "device": device, "dir": "read"}, chunk.reads)
+        compare_metric(metrics, f"{prefix}_bytes_total",
+                       {**labels, "device": device, "dir": "write"}, chunk.writes)
+
+    usage = stats.usage_stats
+    for state, expected in {
+        "occupancy": usage.occupancy,
+        "clean": usage.clean,
+        "dirty": usage.dirty,
+    }.items():
+        compare_metric(metrics, f"{prefix}_usage_bytes", {**labels, "state": state}, expected)
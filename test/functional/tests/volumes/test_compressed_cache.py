@@ -0,0 +1,96 @@
+#
+# Copyright(c) 2024 Huawei Technologies
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+import pytest
+
+from api.cas import casadm
+from api.cas.cache_config import CacheMode
+from api.cas.casadm_parser import get_internal_stats
+from api.cas.cli_messages import check_stderr_msg
+from core.test_run import TestRun
+from storage_devices.disk import DiskType, DiskTypeSet, DiskTypeLowerThan
+from test_tools.fio.fio import Fio
+from test_tools.fio.fio_param import ReadWrite, IoEngine, VerifyMethod
+from test_utils.os_utils import reload_kernel_module
+from test_utils.output import CmdException
+from test_utils.size import Size, Unit
+
+compress_ratio = 200
+io_size = Size(512, Unit.MebiByte)
+load_compressed_msg = [r"Cache cannot be loaded from compressed cache device"]
+
+
+@pytest.mark.require_disk("cache", DiskTypeSet([DiskType.optane, DiskType.nand]))
+@pytest.mark.require_disk("core", DiskTypeLowerThan("cache"))
+def test_compressed_cache():
+    """
+    title: Cache on compressed cache device.
+    description: |
+        Start cache on compressed cache device in Write-Through mode, run I/O with
+        compressible data on exported object, check that data is stored compressed
+        and read correctly, and that the cache cannot be loaded after it is stopped.
+    pass_criteria:
+      - Cache starts on compressed cache device
+      - Data stored on cache device takes less space than data written
+      - Data read from exported object and from core device is correct
+      - Load of the cache fails with error about compressed cache device
+    """
+    with TestRun.step("Prepare cache and core devices."):
+        cache_disk = TestRun.disks["cache"]
+        cache_disk.create_partitions([Size(1, Unit.GibiByte)])
+        cache_device = cache_disk.partitions[0]
+
+        core_disk = TestRun.disks["core"]
+        core_disk.create_partitions([io_size * 2])
+        core_device = core_disk.partitions[0]
+
+    with TestRun.step("Reload module with compressed cache volume."):
+        reload_kernel_module("cas_cache", {"compressed_cache_volume": str(compress_ratio)})
+
+    with TestRun.step("Start cache in Write-Through mode and add core."):
+        cache = casadm.start_cache(cache_device, cache_mode=CacheMode.WT, force=True)
+        core = cache.add_core(core_device)
+
+    fio = (
+        Fio()
+        .create_command()
+        .io_engine(IoEngine.libaio)
+        .size(io_size)
+        .block_size(Size(64, Unit.KibiByte))
+        .target(core)
+        .read_write(ReadWrite.write)
+        .verify_pattern()
+        .verify(VerifyMethod.pattern)
+        .direct()
+    )
+
+    with TestRun.step("Write compressible data to exported object."):
+        fio.run()
+
+    with TestRun.step("Check that data is stored compressed."):
+        stats = get_internal_stats(cache.cache_id)
+        stored = stats["Compressed data stored"]
+        packed = stats["Compressed data on device"]
+        if stored == 0:
+            TestRun.fail("No compressed data stored on cache device.")
+        if packed >= stored:
+            TestRun.LOGGER.error(f"Compressed data takes {packed} MiB of cache device, "
+                                 f"should take less than {stored} MiB stored.")
+
+    with TestRun.step("Verify data read from exported object."):
+        fio.read_write(ReadWrite.read).verify_only().run()
+
+    with TestRun.step("Stop cache and try to load it."):
+        cache.stop()
+        try:
+            casadm.start_cache(cache_device, load=True)
+            TestRun.LOGGER.error("Cache loaded from compressed cache device.")
+        except CmdException as e:
+            if not check_stderr_msg(e.output, load_compressed_msg):
+                TestRun.LOGGER.error("Load failed with unexpected error message.")
+
+    with TestRun.step("Reload module with default parameters and verify core device."):
+        reload_kernel_module("cas_cache")
+        fio.target(core_device).run()
@@ -0,0 +1,134 @@
+#
+# Copyright(c) 2024 Huawei Technologies
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+import pytest
+
+from api.cas import casadm
+from api.cas.cache_config import CacheMode, SeqCutOffPolicy
+from api.cas.casadm_parser import get_dedup_enabled, get_internal_stats
+from core.test_run import TestRun
+from storage_devices.disk import DiskType, DiskTypeSet, DiskTypeLowerThan
+from test_tools import fs_utils
+from test_tools.dd import Dd
+from test_utils.os_utils import Udev, reload_kernel_module
+from test_utils.output import CmdException
+from test_utils.size import Size, Unit
+
+compress_ratio = 200
+data_count = 64
+test_file_path = "/tmp/opencas_dedup_data"
+
+
+@pytest.mark.require_disk("cache", DiskTypeSet([DiskType.optane, DiskType.nand]))
+@pytest.mark.require_disk("core", DiskTypeLowerThan("cache"))
+def test_compressed_cache_dedup():
+    """
+    title: Deduplication of clean data on compressed cache device.
+    description: |
+        Enable deduplication of cache on compressed cache device, read the same data
+        from two cores so that it is inserted into the cache clean, and check that it
+        is stored once, that data read from both cores is correct and that space is
+        no longer shared once data of one of the cores is overwritten. Check that
+        deduplication cannot be enabled on cache device which is not compressed.
+    pass_criteria:
+      - Deduplication is reported as enabled
+      - Space saved by deduplication is reported after read of identical data
+      - Data read from both exported objects is correct
+      - Space saved decreases after data of one core is overwritten
+      - Enabling deduplication fails on cache device which is not compressed
+    """
+    with TestRun.step("Prepare cache device and two core devices."):
+        cache_disk = TestRun.disks["cache"]
+        cache_disk.create_partitions([Size(1, Unit.GibiByte)])
+        cache_device = cache_disk.partitions[0]
+
+        core_disk = TestRun.disks["core"]
+        core_disk.create_partitions([Size(256, Unit.MebiByte)] * 2)
+        core_devices = core_disk.partitions
+
+    with TestRun.step("Disable udev."):
+        Udev.disable()
+
+    with TestRun.step("Write the same data to both core devices."):
+        Dd().input("/dev/urandom").output(test_file_path) \
+            .block_size(Size(1, Unit.MebiByte)).count(data_count).run()
+        for core_device in core_devices:
+            write_file(core_device.path)
+        expected_md5 = md5sum(test_file_path)
+
+    with TestRun.step("Reload module with compressed cache volume."):
+        reload_kernel_module("cas_cache", {"compressed_cache_volume": str(compress_ratio)})
+
+    with TestRun.step("Start cache in Write-Through mode and add cores."):
+        cache = casadm.start_cache(cache_device, cache_mode=CacheMode.WT, force=True)
+        cache.set_seq_cutoff_policy(SeqCutOffPolicy.never)
+        cores = [cache.add_core(core_device) for core_device in core_devices]
+
+    with TestRun.step("Enable deduplication and check that it is reported as enabled."):
+        casadm.set_param_dedup(cache.cache_id, True)
+        if not get_dedup_enabled(cache.cache_id):
+            TestRun.fail("Deduplication is reported as disabled.")
+
+    with TestRun.step("Read data of both cores and check that it is correct."):
+        for core in cores:
+            check_md5(core.path, expected_md5)
+
+    with TestRun.step("Check that data is stored once."):
+        stats = get_internal_stats(cache.cache_id)
+        saved = stats["Deduplication saved space"]
+        TestRun.LOGGER.info(f"Deduplication indexed {stats['Deduplication indexed data']} "
+                            f"MiB and saved {saved} MiB.")
+        if saved < data_count / 2:
+            TestRun.fail(f"Deduplication saved {saved} MiB, should save about "
+                         f"{data_count} MiB.")
+
+    with TestRun.step("Overwrite data of second core and check data of both cores."):
+        fs_utils.remove(test_file_path, force=True)
+        Dd().input("/dev/urandom").output(test_file_path) \
+            .block_size(Size(1, Unit.MebiByte)).count(data_count).run()
+        write_file(cores[1].path)
+        check_md5(cores[0].path, expected_md5)
+        check_md5(cores[1].path, md5sum(test_file_path))
+
+    with TestRun.step("Check that space is no longer shared."):
+        saved_after = get_internal_stats(cache.cache_id)["Deduplication saved space"]
+        if saved_after >= saved:
+            TestRun.LOGGER.error(f"Deduplication saved {saved_after} MiB after overwrite, "
+                                 f"should save less than {saved} MiB.")
+
+    with TestRun.step("Stop cache and reload module with default parameters."):
+        cache.stop()
+        reload_kernel_module("cas_cache")
+
+    with TestRun.step("Start cache on cache device which is not compressed "
+                      "and try to enable deduplication."):
+        cache = casadm.start_cache(cache_device, cache_mode=CacheMode.WT, force=True)
+        try:
+            casadm.set_param_dedup(cache.cache_id, True)
+            TestRun.LOGGER.error("Deduplication enabled on cache device "
+                                 "which is not compressed.")
+        except CmdException:
+            TestRun.LOGGER.info("Deduplication refused as expected.")
+
+    with TestRun.step("Stop cache and remove file."):
+        cache.stop()
+        fs_utils.remove(test_file_path, force=True)
+
+
+def write_file(path: str):
+    Dd().input(test_file_path).output(path) \
+        .block_size(Size(1, Unit.MebiByte)).count(data_count).oflag("direct").run()
+
+
+def md5sum(path: str):
+    return TestRun.executor.run_expect_success(f"md5sum {path}").stdout.split()[0]
+
+
+def check_md5(path: str, expected: str):
+    actual = TestRun.executor.run_expect_success(
+        f"dd if={path} bs=1M count={data_count} iflag=direct | md5sum"
+    ).stdout.split()[0]
+    if actual != expected:
+        TestRun.LOGGER.error(f"Md5 sum of {path} is {actual}, should be {expected}.")
@@ -0,0 +1,111 @@
+#
+# Copyright(c) 2024 Huawei Technologies
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+import pytest
+
+from api.cas.cache import Cache
+from api.cas.cache_config import CacheMode, CleaningPolicy, SeqCutOffPolicy
+from api.cas.cli import start_cmd
+from core.test_run import TestRun
+from storage_devices.disk import DiskType, DiskTypeSet, DiskTypeLowerThan
+from test_tools.fio.fio import Fio
+from test_tools.fio.fio_param import ReadWrite, IoEngine, VerifyMethod
+from test_utils.os_utils import Udev
+from test_utils.output import CmdException
+from test_utils.size import Size, Unit
+
+cache_id = 1
+member_size = Size(1, Unit.GibiByte)
+io_size = Size(1536, Unit.MebiByte)
+
+
+@pytest.mark.require_disk("cache", DiskTypeSet([DiskType.optane, DiskType.nand]))
+@pytest.mark.require_disk("core", DiskTypeLowerThan("cache"))
+def test_striped_cache():
+    """
+    title: Cache on striped cache device.
+    description: |
+        Start cache in Write-Back mode on cache device striped over two partitions,
+        write more data than fits on one of them, and check that the cache spans both
+        members and that data is read correctly from exported object, also after the
+        cache is loaded, and from core device after the cache is stopped.
+    pass_criteria:
+      - Cache starts on striped cache device
+      - Cache size and occupancy exceed size of one member
+      - Data read from exported object is correct before and after load of the cache
+      - Data read from core device after stop of the cache is correct
+    """
+    with TestRun.step("Prepare cache member partitions and core device."):
+        cache_disk = TestRun.disks["cache"]
+        cache_disk.create_partitions([member_size] * 2)
+        members = cache_disk.partitions
+        stripe_path = ",".join(member.path for member in members)
+
+        core_disk = TestRun.disks["core"]
+        core_disk.create_partitions([io_size * 2])
+        core_device = core_disk.partitions[0]
+
+    with TestRun.step("Disable udev."):
+        Udev.disable()
+
+    with TestRun.step("Start cache on striped cache device in Write-Back mode."):
+        start_striped_cache(stripe_path)
+        cache = Cache(members[0], cache_id=cache_id)
+        cache.set_cleaning_policy(CleaningPolicy.nop)
+        cache.set_seq_cutoff_policy(SeqCutOffPolicy.never)
+        core = cache.add_core(core_device)
+
+    with TestRun.step("Check that cache spans both members."):
+        if cache.size <= member_size:
+            TestRun.fail(f"Cache size is {cache.size}, should exceed {member_size} "
+                         f"of one member.")
+
+    fio = (
+        Fio()
+        .create_command()
+        .io_engine(IoEngine.libaio)
+        .size(io_size)
+        .block_size(Size(64, Unit.KibiByte))
+        .target(core)
+        .read_write(ReadWrite.write)
+        .verify_pattern()
+        .verify(VerifyMethod.pattern)
+        .direct()
+    )
+
+    with TestRun.step("Write data to exported object and check occupancy."):
+        fio.run()
+        occupancy = cache.get_statistics().usage_stats.occupancy
+        if occupancy <= member_size:
+            TestRun.LOGGER.error(f"Cache occupancy is {occupancy}, should exceed "
+                                 f"{member_size} of one member.")
+
+    with TestRun.step("Verify data read from exported object."):
+        fio.read_write(ReadWrite.read).verify_only().run()
+
+    with TestRun.step("Stop cache without flush and load it."):
+        cache.stop(no_data_flush=True)
+        start_striped_cache(stripe_path, load=True)
+
+    with TestRun.step("Verify data read from exported object after load."):
+        fio.run()
+
+    with TestRun.step("Stop cache and verify core device contents."):
+        cache.stop()
+        fio.target(core_device).run()
+
+
+def start_striped_cache(stripe_path: str, load: bool = False):
+    output = TestRun.executor.run(
+        start_cmd(
+            cache_dev=stripe_path,
+            cache_mode=None if load else CacheMode.WB.name.lower(),
+            cache_id=None if load else str(cache_id),
+            force=not load,
+            load=load,
+        )
+    )
+    if output.exit_code != 0:
+        raise CmdException("Failed to start cache on striped cache device.", output)
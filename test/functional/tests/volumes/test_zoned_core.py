@@ -0,0 +1,131 @@
+#
+# Copyright(c) 2024 Huawei Technologies
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+import os
+import re
+
+import pytest
+
+from api.cas import casadm
+from api.cas.cache_config import CacheMode, CleaningPolicy, SeqCutOffPolicy
+from core.test_run import TestRun
+from storage_devices.disk import DiskType, DiskTypeSet
+from test_tools import fs_utils
+from test_tools.dd import Dd
+from test_utils.os_utils import reload_kernel_module
+from test_utils.output import CmdException
+from test_utils.size import Size, Unit
+
+zone_size = Size(4, Unit.MebiByte)
+zones_written = 4
+test_file_path = "/tmp/opencas_zoned_data"
+wptr_regex = re.compile(r"start: 0x([0-9a-f]+),.*wptr 0x([0-9a-f]+)")
+
+
+@pytest.mark.os_dependent
+@pytest.mark.require_disk("cache", DiskTypeSet([DiskType.optane, DiskType.nand]))
+@pytest.mark.require_plugin("scsi_debug", delay="0", dev_size_mb="256", zbc="managed",
+                            zone_size_mb=str(int(zone_size.get_value(Unit.MebiByte))),
+                            zone_nr_conv="0")
+def test_zoned_core():
+    """
+    title: Host-managed zoned device as core.
+    description: |
+        Write zones of exported object of zoned core sequentially in Write-Back mode,
+        check that data is written back to the zones of the core, that zone reset
+        reaches the core and that zoned core is refused with request based I/O.
+    pass_criteria:
+      - Exported object of zoned core is host-managed zoned
+      - Data read from exported object and from core after flush is correct
+      - Write pointer of reset zone is at the zone start on core device
+      - Adding zoned core fails when request_based_io is enabled
+    """
+    with TestRun.step("Prepare cache device and zoned core device."):
+        cache_disk = TestRun.disks["cache"]
+        cache_disk.create_partitions([Size(1, Unit.GibiByte)])
+        cache_device = cache_disk.partitions[0]
+        core_device = TestRun.scsi_debug_devices[0]
+
+    with TestRun.step("Start cache in Write-Back mode and add zoned core."):
+        cache = casadm.start_cache(cache_device, cache_mode=CacheMode.WB, force=True)
+        cache.set_cleaning_policy(CleaningPolicy.nop)
+        cache.set_seq_cutoff_policy(SeqCutOffPolicy.never)
+        core = cache.add_core(core_device)
+
+    with TestRun.step("Check that exported object is host-managed zoned."):
+        zoned = fs_utils.read_file(
+            f"/sys/block/{os.path.basename(core.path)}/queue/zoned"
+        ).strip()
+        if zoned != "host-managed":
+            TestRun.fail(f"Exported object zoned model is {zoned}, should be host-managed.")
+
+    with TestRun.step("Write zones of exported object sequentially."):
+        count = zones_written * int(zone_size.get_value(Unit.MebiByte))
+        Dd().input("/dev/urandom").output(test_file_path) \
+            .block_size(Size(1, Unit.MebiByte)).count(count).run()
+        Dd().input(test_file_path).output(core.path) \
+            .block_size(Size(1, Unit.MebiByte)).count(count).oflag("direct").run()
+        expected_md5 = TestRun.executor.run_expect_success(
+            f"md5sum {test_file_path}"
+        ).stdout.split()[0]
+
+    with TestRun.step("Check data read from exported object."):
+        check_md5(core.path, count, expected_md5)
+
+    with TestRun.step("Flush cache and check data on core device."):
+        cache.flush_cache()
+        check_md5(core_device.path, count, expected_md5)
+
+    with TestRun.step("Reset first zone of exported object."):
+        TestRun.executor.run_expect_success(f"blkzone reset -o 0 -c 1 {core.path}")
+
+    with TestRun.step("Stop cache and check write pointers of core device zones."):
+        cache.stop()
+        zone_sectors = int(zone_size.get_value(Unit.Blocks512))
+        for start, wptr in get_write_pointers(core_device.path)[:zones_written]:
+            expected = 0 if start == 0 else zone_sectors
+            if wptr != expected:
+                TestRun.LOGGER.error(f"Write pointer of zone at {start} is {wptr}, "
+                                     f"should be {expected}.")
+
+    with TestRun.step("Reload module with request based I/O and start cache."):
+        reload_kernel_module("cas_cache", {"request_based_io": "1"})
+        cache = casadm.start_cache(cache_device, cache_mode=CacheMode.WB, force=True)
+
+    with TestRun.step("Try to add zoned core."):
+        try:
+            cache.add_core(core_device)
+            TestRun.LOGGER.error("Zoned core added with request based I/O enabled.")
+        except CmdException:
+            TestRun.LOGGER.info("Zoned core refused with request based I/O as expected.")
+
+    with TestRun.step("Stop cache, reload module with default parameters and remove file."):
+        cache.stop()
+        reload_kernel_module("cas_cache")
+        fs_utils.remove(test_file_path, force=True)
+
+
+def md5sum(path: str, count_mib: int):
+    return TestRun.executor.run_expect_success(
+        f"dd if={path} bs=1M count={count_mib} iflag=direct | md5sum"
+    ).stdout.split()[0]
+
+
+def check_md5(path: str, count_mib: int, expected: str):
+    actual = md5sum(path, count_mib)
+    if actual != expected:
+        TestRun.LOGGER.error(f"Md5 sum of {path} is {actual}, should be {expected}.")
+
+
+def get_write_pointers(path: str):
+    """
+    Returns list of pairs of start sector and write pointer, relative to the zone
+    start, of zones reported by the device.
+    """
+    output = TestRun.executor.run_expect_success(f"blkzone report {path}").stdout
+    return [
+        (int(start, 16), int(wptr, 16))
+        for start, wptr in wptr_regex.findall(output)
+    ]
@@ -86,6 +86,20 @@ class ConfigParameter(ValidatableParameter):
 class WorkloadParameter(ValidatableParameter):
     NUM_JOBS = Schema(Use(int))
     QUEUE_DEPTH = Schema(Use(int))
+    NUM_CPUS = Schema(Use(int))
+    BLOCK_SIZE = Schema(Use(int))
+    CACHE_SIZE = Schema(Use(int))
+
+
+class MgmtMetric(ValidatableParameter):
+    """
+    Metrics of cache operations other than servicing I/O, rates in MiB/s and times in seconds
+    """
+
+    WRITEBACK_BW = Schema(Use(float))
+    FLUSH_RATE = Schema(Use(float))
+    CLEANER_RATE = Schema(Use(float))
+    LOAD_TIME = Schema(Use(float))
 
 
 class MetricContainer:
@@ -139,6 +153,8 @@ class PerfContainer:
         self.core_metrics = MetricContainer(IOMetric)
         self.exp_obj_metrics = MetricContainer(IOMetric)
 
+        self.mgmt_metrics = MetricContainer(MgmtMetric)
+
     def insert_config_param(self, param, kind: ConfigParameter):
         self.conf_params.insert_metric(param, kind)
 
@@ -191,6 +207,9 @@ class PerfContainer:
     def insert_exp_obj_metrics_from_fio_job(self, fio_results):
         self._insert_metrics_from_fio(self.exp_obj_metrics, fio_results)
 
+    def insert_mgmt_metric(self, metric, kind: MgmtMetric):
+        self.mgmt_metrics.insert_metric(metric, kind)
+
     @property
     def is_empty(self):
         return (
@@ -199,6 +218,7 @@ class PerfContainer:
             and self.cache_metrics.is_empty
             and self.core_metrics.is_empty
             and self.exp_obj_metrics.is_empty
+            and self.mgmt_metrics.is_empty
         )
 
     def to_serializable_dict(self):
@@ -212,5 +232,7 @@ class PerfContainer:
             ret["core_io"] = self.core_metrics.to_serializable_dict()
         if not self.exp_obj_metrics.is_empty:
             ret["exp_obj_io"] = self.exp_obj_metrics.to_serializable_dict()
+        if not self.mgmt_metrics.is_empty:
+            ret["mgmt"] = self.mgmt_metrics.to_serializable_dict()
 
         return ret
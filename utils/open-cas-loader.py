@@ -8,40 +8,239 @@ import subprocess
 import opencas
 import sys
 import os
+import select
+import signal
+import time
 import syslog as sl
 
+config_path = '/etc/opencas/opencas.conf'
+
+# Existence of this file tells udev rule that daemon handles block devices
+daemon_pid_file = '/run/opencas/loader.pid'
+
+# Events coming closer than window apart are handled in one batch, but
+# no event waits longer than max delay
+batch_window = 0.2
+batch_max_delay = 1.0
+
+
+def load_config():
+    try:
+        return opencas.cas_config.from_file(config_path,
+                                            allow_incomplete=True)
+    except Exception as e:
+        sl.syslog(sl.LOG_ERR,
+                  f'Unable to load opencas config. Reason: {str(e)}')
+        return None
+
+
+def start_cache(cache):
+    try:
+        opencas.wait_for_cas_ctrl()
+        opencas.start_cache(cache, True)
+    except opencas.casadm.CasadmError as e:
+        sl.syslog(sl.LOG_WARNING,
+                  f'Unable to load cache {cache.cache_id} ({cache.device}). '
+                  f'Reason: {e.result.stderr}')
+        return e.result.exit_code
+    return 0
+
+
+def add_core(core):
+    try:
+        opencas.wait_for_cas_ctrl()
+        opencas.add_core(core, True)
+    except opencas.casadm.CasadmError as e:
+        sl.syslog(sl.LOG_WARNING,
+                  f'Unable to attach core {core.device} from cache {core.cache_id}. '
+                  f'Reason: {e.result.stderr}')
+        return e.result.exit_code
+    return 0
+
+
+def load_device(config, device):
+    for cache in config.caches.values():
+        if device == os.path.realpath(cache.device):
+            return start_cache(cache)
+        for core in cache.cores.values():
+            if device == os.path.realpath(core.device):
+                return add_core(core)
+    return 0
+
+
+# Daemon - handle all block device events in one process
+
+
+def load_devices(config, devices):
+    """
+    Start caches and attach cores whose devices are among given ones.
+    Caches are handled in parallel, each one by a single task which starts
+    the cache first and then attaches its cores one after another.
+    Cores of a cache loaded in the same batch are attached by the load
+    itself.
+    Caches on top of exported objects get their turn when udev reports the
+    exported object, which happens once the core below is attached.
+    """
+    try:
+        state = opencas.get_devices_state()
+    except opencas.casadm.CasadmError:
+        state = {"core_pool": {}, "caches": {}, "cores": {}}
+
+    tasks = {}
+    for cache in config.caches.values():
+        start = (cache.cache_id not in state["caches"] and
+                 os.path.realpath(cache.device) in devices)
+        cores = []
+        for core in cache.cores.values():
+            device = os.path.realpath(core.device)
+            runtime = state["cores"].get((cache.cache_id, core.core_id))
+            if runtime and runtime["status"] != "Inactive":
+                continue
+            if device in devices and device not in state["core_pool"]:
+                cores.append(core)
+        if not start and not cores:
+            continue
+
+        def task(cache=cache, start=start, cores=cores):
+            if start and start_cache(cache) == 0:
+                return
+            for core in cores:
+                add_core(core)
+
+        tasks[cache.cache_id] = (task, [])
+
+    opencas.run_parallel(tasks, os.cpu_count() or 1)
+
+
+def existing_devices():
+    try:
+        return {f'/dev/{name}' for name in os.listdir('/sys/class/block')}
+    except OSError:
+        return set()
+
+
+class udev_monitor(object):
+    """
+    Stream of names of block devices added or changed, as reported by udev
+    once it has finished processing of their events.
+    """
+
+    def __init__(self):
+        self.proc = subprocess.Popen(
+            ['udevadm', 'monitor', '--udev', '--property',
+             '--subsystem-match=block'],
+            stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+        self.fd = self.proc.stdout.fileno()
+        self.buf = b''
+        self.event = {}
+
+        # Header ends with empty line, printed once monitor is subscribed
+        while self.readline(None) not in ('', None):
+            pass
+
+    def readline(self, timeout):
+        while b'\n' not in self.buf:
+            ready, _, _ = select.select([self.fd], [], [], timeout)
+            if not ready:
+                return None
+            data = os.read(self.fd, 4096)
+            if not data:
+                raise EOFError('udevadm monitor exited')
+            self.buf += data
+        line, self.buf = self.buf.split(b'\n', 1)
+        return line.decode(errors='replace').strip()
+
+    def read(self, timeout):
+        """
+        Return set of devices reported before timeout passes. Without
+        timeout wait for the first device.
+        """
+        devices = set()
+        if timeout is not None:
+            deadline = time.monotonic() + timeout
+        while True:
+            if timeout is None:
+                line = self.readline(0 if devices else None)
+            else:
+                line = self.readline(max(deadline - time.monotonic(), 0))
+            if line is None:
+                return devices
+            if line:
+                key, _, value = line.partition('=')
+                self.event[key] = value
+                continue
+            if (self.event.get('ACTION') != 'remove' and
+                    'DEVNAME' in self.event):
+                devices.add(self.event['DEVNAME'])
+            self.event = {}
+
+    def close(self):
+        self.proc.kill()
+        self.proc.wait()
+
+
+def daemon():
+    def terminate(signum, frame):
+        raise SystemExit(0)
+
+    signal.signal(signal.SIGTERM, terminate)
+
+    config = load_config()
+    config_mtime = os.stat(config_path).st_mtime if config else None
+
+    monitor = udev_monitor()
+    try:
+        os.makedirs(os.path.dirname(daemon_pid_file), exist_ok=True)
+        with open(daemon_pid_file, 'w') as f:
+            f.write(f'{os.getpid()}\n')
+
+        # Devices which appeared before udev rule handed them over to us
+        pending = existing_devices()
+        while True:
+            if not pending:
+                pending = monitor.read(None)
+            deadline = time.monotonic() + batch_max_delay
+            while time.monotonic() < deadline:
+                devices = monitor.read(batch_window)
+                if not devices:
+                    break
+                pending |= devices
+
+            try:
+                mtime = os.stat(config_path).st_mtime
+            except OSError:
+                mtime = None
+            if mtime != config_mtime:
+                # Broken config is reported once, last good one stays in use
+                config = load_config() or config
+                config_mtime = mtime
+
+            if config:
+                load_devices(config, {os.path.realpath(d) for d in pending})
+            pending = set()
+    finally:
+        try:
+            os.remove(daemon_pid_file)
+        except OSError:
+            pass
+        monitor.close()
+
+
 try:
     subprocess.call(['/sbin/modprobe', 'cas_cache'])
 except:
     sl.syslog(sl.LOG_ERR, 'Unable to probe cas_cache module')
     exit(1)
 
-try:
-    config = opencas.cas_config.from_file('/etc/opencas/opencas.conf',
-                                          allow_incomplete=True)
-except Exception as e:
-    sl.syslog(sl.LOG_ERR, f'Unable to load opencas config. Reason: {str(e)}')
+if sys.argv[1] == '--daemon':
+    try:
+        daemon()
+    except EOFError as e:
+        sl.syslog(sl.LOG_ERR, f'Loader daemon stopped. Reason: {str(e)}')
+        exit(1)
+
+config = load_config()
+if config is None:
     exit(1)
 
-for cache in config.caches.values():
-    if sys.argv[1] == os.path.realpath(cache.device):
-        try:
-            opencas.wait_for_cas_ctrl()
-            opencas.start_cache(cache, True)
-        except opencas.casadm.CasadmError as e:
-            sl.syslog(sl.LOG_WARNING,
-                      f'Unable to load cache {cache.cache_id} ({cache.device}). '
-                      f'Reason: {e.result.stderr}')
-            exit(e.result.exit_code)
-        exit(0)
-    for core in cache.cores.values():
-        if sys.argv[1] == os.path.realpath(core.device):
-            try:
-                opencas.wait_for_cas_ctrl()
-                opencas.add_core(core, True)
-            except opencas.casadm.CasadmError as e:
-                sl.syslog(sl.LOG_WARNING,
-                          f'Unable to attach core {core.device} from cache {cache.cache_id}. '
-                          f'Reason: {e.result.stderr}')
-                exit(e.result.exit_code)
-            exit(0)
+exit(load_device(config, sys.argv[1]))
@@ -9,6 +9,7 @@ import re
 import os
 import stat
 import time
+import concurrent.futures
 
 # Casadm functionality
 
@@ -153,6 +154,34 @@ class casadm:
 
         return cls.run_cmd(cmd)
 
+    @classmethod
+    def get_heatmap(cls, cache_id, core_id):
+        cmd = [cls.casadm_path,
+               '--stats',
+               '--cache-id', str(cache_id),
+               '--core-id', str(core_id),
+               '--filter', 'heatmap',
+               '--output-format', 'csv']
+        return cls.run_cmd(cmd)
+
+    @classmethod
+    def save_hot_set(cls, cache_id, core_id, path):
+        cmd = [cls.casadm_path,
+               '--save-hot-set',
+               '--cache-id', str(cache_id),
+               '--core-id', str(core_id),
+               '--file', path]
+        return cls.run_cmd(cmd)
+
+    @classmethod
+    def load_hot_set(cls, cache_id, core_id, path):
+        cmd = [cls.casadm_path,
+               '--load-hot-set',
+               '--cache-id', str(cache_id),
+               '--core-id', str(core_id),
+               '--file', path]
+        return cls.run_cmd(cmd)
+
     @classmethod
     def flush_parameters(cls, cache_id, policy_type):
         cmd = [cls.casadm_path,
@@ -308,7 +337,7 @@ class cas_config(object):
                 raise ValueError(f"{failover_state} is invalid target_failover_state value")
 
         def check_promotion_policy_valid(self, promotion_policy):
-            if promotion_policy not in ['always', 'nhit']:
+            if promotion_policy not in ['always', 'nhit', 'tinylfu']:
                 raise ValueError(f'{promotion_policy} is invalid promotion policy name')
 
         def check_cache_line_size_valid(self, cache_line_size):
@@ -690,6 +719,72 @@ class CompoundException(Exception):
             raise self
 
 
+class DependencyCycleError(Exception):
+    pass
+
+
+def get_device_dependency(device):
+    """
+    Returns (cache_id, core_id) of exported object given device is, that is
+    core which has to be added before device may be used, or None.
+    """
+    match = re.match(r"/dev/cas(\d{1,5})-(\d{1,4})$", device)
+    if not match:
+        return None
+
+    cache_id, core_id = match.groups()
+    return int(cache_id), int(core_id)
+
+
+def run_parallel(tasks, jobs):
+    """
+    Run tasks with at most jobs of them at once. tasks maps task key to
+    (function, list of keys of tasks that have to succeed first). Task whose
+    dependency failed, doesn't exist or depends on the task itself is not run.
+
+    Returns dict mapping key of each task that failed or wasn't run to
+    exception raised by it, None if dependency failed or DependencyCycleError.
+    """
+    failed = {}
+    done = set()
+    pending = dict(tasks)
+    running = {}
+
+    with concurrent.futures.ThreadPoolExecutor(max_workers=jobs) as executor:
+        while pending or running:
+            scheduled = True
+            while scheduled:
+                scheduled = False
+                for key, (func, deps) in list(pending.items()):
+                    if any(dep in failed or dep not in tasks for dep in deps):
+                        failed[key] = None
+                    elif all(dep in done for dep in deps):
+                        running[executor.submit(func)] = key
+                    else:
+                        continue
+                    del pending[key]
+                    scheduled = True
+
+            if not running:
+                # Whatever is left waits for itself
+                for key in pending:
+                    failed[key] = DependencyCycleError()
+                break
+
+            finished, _ = concurrent.futures.wait(
+                running, return_when=concurrent.futures.FIRST_COMPLETED
+            )
+            for future in finished:
+                key = running.pop(future)
+                try:
+                    future.result()
+                    done.add(key)
+                except Exception as e:
+                    failed[key] = e
+
+    return failed
+
+
 def detach_core_recursive(cache_id, core_id, flush):
     # Catching exceptions is left to uppermost caller of detach_core_recursive
     # as the immediate caller that made a recursive call depends on the callee
@@ -759,6 +854,57 @@ def stop_all_caches(flush):
     error.raise_nonempty()
 
 
+HOT_SET_DIR = '/var/lib/opencas/hot-set'
+
+
+def hot_set_path(cache_id, core_id):
+    return os.path.join(HOT_SET_DIR, f'cache{cache_id}-core{core_id}')
+
+
+def active_cores():
+    cache_id = None
+    for dev in get_caches_list():
+        if dev['type'] == 'cache':
+            cache_id = dev['id']
+        elif dev['type'] == 'core pool':
+            cache_id = None
+        elif dev['type'] == 'core' and cache_id and dev['status'] == 'Active':
+            yield cache_id, dev['id']
+
+
+def save_hot_sets():
+    error = CompoundException()
+
+    os.makedirs(HOT_SET_DIR, exist_ok=True)
+    for cache_id, core_id in active_cores():
+        try:
+            casadm.save_hot_set(cache_id, core_id,
+                                hot_set_path(cache_id, core_id))
+        except casadm.CasadmError as e:
+            error.add_exception(Exception(
+                f"Unable to save hot set of core {core_id} of cache {cache_id}. "
+                f"Reason:\n{e.result.stderr}"))
+
+    error.raise_nonempty()
+
+
+def load_hot_sets():
+    error = CompoundException()
+
+    for cache_id, core_id in active_cores():
+        path = hot_set_path(cache_id, core_id)
+        if not os.path.exists(path):
+            continue
+        try:
+            casadm.load_hot_set(cache_id, core_id, path)
+        except casadm.CasadmError as e:
+            error.add_exception(Exception(
+                f"Unable to load hot set of core {core_id} of cache {cache_id}. "
+                f"Reason:\n{e.result.stderr}"))
+
+    error.raise_nonempty()
+
+
 def stop(flush):
     error = CompoundException()
 